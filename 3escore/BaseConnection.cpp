@@ -8,25 +8,52 @@
 #include "Debug.h"
 #include "Endian.h"
 #include "Log.h"
+#include "PacketReader.h"
 #include "Resource.h"
-#include "ResourcePacker.h"
+#include "ResourcePacketCache.h"
 #include "Rotation.h"
 
+#include <3escore/shapes/MeshShape.h>
 #include <3escore/shapes/Shape.h>
 
 #include <algorithm>
+#include <limits>
 
 namespace tes
 {
 namespace
 {
 constexpr float kSecondsToMicroseconds = 1e6;
+/// Smoothing factor for the adaptive send latency and throughput averages.
+constexpr double kAdaptiveSmoothing = 0.2;
+/// Frames to hold an adaptive level after a change before degrading again.
+constexpr unsigned kAdaptiveCooldownFrames = 5;
+/// Consecutive frames under a quarter of the target latency required to recover one level.
+constexpr unsigned kAdaptiveRecoveryFrames = 30;
+/// Adaptive level at which resource transfers are budgeted.
+constexpr unsigned kAdaptiveTransferLevel = 2;
+/// Adaptive level at which transient point clouds start to be decimated.
+constexpr unsigned kAdaptiveDecimationLevel = 3;
+/// Minimum adaptive resource transfer budget per frame (bytes).
+constexpr unsigned kMinTransferByteLimit = 1024u;
+/// Number of stale resource queue entries tolerated before purging them.
+constexpr size_t kMinResourceQueuePurge = 64u;
 }  // namespace
 
 BaseConnection::BaseConnection(const ServerSettings &settings)
-  : _current_resource(std::make_unique<ResourcePacker>())
+  : _resource_cache(std::make_shared<ResourcePacketCache>(settings.resourcePacketSize(),
+                                                            settings.progressivePointCount()))
+  , _max_resource_packet_size(settings.resourcePacketSize())
+  , _resource_order(settings.resource_order)
   , _server_flags(settings.flags)
-  , _collation(std::make_unique<CollatedPacket>((settings.flags & SFCompress) != 0))
+  , _max_collated_packet_size((settings.flags & SFExtendedPackets) ?
+                                std::max<unsigned>(settings.extended_packet_size,
+                                                   CollatedPacket::kMaxPacketSize) :
+                                CollatedPacket::kMaxPacketSize)
+  , _collation(std::make_unique<CollatedPacket>((settings.flags & SFCompress) != 0,
+                                                CollatedPacket::kDefaultBufferSize,
+                                                _max_collated_packet_size))
+  , _flush_policy(settings.flush_policy)
 {
   _packet_buffer.resize(settings.client_buffer_size);
   _packet = std::make_unique<PacketWriter>(_packet_buffer.data(),
@@ -38,6 +65,10 @@ BaseConnection::BaseConnection(const ServerSettings &settings)
     kSecondsToMicroseconds /
     (_server_info.time_unit ? static_cast<float>(_server_info.time_unit) : 1.0f);
   _collation->setCompressionLevel(settings.compression_level);
+  _target_latency = 1e-3 * static_cast<double>(settings.target_latency_ms);
+  _base_compression_level =
+    (settings.flags & SFCompress) ? settings.compression_level : CompressionLevel::None;
+  _stats.compression_level = _base_compression_level;
 }
 
 
@@ -72,13 +103,18 @@ bool BaseConnection::sendServerInfo(const ServerInfoMessage &info)
   {
     const std::lock_guard<Lock> guard(_packet_lock);
     _packet->reset(MtServerInfo, 0);
+    if (_server_flags & SFExtendedPackets)
+    {
+      // Advertise that the stream may contain extended packets.
+      _packet->setVersion(kPacketVersionMajor, kPacketExtendedVersionMinor);
+    }
     if (info.write(*_packet))
     {
       if (_packet->finalise())
       {
         const std::lock_guard<Lock> send_guard(_send_lock);
         // Do not use collation buffer or compression for this message.
-        writeBytes(_packet_buffer.data(), _packet->packetSize());
+        timedWriteBytes(_packet_buffer.data(), _packet->packetSize());
         return true;
       }
     }
@@ -116,37 +152,30 @@ int BaseConnection::send(const CollatedPacket &collated)
     return 0;
   }
 
+  // Large collated packets are finalised as PFExtended packets. Skip the extended payload size.
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const PacketReader collated_reader(reinterpret_cast<const PacketHeader *>(bytes));
+  const unsigned data_offset = CollatedPacket::InitialCursorOffset + collated_reader.payloadOffset();
+
   // Use the packet lock to prevent other sends until the collated packet is flushed.
   const std::lock_guard<Lock> guard(_packet_lock);
-  // Extract each packet in turn.
-  // Cycle each message and send.
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-  const auto *packet = reinterpret_cast<const PacketHeader *>(bytes);
-  unsigned processed_bytes = CollatedPacket::InitialCursorOffset;
-  unsigned packet_size = 0;
-  uint16_t payload_size = 0;
-  bool crc_present = false;
-  if (!(packet->flags & PFNoCrc))
-  {
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    processed_bytes -= static_cast<unsigned>(sizeof(PacketWriter::CrcType));
-  }
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-*)
-  packet = reinterpret_cast<const PacketHeader *>(bytes + processed_bytes);
-  while (processed_bytes + sizeof(PacketHeader) < collated_bytes)
-  {
-    // Determine current packet size.
-    // Get payload size.
-    payload_size = packet->payload_size;
-    networkEndianSwap(payload_size);
-    // Add header size.
-    packet_size = payload_size + static_cast<unsigned>(sizeof(PacketHeader));
-    // Add Crc Size.
-    crc_present = (packet->flags & PFNoCrc) == 0;
-    packet_size += !!crc_present * static_cast<unsigned>(sizeof(PacketWriter::CrcType));
-
-    // Send packet.
-    if (packet_size + processed_bytes > collated_bytes)
+  // Extract each packet in turn. Packets may be PFExtended, so size them with a PacketReader once
+  // the header and the extended payload size are known to be present. The collated packet CRC
+  // follows the last packet.
+  const unsigned end_bytes = collated_bytes - static_cast<unsigned>(sizeof(PacketWriter::CrcType));
+  unsigned processed_bytes = data_offset;
+  while (processed_bytes + sizeof(PacketHeader) <= end_bytes)
+  {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-*)
+    const auto *packet = reinterpret_cast<const PacketHeader *>(bytes + processed_bytes);
+    const PacketReader reader(packet);
+    if (processed_bytes + sizeof(PacketHeader) + reader.payloadOffset() > end_bytes)
+    {
+      return -1;
+    }
+
+    const unsigned packet_size = reader.packetSize();
+    if (packet_size + processed_bytes > end_bytes)
     {
       return -1;
     }
@@ -155,8 +184,6 @@ int BaseConnection::send(const CollatedPacket &collated)
 
     // Next packet.
     processed_bytes += packet_size;
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-*)
-    packet = reinterpret_cast<const PacketHeader *>(bytes + processed_bytes);
   }
 
   return int_cast<int>(processed_bytes);
@@ -170,7 +197,7 @@ int BaseConnection::send(const uint8_t *data, int byte_count, bool allow_collati
     return 0;
   }
 
-  return writePacket(data, int_cast<uint16_t>(byte_count), allow_collation);
+  return writePacket(data, int_cast<uint32_t>(byte_count), allow_collation);
 }
 
 
@@ -181,6 +208,32 @@ int BaseConnection::create(const Shape &shape)
     return 0;
   }
 
+  if (shape.isTransient() && (_server_flags & SFAdaptive))
+  {
+    unsigned decimation = 1;
+    {
+      const std::lock_guard<Lock> stats_guard(_stats_lock);
+      decimation = _stats.point_decimation;
+    }
+
+    if (decimation > 1)
+    {
+      if (const auto *mesh = dynamic_cast<const MeshShape *>(&shape))
+      {
+        if (mesh->drawType() == DrawType::Points && mesh->indices().count() == 0)
+        {
+          return createShape(mesh->decimatedPoints(decimation));
+        }
+      }
+    }
+  }
+
+  return createShape(shape);
+}
+
+
+int BaseConnection::createShape(const Shape &shape)
+{
   // const std::lock_guard<Lock> guard(_lock);
   const std::lock_guard<Lock> guard(_packet_lock);
   if (shape.writeCreate(*_packet))
@@ -278,52 +331,193 @@ int BaseConnection::updateTransfers(unsigned byte_limit)
     return 0;
   }
 
-  const std::lock_guard<Lock> guard(_packet_lock);
-  const std::lock_guard<Lock> resource_guard(_resource_lock);
-  unsigned transferred = 0;
+  {
+    const std::lock_guard<Lock> stats_guard(_stats_lock);
+    if (_stats.transfer_byte_limit)
+    {
+      byte_limit = (byte_limit) ? std::min(byte_limit, _stats.transfer_byte_limit) :
+                                  _stats.transfer_byte_limit;
+    }
+  }
 
-  while ((!byte_limit || transferred < byte_limit) &&
-         (_current_resource->isValid() || !_resource_queue.empty()))
+  unsigned transferred = 0;
+  // Resources are packed without holding the locks, so stop sending whenever the current resource
+  // needs packing, then resume.
+  bool pack = true;
+  while (pack)
   {
-    if (!_current_resource->isValid())
+    packResources();
+    pack = false;
+
+    const std::lock_guard<Lock> guard(_packet_lock);
+    const std::lock_guard<Lock> resource_guard(_resource_lock);
+    while (!byte_limit || transferred < byte_limit)
     {
-      if (!_resource_queue.empty())  // Should never be empty. Loop check this.
+      if (!_current_resource)
+      {
+        _current_resource = nextResource();
+        if (!_current_resource)
+        {
+          break;
+        }
+        _current_resource->started = true;
+      }
+
+      ResourceInfo &info = *_current_resource;
+      if (!info.packed)
       {
-        // Start the next resource transfer.
-        const uint64_t next_resource = _resource_queue.front();
-        _resource_queue.pop_front();
-        auto resource_info = _resources.find(next_resource);
-        if (resource_info != _resources.end())
+        pack = true;
+        break;
+      }
+
+      if (info.next_packet < info.packed->packetCount())
+      {
+        uint32_t packet_size = 0;
+        const uint8_t *packet = info.packed->packet(info.next_packet, packet_size);
+        // Respect the byte limit at packet granularity, but always make some progress.
+        if (byte_limit && transferred && transferred + packet_size > byte_limit)
         {
-          auto &resource = resource_info->second.resource;
-          resource_info->second.started = true;
-          _current_resource->transfer(resource);
+          break;
         }
+
+        writePacket(packet, packet_size, true);
+        transferred += packet_size;
+        info.bytes_sent += packet_size;
+        ++info.next_packet;
       }
-      continue;
+
+      // Check completion.
+      if (info.next_packet >= info.packed->packetCount())
+      {
+        info.sent = true;
+        info.latency = std::chrono::duration_cast<std::chrono::duration<double>>(
+                         std::chrono::steady_clock::now() - info.referenced_time)
+                         .count();
+        _current_resource = nullptr;
+
+        const std::lock_guard<Lock> stats_guard(_stats_lock);
+        const double latency_delta = info.latency - _stats.resource_latency;
+        _stats.resource_latency =
+          (_stats.resources_sent) ? _stats.resource_latency + kAdaptiveSmoothing * latency_delta :
+                                    info.latency;
+        ++_stats.resources_sent;
+      }
+    }
+  }
+
+  return 0;
+}
+
+
+BaseConnection::ResourceInfo *BaseConnection::nextResource()
+{
+  while (!_resource_queue.empty())
+  {
+    std::pop_heap(_resource_queue.begin(), _resource_queue.end());
+    const ResourceQueueEntry entry = _resource_queue.back();
+    _resource_queue.pop_back();
+
+    auto search = _resources.find(entry.resource_id);
+    if (search != _resources.end() && !search->second.started &&
+        search->second.queued.sequence == entry.sequence)
+    {
+      return &search->second;
     }
+    // Released, started or requeued.
+  }
+
+  return nullptr;
+}
 
-    if (_current_resource->nextPacket(*_packet, byte_limit ? byte_limit - transferred : 0))
+
+void BaseConnection::queueResource(ResourceInfo &info)
+{
+  switch (_resource_order)
+  {
+  case ResourceOrder::SmallestFirst:
+    if (!info.packed)
     {
-      _packet->finalise();
-      writePacket(_packet->data(), _packet->packetSize(), true);
-      transferred += _packet->packetSize();
+      _unpacked_resources.emplace_back(info.queued.resource_id);
+      return;
     }
+    info.queued.order = info.packed->byteCount();
+    break;
+  case ResourceOrder::RecentFirst:
+    info.queued.order = std::numeric_limits<uint64_t>::max() - info.sequence;
+    break;
+  case ResourceOrder::Fifo:
+  default:
+    // Keep the order of first reference, set by referenceResource().
+    break;
+  }
+
+  info.queued.sequence = info.sequence;
+  _resource_queue.emplace_back(info.queued);
+  std::push_heap(_resource_queue.begin(), _resource_queue.end());
+
+  // Requeuing leaves stale entries. Purge them when they dominate the queue.
+  if (_resource_queue.size() > 2 * _resources.size() + kMinResourceQueuePurge)
+  {
+    _resource_queue.erase(std::remove_if(_resource_queue.begin(), _resource_queue.end(),
+                                         [this](const ResourceQueueEntry &entry) {
+                                           const auto search = _resources.find(entry.resource_id);
+                                           return search == _resources.end() ||
+                                                  search->second.started ||
+                                                  search->second.queued.sequence != entry.sequence;
+                                         }),
+                          _resource_queue.end());
+    std::make_heap(_resource_queue.begin(), _resource_queue.end());
+  }
+}
+
 
-    // Check completion.
-    if (!_current_resource->isValid())
+void BaseConnection::packResources()
+{
+  std::shared_ptr<ResourcePacketCache> cache;
+  std::vector<std::pair<uint64_t, ResourcePtr>> to_pack;
+  {
+    const std::lock_guard<Lock> resource_guard(_resource_lock);
+    cache = _resource_cache;
+    if (_current_resource && !_current_resource->packed)
+    {
+      to_pack.emplace_back(_current_resource->queued.resource_id, _current_resource->resource);
+    }
+    for (const auto resource_id : _unpacked_resources)
     {
-      // Have completed
-      const uint64_t completed_id = _current_resource->lastCompletedId();
-      auto resource_info = _resources.find(completed_id);
-      if (resource_info != _resources.end())
+      const auto search = _resources.find(resource_id);
+      if (search != _resources.end() && !search->second.packed)
       {
-        resource_info->second.sent = true;
+        to_pack.emplace_back(resource_id, search->second.resource);
       }
     }
+    _unpacked_resources.clear();
   }
 
-  return 0;
+  if (to_pack.empty())
+  {
+    return;
+  }
+
+  std::vector<std::shared_ptr<const PackedResource>> packed(to_pack.size());
+  for (size_t i = 0; i < to_pack.size(); ++i)
+  {
+    packed[i] = cache->acquire(to_pack[i].second);
+  }
+
+  // The resources may have been released or started while packing.
+  const std::lock_guard<Lock> resource_guard(_resource_lock);
+  for (size_t i = 0; i < to_pack.size(); ++i)
+  {
+    const auto search = _resources.find(to_pack[i].first);
+    if (search != _resources.end() && !search->second.packed)
+    {
+      search->second.packed = std::move(packed[i]);
+      if (!search->second.started)
+      {
+        queueResource(search->second);
+      }
+    }
+  }
 }
 
 
@@ -350,11 +544,71 @@ int BaseConnection::updateFrame(float dt, bool flush)
     wrote = writePacket(_packet_buffer.data(), _packet->packetSize(),
                         !(_server_flags & SFNakedFrameMessage));
   }
-  flushCollatedPacket();
+  if (_flush_policy.end_of_frame)
+  {
+    flushCollatedPacket();
+  }
+  updateAdaptiveControl();
   return wrote;
 }
 
 
+ConnectionStats BaseConnection::stats() const
+{
+  const std::lock_guard<Lock> stats_guard(_stats_lock);
+  return _stats;
+}
+
+
+void BaseConnection::setResourceCache(std::shared_ptr<ResourcePacketCache> cache)
+{
+  if (!cache)
+  {
+    return;
+  }
+
+  if (cache->packetSize() > _max_resource_packet_size)
+  {
+    log::error("Resource cache packet size ", cache->packetSize(), " exceeds the limit ",
+               _max_resource_packet_size);
+    return;
+  }
+
+  const std::lock_guard<Lock> resource_guard(_resource_lock);
+  _resource_cache = std::move(cache);
+}
+
+
+std::shared_ptr<ResourcePacketCache> BaseConnection::resourceCache() const
+{
+  const std::lock_guard<Lock> resource_guard(_resource_lock);
+  return _resource_cache;
+}
+
+
+std::vector<ResourceTransferStatus> BaseConnection::resourceTransfers() const
+{
+  std::vector<ResourceTransferStatus> transfers;
+  const auto now = std::chrono::steady_clock::now();
+  const std::lock_guard<Lock> resource_guard(_resource_lock);
+  transfers.reserve(_resources.size());
+  for (const auto &[key, info] : _resources)
+  {
+    ResourceTransferStatus status = {};
+    status.resource_key = key;
+    status.bytes_sent = info.bytes_sent;
+    status.byte_count = (info.packed) ? info.packed->byteCount() : 0u;
+    status.latency = (info.sent) ? info.latency :
+                                   std::chrono::duration_cast<std::chrono::duration<double>>(
+                                     now - info.referenced_time)
+                                     .count();
+    status.sent = info.sent;
+    transfers.emplace_back(status);
+  }
+  return transfers;
+}
+
+
 unsigned BaseConnection::referenceResource(const ResourcePtr &resource)
 {
   if (!_active)
@@ -365,15 +619,31 @@ unsigned BaseConnection::referenceResource(const ResourcePtr &resource)
   unsigned ref_count = 0;
   const uint64_t resource_id = resource->uniqueKey();
   const std::lock_guard<Lock> resource_guard(_resource_lock);
+  const int priority = _resource_cache->priority(resource_id);
   auto existing = _resources.find(resource_id);
   if (existing != _resources.end())
   {
-    ref_count = ++existing->second.reference_count;
+    ResourceInfo &info = existing->second;
+    ref_count = ++info.reference_count;
+    info.sequence = _resource_sequence++;
+    // Requeue when the ordering key changes.
+    if (!info.started &&
+        (_resource_order == ResourceOrder::RecentFirst || priority != info.queued.priority))
+    {
+      info.queued.priority = priority;
+      queueResource(info);
+    }
   }
   else
   {
-    _resources.emplace(std::make_pair(resource_id, ResourceInfo(resource)));
-    _resource_queue.push_back(resource_id);
+    ResourceInfo info(resource);
+    info.sequence = _resource_sequence++;
+    info.referenced_time = std::chrono::steady_clock::now();
+    info.queued.resource_id = resource_id;
+    info.queued.priority = priority;
+    info.queued.order = info.sequence;
+    auto inserted = _resources.emplace(std::make_pair(resource_id, std::move(info)));
+    queueResource(inserted.first->second);
     ref_count = 1;
   }
 
@@ -486,13 +756,13 @@ unsigned BaseConnection::releaseResource(uint64_t resource_id)
     }
     else
     {
-      if (_current_resource->resource() &&
-          _current_resource->resource()->uniqueKey() == resource_id)
+      if (_current_resource == &existing->second)
       {
-        _current_resource->cancel();
+        _current_resource = nullptr;
       }
 
-      if (existing->second.started || existing->second.sent)
+      // Only destroy once the create message has been sent.
+      if (existing->second.next_packet > 0)
       {
         // Send destroy message.
         _packet->reset();
@@ -509,6 +779,18 @@ unsigned BaseConnection::releaseResource(uint64_t resource_id)
 }
 
 
+bool BaseConnection::flushExpired(std::chrono::steady_clock::time_point now)
+{
+  const std::lock_guard<Lock> guard(_send_lock);
+  if (_flush_policy.max_age_us && collationExpired(now))
+  {
+    flushCollatedPacketUnguarded();
+    return true;
+  }
+  return false;
+}
+
+
 void BaseConnection::flushCollatedPacket()
 {
   const std::lock_guard<Lock> guard(_send_lock);
@@ -528,14 +810,14 @@ void BaseConnection::flushCollatedPacketUnguarded()
     const uint8_t *bytes = _collation->buffer(byte_count);
     if (bytes && byte_count)
     {
-      writeBytes(bytes, int_cast<int>((byte_count)));
+      timedWriteBytes(bytes, int_cast<int>((byte_count)));
     }
     _collation->reset();
   }
 }
 
 
-int BaseConnection::writePacket(const uint8_t *buffer, uint16_t byte_count, bool allow_collation)
+int BaseConnection::writePacket(const uint8_t *buffer, uint32_t byte_count, bool allow_collation)
 {
   const std::unique_lock<Lock> guard(_send_lock);
 
@@ -546,7 +828,7 @@ int BaseConnection::writePacket(const uint8_t *buffer, uint16_t byte_count, bool
 
   if ((SFCollate & _server_flags) == 0 || !allow_collation)
   {
-    return writeBytes(buffer, byte_count);
+    return timedWriteBytes(buffer, byte_count);
   }
 
   // Add to the collection buffer.
@@ -555,19 +837,169 @@ int BaseConnection::writePacket(const uint8_t *buffer, uint16_t byte_count, bool
     flushCollatedPacketUnguarded();
   }
 
+  const bool first_message = _collation->collatedBytes() == 0;
   int send_count = _collation->add(buffer, byte_count);
   if (send_count == -1)
   {
     // Failed to collate. Packet may be too big to collated (due to collation overhead).
     // Flush the buffer, then send without collation.
     flushCollatedPacketUnguarded();
-    send_count = writeBytes(buffer, byte_count);
+    send_count = timedWriteBytes(buffer, byte_count);
+  }
+  else if (_flush_policy.max_bytes || _flush_policy.max_age_us)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    if (first_message)
+    {
+      _collation_start_time = now;
+    }
+    if (collationExpired(now))
+    {
+      flushCollatedPacketUnguarded();
+    }
   }
 
   return send_count;
 }
 
 
+bool BaseConnection::collationExpired(std::chrono::steady_clock::time_point now) const
+{
+  const unsigned collated_bytes = _collation->collatedBytes();
+  if (collated_bytes == 0)
+  {
+    return false;
+  }
+
+  if (_flush_policy.max_bytes && collated_bytes >= _flush_policy.max_bytes)
+  {
+    return true;
+  }
+
+  return _flush_policy.max_age_us &&
+         now - _collation_start_time >= std::chrono::microseconds(_flush_policy.max_age_us);
+}
+
+
+int BaseConnection::timedWriteBytes(const uint8_t *data, int byte_count)
+{
+  const auto start_time = std::chrono::steady_clock::now();
+  const int wrote = writeBytes(data, byte_count);
+  _frame_write_time += std::chrono::steady_clock::now() - start_time;
+  if (wrote > 0)
+  {
+    _frame_bytes += static_cast<uint64_t>(wrote);
+  }
+  return wrote;
+}
+
+
+void BaseConnection::addWriteLatency(std::chrono::steady_clock::duration latency)
+{
+  _frame_write_time += latency;
+}
+
+
+void BaseConnection::updateAdaptiveControl()
+{
+  const std::lock_guard<Lock> send_guard(_send_lock);
+  const std::lock_guard<Lock> stats_guard(_stats_lock);
+
+  const double frame_latency = std::chrono::duration<double>(_frame_write_time).count();
+  _stats.bytes_sent += _frame_bytes;
+  _stats.send_latency += kAdaptiveSmoothing * (frame_latency - _stats.send_latency);
+  // Only sends which block measure the link. Fast sends only tell us the link is not saturated.
+  if (frame_latency > 0.1 * _target_latency && _frame_bytes)
+  {
+    const double frame_throughput = static_cast<double>(_frame_bytes) / frame_latency;
+    _stats.throughput = (_stats.throughput > 0) ?
+                          _stats.throughput +
+                            kAdaptiveSmoothing * (frame_throughput - _stats.throughput) :
+                          frame_throughput;
+  }
+  _frame_write_time = {};
+  _frame_bytes = 0;
+
+  if (!(_server_flags & SFAdaptive))
+  {
+    return;
+  }
+
+  if (_adaptive_cooldown)
+  {
+    --_adaptive_cooldown;
+  }
+
+  if (_stats.send_latency > _target_latency)
+  {
+    _adaptive_good_frames = 0;
+    if (!_adaptive_cooldown && _stats.adaptive_level < kMaxAdaptiveLevel)
+    {
+      ++_stats.adaptive_level;
+      _adaptive_cooldown = kAdaptiveCooldownFrames;
+      applyAdaptiveLevel();
+    }
+  }
+  else if (_stats.send_latency < 0.25 * _target_latency)
+  {
+    if (++_adaptive_good_frames >= kAdaptiveRecoveryFrames && _stats.adaptive_level > 0)
+    {
+      --_stats.adaptive_level;
+      _adaptive_good_frames = 0;
+      applyAdaptiveLevel();
+    }
+  }
+  else
+  {
+    _adaptive_good_frames = 0;
+  }
+
+  // Keep the transfer budget tracking the measured throughput.
+  if (_stats.adaptive_level >= kAdaptiveTransferLevel && _stats.throughput > 0)
+  {
+    const double budget = 0.25 * _stats.throughput * _target_latency;
+    const double max_budget = static_cast<double>(std::numeric_limits<int>::max());
+    _stats.transfer_byte_limit =
+      std::max(kMinTransferByteLimit, static_cast<unsigned>(std::min(budget, max_budget)));
+  }
+}
+
+
+void BaseConnection::applyAdaptiveLevel()
+{
+  const unsigned level = _stats.adaptive_level;
+
+  // Compression only applies to collated packets.
+  if (_server_flags & SFCollate)
+  {
+    const auto compression = static_cast<CompressionLevel>(
+      std::min(static_cast<unsigned>(_base_compression_level) + level,
+               static_cast<unsigned>(CompressionLevel::VeryHigh)));
+    const bool compress = compression != CompressionLevel::None;
+    // Toggling compression requires a new collation buffer. The buffer is only flushed before this
+    // call when frames flush collation, so rely on the collatedBytes() check to only replace an
+    // empty buffer. Otherwise the toggle is skipped until the next level change and the stats
+    // report the compression actually in use.
+    if (compress != _collation->compressionEnabled() && !_collation->collatedBytes())
+    {
+      _collation = std::make_unique<CollatedPacket>(compress, CollatedPacket::kDefaultBufferSize,
+                                                    _max_collated_packet_size);
+    }
+    _collation->setCompressionLevel(compression);
+    _stats.compression_level =
+      _collation->compressionEnabled() ? compression : CompressionLevel::None;
+  }
+
+  if (level < kAdaptiveTransferLevel)
+  {
+    _stats.transfer_byte_limit = 0;
+  }
+
+  _stats.point_decimation =
+    (level >= kAdaptiveDecimationLevel) ? 1u << (level - kAdaptiveDecimationLevel + 1) : 1u;
+}
+
+
 void BaseConnection::ensurePacketBufferCapacity(size_t size)
 {
   if (_packet_buffer.capacity() < size)
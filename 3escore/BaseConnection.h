@@ -7,12 +7,13 @@
 
 #include "Server.h"
 
+#include "CompressionLevel.h"
 #include "Connection.h"
 #include "Messages.h"
 #include "PacketWriter.h"
 
 #include <atomic>
-#include <list>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -21,8 +22,51 @@
 namespace tes
 {
 class CollatedPacket;
+class PackedResource;
 class Resource;
-class ResourcePacker;
+class ResourcePacketCache;
+
+/// Send statistics and adaptive quality parameters for a @c BaseConnection .
+///
+/// Adaptive parameters only change from their defaults when the connection is created with
+/// @c SFAdaptive .
+struct TES_CORE_API ConnectionStats
+{
+  /// Total number of bytes written.
+  uint64_t bytes_sent = 0;
+  /// Estimated throughput while sends are blocking (bytes/second). Zero until measured.
+  double throughput = 0;
+  /// Smoothed time per frame spent blocked writing to the connection (seconds).
+  double send_latency = 0;
+  /// Current adaptive degradation level. Zero is full quality.
+  unsigned adaptive_level = 0;
+  /// Compression level currently applied to collated packets.
+  CompressionLevel compression_level = CompressionLevel::None;
+  /// Per frame resource transfer byte budget. Zero for no adaptive limit, deferring to the
+  /// @c updateTransfers() argument.
+  unsigned transfer_byte_limit = 0;
+  /// Vertex stride applied to transient point cloud @c MeshShape objects. One for no decimation.
+  unsigned point_decimation = 1;
+  /// Number of resources completely transferred.
+  uint64_t resources_sent = 0;
+  /// Smoothed time from first referencing a resource to completing its transfer (seconds).
+  double resource_latency = 0;
+};
+
+/// Transfer progress for a single resource referenced by a @c BaseConnection .
+struct TES_CORE_API ResourceTransferStatus
+{
+  /// The @c Resource::uniqueKey() .
+  uint64_t resource_key = 0;
+  /// Number of bytes sent so far.
+  uint64_t bytes_sent = 0;
+  /// Total bytes to send. Zero until the resource has been packed.
+  uint64_t byte_count = 0;
+  /// Time from first reference until the transfer completed, or until now while pending (seconds).
+  double latency = 0;
+  /// True once the transfer has completed.
+  bool sent = false;
+};
 
 // Resource management:
 // - Reference count resources.
@@ -64,6 +108,14 @@ public:
   int destroy(const Shape &shape) override;
   int update(const Shape &shape) override;
 
+  /// Transfer queued resources, up to @p byte_limit bytes.
+  ///
+  /// Resources are sent in the order selected by @c ServerSettings::resource_order , after any
+  /// with a user priority. Each resource is sent as a sequence of packets packed once by the
+  /// @c resourceCache() . The @p byte_limit is respected at packet granularity, always sending at
+  /// least one packet when resources are pending.
+  /// @param byte_limit The maximum number of bytes to transfer. Zero for no limit.
+  /// @return Zero on success.
   int updateTransfers(unsigned byte_limit) override;
   int updateFrame(float dt, bool flush) override;
   using Connection::updateFrame;
@@ -71,9 +123,106 @@ public:
   unsigned referenceResource(const ResourcePtr &resource) override;
   unsigned releaseResource(const ResourcePtr &resource) override;
 
+  /// Query the current send statistics and adaptive parameters.
+  ///
+  /// Threadsafe.
+  /// @return The current statistics.
+  [[nodiscard]] ConnectionStats stats() const;
+
+  /// Set the cache used to pack resources for transfer. Connections to the same server share a
+  /// cache so each resource is packed once. Each connection has a private cache by default.
+  ///
+  /// This should be set before any resources are referenced. A cache using a larger packet size
+  /// than this connection's buffer is rejected.
+  /// @param cache The cache to use.
+  void setResourceCache(std::shared_ptr<ResourcePacketCache> cache);
+
+  /// Access the cache used to pack resources.
+  /// @return The resource cache.
+  [[nodiscard]] std::shared_ptr<ResourcePacketCache> resourceCache() const;
+
+  /// Query the transfer progress of the resources currently referenced by this connection.
+  ///
+  /// Threadsafe.
+  /// @return The progress of each referenced resource.
+  [[nodiscard]] std::vector<ResourceTransferStatus> resourceTransfers() const;
+
+  /// Query the collation flush policy.
+  /// @return The flush policy.
+  [[nodiscard]] const CollationFlushPolicy &flushPolicy() const { return _flush_policy; }
+
+  /// Send the pending collated packet if it is older than @c CollationFlushPolicy::max_age_us .
+  ///
+  /// Threadsafe. Called periodically by the server to bound collation latency between frames.
+  /// @param now The current time.
+  /// @return True if a collated packet was sent.
+  bool flushExpired(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+  /// Maximum adaptive degradation level.
+  static constexpr unsigned kMaxAdaptiveLevel = 6;
+
 protected:
   virtual int writeBytes(const uint8_t *data, int byte_count) = 0;
 
+  /// Invoke @c writeBytes() while tracking the bytes sent and time spent blocked.
+  ///
+  /// Note: the @c _send_lock must be locked before calling this function.
+  /// @param data The data to write.
+  /// @param byte_count Number of bytes to write.
+  /// @return The @c writeBytes() result.
+  int timedWriteBytes(const uint8_t *data, int byte_count);
+
+  /// Add time the link spent blocked which @c timedWriteBytes() cannot observe, such as a send
+  /// which completes asynchronously. The time contributes to the current frame's send latency.
+  ///
+  /// Note: the @c _send_lock must be locked before calling this function. This is the case when
+  /// called from @c writeBytes() .
+  /// @param latency The additional blocking time.
+  void addWriteLatency(std::chrono::steady_clock::duration latency);
+
+  /// Create @p shape without adaptive decimation. Implements @c create() .
+  /// @param shape The shape to create.
+  /// @return The number of bytes written or -1 on failure.
+  int createShape(const Shape &shape);
+
+  /// Update the send statistics at the end of a frame and, with @c SFAdaptive , select the
+  /// adaptive level for the next frame.
+  void updateAdaptiveControl();
+
+  /// Apply the parameters for the current adaptive level.
+  ///
+  /// Note: the @c _send_lock and @c _stats_lock must be locked before calling this function.
+  void applyAdaptiveLevel();
+
+  /// An entry in the @c _resource_queue . The transfer order is keyed when the resource is
+  /// referenced, so selecting the next resource does not need to query the @c _resource_cache .
+  struct ResourceQueueEntry
+  {
+    uint64_t resource_id = 0;  ///< The @c Resource::uniqueKey() .
+    /// User priority from the @c ResourcePacketCache . Higher priorities are sent first.
+    int priority = 0;
+    /// Order within a priority according to the @c ResourceOrder . Lower values are sent first.
+    uint64_t order = 0;
+    /// @c ResourceInfo::sequence when queued. Breaks ties and identifies stale entries.
+    uint64_t sequence = 0;
+
+    /// Heap ordering, placing the next resource to send at the top of the heap.
+    /// @param other The entry to compare against.
+    /// @return True if this entry is sent after @p other .
+    bool operator<(const ResourceQueueEntry &other) const
+    {
+      if (priority != other.priority)
+      {
+        return priority < other.priority;
+      }
+      if (order != other.order)
+      {
+        return order > other.order;
+      }
+      return sequence > other.sequence;
+    }
+  };
+
   /// Internal structure for managing a resource.
   struct ResourceInfo
   {
@@ -82,6 +231,20 @@ protected:
     /// decreases when @c releaseResource() is called. It also changes as non-transient shapes
     /// with resources are created and destroyed.
     unsigned reference_count = 0;
+    /// Packed transfer data. Set when the transfer is started or when needed for scheduling.
+    std::shared_ptr<const PackedResource> packed;
+    /// Index of the next packet in @c packed to send.
+    size_t next_packet = 0;
+    /// Number of bytes sent.
+    uint64_t bytes_sent = 0;
+    /// Reference sequence number. Updated each time the resource is referenced.
+    uint64_t sequence = 0;
+    /// Time the resource was first referenced.
+    std::chrono::steady_clock::time_point referenced_time = {};
+    /// The current @c _resource_queue entry. Entries with a different sequence number are stale.
+    ResourceQueueEntry queued;
+    /// Time from @c referenced_time to completing the transfer (seconds).
+    double latency = 0;
     bool started = false;  ///< Started sending?
     bool sent = false;     ///< Completed sending?
 
@@ -97,6 +260,28 @@ protected:
   /// @note The @c _packet_lock must be locked before calling this function.
   unsigned releaseResource(uint64_t resource_id);
 
+  /// Pop the next resource to transfer from the @c _resource_queue , skipping stale entries.
+  ///
+  /// Note: the @c _resource_lock must be locked before calling this function.
+  /// @return The next resource to transfer or null if there are no resources pending.
+  ResourceInfo *nextResource();
+
+  /// Add a queue entry for @p info using its current @c ResourceInfo::sequence and the
+  /// @c ResourceQueueEntry::priority set in @c ResourceInfo::queued .
+  ///
+  /// With @c ResourceOrder::SmallestFirst , resources which are yet to be packed are added to the
+  /// @c _unpacked_resources instead, and queued once @c packResources() has packed them.
+  ///
+  /// Note: the @c _resource_lock must be locked before calling this function.
+  /// @param info The resource to queue.
+  void queueResource(ResourceInfo &info);
+
+  /// Pack the current resource and any @c _unpacked_resources using the @c _resource_cache .
+  ///
+  /// Packing large resources is slow, so this is done without holding the @c _packet_lock or
+  /// the @c _resource_lock . Neither may be locked when calling this function.
+  void packResources();
+
   /// Package and send @c DataMessage packets for @p shape assuming @p shape.isComplex().
   ///
   /// This sends all the data messages for @p shape. Such messages should only be sent if the
@@ -137,33 +322,76 @@ protected:
   /// Send pending collated/compressed data without using the threadding guard.
   void flushCollatedPacketUnguarded();
 
+  /// Check if the pending collated packet should be sent according to the @c _flush_policy size
+  /// and age limits.
+  ///
+  /// Note: the @c _send_lock must be locked before calling this function.
+  /// @param now The current time.
+  /// @return True if the collated packet should be flushed.
+  [[nodiscard]] bool collationExpired(std::chrono::steady_clock::time_point now) const;
+
   /// Write data to the client. Handles collation and compression if enabled.
   ///
   /// Note: the @c _lock must be locked before calling this function.
   /// @param buffer The data buffer to send from.
   /// @param byte_count Number of bytes from @p buffer to send.
   /// @param True to allow collation and compression for this packet.
-  int writePacket(const uint8_t *buffer, uint16_t byte_count, bool allow_collation);
+  int writePacket(const uint8_t *buffer, uint32_t byte_count, bool allow_collation);
 
   void ensurePacketBufferCapacity(size_t size);
 
   // FIXME(KS): address protected member usage.
   // NOLINTBEGIN(cppcoreguidelines-non-private-member-variables-in-classes)
-  Lock _packet_lock;    ///< Lock for using @c _packet
-  Lock _send_lock;      ///< Lock for @c writePacket() and @c flushCollatedPacket()
-  Lock _resource_lock;  ///< Lock for @c _resources
+  Lock _packet_lock;            ///< Lock for using @c _packet
+  Lock _send_lock;              ///< Lock for @c writePacket() and @c flushCollatedPacket()
+  mutable Lock _resource_lock;  ///< Lock for @c _resources
   std::unique_ptr<PacketWriter> _packet;
   std::vector<uint8_t> _packet_buffer;
-  std::unique_ptr<ResourcePacker> _current_resource;  ///< Current resource being transmitted.
-  std::list<uint64_t> _resource_queue;
+  /// Current resource being transmitted. Points into @c _resources .
+  ResourceInfo *_current_resource = nullptr;
+  /// Heap of resources referenced, but not yet started. See @c ResourceQueueEntry . May contain
+  /// stale entries, which are skipped by @c nextResource() .
+  std::vector<ResourceQueueEntry> _resource_queue;
+  /// Resources to pack before they can be queued for @c ResourceOrder::SmallestFirst .
+  std::vector<uint64_t> _unpacked_resources;
   std::unordered_map<uint64_t, ResourceInfo> _resources;
+  /// Packs resources for transfer. Guarded by @c _resource_lock .
+  std::shared_ptr<ResourcePacketCache> _resource_cache;
+  /// Largest @c ResourcePacketCache::packetSize() supported. See @c SFExtendedPackets .
+  uint32_t _max_resource_packet_size = 0;
+  /// Resource transfer order policy.
+  ResourceOrder _resource_order = ResourceOrder::Fifo;
+  /// Sequence number for the next resource reference.
+  uint64_t _resource_sequence = 0;
   /// Buffer used when calling @c Shape::enumerateResources() . Use is transient.
   std::vector<ResourcePtr> _resource_buffer;
   ServerInfoMessage _server_info = {};
   float _seconds_to_time_unit = 0;
   unsigned _server_flags = 0;
+  /// Maximum @c _collation packet size. Larger than @c CollatedPacket::kMaxPacketSize only with
+  /// @c SFExtendedPackets , where large collated packets are sent as @c PFExtended packets.
+  unsigned _max_collated_packet_size = 0;
   std::unique_ptr<CollatedPacket> _collation;
+  /// Controls when @c _collation is sent.
+  CollationFlushPolicy _flush_policy = {};
+  /// Time the first message was added to @c _collation . Guarded by @c _send_lock .
+  std::chrono::steady_clock::time_point _collation_start_time = {};
   std::atomic_bool _active = { true };
+
+  mutable Lock _stats_lock;  ///< Lock for @c _stats
+  ConnectionStats _stats;
+  /// Time spent in @c writeBytes() during the current frame. Guarded by @c _send_lock .
+  std::chrono::steady_clock::duration _frame_write_time = {};
+  /// Bytes written during the current frame. Guarded by @c _send_lock .
+  uint64_t _frame_bytes = 0;
+  /// Target send latency for @c SFAdaptive (seconds).
+  double _target_latency = 0;
+  /// Configured compression level. Adaptive compression starts here.
+  CompressionLevel _base_compression_level = CompressionLevel::None;
+  /// Consecutive frames under the recovery threshold.
+  unsigned _adaptive_good_frames = 0;
+  /// Frames to wait before changing the adaptive level again.
+  unsigned _adaptive_cooldown = 0;
   // NOLINTEND(cppcoreguidelines-non-private-member-variables-in-classes)
 };
 }  // namespace tes
@@ -9,6 +9,7 @@
 #include "Log.h"
 #include "Maths.h"
 #include "Messages.h"
+#include "PacketStream.h"
 #include "PacketWriter.h"
 #include "Throw.h"
 
@@ -18,6 +19,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <limits>
 
 // clang-format off
 // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic)
@@ -27,25 +29,44 @@ namespace tes
 {
 namespace
 {
+/// Write the @c PacketHeader and @c CollatedPacketMessage to @p buffer.
+///
+/// For @p extended packets, the extended payload size is written after the header and the
+/// message follows it.
 void writeMessageHeader(uint8_t *buffer, unsigned uncompressed_size, unsigned payload_size,
-                        bool compressed)
+                        bool compressed, bool extended)
 {
   auto *header = reinterpret_cast<PacketHeader *>(buffer);
   std::memset(header, 0, sizeof(PacketHeader));
-  auto *message = reinterpret_cast<CollatedPacketMessage *>(buffer + sizeof(PacketHeader));
+  const size_t payload_offset = (extended) ? kExtendedPayloadSizeBytes : 0u;
+  auto *message =
+    reinterpret_cast<CollatedPacketMessage *>(buffer + sizeof(PacketHeader) + payload_offset);
   std::memset(message, 0, sizeof(CollatedPacketMessage));
 
   // Keep header in network byte order.
   header->marker = networkEndianSwapValue(kPacketMarker);
   header->version_major = networkEndianSwapValue(kPacketVersionMajor);
-  header->version_minor = networkEndianSwapValue(kPacketVersionMinor);
+  header->version_minor =
+    networkEndianSwapValue((extended) ? kPacketExtendedVersionMinor : kPacketVersionMinor);
   header->routing_id = MtCollatedPacket;
   networkEndianSwap(header->routing_id);
   header->message_id = 0;
-  header->payload_size = static_cast<uint16_t>(payload_size + sizeof(CollatedPacketMessage));
-  networkEndianSwap(header->payload_size);
-  header->payload_offset = 0;
-  header->flags = 0;
+  header->payload_offset = static_cast<uint8_t>(payload_offset);
+  if (extended)
+  {
+    header->payload_size = 0;
+    header->flags = PFExtended;
+    const uint32_t extended_payload_size = networkEndianSwapValue(
+      static_cast<uint32_t>(payload_size + sizeof(CollatedPacketMessage)));
+    std::memcpy(buffer + sizeof(PacketHeader), &extended_payload_size,
+                sizeof(extended_payload_size));
+  }
+  else
+  {
+    header->payload_size = static_cast<uint16_t>(payload_size + sizeof(CollatedPacketMessage));
+    networkEndianSwap(header->payload_size);
+    header->flags = 0;
+  }
 
   message->flags = (compressed) ? CPFCompress : CPFZero;
   networkEndianSwap(message->flags);
@@ -73,6 +94,12 @@ CollatedPacket::CollatedPacket(unsigned buffer_size, unsigned max_packet_size)
 }
 
 
+CollatedPacket::CollatedPacket(bool compress, unsigned buffer_size, unsigned max_packet_size)
+{
+  init(compress, buffer_size, max_packet_size);
+}
+
+
 CollatedPacket::~CollatedPacket() = default;
 
 
@@ -106,12 +133,12 @@ int CollatedPacket::add(const PacketWriter &packet)
   }
 
   const auto *packet_buffer = reinterpret_cast<const uint8_t *>(&packet.packet());
-  const uint16_t packet_bytes = packet.packetSize();
+  const uint32_t packet_bytes = packet.packetSize();
   return add(packet_buffer, packet_bytes);
 }
 
 
-int CollatedPacket::add(const uint8_t *buffer, uint16_t byte_count)
+int CollatedPacket::add(const uint8_t *buffer, uint32_t byte_count)
 {
   if (!_active)
   {
@@ -129,7 +156,7 @@ int CollatedPacket::add(const uint8_t *buffer, uint16_t byte_count)
   }
 
   // Check total size capacity.
-  if (collatedBytes() + byte_count + Overhead > _max_packet_size)
+  if (collatedBytes() + byte_count + _overhead > _max_packet_size)
   {
     // Too many bytes to collate.
     return -1;
@@ -162,7 +189,13 @@ bool CollatedPacket::finalise()
     return true;
   }
 
-  _final_buffer.resize(_buffer.size() + Overhead);
+  // Use a PFExtended packet when the payload does not fit the 16-bit payload size. This is decided
+  // on the uncompressed size so the data offset is known before compressing.
+  const bool extended = collatedBytes() + sizeof(CollatedPacketMessage) >
+                        std::numeric_limits<decltype(PacketHeader::payload_size)>::max();
+  const unsigned data_offset =
+    InitialCursorOffset + static_cast<unsigned>((extended) ? kExtendedPayloadSizeBytes : 0u);
+  _final_buffer.resize(_buffer.size() + data_offset + sizeof(PacketWriter::CrcType));
 
   // Finalise the packet. If possible, we try compress the buffer. If that is smaller then we use
   // the compressed result. Otherwise we use compressed data.
@@ -179,8 +212,8 @@ bool CollatedPacket::finalise()
     deflateInit2(&_zip->stream, gzip_compression_level, Z_DEFLATED,
                  CollatedPacketZip::WindowBits | CollatedPacketZip::GZipEncoding, 8,
                  Z_DEFAULT_STRATEGY);
-    _zip->stream.next_out = reinterpret_cast<Bytef *>(_final_buffer.data() + InitialCursorOffset);
-    _zip->stream.avail_out = static_cast<uInt>(_final_buffer.size() - Overhead);
+    _zip->stream.next_out = reinterpret_cast<Bytef *>(_final_buffer.data() + data_offset);
+    _zip->stream.avail_out = static_cast<uInt>(_buffer.size());
 
     int zip_ret = 0;
     _zip->stream.avail_in = collatedBytes();
@@ -200,8 +233,9 @@ bool CollatedPacket::finalise()
         // Compression is good. Smaller than uncompressed data.
         compressed_data = true;
         // Write uncompressed header.
-        writeMessageHeader(_final_buffer.data(), collatedBytes(), compressed_bytes, true);
-        _final_packet_cursor = InitialCursorOffset + compressed_bytes;
+        writeMessageHeader(_final_buffer.data(), collatedBytes(), compressed_bytes, true,
+                           extended);
+        _final_packet_cursor = data_offset + compressed_bytes;
       }
       else
       {
@@ -217,9 +251,9 @@ bool CollatedPacket::finalise()
   if (!compressed_data)
   {
     // No or failed compression. Write uncompressed.
-    writeMessageHeader(_final_buffer.data(), collatedBytes(), collatedBytes(), false);
-    std::memcpy(_final_buffer.data() + InitialCursorOffset, _buffer.data(), collatedBytes());
-    _final_packet_cursor = InitialCursorOffset + collatedBytes();
+    writeMessageHeader(_final_buffer.data(), collatedBytes(), collatedBytes(), false, extended);
+    std::memcpy(_final_buffer.data() + data_offset, _buffer.data(), collatedBytes());
+    _final_packet_cursor = data_offset + collatedBytes();
   }
 
   // Calculate the CRC
@@ -587,12 +621,12 @@ int CollatedPacket::send(const uint8_t *data, int byte_count, bool /*allow_colla
     return 0;
   }
 
-  if (byte_count > 0xffff)
+  if (byte_count < 0)
   {
     return -1;
   }
 
-  return add(data, static_cast<uint16_t>(byte_count));
+  return add(data, static_cast<uint32_t>(byte_count));
 }
 
 
@@ -616,6 +650,11 @@ void CollatedPacket::init(bool compress, unsigned buffer_size, unsigned max_pack
   _final_buffer.clear();
   _cursor = _final_packet_cursor = 0;
   _max_packet_size = max_packet_size;
+  _overhead = static_cast<unsigned>(Overhead);
+  if (_max_packet_size > kMaxPacketSize)
+  {
+    _overhead += static_cast<unsigned>(kExtendedPayloadSizeBytes);
+  }
 
 #ifdef TES_ZLIB
   if (compress)
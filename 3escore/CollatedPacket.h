@@ -52,6 +52,11 @@ class PacketWriter;
 /// Internally, the method may either send the packet as is (if small enough), or extract and
 /// reprocess each collated packet.
 ///
+/// A server may also collate into larger packets using the
+/// `CollatedPacket(bool, unsigned, unsigned)` constructor when the client supports
+/// @c PFExtended packets. Packets larger than @c kMaxPacketSize are then written as
+/// @c PFExtended packets.
+///
 /// @see See @c PacketHeader notes on @c payload_size limits.
 class TES_CORE_API CollatedPacket : public Connection
 {
@@ -87,6 +92,16 @@ public:
   /// @param max_packet_size The maximum packet size.
   CollatedPacket(unsigned buffer_size, unsigned max_packet_size);
 
+  /// Initialise a collated packet with optional compression, allowing packet sizes larger than
+  /// @p kMaxPacketSize. A finalised packet whose payload exceeds the 16-bit
+  /// @c PacketHeader::payload_size is written as a @c PFExtended packet, so this should only be
+  /// used where the receiver supports @c PFExtended packets.
+  ///
+  /// @param compress True to compress data as written.
+  /// @param buffer_size The initial buffer_size
+  /// @param max_packet_size The maximum packet size.
+  CollatedPacket(bool compress, unsigned buffer_size, unsigned max_packet_size);
+
   CollatedPacket(const CollatedPacket &) = delete;
 
   /// Destructor.
@@ -111,8 +126,9 @@ public:
   ///
   /// This defaults to 64 * 1024 - 1 (the maximum for a 16-bit unsigned integer),
   /// when using the constructor: @c CollatedPacket(bool, unsigned). It may be
-  /// larger when using the @c CollatedPacket(unsigned, unsigned) constructor.
-  /// See that constructor and class notes for details.
+  /// larger when using the @c CollatedPacket(unsigned, unsigned) or
+  /// @c CollatedPacket(bool, unsigned, unsigned) constructors. See those constructors and class
+  /// notes for details.
   ///
   /// @return The maximum packet capacity or 0xffffffffu if the packet size is variable.
   [[nodiscard]] unsigned maxPacketSize() const;
@@ -136,10 +152,14 @@ public:
   /// @param buffer The data to add.
   /// @param byte_count The number of bytes in @p buffer.
   /// @return The <tt>packet.packetSize()</tt> on success, or -1 on failure.
-  int add(const uint8_t *buffer, uint16_t byte_count);
+  int add(const uint8_t *buffer, uint32_t byte_count);
 
   /// Finalises the collated packet for sending. This includes completing
   /// compression and calculating the CRC.
+  ///
+  /// The packet is written as a @c PFExtended packet when the uncompressed collated bytes exceed
+  /// the 16-bit @c PacketHeader::payload_size limit. This is only possible when the
+  /// @c maxPacketSize() is larger than @c kMaxPacketSize .
   /// @return True on successful finalisation, false when already finalised.
   bool finalise();
 
@@ -265,6 +285,9 @@ private:
   unsigned _final_packet_cursor = 0;  ///< End of data in @c _final_buffer
   unsigned _cursor = 0;               ///< Current write position in @c _buffer.
   unsigned _max_packet_size = 0;      ///< Maximum @p _buffer_size.
+  /// Packet overhead for @c availableBytes() : @c Overhead plus the extended payload size field
+  /// when @c _max_packet_size allows @c PFExtended packets.
+  unsigned _overhead = 0;
   /// @c CompressionLevel
   CompressionLevel _compression_level = CompressionLevel::Default;
   bool _finalised = false;  ///< Finalisation flag.
@@ -291,7 +314,7 @@ inline unsigned CollatedPacket::collatedBytes() const
 
 inline unsigned CollatedPacket::availableBytes() const
 {
-  const unsigned used = collatedBytes() + static_cast<unsigned>(Overhead);
+  const unsigned used = collatedBytes() + _overhead;
   return (_max_packet_size >= used) ? _max_packet_size - used : 0;
 }
 }  // namespace tes
@@ -11,6 +11,7 @@
 
 #include "private/CollatedPacketZip.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace tes
@@ -21,13 +22,26 @@ constexpr size_t kDefaultBufferSize =
   4u * 1024u;  // NOLINT(bugprone-implicit-widening-of-multiplication-result)
 }  // namespace
 
-unsigned getPacketSize(const uint8_t *bytes)
+/// Validate the packet header at @p bytes and calculate the packet size.
+/// @param bytes The packet bytes.
+/// @param byte_count The number of bytes available at @p bytes . Must cover the header and any
+///   extended payload size.
+/// @param max_payload_size The largest extended payload size to accept.
+/// @return The packet size or zero if the header is invalid.
+unsigned getPacketSize(const uint8_t *bytes, size_t byte_count, uint32_t max_payload_size)
 {
+  if (byte_count < sizeof(PacketHeader))
+  {
+    return 0;
+  }
+
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
   const PacketReader reader(reinterpret_cast<const PacketHeader *>(bytes));
-  if (reader.marker() != kPacketMarker)
+  if (reader.marker() != kPacketMarker || !reader.validPayloadOffset() ||
+      byte_count < sizeof(PacketHeader) + reader.payloadOffset() ||
+      !reader.validPayloadSize(max_payload_size))
   {
-    // Invalid marker bytes. Fail.
+    // Invalid marker bytes or corrupt header. Fail.
     return 0;
   }
 
@@ -43,6 +57,7 @@ struct CollatedPacketDecoderDetail
   unsigned stream_bytes = 0;   // Number of bytes in stream.
   const PacketHeader *packet = nullptr;
   const uint8_t *stream = nullptr;
+  uint32_t max_payload_size = kDefaultMaxExtendedPayloadSize;
   CollatedPacketZip zip = CollatedPacketZip(true);
   bool compressed = false;
   bool ok = false;
@@ -101,6 +116,14 @@ struct CollatedPacketDecoderDetail
     target_bytes = target_decode_bytes;
     decoded_bytes = 0;
 
+    if (target_decode_bytes > max_payload_size)
+    {
+      // Corrupt or oversized collated packet.
+      initStream(0, 0, nullptr, 0);
+      ok = false;
+      return false;
+    }
+
     if (buffer.size() < target_decode_bytes)
     {
       buffer.resize(target_decode_bytes);
@@ -153,11 +176,14 @@ struct CollatedPacketDecoderDetail
       return nextPacketCompressed();
     }
 
+    // The uncompressed packets must lie within the collated payload.
+    const unsigned available = std::min(stream_bytes, target_bytes) - decoded_bytes;
     // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    const unsigned packet_size = getPacketSize(stream + decoded_bytes);
-    if (packet_size == 0)
+    const unsigned packet_size = getPacketSize(stream + decoded_bytes, available, max_payload_size);
+    if (packet_size == 0 || packet_size > available)
     {
-      // Validation failed.
+      // Validation failed. Abandon the rest of the collated packet.
+      finishCurrent();
       return nullptr;
     }
 
@@ -196,11 +222,33 @@ private:
       return nullptr;
     }
 
+    // Decode the extended payload size for extended packets. Validate the offset first.
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto *header = reinterpret_cast<const PacketHeader *>(buffer.data());
+    if (!PacketReader(header).validPayloadOffset())
+    {
+      finishCurrent();
+      return nullptr;
+    }
+    const unsigned payload_offset = header->payload_offset;
+    if (payload_offset > 0)
+    {
+      zip.stream.avail_out = payload_offset;
+      status = inflate(&zip.stream, Z_NO_FLUSH);
+      if (status == Z_STREAM_ERROR || status == Z_NEED_DICT || status == Z_DATA_ERROR ||
+          status == Z_MEM_ERROR || zip.stream.avail_out != 0)
+      {
+        return nullptr;
+      }
+    }
+    const auto header_size = static_cast<unsigned>(sizeof(PacketHeader)) + payload_offset;
+
     // Validate the header. Use a PacketReader to ensure endian swap as needed.
-    const unsigned packet_size = getPacketSize(buffer.data());
-    if (packet_size == 0)
+    const unsigned packet_size = getPacketSize(buffer.data(), header_size, max_payload_size);
+    if (packet_size < header_size)
     {
-      // Validation failed.
+      // Validation failed. Abandon the rest of the collated packet.
+      finishCurrent();
       return nullptr;
     }
 
@@ -209,11 +257,11 @@ private:
     {
       buffer.resize(packet_size);
       // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      zip.stream.next_out = buffer.data() + sizeof(PacketHeader);
+      zip.stream.next_out = buffer.data() + header_size;
     }
 
     // Inflate remaining packet bytes.
-    zip.stream.avail_out = int_cast<uInt>(packet_size - sizeof(PacketHeader));
+    zip.stream.avail_out = int_cast<uInt>(packet_size - header_size);
     status = inflate(&zip.stream, Z_NO_FLUSH);
 
     if (status == Z_STREAM_ERROR || status == Z_NEED_DICT || status == Z_DATA_ERROR ||
@@ -295,6 +343,7 @@ bool CollatedPacketDecoder::setPacket(const PacketHeader *packet)
       _detail = std::make_unique<CollatedPacketDecoderDetail>();
     }
 
+    _detail->max_payload_size = _max_payload_size;
     return _detail->init(packet);
   }
   if (_detail)
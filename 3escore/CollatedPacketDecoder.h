@@ -8,6 +8,7 @@
 //
 #include "Connection.h"
 #include "PacketHeader.h"
+#include "PacketStream.h"
 
 #include <memory>
 
@@ -106,10 +107,23 @@ public:
   /// The returned packet remains valid until the next call to @c next(), a new primary packet is
   /// set or this object goes out of scope.
   ///
+  /// Decoding stops at the first packet with a corrupt header or an oversized payload. See
+  /// @c setMaxPayloadSize() .
+  ///
   /// @return The next extracted packet or null when there are no more available.
   [[nodiscard]] const PacketHeader *next();
 
+  /// Set the largest @c PFExtended payload size accepted when decoding packets, and the largest
+  /// uncompressed size of a collated packet. Larger sizes are treated as corrupt. Defaults to
+  /// @c kDefaultMaxExtendedPayloadSize . Takes effect from the next @c setPacket() call.
+  /// @param max_payload_size The maximum payload size (bytes).
+  void setMaxPayloadSize(uint32_t max_payload_size) { _max_payload_size = max_payload_size; }
+  /// Query the largest payload size accepted. See @c setMaxPayloadSize() .
+  /// @return The maximum payload size (bytes).
+  [[nodiscard]] uint32_t maxPayloadSize() const { return _max_payload_size; }
+
 private:
   std::unique_ptr<CollatedPacketDecoderDetail> _detail;
+  uint32_t _max_payload_size = kDefaultMaxExtendedPayloadSize;
 };
 }  // namespace tes
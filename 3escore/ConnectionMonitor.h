@@ -189,6 +189,10 @@ public:
   /// For each new connection, the callback set in @c setConnectionCallback() is invoked,
   /// passing the server, connection and @p user argument.
   ///
+  /// When the server is created with @c SFStateCache , the cached state is also replayed to each
+  /// new connection from a background thread. The connection receives no other messages from the
+  /// server until the replay completes, so the callback should not recreate the scene.
+  ///
   /// @param callback When given, called for each new connection.
   /// @param user User argument passed to @p callback.
   virtual void commitConnections() = 0;
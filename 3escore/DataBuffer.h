@@ -797,9 +797,30 @@ public:
   /// @param overhead Byte overhead for a single transfer packet (headers etc), which effectively
   /// reduces the @c byte_limit.
   /// @param byte_limit Maximum number of bytes which can be transferred.
+  /// @param extended True if transferring in a @c PFExtended packet, which lifts the 16-bit
+  /// packet size and element count limits. The @p byte_limit must be given in this case.
   /// @return The maximum number of elements which can be packed into a single network packet.
-  [[nodiscard]] static uint16_t estimateTransferCount(size_t element_size, unsigned overhead,
-                                                      unsigned byte_limit);
+  [[nodiscard]] static uint32_t estimateTransferCount(size_t element_size, unsigned overhead,
+                                                      unsigned byte_limit, bool extended = false);
+
+  /// Query the byte size of the element count written to @p packet by @c write() . This is
+  /// a @c uint32_t for @c PFExtended packets and a @c uint16_t otherwise.
+  /// @param packet The packet of interest.
+  /// @return The count byte size.
+  template <typename Header>
+  [[nodiscard]] static unsigned transferCountSize(const PacketStream<Header> &packet);
+
+  /// Write an element count to @p packet using @c transferCountSize() bytes.
+  /// @param packet The packet to write to.
+  /// @param count The count to write. Must be representable in @c transferCountSize() bytes.
+  /// @return True on success.
+  static bool writeTransferCount(PacketWriter &packet, uint32_t count);
+
+  /// Read an element count written by @c writeTransferCount() .
+  /// @param packet The packet to read from.
+  /// @param[out] count The count read.
+  /// @return True on success.
+  static bool readTransferCount(PacketReader &packet, uint32_t &count);
 
   // receive_offset: offset packed into the message for the receiver to handle. Allows a small
   // vertex buffer to represent a slice of a buffer at the other end.
@@ -823,7 +844,8 @@ public:
   ///
   /// - @c uint32_t @c offset - the index of the first element in the @p packet.
   ///   Calculated as `offset + receive_offset`.
-  /// - @c uin16_t @c count - the number of elements in the @p packet.
+  /// - @c uin16_t @c count - the number of elements in the @p packet. This is a @c uint32_t for
+  ///   @c PFExtended packets.
   /// - @c uint8_t @c component_count - number of primitives in each element (channels).
   /// - @c uint8_t @c dataType - the @c DataStreamType of data in the buffer.
   /// - buffer data
@@ -866,7 +888,8 @@ public:
   /// The packet is assumed to have the following format:
   ///
   /// - @c uint32_t @c offset - the element offset to write into this buffer.
-  /// - @c uint16_t @c count - the number of elements to read from the @p packet.
+  /// - @c uint16_t @c count - the number of elements to read from the @p packet. This is a
+  ///   @c uint32_t for @c PFExtended packets.
   /// - @c uint8_t @c component_count - the @c componentCount() of data in the @p packet (channels).
   /// - @c uint8_t @c packetType - the @c DataStreamType of data in the packet.
   ///
@@ -89,11 +89,11 @@ inline DataBuffer::DataBuffer(bool own_pointer, T *v, size_t count, size_t compo
   , _flags((own_pointer && v) ? Flag::OwnPointer : Flag::Zero)
   , _affordances(detail::DataBufferAffordancesT<T>::instance())
 {
-  static_assert(typeid(std::remove_const_t<T>) != typeid(Vector3f),
+  static_assert(!std::is_same_v<std::remove_const_t<T>, Vector3f>,
                 "Unsupported mutable stream type. Use const T * constructor and duplicate()");
-  static_assert(typeid(std::remove_const_t<T>) != typeid(Vector3d),
+  static_assert(!std::is_same_v<std::remove_const_t<T>, Vector3d>,
                 "Unsupported mutable stream type. Use const T * constructor and duplicate()");
-  static_assert(typeid(std::remove_const_t<T>) != typeid(Colour),
+  static_assert(!std::is_same_v<std::remove_const_t<T>, Colour>,
                 "Unsupported mutable stream type. Use const T * constructor and duplicate()");
 }
 
@@ -314,9 +314,15 @@ inline const T *DataBuffer::ptrAt(size_t element_index) const
   return nullptr;
 }
 
-inline uint16_t DataBuffer::estimateTransferCount(size_t element_size, unsigned overhead,
-                                                  unsigned byte_limit)
+inline uint32_t DataBuffer::estimateTransferCount(size_t element_size, unsigned overhead,
+                                                  unsigned byte_limit, bool extended)
 {
+  if (extended)
+  {
+    // The byte limit is the only limit for extended packets.
+    return static_cast<uint32_t>(byte_limit / element_size);
+  }
+
   // FIXME: Without additional overhead padding I was getting missing messages at the client with
   // no obvious error path. For this reason, we use 0xff00u, instead of 0xffffu
   //           packet header           message                 crc
@@ -328,11 +334,55 @@ inline uint16_t DataBuffer::estimateTransferCount(size_t element_size, unsigned
     count = max_transfer;
   }
 
-  return static_cast<uint16_t>(count);
+  return static_cast<uint32_t>(count);
+}
+
+
+template <typename Header>
+inline unsigned DataBuffer::transferCountSize(const PacketStream<Header> &packet)
+{
+  return (packet.isExtended()) ? static_cast<unsigned>(sizeof(uint32_t)) :
+                                 static_cast<unsigned>(sizeof(uint16_t));
+}
+
+
+inline bool DataBuffer::writeTransferCount(PacketWriter &packet, uint32_t count)
+{
+  if (packet.isExtended())
+  {
+    return packet.writeElement(count) == sizeof(count);
+  }
+  return packet.writeElement(static_cast<uint16_t>(count)) == sizeof(uint16_t);
+}
+
+
+inline bool DataBuffer::readTransferCount(PacketReader &packet, uint32_t &count)
+{
+  if (packet.isExtended())
+  {
+    return packet.readElement(count) == sizeof(count);
+  }
+  uint16_t count16 = 0;
+  const bool ok = packet.readElement(count16) == sizeof(count16);
+  count = count16;
+  return ok;
 }
 
 namespace detail
 {
+/// Limit @p byte_limit to the payload space remaining in an extended @p packet after writing
+/// @p overhead bytes and the CRC. Unlike non-extended packets, this limit is not enforced by
+/// @c DataBuffer::estimateTransferCount() .
+inline unsigned extendedByteLimit(const PacketWriter &packet, unsigned overhead,
+                                  unsigned byte_limit)
+{
+  const unsigned reserved = overhead + static_cast<unsigned>(sizeof(PacketWriter::CrcType));
+  const unsigned available =
+    (packet.bytesRemaining() > reserved) ? packet.bytesRemaining() - reserved : 0u;
+  return std::min(byte_limit, available);
+}
+
+
 template <typename T>
 DataBufferAffordances *DataBufferAffordancesT<T>::instance()
 {
@@ -414,27 +464,32 @@ uint32_t DataBufferAffordancesT<T>::writeAs(PacketWriter &packet, uint32_t offse
 
   // Overhead: account for:
   // - uint32_t offset
-  // - uint16_t count
+  // - uint16_t count (uint32_t for extended packets)
   // - uint8_t component count
   // - uint8_t data type
-  const unsigned overhead = sizeof(uint32_t) +  // offset
-                            sizeof(uint16_t) +  // count
-                            sizeof(uint8_t) +   // element stride
-                            sizeof(uint8_t);    // data type;
+  const unsigned overhead = sizeof(uint32_t) +                         // offset
+                            DataBuffer::transferCountSize(packet) +  // count
+                            sizeof(uint8_t) +                          // element stride
+                            sizeof(uint8_t);                           // data type;
 
   byte_limit =
     (byte_limit) ? (byte_limit > overhead ? byte_limit - overhead : 0) : packet.bytesRemaining();
-  uint16_t transfer_count = DataBuffer::estimateTransferCount(item_size, overhead, byte_limit);
+  if (packet.isExtended())
+  {
+    byte_limit = extendedByteLimit(packet, overhead, byte_limit);
+  }
+  uint32_t transfer_count =
+    DataBuffer::estimateTransferCount(item_size, overhead, byte_limit, packet.isExtended());
   if (transfer_count > buffer.count() - offset)
   {
-    transfer_count = static_cast<uint16_t>(buffer.count() - offset);
+    transfer_count = static_cast<uint32_t>(buffer.count() - offset);
   }
 
   // Write header
   bool ok = true;
   ok =
     packet.writeElement(static_cast<uint32_t>(offset + receive_offset)) == sizeof(uint32_t) && ok;
-  ok = packet.writeElement(static_cast<uint16_t>(transfer_count)) == sizeof(uint16_t) && ok;
+  ok = DataBuffer::writeTransferCount(packet, transfer_count) && ok;
   ok = packet.writeElement(static_cast<uint8_t>(buffer.componentCount())) == sizeof(uint8_t) && ok;
   ok = packet.writeElement(static_cast<uint8_t>(write_as_type)) == sizeof(uint8_t) && ok;
 
@@ -500,24 +555,29 @@ uint32_t DataBufferAffordancesT<T>::writeAsPacked(PacketWriter &packet, uint32_t
 
   // Overhead: account for:
   // - uint32_t offset
-  // - uint16_t count
+  // - uint16_t count (uint32_t for extended packets)
   // - uint8_t element stride
   // - uint8_t data type
   // - FloatType quantisation_unit
   // - FloatType[buffer.componentCount()] packet_origin
   const auto overhead =
     int_cast<unsigned>(sizeof(uint32_t) +                             // offset
-                       sizeof(uint16_t) +                             // count
+                       DataBuffer::transferCountSize(packet) +        // count
                        sizeof(uint8_t) +                              // element stride
                        sizeof(uint8_t) +                              // data type
                        sizeof(quantisation_unit) +                    // quantisation_unit
                        sizeof(FloatType) * buffer.componentCount());  // packet_origin
 
   byte_limit = (byte_limit) ? byte_limit : packet.bytesRemaining();
-  uint16_t transfer_count = DataBuffer::estimateTransferCount(item_size, overhead, byte_limit);
+  if (packet.isExtended())
+  {
+    byte_limit = extendedByteLimit(packet, overhead, byte_limit);
+  }
+  uint32_t transfer_count =
+    DataBuffer::estimateTransferCount(item_size, overhead, byte_limit, packet.isExtended());
   if (transfer_count > buffer.count() - offset)
   {
-    transfer_count = static_cast<uint16_t>(buffer.count() - offset);
+    transfer_count = static_cast<uint32_t>(buffer.count() - offset);
   }
 
   if (transfer_count == 0)
@@ -529,7 +589,7 @@ uint32_t DataBufferAffordancesT<T>::writeAsPacked(PacketWriter &packet, uint32_t
   bool ok = true;
   ok =
     packet.writeElement(static_cast<uint32_t>(offset + receive_offset)) == sizeof(uint32_t) && ok;
-  ok = packet.writeElement(static_cast<uint16_t>(transfer_count)) == sizeof(uint16_t) && ok;
+  ok = DataBuffer::writeTransferCount(packet, transfer_count) && ok;
   ok = packet.writeElement(static_cast<uint8_t>(buffer.componentCount())) == sizeof(uint8_t) && ok;
   ok = packet.writeElement(static_cast<uint8_t>(write_as_type)) == sizeof(uint8_t) && ok;
   const FloatType q_unit{ quantisation_unit };
@@ -590,11 +650,11 @@ uint32_t DataBufferAffordancesT<T>::read(PacketReader &packet, void **stream_ptr
                                          const DataBuffer &buffer) const
 {
   uint32_t offset = 0u;
-  uint16_t count = 0u;
+  uint32_t count = 0u;
 
   bool ok = true;
   ok = packet.readElement(offset) == sizeof(offset) && ok;
-  ok = packet.readElement(count) == sizeof(count) && ok;
+  ok = DataBuffer::readTransferCount(packet, count) && ok;
 
   if (!ok)
   {
@@ -6,14 +6,16 @@
 #include "StreamUtil.h"
 
 #include <mutex>
+#include <sstream>
 
 namespace tes
 {
 FileConnection::FileConnection(const std::string &filename, const ServerSettings &settings)
   : BaseConnection(settings)
-  , _out_file(filename, std::ios::binary | std::ios::out | std::ios::in | std::ios::trunc)
   , _filename(filename)
-{}
+{
+  _out_file.open(filename);
+}
 
 
 // TODO(KS): What's the correct way to handle the potential for close() throwing an exception?
@@ -32,12 +34,8 @@ FileConnection::~FileConnection()
 void FileConnection::close()
 {
   const std::lock_guard<Lock> guard(_file_lock);
-  if (_out_file.is_open())
-  {
-    _out_file.flush();
-    streamutil::finaliseStream(_out_file, _frame_count);
-    _out_file.close();
-  }
+  _out_file.close(
+    [this](std::fstream &file) { streamutil::finaliseStream(file, _frame_count); });
 }
 
 
@@ -62,7 +60,7 @@ uint16_t FileConnection::port() const
 bool FileConnection::isConnected() const
 {
   const std::lock_guard<Lock> guard(_file_lock);
-  return _out_file.is_open();
+  return _out_file.isOpen();
 }
 
 
@@ -74,7 +72,13 @@ bool FileConnection::sendServerInfo(const ServerInfoMessage &info)
   }
 
   // Server info already written. No need to write it again.
-  return streamutil::initialiseStream(_out_file, nullptr);
+  std::ostringstream header;
+  if (!streamutil::initialiseStream(header, nullptr))
+  {
+    return false;
+  }
+  const std::string header_bytes = header.str();
+  return _out_file.write(header_bytes.data(), header_bytes.size());
 }
 
 
@@ -87,9 +91,7 @@ int FileConnection::updateFrame(float dt, bool flush)
 
 int FileConnection::writeBytes(const uint8_t *data, int byte_count)
 {
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-  _out_file.write(reinterpret_cast<const char *>(data), byte_count);
-  if (!_out_file.fail())
+  if (_out_file.write(data, static_cast<size_t>(byte_count)))
   {
     return byte_count;
   }
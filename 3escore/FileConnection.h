@@ -8,13 +8,16 @@
 #include "Server.h"
 
 #include "BaseConnection.h"
+#include "WriteBehindFile.h"
 
-#include <fstream>
 #include <string>
 
 namespace tes
 {
 /// A file stream implementation of a 3es @c Connection.
+///
+/// File IO is performed on a background thread by a @c WriteBehindFile , so slow storage does not
+/// stall the server until the write buffers are exhausted.
 class TES_CORE_API FileConnection final : public BaseConnection
 {
 public:
@@ -43,12 +46,16 @@ public:
 
   int updateFrame(float dt, bool flush) final;
 
+  /// Query the file write statistics.
+  /// @return The write behind statistics.
+  [[nodiscard]] WriteBehindFile::Stats fileStats() const { return _out_file.stats(); }
+
 protected:
   int writeBytes(const uint8_t *data, int byte_count) final;
 
 private:
   mutable Lock _file_lock;  ///< Lock for @c _out_file() operations
-  std::fstream _out_file;
+  WriteBehindFile _out_file;
   std::string _filename;
   unsigned _frame_count = 0;
 };
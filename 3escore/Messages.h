@@ -44,6 +44,16 @@ enum RoutingId : uint16_t
   UserIDStart = 2048
 };
 
+/// Build a key uniquely identifying an object or resource in a stream from its routing ID and its
+/// ID. Shape categories are not part of the key as a shape ID is unique within its routing ID.
+/// @param routing_id The object routing ID or resource type ID.
+/// @param id The object or resource ID.
+/// @return The combined key.
+inline uint64_t objectKey(uint16_t routing_id, uint32_t id)
+{
+  return (static_cast<uint64_t>(routing_id) << 32u) | static_cast<uint64_t>(id);
+}
+
 /// Default/built in renderers (routing IDs).
 enum ShapeHandlerId : uint16_t
 {
@@ -198,6 +208,13 @@ enum UpdateFlag : uint16_t
   UFScale = (OFExtended << 4u),     ///< Update scale data.
   UFColour = (OFExtended << 5u),    ///< Update colour data.
   UFPosRotScaleColour = UFPosition | UFRotation | UFScale | UFColour,
+  /// Used with @c UFUpdateMode to indicate the @c UpdateMessage only carries the attributes
+  /// selected by the other update flags, rather than a full @c ObjectAttributes block. Present
+  /// attributes are written in the order colour, position, rotation, scale.
+  ///
+  /// Older clients do not understand this flag, so it is only written when explicitly enabled.
+  /// See @c SFDeltaUpdates .
+  UFCompact = (OFExtended << 6u),
 };
 
 /// Flags for @c CollatedPacketMessage.
@@ -558,6 +575,121 @@ struct TES_CORE_API ObjectAttributes
     return ok;
   }
 
+  /// Read the attribute parts selected by @p parts from @p reader selecting the precision using
+  /// @p read_double_precision . Attributes not selected are left unchanged.
+  /// @param reader The data source.
+  /// @param read_double_precision True to try read double precision, false to try single precision.
+  /// @param parts The attributes to read - @c UpdateFlag values from @c UFPosRotScaleColour .
+  /// @return True on success.
+  inline bool readParts(PacketReader &reader, bool read_double_precision, unsigned parts)
+  {
+    if (read_double_precision)
+    {
+      return readPartsT<double>(reader, parts);
+    }
+    return readPartsT<float>(reader, parts);
+  }
+
+  /// Read the attribute parts selected by @p parts from @p reader using the type @p T to decode
+  /// position, rotation and scale elements. Attributes not selected are left unchanged.
+  /// @param reader The data source.
+  /// @param parts The attributes to read - @c UpdateFlag values from @c UFPosRotScaleColour .
+  /// @return True on success.
+  /// @tparam T Either @c float or @c double
+  template <typename T>
+  inline bool readPartsT(PacketReader &reader, unsigned parts)
+  {
+    bool ok = true;
+    T value;
+    if (parts & UFColour)
+    {
+      ok = reader.readElement(colour) == sizeof(colour) && ok;
+    }
+    if (parts & UFPosition)
+    {
+      for (size_t i = 0; i < 3; ++i)
+      {
+        ok = reader.readElement(value) == sizeof(value) && ok;
+        position[i] = Real(value);
+      }
+    }
+    if (parts & UFRotation)
+    {
+      for (size_t i = 0; i < 4; ++i)
+      {
+        ok = reader.readElement(value) == sizeof(value) && ok;
+        rotation[i] = Real(value);
+      }
+    }
+    if (parts & UFScale)
+    {
+      for (size_t i = 0; i < 3; ++i)
+      {
+        ok = reader.readElement(value) == sizeof(value) && ok;
+        scale[i] = Real(value);
+      }
+    }
+    return ok;
+  }
+
+  /// Write the attribute parts selected by @p parts to @p writer selecting the packing precision
+  /// based on @c write_double_precision .
+  /// @param writer The target buffer.
+  /// @param write_double_precision True to write double precision values, false for single
+  /// precision.
+  /// @param parts The attributes to write - @c UpdateFlag values from @c UFPosRotScaleColour .
+  /// @return True on success.
+  inline bool writeParts(PacketWriter &writer, bool write_double_precision, unsigned parts) const
+  {
+    if (write_double_precision)
+    {
+      return writePartsT<double>(writer, parts);
+    }
+    return writePartsT<float>(writer, parts);
+  }
+
+  /// Write the attribute parts selected by @p parts to @p writer using the type @p T to encode
+  /// position, rotation and scale elements.
+  /// @param writer The target buffer.
+  /// @param parts The attributes to write - @c UpdateFlag values from @c UFPosRotScaleColour .
+  /// @return True on success.
+  /// @tparam T Either @c float or @c double
+  template <typename T>
+  inline bool writePartsT(PacketWriter &writer, unsigned parts) const
+  {
+    bool ok = true;
+    T value;
+    if (parts & UFColour)
+    {
+      ok = writer.writeElement(colour) == sizeof(colour) && ok;
+    }
+    if (parts & UFPosition)
+    {
+      for (size_t i = 0; i < 3; ++i)
+      {
+        value = T(position[i]);
+        ok = writer.writeElement(value) == sizeof(value) && ok;
+      }
+    }
+    if (parts & UFRotation)
+    {
+      for (size_t i = 0; i < 4; ++i)
+      {
+        value = T(rotation[i]);
+        ok = writer.writeElement(value) == sizeof(value) && ok;
+      }
+    }
+    if (parts & UFScale)
+    {
+      for (size_t i = 0; i < 3; ++i)
+      {
+        value = T(scale[i]);
+        ok = writer.writeElement(value) == sizeof(value) && ok;
+      }
+    }
+    return ok;
+  }
+
   template <typename real_dst>
   inline operator ObjectAttributes<real_dst>() const
   {
@@ -693,7 +825,15 @@ struct TES_CORE_API UpdateMessage
     bool ok = true;
     ok = reader.readElement(id) == sizeof(id) && ok;
     ok = reader.readElement(flags) == sizeof(flags) && ok;
-    ok = attributes.read(reader, flags & OFDoublePrecision) && ok;
+    if ((flags & (UFUpdateMode | UFCompact)) == (UFUpdateMode | UFCompact))
+    {
+      ok = attributes.readParts(reader, flags & OFDoublePrecision, flags & UFPosRotScaleColour) &&
+           ok;
+    }
+    else
+    {
+      ok = attributes.read(reader, flags & OFDoublePrecision) && ok;
+    }
     return ok;
   }
 
@@ -706,7 +846,15 @@ struct TES_CORE_API UpdateMessage
     bool ok = true;
     ok = writer.writeElement(id) == sizeof(id) && ok;
     ok = writer.writeElement(flags) == sizeof(flags) && ok;
-    ok = attributes.write(writer, flags & OFDoublePrecision) && ok;
+    if ((flags & (UFUpdateMode | UFCompact)) == (UFUpdateMode | UFCompact))
+    {
+      ok = attributes.writeParts(writer, flags & OFDoublePrecision, flags & UFPosRotScaleColour) &&
+           ok;
+    }
+    else
+    {
+      ok = attributes.write(writer, flags & OFDoublePrecision) && ok;
+    }
     return ok;
   }
 };
@@ -34,7 +34,7 @@ int packetMarkerPosition(const uint8_t *bytes, size_t byte_count)
 {
   thread_local const MarkerBytes packet_marker;
 
-  for (size_t i = 0; i < byte_count; i += 4)
+  for (size_t i = 0; i + packet_marker.size() <= byte_count; ++i)
   {
     if (bytes[i] == packet_marker[0])
     {
@@ -57,9 +57,8 @@ int packetMarkerPosition(const uint8_t *bytes, size_t byte_count)
 }  // namespace
 
 PacketBuffer::PacketBuffer(size_t capacity)
-{
-  _packet_buffer.reserve(capacity);
-}
+  : _packet_buffer(capacity)
+{}
 
 
 PacketBuffer::~PacketBuffer() = default;
@@ -67,97 +66,162 @@ PacketBuffer::~PacketBuffer() = default;
 
 int PacketBuffer::addBytes(const uint8_t *bytes, size_t byte_count)
 {
-  if (_marker_found)
-  {
-    // Append to the existing buffer.
-    appendData(bytes, bytes + byte_count);
-    // All bytes accepted.
-    return 0;
-  }
+  appendData(bytes, bytes + byte_count);
+  return acceptBytes(byte_count);
+}
 
-  // Buffer does not hold any interesting data. Find the marker position in incoming data and
-  // initialise the _packet_buffer from there.
-  const int marker_pos = packetMarkerPosition(bytes, byte_count);
-  if (marker_pos >= 0)
-  {
-    _marker_found = true;
-    appendData(bytes + marker_pos, bytes + byte_count - static_cast<size_t>(marker_pos));
-    return marker_pos;
-  }
 
-  return -1;
+uint8_t *PacketBuffer::writeBuffer(size_t byte_count)
+{
+  reserveWrite(byte_count);
+  return _packet_buffer.data() + _write_offset;
+}
+
+
+int PacketBuffer::commitBytes(size_t byte_count)
+{
+  _write_offset += byte_count;
+  return acceptBytes(byte_count);
 }
 
 
 PacketHeader *PacketBuffer::extractPacket(std::vector<uint8_t> &buffer)
 {
-  if (_marker_found && _packet_buffer.size() >= sizeof(PacketHeader))
+  while (_marker_found && pendingBytes() >= sizeof(PacketHeader))
   {
     // Remember, the CRC appears after the packet payload. We have to include
     // that in our mem copy.
-    auto *pending = reinterpret_cast<PacketHeader *>(_packet_buffer.data());
-    const PacketReader reader(pending);
-    if (reader.packetSize() <= _packet_buffer.size())
+    const size_t pending_size = pendingBytes();
+    const uint8_t *pending_bytes = _packet_buffer.data() + _read_offset;
+    const PacketReader reader(reinterpret_cast<const PacketHeader *>(pending_bytes));
+    if (!reader.validPayloadOffset())
     {
-      // We have a full packet. Allocate a copy and extract the full packet data.
-      const unsigned packet_size = reader.packetSize();
-      // FIXME(KS): why copy to a new buffer? Can't we hold a pointer in the buffer, then shift
-      // bytes on release?
-      buffer.clear();
-      std::copy(_packet_buffer.begin(), _packet_buffer.begin() + packet_size,
-                std::back_inserter(buffer));
+      // Corrupt header. Resync on the next marker.
+      skipMarker();
+      continue;
+    }
+
+    // Extended packets need the payload size following the header.
+    if (sizeof(PacketHeader) + reader.payloadOffset() > pending_size)
+    {
+      break;
+    }
 
+    if (!reader.validPayloadSize(_max_payload_size))
+    {
+      skipMarker();
+      continue;
+    }
+
+    if (reader.packetSize() <= pending_size)
+    {
+      // We have a full packet. Copy out the full packet data.
+      const size_t packet_size = reader.packetSize();
+      // The copy leaves the caller holding a stable packet while we continue to buffer data.
+      buffer.assign(pending_bytes, pending_bytes + packet_size);
+
+      // Find next marker beyond the packet just returned.
+      // TODO(KS): should highlight an error when the next marker does not immediately follow the
+      // packet as that suggests some sort of data issue.
+      removeData(packet_size);
       _marker_found = false;
-      if (_packet_buffer.size() > packet_size)
-      {
-        // Find next marker beyond the packet just returned.
-        const int next_marker_pos = packetMarkerPosition(_packet_buffer.data() + packet_size,
-                                                         _packet_buffer.size() - packet_size);
-        // TODO(KS): should highlight an error when next_marker_pos != packet_size as that suggests
-        // some sort of data issue.
-        if (next_marker_pos >= 0)
-        {
-          removeData(int_cast<size_t>(packet_size + static_cast<size_t>(next_marker_pos)));
-          _marker_found = true;
-        }
-        else
-        {
-          // No new marker. Remove all data.
-          removeData(_packet_buffer.size());
-        }
-      }
-      else
-      {
-        removeData(packet_size);
-      }
+      findMarker();
 
       return reinterpret_cast<PacketHeader *>(buffer.data());
     }
+    break;
   }
 
   return nullptr;
 }
 
 
+int PacketBuffer::acceptBytes(size_t byte_count)
+{
+  if (_marker_found)
+  {
+    // All bytes accepted.
+    return 0;
+  }
+
+  // Pending data may hold the start of a marker. Find the first byte of the new data which is
+  // accepted.
+  const size_t prior_byte_count = pendingBytes() - byte_count;
+  const int marker_pos = findMarker();
+  if (marker_pos >= 0)
+  {
+    return std::max(0, marker_pos - static_cast<int>(prior_byte_count));
+  }
+
+  return -1;
+}
+
+
+int PacketBuffer::findMarker()
+{
+  const size_t pending_size = pendingBytes();
+  const int marker_pos = packetMarkerPosition(_packet_buffer.data() + _read_offset, pending_size);
+  if (marker_pos >= 0)
+  {
+    removeData(static_cast<size_t>(marker_pos));
+    _marker_found = true;
+    return marker_pos;
+  }
+
+  // Retain any trailing bytes which may be the start of a marker split across reads.
+  const size_t retain = std::min(pending_size, sizeof(kPacketMarker) - 1u);
+  removeData(pending_size - retain);
+  return -1;
+}
+
+
+void PacketBuffer::skipMarker()
+{
+  removeData(sizeof(kPacketMarker));
+  _marker_found = false;
+  findMarker();
+}
+
+
 template <typename Iter>
 void PacketBuffer::appendData(const Iter &begin, const Iter &end)
 {
-  std::copy(begin, end, std::back_inserter(_packet_buffer));
+  const auto byte_count = static_cast<size_t>(std::distance(begin, end));
+  reserveWrite(byte_count);
+  std::copy(begin, end, _packet_buffer.data() + _write_offset);
+  _write_offset += byte_count;
 }
 
 
 void PacketBuffer::removeData(size_t remove_byte_count)
 {
-  if (remove_byte_count < _packet_buffer.size())
+  _read_offset += remove_byte_count;
+  if (_read_offset >= _write_offset)
   {
-    const size_t new_size = _packet_buffer.size() - remove_byte_count;
-    std::copy(_packet_buffer.begin() + static_cast<ssize_t>(remove_byte_count),
-              _packet_buffer.end(), _packet_buffer.begin());
-    _packet_buffer.resize(new_size);
+    _read_offset = _write_offset = 0;
   }
-  else
+}
+
+
+void PacketBuffer::reserveWrite(size_t byte_count)
+{
+  if (_packet_buffer.size() - _write_offset >= byte_count)
+  {
+    return;
+  }
+
+  // Move the pending data to the front before growing.
+  if (_read_offset > 0)
+  {
+    std::memmove(_packet_buffer.data(), _packet_buffer.data() + _read_offset, pendingBytes());
+    _write_offset -= _read_offset;
+    _read_offset = 0;
+  }
+
+  if (_packet_buffer.size() - _write_offset < byte_count)
   {
-    _packet_buffer.resize(0);
+    // Grow geometrically to amortise growth over small writes.
+    _packet_buffer.resize(std::max(_write_offset + byte_count, 2u * _packet_buffer.size()));
   }
 }
 }  // namespace tes
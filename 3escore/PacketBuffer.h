@@ -5,6 +5,8 @@
 
 #include "CoreConfig.h"
 
+#include "PacketStream.h"
+
 #include <array>
 #include <cinttypes>
 #include <vector>
@@ -18,6 +20,12 @@ struct PacketHeader;
 /// Data is buffered until full packets have arrived, which must be extracted using
 /// @c extractPacket().
 ///
+/// Data may be copied in using @c addBytes() or read directly into the buffer by requesting write
+/// space with @c writeBuffer() , then calling @c commitBytes() with the number of bytes written.
+/// The latter supports reading large blocks from a socket without an intermediate copy. Extracted
+/// packets are released by advancing a read cursor, with the remaining data only moved to the
+/// front of the buffer when more write space is needed.
+///
 /// @note @c PacketStreamReader is recommended over using @c PacketBuffer.
 ///
 /// @todo Deprecate this class in favour of @c PacketStreamReader.
@@ -54,6 +62,34 @@ public:
   /// @overload
   int addBytes(const std::vector<uint8_t> &bytes) { return addBytes(bytes.data(), bytes.size()); }
 
+  /// Request space to write @p byte_count bytes directly into the buffer.
+  ///
+  /// The returned pointer is valid until the next call to any non-const function. Written bytes
+  /// must be accepted by calling @c commitBytes() and are otherwise ignored.
+  /// @param byte_count The number of bytes to make available.
+  /// @return A pointer to at least @p byte_count writable bytes.
+  uint8_t *writeBuffer(size_t byte_count);
+
+  /// Accept @p byte_count bytes written to the address returned by @c writeBuffer() .
+  ///
+  /// Bytes are rejected as for @c addBytes() .
+  /// @param byte_count The number of bytes written. Must not exceed the size requested from
+  ///   @c writeBuffer() .
+  /// @return the index of the first accepted byte or -1 if all are rejected.
+  int commitBytes(size_t byte_count);
+
+  /// Set the largest @c PFExtended payload size accepted by @c extractPacket() . Packets claiming a
+  /// larger payload are treated as corrupt. Defaults to @c kDefaultMaxExtendedPayloadSize .
+  /// @param max_payload_size The maximum extended payload size (bytes).
+  void setMaxPayloadSize(uint32_t max_payload_size) { _max_payload_size = max_payload_size; }
+  /// Query the largest @c PFExtended payload size accepted. See @c setMaxPayloadSize() .
+  /// @return The maximum extended payload size (bytes).
+  [[nodiscard]] uint32_t maxPayloadSize() const { return _max_payload_size; }
+
+  /// Query the number of bytes buffered and pending extraction.
+  /// @return The number of buffered bytes.
+  [[nodiscard]] size_t pendingBytes() const { return _write_offset - _read_offset; }
+
   /// Extract the first valid packet in the buffer. Additional packets may be left available.
   ///
   /// The packet is extracted into the @p buffer, which is used to avoid memory allocation on each
@@ -61,6 +97,9 @@ public:
   /// entire packet, then the packet is copied into the @p buffer. The return value is the same
   /// address as @p buffer.data(), but converted to the @c PacketHeader type.
   ///
+  /// Packets with a corrupt header, an invalid @c PacketHeader::payload_offset or an extended
+  /// payload larger than @c maxPayloadSize() , are skipped by searching for the next packet marker.
+  ///
   /// @param buffer A byte array to copy the packet into.
   /// @return A valid packet pointer if available, null if none available.
   PacketHeader *extractPacket(std::vector<uint8_t> &buffer);
@@ -72,12 +111,37 @@ private:
   template <typename Iter>
   void appendData(const Iter &begin, const Iter &end);
 
+  /// Resolve the marker state after appending @p byte_count bytes to the pending data.
+  /// @param byte_count The number of bytes appended.
+  /// @return the index of the first accepted byte of the new data or -1 if all are rejected.
+  int acceptBytes(size_t byte_count);
+
+  /// Search the pending data for a packet marker, discarding data before the marker. When no marker
+  /// is found, only the trailing bytes which may be the start of a marker are retained.
+  /// @return The number of bytes discarded before the marker or -1 if there is no marker.
+  int findMarker();
+
+  /// Skip the packet marker at the start of the pending data, then search for the next marker.
+  void skipMarker();
+
   /// Remove the first @p byte_count bytes from the packet buffer.
   /// @param remove_byte_count The number of bytes to remove from the buffer.
   void removeData(size_t remove_byte_count);
 
+  /// Ensure there are at least @p byte_count bytes available to write at @c _write_offset ,
+  /// moving pending data to the front of the buffer first, if required.
+  /// @param byte_count The required write space.
+  void reserveWrite(size_t byte_count);
+
   std::vector<uint8_t> _packet_buffer;  ///< Buffers incoming packet data.
-  /// Indicates that @c _packet_buffer has valid packet marker byte sequence at position zero.
+  /// Offset to the first pending byte in @c _packet_buffer .
+  size_t _read_offset = 0;
+  /// Offset to the end of the pending bytes in @c _packet_buffer .
+  size_t _write_offset = 0;
+  /// Indicates that @c _packet_buffer has valid packet marker byte sequence at @c _read_offset .
+  /// When false, the pending bytes are at most a partial marker.
   bool _marker_found = false;
+  /// The largest extended payload size accepted.
+  uint32_t _max_payload_size = kDefaultMaxExtendedPayloadSize;
 };
 }  // namespace tes
@@ -5,11 +5,25 @@
 
 #include "Endian.h"
 
+#include <utility>
+
 namespace tes
 {
 const uint32_t kPacketMarker = 0x03e55e30u;
 const uint16_t kPacketVersionMajor = 0u;
 const uint16_t kPacketVersionMinor = 4u;
+const uint16_t kPacketExtendedVersionMinor = 5u;
 const uint16_t kPacketCompatibilityVersionMajor = 0u;
 const uint16_t kPacketCompatibilityVersionMinor = 3u;
+
+
+bool packetVersionCompatible(uint16_t version_major, uint16_t version_minor)
+{
+  // Compare versions lexicographically against the supported range. Checking the major and minor
+  // versions separately would accept any minor version while the major versions match.
+  const auto version = std::make_pair(version_major, version_minor);
+  return std::make_pair(kPacketCompatibilityVersionMajor, kPacketCompatibilityVersionMinor) <=
+           version &&
+         version <= std::make_pair(kPacketVersionMajor, kPacketExtendedVersionMinor);
+}
 }  // namespace tes
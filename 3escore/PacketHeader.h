@@ -14,7 +14,15 @@ extern const uint32_t TES_CORE_API kPacketMarker;
 /// Packet encoding major version local Endian.
 extern const uint16_t TES_CORE_API kPacketVersionMajor;
 /// Packet encoding minor version local Endian.
+///
+/// This is the version written for packets without @c PFExtended , so streams which do not use
+/// extended packets remain readable by older clients.
 extern const uint16_t TES_CORE_API kPacketVersionMinor;
+/// Packet encoding minor version for @c PFExtended packets, local Endian.
+///
+/// Also written to the server info message of a server which may send extended packets. This is
+/// the latest supported minor version.
+extern const uint16_t TES_CORE_API kPacketExtendedVersionMinor;
 
 /// Packet decoding major compatibility version local Endian.
 ///
@@ -25,18 +33,30 @@ extern const uint16_t TES_CORE_API kPacketCompatibilityVersionMajor;
 /// This is the minimum supported version number.
 extern const uint16_t TES_CORE_API kPacketCompatibilityVersionMinor;
 
+/// Check if packets of the given version can be decoded. This accepts versions from
+/// @c kPacketCompatibilityVersionMajor.kPacketCompatibilityVersionMinor up to
+/// @c kPacketVersionMajor.kPacketExtendedVersionMinor .
+/// @param version_major The packet major version, local Endian.
+/// @param version_minor The packet minor version, local Endian.
+/// @return True if the version is supported.
+bool TES_CORE_API packetVersionCompatible(uint16_t version_major, uint16_t version_minor);
+
 /// Flag values for @c PacketHeader objects.
 enum PacketFlag : uint8_t
 {
   PFZero = 0u,
   /// Marks a @c PacketHeader as missing its 16-bit CRC.
   PFNoCrc = (1u << 0u),
+  /// Marks an extended @c PacketHeader with a 32-bit payload size. The size is written in the
+  /// @c uint32_t immediately following the header, @c PacketHeader::payload_offset is 4 and
+  /// @c PacketHeader::payload_size is zero. Supported from packet version 0.5.
+  PFExtended = (1u << 1u),
   // /// Indicates that the platform which wrote this data was big endian. In most cases this is
   // /// irrelevant as data items are generally written to big endian format. However, in some cases
   // /// the write operation may not be able to change to network endian form, in which case this
   // flag
   // /// indicates the source data endian format.
-  // PF_PlatformBigEndian = (1u << 1u),
+  // PF_PlatformBigEndian = (1u << 2u),
 };
 
 /// The header for an incoming 3ES data packet. All packet data, including payload bytes, must be in
@@ -50,12 +70,12 @@ enum PacketFlag : uint8_t
 /// @note The @c payload_size bit width limit was chosen to keep the header size small. Initially
 /// there were also some issues with the initial socket implementation causing some data loss due
 /// to undersized buffers. The payload size can't be changed without invalidating the header format,
-/// invalidating any previously captured data. However, a @c PacketFlag could be used to incidate
-/// that a 4-byte payload size followes the @c PacketHeader . This change is reserved for future
-/// implementation if need be. In particular larger packets may support better compression for
-/// @c CollatedPacket .
+/// invalidating any previously captured data. Instead, the @c PFExtended flag marks a packet with
+/// a 4-byte payload size following the @c PacketHeader , with the payload following that. The
+/// CRC covers the header, the extended size and the payload. Extended packets are intended for
+/// bulk data such as resource transfers; small messages continue to use the compact form.
 ///
-/// @see The upper limit for the combined size of a packet is defined by
+/// @see The upper limit for the combined size of a non-extended packet is defined by
 /// @c tes::kMaxPacketSize defined in @c PacketStream.h
 struct TES_CORE_API PacketHeader
 {
@@ -67,7 +87,8 @@ struct TES_CORE_API PacketHeader
   /// Identifies the message ID or message type.
   uint16_t message_id;
   uint16_t payload_size;  ///< Size of the payload following this header.
-  /// Offset from the end of this header to the payload.
+  /// Offset from the end of this header to the payload. Holds the size of the extended payload
+  /// size field with @c PFExtended .
   uint8_t payload_offset;
   /// @c PacketFlag values.
   uint8_t flags;
@@ -65,7 +65,8 @@ bool PacketReader::checkCrc()
 PacketReader::CrcType PacketReader::calculateCrc() const
 {
   const CrcType crc_val =
-    crc16(reinterpret_cast<const uint8_t *>(_packet), sizeof(PacketHeader) + payloadSize());
+    crc16(reinterpret_cast<const uint8_t *>(_packet),
+          sizeof(PacketHeader) + payloadOffset() + payloadSize());
   return crc_val;
 }
 
@@ -76,7 +77,7 @@ size_t PacketReader::readElement(uint8_t *bytes, size_t element_size)
   {
     std::memcpy(bytes, payload() + _payload_position, element_size);
     networkEndianSwap(bytes, element_size);
-    _payload_position = static_cast<uint16_t>(_payload_position + element_size);
+    _payload_position = static_cast<uint32_t>(_payload_position + element_size);
     return element_size;
   }
 
@@ -98,7 +99,7 @@ size_t PacketReader::readArray(uint8_t *bytes, size_t element_size, size_t eleme
       networkEndianSwap(fix_bytes, element_size);
     }
 #endif  // !TES_IS_NETWORK_ENDIAN
-    _payload_position = static_cast<uint16_t>(_payload_position + element_size * copy_count);
+    _payload_position = static_cast<uint32_t>(_payload_position + element_size * copy_count);
     return copy_count;
   }
 
@@ -110,7 +111,7 @@ size_t PacketReader::readRaw(uint8_t *bytes, size_t byte_count)
 {
   const size_t copy_count = (byte_count <= bytesAvailable()) ? byte_count : bytesAvailable();
   std::memcpy(bytes, payload() + _payload_position, copy_count);
-  _payload_position = static_cast<uint16_t>(_payload_position + copy_count);
+  _payload_position = static_cast<uint32_t>(_payload_position + copy_count);
   return copy_count;
 }
 
@@ -9,6 +9,7 @@
 #include "Enum.h"
 #include "PacketHeader.h"
 
+#include <cstring>
 #include <limits>
 #include <utility>
 
@@ -17,13 +18,20 @@ namespace tes
 /// Defies the packet CRC type.
 using CrcType = uint16_t;
 
-/// Defines the upper limit for the size of any one 3es packet.
+/// Defines the upper limit for the size of any one 3es packet, excluding @c PFExtended packets.
 ///
 /// This is calculated as the size of the packet plus the payload (determined by
 /// @c PacketHeader::payload_size ) plus the @c CrcType size.
 constexpr size_t kMaxPacketSize = std::numeric_limits<decltype(PacketHeader::payload_size)>::max() +
                                   sizeof(PacketHeader) + sizeof(CrcType);
 
+/// The size of the payload size field following the @c PacketHeader for @c PFExtended packets.
+constexpr size_t kExtendedPayloadSizeBytes = sizeof(uint32_t);
+
+/// The default upper limit for the payload size of a @c PFExtended packet accepted when reading a
+/// packet stream. Larger sizes are treated as corrupt data rather than allocated.
+constexpr uint32_t kDefaultMaxExtendedPayloadSize = 64u * 1024u * 1024u;
+
 // Casting and pointer arithmetic are fundamental the the PacketStream.
 // clang-format off
 // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic)
@@ -94,18 +102,52 @@ public:
   {
     return networkEndianSwapValue(_packet->version_minor);
   }
-  /// Fetch the payload size bytes in local endian.
+  /// Fetch the payload size in local endian. This is read from the extended payload size field
+  /// for @c PFExtended packets.
   /// @return The @c PacketHeader::payloadSize bytes.
-  [[nodiscard]] uint16_t payloadSize() const
+  [[nodiscard]] uint32_t payloadSize() const
   {
+    if (isExtended())
+    {
+      uint32_t payload_size = 0;
+      std::memcpy(&payload_size, reinterpret_cast<const uint8_t *>(_packet) + sizeof(Header),
+                  sizeof(payload_size));
+      return networkEndianSwapValue(payload_size);
+    }
     return networkEndianSwapValue(_packet->payload_size);
   }
+  /// Fetch the byte offset from the end of the header to the payload.
+  /// @return The @c PacketHeader::payload_offset value.
+  [[nodiscard]] uint8_t payloadOffset() const { return _packet->payload_offset; }
+  /// Is this an extended packet with a 32-bit payload size? See @c PFExtended .
+  /// @return True if the @c PFExtended flag is set.
+  [[nodiscard]] bool isExtended() const { return (_packet->flags & PFExtended) != 0; }
+  /// Check the @c payloadOffset() matches the packet format: zero, or @c kExtendedPayloadSizeBytes
+  /// for @c PFExtended packets. Other values indicate a corrupt header.
+  /// @return True if the payload offset is valid.
+  [[nodiscard]] bool validPayloadOffset() const
+  {
+    return payloadOffset() == (isExtended() ? kExtendedPayloadSizeBytes : 0u);
+  }
+  /// Check the @c payloadSize() does not exceed @p max_extended_payload_size for @c PFExtended
+  /// packets. Non-extended packets are always within the limit.
+  ///
+  /// As with @c packetSize() , the extended payload size must be available to make this call.
+  /// @param max_extended_payload_size The largest extended payload size to accept.
+  /// @return True if the payload size is acceptable.
+  [[nodiscard]] bool validPayloadSize(uint32_t max_extended_payload_size) const
+  {
+    return !isExtended() || payloadSize() <= max_extended_payload_size;
+  }
   /// Returns the size of the packet plus payload, giving the full data packet size including the
   /// CRC.
+  ///
+  /// For @c PFExtended packets, at least `sizeof(PacketHeader) + payloadOffset()` bytes must be
+  /// available to make this call.
   /// @return PacketHeader data size (bytes).
-  [[nodiscard]] uint16_t packetSize() const
+  [[nodiscard]] uint32_t packetSize() const
   {
-    return static_cast<uint16_t>(sizeof(Header) + payloadSize() +
+    return static_cast<uint32_t>(sizeof(Header) + payloadOffset() + payloadSize() +
                                  (((packet().flags & PFNoCrc) == 0) ? sizeof(CrcType) : 0));
   }
   /// Fetch the routing ID bytes in local endian.
@@ -128,7 +170,8 @@ public:
   [[nodiscard]] CrcType *crcPtr()
   {
     // CRC appears after the payload.
-    uint8_t *pos = reinterpret_cast<uint8_t *>(_packet) + sizeof(Header) + payloadSize();
+    uint8_t *pos =
+      reinterpret_cast<uint8_t *>(_packet) + sizeof(Header) + payloadOffset() + payloadSize();
     return reinterpret_cast<CrcType *>(pos);
   }
   /// @overload
@@ -167,7 +210,7 @@ public:
 
   /// Tell the current stream position.
   /// @return The current position.
-  [[nodiscard]] uint16_t tell() const;
+  [[nodiscard]] uint32_t tell() const;
   /// Seek to the indicated position.
   /// @param offset Seek offset from @p pos.
   /// @param pos The seek reference position.
@@ -190,7 +233,7 @@ protected:
   // NOLINTBEGIN(cppcoreguidelines-non-private-member-variables-in-classes)
   Header *_packet = nullptr;                  ///< Packet header and buffer start address.
   PacketStatus _status = PacketStatus::Zero;  ///< @c Status bits.
-  uint16_t _payload_position = 0u;            ///< Payload cursor.
+  uint32_t _payload_position = 0u;            ///< Payload cursor.
   // NOLINTEND(cppcoreguidelines-non-private-member-variables-in-classes)
 
   /// Type traits: is @c T const?
@@ -230,7 +273,7 @@ template <class Header>
 PacketStream<Header>::PacketStream(PacketStream<Header> &&other) noexcept
   : _packet(std::exchange(other._packet, nullptr))
   , _status(std::exchange(other._status, PacketStatus::Zero))
-  , _payload_position(std::exchange(_payload_position, 0u))
+  , _payload_position(std::exchange(other._payload_position, 0u))
 {}
 
 
@@ -249,26 +292,26 @@ bool PacketStream<Header>::seek(int offset, SeekPos pos)
   switch (pos)
   {
   case SeekPos::Begin:
-    if (offset <= payloadSize())
+    if (offset >= 0 && static_cast<uint32_t>(offset) <= payloadSize())
     {
-      _payload_position = static_cast<uint16_t>(offset);
+      _payload_position = static_cast<uint32_t>(offset);
       return true;
     }
     break;
 
   case SeekPos::Current:
-    if (offset >= 0 && offset + _payload_position <= payloadSize() ||
-        offset < 0 && _payload_position >= -offset)
+    if (offset >= 0 && offset + int64_t(_payload_position) <= payloadSize() ||
+        offset < 0 && int64_t(_payload_position) >= -int64_t(offset))
     {
-      _payload_position = static_cast<uint16_t>(_payload_position + offset);
+      _payload_position = static_cast<uint32_t>(int64_t(_payload_position) + offset);
       return true;
     }
     break;
 
   case SeekPos::End:
-    if (offset < payloadSize())
+    if (offset >= 0 && static_cast<uint32_t>(offset) < payloadSize())
     {
-      _payload_position = static_cast<uint16_t>(_packet->payload_size - 1 - offset);
+      _payload_position = payloadSize() - 1u - static_cast<uint32_t>(offset);
       return true;
     }
     break;
@@ -285,7 +328,8 @@ template <class Header>
 const typename PacketStream<Header>::CrcType *PacketStream<Header>::crcPtr() const
 {
   // CRC appears after the payload.
-  const uint8_t *pos = reinterpret_cast<const uint8_t *>(_packet) + sizeof(Header) + payloadSize();
+  const uint8_t *pos =
+    reinterpret_cast<const uint8_t *>(_packet) + sizeof(Header) + payloadOffset() + payloadSize();
   return reinterpret_cast<const CrcType *>(pos);
 }
 
@@ -303,7 +347,7 @@ inline Header &PacketStream<Header>::packet() const
 }
 
 template <class Header>
-inline uint16_t PacketStream<Header>::tell() const
+inline uint32_t PacketStream<Header>::tell() const
 {
   return _payload_position;
 }
@@ -311,7 +355,7 @@ inline uint16_t PacketStream<Header>::tell() const
 template <class Header>
 inline const uint8_t *PacketStream<Header>::payload() const
 {
-  return reinterpret_cast<const uint8_t *>(_packet) + sizeof(Header);
+  return reinterpret_cast<const uint8_t *>(_packet) + sizeof(Header) + payloadOffset();
 }
 
 
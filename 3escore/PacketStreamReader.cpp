@@ -70,9 +70,9 @@ PacketStreamReader::ExtractedPacket PacketStreamReader::extractPacket()
   }
 
   // Scan for the buffer start.
+  Status status = Status::Success;
   for (size_t i = 0; i < _buffer.size(); ++i)
   {
-    Status status = Status::Success;
     if (checkMarker(_buffer, i))
     {
       // Marker found. Shift down to comsume trash at the start of the buffer.
@@ -82,6 +82,7 @@ PacketStreamReader::ExtractedPacket PacketStreamReader::extractPacket()
         _buffer.resize(_buffer.size() - i);
         status = Status::Dropped;
         _current_packet_pos += i;
+        i = 0;
       }
 
       if (_buffer.size() < sizeof(PacketHeader))
@@ -94,8 +95,36 @@ PacketStreamReader::ExtractedPacket PacketStreamReader::extractPacket()
         }
       }
 
+      // Validate the header before reading the extended payload size it may specify.
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      if (!PacketReader(reinterpret_cast<const PacketHeader *>(_buffer.data()))
+             .validPayloadOffset())
+      {
+        // Corrupt header. Resync on the next marker.
+        continue;
+      }
+
+      // Extended packets need the payload size following the header.
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      const auto *header = reinterpret_cast<const PacketHeader *>(_buffer.data());
+      const size_t header_size = sizeof(PacketHeader) + header->payload_offset;
+      if (_buffer.size() < header_size)
+      {
+        readMore(header_size - _buffer.size());
+        if (_buffer.size() < header_size)
+        {
+          return { nullptr, Status::Incomplete, 0 };
+        }
+      }
+
       // Check the packet size and work out how much more to read.
       const auto target_size = calcExpectedSize();
+      if (target_size == 0)
+      {
+        // The extended payload size is over the limit. Resync on the next marker.
+        continue;
+      }
+
       // Read the full payload.
       if (_buffer.size() < target_size)
       {
@@ -121,6 +150,9 @@ PacketStreamReader::ExtractedPacket PacketStreamReader::extractPacket()
     }
   }
 
+  // There is no marker in the buffered data, so drop it and read on from the next call.
+  _current_packet_pos += static_cast<ssize_t>(_buffer.size());
+  _buffer.clear();
   return { nullptr, Status::Unavailable, 0 };
 }
 
@@ -191,7 +223,7 @@ void PacketStreamReader::consume()
   }
 
   const auto target_size = calcExpectedSize();
-  if (_buffer.size() >= target_size)
+  if (target_size > 0 && _buffer.size() >= target_size)
   {
     // Update cursor.
     _current_packet_pos += static_cast<ssize_t>(target_size);
@@ -206,11 +238,17 @@ size_t PacketStreamReader::calcExpectedSize()
 {
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
   const auto *header = reinterpret_cast<const PacketHeader *>(_buffer.data());
-  auto payload_size = networkEndianSwapValue(header->payload_size);
-  if ((networkEndianSwapValue(header->flags) & PFNoCrc) == 0)
+  const PacketReader reader(header);
+  if (!reader.validPayloadOffset() ||
+      _buffer.size() < sizeof(PacketHeader) + reader.payloadOffset())
   {
-    payload_size += sizeof(PacketReader::CrcType);
+    // Corrupt header or extended payload size not yet available.
+    return 0;
+  }
+  if (!reader.validPayloadSize(_max_payload_size))
+  {
+    return 0;
   }
-  return sizeof(PacketHeader) + payload_size;
+  return reader.packetSize();
 }
 }  // namespace tes
@@ -6,6 +6,7 @@
 #include "CoreConfig.h"
 
 #include "PacketHeader.h"
+#include "PacketStream.h"
 
 #include <array>
 #include <cinttypes>
@@ -97,9 +98,20 @@ public:
   /// Note there is no version check on the packet. The caller should check the
   /// packet version for compatibility.
   ///
+  /// Packets with an invalid @c PacketHeader::payload_offset or an extended payload larger than
+  /// @c maxPayloadSize() are skipped as corrupt, reporting @c Status::Dropped .
+  ///
   /// @return The next packet or null on failure and a @c Status code.
   ExtractedPacket extractPacket();
 
+  /// Set the largest @c PFExtended payload size accepted by @c extractPacket() . Packets claiming a
+  /// larger payload are treated as corrupt. Defaults to @c kDefaultMaxExtendedPayloadSize .
+  /// @param max_payload_size The maximum extended payload size (bytes).
+  void setMaxPayloadSize(uint32_t max_payload_size) { _max_payload_size = max_payload_size; }
+  /// Query the largest @c PFExtended payload size accepted. See @c setMaxPayloadSize() .
+  /// @return The maximum extended payload size (bytes).
+  [[nodiscard]] uint32_t maxPayloadSize() const { return _max_payload_size; }
+
   /// Seek to the given stream position.
   ///
   /// This clears the current data buffer, invalidating results from @c extractPacket().
@@ -118,7 +130,9 @@ private:
   /// Calculate the expected packet size for the packet at the head of the buffer.
   ///
   /// Only valid to call when we have a verified header at the _buffer start.
-  /// @return The expected packet size including payload as indicated by the packet header.
+  /// @return The expected packet size including payload as indicated by the packet header, or zero
+  ///   when the extended payload size of a @c PFExtended packet has yet to be read or the header
+  ///   is corrupt.
   size_t calcExpectedSize();
 
   std::istream *_stream = nullptr;
@@ -126,5 +140,6 @@ private:
   std::vector<uint8_t> _buffer;
   size_t _chunk_size = 1024u;
   std::istream::pos_type _current_packet_pos = {};
+  uint32_t _max_payload_size = kDefaultMaxExtendedPayloadSize;
 };
 }  // namespace tes
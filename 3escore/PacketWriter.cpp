@@ -6,7 +6,9 @@
 #include "Crc.h"
 #include "Endian.h"
 
+#include <algorithm>
 #include <cstring>
+#include <limits>
 #include <utility>
 
 // Casting and pointer arithmetic are fundamental the the PacketStream.
@@ -21,9 +23,9 @@ PacketWriter::PacketWriter(PacketHeader *packet, uint16_t max_payload_size, uint
   : PacketStream<PacketHeader>(packet)
   , _buffer_size(max_payload_size + sizeof(PacketHeader))
 {
-  _packet->marker = kPacketMarker;
-  _packet->version_major = kPacketVersionMajor;
-  _packet->version_minor = kPacketVersionMinor;
+  _packet->marker = networkEndianSwapValue(kPacketMarker);
+  _packet->version_major = networkEndianSwapValue(kPacketVersionMajor);
+  _packet->version_minor = networkEndianSwapValue(kPacketVersionMinor);
   _packet->routing_id = networkEndianSwapValue(routing_id);
   _packet->message_id = networkEndianSwapValue(message_id);
   _packet->payload_size = 0u;
@@ -60,6 +62,7 @@ PacketWriter::PacketWriter(uint8_t *buffer, size_t buffer_size, uint16_t routing
 PacketWriter::PacketWriter(const PacketWriter &other)
   : PacketStream<PacketHeader>(reinterpret_cast<PacketHeader *>(other._packet))
   , _buffer_size(other._buffer_size)
+  , _extended(other._extended)
 {
   _status = other._status;
   _payload_position = other._payload_position;
@@ -73,6 +76,7 @@ PacketWriter::PacketWriter(PacketWriter &&other) noexcept
   _status = std::exchange(other._status, PacketStatus::Zero);
   _payload_position = std::exchange(other._payload_position, 0);
   _buffer_size = std::exchange(other._buffer_size, 0);
+  _extended = std::exchange(other._extended, false);
 }
 
 
@@ -82,6 +86,7 @@ PacketWriter &PacketWriter::operator=(const PacketWriter &other)
   _status = other._status;
   _payload_position = other._payload_position;
   _buffer_size = other._buffer_size;
+  _extended = other._extended;
   return *this;
 }
 
@@ -99,6 +104,7 @@ void PacketWriter::swap(PacketWriter &other) noexcept
   std::swap(_status, other._status);
   std::swap(_payload_position, other._payload_position);
   std::swap(_buffer_size, other._buffer_size);
+  std::swap(_extended, other._extended);
 }
 
 
@@ -109,11 +115,10 @@ void PacketWriter::reset(uint16_t routing_id, uint16_t message_id)
   {
     _packet->routing_id = networkEndianSwapValue(routing_id);
     _packet->message_id = networkEndianSwapValue(message_id);
-    _packet->payload_size = 0u;
-    _packet->payload_offset = 0u;
     // Flag no CRC if there's no room.
     _packet->flags = (_buffer_size >= sizeof(PacketHeader) + sizeof(CrcType)) ? PFZero : PFNoCrc;
     _payload_position = 0;
+    initPayloadSize();
   }
   else
   {
@@ -122,15 +127,42 @@ void PacketWriter::reset(uint16_t routing_id, uint16_t message_id)
 }
 
 
-uint16_t PacketWriter::bytesRemaining() const
+bool PacketWriter::setExtended(bool extended)
 {
-  return static_cast<uint16_t>(maxPayloadSize() - payloadSize());
+  if (isFail() || _payload_position > 0 || payloadSize() > 0)
+  {
+    return false;
+  }
+
+  if (extended && _buffer_size < sizeof(PacketHeader) + kExtendedPayloadSizeBytes)
+  {
+    return false;
+  }
+
+  _extended = extended;
+  initPayloadSize();
+  return true;
 }
 
 
-uint16_t PacketWriter::maxPayloadSize() const
+uint32_t PacketWriter::bytesRemaining() const
 {
-  return (!isFail()) ? static_cast<uint16_t>(_buffer_size - sizeof(PacketHeader)) : 0u;
+  return maxPayloadSize() - payloadSize();
+}
+
+
+uint32_t PacketWriter::maxPayloadSize() const
+{
+  if (isFail())
+  {
+    return 0u;
+  }
+
+  const size_t max_payload = _buffer_size - sizeof(PacketHeader) - payloadOffset();
+  using PayloadSizeType = decltype(PacketHeader::payload_size);
+  const size_t limit = (isExtended()) ? std::numeric_limits<uint32_t>::max() :
+                                        std::numeric_limits<PayloadSizeType>::max();
+  return static_cast<uint32_t>(std::min(max_payload, limit));
 }
 
 
@@ -171,8 +203,8 @@ PacketWriter::CrcType PacketWriter::calculateCrc()
 
   CrcType *crc_pos = crcPtr();
   // Validate the CRC position for buffer overflow.
-  const auto crc_offset = static_cast<unsigned>(reinterpret_cast<uint8_t *>(crc_pos) -
-                                                reinterpret_cast<uint8_t *>(_packet));
+  const auto crc_offset = static_cast<size_t>(reinterpret_cast<uint8_t *>(crc_pos) -
+                                              reinterpret_cast<uint8_t *>(_packet));
   if (crc_offset > _buffer_size - sizeof(CrcType))
   {
     // CRC overruns the buffer. Cannot calculate.
@@ -180,8 +212,7 @@ PacketWriter::CrcType PacketWriter::calculateCrc()
     return 0;
   }
 
-  const CrcType crc_val =
-    crc16(reinterpret_cast<const uint8_t *>(_packet), sizeof(PacketHeader) + payloadSize());
+  const CrcType crc_val = crc16(reinterpret_cast<const uint8_t *>(_packet), crc_offset);
   *crc_pos = networkEndianSwapValue(crc_val);
   _status |= PacketStatus::CrcValid;
   return *crc_pos;
@@ -194,7 +225,7 @@ size_t PacketWriter::writeElement(const uint8_t *bytes, size_t element_size)
   {
     memcpy(payloadWritePtr(), bytes, element_size);
     networkEndianSwap(payloadWritePtr(), element_size);
-    _payload_position = static_cast<uint16_t>(_payload_position + element_size);
+    _payload_position = static_cast<uint32_t>(_payload_position + element_size);
     incrementPayloadSize(element_size);
     return element_size;
   }
@@ -218,7 +249,7 @@ size_t PacketWriter::writeArray(const uint8_t *bytes, size_t element_size, size_
     }
 #endif  // !TES_IS_NETWORK_ENDIAN
     incrementPayloadSize(element_size * copy_count);
-    _payload_position = static_cast<uint16_t>(_payload_position + element_size * copy_count);
+    _payload_position = static_cast<uint32_t>(_payload_position + element_size * copy_count);
     return copy_count;
   }
 
@@ -231,15 +262,61 @@ size_t PacketWriter::writeRaw(const uint8_t *bytes, size_t byte_count)
   const size_t copy_count = (byte_count <= bytesRemaining()) ? byte_count : bytesRemaining();
   memcpy(payloadWritePtr(), bytes, copy_count);
   incrementPayloadSize(copy_count);
-  _payload_position = static_cast<uint16_t>(_payload_position + copy_count);
+  _payload_position = static_cast<uint32_t>(_payload_position + copy_count);
   return copy_count;
 }
 
 
+void PacketWriter::setVersion(uint16_t major, uint16_t minor)
+{
+  if (!isFail())
+  {
+    _packet->version_major = networkEndianSwapValue(major);
+    _packet->version_minor = networkEndianSwapValue(minor);
+    invalidateCrc();
+  }
+}
+
+
+void PacketWriter::initPayloadSize()
+{
+  _packet->payload_size = 0u;
+  // Only extended packets need the newer version, keeping other packets readable by old clients.
+  _packet->version_major = networkEndianSwapValue(kPacketVersionMajor);
+  _packet->version_minor =
+    networkEndianSwapValue((_extended) ? kPacketExtendedVersionMinor : kPacketVersionMinor);
+  if (_extended)
+  {
+    // The extended payload size follows the header.
+    const uint32_t payload_size = 0u;
+    std::memcpy(reinterpret_cast<uint8_t *>(_packet) + sizeof(PacketHeader), &payload_size,
+                sizeof(payload_size));
+    _packet->payload_offset = static_cast<uint8_t>(kExtendedPayloadSizeBytes);
+    _packet->flags = static_cast<uint8_t>(_packet->flags | PFExtended);
+  }
+  else
+  {
+    _packet->payload_offset = 0u;
+    _packet->flags = static_cast<uint8_t>(_packet->flags & ~PFExtended);
+  }
+  invalidateCrc();
+}
+
+
 void PacketWriter::incrementPayloadSize(size_t inc)
 {
-  _packet->payload_size = static_cast<uint16_t>(payloadSize() + inc);
-  networkEndianSwap(_packet->payload_size);
+  if (_extended)
+  {
+    const uint32_t payload_size =
+      networkEndianSwapValue(static_cast<uint32_t>(payloadSize() + inc));
+    std::memcpy(reinterpret_cast<uint8_t *>(_packet) + sizeof(PacketHeader), &payload_size,
+                sizeof(payload_size));
+  }
+  else
+  {
+    _packet->payload_size = static_cast<uint16_t>(payloadSize() + inc);
+    networkEndianSwap(_packet->payload_size);
+  }
   invalidateCrc();
 }
 }  // namespace tes
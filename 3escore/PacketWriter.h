@@ -32,9 +32,8 @@ namespace tes
 /// The buffer size must be large enough for the @ PacketHeader. Remaining space is available
 /// for the payload.
 ///
-/// @bug Use the payloadOffset in various calculations herein. It was added after this
-/// class was written, but is currently only supported as being zero, so it's not an issue
-/// yet.
+/// The payload is limited to 0xffff bytes unless @c setExtended() is used to select the
+/// @c PFExtended packet format. This allows the payload to use the whole buffer.
 class TES_CORE_API PacketWriter : public PacketStream<PacketHeader>
 {
 public:
@@ -101,6 +100,26 @@ public:
   /// @overload
   inline void reset() { reset(0, 0); }
 
+  /// Select the @c PFExtended packet format, supporting payloads larger than 0xffff bytes.
+  ///
+  /// This must be set before writing any payload and persists across @c reset() calls. Extended
+  /// packets must only be sent to clients which support packet version 0.5 or later.
+  ///
+  /// @param extended True to write extended packets.
+  /// @return True on success, false if payload has already been written or the buffer is too small
+  ///   for the extended payload size.
+  bool setExtended(bool extended);
+
+  /// Override the packet version written to the header until the next @c reset() .
+  ///
+  /// The version is otherwise @c kPacketVersionMinor , or @c kPacketExtendedVersionMinor for
+  /// extended packets. This is used to mark the server info message of a server which may send
+  /// extended packets.
+  ///
+  /// @param major The major version number.
+  /// @param minor The minor version number.
+  void setVersion(uint16_t major, uint16_t minor);
+
   void setRoutingId(uint16_t routing_id);
   [[nodiscard]] PacketHeader &packet() const;
 
@@ -113,12 +132,12 @@ public:
   /// Returns the number of bytes remaining available in the payload.
   /// This is calculated as the @c maxPayloadSize() - @c payloadSize().
   /// @return Number of bytes remaining available for write.
-  [[nodiscard]] uint16_t bytesRemaining() const;
+  [[nodiscard]] uint32_t bytesRemaining() const;
 
   /// Returns the size of the payload buffer. This is the maximum number of bytes
-  /// which can be written to the payload.
+  /// which can be written to the payload, limited to 0xffff unless @c isExtended() .
   /// @return The payload buffer size (bytes).
-  [[nodiscard]] uint16_t maxPayloadSize() const;
+  [[nodiscard]] uint32_t maxPayloadSize() const;
 
   /// Finalises the packet for sending, calculating the CRC.
   ///
@@ -193,9 +212,11 @@ public:
 
 private:
   uint8_t *payloadWritePtr();
+  void initPayloadSize();
   void incrementPayloadSize(size_t inc);
 
   size_t _buffer_size = 0;
+  bool _extended = false;
 };
 
 inline void PacketWriter::setRoutingId(uint16_t routing_id)
@@ -215,7 +236,7 @@ inline const uint8_t *PacketWriter::data() const
 
 inline uint8_t *PacketWriter::payload()
 {
-  return reinterpret_cast<uint8_t *>(_packet) + sizeof(PacketHeader);
+  return reinterpret_cast<uint8_t *>(_packet) + sizeof(PacketHeader) + payloadOffset();
 }
 
 template <typename T>
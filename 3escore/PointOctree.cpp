@@ -0,0 +1,332 @@
+//
+// author: Kazys Stepanas
+//
+#include "PointOctree.h"
+
+#include "Vector4.h"
+
+#include "shapes/MeshResource.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace tes
+{
+namespace
+{
+/// Number of points to process between abort checks.
+constexpr size_t kAbortCheckInterval = 1u << 20u;
+/// Minimum distance used when projecting node spacing, avoiding division by zero.
+constexpr float kMinDistance = 1e-3f;
+
+/// Spread the lower 10 bits of @p value to every third bit.
+uint32_t spreadBits(uint32_t value)
+{
+  value &= 0x3ffu;
+  value = (value | (value << 16u)) & 0x30000ffu;
+  value = (value | (value << 8u)) & 0x300f00fu;
+  value = (value | (value << 4u)) & 0x30c30c3u;
+  value = (value | (value << 2u)) & 0x9249249u;
+  return value;
+}
+
+/// Frustum planes extracted from a clip space transformation. Each plane is stored as the normal
+/// and distance (xyz, w) with the normal facing into the frustum. Planes are not normalised.
+class FrustumPlanes
+{
+public:
+  /// Extract the planes from @p clip , which transforms from the culling frame to clip space.
+  explicit FrustumPlanes(const Matrix4f &clip)
+  {
+    // Gribb/Hartmann: each plane is the last clip matrix row plus or minus another row.
+    const auto row = [&clip](size_t r) {
+      return Vector4f(clip(r, 0), clip(r, 1), clip(r, 2), clip(r, 3));
+    };
+    const Vector4f w_row = row(3);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      _planes[2 * i] = w_row + row(i);
+      _planes[2 * i + 1] = w_row - row(i);
+    }
+  }
+
+  /// Check if a box overlaps the frustum. This is conservative, so boxes near the frustum corners
+  /// may be reported as overlapping.
+  /// @param bounds The box to test.
+  /// @return False if the box is entirely outside any frustum plane.
+  [[nodiscard]] bool overlaps(const Boundsf &bounds) const
+  {
+    const auto centre = bounds.centre();
+    const auto half_extents = bounds.halfExtents();
+    for (const auto &plane : _planes)
+    {
+      // Distance of the box corner furthest along the plane normal.
+      const float distance = plane.x() * centre.x() + plane.y() * centre.y() +
+                             plane.z() * centre.z() + plane.w() +
+                             std::abs(plane.x()) * half_extents.x() +
+                             std::abs(plane.y()) * half_extents.y() +
+                             std::abs(plane.z()) * half_extents.z();
+      if (distance < 0)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  std::array<Vector4f, 6> _planes;
+};
+}  // namespace
+
+
+struct PointOctree::BuildContext
+{
+  DataBuffer vertices;
+  std::vector<Entry> entries;
+  /// Scratch space for extracting node samples.
+  std::vector<Entry> samples;
+  /// Edge length of the root cell.
+  float edge = 0;
+  unsigned capacity = kDefaultNodeCapacity;
+  const std::atomic_bool *abort = nullptr;
+
+  [[nodiscard]] bool aborted() const { return abort && *abort; }
+
+  [[nodiscard]] Vector3f position(uint32_t index) const
+  {
+    return { vertices.get<float>(index, 0), vertices.get<float>(index, 1),
+             vertices.get<float>(index, 2) };
+  }
+};
+
+
+bool PointOctree::build(const tes::MeshResource &resource, unsigned node_capacity,
+                        const std::atomic_bool *abort)
+{
+  _nodes.clear();
+  _order.clear();
+
+  BuildContext context;
+  context.vertices = resource.vertices();
+  context.capacity = std::max(node_capacity, 1u);
+  context.abort = abort;
+
+  const auto vertex_count = static_cast<uint32_t>(context.vertices.count());
+  if (vertex_count == 0 || context.vertices.componentCount() < 3)
+  {
+    return false;
+  }
+
+  // Resolve a cubic root cell.
+  Boundsf extents(context.position(0));
+  for (uint32_t i = 1; i < vertex_count; ++i)
+  {
+    extents.expand(context.position(i));
+  }
+  const auto size = extents.maximum() - extents.minimum();
+  context.edge =
+    std::max({ size.x(), size.y(), size.z(), std::numeric_limits<float>::epsilon() });
+
+  // Sort points by Morton key, which places every octree cell in a contiguous range.
+  constexpr uint32_t kCellLimit = (1u << kMaxDepth) - 1u;
+  const float to_cell = static_cast<float>(1u << kMaxDepth) / context.edge;
+  context.entries.resize(vertex_count);
+  for (uint32_t i = 0; i < vertex_count; ++i)
+  {
+    if (i % kAbortCheckInterval == 0 && context.aborted())
+    {
+      return false;
+    }
+    const auto cell = (context.position(i) - extents.minimum()) * to_cell;
+    const auto x = std::min(static_cast<uint32_t>(cell.x()), kCellLimit);
+    const auto y = std::min(static_cast<uint32_t>(cell.y()), kCellLimit);
+    const auto z = std::min(static_cast<uint32_t>(cell.z()), kCellLimit);
+    context.entries[i] = { spreadBits(x) | (spreadBits(y) << 1u) | (spreadBits(z) << 2u), i };
+  }
+  std::sort(context.entries.begin(), context.entries.end(),
+            [](const Entry &a, const Entry &b) { return a.key < b.key; });
+
+  _nodes.emplace_back();
+  if (!buildNode(context, 0, 0, context.entries.size(), 0))
+  {
+    _nodes.clear();
+    return false;
+  }
+
+  _order.resize(vertex_count);
+  for (uint32_t i = 0; i < vertex_count; ++i)
+  {
+    _order[i] = context.entries[i].index;
+  }
+  return true;
+}
+
+
+bool PointOctree::buildNode(BuildContext &context, uint32_t node_index, size_t begin, size_t end,
+                            unsigned depth)
+{
+  if (context.aborted())
+  {
+    return false;
+  }
+
+  auto &entries = context.entries;
+  const size_t count = end - begin;
+  const bool leaf = count <= context.capacity || depth >= kMaxDepth;
+  const size_t node_count = (leaf) ? count : context.capacity;
+
+  if (!leaf)
+  {
+    // Take an even stride of samples over the Morton ordered points for the node, moving them to
+    // the front of the range. The remaining points keep their order.
+    context.samples.resize(node_count);
+    const auto sample_position = [begin, count, node_count](size_t k) {
+      return begin + k * count / node_count;
+    };
+    size_t write = end;
+    size_t k = node_count;
+    for (size_t read = end; read > begin;)
+    {
+      --read;
+      if (k > 0 && read == sample_position(k - 1))
+      {
+        context.samples[--k] = entries[read];
+      }
+      else
+      {
+        entries[--write] = entries[read];
+      }
+    }
+    std::copy(context.samples.begin(), context.samples.end(),
+              entries.begin() + static_cast<std::ptrdiff_t>(begin));
+  }
+
+  // Bounds of the node points.
+  Boundsf bounds(context.position(entries[begin].index));
+  for (size_t i = begin + 1; i < begin + node_count; ++i)
+  {
+    bounds.expand(context.position(entries[i].index));
+  }
+
+  _nodes[node_index].begin = static_cast<uint32_t>(begin);
+  _nodes[node_index].count = static_cast<uint32_t>(node_count);
+
+  if (!leaf)
+  {
+    // Split the remaining points by their octant digit at this depth.
+    const unsigned shift = 3u * (kMaxDepth - 1u - depth);
+    std::array<std::pair<size_t, size_t>, 8> child_ranges = {};
+    uint32_t child_count = 0;
+    size_t child_begin = begin + node_count;
+    for (uint32_t digit = 0; digit < 8u; ++digit)
+    {
+      const auto child_end =
+        static_cast<size_t>(std::partition_point(
+                              entries.begin() + static_cast<std::ptrdiff_t>(child_begin),
+                              entries.begin() + static_cast<std::ptrdiff_t>(end),
+                              [shift, digit](const Entry &entry) {
+                                return ((entry.key >> shift) & 7u) <= digit;
+                              }) -
+                            entries.begin());
+      if (child_end > child_begin)
+      {
+        child_ranges[child_count++] = { child_begin, child_end };
+      }
+      child_begin = child_end;
+    }
+
+    const auto first_child = static_cast<uint32_t>(_nodes.size());
+    _nodes[node_index].first_child = first_child;
+    _nodes[node_index].child_count = child_count;
+    // Assume a surface like distribution for the spacing of the node samples.
+    const float cell_edge = context.edge / static_cast<float>(1u << depth);
+    _nodes[node_index].spacing = cell_edge / std::sqrt(static_cast<float>(node_count));
+    _nodes.resize(_nodes.size() + child_count);
+
+    for (uint32_t i = 0; i < child_count; ++i)
+    {
+      if (!buildNode(context, first_child + i, child_ranges[i].first, child_ranges[i].second,
+                     depth + 1))
+      {
+        return false;
+      }
+      bounds.expand(_nodes[first_child + i].bounds);
+    }
+  }
+
+  _nodes[node_index].bounds = bounds;
+  return true;
+}
+
+
+unsigned PointOctree::select(std::vector<uint32_t> &nodes, const Matrix4f &projection,
+                             const Matrix4f &model_view, unsigned view_height,
+                             unsigned point_budget, float error_threshold) const
+{
+  nodes.clear();
+  if (_nodes.empty())
+  {
+    return 0;
+  }
+
+  // Cull in the resource frame.
+  const FrustumPlanes frustum(projection * model_view);
+  const float scale = std::max({ model_view.axisX().magnitude(), model_view.axisY().magnitude(),
+                                 model_view.axisZ().magnitude() });
+  // Pixels covered by a unit length at unit distance.
+  const float pixel_scale = 0.5f * static_cast<float>(view_height) * projection(1, 1);
+
+  const auto visible = [&frustum](const Node &node) { return frustum.overlaps(node.bounds); };
+  // Project a spacing at the nearest point of the node bounding sphere.
+  const auto project = [&](float spacing, const Node &node) {
+    const float radius = node.bounds.halfExtents().magnitude() * scale;
+    const float distance =
+      std::max(model_view.transform(node.bounds.centre()).magnitude() - radius, kMinDistance);
+    return spacing * scale * pixel_scale / distance;
+  };
+
+  // Visit by priority: the projected spacing for the region without the node.
+  using Candidate = std::pair<float, uint32_t>;
+  std::priority_queue<Candidate> queue;
+  if (visible(_nodes.front()))
+  {
+    queue.emplace(std::numeric_limits<float>::max(), 0u);
+  }
+
+  unsigned point_count = 0;
+  while (!queue.empty())
+  {
+    const auto node_index = queue.top().second;
+    queue.pop();
+    const Node &node = _nodes[node_index];
+    if (!nodes.empty() && point_count + node.count > point_budget)
+    {
+      break;
+    }
+
+    nodes.emplace_back(node_index);
+    point_count += node.count;
+
+    if (node.child_count == 0 || project(node.spacing, node) <= error_threshold)
+    {
+      continue;
+    }
+
+    for (uint32_t i = 0; i < node.child_count; ++i)
+    {
+      const Node &child = _nodes[node.first_child + i];
+      if (visible(child))
+      {
+        queue.emplace(project(node.spacing, child), node.first_child + i);
+      }
+    }
+  }
+
+  return point_count;
+}
+}  // namespace tes
@@ -0,0 +1,130 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include "CoreConfig.h"
+
+#include "Bounds.h"
+#include "Matrix4.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace tes
+{
+class MeshResource;
+
+/// A level of detail hierarchy over a point cloud, used to render large point clouds progressively.
+///
+/// Each node holds a spatially even sample of the points within its octree cell, up to the node
+/// capacity, while the remaining points are distributed to its children. The node point sets are
+/// disjoint, so drawing a node along with all its ancestors draws the points in the node cell at
+/// the node resolution, and drawing a whole selection draws each point at most once.
+///
+/// Node points are identified by a contiguous range of @c order() , which maps to the vertex
+/// indices of the source resource. The octree does not reference the source resource after
+/// @c build() , but the source vertex indices are only meaningful for that resource.
+///
+/// Nodes are selected for rendering by @c select() , which prioritises nodes by their screen space
+/// error and stops at a point budget.
+class TES_CORE_API PointOctree
+{
+public:
+  /// Default maximum number of points in a node.
+  static constexpr unsigned kDefaultNodeCapacity = 1u << 15u;
+  /// Maximum octree depth. The root is at depth zero.
+  static constexpr unsigned kMaxDepth = 10u;
+
+  /// An octree node.
+  struct Node
+  {
+    /// Tight bounds of the points in this node and all its descendants.
+    Boundsf bounds;
+    /// Approximate point spacing when drawing this node and its ancestors. Zero when the node has
+    /// no children, as all the points in the node cell are then drawn.
+    float spacing = 0;
+    /// Index of the first node point in @c order() .
+    uint32_t begin = 0;
+    /// Number of points in the node.
+    uint32_t count = 0;
+    /// Index of the first child node. Children are contiguous.
+    uint32_t first_child = 0;
+    /// Number of child nodes.
+    uint32_t child_count = 0;
+  };
+
+  /// Build the octree for the vertices of @p resource .
+  ///
+  /// Intended to be run on a background thread. Indices are ignored.
+  ///
+  /// @param resource The point resource.
+  /// @param node_capacity The maximum number of points in a node, excluding nodes at
+  ///   @c kMaxDepth .
+  /// @param abort Optional flag which aborts the build when set.
+  /// @return True on success, false if aborted or there are no vertices.
+  bool build(const tes::MeshResource &resource, unsigned node_capacity = kDefaultNodeCapacity,
+             const std::atomic_bool *abort = nullptr);
+
+  /// Select the nodes to draw for a view.
+  ///
+  /// Nodes are visited by decreasing screen space error, starting from the root. Each visited node
+  /// is selected, and its children are considered when the node's projected point spacing exceeds
+  /// @p error_threshold . Nodes outside the view frustum are skipped. Selection stops before
+  /// exceeding @p point_budget , except for the root. A selected node always has its parent
+  /// selected, ahead of it in @p nodes .
+  ///
+  /// The matrices transform column vectors, as for @c Matrix4::transform() , with an OpenGL style
+  /// projection to clip space in the range [-w, w] on each axis.
+  ///
+  /// @param[out] nodes Set to the selected node indices.
+  /// @param projection The projection matrix.
+  /// @param model_view The transformation from the resource frame to the view frame.
+  /// @param view_height The viewport height (pixels).
+  /// @param point_budget The maximum number of points to select.
+  /// @param error_threshold The projected point spacing (pixels) below which nodes are not refined.
+  /// @return The number of points in the selected nodes.
+  unsigned select(std::vector<uint32_t> &nodes, const Matrix4f &projection,
+                  const Matrix4f &model_view, unsigned view_height, unsigned point_budget,
+                  float error_threshold = 1.0f) const;
+
+  /// Query the octree nodes. The root is the first node, when not empty.
+  /// @return The octree nodes.
+  [[nodiscard]] const std::vector<Node> &nodes() const { return _nodes; }
+  /// Query the source vertex indices in node order.
+  /// @return The point order.
+  [[nodiscard]] const std::vector<uint32_t> &order() const { return _order; }
+  /// Query the source vertex indices of a node.
+  /// @param node The node index.
+  /// @return A pointer to the first of @c Node::count vertex indices.
+  [[nodiscard]] const uint32_t *nodePoints(uint32_t node) const
+  {
+    return _order.data() + _nodes[node].begin;
+  }
+  /// Check if the octree is empty.
+  /// @return True if there are no nodes.
+  [[nodiscard]] bool empty() const { return _nodes.empty(); }
+
+private:
+  /// A point entry used while building.
+  struct Entry
+  {
+    /// Morton key of the point cell at @c kMaxDepth .
+    uint32_t key;
+    /// Source vertex index.
+    uint32_t index;
+  };
+
+  /// Build context passed through @c buildNode() .
+  struct BuildContext;
+
+  /// Recursively build a node over the build entries in the range `[begin, end)` .
+  /// @return False if aborted.
+  bool buildNode(BuildContext &context, uint32_t node_index, size_t begin, size_t end,
+                 unsigned depth);
+
+  std::vector<Node> _nodes;
+  std::vector<uint32_t> _order;
+};
+}  // namespace tes
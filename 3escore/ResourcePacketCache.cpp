@@ -0,0 +1,165 @@
+//
+// author: Kazys Stepanas
+//
+#include "ResourcePacketCache.h"
+
+#include "PacketWriter.h"
+#include "Resource.h"
+#include "ResourcePacker.h"
+
+#include "shapes/ProgressivePoints.h"
+
+#include <algorithm>
+
+namespace tes
+{
+namespace
+{
+/// Minimum entry count before purging expired cache entries.
+constexpr size_t kMinPurgeThreshold = 64u;
+}  // namespace
+
+PackedResource::PackedResource(const Resource &resource, uint32_t packet_size,
+                               uint32_t progressive_point_count)
+  : _key(resource.uniqueKey())
+{
+  // Substitute a progressive transfer for large point clouds.
+  const Resource *source = &resource;
+  std::unique_ptr<ProgressivePoints> progressive;
+  if (progressive_point_count > 0 && resource.typeId() == MtMesh)
+  {
+    const auto *mesh = dynamic_cast<const MeshResource *>(&resource);
+    if (mesh && mesh->vertexCount() >= progressive_point_count &&
+        ProgressivePoints::canRefine(*mesh))
+    {
+      progressive = std::make_unique<ProgressivePoints>(*mesh);
+      source = progressive.get();
+    }
+  }
+
+  std::vector<uint8_t> buffer(packet_size);
+  PacketWriter packet(buffer.data(), packet_size);
+  if (packet_size > kMaxPacketSize)
+  {
+    packet.setExtended(true);
+  }
+  ResourcePacker packer;
+  // Borrow the resource. It need only outlive packing.
+  packer.transfer(ResourcePacker::ResourcePtr(source));
+  while (packer.isValid())
+  {
+    if (!packer.nextPacket(packet, 0) || !packet.finalise())
+    {
+      break;
+    }
+
+    _packet_offsets.emplace_back(_data.size());
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    _data.insert(_data.end(), packet.data(), packet.data() + packet.packetSize());
+  }
+  _data.shrink_to_fit();
+  _packet_offsets.shrink_to_fit();
+}
+
+
+const uint8_t *PackedResource::packet(size_t index, uint32_t &byte_count) const
+{
+  const size_t begin = _packet_offsets[index];
+  const size_t end =
+    (index + 1 < _packet_offsets.size()) ? _packet_offsets[index + 1] : _data.size();
+  byte_count = static_cast<uint32_t>(end - begin);
+  return &_data[begin];
+}
+
+
+ResourcePacketCache::ResourcePacketCache(uint32_t packet_size, uint32_t progressive_point_count)
+  : _purge_threshold(kMinPurgeThreshold)
+  , _packet_size(packet_size)
+  , _progressive_point_count(progressive_point_count)
+{}
+
+
+std::shared_ptr<const PackedResource> ResourcePacketCache::acquire(const ResourcePtr &resource)
+{
+  const uint64_t key = resource->uniqueKey();
+  {
+    const std::lock_guard<std::mutex> guard(_lock);
+    const auto search = _entries.find(key);
+    if (search != _entries.end())
+    {
+      if (auto packed = search->second.lock())
+      {
+        return packed;
+      }
+    }
+  }
+
+  // Pack outside the lock. Concurrent requests for the same resource may both pack, but the first
+  // to finish is shared.
+  auto packed =
+    std::make_shared<const PackedResource>(*resource, _packet_size, _progressive_point_count);
+
+  const std::lock_guard<std::mutex> guard(_lock);
+  auto &entry = _entries[key];
+  if (auto existing = entry.lock())
+  {
+    return existing;
+  }
+  entry = packed;
+
+  if (_entries.size() >= _purge_threshold)
+  {
+    purge();
+  }
+  return packed;
+}
+
+
+void ResourcePacketCache::setPriority(uint64_t resource_key, int priority)
+{
+  const std::lock_guard<std::mutex> guard(_lock);
+  if (priority)
+  {
+    _priorities[resource_key] = priority;
+  }
+  else
+  {
+    _priorities.erase(resource_key);
+  }
+}
+
+
+int ResourcePacketCache::priority(uint64_t resource_key) const
+{
+  const std::lock_guard<std::mutex> guard(_lock);
+  const auto search = _priorities.find(resource_key);
+  return (search != _priorities.end()) ? search->second : 0;
+}
+
+
+size_t ResourcePacketCache::size() const
+{
+  const std::lock_guard<std::mutex> guard(_lock);
+  return static_cast<size_t>(
+    std::count_if(_entries.begin(), _entries.end(),
+                  [](const auto &entry) { return !entry.second.expired(); }));
+}
+
+
+void ResourcePacketCache::purge()
+{
+  for (auto iter = _entries.begin(); iter != _entries.end();)
+  {
+    if (iter->second.expired())
+    {
+      iter = _entries.erase(iter);
+    }
+    else
+    {
+      ++iter;
+    }
+  }
+  // Grow the threshold with the live entry count so purging stays amortised.
+  _purge_threshold = std::max(kMinPurgeThreshold, 2 * _entries.size());
+}
+}  // namespace tes
@@ -0,0 +1,126 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include "CoreConfig.h"
+
+#include "Ptr.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tes
+{
+class Resource;
+
+/// A @c Resource packed into the sequence of finalised packets required to transfer it.
+///
+/// Packed resources are immutable once created, so may be shared between connections and
+/// transferred from multiple threads.
+class TES_CORE_API PackedResource
+{
+public:
+  /// Pack @p resource using @c ResourcePacker .
+  /// @param resource The resource to pack.
+  /// @param packet_size The maximum size of each packet. Packets larger than @c kMaxPacketSize
+  /// use the @c PFExtended format.
+  /// @param progressive_point_count Point cloud resources with at least this many points are
+  /// packed for progressive transfer using @c ProgressivePoints . Zero to disable.
+  PackedResource(const Resource &resource, uint32_t packet_size,
+                 uint32_t progressive_point_count = 0);
+
+  /// Query the @c Resource::uniqueKey() of the packed resource.
+  /// @return The resource key.
+  [[nodiscard]] uint64_t key() const { return _key; }
+
+  /// Query the number of packets.
+  /// @return The packet count.
+  [[nodiscard]] size_t packetCount() const { return _packet_offsets.size(); }
+
+  /// Query the total number of bytes across all packets.
+  /// @return The packed byte count.
+  [[nodiscard]] size_t byteCount() const { return _data.size(); }
+
+  /// Access the packet at @p index .
+  /// @param index The packet index. Must be less than @c packetCount() .
+  /// @param[out] byte_count Set to the packet size in bytes.
+  /// @return The packet data.
+  [[nodiscard]] const uint8_t *packet(size_t index, uint32_t &byte_count) const;
+
+private:
+  std::vector<uint8_t> _data;
+  std::vector<size_t> _packet_offsets;
+  uint64_t _key = 0;
+};
+
+/// A cache of @c PackedResource objects, shared by connections so each resource is packed once
+/// regardless of the number of connections or when they join.
+///
+/// The cache holds weak references. A packed resource stays cached while at least one connection
+/// references the resource and is released once no connection needs it. This implies the cache
+/// assumes a resource's content does not change while it is referenced.
+///
+/// The cache also holds optional user priorities for resources. Resources with a higher priority
+/// are transferred first, before the @c ResourceOrder policy applies. Priorities persist until
+/// cleared, regardless of whether the resource is referenced.
+///
+/// Threadsafe.
+class TES_CORE_API ResourcePacketCache
+{
+public:
+  using ResourcePtr = Ptr<const Resource>;
+
+  /// Create a cache which packs resources using the given packet size.
+  /// @param packet_size The maximum packet size. Should not exceed the connection packet buffers
+  /// unless the connections support extended packets - see @c SFExtendedPackets - in which case
+  /// sizes larger than @c kMaxPacketSize use the @c PFExtended packet format.
+  /// @param progressive_point_count Minimum point count for progressive transfer of point cloud
+  /// resources. Zero to disable. See @c SFProgressivePoints .
+  explicit ResourcePacketCache(uint32_t packet_size, uint32_t progressive_point_count = 0);
+
+  /// Query the packet size used to pack resources.
+  /// @return The maximum packet size.
+  [[nodiscard]] uint32_t packetSize() const { return _packet_size; }
+
+  /// Query the minimum point count for progressive transfer of point cloud resources.
+  /// @return The progressive point count or zero when disabled.
+  [[nodiscard]] uint32_t progressivePointCount() const { return _progressive_point_count; }
+
+  /// Fetch the packed data for @p resource , packing it if not already cached.
+  /// @param resource The resource to fetch.
+  /// @return The packed resource.
+  [[nodiscard]] std::shared_ptr<const PackedResource> acquire(const ResourcePtr &resource);
+
+  /// Set the transfer priority for the resource with the given key.
+  /// @param resource_key The @c Resource::uniqueKey() .
+  /// @param priority The priority. Higher values are sent first. Zero clears the priority.
+  void setPriority(uint64_t resource_key, int priority);
+
+  /// Query the transfer priority for a resource.
+  /// @param resource_key The @c Resource::uniqueKey() .
+  /// @return The priority set by @c setPriority() or zero.
+  [[nodiscard]] int priority(uint64_t resource_key) const;
+
+  /// Query the number of packed resources currently cached.
+  /// @return The number of live cache entries.
+  [[nodiscard]] size_t size() const;
+
+private:
+  /// Remove expired entries.
+  ///
+  /// Note: the @c _lock must be locked before calling this function.
+  void purge();
+
+  mutable std::mutex _lock;
+  std::unordered_map<uint64_t, std::weak_ptr<const PackedResource>> _entries;
+  std::unordered_map<uint64_t, int> _priorities;
+  /// Number of entries at which to next purge expired entries.
+  size_t _purge_threshold = 0;
+  uint32_t _packet_size = 0;
+  uint32_t _progressive_point_count = 0;
+};
+}  // namespace tes
@@ -17,7 +17,9 @@ class CollatedPacket;
 class Connection;
 class ConnectionMonitor;
 class PacketWriter;
+class ResourcePacketCache;
 class Shape;
+class ShapeRegistry;
 struct ServerInfoMessage;
 
 /// Server option flags.
@@ -32,6 +34,31 @@ enum ServerFlag : uint32_t
   /// Set to compress collated outgoing packets using GZip compression.
   /// Has no effect if @c SFCollate is not set or if the library is not built against ZLib.
   SFCompress = (1u << 2u),
+  /// Also accept clients on the same host via a @c SharedMemoryRing named for the listen port
+  /// (see @c SharedMemoryRing::nameForPort() ). Ignored where shared memory is unsupported.
+  SFSharedMemory = (1u << 3u),
+  /// Adapt compression, resource transfer budgets and transient point cloud decimation per
+  /// connection to keep the time spent blocked on sends under
+  /// @c ServerSettings::target_latency_ms . See @c BaseConnection::stats() .
+  SFAdaptive = (1u << 4u),
+  /// Cache the live state - non-transient shapes, categories and referenced resources - and
+  /// replay it to each new connection from a background thread. This removes the need to recreate
+  /// the scene in the new connection callback. See @c ConnectionMonitor::commitConnections() .
+  SFStateCache = (1u << 5u),
+  /// Track the attributes last sent for each persistent shape and send only the attributes which
+  /// have changed on @c update() , skipping updates which change nothing. Changes are sent using
+  /// compact partial updates - see @c UFCompact - which require a client supporting that flag.
+  /// See @c ServerSettings::update_tolerance .
+  SFDeltaUpdates = (1u << 6u),
+  /// Transfer resources using @c PFExtended packets of up to
+  /// @c ServerSettings::extended_packet_size bytes. This reduces the packet count and per packet
+  /// overhead for large resources such as point clouds. Packets too large to collate are sent
+  /// directly. Only set for clients supporting packet version 0.5 or later.
+  SFExtendedPackets = (1u << 7u),
+  /// Transfer large point cloud resources progressively: a coarse, spatially decimated level
+  /// first, then successively finer levels. See @c ProgressivePoints and
+  /// @c ServerSettings::progressive_point_count .
+  SFProgressivePoints = (1u << 8u),
 
   /// The combination of @c SFCollate and @c SFCompress
   SFCollateAndCompress = SFCollate | SFCompress,
@@ -43,6 +70,40 @@ enum ServerFlag : uint32_t
   SFDefaultNoCompression = (SFDefault & ~SFCompress),
 };
 
+/// Selects the order in which queued resources are transferred to each connection. Resources with
+/// a user priority - see @c ResourcePacketCache::setPriority() - are always sent first.
+enum class ResourceOrder : uint8_t
+{
+  /// Send resources in the order they are first referenced.
+  Fifo,
+  /// Send the smallest resources first, so more shapes become drawable sooner.
+  SmallestFirst,
+  /// Send the most recently referenced resources first, favouring the current scene content.
+  RecentFirst
+};
+
+/// Controls when a connection sends its pending collated packet with @c SFCollate .
+///
+/// A collated packet is always sent when it is full and before sending any message which may not
+/// be collated, such as frame messages with @c SFNakedFrameMessage . The policy adds triggers to
+/// trade latency against packet size, and hence compression ratio.
+struct TES_CORE_API CollationFlushPolicy
+{
+  /// Send once at least this many bytes have been collated. Zero to flush only when the collated
+  /// packet is full. Collated packets are limited to 64 KiB, so larger values have no effect
+  /// unless @c SFExtendedPackets is set, in which case collated packets of up to
+  /// @c ServerSettings::extended_packet_size bytes are sent as @c PFExtended packets.
+  uint32_t max_bytes = 0;
+  /// Send once the first message collated into the pending packet is this old (microseconds).
+  /// Zero to disable. Checked as messages are collated and from a background server thread, so
+  /// messages do not wait for the end of a frame on low rate streams.
+  uint32_t max_age_us = 0;
+  /// Send at the end of each frame. Disable to allow collation across frames on high rate
+  /// streams, relying on the other triggers to bound latency. Ineffective with
+  /// @c SFNakedFrameMessage .
+  bool end_of_frame = true;
+};
+
 /// Settings used to create the server.
 struct TES_CORE_API ServerSettings
 {
@@ -51,6 +112,12 @@ struct TES_CORE_API ServerSettings
   /// Default server buffer size per client.
   static constexpr uint16_t kDefaultBufferSize = 0xffe0u;
   static constexpr uint32_t kDefaultAsyncTimeoutMs = 5000u;
+  /// Default target send latency for @c SFAdaptive (milliseconds).
+  static constexpr uint32_t kDefaultTargetLatencyMs = 50u;
+  /// Default packet size for @c SFExtendedPackets .
+  static constexpr uint32_t kDefaultExtendedPacketSize = 1024u * 1024u;
+  /// Default minimum point count for @c SFProgressivePoints .
+  static constexpr uint32_t kDefaultProgressivePointCount = 1u << 18u;
 
   /// First port to try listening on.
   uint16_t listen_port = kDefaultPort;
@@ -65,6 +132,22 @@ struct TES_CORE_API ServerSettings
   uint16_t client_buffer_size = kDefaultBufferSize;
   /// Compression level to use if enabled. See @c CompressionLevel.
   CompressionLevel compression_level = CompressionLevel::Default;
+  /// Target per frame send latency with @c SFAdaptive (milliseconds). This bounds the time a frame
+  /// update may block writing to a connection.
+  uint32_t target_latency_ms = kDefaultTargetLatencyMs;
+  /// Order in which queued resources are transferred.
+  ResourceOrder resource_order = ResourceOrder::Fifo;
+  /// Quantisation tolerance for @c SFDeltaUpdates . Position, rotation and scale components which
+  /// differ from the last sent value by no more than this are considered unchanged. Colour changes
+  /// are always sent.
+  double update_tolerance = 0;
+  /// Controls when collated packets are sent.
+  CollationFlushPolicy flush_policy = {};
+  /// Maximum resource and collated packet size with @c SFExtendedPackets (bytes).
+  uint32_t extended_packet_size = kDefaultExtendedPacketSize;
+  /// Minimum vertex count for a point cloud resource to be transferred progressively with
+  /// @c SFProgressivePoints . Zero disables progressive transfer.
+  uint32_t progressive_point_count = kDefaultProgressivePointCount;
 
   ServerSettings() = default;
   ServerSettings(uint32_t flags, uint16_t port = kDefaultPort,
@@ -76,6 +159,24 @@ struct TES_CORE_API ServerSettings
     , compression_level(compression_level)
   {}
 
+  /// Query the packet size used to transfer resources. This is the @c extended_packet_size with
+  /// @c SFExtendedPackets , or the @c client_buffer_size otherwise.
+  /// @return The resource packet size (bytes).
+  [[nodiscard]] uint32_t resourcePacketSize() const
+  {
+    return ((flags & SFExtendedPackets) && extended_packet_size > client_buffer_size) ?
+             extended_packet_size :
+             client_buffer_size;
+  }
+
+  /// Query the minimum vertex count for progressive point cloud transfer. This is the
+  /// @c progressive_point_count with @c SFProgressivePoints , or zero otherwise.
+  /// @return The progressive point count threshold. Zero disables progressive transfer.
+  [[nodiscard]] uint32_t progressivePointCount() const
+  {
+    return (flags & SFProgressivePoints) ? progressive_point_count : 0u;
+  }
+
   // TODO(KS): Allowed client IPs.
 };
 
@@ -124,5 +225,23 @@ public:
 
   /// @overload
   [[nodiscard]] virtual std::shared_ptr<const Connection> connection(unsigned index) const = 0;
+
+  /// Access the cache of packed resources shared by all connections. Use this to set resource
+  /// transfer priorities.
+  /// @return The shared resource cache.
+  [[nodiscard]] virtual std::shared_ptr<ResourcePacketCache> resourceCache() const = 0;
+
+  /// Add a @c ShapeRegistry to encode on each @c updateFrame() . The registry changes are sent to
+  /// all connections ahead of the frame message and the registry shapes are created for each new
+  /// connection. Updates use compact encoding when the server has @c SFDeltaUpdates .
+  ///
+  /// The registry must only be modified on the thread calling @c updateFrame() .
+  /// @param registry The registry to add. Ignored if already added.
+  virtual void addRegistry(const std::shared_ptr<ShapeRegistry> &registry) = 0;
+
+  /// Remove a registry added with @c addRegistry() . The registry shapes are not destroyed. To do
+  /// so, @c ShapeRegistry::clear() the registry and call @c updateFrame() before removing it.
+  /// @param registry The registry to remove.
+  virtual void removeRegistry(const std::shared_ptr<ShapeRegistry> &registry) = 0;
 };
 }  // namespace tes
@@ -0,0 +1,291 @@
+//
+// author: Kazys Stepanas
+//
+#include "ShapeRegistry.h"
+
+#include "Messages.h"
+#include "PacketWriter.h"
+
+namespace tes
+{
+namespace
+{
+/// Packet buffer size. Large enough for any single object message.
+constexpr size_t kPacketBufferSize = 256u;
+
+ObjectAttributesf attributesAt(const ShapeRegistry &registry, size_t index)
+{
+  ObjectAttributesf attrs = {};
+  attrs.colour = registry.colours()[index];
+  attrs.position = registry.positions()[index].storage();
+  attrs.rotation = registry.rotations()[index].storage();
+  attrs.scale = registry.scales()[index].storage();
+  return attrs;
+}
+}  // namespace
+
+ShapeRegistry::ShapeRegistry(uint16_t routing_id)
+  : _packet_buffer(kPacketBufferSize)
+  , _routing_id(routing_id)
+{}
+
+
+void ShapeRegistry::reserve(size_t count)
+{
+  _ids.reserve(count);
+  _categories.reserve(count);
+  _flags.reserve(count);
+  _positions.reserve(count);
+  _rotations.reserve(count);
+  _scales.reserve(count);
+  _colours.reserve(count);
+  _sent_positions.reserve(count);
+  _sent_rotations.reserve(count);
+  _sent_scales.reserve(count);
+  _sent_colours.reserve(count);
+  _created.reserve(count);
+  _index_to_handle.reserve(count);
+}
+
+
+ShapeRegistry::Handle ShapeRegistry::add(uint32_t id, const Vector3f &position,
+                                         const Quaternionf &rotation, const Vector3f &scale,
+                                         const Colour &colour, uint16_t category, uint16_t flags)
+{
+  if (id == 0)
+  {
+    return kInvalidHandle;
+  }
+
+  Handle handle = kInvalidHandle;
+  if (!_free_handles.empty())
+  {
+    handle = _free_handles.back();
+    _free_handles.pop_back();
+  }
+  else
+  {
+    handle = static_cast<Handle>(_handle_to_index.size());
+    _handle_to_index.emplace_back(0);
+  }
+
+  _handle_to_index[handle] = static_cast<uint32_t>(_ids.size());
+  _index_to_handle.emplace_back(handle);
+  _ids.emplace_back(id);
+  _categories.emplace_back(category);
+  _flags.emplace_back(static_cast<uint16_t>(flags & ~OFDoublePrecision));
+  _positions.emplace_back(position);
+  _rotations.emplace_back(rotation);
+  _scales.emplace_back(scale);
+  _colours.emplace_back(colour.colour32());
+  _sent_positions.emplace_back(position);
+  _sent_rotations.emplace_back(rotation);
+  _sent_scales.emplace_back(scale);
+  _sent_colours.emplace_back(colour.colour32());
+  _created.emplace_back(0u);
+  return handle;
+}
+
+
+bool ShapeRegistry::remove(Handle handle)
+{
+  if (!contains(handle))
+  {
+    return false;
+  }
+
+  const size_t index = _handle_to_index[handle];
+  if (_created[index])
+  {
+    _destroyed.emplace_back(_ids[index]);
+  }
+
+  const size_t last = _ids.size() - 1;
+  if (index != last)
+  {
+    moveEntry(last, index);
+  }
+
+  _ids.pop_back();
+  _categories.pop_back();
+  _flags.pop_back();
+  _positions.pop_back();
+  _rotations.pop_back();
+  _scales.pop_back();
+  _colours.pop_back();
+  _sent_positions.pop_back();
+  _sent_rotations.pop_back();
+  _sent_scales.pop_back();
+  _sent_colours.pop_back();
+  _created.pop_back();
+  _index_to_handle.pop_back();
+
+  _handle_to_index[handle] = ~0u;
+  _free_handles.emplace_back(handle);
+  return true;
+}
+
+
+void ShapeRegistry::clear()
+{
+  for (size_t i = 0; i < _ids.size(); ++i)
+  {
+    if (_created[i])
+    {
+      _destroyed.emplace_back(_ids[i]);
+    }
+  }
+
+  _ids.clear();
+  _categories.clear();
+  _flags.clear();
+  _positions.clear();
+  _rotations.clear();
+  _scales.clear();
+  _colours.clear();
+  _sent_positions.clear();
+  _sent_rotations.clear();
+  _sent_scales.clear();
+  _sent_colours.clear();
+  _created.clear();
+  _index_to_handle.clear();
+  _handle_to_index.clear();
+  _free_handles.clear();
+}
+
+
+bool ShapeRegistry::contains(Handle handle) const
+{
+  return handle < _handle_to_index.size() && _handle_to_index[handle] != ~0u;
+}
+
+
+unsigned ShapeRegistry::encode(const Emit &emit, bool compact_updates)
+{
+  unsigned packet_count = 0;
+  PacketWriter packet(_packet_buffer.data(), _packet_buffer.size());
+
+  for (const uint32_t id : _destroyed)
+  {
+    DestroyMessage destroy = {};
+    destroy.id = id;
+    packet.reset(_routing_id, DestroyMessage::MessageId);
+    if (destroy.write(packet) && packet.finalise())
+    {
+      emit(packet.data(), packet.packetSize());
+      ++packet_count;
+    }
+  }
+  _destroyed.clear();
+
+  // Detect changes one attribute array at a time.
+  const size_t count = _ids.size();
+  const uint16_t no_change = 0u;
+  const uint16_t colour_change = UFColour;
+  const uint16_t position_change = UFPosition;
+  const uint16_t rotation_change = UFRotation;
+  const uint16_t scale_change = UFScale;
+  _changes.resize(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    _changes[i] = (_colours[i] != _sent_colours[i]) ? colour_change : no_change;
+  }
+  for (size_t i = 0; i < count; ++i)
+  {
+    _changes[i] |= (_positions[i] != _sent_positions[i]) ? position_change : no_change;
+  }
+  for (size_t i = 0; i < count; ++i)
+  {
+    _changes[i] |= (_rotations[i] != _sent_rotations[i]) ? rotation_change : no_change;
+  }
+  for (size_t i = 0; i < count; ++i)
+  {
+    _changes[i] |= (_scales[i] != _sent_scales[i]) ? scale_change : no_change;
+  }
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (!_created[i])
+    {
+      writeCreate(i, emit);
+      _created[i] = 1u;
+      ++packet_count;
+    }
+    else if (_changes[i])
+    {
+      UpdateMessage update = {};
+      update.id = _ids[i];
+      update.flags = (compact_updates) ?
+                       static_cast<uint16_t>(UFUpdateMode | UFCompact | _changes[i]) :
+                       uint16_t(0u);
+      packet.reset(_routing_id, UpdateMessage::MessageId);
+      if (update.write(packet, attributesAt(*this, i)) && packet.finalise())
+      {
+        emit(packet.data(), packet.packetSize());
+        ++packet_count;
+      }
+    }
+    else
+    {
+      continue;
+    }
+
+    _sent_colours[i] = _colours[i];
+    _sent_positions[i] = _positions[i];
+    _sent_rotations[i] = _rotations[i];
+    _sent_scales[i] = _scales[i];
+  }
+
+  return packet_count;
+}
+
+
+unsigned ShapeRegistry::encodeCreated(const Emit &emit) const
+{
+  unsigned packet_count = 0;
+  for (size_t i = 0; i < _ids.size(); ++i)
+  {
+    if (_created[i])
+    {
+      writeCreate(i, emit);
+      ++packet_count;
+    }
+  }
+  return packet_count;
+}
+
+
+void ShapeRegistry::writeCreate(size_t index, const Emit &emit) const
+{
+  CreateMessage create = {};
+  create.id = _ids[index];
+  create.category = _categories[index];
+  create.flags = _flags[index];
+  PacketWriter packet(_packet_buffer.data(), _packet_buffer.size(), _routing_id,
+                      CreateMessage::MessageId);
+  if (create.write(packet, attributesAt(*this, index)) && packet.finalise())
+  {
+    emit(packet.data(), packet.packetSize());
+  }
+}
+
+
+void ShapeRegistry::moveEntry(size_t from, size_t to)
+{
+  _ids[to] = _ids[from];
+  _categories[to] = _categories[from];
+  _flags[to] = _flags[from];
+  _positions[to] = _positions[from];
+  _rotations[to] = _rotations[from];
+  _scales[to] = _scales[from];
+  _colours[to] = _colours[from];
+  _sent_positions[to] = _sent_positions[from];
+  _sent_rotations[to] = _sent_rotations[from];
+  _sent_scales[to] = _sent_scales[from];
+  _sent_colours[to] = _sent_colours[from];
+  _created[to] = _created[from];
+  const Handle handle = _index_to_handle[from];
+  _index_to_handle[to] = handle;
+  _handle_to_index[handle] = static_cast<uint32_t>(to);
+}
+}  // namespace tes
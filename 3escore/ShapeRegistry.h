@@ -0,0 +1,212 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include "CoreConfig.h"
+
+#include "Colour.h"
+#include "Quaternion.h"
+#include "Vector3.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace tes
+{
+/// A handle based registry of many persistent shapes of one simple shape type, such as
+/// @c SIdSphere or @c SIdBox , stored as a structure of arrays.
+///
+/// This is an alternative to managing large numbers of @c Shape objects one at a time. Each entry
+/// has an id, category, flags, position, rotation, scale and colour stored in parallel arrays. The
+/// application modifies the arrays in bulk via @c positions() , @c colours() etc, then the
+/// registry encodes creation, update and destroy messages for all changed entries in one pass with
+/// @c encode() . Changes are detected by comparing against the last encoded values, one attribute
+/// array at a time, so there is no need to flag modified entries.
+///
+/// A registry added to a @c Server with @c Server::addRegistry() is encoded on each
+/// @c Server::updateFrame() and its live shapes are created for each new connection.
+///
+/// Only shapes fully described by their @c ObjectAttributes are supported - the simple primitive
+/// shapes which have no data messages. Shapes are always written with single precision.
+///
+/// Entries are addressed by @c Handle . Handles remain valid until the entry is removed, while the
+/// array index of an entry may change whenever an entry is removed. Use @c indexOf() to resolve the
+/// current index.
+///
+/// Not threadsafe. Modify the registry on the thread which calls @c Server::updateFrame() .
+class TES_CORE_API ShapeRegistry
+{
+public:
+  /// Identifies an entry.
+  using Handle = uint32_t;
+  /// Function used to emit encoded packets.
+  using Emit = std::function<void(const uint8_t *data, uint32_t byte_count)>;
+
+  /// Value used for an invalid handle.
+  static constexpr Handle kInvalidHandle = ~0u;
+
+  /// Create a registry for shapes of the given type.
+  /// @param routing_id The shape routing ID. See @c ShapeHandlerIDs .
+  explicit ShapeRegistry(uint16_t routing_id);
+
+  /// Query the routing ID for the registry shapes.
+  /// @return The shape routing ID.
+  [[nodiscard]] uint16_t routingId() const { return _routing_id; }
+
+  /// Query the number of entries.
+  /// @return The number of entries.
+  [[nodiscard]] size_t size() const { return _ids.size(); }
+
+  /// Reserve space for @p count entries.
+  /// @param count The number of entries to reserve for.
+  void reserve(size_t count);
+
+  /// Add an entry. The shape is created on the next @c encode() .
+  /// @param id The shape id. Must be non-zero and unique for the routing ID.
+  /// @param position The shape position.
+  /// @param rotation The shape rotation.
+  /// @param scale The shape scale.
+  /// @param colour The shape colour.
+  /// @param category The shape category.
+  /// @param flags @c ObjectFlag values. @c OFDoublePrecision is ignored.
+  /// @return The handle for the new entry or @c kInvalidHandle if @p id is zero.
+  Handle add(uint32_t id, const Vector3f &position = Vector3f::Zero,
+             const Quaternionf &rotation = Quaternionf::Identity,
+             const Vector3f &scale = Vector3f::One, const Colour &colour = Colour(255, 255, 255),
+             uint16_t category = 0, uint16_t flags = 0);
+
+  /// Remove an entry. The shape is destroyed on the next @c encode() if it has been created.
+  ///
+  /// This moves the last entry into the array index of the removed entry.
+  /// @param handle The entry to remove.
+  /// @return True if @p handle was valid.
+  bool remove(Handle handle);
+
+  /// Remove all entries.
+  void clear();
+
+  /// Check if @p handle references an entry.
+  /// @param handle The handle to check.
+  /// @return True if valid.
+  [[nodiscard]] bool contains(Handle handle) const;
+
+  /// Resolve the array index of an entry.
+  /// @param handle The entry handle. Must be valid.
+  /// @return The array index of the entry.
+  [[nodiscard]] size_t indexOf(Handle handle) const { return _handle_to_index[handle]; }
+
+  /// Resolve the handle of the entry at array index @p index .
+  /// @param index The array index. Must be less than @c size() .
+  /// @return The entry handle.
+  [[nodiscard]] Handle handleAt(size_t index) const { return _index_to_handle[index]; }
+
+  /// Shape ids by array index.
+  /// @return The id array.
+  [[nodiscard]] const uint32_t *ids() const { return _ids.data(); }
+  /// Shape categories by array index. Category changes take effect only on creation.
+  /// @return The category array.
+  [[nodiscard]] const uint16_t *categories() const { return _categories.data(); }
+  /// Shape flags by array index.
+  /// @return The flags array.
+  [[nodiscard]] const uint16_t *flags() const { return _flags.data(); }
+
+  /// Shape positions by array index. May be modified.
+  /// @return The position array.
+  [[nodiscard]] Vector3f *positions() { return _positions.data(); }
+  /// @overload
+  [[nodiscard]] const Vector3f *positions() const { return _positions.data(); }
+  /// Shape rotations by array index. May be modified.
+  /// @return The rotation array.
+  [[nodiscard]] Quaternionf *rotations() { return _rotations.data(); }
+  /// @overload
+  [[nodiscard]] const Quaternionf *rotations() const { return _rotations.data(); }
+  /// Shape scales by array index. May be modified.
+  /// @return The scale array.
+  [[nodiscard]] Vector3f *scales() { return _scales.data(); }
+  /// @overload
+  [[nodiscard]] const Vector3f *scales() const { return _scales.data(); }
+  /// Shape colours by array index, as @c Colour::colour32() values. May be modified.
+  /// @return The colour array.
+  [[nodiscard]] uint32_t *colours() { return _colours.data(); }
+  /// @overload
+  [[nodiscard]] const uint32_t *colours() const { return _colours.data(); }
+
+  /// Set the position of an entry.
+  /// @param handle The entry handle. Must be valid.
+  /// @param position The new position.
+  void setPosition(Handle handle, const Vector3f &position)
+  {
+    _positions[indexOf(handle)] = position;
+  }
+  /// Set the rotation of an entry.
+  /// @param handle The entry handle. Must be valid.
+  /// @param rotation The new rotation.
+  void setRotation(Handle handle, const Quaternionf &rotation)
+  {
+    _rotations[indexOf(handle)] = rotation;
+  }
+  /// Set the scale of an entry.
+  /// @param handle The entry handle. Must be valid.
+  /// @param scale The new scale.
+  void setScale(Handle handle, const Vector3f &scale) { _scales[indexOf(handle)] = scale; }
+  /// Set the colour of an entry.
+  /// @param handle The entry handle. Must be valid.
+  /// @param colour The new colour.
+  void setColour(Handle handle, const Colour &colour)
+  {
+    _colours[indexOf(handle)] = colour.colour32();
+  }
+
+  /// Encode the changes since the last call: destroy messages for removed entries, creation
+  /// messages for new entries and update messages for modified entries.
+  ///
+  /// Updates carry all attributes unless @p compact_updates is set, in which case they carry only
+  /// the modified attributes using @c UFCompact . Only use compact updates with clients which
+  /// support them. See @c SFDeltaUpdates .
+  /// @param emit Function called for each finalised packet.
+  /// @param compact_updates True to write compact partial updates.
+  /// @return The number of packets emitted.
+  unsigned encode(const Emit &emit, bool compact_updates = false);
+
+  /// Encode creation messages for all entries created by previous @c encode() calls. This supports
+  /// bringing a new connection up to date.
+  /// @param emit Function called for each finalised packet.
+  /// @return The number of packets emitted.
+  unsigned encodeCreated(const Emit &emit) const;
+
+private:
+  /// Encode a creation message for the entry at @p index .
+  void writeCreate(size_t index, const Emit &emit) const;
+  /// Move the entry at array index @p from to array index @p to , updating the handle mappings.
+  void moveEntry(size_t from, size_t to);
+
+  /// @c ObjectAttributes arrays.
+  std::vector<uint32_t> _ids;
+  std::vector<uint16_t> _categories;
+  std::vector<uint16_t> _flags;
+  std::vector<Vector3f> _positions;
+  std::vector<Quaternionf> _rotations;
+  std::vector<Vector3f> _scales;
+  std::vector<uint32_t> _colours;
+  /// Attribute values as last encoded, for change detection.
+  std::vector<Vector3f> _sent_positions;
+  std::vector<Quaternionf> _sent_rotations;
+  std::vector<Vector3f> _sent_scales;
+  std::vector<uint32_t> _sent_colours;
+  /// Non-zero for entries which have been created.
+  std::vector<uint8_t> _created;
+  /// Modified @c UpdateFlag values for each entry. Working space for @c encode() .
+  std::vector<uint16_t> _changes;
+  /// Ids of removed entries to destroy.
+  std::vector<uint32_t> _destroyed;
+  std::vector<uint32_t> _handle_to_index;
+  std::vector<Handle> _index_to_handle;
+  /// Released handles available for reuse.
+  std::vector<Handle> _free_handles;
+  /// Buffer used to encode each packet.
+  mutable std::vector<uint8_t> _packet_buffer;
+  uint16_t _routing_id = 0;
+};
+}  // namespace tes
@@ -0,0 +1,523 @@
+//
+// author: Kazys Stepanas
+//
+#include "ShapeTimeline.h"
+
+#include "CollatedPacketDecoder.h"
+#include "Log.h"
+#include "Messages.h"
+#include "PacketReader.h"
+#include "PacketStreamReader.h"
+
+#include "shapes/Shape.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+
+namespace tes
+{
+namespace
+{
+/// Timeline file header.
+struct FileHeader
+{
+  uint32_t marker = ShapeTimeline::kMarker;
+  uint32_t version = ShapeTimeline::kVersion;
+  uint32_t frame_count = 0;
+  uint32_t reserved = 0;
+  uint64_t shape_count = 0;
+  uint64_t event_count = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<FileHeader>);
+
+template <typename T>
+bool writeColumn(std::ostream &out, const std::vector<T> &column)
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  out.write(reinterpret_cast<const char *>(column.data()),
+            static_cast<std::streamsize>(column.size() * sizeof(T)));
+  return out.good();
+}
+
+
+template <typename T>
+bool readColumn(std::istream &in, std::vector<T> &column, size_t count)
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+  column.resize(count);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  in.read(reinterpret_cast<char *>(column.data()),
+          static_cast<std::streamsize>(column.size() * sizeof(T)));
+  return in.good();
+}
+
+
+/// Check the @p header counts match the @p data_size bytes following the header.
+bool validCounts(const FileHeader &header, uint64_t data_size)
+{
+  constexpr uint64_t kShapeBytes = sizeof(uint64_t) + sizeof(uint32_t);
+  constexpr uint64_t kEventBytes = sizeof(uint32_t) + sizeof(uint8_t) +
+                                   sizeof(std::array<float, 3>) + sizeof(std::array<float, 4>) +
+                                   sizeof(std::array<float, 3>) + sizeof(uint32_t);
+  // Event offsets are 32-bit. Check the counts individually before multiplying to avoid overflow.
+  if (header.event_count > std::numeric_limits<uint32_t>::max() ||
+      header.shape_count > data_size / kShapeBytes || header.event_count > data_size / kEventBytes)
+  {
+    return false;
+  }
+  return data_size == header.shape_count * kShapeBytes + sizeof(uint32_t) +
+                        header.event_count * kEventBytes;
+}
+
+
+/// Check the loaded @p keys are sorted and the @p offsets index events in order.
+bool validIndex(const std::vector<uint64_t> &keys, const std::vector<uint32_t> &offsets,
+                size_t event_count)
+{
+  if (std::adjacent_find(keys.begin(), keys.end(), std::greater_equal<>()) != keys.end())
+  {
+    return false;
+  }
+  if (offsets.empty() || offsets.front() != 0 || offsets.back() != event_count)
+  {
+    return false;
+  }
+  return std::is_sorted(offsets.begin(), offsets.end());
+}
+
+
+/// Reorders a column from stream order into shape order.
+template <typename T>
+void reorder(std::vector<T> &column, const std::vector<uint32_t> &order)
+{
+  std::vector<T> sorted(column.size());
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    sorted[order[i]] = column[i];
+  }
+  column = std::move(sorted);
+}
+
+
+/// Accumulates events in stream order while building a @c ShapeTimeline .
+class TimelineBuilder
+{
+public:
+  TimelineBuilder(std::vector<uint32_t> &frames, std::vector<uint8_t> &types,
+                  std::vector<std::array<float, 3>> &positions,
+                  std::vector<std::array<float, 4>> &rotations,
+                  std::vector<std::array<float, 3>> &scales, std::vector<uint32_t> &colours)
+    : _frames(frames)
+    , _types(types)
+    , _positions(positions)
+    , _rotations(rotations)
+    , _scales(scales)
+    , _colours(colours)
+  {}
+
+  /// Process a shape message.
+  bool read(PacketReader &packet, uint32_t frame)
+  {
+    const uint16_t routing_id = packet.routingId();
+    if (packet.messageId() == OIdCreate)
+    {
+      Shape shape(routing_id);
+      if (!shape.readCreate(packet))
+      {
+        return false;
+      }
+      if (!shape.isTransient())
+      {
+        const uint64_t key = objectKey(routing_id, shape.id());
+        const auto live = _live.insert_or_assign(key, std::move(shape)).first;
+        addEvent(key, frame, ShapeTimeline::EventType::Create, live->second);
+      }
+      return true;
+    }
+
+    uint32_t id = 0;
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (packet.peek(reinterpret_cast<uint8_t *>(&id), sizeof(id)) != sizeof(id))
+    {
+      return false;
+    }
+
+    const uint64_t key = objectKey(routing_id, id);
+    const auto live = _live.find(key);
+    if (live == _live.end())
+    {
+      // Transient data or an unknown shape.
+      return true;
+    }
+
+    switch (packet.messageId())
+    {
+    case OIdUpdate:
+      if (!live->second.readUpdate(packet))
+      {
+        return false;
+      }
+      addEvent(key, frame, ShapeTimeline::EventType::Update, live->second);
+      break;
+    case OIdDestroy:
+      addEvent(key, frame, ShapeTimeline::EventType::Destroy, live->second);
+      _live.erase(live);
+      break;
+    default:
+      break;
+    }
+    return true;
+  }
+
+  /// Destroy all live shapes.
+  void reset(uint32_t frame)
+  {
+    for (const auto &[key, shape] : _live)
+    {
+      addEvent(key, frame, ShapeTimeline::EventType::Destroy, shape);
+    }
+    _live.clear();
+  }
+
+  /// Sort the events by shape, populating @p keys and @p offsets .
+  void finalise(std::vector<uint64_t> &keys, std::vector<uint32_t> &offsets)
+  {
+    // Sort the shapes by key, then scatter the events into shape order. Events for each shape stay
+    // in stream order, which is frame order.
+    std::vector<uint32_t> shape_order(_shape_keys.size());
+    for (uint32_t i = 0; i < shape_order.size(); ++i)
+    {
+      shape_order[i] = i;
+    }
+    std::sort(shape_order.begin(), shape_order.end(),
+              [this](uint32_t a, uint32_t b) { return _shape_keys[a] < _shape_keys[b]; });
+
+    // Sorted position of each shape.
+    std::vector<uint32_t> shape_rank(shape_order.size());
+    keys.resize(shape_order.size());
+    offsets.resize(shape_order.size() + 1);
+    uint32_t offset = 0;
+    for (uint32_t rank = 0; rank < shape_order.size(); ++rank)
+    {
+      const uint32_t shape = shape_order[rank];
+      shape_rank[shape] = rank;
+      keys[rank] = _shape_keys[shape];
+      offsets[rank] = offset;
+      offset += _event_counts[shape];
+    }
+    offsets.back() = offset;
+
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    std::vector<uint32_t> order(_event_shapes.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+      order[i] = next[shape_rank[_event_shapes[i]]]++;
+    }
+
+    reorder(_frames, order);
+    reorder(_types, order);
+    reorder(_positions, order);
+    reorder(_rotations, order);
+    reorder(_scales, order);
+    reorder(_colours, order);
+  }
+
+private:
+  void addEvent(uint64_t key, uint32_t frame, ShapeTimeline::EventType type, const Shape &shape)
+  {
+    const auto [shape_index, added] =
+      _shape_indices.emplace(key, static_cast<uint32_t>(_shape_keys.size()));
+    if (added)
+    {
+      _shape_keys.emplace_back(key);
+      _event_counts.emplace_back(0);
+    }
+    ++_event_counts[shape_index->second];
+    _event_shapes.emplace_back(shape_index->second);
+
+    const auto &attrs = shape.attributes();
+    _frames.emplace_back(frame);
+    _types.emplace_back(static_cast<uint8_t>(type));
+    _positions.emplace_back(std::array<float, 3>{ static_cast<float>(attrs.position[0]),
+                                                  static_cast<float>(attrs.position[1]),
+                                                  static_cast<float>(attrs.position[2]) });
+    _rotations.emplace_back(std::array<float, 4>{
+      static_cast<float>(attrs.rotation[0]), static_cast<float>(attrs.rotation[1]),
+      static_cast<float>(attrs.rotation[2]), static_cast<float>(attrs.rotation[3]) });
+    _scales.emplace_back(std::array<float, 3>{ static_cast<float>(attrs.scale[0]),
+                                               static_cast<float>(attrs.scale[1]),
+                                               static_cast<float>(attrs.scale[2]) });
+    _colours.emplace_back(attrs.colour);
+  }
+
+  std::vector<uint32_t> &_frames;
+  std::vector<uint8_t> &_types;
+  std::vector<std::array<float, 3>> &_positions;
+  std::vector<std::array<float, 4>> &_rotations;
+  std::vector<std::array<float, 3>> &_scales;
+  std::vector<uint32_t> &_colours;
+  /// Live shapes holding their current state.
+  std::unordered_map<uint64_t, Shape> _live;
+  /// Maps shape keys to dense shape indices, in order of first appearance.
+  std::unordered_map<uint64_t, uint32_t> _shape_indices;
+  std::vector<uint64_t> _shape_keys;
+  std::vector<uint32_t> _event_counts;
+  /// Dense shape index of each event.
+  std::vector<uint32_t> _event_shapes;
+};
+}  // namespace
+
+
+bool ShapeTimeline::build(std::istream &stream)
+{
+  clear();
+  TimelineBuilder builder(_frames, _types, _positions, _rotations, _scales, _colours);
+  PacketStreamReader reader(stream);
+  CollatedPacketDecoder decoder;
+  uint32_t frame = 0;
+  bool ok = true;
+
+  while (ok && reader.isOk() && !reader.isEof())
+  {
+    const auto [packet_header, status, stream_position] = reader.extractPacket();
+    if (!packet_header)
+    {
+      ok = status == PacketStreamReader::Status::End;
+      continue;
+    }
+
+    decoder.setPacket(packet_header);
+    while (const auto *header = decoder.next())
+    {
+      PacketReader packet(header);
+      const uint16_t routing_id = packet.routingId();
+      if (routing_id >= ShapeHandlersIDStart)
+      {
+        if (!builder.read(packet, frame))
+        {
+          log::error("Failed to decode shape message ", routing_id, ":", packet.messageId(),
+                     " in frame ", frame);
+          ok = false;
+        }
+      }
+      else if (routing_id == MtControl)
+      {
+        if (packet.messageId() == CIdFrame)
+        {
+          ++frame;
+        }
+        else if (packet.messageId() == CIdReset)
+        {
+          builder.reset(frame);
+        }
+      }
+    }
+  }
+
+  builder.finalise(_keys, _offsets);
+  _frame_count = frame;
+  return ok;
+}
+
+
+bool ShapeTimeline::save(const std::string &path) const
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open())
+  {
+    log::error("Unable to open timeline file for writing: ", path);
+    return false;
+  }
+
+  FileHeader header = {};
+  header.frame_count = _frame_count;
+  header.shape_count = _keys.size();
+  header.event_count = _frames.size();
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  bool ok = out.good();
+  ok = ok && writeColumn(out, _keys);
+  ok = ok && writeColumn(out, _offsets);
+  ok = ok && writeColumn(out, _frames);
+  ok = ok && writeColumn(out, _types);
+  ok = ok && writeColumn(out, _positions);
+  ok = ok && writeColumn(out, _rotations);
+  ok = ok && writeColumn(out, _scales);
+  ok = ok && writeColumn(out, _colours);
+
+  if (!ok)
+  {
+    log::error("Failed to write timeline file: ", path);
+  }
+  return ok;
+}
+
+
+bool ShapeTimeline::load(const std::string &path)
+{
+  clear();
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open())
+  {
+    return false;
+  }
+
+  FileHeader header = {};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  in.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!in.good() || header.marker != kMarker)
+  {
+    log::error("Not a timeline file: ", path);
+    return false;
+  }
+
+  if (header.version != kVersion)
+  {
+    log::error("Unsupported timeline version ", header.version, ": ", path);
+    return false;
+  }
+
+  // Validate the counts against the file size before allocating anything.
+  const auto data_start = in.tellg();
+  in.seekg(0, std::ios::end);
+  const auto data_size = static_cast<uint64_t>(in.tellg() - data_start);
+  in.seekg(data_start);
+  if (!validCounts(header, data_size))
+  {
+    log::error("Corrupt timeline file: ", path);
+    return false;
+  }
+
+  const auto shape_count = static_cast<size_t>(header.shape_count);
+  const auto event_count = static_cast<size_t>(header.event_count);
+  bool ok = true;
+  ok = ok && readColumn(in, _keys, shape_count);
+  ok = ok && readColumn(in, _offsets, shape_count + 1);
+  ok = ok && readColumn(in, _frames, event_count);
+  ok = ok && readColumn(in, _types, event_count);
+  ok = ok && readColumn(in, _positions, event_count);
+  ok = ok && readColumn(in, _rotations, event_count);
+  ok = ok && readColumn(in, _scales, event_count);
+  ok = ok && readColumn(in, _colours, event_count);
+  ok = ok && validIndex(_keys, _offsets, event_count);
+
+  if (!ok)
+  {
+    log::error("Failed to read timeline file: ", path);
+    clear();
+    return false;
+  }
+
+  _frame_count = header.frame_count;
+  return true;
+}
+
+
+void ShapeTimeline::clear()
+{
+  _keys.clear();
+  _offsets.clear();
+  _frames.clear();
+  _types.clear();
+  _positions.clear();
+  _rotations.clear();
+  _scales.clear();
+  _colours.clear();
+  _frame_count = 0;
+}
+
+
+bool ShapeTimeline::contains(uint16_t routing_id, uint32_t id) const
+{
+  return std::binary_search(_keys.begin(), _keys.end(), objectKey(routing_id, id));
+}
+
+
+std::optional<ShapeTimeline::State> ShapeTimeline::stateAt(uint16_t routing_id, uint32_t id,
+                                                           uint32_t frame) const
+{
+  uint32_t first = 0;
+  uint32_t last = 0;
+  if (!eventRange(routing_id, id, first, last))
+  {
+    return std::nullopt;
+  }
+
+  // Find the last event at or before frame.
+  const auto begin = _frames.begin() + first;
+  const auto end = _frames.begin() + last;
+  const auto after = std::upper_bound(begin, end, frame);
+  if (after == begin)
+  {
+    // Not yet created.
+    return std::nullopt;
+  }
+
+  const auto index = static_cast<uint32_t>(std::distance(_frames.begin(), after) - 1);
+  const auto event = eventAt(index);
+  if (event.type == EventType::Destroy)
+  {
+    return std::nullopt;
+  }
+  return event.state;
+}
+
+
+size_t ShapeTimeline::events(uint16_t routing_id, uint32_t id, uint32_t begin_frame,
+                             uint32_t end_frame, std::vector<Event> &events) const
+{
+  events.clear();
+  uint32_t first = 0;
+  uint32_t last = 0;
+  if (!eventRange(routing_id, id, first, last))
+  {
+    return 0;
+  }
+
+  const auto begin = _frames.begin() + first;
+  const auto end = _frames.begin() + last;
+  const auto range_begin = std::lower_bound(begin, end, begin_frame);
+  const auto range_end = std::lower_bound(range_begin, end, end_frame);
+  for (auto iter = range_begin; iter < range_end; ++iter)
+  {
+    events.emplace_back(eventAt(static_cast<uint32_t>(std::distance(_frames.begin(), iter))));
+  }
+  return events.size();
+}
+
+
+bool ShapeTimeline::eventRange(uint16_t routing_id, uint32_t id, uint32_t &first,
+                               uint32_t &last) const
+{
+  const auto search = std::lower_bound(_keys.begin(), _keys.end(), objectKey(routing_id, id));
+  if (search == _keys.end() || *search != objectKey(routing_id, id))
+  {
+    return false;
+  }
+
+  const auto shape = static_cast<size_t>(std::distance(_keys.begin(), search));
+  first = _offsets[shape];
+  last = _offsets[shape + 1];
+  return true;
+}
+
+
+ShapeTimeline::Event ShapeTimeline::eventAt(uint32_t index) const
+{
+  Event event = {};
+  event.frame = _frames[index];
+  event.type = static_cast<EventType>(_types[index]);
+  event.state.position = Vector3f(_positions[index]);
+  event.state.rotation = Quaternionf(_rotations[index]);
+  event.state.scale = Vector3f(_scales[index]);
+  event.state.colour = _colours[index];
+  return event;
+}
+}  // namespace tes
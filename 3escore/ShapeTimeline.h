@@ -0,0 +1,149 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include "CoreConfig.h"
+
+#include "Quaternion.h"
+#include "Vector3.h"
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tes
+{
+/// A per shape timeline of the create, update and destroy events in a 3es recording, supporting
+/// queries of the state of persistent shapes at any frame.
+///
+/// The timeline is built from a recording in a single streaming pass with @c build() . Each event
+/// records the frame in which it occurs and the complete shape state after the event, as resolved
+/// using @c Shape::readCreate() and @c Shape::readUpdate() . This means partial and compact updates
+/// are resolved once on building, not on each query.
+///
+/// Events are stored in columns grouped by shape and ordered by frame, with a sorted shape table
+/// referencing the events for each shape. A query is two binary searches: one for the shape, one
+/// for the frame. The timeline can be saved to and loaded from a compact file using @c save() and
+/// @c load() , so recordings need only be processed once. The file stores values in host byte
+/// order and single precision.
+///
+/// Frames are numbered from zero, counting @c CIdFrame messages, so messages before the first
+/// frame end are in frame zero. A @c CIdReset message destroys all shapes. Transient shapes are not
+/// tracked and multi-shape creation messages only track the first shape.
+class TES_CORE_API ShapeTimeline
+{
+public:
+  /// File marker.
+  static constexpr uint32_t kMarker = 0x4c4d5433u;  // "3TML" little endian
+  /// File version.
+  static constexpr uint32_t kVersion = 1u;
+
+  /// Timeline event types.
+  enum class EventType : uint8_t
+  {
+    Create,
+    Update,
+    Destroy
+  };
+
+  /// The state of a shape.
+  struct State
+  {
+    Vector3f position = Vector3f::Zero;
+    Quaternionf rotation = Quaternionf::Identity;
+    Vector3f scale = Vector3f::One;
+    /// Colour as a @c Colour::colour32() value.
+    uint32_t colour = 0xffffffffu;
+  };
+
+  /// A timeline event.
+  struct Event
+  {
+    /// The frame in which the event occurs.
+    uint32_t frame = 0;
+    /// The event type.
+    EventType type = EventType::Create;
+    /// The shape state after the event. For @c EventType::Destroy this is the last state.
+    State state;
+  };
+
+  /// Build the timeline from a 3es stream, replacing any existing timeline.
+  /// @param stream The stream to read.
+  /// @return True on success, false if the stream is invalid or has errors. A timeline is built
+  /// up to any error.
+  bool build(std::istream &stream);
+
+  /// Save the timeline to @p path .
+  /// @param path The file to write.
+  /// @return True on success.
+  bool save(const std::string &path) const;
+
+  /// Load a timeline written by @c save() , replacing any existing timeline.
+  /// @param path The file to read.
+  /// @return True on success.
+  bool load(const std::string &path);
+
+  /// Clear the timeline.
+  void clear();
+
+  /// Query the number of frames in the recording.
+  /// @return The frame count.
+  [[nodiscard]] uint32_t frameCount() const { return _frame_count; }
+  /// Query the number of shapes in the timeline.
+  /// @return The number of shapes which have been created.
+  [[nodiscard]] size_t shapeCount() const { return _keys.size(); }
+  /// Query the total number of events.
+  /// @return The event count.
+  [[nodiscard]] size_t eventCount() const { return _frames.size(); }
+
+  /// Check if a shape appears in the timeline.
+  /// @param routing_id The shape routing ID.
+  /// @param id The shape ID.
+  /// @return True if the shape has been created at any time.
+  [[nodiscard]] bool contains(uint16_t routing_id, uint32_t id) const;
+
+  /// Query the state of a shape at the end of @p frame .
+  /// @param routing_id The shape routing ID.
+  /// @param id The shape ID.
+  /// @param frame The frame of interest.
+  /// @return The shape state or an empty value if the shape does not exist at @p frame .
+  [[nodiscard]] std::optional<State> stateAt(uint16_t routing_id, uint32_t id,
+                                             uint32_t frame) const;
+
+  /// Collect the events for a shape in the frame range [ @p begin_frame , @p end_frame ).
+  ///
+  /// Combine with @c stateAt() to find the state at the start of the range.
+  /// @param routing_id The shape routing ID.
+  /// @param id The shape ID.
+  /// @param begin_frame The first frame of interest.
+  /// @param end_frame The frame after the last frame of interest.
+  /// @param[out] events Populated with the events in frame order. Cleared first.
+  /// @return The number of events added to @p events .
+  size_t events(uint16_t routing_id, uint32_t id, uint32_t begin_frame, uint32_t end_frame,
+                std::vector<Event> &events) const;
+
+private:
+  /// Resolve the event range [first, last) for a shape.
+  [[nodiscard]] bool eventRange(uint16_t routing_id, uint32_t id, uint32_t &first,
+                                uint32_t &last) const;
+  /// Extract the event at @p index .
+  [[nodiscard]] Event eventAt(uint32_t index) const;
+
+  /// Shape keys - routing ID and shape ID - sorted ascending.
+  std::vector<uint64_t> _keys;
+  /// Index of the first event for each shape, plus a trailing event count.
+  std::vector<uint32_t> _offsets;
+  /// Event columns.
+  std::vector<uint32_t> _frames;
+  std::vector<uint8_t> _types;
+  std::vector<std::array<float, 3>> _positions;
+  std::vector<std::array<float, 4>> _rotations;
+  std::vector<std::array<float, 3>> _scales;
+  std::vector<uint32_t> _colours;
+  uint32_t _frame_count = 0;
+};
+}  // namespace tes
@@ -0,0 +1,364 @@
+//
+// author: Kazys Stepanas
+//
+#include "SharedMemoryRing.h"
+
+#include "private/SharedMemoryDetail.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+namespace tes
+{
+namespace
+{
+constexpr uint32_t kRingMarker = 0x3e5517u;
+constexpr uint32_t kRingVersion = 1u;
+constexpr size_t kCacheLineSize = 64u;
+
+enum class PeerState : uint32_t
+{
+  /// No reader has attached.
+  None,
+  /// The peer is attached and active.
+  Attached,
+  /// The peer has closed.
+  Closed
+};
+
+/// Header for the ring, placed at the start of the shared memory block. The data buffer follows.
+///
+/// The read and write cursors are monotonic byte counts, wrapped by the capacity on access. Each
+/// cursor is on its own cache line to avoid false sharing between the reader and writer.
+struct RingHeader
+{
+  uint32_t marker = kRingMarker;
+  uint32_t version = kRingVersion;
+  uint64_t capacity = 0;
+  std::atomic_uint32_t writer_state = { static_cast<uint32_t>(PeerState::Attached) };
+  std::atomic_uint32_t writer_pid = { 0 };
+  std::atomic_uint32_t reader_state = { static_cast<uint32_t>(PeerState::None) };
+  std::atomic_uint32_t reader_pid = { 0 };
+
+  /// Total bytes written.
+  alignas(kCacheLineSize) std::atomic_uint64_t head = { 0 };
+  /// Doorbell for the reader, bumped after each write.
+  std::atomic_uint32_t data_seq = { 0 };
+  /// Set while the reader is blocked on @c data_seq .
+  std::atomic_uint32_t reader_waiting = { 0 };
+
+  /// Total bytes read.
+  alignas(kCacheLineSize) std::atomic_uint64_t tail = { 0 };
+  /// Doorbell for the writer, bumped after each read or on reader detach.
+  std::atomic_uint32_t space_seq = { 0 };
+  /// Set while the writer is blocked on @c space_seq .
+  std::atomic_uint32_t writer_waiting = { 0 };
+};
+
+static_assert(std::atomic_uint64_t::is_always_lock_free,
+              "Shared memory ring requires lock free 64-bit atomics");
+
+constexpr size_t kDataOffset =
+  (sizeof(RingHeader) + kCacheLineSize - 1u) / kCacheLineSize * kCacheLineSize;
+
+bool peerIs(const std::atomic_uint32_t &state, PeerState expected)
+{
+  return state.load(std::memory_order_acquire) == static_cast<uint32_t>(expected);
+}
+}  // namespace
+
+struct SharedMemoryRingDetail
+{
+  shm::Mapping mapping;
+  RingHeader *header = nullptr;
+  uint8_t *data = nullptr;
+  size_t capacity = 0;
+  bool writer = false;
+  /// Set by the reader once it has detected the writer has gone.
+  bool writer_lost = false;
+
+  ~SharedMemoryRingDetail() { shm::closeMapping(mapping); }
+};
+
+
+std::string SharedMemoryRing::nameForPort(uint16_t port)
+{
+  return "/3es-" + std::to_string(port);
+}
+
+
+std::unique_ptr<SharedMemoryRing> SharedMemoryRing::create(const std::string &name, size_t capacity)
+{
+  auto imp = std::make_unique<SharedMemoryRingDetail>();
+  const size_t page_size = shm::pageSize();
+  capacity = std::max(capacity, page_size);
+  capacity = (capacity + page_size - 1u) / page_size * page_size;
+  if (!shm::createMapping(imp->mapping, name, kDataOffset + capacity))
+  {
+    return nullptr;
+  }
+
+  imp->header = new (imp->mapping.memory) RingHeader();
+  imp->header->capacity = capacity;
+  imp->header->writer_pid = shm::processId();
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  imp->data = static_cast<uint8_t *>(imp->mapping.memory) + kDataOffset;
+  imp->capacity = capacity;
+  imp->writer = true;
+  return std::unique_ptr<SharedMemoryRing>(new SharedMemoryRing(std::move(imp)));
+}
+
+
+std::unique_ptr<SharedMemoryRing> SharedMemoryRing::open(const std::string &name)
+{
+  auto imp = std::make_unique<SharedMemoryRingDetail>();
+  if (!shm::openMapping(imp->mapping, name) || imp->mapping.size < kDataOffset)
+  {
+    return nullptr;
+  }
+
+  auto *header = static_cast<RingHeader *>(imp->mapping.memory);
+  if (header->marker != kRingMarker || header->version != kRingVersion ||
+      header->capacity > imp->mapping.size - kDataOffset)
+  {
+    return nullptr;
+  }
+
+  // Claim the reader slot.
+  auto expected = static_cast<uint32_t>(PeerState::None);
+  if (!header->reader_state.compare_exchange_strong(expected,
+                                                    static_cast<uint32_t>(PeerState::Attached)))
+  {
+    return nullptr;
+  }
+  header->reader_pid = shm::processId();
+
+  imp->header = header;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  imp->data = static_cast<uint8_t *>(imp->mapping.memory) + kDataOffset;
+  imp->capacity = header->capacity;
+  imp->writer = false;
+  return std::unique_ptr<SharedMemoryRing>(new SharedMemoryRing(std::move(imp)));
+}
+
+
+SharedMemoryRing::SharedMemoryRing(std::unique_ptr<SharedMemoryRingDetail> &&detail)
+  : _imp(std::move(detail))
+{}
+
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+  close();
+}
+
+
+bool SharedMemoryRing::isWriter() const
+{
+  return _imp->writer;
+}
+
+
+const std::string &SharedMemoryRing::name() const
+{
+  return _imp->mapping.name;
+}
+
+
+size_t SharedMemoryRing::capacity() const
+{
+  return _imp->capacity;
+}
+
+
+size_t SharedMemoryRing::pending() const
+{
+  if (!_imp->header)
+  {
+    return 0;
+  }
+  return static_cast<size_t>(_imp->header->head.load(std::memory_order_acquire) -
+                             _imp->header->tail.load(std::memory_order_acquire));
+}
+
+
+bool SharedMemoryRing::readerAttached() const
+{
+  return _imp->header && peerIs(_imp->header->reader_state, PeerState::Attached) &&
+         shm::processAlive(_imp->header->reader_pid);
+}
+
+
+bool SharedMemoryRing::isConnected() const
+{
+  if (!_imp->header)
+  {
+    return false;
+  }
+
+  if (_imp->writer)
+  {
+    return !peerIs(_imp->header->reader_state, PeerState::Closed);
+  }
+
+  const bool writer_gone =
+    _imp->writer_lost || peerIs(_imp->header->writer_state, PeerState::Closed);
+  return !writer_gone || pending() > 0;
+}
+
+
+int SharedMemoryRing::write(const uint8_t *data, int byte_count, unsigned timeout_ms)
+{
+  RingHeader *header = _imp->header;
+  if (!header || !_imp->writer || byte_count < 0 ||
+      static_cast<size_t>(byte_count) > _imp->capacity)
+  {
+    return -1;
+  }
+
+  const auto bytes = static_cast<uint64_t>(byte_count);
+  const uint64_t head = header->head.load(std::memory_order_relaxed);
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (_imp->capacity - (head - header->tail.load(std::memory_order_acquire)) < bytes)
+  {
+    if (!peerIs(header->reader_state, PeerState::Attached))
+    {
+      return -1;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline)
+    {
+      return -1;
+    }
+
+    // Announce we are waiting, then re-check before blocking so we cannot miss a wake.
+    const uint32_t seq = header->space_seq.load(std::memory_order_acquire);
+    header->writer_waiting.store(1u);
+    if (_imp->capacity - (head - header->tail.load()) < bytes)
+    {
+      const auto remaining_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+      shm::wait(header->space_seq, seq, static_cast<unsigned>(std::max<int64_t>(1, remaining_ms)));
+    }
+    header->writer_waiting.store(0u);
+  }
+
+  // Copy, wrapping around the end of the buffer.
+  const auto offset = static_cast<size_t>(head % _imp->capacity);
+  const size_t first = std::min(static_cast<size_t>(bytes), _imp->capacity - offset);
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(_imp->data + offset, data, first);
+  std::memcpy(_imp->data, data + first, static_cast<size_t>(bytes) - first);
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  header->head.store(head + bytes, std::memory_order_release);
+  header->data_seq.fetch_add(1u);
+  if (header->reader_waiting.load())
+  {
+    shm::wake(header->data_seq);
+  }
+
+  return byte_count;
+}
+
+
+int SharedMemoryRing::read(uint8_t *buffer, int buffer_length, unsigned timeout_ms)
+{
+  RingHeader *header = _imp->header;
+  if (!header || _imp->writer || buffer_length < 0)
+  {
+    return -1;
+  }
+
+  const uint64_t tail = header->tail.load(std::memory_order_relaxed);
+  uint64_t available = header->head.load(std::memory_order_acquire) - tail;
+  if (available == 0)
+  {
+    if (!isConnected())
+    {
+      return -1;
+    }
+
+    if (timeout_ms == 0)
+    {
+      return 0;
+    }
+
+    // Announce we are waiting, then re-check before blocking so we cannot miss a wake.
+    const uint32_t seq = header->data_seq.load(std::memory_order_acquire);
+    header->reader_waiting.store(1u);
+    available = header->head.load() - tail;
+    if (available == 0)
+    {
+      shm::wait(header->data_seq, seq, timeout_ms);
+      available = header->head.load(std::memory_order_acquire) - tail;
+    }
+    header->reader_waiting.store(0u);
+
+    if (available == 0)
+    {
+      // Timed out or spurious wake. Check the writer is still around.
+      if (!peerIs(header->writer_state, PeerState::Closed) &&
+          !shm::processAlive(header->writer_pid))
+      {
+        _imp->writer_lost = true;
+      }
+      return 0;
+    }
+  }
+
+  const auto bytes = static_cast<size_t>(std::min<uint64_t>(available, buffer_length));
+  const auto offset = static_cast<size_t>(tail % _imp->capacity);
+  const size_t first = std::min(bytes, _imp->capacity - offset);
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(buffer, _imp->data + offset, first);
+  std::memcpy(buffer + first, _imp->data, bytes - first);
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  header->tail.store(tail + bytes, std::memory_order_release);
+  header->space_seq.fetch_add(1u);
+  if (header->writer_waiting.load())
+  {
+    shm::wake(header->space_seq);
+  }
+
+  return static_cast<int>(bytes);
+}
+
+
+void SharedMemoryRing::unlink()
+{
+  shm::unlinkMapping(_imp->mapping);
+}
+
+
+void SharedMemoryRing::close()
+{
+  RingHeader *header = _imp->header;
+  if (!header)
+  {
+    return;
+  }
+
+  if (_imp->writer)
+  {
+    header->writer_state.store(static_cast<uint32_t>(PeerState::Closed));
+    header->data_seq.fetch_add(1u);
+    shm::wake(header->data_seq);
+  }
+  else
+  {
+    header->reader_state.store(static_cast<uint32_t>(PeerState::Closed));
+    header->space_seq.fetch_add(1u);
+    shm::wake(header->space_seq);
+  }
+
+  _imp->header = nullptr;
+  _imp->data = nullptr;
+  shm::closeMapping(_imp->mapping);
+}
+}  // namespace tes
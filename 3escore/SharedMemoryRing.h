@@ -0,0 +1,132 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include "CoreConfig.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace tes
+{
+struct SharedMemoryRingDetail;
+
+/// A single producer, single consumer byte ring buffer in named shared memory.
+///
+/// This supports a same host transport for 3es data, avoiding the kernel copies of a loopback TCP
+/// connection. The writer (server) @c create() s the named ring and the reader (client) @c open() s
+/// it by name. Data are copied directly into and out of the shared ring, with the cursors managed
+/// using lock free atomics.
+///
+/// Each side only makes a system call when it has to block: the reader waiting for data or the
+/// writer waiting for space. Blocking uses a futex doorbell in the shared ring header on Linux,
+/// falling back to a short sleep poll on other POSIX platforms.
+///
+/// A ring supports only one reader. A server accepts further same host clients by creating a new
+/// ring under the same name once the current one is attached; see @c unlink().
+///
+/// Shared memory rings are not supported on Windows; @c create() and @c open() fail there.
+///
+/// The @c isConnected() and @c readAvailable() methods mirror the @c TcpSocket API so the two may
+/// be used interchangeably by client read loops.
+class TES_CORE_API SharedMemoryRing
+{
+public:
+  /// Default ring capacity in bytes.
+  static constexpr size_t kDefaultCapacity = 16u * 1024u * 1024u;
+  /// Host name used by clients to select the shared memory transport rather than TCP.
+  static constexpr const char *kHostName = "shm";
+
+  /// Generate the default ring name for a server listening on @p port .
+  /// @param port The server's TCP listen port.
+  /// @return The shared memory name.
+  [[nodiscard]] static std::string nameForPort(uint16_t port);
+
+  /// Create a new ring for writing. Any stale ring of the same name is replaced.
+  /// @param name The shared memory name. See @c nameForPort() .
+  /// @param capacity The ring buffer capacity in bytes. Rounded up to the page size.
+  /// @return The ring or null on failure.
+  [[nodiscard]] static std::unique_ptr<SharedMemoryRing> create(const std::string &name,
+                                                                size_t capacity = kDefaultCapacity);
+
+  /// Open an existing ring for reading. Fails if the ring already has a reader attached.
+  /// @param name The shared memory name.
+  /// @return The ring or null on failure.
+  [[nodiscard]] static std::unique_ptr<SharedMemoryRing> open(const std::string &name);
+
+  SharedMemoryRing(const SharedMemoryRing &other) = delete;
+  /// Destructor, calling @c close() .
+  ~SharedMemoryRing();
+
+  SharedMemoryRing &operator=(const SharedMemoryRing &other) = delete;
+
+  /// Is this the writing end of the ring?
+  /// @return True for the ring created by @c create() .
+  [[nodiscard]] bool isWriter() const;
+
+  /// Query the shared memory name.
+  /// @return The ring name.
+  [[nodiscard]] const std::string &name() const;
+
+  /// Query the ring buffer capacity in bytes.
+  /// @return The capacity.
+  [[nodiscard]] size_t capacity() const;
+
+  /// Query the number of bytes currently available to read.
+  /// @return The number of bytes written, but not yet read.
+  [[nodiscard]] size_t pending() const;
+
+  /// Check if a reader is currently attached to the ring.
+  /// @return True when a live reader has attached and not yet detached.
+  [[nodiscard]] bool readerAttached() const;
+
+  /// Check whether the ring is still usable.
+  ///
+  /// For the writer, this is true until the reader detaches. For the reader, this is true until
+  /// the writer has closed (or exited) and all pending data have been read.
+  /// @return True while connected.
+  [[nodiscard]] bool isConnected() const;
+
+  /// Write @p byte_count bytes into the ring. The write is all or nothing.
+  ///
+  /// Blocks up to @p timeout_ms for space to become available.
+  ///
+  /// @param data The data to write.
+  /// @param byte_count Number of bytes in @p data .
+  /// @param timeout_ms Maximum time to wait for space.
+  /// @return @p byte_count on success, -1 on timeout, when there is no reader or on a write from
+  ///   the reading end.
+  int write(const uint8_t *data, int byte_count, unsigned timeout_ms);
+
+  /// Read up to @p buffer_length bytes from the ring.
+  ///
+  /// Blocks up to @p timeout_ms for data when the ring is empty.
+  ///
+  /// @param buffer The buffer to read into.
+  /// @param buffer_length The @p buffer capacity.
+  /// @param timeout_ms Maximum time to wait for data.
+  /// @return The number of bytes read, zero when none are available or -1 when disconnected.
+  int read(uint8_t *buffer, int buffer_length, unsigned timeout_ms);
+
+  /// Read available data without blocking. Mirrors @c TcpSocket::readAvailable() .
+  /// @param buffer The buffer to read into.
+  /// @param buffer_length The @p buffer capacity.
+  /// @return The number of bytes read, zero when none are available or -1 when disconnected.
+  int readAvailable(uint8_t *buffer, int buffer_length) { return read(buffer, buffer_length, 0); }
+
+  /// Remove the shared memory name so a new ring may be created under the same name. Existing
+  /// mappings, including this one, remain valid.
+  void unlink();
+
+  /// Close the ring, notifying the other end.
+  void close();
+
+private:
+  explicit SharedMemoryRing(std::unique_ptr<SharedMemoryRingDetail> &&detail);
+
+  std::unique_ptr<SharedMemoryRingDetail> _imp;
+};
+}  // namespace tes
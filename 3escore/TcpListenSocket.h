@@ -48,7 +48,7 @@ public:
   [[nodiscard]] bool isListening() const;
 
   /// Accepts the first pending connection. This will block for the
-  /// given timeout period.
+  /// given timeout period, or until @c wake() is called.
   /// @param timeout_ms The timeout to block for, awaiting new connections.
   /// @return A new @c TcpSocket representing the accepted connection,
   ///   or @c nullptr if there are not pending connections. The caller
@@ -56,6 +56,13 @@ public:
   ///   by invoking @c delete, or by calling @c releaseClient() (preferred).
   std::shared_ptr<TcpSocket> accept(unsigned timeout_ms = 0);
 
+  /// Wake a thread blocked in @c accept() , which returns without a connection. A wake while not
+  /// blocked in @c accept() causes the next @c accept() call to return immediately.
+  ///
+  /// May be called from any thread while listening. Not supported on Windows, where the blocked
+  /// @c accept() continues until its timeout expires.
+  void wake();
+
 private:
   std::unique_ptr<TcpListenSocketDetail> _detail;  ///< Implementation detail.
 };
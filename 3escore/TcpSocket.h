@@ -129,6 +129,14 @@ public:
     return readAvailable(reinterpret_cast<char *>(buffer), buffer_length);
   }
 
+  /// Waits until data are available to read, returning early when data arrive.
+  ///
+  /// This supports backing off from polling @c readAvailable() when a stream is idle without
+  /// blocking in a read call. A closed connection also ends the wait, as does an error.
+  /// @param timeout_ms The maximum time to wait (milliseconds).
+  /// @return True if data are available or the connection state has changed, false on timeout.
+  [[nodiscard]] bool waitForData(unsigned timeout_ms) const;
+
   /// Attempts to write data from the socket. This may block for the set write
   /// timeout.
   /// @param buffer The data buffer to send.
@@ -0,0 +1,192 @@
+//
+// author: Kazys Stepanas
+//
+#include "WriteBehindFile.h"
+
+#include "Log.h"
+
+#include <algorithm>
+
+namespace tes
+{
+WriteBehindFile::WriteBehindFile(size_t buffer_size, bool drop_when_full)
+  : _buffer_size(std::max<size_t>(buffer_size, 1u))
+  , _drop_when_full(drop_when_full)
+{}
+
+
+WriteBehindFile::~WriteBehindFile()
+{
+  close();
+}
+
+
+bool WriteBehindFile::open(const std::string &path)
+{
+  close();
+
+  _file.open(path, std::ios::binary | std::ios::out | std::ios::in | std::ios::trunc);
+  if (!_file.is_open())
+  {
+    return false;
+  }
+
+  const std::lock_guard<std::mutex> guard(_lock);
+  _fill.reserve(_buffer_size);
+  _pending.reserve(_buffer_size);
+  _stats = {};
+  _open = true;
+  _failed = false;
+  _thread = std::thread([this]() { run(); });
+  return true;
+}
+
+
+bool WriteBehindFile::isOpen() const
+{
+  const std::lock_guard<std::mutex> guard(_lock);
+  return _open;
+}
+
+
+bool WriteBehindFile::write(const void *data, size_t byte_count)
+{
+  std::unique_lock<std::mutex> lock(_lock);
+  if (!_open || _failed)
+  {
+    return false;
+  }
+
+  if (!_fill.empty() && _fill.size() + byte_count > _buffer_size)
+  {
+    // Hand the fill buffer to the writer thread, waiting for it to finish the last buffer.
+    if (!_pending.empty())
+    {
+      if (_drop_when_full)
+      {
+        _stats.bytes_dropped += byte_count;
+        return false;
+      }
+
+      const auto start_time = std::chrono::steady_clock::now();
+      _done_signal.wait(lock, [this]() { return _pending.empty() || _failed; });
+      _stats.stall_time += std::chrono::duration_cast<std::chrono::duration<double>>(
+                             std::chrono::steady_clock::now() - start_time)
+                             .count();
+      _stats.bytes_late += byte_count;
+    }
+
+    std::swap(_fill, _pending);
+    _work_signal.notify_one();
+  }
+
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  _fill.insert(_fill.end(), bytes, bytes + byte_count);
+  return !_failed;
+}
+
+
+void WriteBehindFile::flush()
+{
+  std::unique_lock<std::mutex> lock(_lock);
+  if (!_open)
+  {
+    return;
+  }
+
+  _flush_requested = true;
+  _work_signal.notify_one();
+  _done_signal.wait(lock, [this]() { return (_fill.empty() && _pending.empty()) || _failed; });
+}
+
+
+void WriteBehindFile::close(const std::function<void(std::fstream &)> &finalise)
+{
+  {
+    const std::lock_guard<std::mutex> guard(_lock);
+    if (!_open)
+    {
+      return;
+    }
+    _quit = true;
+    _work_signal.notify_one();
+  }
+
+  // The writer thread writes all pending data before quitting.
+  _thread.join();
+
+  _file.flush();
+  if (finalise)
+  {
+    finalise(_file);
+  }
+  _file.close();
+
+  const std::lock_guard<std::mutex> guard(_lock);
+  _open = false;
+  _quit = false;
+  _fill.clear();
+  _pending.clear();
+}
+
+
+WriteBehindFile::Stats WriteBehindFile::stats() const
+{
+  const std::lock_guard<std::mutex> guard(_lock);
+  return _stats;
+}
+
+
+bool WriteBehindFile::writeBytes(std::fstream &file, const uint8_t *data, size_t byte_count)
+{
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(byte_count));
+  return file.good();
+}
+
+
+void WriteBehindFile::run()
+{
+  std::unique_lock<std::mutex> lock(_lock);
+  for (;;)
+  {
+    _work_signal.wait_for(lock, kFlushInterval,
+                          [this]() { return _quit || _flush_requested || !_pending.empty(); });
+
+    // Take the fill buffer on a timeout, flush or quit.
+    if (_pending.empty())
+    {
+      std::swap(_fill, _pending);
+    }
+
+    if (_pending.empty())
+    {
+      _flush_requested = false;
+      _done_signal.notify_all();
+      if (_quit)
+      {
+        break;
+      }
+      continue;
+    }
+
+    // Write without the lock, so the next buffer can be filled meanwhile.
+    lock.unlock();
+    const bool ok = writeBytes(_file, _pending.data(), _pending.size());
+    lock.lock();
+
+    if (ok)
+    {
+      _stats.bytes_written += _pending.size();
+    }
+    else if (!_failed)
+    {
+      log::error("Write behind file write failure");
+      _failed = true;
+    }
+    _pending.clear();
+    _done_signal.notify_all();
+  }
+}
+}  // namespace tes
@@ -0,0 +1,128 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include "CoreConfig.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tes
+{
+/// A file writer which performs the file IO on a background thread, so slow storage does not stall
+/// the writing thread.
+///
+/// Data are written into a fill buffer, which is handed to the writer thread once full, on
+/// @c flush() or after @c kFlushInterval . The writer thread writes one buffer while the next is
+/// filled - double buffering. When the fill buffer is full while the writer thread is still busy,
+/// the caller either blocks until the writer catches up, counting the bytes as late, or drops the
+/// write when created with @c drop_when_full . Writes are dropped whole, so a write of a complete
+/// packet is either fully written or fully dropped.
+///
+/// Writes are expected from one thread at a time. @c stats() may be called from any thread.
+class TES_CORE_API WriteBehindFile
+{
+public:
+  /// Default size of each of the two buffers.
+  static constexpr size_t kDefaultBufferSize = 4u * 1024u * 1024u;
+  /// Maximum time data may sit in the fill buffer before being written.
+  static constexpr std::chrono::milliseconds kFlushInterval = std::chrono::milliseconds(200);
+
+  /// Write statistics.
+  struct Stats
+  {
+    /// Bytes written to the file.
+    uint64_t bytes_written = 0;
+    /// Bytes accepted, but which had to wait for the writer thread to make space.
+    uint64_t bytes_late = 0;
+    /// Bytes dropped because the writer thread was too slow. Only with @c drop_when_full .
+    uint64_t bytes_dropped = 0;
+    /// Total time spent blocked waiting for the writer thread (seconds).
+    double stall_time = 0;
+  };
+
+  /// Create a writer.
+  /// @param buffer_size The size of each buffer.
+  /// @param drop_when_full Drop writes rather than block when the writer thread falls behind.
+  explicit WriteBehindFile(size_t buffer_size = kDefaultBufferSize, bool drop_when_full = false);
+  WriteBehindFile(const WriteBehindFile &other) = delete;
+  /// Destructor. Closes the file, writing any pending data.
+  virtual ~WriteBehindFile();
+
+  WriteBehindFile &operator=(const WriteBehindFile &other) = delete;
+
+  /// Open @p path for writing, truncating any existing file, and start the writer thread.
+  /// @param path The file to write.
+  /// @return True on success.
+  bool open(const std::string &path);
+
+  /// Check if the file is open.
+  /// @return True while open.
+  [[nodiscard]] bool isOpen() const;
+
+  /// Write @p byte_count bytes from @p data .
+  /// @param data The data to write.
+  /// @param byte_count The number of bytes to write.
+  /// @return True if the data were accepted, false if the file is not open, a write failed or the
+  /// data were dropped.
+  bool write(const void *data, size_t byte_count);
+
+  /// Block until all data written so far have been written to the file.
+  void flush();
+
+  /// Write any pending data, stop the writer thread and close the file.
+  ///
+  /// @p finalise is called with the file after all the data have been written and before closing.
+  /// This supports rewriting header data, such as with @c streamutil::finaliseStream() . The file
+  /// is opened for reading and writing.
+  /// @param finalise Optional function to call before closing.
+  void close(const std::function<void(std::fstream &)> &finalise = {});
+
+  /// Query the write statistics.
+  /// @return The current statistics.
+  [[nodiscard]] Stats stats() const;
+
+protected:
+  /// Write @p byte_count bytes to @p file . Called on the writer thread without holding any locks.
+  ///
+  /// Derivations which override this function must call @c close() in their destructor to stop
+  /// the writer thread.
+  /// @param file The output file.
+  /// @param data The data to write.
+  /// @param byte_count The number of bytes to write.
+  /// @return True on success.
+  virtual bool writeBytes(std::fstream &file, const uint8_t *data, size_t byte_count);
+
+private:
+  /// Writer thread entry point.
+  void run();
+
+  mutable std::mutex _lock;
+  /// Signals the writer thread that data are ready, or on quit.
+  std::condition_variable _work_signal;
+  /// Signals writers that the writer thread has completed a buffer.
+  std::condition_variable _done_signal;
+  std::fstream _file;
+  /// Buffer being filled by @c write() .
+  std::vector<uint8_t> _fill;
+  /// Buffer handed to the writer thread. Empty while the writer thread is idle.
+  std::vector<uint8_t> _pending;
+  Stats _stats;
+  std::thread _thread;
+  size_t _buffer_size = kDefaultBufferSize;
+  bool _drop_when_full = false;
+  /// Set to request the writer thread take the fill buffer without waiting for it to fill.
+  bool _flush_requested = false;
+  bool _open = false;
+  bool _quit = false;
+  bool _failed = false;
+};
+}  // namespace tes
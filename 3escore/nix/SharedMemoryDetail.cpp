@@ -0,0 +1,176 @@
+//
+// author: Kazys Stepanas
+//
+#include "../private/SharedMemoryDetail.h"
+
+#include <cerrno>
+#include <chrono>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif  // __linux__
+
+namespace tes::shm
+{
+static_assert(sizeof(std::atomic_uint32_t) == sizeof(uint32_t) &&
+                std::atomic_uint32_t::is_always_lock_free,
+              "futex doorbell requires a plain 32-bit atomic");
+
+size_t pageSize()
+{
+  const long page_size = sysconf(_SC_PAGESIZE);
+  return (page_size > 0) ? static_cast<size_t>(page_size) : 4096u;
+}
+
+
+bool createMapping(Mapping &mapping, const std::string &name, size_t size)
+{
+  // Replace any stale mapping.
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+  {
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (memory == MAP_FAILED)  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+  {
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  mapping.name = name;
+  mapping.memory = memory;
+  mapping.size = size;
+  mapping.handle = fd;
+  mapping.owns_name = true;
+  return true;
+}
+
+
+bool openMapping(Mapping &mapping, const std::string &name)
+{
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat info = {};
+  if (fstat(fd, &info) != 0 || info.st_size <= 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  const auto size = static_cast<size_t>(info.st_size);
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (memory == MAP_FAILED)  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  mapping.name = name;
+  mapping.memory = memory;
+  mapping.size = size;
+  mapping.handle = fd;
+  mapping.owns_name = false;
+  return true;
+}
+
+
+void unlinkMapping(Mapping &mapping)
+{
+  if (mapping.owns_name)
+  {
+    shm_unlink(mapping.name.c_str());
+    mapping.owns_name = false;
+  }
+}
+
+
+void closeMapping(Mapping &mapping)
+{
+  unlinkMapping(mapping);
+  if (mapping.memory)
+  {
+    munmap(mapping.memory, mapping.size);
+    mapping.memory = nullptr;
+  }
+  if (mapping.handle >= 0)
+  {
+    ::close(static_cast<int>(mapping.handle));
+    mapping.handle = -1;
+  }
+  mapping.size = 0;
+}
+
+
+void wait(std::atomic_uint32_t &word, uint32_t expected, unsigned timeout_ms)
+{
+  if (word.load(std::memory_order_acquire) != expected || timeout_ms == 0)
+  {
+    return;
+  }
+#ifdef __linux__
+  struct timespec timeout = {};
+  timeout.tv_sec = static_cast<time_t>(timeout_ms / 1000u);
+  timeout.tv_nsec = static_cast<long>(timeout_ms % 1000u) * 1000000l;
+  // Not FUTEX_PRIVATE_FLAG: the word is shared between processes.
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &timeout, nullptr,
+          0);
+#else   // __linux__
+  // No portable cross process doorbell. Poll with a short sleep.
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (word.load(std::memory_order_acquire) == expected &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+#endif  // __linux__
+}
+
+
+void wake(std::atomic_uint32_t &word)
+{
+#ifdef __linux__
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr,
+          0);
+#else   // __linux__
+  (void)word;
+#endif  // __linux__
+}
+
+
+uint32_t processId()
+{
+  return static_cast<uint32_t>(getpid());
+}
+
+
+bool processAlive(uint32_t pid)
+{
+  return pid != 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+}  // namespace tes::shm
@@ -0,0 +1,55 @@
+//
+// author: Kazys Stepanas
+//
+#include "SharedMemoryConnection.h"
+
+#include <3escore/SharedMemoryRing.h>
+
+namespace tes
+{
+SharedMemoryConnection::SharedMemoryConnection(std::unique_ptr<SharedMemoryRing> ring,
+                                               uint16_t port, const ServerSettings &settings)
+  : BaseConnection(settings)
+  , _ring(std::move(ring))
+  , _port(port)
+{}
+
+
+SharedMemoryConnection::~SharedMemoryConnection()
+{
+  close();
+}
+
+
+void SharedMemoryConnection::close()
+{
+  if (_ring)
+  {
+    _ring->close();
+  }
+}
+
+
+const char *SharedMemoryConnection::address() const
+{
+  return (_ring) ? _ring->name().c_str() : "";
+}
+
+
+uint16_t SharedMemoryConnection::port() const
+{
+  return _port;
+}
+
+
+bool SharedMemoryConnection::isConnected() const
+{
+  return _ring && _ring->readerAttached();
+}
+
+
+int SharedMemoryConnection::writeBytes(const uint8_t *data, int byte_count)
+{
+  return _ring->write(data, byte_count, kWriteTimeoutMs);
+}
+}  // namespace tes
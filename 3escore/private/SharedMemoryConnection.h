@@ -0,0 +1,56 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include <3escore/Server.h>
+
+#include <3escore/BaseConnection.h>
+
+#include <memory>
+
+namespace tes
+{
+class SharedMemoryRing;
+
+/// A shared memory implementation of a 3es @c Connection for clients on the same host. Each
+/// @c SharedMemoryConnection writes to a @c SharedMemoryRing with a single attached reader.
+///
+/// These connections are created by the @c TcpConnectionMonitor when the server is created with
+/// @c SFSharedMemory .
+class SharedMemoryConnection final : public BaseConnection
+{
+public:
+  /// Maximum time to block waiting for the reader to make space in the ring (milliseconds).
+  static constexpr unsigned kWriteTimeoutMs = 1000u;
+
+  /// Create a new connection writing to @p ring .
+  /// @param ring The ring to write to. Must have a reader attached.
+  /// @param port The server listen port from which the ring name was derived.
+  /// @param settings Various server settings to initialise with.
+  SharedMemoryConnection(std::unique_ptr<SharedMemoryRing> ring, uint16_t port,
+                         const ServerSettings &settings);
+
+  SharedMemoryConnection(const SharedMemoryConnection &other) = delete;
+
+  /// Destructor.
+  ~SharedMemoryConnection() final;
+
+  SharedMemoryConnection &operator=(const SharedMemoryConnection &other) = delete;
+
+  /// Close the ring.
+  void close() final;
+
+  /// Reports the shared memory name.
+  const char *address() const final;
+  uint16_t port() const final;
+  bool isConnected() const final;
+
+protected:
+  int writeBytes(const uint8_t *data, int byte_count) final;
+
+private:
+  std::unique_ptr<SharedMemoryRing> _ring;
+  uint16_t _port = 0;
+};
+}  // namespace tes
@@ -0,0 +1,75 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include <3escore/CoreConfig.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tes::shm
+{
+/// A named shared memory mapping. Platform specific.
+struct Mapping
+{
+  /// The shared memory name.
+  std::string name;
+  /// Mapped memory. Null when not mapped.
+  void *memory = nullptr;
+  /// Size of the mapping in bytes.
+  size_t size = 0;
+  /// Platform handle.
+  intptr_t handle = -1;
+  /// True while the name is linked and was created by this mapping.
+  bool owns_name = false;
+};
+
+/// Query the system page size.
+/// @return The page size in bytes.
+size_t pageSize();
+
+/// Create a new named mapping of @p size bytes, replacing any existing mapping of the same name.
+/// @param mapping The mapping to initialise.
+/// @param name The shared memory name.
+/// @param size The mapping size.
+/// @return True on success.
+bool createMapping(Mapping &mapping, const std::string &name, size_t size);
+
+/// Open and map an existing named mapping.
+/// @param mapping The mapping to initialise.
+/// @param name The shared memory name.
+/// @return True on success.
+bool openMapping(Mapping &mapping, const std::string &name);
+
+/// Remove the name for @p mapping if it owns the name. The mapping remains valid.
+/// @param mapping The mapping.
+void unlinkMapping(Mapping &mapping);
+
+/// Unmap @p mapping and release the handle.
+/// @param mapping The mapping.
+void closeMapping(Mapping &mapping);
+
+/// Block while @p word equals @p expected or until @p timeout_ms elapses. May wake spuriously.
+///
+/// @p word must be in shared memory to wake across processes.
+/// @param word The doorbell word.
+/// @param expected The value to wait on.
+/// @param timeout_ms Maximum time to wait.
+void wait(std::atomic_uint32_t &word, uint32_t expected, unsigned timeout_ms);
+
+/// Wake all waiters on @p word .
+/// @param word The doorbell word.
+void wake(std::atomic_uint32_t &word);
+
+/// Query the current process ID.
+/// @return The process ID.
+uint32_t processId();
+
+/// Check if process @p pid is still running.
+/// @param pid The process ID.
+/// @return True if the process is alive.
+bool processAlive(uint32_t pid);
+}  // namespace tes::shm
@@ -0,0 +1,163 @@
+//
+// author: Kazys Stepanas
+//
+#include "StateCache.h"
+
+#include <3escore/Connection.h>
+#include <3escore/Messages.h>
+#include <3escore/PacketReader.h>
+#include <3escore/Resource.h>
+#include <3escore/shapes/Shape.h>
+
+namespace tes
+{
+void StateCache::create(const Shape &shape)
+{
+  if (shape.isTransient())
+  {
+    return;
+  }
+
+  auto &entry = _state.shapes[shapeKey(shape)];
+  entry.shape = shape.clone();
+  entry.generation = _next_generation++;
+}
+
+
+void StateCache::update(const Shape &shape)
+{
+  const auto search = _state.shapes.find(shapeKey(shape));
+  if (search == _state.shapes.end())
+  {
+    return;
+  }
+
+  auto &entry = search->second;
+  if (entry.shape.use_count() > 1)
+  {
+    // Shared with a state copy. Copy on write.
+    entry.shape = entry.shape->clone();
+  }
+  entry.shape->updateFrom(shape);
+}
+
+
+void StateCache::destroy(const Shape &shape)
+{
+  _state.shapes.erase(shapeKey(shape));
+}
+
+
+void StateCache::send(const uint8_t *data, int byte_count)
+{
+  if (!data || byte_count < static_cast<int>(sizeof(PacketHeader)))
+  {
+    return;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  PacketReader reader(reinterpret_cast<const PacketHeader *>(data));
+  if (reader.marker() != kPacketMarker || reader.routingId() != MtCategory ||
+      reader.messageId() != CategoryNameMessage::MessageId ||
+      reader.packetSize() > static_cast<unsigned>(byte_count))
+  {
+    return;
+  }
+
+  // The category ID leads the message payload.
+  uint16_t category_id = 0;
+  if (reader.readElement(category_id) != sizeof(category_id))
+  {
+    return;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  _state.categories[category_id].assign(data, data + reader.packetSize());
+}
+
+
+void StateCache::referenceResource(const ResourcePtr &resource)
+{
+  auto &entry = _state.resources[resource->uniqueKey()];
+  entry.resource = resource;
+  ++entry.reference_count;
+}
+
+
+void StateCache::releaseResource(const ResourcePtr &resource)
+{
+  const auto search = _state.resources.find(resource->uniqueKey());
+  if (search != _state.resources.end() && --search->second.reference_count == 0)
+  {
+    _state.resources.erase(search);
+  }
+}
+
+
+bool StateCache::replay(Connection &connection, const State &from, const State &to)
+{
+  bool ok = true;
+
+  for (const auto &[category_id, packet] : to.categories)
+  {
+    const auto search = from.categories.find(category_id);
+    if (search == from.categories.end() || search->second != packet)
+    {
+      ok = connection.send(packet.data(), static_cast<int>(packet.size()), true) >= 0 && ok;
+    }
+  }
+
+  for (const auto &[key, entry] : to.resources)
+  {
+    const auto search = from.resources.find(key);
+    unsigned reference_count =
+      (search != from.resources.end()) ? search->second.reference_count : 0u;
+    for (; reference_count < entry.reference_count; ++reference_count)
+    {
+      connection.referenceResource(entry.resource);
+    }
+  }
+
+  for (const auto &[key, entry] : from.resources)
+  {
+    const auto search = to.resources.find(key);
+    unsigned reference_count =
+      (search != to.resources.end()) ? search->second.reference_count : 0u;
+    for (; reference_count < entry.reference_count; ++reference_count)
+    {
+      connection.releaseResource(entry.resource);
+    }
+  }
+
+  // Destroy removed and re-created shapes before creating new shapes.
+  for (const auto &[key, entry] : from.shapes)
+  {
+    const auto search = to.shapes.find(key);
+    if (search == to.shapes.end() || search->second.generation != entry.generation)
+    {
+      ok = connection.destroy(*entry.shape) >= 0 && ok;
+    }
+  }
+
+  for (const auto &[key, entry] : to.shapes)
+  {
+    const auto search = from.shapes.find(key);
+    if (search == from.shapes.end() || search->second.generation != entry.generation)
+    {
+      ok = connection.create(*entry.shape) >= 0 && ok;
+    }
+    else if (search->second.shape != entry.shape)
+    {
+      ok = connection.update(*entry.shape) >= 0 && ok;
+    }
+  }
+
+  return ok;
+}
+
+
+uint64_t StateCache::shapeKey(const Shape &shape)
+{
+  return objectKey(shape.routingId(), shape.id());
+}
+}  // namespace tes
@@ -0,0 +1,112 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include <3escore/CoreConfig.h>
+
+#include <3escore/Ptr.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace tes
+{
+class Connection;
+class Resource;
+class Shape;
+
+/// Tracks the live, persistent state of a @c TcpServer so it can be replayed to new connections.
+///
+/// The cache holds a copy of each non-transient shape, maintained using @c Shape::updateFrom() ,
+/// the latest encoded category message for each category and the explicitly referenced resources.
+/// The @c State is copy on write: copying it is shallow and later changes to the cache do not
+/// affect the copy. This allows a replay to proceed from a copy while the cache continues to
+/// change, then to catch up using @c replay() with the copy and the latest state.
+///
+/// Not threadsafe. The @c TcpServer guards access.
+class StateCache
+{
+public:
+  using ResourcePtr = Ptr<const Resource>;
+
+  /// A cached shape.
+  struct ShapeEntry
+  {
+    /// Copy of the shape. Replaced, rather than modified, while shared with a @c State copy.
+    std::shared_ptr<Shape> shape;
+    /// Identifies the create call which added the shape, distinguishing re-created shapes.
+    uint64_t generation = 0;
+  };
+
+  /// An explicitly referenced resource.
+  struct ResourceEntry
+  {
+    ResourcePtr resource;
+    unsigned reference_count = 0;
+  };
+
+  /// The cached state.
+  struct State
+  {
+    /// Shapes keyed by routing ID and shape ID. See @c shapeKey() .
+    std::unordered_map<uint64_t, ShapeEntry> shapes;
+    /// Encoded @c CategoryNameMessage packets keyed by category ID. Ordered so parent categories
+    /// are generally defined first.
+    std::map<uint16_t, std::vector<uint8_t>> categories;
+    /// Resources keyed by @c Resource::uniqueKey() .
+    std::unordered_map<uint64_t, ResourceEntry> resources;
+  };
+
+  /// Track the creation of @p shape . Transient shapes are ignored.
+  /// @param shape The created shape.
+  void create(const Shape &shape);
+  /// Track an update to @p shape .
+  /// @param shape The updated shape.
+  void update(const Shape &shape);
+  /// Track the destruction of @p shape .
+  /// @param shape The destroyed shape.
+  void destroy(const Shape &shape);
+
+  /// Inspect a raw packet sent by the server, caching category definitions. Other packets are
+  /// ignored, as are collated packets.
+  /// @param data The packet data.
+  /// @param byte_count The number of bytes in @p data .
+  void send(const uint8_t *data, int byte_count);
+
+  /// Track an explicit resource reference.
+  /// @param resource The referenced resource.
+  void referenceResource(const ResourcePtr &resource);
+  /// Track an explicit resource release.
+  /// @param resource The released resource.
+  void releaseResource(const ResourcePtr &resource);
+
+  /// Access the current state. Copy to take a snapshot.
+  /// @return The cached state.
+  [[nodiscard]] const State &state() const { return _state; }
+
+  /// Clear the cache.
+  void clear() { _state = {}; }
+
+  /// Send the messages required to bring @p connection from state @p from to state @p to .
+  ///
+  /// Categories are sent first, then resources, then shapes.
+  /// @param connection The connection to write to.
+  /// @param from The state the connection currently reflects. Empty for a new connection.
+  /// @param to The target state.
+  /// @return True on success, false if any message failed to send.
+  static bool replay(Connection &connection, const State &from, const State &to);
+
+  /// Generate the @c State::shapes key for @p shape . See @c objectKey() .
+  /// @param shape The shape of interest.
+  /// @return The shape key.
+  [[nodiscard]] static uint64_t shapeKey(const Shape &shape);
+
+private:
+  State _state;
+  uint64_t _next_generation = 1;
+};
+}  // namespace tes
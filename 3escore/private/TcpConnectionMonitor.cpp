@@ -3,12 +3,14 @@
 //
 #include "TcpConnectionMonitor.h"
 
+#include "SharedMemoryConnection.h"
 #include "TcpConnection.h"
 #include "TcpServer.h"
 
 #include <3escore/CoreUtil.h>
 #include <3escore/FileConnection.h>
 #include <3escore/Log.h>
+#include <3escore/SharedMemoryRing.h>
 #include <3escore/TcpListenSocket.h>
 #include <3escore/TcpSocket.h>
 
@@ -123,9 +125,16 @@ void TcpConnectionMonitor::stop()
     _mode = ConnectionMode::None;
     break;
 
-  case ConnectionMode::Asynchronous:
+  case ConnectionMode::Asynchronous: {
+    const std::lock_guard<Lock> guard(_listen_lock);
     _quit_flag = true;
+    // Wake the monitor thread from waiting on new connections.
+    if (_listen)
+    {
+      _listen->wake();
+    }
     break;
+  }
 
   default:
     break;
@@ -203,6 +212,12 @@ int TcpConnectionMonitor::waitForConnection(unsigned timeout_ms)
 
 
 void TcpConnectionMonitor::monitorConnections()
+{
+  monitorConnections(0);
+}
+
+
+void TcpConnectionMonitor::monitorConnections(unsigned accept_timeout_ms)
 {
   // Lock for connection expiry.
   std::unique_lock<Lock> lock(_connection_lock);
@@ -219,6 +234,7 @@ void TcpConnectionMonitor::monitorConnections()
     {
       _expired.push_back(connection);
       iter = _connections.erase(iter);
+      _connections_changed = true;
     }
   }
 
@@ -228,7 +244,7 @@ void TcpConnectionMonitor::monitorConnections()
   // Look for new connections.
   if (_listen)
   {
-    if (auto new_socket = _listen->accept(0))
+    if (auto new_socket = _listen->accept(accept_timeout_ms))
     {
       // Options to try and reduce socket latency.
       // Attempt to prevent periodic latency on osx.
@@ -242,18 +258,36 @@ void TcpConnectionMonitor::monitorConnections()
 #endif  // __apple__
 
       auto new_connection = std::make_shared<TcpConnection>(new_socket, _server.settings());
+      new_connection->setResourceCache(_server.resourceCache());
       // Lock for new connection.
       lock.lock();
       _connections.push_back(new_connection);
+      _connections_changed = true;
       lock.unlock();
     }
   }
+
+  // Look for a same host reader on the shared memory ring.
+  if (_shm_listen && _shm_listen->readerAttached())
+  {
+    // Release the name so we can listen for the next reader.
+    _shm_listen->unlink();
+    auto new_connection = std::make_shared<SharedMemoryConnection>(
+      std::move(_shm_listen), _listen_port, _server.settings());
+    new_connection->setResourceCache(_server.resourceCache());
+    lock.lock();
+    _connections.push_back(new_connection);
+    _connections_changed = true;
+    lock.unlock();
+    listenSharedMemory();
+  }
 }
 
 
 std::shared_ptr<Connection> TcpConnectionMonitor::openFileStream(const std::string &file_path)
 {
   auto new_connection = std::make_shared<FileConnection>(file_path, _server.settings());
+  new_connection->setResourceCache(_server.resourceCache());
   if (!new_connection->isConnected())
   {
     return nullptr;
@@ -261,6 +295,7 @@ std::shared_ptr<Connection> TcpConnectionMonitor::openFileStream(const std::stri
 
   const std::unique_lock<Lock> lock(_connection_lock);
   _connections.push_back(new_connection);
+  _connections_changed = true;
   return new_connection;
 }
 
@@ -289,13 +324,18 @@ const std::function<void(Server &, Connection &)> &TcpConnectionMonitor::connect
 
 void TcpConnectionMonitor::commitConnections()
 {
+  // Called every frame in asynchronous mode. Avoid locking when there is nothing to commit.
+  if (!_connections_changed.exchange(false))
+  {
+    return;
+  }
+
   std::unique_lock<Lock> lock(_connection_lock);
   _server.updateConnections(_connections, _on_new_connection);
-
+  // Take the expired connections to delete them outside the lock.
+  std::vector<std::shared_ptr<Connection>> expired;
+  expired.swap(_expired);
   lock.unlock();
-
-  // Delete expired connections.
-  _expired.clear();
 }
 
 
@@ -306,7 +346,10 @@ bool TcpConnectionMonitor::listen()
     return true;
   }
 
-  _listen = std::make_unique<TcpListenSocket>();
+  {
+    const std::lock_guard<Lock> guard(_listen_lock);
+    _listen = std::make_unique<TcpListenSocket>();
+  }
 
   bool listening = false;
 
@@ -318,10 +361,26 @@ bool TcpConnectionMonitor::listen()
 
   _listen_port = (listening) ? _listen->port() : 0;
 
+  if (listening && (_server.flags() & SFSharedMemory))
+  {
+    listenSharedMemory();
+  }
+
   return listening;
 }
 
 
+void TcpConnectionMonitor::listenSharedMemory()
+{
+  const std::string name = SharedMemoryRing::nameForPort(_listen_port);
+  _shm_listen = SharedMemoryRing::create(name);
+  if (!_shm_listen)
+  {
+    log::warn("Failed to create shared memory ring ", name);
+  }
+}
+
+
 void TcpConnectionMonitor::stopListening()
 {
   _listen_port = 0;
@@ -332,6 +391,8 @@ void TcpConnectionMonitor::stopListening()
     con->close();
   }
 
+  _shm_listen.reset();
+  const std::lock_guard<Lock> guard(_listen_lock);
   _listen.reset();
 }
 
@@ -346,11 +407,11 @@ void TcpConnectionMonitor::monitorThread()
   }
   _running = true;
 
-  const unsigned sleep_ms = 50;
+  // Block on accepting new connections, so they are accepted as soon as they arrive. The timeout
+  // bounds the interval for the other checks. stop() wakes the wait.
   while (!_quit_flag)
   {
-    monitorConnections();
-    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+    monitorConnections(kMonitorIntervalMs);
   }
 
   _running = false;
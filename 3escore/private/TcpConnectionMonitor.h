@@ -15,6 +15,7 @@
 namespace tes
 {
 class BaseConnection;
+class SharedMemoryRing;
 class TcpServer;
 class TcpListenSocket;
 
@@ -154,12 +155,23 @@ public:
   void commitConnections() final;
 
 private:
+  /// Interval between checks for expired connections and shared memory readers in asynchronous
+  /// mode. New TCP connections are accepted as they arrive.
+  static constexpr unsigned kMonitorIntervalMs = 50u;
+
+  /// Implementation of @c monitorConnections() , blocking for up to @p accept_timeout_ms awaiting
+  /// a new TCP connection.
+  /// @param accept_timeout_ms Time to wait for a new connection (milliseconds).
+  void monitorConnections(unsigned accept_timeout_ms);
   bool listen();
+  void listenSharedMemory();
   void stopListening();
   void monitorThread();
 
   TcpServer &_server;
   std::unique_ptr<TcpListenSocket> _listen;
+  /// Ring waiting for a same host reader to attach. Only with @c SFSharedMemory .
+  std::unique_ptr<SharedMemoryRing> _shm_listen;
   std::function<void(Server &, Connection &)> _on_new_connection;
   ConnectionMode _mode = ConnectionMode::None;  ///< Current execution mode.
   std::vector<std::shared_ptr<Connection>> _connections;
@@ -168,7 +180,12 @@ private:
   std::atomic_uint16_t _listen_port = { 0 };
   std::atomic_bool _running = { false };
   std::atomic_bool _quit_flag = { false };
+  /// Set when @c _connections changes, so @c commitConnections() can skip updating the server
+  /// when nothing has changed.
+  std::atomic_bool _connections_changed = { false };
   mutable Lock _connection_lock;
+  /// Guards replacing @c _listen against @c stop() waking it from another thread.
+  Lock _listen_lock;
   std::unique_ptr<std::thread> _thread;
 };
 }  // namespace tes
@@ -6,13 +6,26 @@
 #include "TcpConnection.h"
 #include "TcpConnectionMonitor.h"
 
+#include <3escore/BaseConnection.h>
 #include <3escore/PacketWriter.h>
+#include <3escore/ResourcePacketCache.h>
+#include <3escore/ShapeRegistry.h>
+
+#include "StateCache.h"
+#include "UpdateTracker.h"
 
 #include <algorithm>
+#include <chrono>
 #include <mutex>
 
 namespace tes
 {
+namespace
+{
+/// Minimum interval between checks for aged collated packets (microseconds).
+constexpr uint32_t kMinFlushIntervalUs = 100u;
+}  // namespace
+
 std::shared_ptr<Server> Server::create(const ServerSettings &settings,
                                        const ServerInfoMessage *server_info)
 {
@@ -22,20 +35,40 @@ std::shared_ptr<Server> Server::create(const ServerSettings &settings,
 
 TcpServer::TcpServer(const ServerSettings &settings, const ServerInfoMessage *server_info)
   : _monitor(nullptr)
+  , _resource_cache(std::make_shared<ResourcePacketCache>(settings.resourcePacketSize(),
+                                                            settings.progressivePointCount()))
   , _settings(settings)
   , _server_info(server_info ? *server_info : ServerInfoMessage())
   , _active(true)
 {
   _monitor = std::make_shared<TcpConnectionMonitor>(*this);
+  if (settings.flags & SFStateCache)
+  {
+    _state_cache = std::make_unique<StateCache>();
+  }
+  if (settings.flags & SFDeltaUpdates)
+  {
+    _update_tracker =
+      std::make_unique<UpdateTracker>(settings.update_tolerance, settings.client_buffer_size);
+  }
 
   if (!server_info)
   {
     initDefaultServerInfo(&_server_info);
   }
+
+  if ((settings.flags & SFCollate) && settings.flush_policy.max_age_us)
+  {
+    _flush_thread = std::thread([this]() { flushThread(); });
+  }
 }
 
 
-TcpServer::~TcpServer() = default;
+TcpServer::~TcpServer()
+{
+  stopFlushThread();
+  joinReplays();
+}
 
 
 unsigned TcpServer::flags() const
@@ -48,10 +81,10 @@ void TcpServer::close()
 {
   _monitor->stop();
   _monitor->join();
+  stopFlushThread();
+  joinReplays();
 
-  const std::lock_guard<Lock> guard(_lock);
-
-  for (const auto &con : _connections)
+  for (const auto &con : *connections())
   {
     con->close();
   }
@@ -84,8 +117,7 @@ uint16_t TcpServer::port() const
 
 bool TcpServer::isConnected() const
 {
-  const std::lock_guard<Lock> guard(_lock);
-  return !_connections.empty();
+  return !connections()->empty();
 }
 
 
@@ -96,11 +128,24 @@ int TcpServer::create(const Shape &shape)
     return 0;
   }
 
-  const std::lock_guard<Lock> guard(_lock);
+  const auto guard = lockState();
+  const auto connections = this->connections();
+  if (_state_cache)
+  {
+    _state_cache->create(shape);
+  }
+  if (_update_tracker)
+  {
+    _update_tracker->create(shape);
+  }
   int transferred = 0;
   bool error = false;
-  for (const auto &con : _connections)
+  for (const auto &con : *connections)
   {
+    if (!isLive(*con))
+    {
+      continue;
+    }
     const int txc = con->create(shape);
     if (txc >= 0)
     {
@@ -123,11 +168,24 @@ int TcpServer::destroy(const Shape &shape)
     return 0;
   }
 
-  const std::lock_guard<Lock> guard(_lock);
+  const auto guard = lockState();
+  const auto connections = this->connections();
+  if (_state_cache)
+  {
+    _state_cache->destroy(shape);
+  }
+  if (_update_tracker)
+  {
+    _update_tracker->destroy(shape);
+  }
   int transferred = 0;
   bool error = false;
-  for (const auto &con : _connections)
+  for (const auto &con : *connections)
   {
+    if (!isLive(*con))
+    {
+      continue;
+    }
     const int txc = con->destroy(shape);
     if (txc >= 0)
     {
@@ -150,12 +208,39 @@ int TcpServer::update(const Shape &shape)
     return 0;
   }
 
-  const std::lock_guard<Lock> guard(_lock);
+  const auto guard = lockState();
+  const auto connections = this->connections();
+  if (_state_cache)
+  {
+    _state_cache->update(shape);
+  }
+
+  // With delta updates, encode the changed attributes once and send the same packet to each
+  // connection.
+  const PacketWriter *delta = nullptr;
+  if (_update_tracker)
+  {
+    switch (_update_tracker->update(shape))
+    {
+    case UpdateTracker::Result::Unchanged:
+      return 0;
+    case UpdateTracker::Result::Changed:
+      delta = &_update_tracker->packet();
+      break;
+    case UpdateTracker::Result::Untracked:
+      break;
+    }
+  }
+
   int transferred = 0;
   bool error = false;
-  for (const auto &con : _connections)
+  for (const auto &con : *connections)
   {
-    const int txc = con->update(shape);
+    if (!isLive(*con))
+    {
+      continue;
+    }
+    const int txc = (delta) ? con->send(*delta, true) : con->update(shape);
     if (txc >= 0)
     {
       transferred += txc;
@@ -177,11 +262,41 @@ int TcpServer::updateFrame(float dt, bool flush)
     return 0;
   }
 
-  std::unique_lock<Lock> guard(_lock);
+  auto guard = lockState();
+  const auto connections = this->connections();
   int transferred = 0;
   bool error = false;
-  for (const auto &con : _connections)
+
+  // Encode registry changes once, sending each packet to all connections. Registry shapes are
+  // created directly on new connections, so this includes connections which are still replaying
+  // the state cache.
+  const bool compact_updates = (_settings.flags & SFDeltaUpdates) != 0;
+  for (const auto &registry : *std::atomic_load(&_registries))
+  {
+    registry->encode(
+      [&connections, &transferred, &error](const uint8_t *data, uint32_t byte_count) {
+        for (const auto &con : *connections)
+        {
+          const int txc = con->send(data, byte_count, true);
+          if (txc >= 0)
+          {
+            transferred += txc;
+          }
+          else
+          {
+            error = true;
+          }
+        }
+      },
+      compact_updates);
+  }
+
+  for (const auto &con : *connections)
   {
+    if (!isLive(*con))
+    {
+      continue;
+    }
     const int txc = con->updateFrame(dt, flush);
     if (txc >= 0)
     {
@@ -201,7 +316,10 @@ int TcpServer::updateFrame(float dt, bool flush)
   // generate create messages in the callback for objects which have buffered
   // create messages. Alternatively, if the server is not in collated mode, the
   // we'll get different behaviour between collated and uncollated modes.
-  guard.unlock();
+  if (guard.owns_lock())
+  {
+    guard.unlock();
+  }
   if (_monitor->mode() == ConnectionMode::Asynchronous)
   {
     _monitor->commitConnections();
@@ -218,11 +336,16 @@ int TcpServer::updateTransfers(unsigned byte_limit)
     return 0;
   }
 
-  const std::lock_guard<Lock> guard(_lock);
+  const auto guard = lockState();
+  const auto connections = this->connections();
   int transferred = 0;
   bool error = false;
-  for (const auto &con : _connections)
+  for (const auto &con : *connections)
   {
+    if (!isLive(*con))
+    {
+      continue;
+    }
     const int txc = con->updateTransfers(byte_limit);
     if (txc >= 0)
     {
@@ -252,10 +375,19 @@ unsigned TcpServer::referenceResource(const ResourcePtr &resource)
     return 0;
   }
 
-  const std::lock_guard<Lock> guard(_lock);
+  const auto guard = lockState();
+  const auto connections = this->connections();
+  if (_state_cache)
+  {
+    _state_cache->referenceResource(resource);
+  }
   unsigned last_count = 0;
-  for (const auto &con : _connections)
+  for (const auto &con : *connections)
   {
+    if (!isLive(*con))
+    {
+      continue;
+    }
     last_count = con->referenceResource(resource);
   }
   return last_count;
@@ -269,10 +401,19 @@ unsigned TcpServer::releaseResource(const ResourcePtr &resource)
     return 0;
   }
 
-  const std::lock_guard<Lock> guard(_lock);
+  const auto guard = lockState();
+  const auto connections = this->connections();
+  if (_state_cache)
+  {
+    _state_cache->releaseResource(resource);
+  }
   unsigned last_count = 0;
-  for (const auto &con : _connections)
+  for (const auto &con : *connections)
   {
+    if (!isLive(*con))
+    {
+      continue;
+    }
     last_count = con->releaseResource(resource);
   }
   return last_count;
@@ -294,9 +435,14 @@ int TcpServer::send(const CollatedPacket &collated)
 
   int sent = 0;
   bool failed = false;
-  const std::lock_guard<Lock> guard(_lock);
-  for (const auto &con : _connections)
+  const auto guard = lockState();
+  const auto connections = this->connections();
+  for (const auto &con : *connections)
   {
+    if (!isLive(*con))
+    {
+      continue;
+    }
     sent = con->send(collated);
     if (sent == -1)
     {
@@ -317,9 +463,18 @@ int TcpServer::send(const uint8_t *data, int byte_count, bool allow_collation)
 
   int sent = 0;
   bool failed = false;
-  const std::lock_guard<Lock> guard(_lock);
-  for (const auto &con : _connections)
+  const auto guard = lockState();
+  const auto connections = this->connections();
+  if (_state_cache)
+  {
+    _state_cache->send(data, byte_count);
+  }
+  for (const auto &con : *connections)
   {
+    if (!isLive(*con))
+    {
+      continue;
+    }
     sent = con->send(data, byte_count, allow_collation);
     if (sent == -1)
     {
@@ -339,17 +494,16 @@ std::shared_ptr<ConnectionMonitor> TcpServer::connectionMonitor()
 
 unsigned TcpServer::connectionCount() const
 {
-  const std::lock_guard<Lock> guard(_lock);
-  return static_cast<unsigned>(_connections.size());
+  return static_cast<unsigned>(connections()->size());
 }
 
 
 std::shared_ptr<Connection> TcpServer::connection(unsigned index)
 {
-  const std::lock_guard<Lock> guard(_lock);
-  if (index < _connections.size())
+  const auto connections = this->connections();
+  if (index < connections->size())
   {
-    return _connections[index];
+    return (*connections)[index];
   }
   return {};
 }
@@ -357,15 +511,37 @@ std::shared_ptr<Connection> TcpServer::connection(unsigned index)
 
 std::shared_ptr<const Connection> TcpServer::connection(unsigned index) const
 {
-  const std::lock_guard<Lock> guard(_lock);
-  if (index < _connections.size())
+  const auto connections = this->connections();
+  if (index < connections->size())
   {
-    return _connections[index];
+    return (*connections)[index];
   }
   return {};
 }
 
 
+void TcpServer::addRegistry(const std::shared_ptr<ShapeRegistry> &registry)
+{
+  const std::lock_guard<Lock> guard(_lock);
+  const auto registries = std::atomic_load(&_registries);
+  if (registry && std::find(registries->begin(), registries->end(), registry) == registries->end())
+  {
+    auto updated = std::make_shared<RegistryList>(*registries);
+    updated->emplace_back(registry);
+    std::atomic_store(&_registries, std::shared_ptr<const RegistryList>(std::move(updated)));
+  }
+}
+
+
+void TcpServer::removeRegistry(const std::shared_ptr<ShapeRegistry> &registry)
+{
+  const std::lock_guard<Lock> guard(_lock);
+  auto updated = std::make_shared<RegistryList>(*std::atomic_load(&_registries));
+  updated->erase(std::remove(updated->begin(), updated->end(), registry), updated->end());
+  std::atomic_store(&_registries, std::shared_ptr<const RegistryList>(std::move(updated)));
+}
+
+
 void TcpServer::updateConnections(const std::vector<std::shared_ptr<Connection>> &connections,
                                   const std::function<void(Server &, Connection &)> &callback)
 {
@@ -375,6 +551,7 @@ void TcpServer::updateConnections(const std::vector<std::shared_ptr<Connection>>
   }
 
   const std::lock_guard<Lock> guard(_lock);
+  const auto previous = this->connections();
   std::vector<std::shared_ptr<Connection>> new_connections;
 
   if (!connections.empty())
@@ -383,7 +560,7 @@ void TcpServer::updateConnections(const std::vector<std::shared_ptr<Connection>>
     for (const auto &con : connections)
     {
       bool existing = false;
-      for (const auto &exist : _connections)
+      for (const auto &exist : *previous)
       {
         if (exist == con)
         {
@@ -399,18 +576,123 @@ void TcpServer::updateConnections(const std::vector<std::shared_ptr<Connection>>
     }
   }
 
-  _connections.clear();
-  std::for_each(connections.begin(), connections.end(),
-                [this](const std::shared_ptr<Connection> &con) { _connections.push_back(con); });
+  // Publish a new connection list. Threads iterating the previous list keep it alive until done.
+  std::atomic_store(&_connections, std::shared_ptr<const ConnectionList>(
+                                     std::make_shared<ConnectionList>(connections)));
+
+  reapReplays();
 
   // Send server info to new connections.
   for (const auto &con : new_connections)
   {
     con->sendServerInfo(_server_info);
+    for (const auto &registry : *std::atomic_load(&_registries))
+    {
+      registry->encodeCreated([&con](const uint8_t *data, uint32_t byte_count) {
+        con->send(data, byte_count, true);
+      });
+    }
     if (callback)
     {
       (callback)(*this, *con);
     }
+
+    if (_state_cache)
+    {
+      _replaying.emplace(con.get());
+      auto &replay = _replays.emplace_back();
+      replay.thread = std::thread([this, con, &replay]() { replayState(con, replay); });
+    }
+  }
+}
+
+
+void TcpServer::replayState(const std::shared_ptr<Connection> &connection, Replay &replay)
+{
+  // Replay a snapshot of the state without holding the lock, then catch up with the changes made
+  // meanwhile. The final catch up holds the lock, so the connection misses no messages going live.
+  constexpr unsigned kCatchUpPasses = 2;
+  StateCache::State replayed;
+  std::unique_lock<Lock> guard(_lock);
+  for (unsigned i = 0; i < kCatchUpPasses && connection->isConnected(); ++i)
+  {
+    StateCache::State target = _state_cache->state();
+    guard.unlock();
+    StateCache::replay(*connection, replayed, target);
+    replayed = std::move(target);
+    guard.lock();
+  }
+
+  StateCache::replay(*connection, replayed, _state_cache->state());
+  _replaying.erase(connection.get());
+  guard.unlock();
+  replay.done = true;
+}
+
+
+void TcpServer::reapReplays()
+{
+  for (auto iter = _replays.begin(); iter != _replays.end();)
+  {
+    if (iter->done)
+    {
+      iter->thread.join();
+      iter = _replays.erase(iter);
+    }
+    else
+    {
+      ++iter;
+    }
+  }
+}
+
+
+void TcpServer::joinReplays()
+{
+  std::unique_lock<Lock> guard(_lock);
+  std::list<Replay> replays;
+  replays.splice(replays.end(), _replays);
+  guard.unlock();
+  for (auto &replay : replays)
+  {
+    replay.thread.join();
+  }
+}
+
+
+void TcpServer::flushThread()
+{
+  const auto interval = std::chrono::microseconds(
+    std::max(_settings.flush_policy.max_age_us / 2u, kMinFlushIntervalUs));
+  std::unique_lock<std::mutex> guard(_flush_mutex);
+  while (!_flush_notify.wait_for(guard, interval, [this]() { return _flush_quit; }))
+  {
+    guard.unlock();
+    const auto now = std::chrono::steady_clock::now();
+    for (const auto &connection : *connections())
+    {
+      if (auto *base_connection = dynamic_cast<BaseConnection *>(connection.get()))
+      {
+        base_connection->flushExpired(now);
+      }
+    }
+    guard.lock();
+  }
+}
+
+
+void TcpServer::stopFlushThread()
+{
+  if (!_flush_thread.joinable())
+  {
+    return;
+  }
+
+  {
+    const std::lock_guard<std::mutex> guard(_flush_mutex);
+    _flush_quit = true;
   }
+  _flush_notify.notify_all();
+  _flush_thread.join();
 }
 }  // namespace tes
@@ -9,16 +9,24 @@
 #include <3escore/MeshMessages.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <list>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 namespace tes
 {
 class BaseConnection;
+class ShapeRegistry;
+class StateCache;
 class TcpConnectionMonitor;
 class TcpListenSocket;
 class TcpServer;
+class UpdateTracker;
 
 /// A TCP based implementation of a 3es @c Server.
 class TcpServer final : public Server
@@ -88,6 +96,10 @@ public:
   unsigned connectionCount() const final;
   std::shared_ptr<Connection> connection(unsigned index) final;
   std::shared_ptr<const Connection> connection(unsigned index) const final;
+  std::shared_ptr<ResourcePacketCache> resourceCache() const final { return _resource_cache; }
+
+  void addRegistry(const std::shared_ptr<ShapeRegistry> &registry) final;
+  void removeRegistry(const std::shared_ptr<ShapeRegistry> &registry) final;
 
   /// Updates the internal connections list to the given one.
   /// Intended only for use by the @c ConnectionMonitor.
@@ -95,9 +107,94 @@ public:
                          const std::function<void(Server &, Connection &)> &callback);
 
 private:
+  using ConnectionList = std::vector<std::shared_ptr<Connection>>;
+  using RegistryList = std::vector<std::shared_ptr<ShapeRegistry>>;
+
+  /// A background replay of the @c StateCache to a new connection.
+  struct Replay
+  {
+    std::thread thread;
+    /// Set once the replay thread no longer needs the @c _lock .
+    std::atomic_bool done = false;
+  };
+
+  /// Should messages be sent to @p connection ? False while replaying the @c StateCache .
+  ///
+  /// Note: the @c _lock must be locked before calling this function.
+  /// @param connection The connection to check.
+  /// @return True if @p connection is live.
+  [[nodiscard]] bool isLive(const Connection &connection) const
+  {
+    return _replaying.empty() || _replaying.find(&connection) == _replaying.end();
+  }
+
+  /// Access the current connection list snapshot. The list is never modified once published, so
+  /// it may be iterated without holding the @c _lock . The snapshot stays valid while held, even if
+  /// the connections are updated meanwhile.
+  /// @return The current connection list.
+  [[nodiscard]] std::shared_ptr<const ConnectionList> connections() const
+  {
+    return std::atomic_load(&_connections);
+  }
+
+  /// Lock the @c _lock when there is server state to maintain - the @c StateCache or
+  /// @c UpdateTracker . The state must stay consistent with the messages sent to each connection,
+  /// particularly while replaying to a new connection. Without such state, messages are sent
+  /// without locking.
+  /// @return A lock, which only owns the @c _lock when there is server state.
+  [[nodiscard]] std::unique_lock<Lock> lockState() const
+  {
+    return (_state_cache || _update_tracker) ? std::unique_lock<Lock>(_lock) :
+                                               std::unique_lock<Lock>(_lock, std::defer_lock);
+  }
+
+  /// Replay thread entry point. Sends the cached state to @p connection , catching up with changes
+  /// made during the replay, then makes the connection live.
+  /// @param connection The connection to replay to.
+  /// @param replay The replay tracking structure.
+  void replayState(const std::shared_ptr<Connection> &connection, Replay &replay);
+
+  /// Join completed replay threads.
+  ///
+  /// Note: the @c _lock must be locked before calling this function.
+  void reapReplays();
+
+  /// Wait for all replay threads to complete.
+  ///
+  /// Note: the @c _lock must not be locked.
+  void joinReplays();
+
+  /// Flush thread entry point. Periodically sends collated packets older than
+  /// @c CollationFlushPolicy::max_age_us on each connection.
+  void flushThread();
+
+  /// Stop and join the flush thread, if running.
+  void stopFlushThread();
+
+  /// Guards changes to the connection and registry lists and the server state.
   mutable Lock _lock;
-  std::vector<std::shared_ptr<Connection>> _connections;
+  /// Current connections. Replaced as a whole under the @c _lock - read-copy-update - and read with
+  /// @c connections() .
+  std::shared_ptr<const ConnectionList> _connections = std::make_shared<const ConnectionList>();
+  /// Live server state. Only created with @c SFStateCache .
+  std::unique_ptr<StateCache> _state_cache;
+  /// Last sent shape attributes. Only created with @c SFDeltaUpdates .
+  std::unique_ptr<UpdateTracker> _update_tracker;
+  /// Connections currently receiving a @c StateCache replay.
+  std::unordered_set<const Connection *> _replaying;
+  /// Active and completed replays.
+  std::list<Replay> _replays;
+  /// Registries encoded on each @c updateFrame() . Replaced as a whole like @c _connections .
+  std::shared_ptr<const RegistryList> _registries = std::make_shared<const RegistryList>();
   std::shared_ptr<TcpConnectionMonitor> _monitor;
+  /// Sends aged collated packets. Only started with a @c CollationFlushPolicy::max_age_us .
+  std::thread _flush_thread;
+  std::mutex _flush_mutex;
+  std::condition_variable _flush_notify;
+  /// Set to stop the @c _flush_thread . Guarded by @c _flush_mutex .
+  bool _flush_quit = false;
+  /// Packed resources shared by all connections.
+  std::shared_ptr<ResourcePacketCache> _resource_cache;
   ServerSettings _settings;
   ServerInfoMessage _server_info;
   std::atomic_bool _active = false;
@@ -0,0 +1,114 @@
+//
+// author: Kazys Stepanas
+//
+#include "UpdateTracker.h"
+
+#include <3escore/Messages.h>
+#include <3escore/shapes/Shape.h>
+
+#include <cmath>
+
+namespace tes
+{
+namespace
+{
+template <size_t N>
+bool differs(const std::array<double, N> &a, const std::array<double, N> &b, double tolerance)
+{
+  for (size_t i = 0; i < N; ++i)
+  {
+    // Negated comparison so NaN values register as a change.
+    if (!(std::abs(a[i] - b[i]) <= tolerance))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace
+
+UpdateTracker::UpdateTracker(double tolerance, uint16_t buffer_size)
+  : _packet_buffer(buffer_size)
+  , _packet(std::make_unique<PacketWriter>(_packet_buffer.data(), buffer_size))
+  , _tolerance(tolerance)
+{}
+
+
+void UpdateTracker::create(const Shape &shape)
+{
+  if (shape.isTransient())
+  {
+    return;
+  }
+
+  _shapes[shapeKey(shape)] = shape.attributes();
+}
+
+
+void UpdateTracker::destroy(const Shape &shape)
+{
+  _shapes.erase(shapeKey(shape));
+}
+
+
+UpdateTracker::Result UpdateTracker::update(const Shape &shape)
+{
+  const auto search = _shapes.find(shapeKey(shape));
+  if (search == _shapes.end())
+  {
+    return Result::Untracked;
+  }
+
+  const uint16_t shape_flags = shape.flags();
+  // Respect a partial update requested by the shape itself.
+  const unsigned candidates =
+    (shape_flags & UFUpdateMode) ? (shape_flags & UFPosRotScaleColour) : UFPosRotScaleColour;
+  const ObjectAttributesd &current = shape.attributes();
+  ObjectAttributesd &sent = search->second;
+
+  unsigned changed = 0;
+  if ((candidates & UFColour) && current.colour != sent.colour)
+  {
+    changed |= UFColour;
+    sent.colour = current.colour;
+  }
+  if ((candidates & UFPosition) && differs(current.position, sent.position, _tolerance))
+  {
+    changed |= UFPosition;
+    sent.position = current.position;
+  }
+  if ((candidates & UFRotation) && differs(current.rotation, sent.rotation, _tolerance))
+  {
+    changed |= UFRotation;
+    sent.rotation = current.rotation;
+  }
+  if ((candidates & UFScale) && differs(current.scale, sent.scale, _tolerance))
+  {
+    changed |= UFScale;
+    sent.scale = current.scale;
+  }
+
+  if (!changed)
+  {
+    return Result::Unchanged;
+  }
+
+  UpdateMessage update = {};
+  update.id = shape.id();
+  update.flags = static_cast<uint16_t>((shape_flags & OFDoublePrecision) | UFUpdateMode |
+                                       UFCompact | changed);
+  _packet->reset(shape.routingId(), UpdateMessage::MessageId);
+  if (!update.write(*_packet, current) || !_packet->finalise())
+  {
+    // Encoding failure. Fall back to a regular update.
+    return Result::Untracked;
+  }
+  return Result::Changed;
+}
+
+
+uint64_t UpdateTracker::shapeKey(const Shape &shape)
+{
+  return objectKey(shape.routingId(), shape.id());
+}
+}  // namespace tes
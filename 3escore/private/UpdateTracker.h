@@ -0,0 +1,79 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include <3escore/CoreConfig.h>
+
+#include <3escore/Messages.h>
+#include <3escore/PacketWriter.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace tes
+{
+class Shape;
+
+/// Tracks the attributes last sent for each persistent shape to support @c SFDeltaUpdates .
+///
+/// Each @c update() is compared against the last sent attributes and encoded as a compact partial
+/// update (@c UFCompact ) carrying only the attributes which have changed. Position, rotation and
+/// scale components are compared using a quantisation tolerance, so small changes accumulate
+/// against the last sent value rather than being lost. Only shapes registered via @c create() are
+/// tracked.
+///
+/// Not threadsafe. The @c TcpServer guards access.
+class UpdateTracker
+{
+public:
+  /// Result of an @c update() call.
+  enum class Result
+  {
+    /// Nothing has changed. No message is required.
+    Unchanged,
+    /// The shape has changed. The message is available from @c packet() .
+    Changed,
+    /// The shape is not tracked and should be updated as normal.
+    Untracked
+  };
+
+  /// Constructor.
+  /// @param tolerance Quantisation tolerance. See @c ServerSettings::update_tolerance .
+  /// @param buffer_size Size of the packet buffer used to encode updates.
+  explicit UpdateTracker(double tolerance = 0, uint16_t buffer_size = 0xffe0u);
+
+  /// Start tracking @p shape . Ignored for transient shapes.
+  /// @param shape The created shape.
+  void create(const Shape &shape);
+
+  /// Stop tracking @p shape .
+  /// @param shape The destroyed shape.
+  void destroy(const Shape &shape);
+
+  /// Compare @p shape against the last sent attributes, encoding an update when it has changed.
+  ///
+  /// The shape's own @c UFUpdateMode flags restrict which attributes are considered.
+  /// @param shape The shape to update.
+  /// @return The update result.
+  [[nodiscard]] Result update(const Shape &shape);
+
+  /// The packet encoded by the last @c update() call returning @c Result::Changed .
+  /// @return The finalised update packet.
+  [[nodiscard]] const PacketWriter &packet() const { return *_packet; }
+
+  /// Stop tracking all shapes.
+  void clear() { _shapes.clear(); }
+
+private:
+  static uint64_t shapeKey(const Shape &shape);
+
+  /// Last sent attributes keyed by routing ID and shape ID.
+  std::unordered_map<uint64_t, ObjectAttributesd> _shapes;
+  std::vector<uint8_t> _packet_buffer;
+  std::unique_ptr<PacketWriter> _packet;
+  double _tolerance = 0;
+};
+}  // namespace tes
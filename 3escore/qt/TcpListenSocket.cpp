@@ -77,3 +77,9 @@ std::shared_ptr<TcpSocket> tcpListenSocket::accept(unsigned timeout_ms)
   clientDetail->socket = new_socket;
   return std::make_shared<TcpSocket>(clientDetail);
 }
+
+
+void tcpListenSocket::wake()
+{
+  // Not supported. QTcpServer::waitForNewConnection() continues until the timeout expires.
+}
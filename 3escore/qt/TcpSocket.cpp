@@ -182,6 +182,18 @@ int TcpSocket::readAvailable(char *buffer, int bufferLength) const
 }
 
 
+bool TcpSocket::waitForData(unsigned timeoutMs) const
+{
+  if (!isConnected())
+  {
+    return false;
+  }
+
+  return _detail->socket->bytesAvailable() > 0 ||
+         _detail->socket->waitForReadyRead(static_cast<int>(timeoutMs));
+}
+
+
 int TcpSocket::write(const char *buffer, int bufferLength) const
 {
   if (!_detail->socket)
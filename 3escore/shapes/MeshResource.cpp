@@ -38,6 +38,13 @@ uint16_t MeshResource::typeId() const
 
 
 int MeshResource::create(PacketWriter &packet) const
+{
+  return writeDefinition(packet, MeshCreateMessage::MessageId, vertexCount(), indexCount());
+}
+
+
+int MeshResource::writeDefinition(PacketWriter &packet, uint16_t message_id, unsigned vertex_count,
+                                  unsigned index_count) const
 {
   MeshCreateMessage msg = {};
   ObjectAttributesd attributes = {};
@@ -46,8 +53,8 @@ int MeshResource::create(PacketWriter &packet) const
   const float draw_scale = drawScale();
 
   msg.mesh_id = id();
-  msg.vertex_count = vertexCount();
-  msg.index_count = indexCount();
+  msg.vertex_count = vertex_count;
+  msg.index_count = index_count;
   msg.flags = 0;
   msg.draw_type = static_cast<uint8_t>(drawType());
 
@@ -61,7 +68,7 @@ int MeshResource::create(PacketWriter &packet) const
     msg.flags |= McfDrawScale;
   }
 
-  packet.reset(typeId(), MeshCreateMessage::MessageId);
+  packet.reset(typeId(), message_id);
 
   const Vector3d &pos = transform.position();
   const Quaterniond &rot = transform.rotation();
@@ -295,11 +302,11 @@ bool MeshResource::readTransfer(int message_type, PacketReader &packet)
 
   // Read offset and count
   uint32_t offset = 0;
-  uint16_t count = 0;
+  uint32_t count = 0;
 
   // Read vertex stream offset and count.
   ok = packet.readElement(offset) == sizeof(offset) && ok;
-  ok = packet.readElement(count) == sizeof(count) && ok;
+  ok = DataBuffer::readTransferCount(packet, count) && ok;
 
   // If we need to peek the stream data type and component count we can do by invoking
   // peek_stream_info(). On success, component_count and packet_type will be valid.
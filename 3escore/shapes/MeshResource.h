@@ -152,6 +152,16 @@ public:
   bool readTransfer(int message_type, PacketReader &packet) override;
 
 protected:
+  /// Populate a mesh creation or redefinition packet for this mesh, declaring the given vertex and
+  /// index counts. Supports resources which transfer a mesh in stages - see @c ProgressivePoints .
+  /// @param packet A packet to populate and send.
+  /// @param message_id The message ID: @c MmtCreate or @c MmtRedefine .
+  /// @param vertex_count The vertex count to declare.
+  /// @param index_count The index count to declare.
+  /// @return Zero on success, an error code otherwise.
+  int writeDefinition(PacketWriter &packet, uint16_t message_id, unsigned vertex_count,
+                      unsigned index_count) const;
+
   virtual void nextPhase(TransferProgress &progress) const;
 
   virtual bool processCreate(const MeshCreateMessage &msg,
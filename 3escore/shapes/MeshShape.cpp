@@ -9,6 +9,7 @@
 #include <3escore/PacketWriter.h>
 
 #include <algorithm>
+#include <array>
 
 namespace tes
 {
@@ -258,6 +259,98 @@ MeshShape &MeshShape::duplicateArrays()
 }
 
 
+namespace
+{
+/// Create a borrowed view of every @p stride th element of @p buffer .
+/// @tparam T The primitive type of @p buffer .
+template <typename T>
+DataBuffer stridedView(const DataBuffer &buffer, unsigned stride)
+{
+  const size_t count = (buffer.count() + stride - 1u) / stride;
+  const size_t element_stride = size_t(buffer.elementStride()) * stride;
+  return { buffer.ptr<T>(), count, buffer.componentCount(), element_stride };
+}
+
+
+/// Create a strided view of @p buffer , resolving the primitive type from the buffer @c type() .
+/// @return The view, or an empty buffer if the buffer @c type() cannot be viewed with a stride.
+DataBuffer stridedView(const DataBuffer &buffer, unsigned stride)
+{
+  switch (buffer.type())
+  {
+  case DctInt8:
+    return stridedView<int8_t>(buffer, stride);
+  case DctUInt8:
+    return stridedView<uint8_t>(buffer, stride);
+  case DctInt16:
+    return stridedView<int16_t>(buffer, stride);
+  case DctUInt16:
+    return stridedView<uint16_t>(buffer, stride);
+  case DctInt32:
+    return stridedView<int32_t>(buffer, stride);
+  case DctUInt32:
+    return stridedView<uint32_t>(buffer, stride);
+  case DctInt64:
+    return stridedView<int64_t>(buffer, stride);
+  case DctUInt64:
+    return stridedView<uint64_t>(buffer, stride);
+  case DctFloat32:
+    return stridedView<float>(buffer, stride);
+  case DctFloat64:
+    return stridedView<double>(buffer, stride);
+  default:
+    break;
+  }
+  return {};
+}
+}  // namespace
+
+
+MeshShape MeshShape::decimatedPoints(unsigned stride) const
+{
+  MeshShape view;
+  view.Shape::operator=(*this);
+  view._quantisation_unit = _quantisation_unit;
+  view._draw_scale = _draw_scale;
+  view._draw_type = _draw_type;
+
+  view._vertices = DataBuffer(_vertices);
+  view._normals = DataBuffer(_normals);
+  view._colours = DataBuffer(_colours);
+  view._indices = DataBuffer(_indices);
+
+  if (stride <= 1 || _draw_type != DrawType::Points || _indices.count() != 0)
+  {
+    return view;
+  }
+
+  // Only decimate per vertex streams. A single normal or colour is shared by all vertices.
+  std::array<DataBuffer *, 3> streams = { &view._vertices, &view._normals, &view._colours };
+  std::array<DataBuffer, 3> decimated;
+  for (size_t i = 0; i < streams.size(); ++i)
+  {
+    if (streams[i]->count() == _vertices.count())
+    {
+      decimated[i] = stridedView(*streams[i], stride);
+      if (!decimated[i].isValid())
+      {
+        // Unsupported stream type. Keep all the streams undecimated so they stay consistent.
+        return view;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < streams.size(); ++i)
+  {
+    if (decimated[i].isValid())
+    {
+      *streams[i] = decimated[i];
+    }
+  }
+  return view;
+}
+
+
 bool MeshShape::writeCreate(PacketWriter &packet) const
 {
   bool ok = Shape::writeCreate(packet);
@@ -342,9 +435,9 @@ int MeshShape::writeData(PacketWriter &packet, unsigned &progress_marker) const
   default:
     // Either all done or no data to send.
     ok = packet.writeElement(static_cast<uint16_t>(SDTEnd)) == sizeof(uint16_t) && ok;
-    // Write zero offset (4-bytes) and count (2-bytes) for consistency.
+    // Write zero offset (4-bytes) and count (2 or 4-bytes) for consistency.
     ok = packet.writeElement(static_cast<uint32_t>(0)) == sizeof(uint32_t) && ok;
-    ok = packet.writeElement(static_cast<uint16_t>(0)) == sizeof(uint16_t) && ok;
+    ok = DataBuffer::writeTransferCount(packet, 0) && ok;
     done = true;
     break;
   }
@@ -421,9 +514,9 @@ bool MeshShape::readData(PacketReader &packet)
     // Ensure we have zero offset and count.
     {
       uint32_t offset{};
-      uint16_t count{};
+      uint32_t count{};
       ok = ok && packet.readElement(offset) == sizeof(offset);
-      ok = ok && packet.readElement(count) == sizeof(count);
+      ok = ok && DataBuffer::readTransferCount(packet, count);
       ok = ok && offset == 0 && count == 0;
     }
     break;
@@ -450,11 +543,11 @@ void MeshShape::onClone(MeshShape &copy) const
   Shape::onClone(copy);
   copy._vertices = DataBuffer(_vertices);
   copy._vertices.duplicate();
-  copy._normals = DataBuffer(_indices);
+  copy._normals = DataBuffer(_normals);
   copy._normals.duplicate();
   copy._indices = DataBuffer(_indices);
   copy._indices.duplicate();
-  copy._colours = DataBuffer(_indices);
+  copy._colours = DataBuffer(_colours);
   copy._colours.duplicate();
   copy._quantisation_unit = _quantisation_unit;
   copy._draw_scale = _draw_scale;
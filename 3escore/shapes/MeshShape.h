@@ -248,6 +248,17 @@ public:
   /// @return this
   MeshShape &duplicateArrays();
 
+  /// Create a decimated view of an unindexed point cloud mesh, keeping every @p stride th vertex.
+  ///
+  /// The view borrows the vertex, normal and colour arrays of this shape, using a larger element
+  /// stride, so it must not outlive this shape. Streams of any primitive @c DataStreamType are
+  /// decimated. Other shapes, including indexed meshes and meshes with a stream which cannot be
+  /// decimated, are copied without decimation.
+  ///
+  /// @param stride The vertex stride. Values less than 2 yield an undecimated view.
+  /// @return The decimated view.
+  [[nodiscard]] MeshShape decimatedPoints(unsigned stride) const;
+
   /// Access the vertices as a @c DataBuffer . The underlying pointer type must be either @c float
   /// or @c double .
   /// @return The vertices vertex stream.
@@ -12,6 +12,7 @@
 #include <3escore/Rotation.h>
 #include <3escore/Transform.h>
 
+#include <algorithm>
 #include <vector>
 
 namespace tes
@@ -35,6 +36,114 @@ struct IndexChange
   unsigned write_index;
 };
 
+namespace
+{
+/// Packet buffer size used for update messages. This is the largest packet which can be written by
+/// a @c PacketWriter while leaving room for collation overhead.
+constexpr uint16_t kUpdatePacketSize = 0xff00u;
+
+/// Coalesce pending @p changes for a single mesh component.
+///
+/// Writes are sorted by @c write_index , keeping only the most recent write to each index. Writes
+/// at or beyond @p limit are dropped as they have been truncated by a later count change.
+///
+/// @param changes The pending change list in submission order.
+/// @param accept Predicate used to select the changes for the component of interest.
+/// @param limit The pending element count for the component.
+/// @return Pointers into @p changes for the surviving writes, sorted by @c write_index .
+template <typename Change, typename Accept>
+std::vector<const Change *> coalesce(const std::vector<Change> &changes, Accept accept,
+                                     unsigned limit)
+{
+  std::vector<const Change *> writes;
+  writes.reserve(changes.size());
+  for (const auto &change : changes)
+  {
+    if (change.write_index < limit && accept(change))
+    {
+      writes.emplace_back(&change);
+    }
+  }
+
+  // Stable sort preserves submission order for writes to the same index, so the last write in
+  // each group of equal indices is the one to keep.
+  std::stable_sort(writes.begin(), writes.end(), [](const Change *a, const Change *b) {
+    return a->write_index < b->write_index;
+  });
+
+  auto out = writes.begin();
+  for (auto iter = writes.begin(); iter != writes.end(); ++iter)
+  {
+    const auto next = iter + 1;
+    if (next == writes.end() || (*next)->write_index != (*iter)->write_index)
+    {
+      *out++ = *iter;
+    }
+  }
+  writes.erase(out, writes.end());
+  return writes;
+}
+
+
+/// Send coalesced @p writes as contiguous runs of @c MeshShape component data.
+///
+/// Each run of consecutive write indices is packed into a single @c DataBuffer and written in as
+/// few packets as the packet byte limit allows.
+///
+/// @param con The connection to send on.
+/// @param packet Packet writer used to build messages.
+/// @param component_msg The component message header for the mesh.
+/// @param message_type The @c MeshMessageType for the component.
+/// @param writes The coalesced writes from @c coalesce() .
+/// @param component_count Number of @c T components per element.
+/// @param extract Copies the @c component_count values for a change into the given output.
+template <typename T, typename Change, typename Extract>
+void sendRuns(Connection &con, PacketWriter &packet, const MeshComponentMessage &component_msg,
+              uint16_t message_type, const std::vector<const Change *> &writes,
+              unsigned component_count, Extract extract)
+{
+  std::vector<T> run_values;
+  size_t run_begin = 0;
+  while (run_begin < writes.size())
+  {
+    // Find the end of the contiguous run.
+    size_t run_end = run_begin + 1;
+    while (run_end < writes.size() &&
+           writes[run_end]->write_index == writes[run_end - 1]->write_index + 1)
+    {
+      ++run_end;
+    }
+
+    const unsigned run_start_index = writes[run_begin]->write_index;
+    const auto run_length = static_cast<unsigned>(run_end - run_begin);
+    run_values.resize(size_t(run_length) * component_count);
+    for (size_t i = run_begin; i < run_end; ++i)
+    {
+      extract(*writes[i], run_values.data() + (i - run_begin) * component_count);
+    }
+
+    const DataBuffer run_buffer(run_values.data(), run_length, component_count);
+    unsigned offset = 0;
+    while (offset < run_length)
+    {
+      packet.reset(tes::MtMesh, message_type);
+      component_msg.write(packet);
+      const unsigned written = run_buffer.write(packet, offset, 0, run_start_index);
+      if (written == 0)
+      {
+        // No progress. Should not happen with a valid packet buffer.
+        break;
+      }
+      packet.finalise();
+      con.send(packet);
+      offset += written;
+    }
+
+    run_begin = run_end;
+  }
+}
+}  // namespace
+
 /// Data members for MutableMesh
 struct MutableMeshImp
 {
@@ -272,8 +381,8 @@ void MutableMesh::update(Connection *con)
   }
 
   // Send mesh redefinition message.
-  std::vector<uint8_t> buffer(kMaxPacketSize);
-  PacketWriter packet(buffer.data(), int_cast<uint16_t>(buffer.size()));
+  std::vector<uint8_t> buffer(kUpdatePacketSize);
+  PacketWriter packet(buffer.data(), kUpdatePacketSize);
   MeshRedefineMessage msg = {};
   MeshComponentMessage component_msg = {};
   MeshFinaliseMessage final_msg = {};
@@ -332,68 +441,43 @@ void MutableMesh::update(Connection *con)
 
   component_msg.mesh_id = _imp->mesh.id();
 
-  // It would be nice to sort additions/removals to support block updates,
-  // however, changes may be interleaved so we have to preserve order.
+  // Coalesce changes per component. Each component array is last write wins, so we can sort by
+  // write index, drop superseded writes and send contiguous runs as single data buffers.
+  const auto component_writes = [this, new_vertex_count](MeshComponentFlag flag) {
+    return coalesce(
+      _imp->vertex_changes,
+      [flag](const VertexChange &change) { return change.component_flag == flag; },
+      new_vertex_count);
+  };
 
   if (!_imp->vertex_changes.empty())
   {
-    // Process new vertices.
-    for (const auto &vertex_def : _imp->vertex_changes)
-    {
-      if ((vertex_def.component_flag & MeshComponentFlag::Vertex) != MeshComponentFlag::Zero)
-      {
-        packet.reset(tes::MtMesh, tes::MmtVertex);
-        component_msg.write(packet);
-        const DataBuffer write_buffer(vertex_def.position.data(), 1, 3);
-        write_buffer.write(packet, 0, vertex_def.write_index);
-        packet.finalise();
-        con->send(packet);
-      }
-
-      if ((vertex_def.component_flag & MeshComponentFlag::Colour) != MeshComponentFlag::Zero)
-      {
-        packet.reset(tes::MtMesh, tes::MmtVertexColour);
-        component_msg.write(packet);
-        const DataBuffer write_buffer(&vertex_def.colour, 1);
-        write_buffer.write(packet, 0, vertex_def.write_index);
-        packet.finalise();
-        con->send(packet);
-      }
-
-      if ((vertex_def.component_flag & MeshComponentFlag::Normal) != MeshComponentFlag::Zero)
-      {
-        packet.reset(tes::MtMesh, tes::MmtNormal);
-        component_msg.write(packet);
-        const DataBuffer write_buffer(vertex_def.normal.data(), 1, 3);
-        write_buffer.write(packet, 0, vertex_def.write_index);
-        packet.finalise();
-        con->send(packet);
-      }
-
-      if ((vertex_def.component_flag & MeshComponentFlag::Uv) != MeshComponentFlag::Zero)
-      {
-        packet.reset(tes::MtMesh, tes::MmtUv);
-        component_msg.write(packet);
-        const DataBuffer write_buffer(vertex_def.uv.data(), 1, 2);
-        write_buffer.write(packet, 0, vertex_def.write_index);
-        packet.finalise();
-        con->send(packet);
-      }
-    }
+    sendRuns<float>(*con, packet, component_msg, tes::MmtVertex,
+                    component_writes(MeshComponentFlag::Vertex), 3,
+                    [](const VertexChange &change, float *out) {
+                      std::copy(change.position.begin(), change.position.end(), out);
+                    });
+    sendRuns<uint32_t>(*con, packet, component_msg, tes::MmtVertexColour,
+                       component_writes(MeshComponentFlag::Colour), 1,
+                       [](const VertexChange &change, uint32_t *out) { *out = change.colour; });
+    sendRuns<float>(*con, packet, component_msg, tes::MmtNormal,
+                    component_writes(MeshComponentFlag::Normal), 3,
+                    [](const VertexChange &change, float *out) {
+                      std::copy(change.normal.begin(), change.normal.end(), out);
+                    });
+    sendRuns<float>(*con, packet, component_msg, tes::MmtUv,
+                    component_writes(MeshComponentFlag::Uv), 2,
+                    [](const VertexChange &change, float *out) {
+                      std::copy(change.uv.begin(), change.uv.end(), out);
+                    });
   }
 
   if (!_imp->index_changes.empty())
   {
-    // Process new indices.
-    for (const auto &index_def : _imp->index_changes)
-    {
-      packet.reset(tes::MtMesh, tes::MmtIndex);
-      component_msg.write(packet);
-      const DataBuffer write_buffer(&index_def.index_value, 1);
-      write_buffer.write(packet, 0, index_def.write_index);
-      packet.finalise();
-      con->send(packet);
-    }
+    const auto index_writes = coalesce(
+      _imp->index_changes, [](const IndexChange &) { return true; }, new_index_count);
+    sendRuns<uint32_t>(*con, packet, component_msg, tes::MmtIndex, index_writes, 1,
+                       [](const IndexChange &change, uint32_t *out) { *out = change.index_value; });
   }
 
   migratePending();
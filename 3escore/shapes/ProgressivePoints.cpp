@@ -0,0 +1,528 @@
+//
+// author: Kazys Stepanas
+//
+#include "ProgressivePoints.h"
+
+#include <3escore/CoreUtil.h>
+#include <3escore/MeshMessages.h>
+#include <3escore/Meta.h>
+#include <3escore/PacketWriter.h>
+#include <3escore/TransferProgress.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+namespace tes
+{
+namespace
+{
+/// Number of bits per axis in octree cell keys.
+constexpr unsigned kKeyBits = 21u;
+/// Number of octree levels: the root, one per key bit and a final level for duplicate keys.
+constexpr unsigned kOctreeLevels = kKeyBits + 2u;
+
+/// Spread the lower @c kKeyBits of @p value to every third bit.
+uint64_t spreadBits(uint64_t value)
+{
+  value &= (1ull << kKeyBits) - 1u;
+  value = (value | value << 32u) & 0x1f00000000ffffull;
+  value = (value | value << 16u) & 0x1f0000ff0000ffull;
+  value = (value | value << 8u) & 0x100f00f00f00f00full;
+  value = (value | value << 4u) & 0x10c30c30c30c30c3ull;
+  value = (value | value << 2u) & 0x1249249249249249ull;
+  return value;
+}
+
+/// Find the index of the highest set bit in a non-zero @p value .
+unsigned highestBit(uint64_t value)
+{
+  unsigned bit = 0;
+  for (unsigned shift = 32u; shift > 0; shift >>= 1u)
+  {
+    if (value >> shift)
+    {
+      value >>= shift;
+      bit += shift;
+    }
+  }
+  return bit;
+}
+
+/// Extract the cell key at @p depth from an octree @p key , reversing the octal digits such that
+/// the least significant digit - the finest octant - becomes the most significant.
+uint64_t reverseDigits(uint64_t key, unsigned depth)
+{
+  uint64_t cell = key >> (3u * (kKeyBits - depth));
+  uint64_t reversed = 0;
+  for (unsigned i = 0; i < depth; ++i)
+  {
+    reversed = (reversed << 3u) | (cell & 7u);
+    cell >>= 3u;
+  }
+  return reversed;
+}
+
+/// Check if progressive transfer supports the @p buffer data type.
+bool isSupported(const DataBuffer &buffer)
+{
+  switch (buffer.type())
+  {
+  case DctFloat32:
+  case DctFloat64:
+  case DctUInt32:
+  case DctUInt8:
+    return true;
+  default:
+    break;
+  }
+  return false;
+}
+
+/// Create a borrowed view of the first @p count elements of @p buffer .
+DataBuffer headView(const DataBuffer &buffer, size_t count)
+{
+  const size_t component_count = buffer.componentCount();
+  const size_t element_stride = buffer.elementStride();
+  switch (buffer.type())
+  {
+  case DctFloat32:
+    return { buffer.ptr<float>(), count, component_count, element_stride };
+  case DctFloat64:
+    return { buffer.ptr<double>(), count, component_count, element_stride };
+  case DctUInt32:
+    return { buffer.ptr<uint32_t>(), count, component_count, element_stride };
+  case DctUInt8:
+    return { buffer.ptr<uint8_t>(), count, component_count, element_stride };
+  default:
+    break;
+  }
+  return {};
+}
+
+/// Create a densely packed copy of @p buffer with elements in the given @p order .
+template <typename T>
+DataBuffer reorderedAs(const DataBuffer &buffer, const std::vector<uint32_t> &order)
+{
+  const size_t component_count = buffer.componentCount();
+  const size_t element_stride = buffer.elementStride();
+  const T *source = buffer.ptr<T>();
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  T *elements = new T[order.size() * component_count];
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const T *element = source + order[i] * element_stride;
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::copy(element, element + component_count, elements + i * component_count);
+  }
+  return { true, elements, order.size(), component_count };
+}
+
+/// @overload
+DataBuffer reordered(const DataBuffer &buffer, const std::vector<uint32_t> &order)
+{
+  switch (buffer.type())
+  {
+  case DctFloat32:
+    return reorderedAs<float>(buffer, order);
+  case DctFloat64:
+    return reorderedAs<double>(buffer, order);
+  case DctUInt32:
+    return reorderedAs<uint32_t>(buffer, order);
+  case DctUInt8:
+    return reorderedAs<uint8_t>(buffer, order);
+  default:
+    break;
+  }
+  return {};
+}
+}  // namespace
+
+
+ProgressivePoints::ProgressivePoints(const MeshResource &source, unsigned base_count,
+                                     unsigned refine_factor)
+  : _source(source)
+  , _base_count(base_count)
+  , _refine_factor(std::max(refine_factor, 2u))
+{
+  const DataBuffer vertices = source.vertices();
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> octree_ends;
+  levelOrder(vertices, order, octree_ends);
+
+  const auto per_vertex = [&order](const DataBuffer &buffer) {
+    return (buffer.isValid() && buffer.count() == order.size()) ? reordered(buffer, order) :
+                                                                  DataBuffer();
+  };
+
+  _vertices = per_vertex(vertices);
+  _normals = per_vertex(source.normals());
+  _colours = per_vertex(source.colours());
+  _uvs = per_vertex(source.uvs());
+
+  // Split the transfer levels by point count. The octree ordering makes each a spatial decimation.
+  const uint64_t vertex_count = order.size();
+  for (uint64_t end = std::max(_base_count, 1u); !order.empty(); end *= _refine_factor)
+  {
+    _level_ends.emplace_back(static_cast<uint32_t>(std::min(end, vertex_count)));
+    if (end >= vertex_count)
+    {
+      break;
+    }
+  }
+}
+
+
+ProgressivePoints::~ProgressivePoints() = default;
+
+
+bool ProgressivePoints::canRefine(const MeshResource &resource)
+{
+  if (resource.drawType() != DrawType::Points || resource.indexCount() > 0)
+  {
+    return false;
+  }
+
+  const DataBuffer vertices = resource.vertices();
+  if (!vertices.isValid() || vertices.count() != resource.vertexCount() ||
+      vertices.componentCount() != 3 || !isSupported(vertices))
+  {
+    return false;
+  }
+
+  const auto supported_stream = [&vertices](const DataBuffer &buffer) {
+    return !buffer.isValid() || (buffer.count() == vertices.count() && isSupported(buffer));
+  };
+
+  return supported_stream(resource.normals()) && supported_stream(resource.colours()) &&
+         supported_stream(resource.uvs());
+}
+
+
+void ProgressivePoints::levelOrder(const DataBuffer &vertices, std::vector<uint32_t> &order,
+                                   std::vector<uint32_t> &level_ends)
+{
+  const size_t count = vertices.count();
+  order.clear();
+  level_ends.clear();
+  if (count == 0)
+  {
+    return;
+  }
+
+  // Resolve the bounding cube. Invalid coordinates fail the comparisons and are ignored.
+  std::array<double, 3> min_ext;
+  std::array<double, 3> max_ext;
+  min_ext.fill(std::numeric_limits<double>::max());
+  max_ext.fill(std::numeric_limits<double>::lowest());
+  for (size_t i = 0; i < count; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      const auto coord = vertices.get<double>(i, j);
+      min_ext[j] = (coord < min_ext[j]) ? coord : min_ext[j];
+      max_ext[j] = (coord > max_ext[j]) ? coord : max_ext[j];
+    }
+  }
+
+  double extent = 0;
+  for (size_t j = 0; j < 3; ++j)
+  {
+    extent = std::max(extent, max_ext[j] - min_ext[j]);
+  }
+  constexpr auto kMaxCoord = double((1u << kKeyBits) - 1u);
+  const double scale = (extent > 0) ? kMaxCoord / extent : 0.0;
+
+  // Key each point by its deepest octree cell: the interleaved bits of the quantised coordinates.
+  // Sorting by key makes the points in any octree cell contiguous at every depth.
+  std::vector<std::pair<uint64_t, uint32_t>> keys(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    uint64_t key = 0;
+    for (size_t j = 0; j < 3; ++j)
+    {
+      const double coord = (vertices.get<double>(i, j) - min_ext[j]) * scale;
+      const double clamped = (coord >= 0) ? std::min(coord, kMaxCoord) : 0.0;
+      key |= spreadBits(static_cast<uint64_t>(clamped)) << j;
+    }
+    keys[i] = { key, static_cast<uint32_t>(i) };
+  }
+  std::sort(keys.begin(), keys.end());
+
+  // A point is at the shallowest depth at which it starts a new cell; i.e., the depth of the
+  // highest bit differing from the previous key. Points with duplicate keys are at the last level.
+  std::vector<uint8_t> levels(count);
+  std::array<uint32_t, kOctreeLevels> level_offsets = {};
+  levels[0] = 0;
+  ++level_offsets[0];
+  for (size_t i = 1; i < count; ++i)
+  {
+    const uint64_t diff = keys[i].first ^ keys[i - 1].first;
+    const unsigned level = (diff) ? kKeyBits - highestBit(diff) / 3u : kOctreeLevels - 1u;
+    levels[i] = static_cast<uint8_t>(level);
+    ++level_offsets[level];
+  }
+
+  // Counting sort by level. Within each level, order by the cell key with its octal digits
+  // reversed. This interleaves the cells across the parent cells at every depth, so any prefix of a
+  // level is spread evenly over the cloud.
+  uint32_t offset = 0;
+  for (auto &level_offset : level_offsets)
+  {
+    const uint32_t level_count = level_offset;
+    level_offset = offset;
+    offset += level_count;
+  }
+
+  std::vector<std::pair<uint64_t, uint32_t>> level_keys(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    const unsigned depth = std::min<unsigned>(levels[i], kKeyBits);
+    level_keys[level_offsets[levels[i]]++] = { reverseDigits(keys[i].first, depth),
+                                               keys[i].second };
+  }
+
+  order.resize(count);
+  auto level_begin = level_keys.begin();
+  for (const uint32_t level_end : level_offsets)
+  {
+    std::sort(level_begin, level_keys.begin() + level_end);
+    level_begin = level_keys.begin() + level_end;
+  }
+  std::transform(level_keys.begin(), level_keys.end(), order.begin(),
+                 [](const auto &level_key) { return level_key.second; });
+
+  // Offsets now mark the level ends.
+  for (const uint32_t level_end : level_offsets)
+  {
+    if (level_ends.empty() || level_end > level_ends.back())
+    {
+      level_ends.emplace_back(level_end);
+    }
+  }
+}
+
+
+uint32_t ProgressivePoints::id() const
+{
+  return _source.id();
+}
+
+
+std::shared_ptr<Resource> ProgressivePoints::clone() const
+{
+  return std::make_shared<ProgressivePoints>(_source, _base_count, _refine_factor);
+}
+
+
+Transform ProgressivePoints::transform() const
+{
+  return _source.transform();
+}
+
+
+uint32_t ProgressivePoints::tint() const
+{
+  return _source.tint();
+}
+
+
+DrawType ProgressivePoints::drawType(int stream) const
+{
+  return _source.drawType(stream);
+}
+
+
+float ProgressivePoints::drawScale(int stream) const
+{
+  return _source.drawScale(stream);
+}
+
+
+unsigned ProgressivePoints::vertexCount(int stream) const
+{
+  TES_UNUSED(stream);
+  return _vertices.count();
+}
+
+
+unsigned ProgressivePoints::indexCount(int stream) const
+{
+  TES_UNUSED(stream);
+  return 0;
+}
+
+
+DataBuffer ProgressivePoints::vertices(int stream) const
+{
+  TES_UNUSED(stream);
+  return _vertices;
+}
+
+
+DataBuffer ProgressivePoints::indices(int stream) const
+{
+  TES_UNUSED(stream);
+  return {};
+}
+
+
+DataBuffer ProgressivePoints::normals(int stream) const
+{
+  TES_UNUSED(stream);
+  return _normals;
+}
+
+
+DataBuffer ProgressivePoints::uvs(int stream) const
+{
+  TES_UNUSED(stream);
+  return _uvs;
+}
+
+
+DataBuffer ProgressivePoints::colours(int stream) const
+{
+  TES_UNUSED(stream);
+  return _colours;
+}
+
+
+int ProgressivePoints::create(PacketWriter &packet) const
+{
+  const unsigned first_count = (!_level_ends.empty()) ? _level_ends.front() : 0u;
+  return writeDefinition(packet, MeshCreateMessage::MessageId, first_count, 0);
+}
+
+
+int ProgressivePoints::transfer(PacketWriter &packet, unsigned byte_limit,
+                               TransferProgress &progress) const
+{
+  if (progress.phase == 0)
+  {
+    progress.phase = (!_level_ends.empty()) ? MmtVertex : MmtFinalise;
+    progress.progress = 0;
+  }
+
+  // Resolve the current level: the first to end after the progress. This is the next level for
+  // MmtFinalise and the new level for MmtRedefine.
+  const auto level = static_cast<size_t>(
+    std::upper_bound(_level_ends.begin(), _level_ends.end(), progress.progress) -
+    _level_ends.begin());
+
+  switch (progress.phase)
+  {
+  case MmtRedefine:
+    if (level >= _level_ends.size() ||
+        writeDefinition(packet, MeshRedefineMessage::MessageId, _level_ends[level], 0) != 0)
+    {
+      return -1;
+    }
+    progress.phase = MmtVertex;
+    return 0;
+
+  case MmtFinalise: {
+    MeshFinaliseMessage msg = {};
+    packet.reset(typeId(), MeshFinaliseMessage::MessageId);
+    msg.mesh_id = id();
+    msg.flags = (!_normals.isValid()) ? MffCalculateNormals : MffZero;
+    msg.write(packet);
+    if (progress.progress >= vertexCount())
+    {
+      progress.complete = true;
+    }
+    else
+    {
+      progress.phase = MmtRedefine;
+    }
+    return 0;
+  }
+
+  case MmtVertex:
+  case MmtVertexColour:
+  case MmtNormal:
+  case MmtUv:
+    break;
+
+  default:
+    progress.failed = true;
+    return -1;
+  }
+
+  if (level >= _level_ends.size())
+  {
+    progress.failed = true;
+    return -1;
+  }
+
+  const DataBuffer *data_source = &_vertices;
+  data_source = (progress.phase == MmtVertexColour) ? &_colours : data_source;
+  data_source = (progress.phase == MmtNormal) ? &_normals : data_source;
+  data_source = (progress.phase == MmtUv) ? &_uvs : data_source;
+
+  packet.reset(typeId(), int_cast<uint16_t>(progress.phase));
+  MeshComponentMessage msg = {};
+  msg.mesh_id = id();
+  msg.write(packet);
+
+  // Limit the data to the current level.
+  const uint32_t level_begin = (level > 0) ? _level_ends[level - 1] : 0u;
+  const uint32_t level_end = _level_ends[level];
+  const DataBuffer level_data = headView(*data_source, level_end);
+  const unsigned write_count =
+    level_data.write(packet, int_cast<uint32_t>(progress.progress), byte_limit);
+  if (write_count == 0)
+  {
+    // Failed to write when we should have.
+    return -1;
+  }
+
+  progress.progress += write_count;
+  if (progress.progress >= level_end)
+  {
+    nextComponent(progress, level_begin, level_end);
+  }
+
+  return 0;
+}
+
+
+void ProgressivePoints::nextComponent(TransferProgress &progress, uint32_t level_begin,
+                                      uint32_t level_end) const
+{
+  // Components follow the MeshResource transfer order. There are no indices.
+  int next = MmtFinalise;
+  switch (progress.phase)
+  {
+  case MmtVertex:
+    if (_colours.isValid())
+    {
+      next = MmtVertexColour;
+      break;
+    }
+    TES_FALLTHROUGH;
+  case MmtVertexColour:
+    if (_normals.isValid())
+    {
+      next = MmtNormal;
+      break;
+    }
+    TES_FALLTHROUGH;
+  case MmtNormal:
+    if (_uvs.isValid())
+    {
+      next = MmtUv;
+      break;
+    }
+    TES_FALLTHROUGH;
+  default:
+    break;
+  }
+
+  progress.phase = next;
+  // Each component restarts from the level start, while finalisation marks the level end.
+  progress.progress = (next == MmtFinalise) ? level_end : level_begin;
+}
+}  // namespace tes
@@ -0,0 +1,140 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include <3escore/CoreConfig.h>
+
+#include "MeshResource.h"
+
+#include <vector>
+
+namespace tes
+{
+/// A @c MeshResource which transfers a large, unindexed point resource progressively: a coarse,
+/// spatially decimated level first, then successively finer levels until all points are sent.
+///
+/// The points are ordered by octree level such that each level is a prefix of the points. Level
+/// zero holds a single point, while each subsequent level adds one point for each newly occupied
+/// octree node at that depth. A level prefix is therefore a voxel grid decimation of the cloud at
+/// the level resolution. Within a level, points are interleaved across the parent nodes, so a
+/// partial level is also spread evenly over the cloud. The ordered points are split into transfer
+/// levels by count: the first holds @c baseCount() points and each subsequent level grows the point
+/// count by @c refineFactor() .
+///
+/// The transfer uses the standard mesh messages. The first level is sent as a mesh with the first
+/// level vertex count, followed by @c MmtFinalise . Each subsequent level is sent as a
+/// @c MmtRedefine message with the level vertex count, followed by the data for the new points
+/// only and another @c MmtFinalise . A receiver can display each level on finalisation, replacing
+/// the previous level.
+///
+/// The wrapped resource must outlive this object, and must not change while referenced. The point
+/// order is resolved on construction. Normals, colours and UVs are reordered with the vertices.
+class TES_CORE_API ProgressivePoints : public MeshResource
+{
+public:
+  /// Default number of points in the first transfer level.
+  static constexpr unsigned kDefaultBaseCount = 1u << 16u;
+  /// Default point count growth between transfer levels.
+  static constexpr unsigned kDefaultRefineFactor = 4u;
+
+  /// Wrap @p source for progressive transfer.
+  /// @param source The resource to transfer. Should pass @c canRefine() .
+  /// @param base_count Number of points in the first transfer level.
+  /// @param refine_factor Point count growth between transfer levels. Values below 2 use 2.
+  explicit ProgressivePoints(const MeshResource &source, unsigned base_count = kDefaultBaseCount,
+                             unsigned refine_factor = kDefaultRefineFactor);
+
+  /// Destructor.
+  ~ProgressivePoints() override;
+
+  /// Check if @p resource can be transferred progressively. This requires a @c DrawType::Points
+  /// resource with vertices and no indices, and all other valid vertex streams to be per vertex.
+  /// @param resource The resource to check.
+  /// @return True if @p resource supports progressive transfer.
+  [[nodiscard]] static bool canRefine(const MeshResource &resource);
+
+  /// Order @p vertices by octree level, interleaving each level across the parent nodes. See class
+  /// comments.
+  /// @param vertices The vertex positions.
+  /// @param[out] order Set to the vertex indices in level order.
+  /// @param[out] level_ends Set to the end of each octree level in @p order . Empty levels are
+  ///   omitted, so values increase strictly.
+  static void levelOrder(const DataBuffer &vertices, std::vector<uint32_t> &order,
+                         std::vector<uint32_t> &level_ends);
+
+  /// Query the wrapped resource.
+  /// @return The source resource.
+  [[nodiscard]] const MeshResource &source() const { return _source; }
+  /// Query the point count for the first transfer level.
+  /// @return The base point count.
+  [[nodiscard]] unsigned baseCount() const { return _base_count; }
+  /// Query the point count growth between transfer levels.
+  /// @return The refinement factor.
+  [[nodiscard]] unsigned refineFactor() const { return _refine_factor; }
+  /// Query the vertex count at the end of each transfer level.
+  /// @return The cumulative vertex counts by transfer level. The last is the @c vertexCount() .
+  [[nodiscard]] const std::vector<uint32_t> &levelEnds() const { return _level_ends; }
+
+  /// @copydoc MeshResource::id()
+  [[nodiscard]] uint32_t id() const override;
+  /// Create another wrapper for the same source.
+  /// @return A new @c ProgressivePoints object.
+  [[nodiscard]] std::shared_ptr<Resource> clone() const override;
+  [[nodiscard]] Transform transform() const override;
+  [[nodiscard]] uint32_t tint() const override;
+  [[nodiscard]] DrawType drawType(int stream) const override;
+  using MeshResource::drawType;
+  [[nodiscard]] float drawScale(int stream) const override;
+  using MeshResource::drawScale;
+  [[nodiscard]] unsigned vertexCount(int stream) const override;
+  using MeshResource::vertexCount;
+  [[nodiscard]] unsigned indexCount(int stream) const override;
+  using MeshResource::indexCount;
+  /// Access the reordered vertices.
+  /// @return The vertices in level order.
+  [[nodiscard]] DataBuffer vertices(int stream) const override;
+  using MeshResource::vertices;
+  [[nodiscard]] DataBuffer indices(int stream) const override;
+  using MeshResource::indices;
+  [[nodiscard]] DataBuffer normals(int stream) const override;
+  using MeshResource::normals;
+  [[nodiscard]] DataBuffer uvs(int stream) const override;
+  using MeshResource::uvs;
+  [[nodiscard]] DataBuffer colours(int stream) const override;
+  using MeshResource::colours;
+
+  /// Populate a mesh creation packet declaring the first transfer level.
+  /// @param packet A packet to populate and send.
+  /// @return Zero on success, an error code otherwise.
+  int create(PacketWriter &packet) const override;
+
+  /// Populate the next mesh data packet, progressing through the transfer levels.
+  ///
+  /// The @c progress.progress value tracks the vertex index for the current component, with the
+  /// transfer level resolved from the @c levelEnds() .
+  ///
+  /// @param packet A packet to populate and send.
+  /// @param byte_limit A nominal byte limit on how much data a single @p transfer() call may add.
+  /// @param[in,out] progress A progress marker tracking how much has already been transferred.
+  /// @return Zero on success, an error code otherwise.
+  int transfer(PacketWriter &packet, unsigned byte_limit,
+               TransferProgress &progress) const override;
+
+private:
+  /// Select the next component phase with data for the current level, or @c MmtFinalise .
+  /// @param progress The progress to update.
+  /// @param level_begin The first vertex of the current level.
+  /// @param level_end The end of the current level.
+  void nextComponent(TransferProgress &progress, uint32_t level_begin, uint32_t level_end) const;
+
+  const MeshResource &_source;
+  DataBuffer _vertices;
+  DataBuffer _normals;
+  DataBuffer _colours;
+  DataBuffer _uvs;
+  std::vector<uint32_t> _level_ends;
+  unsigned _base_count = kDefaultBaseCount;
+  unsigned _refine_factor = kDefaultRefineFactor;
+};
+}  // namespace tes
@@ -40,11 +40,13 @@ list(APPEND PUBLIC_HEADERS
   PacketStreamReader.h
   PacketWriter.h
   PlaneGeom.h
+  PointOctree.h
   Ptr.h
   Quaternion.h
   Quaternion.inl
   QuaternionArg.h
   Resource.h
+  ResourcePacketCache.h
   ResourcePacker.h
   Rotation.h
   Rotation.inl
@@ -52,6 +54,9 @@ list(APPEND PUBLIC_HEADERS
   ServerApi.h
   ServerApiMinimal.h
   ServerUtil.h
+  ShapeRegistry.h
+  ShapeTimeline.h
+  SharedMemoryRing.h
   StreamUtil.h
   TcpListenSocket.h
   TcpSocket.h
@@ -65,6 +70,7 @@ list(APPEND PUBLIC_HEADERS
   Vector3.h
   Vector4.h
   VectorHash.h
+  WriteBehindFile.h
   DataBuffer.h
   DataBuffer.inl
 )
@@ -86,6 +92,7 @@ list(APPEND PUBLIC_SHAPE_HEADERS
   shapes/MutableMesh.h
   shapes/Plane.h
   shapes/PointCloud.h
+  shapes/ProgressivePoints.h
   shapes/Pose.h
   shapes/Shape.h
   shapes/Shapes.h
@@ -99,6 +106,7 @@ list(APPEND PUBLIC_SHAPE_HEADERS
 list(APPEND PUBLIC_TESSELLATE_HEADERS
   tessellate/Arrow.h
   tessellate/Box.h
+  tessellate/Cache.h
   tessellate/Capsule.h
   tessellate/Cone.h
   tessellate/Cylinder.h
@@ -133,13 +141,18 @@ list(APPEND SOURCES
   PacketStreamReader.cpp
   PacketWriter.cpp
   PlaneGeom.cpp
+  PointOctree.cpp
   Ptr.cpp
   Quaternion.cpp
   Resource.cpp
+  ResourcePacketCache.cpp
   ResourcePacker.cpp
   Rotation.cpp
   ServerApi.cpp
   ServerApiOff.cpp
+  ShapeRegistry.cpp
+  ShapeTimeline.cpp
+  SharedMemoryRing.cpp
   StreamUtil.cpp
   Throw.cpp
   Timer.cpp
@@ -147,6 +160,7 @@ list(APPEND SOURCES
   TriGeom.cpp
   Vector3.cpp
   Vector4.cpp
+  WriteBehindFile.cpp
   DataBuffer.cpp
 
   shapes/Arrow.cpp
@@ -163,6 +177,7 @@ list(APPEND SOURCES
   shapes/Plane.cpp
   shapes/PointCloud.cpp
   shapes/Pose.cpp
+  shapes/ProgressivePoints.cpp
   shapes/Shape.cpp
   shapes/Shapes.cpp
   shapes/SimpleMesh.cpp
@@ -173,6 +188,7 @@ list(APPEND SOURCES
 
   tessellate/Arrow.cpp
   tessellate/Box.cpp
+  tessellate/Cache.cpp
   tessellate/Capsule.cpp
   tessellate/Cone.cpp
   tessellate/Cylinder.cpp
@@ -182,21 +198,30 @@ list(APPEND SOURCES
 list(APPEND PRIVATE_SOURCES
   private/CollatedPacketZip.cpp
   private/CollatedPacketZip.h
+  private/SharedMemoryConnection.cpp
+  private/SharedMemoryConnection.h
+  private/SharedMemoryDetail.h
+  private/StateCache.cpp
+  private/StateCache.h
   private/TcpConnection.cpp
   private/TcpConnection.h
   private/TcpConnectionMonitor.cpp
   private/TcpConnectionMonitor.h
   private/TcpServer.cpp
   private/TcpServer.h
+  private/UpdateTracker.cpp
+  private/UpdateTracker.h
 )
 
 if(MSVC)
   list(APPEND PRIVATE_SOURCES
     win/Debug.cpp
+    win/SharedMemoryDetail.cpp
   )
 else(MSVC)
   list(APPEND PRIVATE_SOURCES
     nix/Debug.cpp
+    nix/SharedMemoryDetail.cpp
   )
 endif(MSVC)
 
@@ -30,5 +30,7 @@ struct TcpListenSocketDetail
 {
   int listen_socket = -1;
   struct sockaddr_in address = {};
+  /// Read and write ends of the pipe used to wake a blocking @c accept() . Unused on Windows.
+  int wake_pipe[2] = { -1, -1 };  // NOLINT(modernize-avoid-c-arrays)
 };
 }  // namespace tes
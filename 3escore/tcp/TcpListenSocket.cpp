@@ -9,8 +9,15 @@
 
 #include "TcpDetail.h"
 
+#include <array>
 #include <cstring>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif  // !WIN32
+
 namespace tes
 {
 namespace
@@ -53,6 +60,47 @@ bool acceptConnection(TcpListenSocketDetail &server, TcpSocketDetail &client)
   // tcpbase::dumpSocketOptions(client.socket);
   return true;
 }
+
+#ifndef WIN32
+bool openWakePipe(TcpListenSocketDetail &server)
+{
+  if (::pipe(server.wake_pipe) != 0)
+  {
+    server.wake_pipe[0] = server.wake_pipe[1] = -1;
+    return false;
+  }
+
+  // Non-blocking so a wake never blocks and draining stops when empty.
+  for (const int fd : server.wake_pipe)
+  {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  return true;
+}
+
+
+void closeWakePipe(TcpListenSocketDetail &server)
+{
+  for (int &fd : server.wake_pipe)
+  {
+    if (fd != -1)
+    {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+}
+
+
+void drainWakePipe(TcpListenSocketDetail &server)
+{
+  std::array<char, 64> buffer;
+  while (::read(server.wake_pipe[0], buffer.data(), buffer.size()) > 0)
+  {
+  }
+}
+#endif  // !WIN32
 }  // namespace
 
 TcpListenSocket::TcpListenSocket()
@@ -105,6 +153,14 @@ bool TcpListenSocket::listen(unsigned short port)
 
   // printf("Listening on port %d\n", tcpbase::getSocketPort(_detail->listenSocket));
 
+#ifndef WIN32
+  if (!openWakePipe(*_detail))
+  {
+    close();
+    return false;
+  }
+#endif  // !WIN32
+
   return true;
 }
 
@@ -117,6 +173,9 @@ void TcpListenSocket::close()
     _detail->listen_socket = -1;
     memset(&_detail->address, 0, sizeof(_detail->address));
   }
+#ifndef WIN32
+  closeWakePipe(*_detail);
+#endif  // !WIN32
 }
 
 
@@ -128,30 +187,40 @@ bool TcpListenSocket::isListening() const
 
 std::shared_ptr<TcpSocket> TcpListenSocket::accept(unsigned timeout_ms)
 {
-  struct timeval timeout;
-  fd_set fd_read = {};
-
   if (_detail->listen_socket < 0)
   {
     return {};
   }
 
-  // use select() to avoid blocking on accept()
-
-  FD_ZERO(&fd_read);                         // Clear the set of selected objects
-  FD_SET(_detail->listen_socket, &fd_read);  // Add socket to read set
-
-  tcpbase::timevalFromMs(timeout, timeout_ms);
-
-  if (::select(_detail->listen_socket + 1, &fd_read, nullptr, nullptr, &timeout) < 0)
+  // Use poll() to avoid blocking on accept(), also waiting on the wake pipe so another thread may
+  // interrupt the wait.
+#ifdef WIN32
+  std::array<WSAPOLLFD, 1> fds = {};
+  fds[0].fd = static_cast<SOCKET>(_detail->listen_socket);
+  fds[0].events = POLLRDNORM;
+  if (::WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), static_cast<INT>(timeout_ms)) <= 0)
+  {
+    return {};
+  }
+#else   // WIN32
+  std::array<pollfd, 2> fds = {};
+  fds[0].fd = _detail->listen_socket;
+  fds[0].events = POLLIN;
+  fds[1].fd = _detail->wake_pipe[0];
+  fds[1].events = POLLIN;
+  if (::poll(fds.data(), fds.size(), static_cast<int>(timeout_ms)) <= 0)
   {
     return {};
   }
 
-  // Test if the socket file descriptor (m_sockLocal) is part of the
-  // set returned by select().  If not, then select() timed out.
+  if (fds[1].revents & POLLIN)
+  {
+    drainWakePipe(*_detail);
+    return {};
+  }
+#endif  // WIN32
 
-  if (FD_ISSET(_detail->listen_socket, &fd_read) == 0)
+  if ((fds[0].revents & POLLIN) == 0)
   {
     return {};
   }
@@ -165,4 +234,17 @@ std::shared_ptr<TcpSocket> TcpListenSocket::accept(unsigned timeout_ms)
 
   return std::make_shared<TcpSocket>(std::move(client_detail));
 }
+
+
+void TcpListenSocket::wake()
+{
+#ifndef WIN32
+  if (_detail->wake_pipe[1] != -1)
+  {
+    const char byte = 0;
+    // A full pipe already has a wake pending, so failure may be ignored.
+    [[maybe_unused]] const auto written = ::write(_detail->wake_pipe[1], &byte, 1);
+  }
+#endif  // !WIN32
+}
 }  // namespace tes
@@ -16,6 +16,8 @@
 
 #ifdef WIN32
 #include <Ws2tcpip.h>
+#else  // WIN32
+#include <poll.h>
 #endif  // WIN32
 
 namespace tes
@@ -296,6 +298,27 @@ int TcpSocket::readAvailable(char *buffer, int buffer_length) const
 }
 
 
+bool TcpSocket::waitForData(unsigned timeout_ms) const
+{
+  if (_detail->socket == -1)
+  {
+    return false;
+  }
+
+#ifdef WIN32
+  WSAPOLLFD fd = {};
+  fd.fd = static_cast<SOCKET>(_detail->socket);
+  fd.events = POLLRDNORM;
+  return ::WSAPoll(&fd, 1, static_cast<INT>(timeout_ms)) > 0;
+#else   // WIN32
+  pollfd fd = {};
+  fd.fd = _detail->socket;
+  fd.events = POLLIN;
+  return ::poll(&fd, 1, static_cast<int>(timeout_ms)) > 0;
+#endif  // WIN32
+}
+
+
 int TcpSocket::write(const char *buffer, int buffer_length) const
 {
   if (_detail->socket == -1)
@@ -0,0 +1,129 @@
+//
+// author: Kazys Stepanas
+//
+#include "Cache.h"
+
+#include "Arrow.h"
+#include "Cone.h"
+#include "Cylinder.h"
+#include "Sphere.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tes::tessellate
+{
+Cache &Cache::instance()
+{
+  static Cache cache;
+  return cache;
+}
+
+
+MeshPtr Cache::solid(CachedShape shape, unsigned lod)
+{
+  const auto shape_index = static_cast<unsigned>(shape);
+  if (shape_index >= static_cast<unsigned>(CachedShape::Count))
+  {
+    return std::make_shared<const Mesh>();
+  }
+  lod = std::min(lod, kLodCount - 1);
+
+  {
+    const std::scoped_lock guard(_lock);
+    if (const auto &cached = _meshes[shape_index][lod])
+    {
+      return cached;
+    }
+  }
+
+  // Generate outside of the lock. We may generate twice on a race, but only one result is kept.
+  auto mesh = std::make_shared<const Mesh>(generate(shape, lod));
+
+  const std::scoped_lock guard(_lock);
+  auto &cached = _meshes[shape_index][lod];
+  if (!cached)
+  {
+    cached = std::move(mesh);
+  }
+  return cached;
+}
+
+
+Mesh Cache::generate(CachedShape shape, unsigned lod)
+{
+  lod = std::min(lod, kLodCount - 1);
+  Mesh mesh;
+
+  constexpr unsigned kBaseFacets = 24;
+  const unsigned facets = facetsForLod(kBaseFacets, lod);
+
+  switch (shape)
+  {
+  case CachedShape::Sphere: {
+    constexpr unsigned kBaseDepth = 3;
+    sphere::solid(mesh.vertices, mesh.indices, mesh.normals, 1.0f, Vector3f(0.0f),
+                  std::max(1u, kBaseDepth - lod));
+    break;
+  }
+  case CachedShape::Cylinder:
+    cylinder::solid(mesh.vertices, mesh.indices, mesh.normals, Vector3f(0, 0, 1), 1.0f, 1.0f,
+                    facets);
+    break;
+  case CachedShape::Cone: {
+    // Calculate the cone angle for a unit radius and unit length: a = atan(r/h)
+    constexpr float kConeLength = 1.0f;
+    constexpr float kConeRadius = 1.0f;
+    const float cone_angle = std::atan(kConeRadius / kConeLength);
+    cone::solid(mesh.vertices, mesh.indices, mesh.normals, Vector3f(0, 0, kConeLength),
+                Vector3f(0, 0, kConeLength), kConeLength, cone_angle, facets);
+    break;
+  }
+  case CachedShape::Arrow: {
+    constexpr float kHeadRadius = 1.5f;
+    constexpr float kCylinderRadius = 1.0f;
+    constexpr float kCylinderLength = 0.81f;
+    constexpr float kArrowLength = 1.0f;
+    arrow::solid(mesh.vertices, mesh.indices, mesh.normals, facets, kHeadRadius, kCylinderRadius,
+                 kCylinderLength, kArrowLength);
+    break;
+  }
+  case CachedShape::CapsuleBody:
+    cylinder::solid(mesh.vertices, mesh.indices, mesh.normals, Vector3f(0, 0, 1), 1.0f, 1.0f,
+                    facets, true);
+    break;
+  case CachedShape::CapsuleTop:
+  case CachedShape::CapsuleBottom: {
+    constexpr unsigned kBaseRings = 4;
+    const unsigned rings = std::max(1u, kBaseRings >> lod);
+    const float axis_sign = (shape == CachedShape::CapsuleBottom) ? -1.0f : 1.0f;
+    sphere::solidLatLong(mesh.vertices, mesh.indices, mesh.normals, 1.0f, Vector3f(0.0f), rings,
+                         facets, Vector3f(0, 0, axis_sign), true);
+    break;
+  }
+  default:
+    break;
+  }
+
+  return mesh;
+}
+
+
+unsigned Cache::facetsForLod(unsigned base_facets, unsigned lod, unsigned min_facets)
+{
+  return std::max(min_facets, base_facets >> std::min(lod, kLodCount - 1));
+}
+
+
+void Cache::clear()
+{
+  const std::scoped_lock guard(_lock);
+  for (auto &lods : _meshes)
+  {
+    for (auto &mesh : lods)
+    {
+      mesh.reset();
+    }
+  }
+}
+}  // namespace tes::tessellate
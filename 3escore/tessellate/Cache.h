@@ -0,0 +1,108 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include <3escore/CoreConfig.h>
+
+#include <3escore/Vector3.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tes::tessellate
+{
+/// Unit shapes which may be generated and shared via the tessellation @c Cache .
+///
+/// Each shape is tessellated at unit scale matching the scaling semantics of the corresponding
+/// 3es shape messages, such that the shape instance transform can be applied directly.
+enum class CachedShape : unsigned
+{
+  /// Unit radius sphere at the origin.
+  Sphere,
+  /// Cylinder of unit radius and unit length along the Z axis, centred on the origin.
+  Cylinder,
+  /// Cone with its apex at (0, 0, 1), unit length and a unit radius base at the origin.
+  Cone,
+  /// Arrow of unit length along the Z axis starting at the origin.
+  Arrow,
+  /// The open cylinder body of a unit capsule. Matches @c Cylinder without end caps.
+  CapsuleBody,
+  /// The top hemisphere of a unit capsule, built at the origin (see @c capsule::solid() ).
+  CapsuleTop,
+  /// The bottom hemisphere of a unit capsule, built at the origin (see @c capsule::solid() ).
+  CapsuleBottom,
+
+  Count
+};
+
+/// An immutable, tessellated mesh as stored in the @c Cache .
+struct TES_CORE_API Mesh
+{
+  /// Mesh vertices.
+  std::vector<Vector3f> vertices;
+  /// Per vertex normals.
+  std::vector<Vector3f> normals;
+  /// Triangle indices.
+  std::vector<unsigned> indices;
+};
+
+/// Shared pointer to a cached, immutable @c Mesh .
+using MeshPtr = std::shared_ptr<const Mesh>;
+
+/// A process wide cache of tessellated shapes at various levels of detail (LOD).
+///
+/// The @c tes::sphere, @c tes::cylinder, etc tessellation functions regenerate the mesh on every
+/// call. The cache generates each @c CachedShape once per LOD on first request and hands out
+/// shared, immutable buffers thereafter.
+///
+/// LOD zero is the highest level of detail, with each subsequent level approximately halving the
+/// tessellation resolution down to @c kLodCount - 1.
+///
+/// The cache is thread safe.
+class TES_CORE_API Cache
+{
+public:
+  /// Number of LOD levels supported for each shape.
+  static constexpr unsigned kLodCount = 3;
+
+  /// Access the global cache instance.
+  /// @return The cache singleton.
+  static Cache &instance();
+
+  /// Request a solid mesh for @p shape at the given @p lod .
+  ///
+  /// The mesh is generated on the first request.
+  ///
+  /// @param shape The shape to request.
+  /// @param lod The level of detail. Clamped to the range `[0, kLodCount)`.
+  /// @return The cached mesh. Never null.
+  [[nodiscard]] MeshPtr solid(CachedShape shape, unsigned lod = 0);
+
+  /// Generate the solid mesh for @p shape at the given @p lod without using the cache.
+  /// @param shape The shape to generate.
+  /// @param lod The level of detail. Clamped to the range `[0, kLodCount)`.
+  /// @return The generated mesh.
+  [[nodiscard]] static Mesh generate(CachedShape shape, unsigned lod);
+
+  /// Query the number of facets used for a facet based shape at @p lod . The number of facets is
+  /// halved per LOD from @p base_facets , to a minimum of @p min_facets .
+  /// @param base_facets The number of facets at LOD zero.
+  /// @param lod The level of detail.
+  /// @param min_facets The minimum facet count.
+  /// @return The number of facets to use.
+  [[nodiscard]] static unsigned facetsForLod(unsigned base_facets, unsigned lod,
+                                             unsigned min_facets = 6);
+
+  /// Release all cached meshes. Existing @c MeshPtr references remain valid.
+  void clear();
+
+private:
+  Cache() = default;
+
+  std::mutex _lock;
+  std::array<std::array<MeshPtr, kLodCount>, static_cast<unsigned>(CachedShape::Count)> _meshes;
+};
+}  // namespace tes::tessellate
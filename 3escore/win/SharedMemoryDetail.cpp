@@ -0,0 +1,78 @@
+//
+// author: Kazys Stepanas
+//
+#include "../private/SharedMemoryDetail.h"
+
+#include <chrono>
+#include <thread>
+
+// Shared memory rings are not yet supported on Windows. All mapping operations fail.
+
+namespace tes::shm
+{
+size_t pageSize()
+{
+  return 4096u;
+}
+
+
+bool createMapping(Mapping &mapping, const std::string &name, size_t size)
+{
+  (void)mapping;
+  (void)name;
+  (void)size;
+  return false;
+}
+
+
+bool openMapping(Mapping &mapping, const std::string &name)
+{
+  (void)mapping;
+  (void)name;
+  return false;
+}
+
+
+void unlinkMapping(Mapping &mapping)
+{
+  mapping.owns_name = false;
+}
+
+
+void closeMapping(Mapping &mapping)
+{
+  mapping.memory = nullptr;
+  mapping.size = 0;
+  mapping.owns_name = false;
+}
+
+
+void wait(std::atomic_uint32_t &word, uint32_t expected, unsigned timeout_ms)
+{
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (word.load(std::memory_order_acquire) == expected &&
+         std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::yield();
+  }
+}
+
+
+void wake(std::atomic_uint32_t &word)
+{
+  (void)word;
+}
+
+
+uint32_t processId()
+{
+  return 0;
+}
+
+
+bool processAlive(uint32_t pid)
+{
+  (void)pid;
+  return false;
+}
+}  // namespace tes::shm
@@ -0,0 +1,251 @@
+#include "HeadlessScene.h"
+
+#include "BoundsCuller.h"
+
+#include "data/Snapshot.h"
+
+#include "handler/Camera.h"
+#include "handler/Category.h"
+#include "handler/MeshResource.h"
+#include "handler/MeshSet.h"
+#include "handler/MeshShape.h"
+#include "handler/Shape.h"
+#include "handler/Text2D.h"
+#include "handler/Text3D.h"
+
+#include "painter/Capsule.h"
+#include "painter/Cylinder.h"
+#include "painter/ShapePainter.h"
+
+#include <3escore/Connection.h>
+#include <3escore/Log.h>
+#include <3escore/PacketReader.h>
+
+namespace tes::view
+{
+HeadlessScene::HeadlessScene()
+  : _culler(std::make_shared<BoundsCuller>())
+{
+  initDefaultServerInfo(&_server_info);
+  initialiseHandlers();
+}
+
+
+HeadlessScene::~HeadlessScene() = default;
+
+
+void HeadlessScene::reset(std::function<bool()> abort)
+{
+  // Nothing to wait on, so there is nothing to abort.
+  (void)abort;
+  const std::scoped_lock guard(_mutex);
+  for (auto &handler : _ordered_message_handlers)
+  {
+    handler->reset();
+  }
+}
+
+
+void HeadlessScene::updateToFrame(FrameNumber frame)
+{
+  const std::scoped_lock guard(_mutex);
+  // Effect the frame as ThirdEyeScene does across the data and main threads.
+  for (auto &handler : _ordered_message_handlers)
+  {
+    handler->endFrame(_stamp);
+  }
+  _stamp.frame_number = frame;
+  ++_stamp.render_mark;
+  for (auto &handler : _ordered_message_handlers)
+  {
+    handler->prepareFrame(_stamp);
+  }
+  ++_stats.frame_count;
+}
+
+
+void HeadlessScene::updateServerInfo(const ServerInfoMessage &server_info)
+{
+  const std::scoped_lock guard(_mutex);
+  _server_info = server_info;
+  for (auto &handler : _ordered_message_handlers)
+  {
+    handler->updateServerInfo(_server_info);
+  }
+}
+
+
+void HeadlessScene::processMessage(PacketReader &packet)
+{
+  const std::scoped_lock guard(_mutex);
+  ++_stats.message_count;
+  _stats.byte_count += packet.packetSize();
+
+  const auto &handler = _message_handlers[packet.routingId()];
+  if (handler)
+  {
+    handler->readMessage(packet);
+  }
+  else
+  {
+    ++_stats.unhandled_count;
+  }
+}
+
+
+std::pair<bool, FrameNumber> HeadlessScene::saveSnapshot(const std::filesystem::path &path,
+                                                         std::function<bool()> cancel_snapshot)
+{
+  data::Snapshot snapshot;
+  std::vector<handler::Message::SnapshotTask> tasks;
+  {
+    const std::scoped_lock guard(_mutex);
+    snapshot.frame_number = _stamp.frame_number;
+    snapshot.server_info = _server_info;
+    snapshot.chunks.resize(_ordered_message_handlers.size());
+    tasks.reserve(_ordered_message_handlers.size());
+    for (size_t i = 0; i < _ordered_message_handlers.size(); ++i)
+    {
+      snapshot.chunks[i].routing_id = _ordered_message_handlers[i]->routingId();
+      tasks.emplace_back(_ordered_message_handlers[i]->snapshot());
+    }
+  }
+
+  // Encode the captured state without holding the lock. There is no render thread to free up, so
+  // the tasks run in turn.
+  bool ok = true;
+  for (size_t i = 0; i < tasks.size() && ok; ++i)
+  {
+    if (tasks[i])
+    {
+      ok = tasks[i](snapshot.chunks[i]) && !(cancel_snapshot && cancel_snapshot());
+    }
+  }
+
+  ok = ok && snapshot.save(path);
+  return { ok, snapshot.frame_number };
+}
+
+
+std::pair<bool, FrameNumber> HeadlessScene::saveSnapshot(tes::Connection &connection,
+                                                         std::function<bool()> cancel_snapshot)
+{
+  (void)cancel_snapshot;
+  const std::scoped_lock guard(_mutex);
+  const bool ok = writeState(connection);
+  return { ok, _stamp.frame_number };
+}
+
+
+bool HeadlessScene::loadSnapshot(const std::filesystem::path &path)
+{
+  data::Snapshot snapshot;
+  if (!snapshot.load(path))
+  {
+    return false;
+  }
+
+  return snapshot.restore(*this, [this](uint16_t routing_id, data::SnapshotReader &reader) {
+    const std::scoped_lock guard(_mutex);
+    const auto &handler = _message_handlers[routing_id];
+    if (!handler)
+    {
+      log::warn("No message handler to restore snapshot data for routing ID ", routing_id);
+      return true;
+    }
+    return handler->restore(reader);
+  });
+}
+
+
+FrameNumber HeadlessScene::frame() const
+{
+  const std::scoped_lock guard(_mutex);
+  return _stamp.frame_number;
+}
+
+
+ServerInfoMessage HeadlessScene::serverInfo() const
+{
+  const std::scoped_lock guard(_mutex);
+  return _server_info;
+}
+
+
+HeadlessScene::Stats HeadlessScene::stats() const
+{
+  const std::scoped_lock guard(_mutex);
+  return _stats;
+}
+
+
+void HeadlessScene::initialiseHandlers()
+{
+  // Primitive shape painters track the shapes without any meshes or shaders.
+  using BoundsCalculator = painter::ShapePainter::BoundsCalculator;
+  const auto make_painter = [this](const BoundsCalculator &bounds_calculator) {
+    return std::make_shared<painter::ShapePainter>(_culler, bounds_calculator);
+  };
+  const BoundsCalculator spherical = painter::ShapeCache::calcSphericalBounds;
+
+  // Mirror the ThirdEyeScene handler order.
+  _category_handler = std::make_shared<handler::Category>();
+  _ordered_message_handlers.emplace_back(_category_handler);
+  _camera_handler = std::make_shared<handler::Camera>();
+  _ordered_message_handlers.emplace_back(_camera_handler);
+
+  _ordered_message_handlers.emplace_back(
+    std::make_shared<handler::Shape>(SIdSphere, "sphere", make_painter(spherical)));
+  _ordered_message_handlers.emplace_back(
+    std::make_shared<handler::Shape>(SIdBox, "box", make_painter(spherical)));
+  _ordered_message_handlers.emplace_back(
+    std::make_shared<handler::Shape>(SIdCone, "cone", make_painter(spherical)));
+  _ordered_message_handlers.emplace_back(std::make_shared<handler::Shape>(
+    SIdCylinder, "cylinder", make_painter(painter::Cylinder::calculateBounds)));
+  _ordered_message_handlers.emplace_back(std::make_shared<handler::Shape>(
+    SIdCapsule, "capsule", make_painter(painter::Capsule::calculateBounds)));
+  _ordered_message_handlers.emplace_back(
+    std::make_shared<handler::Shape>(SIdPlane, "plane", make_painter(spherical)));
+  _ordered_message_handlers.emplace_back(
+    std::make_shared<handler::Shape>(SIdStar, "star", make_painter(spherical)));
+  _ordered_message_handlers.emplace_back(
+    std::make_shared<handler::Shape>(SIdArrow, "arrow", make_painter(spherical)));
+  _ordered_message_handlers.emplace_back(
+    std::make_shared<handler::Shape>(SIdPose, "pose", make_painter(spherical)));
+
+  auto mesh_resources = std::make_shared<handler::MeshResource>(nullptr);
+  _ordered_message_handlers.emplace_back(mesh_resources);
+  _ordered_message_handlers.emplace_back(std::make_shared<handler::MeshShape>(_culler, nullptr));
+  _ordered_message_handlers.emplace_back(
+    std::make_shared<handler::MeshSet>(_culler, mesh_resources));
+
+  _ordered_message_handlers.emplace_back(std::make_shared<handler::Text2D>(nullptr));
+  _ordered_message_handlers.emplace_back(std::make_shared<handler::Text3D>(nullptr));
+
+  for (auto &handler : _ordered_message_handlers)
+  {
+    handler->setModeFlags(handler->modeFlags() |
+                          static_cast<unsigned>(handler::Message::ModeFlag::Headless));
+    handler->initialise();
+    handler->updateServerInfo(_server_info);
+    if (!_message_handlers[handler->routingId()])
+    {
+      _message_handlers.set(handler->routingId(), handler);
+    }
+  }
+}
+
+
+bool HeadlessScene::writeState(tes::Connection &connection)
+{
+  // Matches ThirdEyeScene protocol message snapshots.
+  bool ok = connection.sendServerInfo(_server_info);
+  for (const auto &handler : _ordered_message_handlers)
+  {
+    handler->serialise(connection);
+  }
+  ok = connection.updateTransfers(0) != -1 && ok;
+  ok = connection.updateFrame(0.0f, true) != -1 && ok;
+  return ok;
+}
+}  // namespace tes::view
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "3esview/ViewConfig.h"
+
+#include "FrameStamp.h"
+#include "SceneProcessor.h"
+
+#include "util/RoutingTable.h"
+
+#include <3escore/Messages.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tes::view
+{
+class BoundsCuller;
+
+namespace handler
+{
+class Camera;
+class Category;
+class Message;
+}  // namespace handler
+
+/// A @c SceneProcessor which maintains the scene state for a 3es stream without creating any
+/// rendering resources.
+///
+/// This supports processing recordings where there is no GPU or OpenGL context, such as for
+/// validating or analysing recordings, generating snapshots or benchmarking the decoding pipeline.
+/// Drive the scene with a @c data::StreamThread , using @c data::StreamThread::setFreeRunning() to
+/// process the stream as fast as possible, then query the scene state.
+///
+/// The scene runs the same message handlers as @c ThirdEyeScene in
+/// @c handler::Message::ModeFlag::Headless mode, so the state matches what the viewer would show.
+/// The handlers for primitive shapes use @c painter::ShapePainter objects which track shapes
+/// without render resources, while the text handlers have no painter. Query the state through the
+/// handlers, using @c messageHandler() .
+///
+/// As with @c ThirdEyeScene , changes are effected by @c updateToFrame() . Each frame update calls
+/// @c handler::Message::endFrame() then @c handler::Message::prepareFrame() for every handler.
+///
+/// The @c SceneProcessor functions and the scene queries are thread safe. The handler state must
+/// only be read while no messages are being processed, such as from the data thread or while the
+/// stream is paused.
+class TES_VIEWER_API HeadlessScene : public SceneProcessor
+{
+public:
+  /// Message processing statistics.
+  struct Stats
+  {
+    /// Number of messages processed.
+    uint64_t message_count = 0;
+    /// Number of message bytes processed, including packet headers.
+    uint64_t byte_count = 0;
+    /// Number of messages with unsupported routing IDs.
+    uint64_t unhandled_count = 0;
+    /// Number of frames ended.
+    uint64_t frame_count = 0;
+  };
+
+  /// Constructor.
+  HeadlessScene();
+  HeadlessScene(const HeadlessScene &other) = delete;
+  /// Destructor.
+  ~HeadlessScene() override;
+
+  HeadlessScene &operator=(const HeadlessScene &other) = delete;
+
+  void reset(std::function<bool()> abort = {}) override;
+  void updateToFrame(FrameNumber frame) override;
+  void updateServerInfo(const ServerInfoMessage &server_info) override;
+  void processMessage(PacketReader &packet) override;
+
+  /// Save a binary snapshot of the current state to @p path .
+  ///
+  /// This uses the same @c data::Snapshot format as @c ThirdEyeScene::saveSnapshot() , capturing
+  /// each handler's @c handler::Message::snapshot() , so the snapshots are interchangeable. Use the
+  /// @c Connection overload to write a snapshot using protocol messages.
+  ///
+  /// @param path The path to save the snapshot to.
+  /// @param cancel_snapshot Cancellation function, checked between handlers. May be empty.
+  /// @return A pair containing a boolean success indicator and the frame number which has been
+  /// saved.
+  std::pair<bool, FrameNumber> saveSnapshot(const std::filesystem::path &path,
+                                            std::function<bool()> cancel_snapshot) override;
+  /// This overload of @c saveSnapshot() writes the snapshot to the given @p connection.
+  /// @param connection The connection to write to.
+  /// @param cancel_snapshot Cancellation function. Unused as the snapshot is written immediately.
+  /// @return A pair containing a boolean success indicator and the frame number which has been
+  /// saved.
+  std::pair<bool, FrameNumber> saveSnapshot(tes::Connection &connection,
+                                            std::function<bool()> cancel_snapshot) override;
+
+  /// Restore a snapshot written by @c saveSnapshot() to a file path, or by
+  /// @c ThirdEyeScene::saveSnapshot() .
+  ///
+  /// The restored state is effected by the next @c updateToFrame() call.
+  ///
+  /// @param path The snapshot file to load.
+  /// @return True on success.
+  bool loadSnapshot(const std::filesystem::path &path) override;
+
+  /// Query the last frame number given to @c updateToFrame() .
+  /// @return The current frame number.
+  [[nodiscard]] FrameNumber frame() const;
+
+  /// Query the current server info.
+  /// @return The server info.
+  [[nodiscard]] ServerInfoMessage serverInfo() const;
+
+  /// Query the message processing statistics.
+  /// @return The current statistics.
+  [[nodiscard]] Stats stats() const;
+
+  /// Access the bounds culler shared by the handlers.
+  /// @return The bounds culler.
+  [[nodiscard]] std::shared_ptr<BoundsCuller> culler() const { return _culler; }
+
+  [[nodiscard]] handler::Camera &cameraHandler() { return *_camera_handler; }
+  [[nodiscard]] const handler::Camera &cameraHandler() const { return *_camera_handler; }
+  [[nodiscard]] handler::Category &categoryHandler() { return *_category_handler; }
+  [[nodiscard]] const handler::Category &categoryHandler() const { return *_category_handler; }
+
+  /// Query the message handler for @p routing_id .
+  /// @param routing_id The routing ID of interest.
+  /// @return The handler or null if @p routing_id is not handled.
+  [[nodiscard]] std::shared_ptr<handler::Message> messageHandler(uint32_t routing_id) const
+  {
+    return _message_handlers[routing_id];
+  }
+
+private:
+  void initialiseHandlers();
+  bool writeState(tes::Connection &connection);
+
+  mutable std::mutex _mutex;
+  ServerInfoMessage _server_info = {};
+  std::shared_ptr<BoundsCuller> _culler;
+  std::shared_ptr<handler::Camera> _camera_handler;
+  std::shared_ptr<handler::Category> _category_handler;
+  /// Message handlers by routing ID.
+  util::RoutingTable<std::shared_ptr<handler::Message>> _message_handlers;
+  /// Message handlers in the same order as @c ThirdEyeScene .
+  std::vector<std::shared_ptr<handler::Message>> _ordered_message_handlers;
+  Stats _stats;
+  FrameStamp _stamp = {};
+};
+}  // namespace tes::view
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "3esview/ViewConfig.h"
+
+#include "FrameStamp.h"
+
+#include <3escore/Messages.h>
+
+#include <filesystem>
+#include <functional>
+#include <utility>
+
+namespace tes
+{
+class Connection;
+class PacketReader;
+}  // namespace tes
+
+namespace tes::view
+{
+/// The interface through which a @c data::StreamThread feeds a 3es stream into a scene.
+///
+/// This is implemented by @c ThirdEyeScene for rendering and by @c HeadlessScene , which maintains
+/// the scene state without any rendering resources.
+///
+/// The @c processMessage() , @c updateToFrame() , @c updateServerInfo() , @c reset() and
+/// @c loadSnapshot() functions are called from the data thread.
+class TES_VIEWER_API SceneProcessor
+{
+public:
+  virtual ~SceneProcessor() = default;
+
+  /// Reset the current state, clearing all the scene data.
+  /// @param abort Optional abort check. Called to check if reset should be aborted (return value
+  /// true to abort).
+  virtual void reset(std::function<bool()> abort = {}) = 0;
+
+  /// Update to the target frame number, effecting the messages processed since the last call.
+  /// @param frame The new frame number.
+  virtual void updateToFrame(FrameNumber frame) = 0;
+
+  /// Updates the server information details.
+  /// @param server_info The new server info.
+  virtual void updateServerInfo(const ServerInfoMessage &server_info) = 0;
+
+  /// Process a message from the server. Not called for @c MtControl messages.
+  /// @param packet The message packet.
+  virtual void processMessage(PacketReader &packet) = 0;
+
+  /// Save a snapshot of the current frame to @p path . The snapshot is restored using
+  /// @c loadSnapshot() .
+  /// @param path The path to save the snapshot to.
+  /// @param cancel_snapshot Cancellation function. This should return true if the snapshot request
+  /// is cancelled by the requesting thread.
+  /// @return A pair containing a boolean success indicator and the frame number which has been
+  /// saved.
+  virtual std::pair<bool, FrameNumber> saveSnapshot(const std::filesystem::path &path,
+                                                    std::function<bool()> cancel_snapshot) = 0;
+  /// Write a snapshot of the current frame to @p connection as protocol messages.
+  /// @param connection The connection to write to.
+  /// @param cancel_snapshot Cancellation function.
+  /// @return A pair containing a boolean success indicator and the frame number which has been
+  /// saved.
+  virtual std::pair<bool, FrameNumber> saveSnapshot(tes::Connection &connection,
+                                                    std::function<bool()> cancel_snapshot) = 0;
+
+  /// Restore a snapshot written by @c saveSnapshot() to a file path.
+  /// @param path The snapshot file to load.
+  /// @return True on success.
+  virtual bool loadSnapshot(const std::filesystem::path &path) = 0;
+};
+}  // namespace tes::view
@@ -2,6 +2,9 @@
 
 #include "EdlEffect.h"
 
+#include "data/MessageDispatcher.h"
+#include "data/Snapshot.h"
+
 #include "handler/Camera.h"
 #include "handler/Category.h"
 #include "handler/MeshResource.h"
@@ -32,9 +35,9 @@
 #include "shaders/VertexColour.h"
 #include "shaders/VoxelGeom.h"
 
-#include <3escore/FileConnection.h>
 #include <3escore/Finally.h>
 #include <3escore/Log.h>
+#include <3escore/PacketReader.h>
 
 #include <Magnum/GL/Context.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
@@ -44,6 +47,8 @@
 #include <Magnum/GL/Version.h>
 #include <Magnum/Text/DistanceFieldGlyphCache.h>
 
+#include <algorithm>
+#include <future>
 #include <iterator>
 
 // Things to learn about:
@@ -148,6 +153,7 @@ void ThirdEyeScene::clearActiveFboEffect()
 
 void ThirdEyeScene::reset(std::function<bool()> abort)
 {
+  waitForDispatch();
   std::unique_lock lock(_render_mutex);
   bool aborted = false;
   if (std::this_thread::get_id() == _main_thread_id)
@@ -260,6 +266,8 @@ void ThirdEyeScene::updateToFrame(FrameNumber frame, camera::Camera &camera)
 {
   // Called from the data thread, not the main thread.
   // Must invoke endFrame() between prepareFrame() and draw() calls.
+  // Frame barrier: all messages for this frame must be read before endFrame().
+  waitForDispatch();
   const std::lock_guard guard(_render_mutex);
   if (frame != _render_stamp.frame_number)
   {
@@ -291,12 +299,19 @@ void ThirdEyeScene::updateServerInfo(const ServerInfoMessage &server_info)
 
 void ThirdEyeScene::processMessage(PacketReader &packet)
 {
-  auto handler = _message_handlers.find(packet.routingId());
-  if (handler != _message_handlers.end())
+  const auto &handler = _message_handlers[packet.routingId()];
+  if (handler)
   {
-    handler->second->readMessage(packet);
+    if (_dispatcher)
+    {
+      _dispatcher->dispatch(handler, packet);
+    }
+    else
+    {
+      handler->readMessage(packet);
+    }
   }
-  else if (_unknown_handlers.find(packet.routingId()) == _unknown_handlers.end())
+  else if (!_unknown_handlers[packet.routingId()])
   {
     const auto known_ids = defaultHandlerNames();
     const auto search = known_ids.find(packet.routingId());
@@ -308,7 +323,33 @@ void ThirdEyeScene::processMessage(PacketReader &packet)
     {
       log::error("No message handler for ", search->second);
     }
-    _unknown_handlers.emplace(packet.routingId());
+    _unknown_handlers[packet.routingId()] = true;
+  }
+}
+
+
+void ThirdEyeScene::setDispatchThreads(unsigned thread_count)
+{
+  // Release the current dispatcher first. This waits for pending messages.
+  _dispatcher = nullptr;
+  if (thread_count > 0)
+  {
+    _dispatcher = std::make_unique<data::MessageDispatcher>(thread_count);
+  }
+}
+
+
+unsigned ThirdEyeScene::dispatchThreads() const
+{
+  return (_dispatcher) ? _dispatcher->threadCount() : 0u;
+}
+
+
+void ThirdEyeScene::waitForDispatch()
+{
+  if (_dispatcher)
+  {
+    _dispatcher->wait();
   }
 }
 
@@ -319,7 +360,7 @@ void ThirdEyeScene::handlePendingSnapshot()
   if (_snapshot_wait.waiting == SnapshotState::Waiting)
   {
     _snapshot_wait.frame_number = _render_stamp.frame_number;
-    if (_snapshot_wait.connection && saveCurrentFrameSnapshot(*_snapshot_wait.connection))
+    if (_snapshot_wait.action && (*_snapshot_wait.action)())
     {
       _snapshot_wait.waiting = SnapshotState::Success;
     }
@@ -337,35 +378,97 @@ void ThirdEyeScene::handlePendingSnapshot()
 std::pair<bool, FrameNumber> ThirdEyeScene::saveSnapshot(const std::filesystem::path &path,
                                                          std::function<bool()> cancel_snapshot)
 {
-  // Note(KS): The server settings are irrelevant for a file connection. We can use teh default.
-  // Arguably this implies the Connection constructor should be refactored.
-  FileConnection out(path.string(), ServerSettings());
-  const auto result = saveSnapshot(out, std::move(cancel_snapshot));
-  out.close();
-  return result;
+  data::Snapshot snapshot;
+  std::vector<handler::Message::SnapshotTask> tasks;
+  const auto [captured, frame_number] = runSnapshotAction(
+    [this, &snapshot, &tasks]() {
+      captureSnapshot(snapshot, tasks);
+      return true;
+    },
+    cancel_snapshot);
+
+  if (!captured)
+  {
+    return { false, 0 };
+  }
+
+  // Encode each handler's captured state in parallel. This no longer involves the main thread.
+  std::vector<std::future<bool>> results;
+  results.reserve(tasks.size());
+  for (size_t i = 0; i < tasks.size(); ++i)
+  {
+    if (tasks[i])
+    {
+      results.emplace_back(std::async(std::launch::async, [&task = tasks[i],
+                                                           &chunk = snapshot.chunks[i]]() {
+        return task(chunk);
+      }));
+    }
+  }
+
+  bool ok = true;
+  for (auto &result : results)
+  {
+    ok = result.get() && ok;
+  }
+
+  ok = ok && !cancel_snapshot() && snapshot.save(path);
+  return { ok, frame_number };
 }
 
 
 std::pair<bool, FrameNumber> ThirdEyeScene::saveSnapshot(tes::Connection &connection,
                                                          std::function<bool()> cancel_snapshot)
+{
+  return runSnapshotAction([this, &connection]() { return saveCurrentFrameSnapshot(connection); },
+                           cancel_snapshot);
+}
+
+
+bool ThirdEyeScene::loadSnapshot(const std::filesystem::path &path)
+{
+  data::Snapshot snapshot;
+  if (!snapshot.load(path))
+  {
+    return false;
+  }
+
+  return snapshot.restore(*this, [this](uint16_t routing_id, data::SnapshotReader &reader) {
+    const auto &handler = _message_handlers[routing_id];
+    if (!handler)
+    {
+      log::warn("No message handler to restore snapshot data for routing ID ", routing_id);
+      return true;
+    }
+
+    // Make sure any dispatched packets for the handler have been read first.
+    waitForDispatch();
+    return handler->restore(reader);
+  });
+}
+
+
+std::pair<bool, FrameNumber>
+  ThirdEyeScene::runSnapshotAction(const std::function<bool()> &action,
+                                   const std::function<bool()> &cancel_snapshot)
 {
   std::unique_lock guard(_snapshot_wait.mutex);
 
   if (std::this_thread::get_id() == _main_thread_id)
   {
-    // Main thread. Save now.
-    const bool ok = saveCurrentFrameSnapshot(connection);
+    // Main thread. Run now.
+    const bool ok = action();
     return { ok, _render_stamp.frame_number };
   }
 
-  if (_snapshot_wait.connection)
+  if (_snapshot_wait.action)
   {
     // Already waiting on a snapshot
     return { false, 0 };
   }
 
   const auto at_exit = finally([this]() { _snapshot_wait.clear(); });
-  _snapshot_wait.connection = &connection;
+  _snapshot_wait.action = &action;
 
   // Block until signalled on the wait condition.
   _snapshot_wait.waiting = SnapshotState::Waiting;
@@ -529,7 +632,7 @@ void ThirdEyeScene::effectReset()
   {
     handler->reset();
   }
-  _unknown_handlers.clear();
+  std::fill(_unknown_handlers.begin(), _unknown_handlers.end(), false);
   ++_reset_marker;
   _reset = false;
   // Slight inefficiency as we notify while the mutex is still locked.
@@ -540,7 +643,7 @@ void ThirdEyeScene::effectReset()
 void ThirdEyeScene::initialiseFont()
 {
   // TODO(KS): get resources strings passed in as it's the exe which must include the resources.
-  _text_painter = std::make_shared<painter::Text>(_font_manager);
+  _text_painter = std::make_shared<painter::Text>(_culler, _font_manager);
 }
 
 
@@ -608,7 +711,10 @@ void ThirdEyeScene::initialiseHandlers()
   for (auto &handler : _ordered_message_handlers)
   {
     handler->initialise();
-    _message_handlers.emplace(handler->routingId(), handler);
+    if (!_message_handlers[handler->routingId()])
+    {
+      _message_handlers.set(handler->routingId(), handler);
+    }
   }
 }
 
@@ -689,6 +795,23 @@ void ThirdEyeScene::onCameraConfigChange(const settings::Settings::Config &confi
 }
 
 
+void ThirdEyeScene::captureSnapshot(data::Snapshot &snapshot,
+                                    std::vector<handler::Message::SnapshotTask> &tasks)
+{
+  snapshot.frame_number = _render_stamp.frame_number;
+  snapshot.server_info = _server_info;
+  snapshot.chunks.clear();
+  snapshot.chunks.resize(_ordered_message_handlers.size());
+  tasks.clear();
+  tasks.reserve(_ordered_message_handlers.size());
+  for (size_t i = 0; i < _ordered_message_handlers.size(); ++i)
+  {
+    snapshot.chunks[i].routing_id = _ordered_message_handlers[i]->routingId();
+    tasks.emplace_back(_ordered_message_handlers[i]->snapshot());
+  }
+}
+
+
 bool ThirdEyeScene::saveCurrentFrameSnapshot(tes::Connection &connection)
 {
   // Write the server info message. We don't need a frame count.
@@ -5,11 +5,14 @@
 #include "BoundsCuller.h"
 #include "FramesPerSecondWindow.h"
 #include "FrameStamp.h"
+#include "SceneProcessor.h"
 
 #include "camera/Fly.h"
 
 #include "painter/ShapeCache.h"
 
+#include "util/RoutingTable.h"
+
 #include "settings/Settings.h"
 
 #include <3escore/Messages.h>
@@ -29,11 +32,11 @@
 #include <chrono>
 #include <condition_variable>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <thread>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace tes
@@ -55,6 +58,13 @@ class Category;
 class Message;
 }  // namespace handler
 
+namespace data
+{
+class MessageDispatcher;
+struct Snapshot;
+struct SnapshotChunk;
+}  // namespace data
+
 namespace painter
 {
 class CategoryState;
@@ -67,7 +77,7 @@ namespace shaders
 class ShaderLibrary;
 }  // namespace shaders
 
-class TES_VIEWER_API ThirdEyeScene
+class TES_VIEWER_API ThirdEyeScene : public SceneProcessor
 {
 public:
   using ResetCallback = std::function<void()>;
@@ -77,7 +87,7 @@ public:
   explicit ThirdEyeScene(const std::vector<settings::Extension> &extended_settings = {});
   ThirdEyeScene(const ThirdEyeScene &other) = delete;
   /// Destructor.
-  ~ThirdEyeScene();
+  ~ThirdEyeScene() override;
 
   ThirdEyeScene &operator=(const ThirdEyeScene &other) = delete;
 
@@ -120,12 +130,7 @@ public:
 
   [[nodiscard]] std::shared_ptr<handler::Message> messageHandler(uint32_t routing_id)
   {
-    const auto find = _message_handlers.find(routing_id);
-    if (find != _message_handlers.end())
-    {
-      return find->second;
-    }
-    return {};
+    return _message_handlers[routing_id];
   }
 
   /// Query the current frame rate : frames per second.
@@ -141,7 +146,7 @@ public:
   ///
   /// @param abort Optional abort check. Called to check if reset should be aborted (return value
   /// true to abort).
-  void reset(std::function<bool()> abort = {});
+  void reset(std::function<bool()> abort = {}) override;
 
   const ResetCallback &resetCallback() const { return _reset_callback; }
   void setResetCallback(ResetCallback callback) { _reset_callback = std::move(callback); }
@@ -169,7 +174,7 @@ public:
   /// @param[out] camera_out Retrieves the current camera position.
   void updateToFrame(FrameNumber frame, camera::Camera &camera_out);
   /// @overload
-  void updateToFrame(FrameNumber frame);
+  void updateToFrame(FrameNumber frame) override;
 
   /// Updates the server information details.
   ///
@@ -178,7 +183,7 @@ public:
   ///
   /// Threadsafe.
   /// @param server_info The new server info.
-  void updateServerInfo(const ServerInfoMessage &server_info);
+  void updateServerInfo(const ServerInfoMessage &server_info) override;
 
   /// Process a message from the server. This is routed to the appropriate message handler.
   ///
@@ -187,16 +192,40 @@ public:
   /// @note Message handling must be thread safe as this method is mostly called from a background
   /// thread. This constraint is placed on the message handlers.
   ///
+  /// When parallel dispatch is enabled, the message is queued for a worker thread. See
+  /// @c setDispatchThreads() .
+  ///
   /// @param packet
-  void processMessage(PacketReader &packet);
+  void processMessage(PacketReader &packet) override;
+
+  /// Enable parallel message dispatch using the given number of worker threads.
+  ///
+  /// With parallel dispatch, @c processMessage() queues messages for their handler using a
+  /// @c data::MessageDispatcher . Messages for each handler are read serially and in order, but
+  /// different handlers read messages concurrently. Dispatch is synchronised at frame boundaries
+  /// in @c updateToFrame() and before @c reset() .
+  ///
+  /// This must not be called while a data thread is calling @c processMessage() .
+  ///
+  /// @param thread_count Number of dispatch threads. Zero disables parallel dispatch, reading
+  /// messages on the calling thread.
+  void setDispatchThreads(unsigned thread_count);
+
+  /// Query the number of parallel dispatch threads.
+  /// @return The number of dispatch threads, zero when dispatch is synchronous.
+  [[nodiscard]] unsigned dispatchThreads() const;
 
-  /// Save a snapshot of the last displayed frame to @p path .
+  /// Save a binary snapshot of the last displayed frame to @p path .
   ///
-  /// The snapshot represents the current frame state, encoding all persistent shapes.
+  /// The snapshot represents the current frame state using the @c data::Snapshot format. This can
+  /// be restored using @c loadSnapshot() , but is not a valid 3es stream. Use the @c Connection
+  /// overload to write a snapshot using protocol messages.
   ///
-  /// This function is thread save in that it can be called from any thread. On the main thread,
-  /// this immediately saves the last frame. From other threads, it blocks that thread until the
-  /// main thread is able to save the snapshot after the next @c prepareFrame() .
+  /// This function is thread save in that it can be called from any thread. The main thread only
+  /// captures a copy of each handler's state - see @c handler::Message::snapshot() . The handler
+  /// state is then encoded in parallel and written on the calling thread. From threads other than
+  /// the main thread, this blocks until the main thread is able to capture the state after the
+  /// next @c prepareFrame() .
   ///
   /// @param path The path to save the snapshot to.
   /// @param cancel_snapshot Cancellation function. This should return true if the snapshot request
@@ -204,7 +233,7 @@ public:
   /// @return A pair containing a boolean success indicator and the frame number which has been
   /// saved.
   std::pair<bool, FrameNumber> saveSnapshot(const std::filesystem::path &path,
-                                            std::function<bool()> cancel_snapshot);
+                                            std::function<bool()> cancel_snapshot) override;
   /// This overload of @c saveSnapshot() writes the snapshot to the given @p connection.
   /// @param connection The connection to write to.
   /// @param cancel_snapshot Cancellation function. This should return true if the snapshot request
@@ -212,7 +241,16 @@ public:
   /// @return A pair containing a boolean success indicator and the frame number which has been
   /// saved.
   std::pair<bool, FrameNumber> saveSnapshot(tes::Connection &connection,
-                                            std::function<bool()> cancel_snapshot);
+                                            std::function<bool()> cancel_snapshot) override;
+
+  /// Restore a snapshot written by @c saveSnapshot() to a file path.
+  ///
+  /// This must be called from the data thread in the same way as @c processMessage() , typically
+  /// after a @c reset() . The restored state is effected by the next @c updateToFrame() call.
+  ///
+  /// @param path The snapshot file to load.
+  /// @return True on success.
+  bool loadSnapshot(const std::filesystem::path &path) override;
 
   void createSampleShapes();
 
@@ -220,6 +258,10 @@ private:
   /// Effect (do/execute) a pending reset.
   void effectReset();
 
+  /// Wait for all messages queued by the @c _dispatcher to be read. Does nothing when parallel
+  /// dispatch is disabled.
+  void waitForDispatch();
+
   void initialiseFont();
   void initialiseHandlers();
   void initialiseShaders();
@@ -249,11 +291,25 @@ private:
   /// Handle pending snapshot if waiting.
   void handlePendingSnapshot();
 
+  /// Run @p action on the main thread for @c saveSnapshot() . Blocks until the main thread has run
+  /// the action after the next @c prepareFrame() , or runs it immediately on the main thread.
+  /// @param action The action to run. Returns true on success.
+  /// @param cancel_snapshot Cancellation function.
+  /// @return A pair containing the @p action result and the frame number at the time it ran.
+  std::pair<bool, FrameNumber> runSnapshotAction(const std::function<bool()> &action,
+                                                 const std::function<bool()> &cancel_snapshot);
+
   /// Implements the detail of @c saveSnapshot() .
   /// @param connection Connection object to write the snapshot to. May be a @c FileConnection .
   /// @return True on success.
   bool saveCurrentFrameSnapshot(tes::Connection &connection);
 
+  /// Capture the handler state for a binary snapshot. Must be called on the main thread.
+  /// @param snapshot The snapshot to initialise. A chunk is added for each handler.
+  /// @param tasks Populated with the @c handler::Message::SnapshotTask for each chunk.
+  void captureSnapshot(data::Snapshot &snapshot,
+                       std::vector<std::function<bool(data::SnapshotChunk &)>> &tasks);
+
   /// Load the @c Settings from the default config location for the current platform.
   void restoreSettings();
   /// Save the @c Settings from the default config location for the current platform.
@@ -274,15 +330,19 @@ private:
   std::shared_ptr<shaders::ShaderLibrary> _shader_library;
 
   std::unordered_map<ShapeHandlerId, std::shared_ptr<painter::ShapePainter>> _painters;
-  std::unordered_map<uint32_t, std::shared_ptr<handler::Message>> _message_handlers;
+  /// Message handlers indexed by routing ID.
+  util::RoutingTable<std::shared_ptr<handler::Message>> _message_handlers;
   /// Message handers arranged by update order..
   std::vector<std::shared_ptr<handler::Message>> _ordered_message_handlers;
   /// Message handlers arranged by draw order, effected during the @c drawPrimary() call.
   std::vector<std::shared_ptr<handler::Message>> _main_draw_handlers;
   /// Message handlers arranged by draw order, effected during the @c drawSecondary() call.
   std::vector<std::shared_ptr<handler::Message>> _secondary_draw_handlers;
-  /// List of unknown message handlers for which we've raised warnings. Cleared on @c reset().
-  std::unordered_set<uint32_t> _unknown_handlers;
+  /// Flags unknown message routing IDs for which we've raised warnings, indexed by routing ID.
+  /// Cleared on @c reset().
+  std::vector<bool> _unknown_handlers = std::vector<bool>(util::RoutingTable<bool>::kMaxSize);
+  /// Parallel message dispatcher. Null for synchronous message handling.
+  std::unique_ptr<data::MessageDispatcher> _dispatcher;
 
   handler::Camera *_camera_handler = nullptr;
   handler::Category *_category_handler = nullptr;
@@ -307,14 +367,14 @@ private:
   {
     std::mutex mutex;
     std::condition_variable signal;
-    /// Connection object to save the next snapshot to.
-    Connection *connection = nullptr;
+    /// Action to run on the main thread for the next snapshot.
+    const std::function<bool()> *action = nullptr;
     SnapshotState waiting = SnapshotState::None;
     FrameNumber frame_number = 0;
 
     void clear()
     {
-      connection = nullptr;
+      action = nullptr;
       waiting = SnapshotState::None;
       frame_number = 0;
     }
@@ -9,6 +9,8 @@
 #include "data/NetworkThread.h"
 #include "data/StreamThread.h"
 
+#include "handler/MeshResource.h"
+
 #include "painter/Arrow.h"
 #include "painter/Box.h"
 #include "painter/Capsule.h"
@@ -118,9 +120,11 @@ void CommandLineOptions::addOptions(cxxopts::Options &parser)
   parser.add_options()
     ("help", "Show command line help.")
     ("file", "Start the UI and open this file for playback. Takes precedence over --host.", cxxopts::value(filename))
-    ("host", "Start the UI and open a connection to this host URL/IP. Use --port to select the port number.", cxxopts::value(server.host))
+    ("host", "Start the UI and open a connection to this host URL/IP. Use --port to select the port number. Use 'shm' to connect to a server on the same host via shared memory.", cxxopts::value(server.host))
     ("port", "The port number to use with --host", cxxopts::value(server.port)->default_value(std::to_string(server.port)))
     ("log-level", "Minimum logging level to display: [trace, info, warn, error].", cxxopts::value(console_log_level))
+    ("dispatch-threads", "Number of threads used to read incoming messages in parallel, one message handler per thread at a time. Zero reads messages on the data thread.", cxxopts::value(dispatch_threads)->default_value(std::to_string(dispatch_threads)))
+    ("receive-buffer", "Socket receive buffer size for network connections (bytes). A larger buffer supports higher throughput from the server.", cxxopts::value(receive_buffer_size)->default_value(std::to_string(receive_buffer_size)))
     ;
   // clang-format on
 }
@@ -166,6 +170,7 @@ Viewer::Viewer(const ViewArguments &arguments,
 
   CommandLineOptions::StartupMode startup_mode;
   _command_line_options = arguments.parseArgs(startup_mode);
+  _tes->setDispatchThreads(_command_line_options->dispatch_threads);
   if (!handleStartupArgs(startup_mode))
   {
     exit();
@@ -233,7 +238,8 @@ bool Viewer::connect(const std::string &host, uint16_t port, bool allow_reconnec
 {
   closeOrDisconnect();
   _tes->reset();
-  auto net_thread = std::make_shared<data::NetworkThread>(_tes, host, port, allow_reconnect);
+  auto net_thread = std::make_shared<data::NetworkThread>(
+    _tes, host, port, allow_reconnect, _command_line_options->receive_buffer_size);
   _data_thread = net_thread;
   if (!allow_reconnect)
   {
@@ -499,6 +505,11 @@ void Viewer::onRenderSettingsChange(const settings::Settings::Config &config)
   _edl_effect->setLinearScale(render.edl_linear_scale.value());
   _edl_effect->setExponentialScale(render.edl_exponential_scale.value());
   _edl_effect->setRadius(static_cast<float>(render.edl_radius.value()));
+  if (auto mesh_resources =
+        std::dynamic_pointer_cast<handler::MeshResource>(_tes->messageHandler(MtMesh)))
+  {
+    mesh_resources->setPointBudget(render.point_budget.value());
+  }
   if (render.use_edl_shader.value())
   {
     _tes->setActiveFboEffect(_edl_effect);
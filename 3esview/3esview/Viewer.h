@@ -83,6 +83,10 @@ struct TES_VIEWER_API CommandLineOptions
   ServerEndPoint server;
 
   log::Level console_log_level = log::Level::Warn;
+  /// Number of parallel message dispatch threads. Zero for synchronous dispatch.
+  unsigned dispatch_threads = 0;
+  /// Socket receive buffer size for network connections (bytes).
+  int receive_buffer_size = 4 * 1024 * 1024;
 
   CommandLineOptions() = default;
   CommandLineOptions(const CommandLineOptions &other) = default;
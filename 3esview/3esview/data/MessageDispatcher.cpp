@@ -0,0 +1,144 @@
+//
+// Author: Kazys Stepanas
+//
+#include "MessageDispatcher.h"
+
+#include <3esview/handler/Message.h>
+
+#include <3escore/PacketReader.h>
+
+#include <algorithm>
+
+namespace tes::view::data
+{
+MessageDispatcher::MessageDispatcher(unsigned thread_count)
+{
+  if (thread_count == 0)
+  {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  _threads.reserve(thread_count);
+  for (unsigned i = 0; i < thread_count; ++i)
+  {
+    _threads.emplace_back([this]() { run(); });
+  }
+}
+
+
+MessageDispatcher::~MessageDispatcher()
+{
+  wait();
+  {
+    const std::lock_guard guard(_mutex);
+    _quit = true;
+  }
+  _work_signal.notify_all();
+  for (auto &thread : _threads)
+  {
+    thread.join();
+  }
+}
+
+
+void MessageDispatcher::dispatch(const std::shared_ptr<handler::Message> &handler,
+                                 const PacketReader &packet)
+{
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto *bytes = reinterpret_cast<const uint8_t *>(&packet.packet());
+  const size_t byte_count = packet.packetSize();
+
+  std::unique_lock guard(_mutex);
+  // Apply back pressure when the workers fall too far behind.
+  _idle_signal.wait(guard, [this]() {
+    return _pending_bytes < kMaxPendingBytes || _scheduled_count == 0;
+  });
+
+  auto &queue = _queues[handler.get()];
+  if (!queue)
+  {
+    queue = std::make_unique<Queue>();
+    queue->handler = handler;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  queue->pending.insert(queue->pending.end(), bytes, bytes + byte_count);
+  _pending_bytes += byte_count;
+
+  if (!queue->scheduled)
+  {
+    queue->scheduled = true;
+    ++_scheduled_count;
+    _ready.emplace_back(queue.get());
+    guard.unlock();
+    _work_signal.notify_one();
+  }
+}
+
+
+void MessageDispatcher::wait()
+{
+  std::unique_lock guard(_mutex);
+  _idle_signal.wait(guard, [this]() { return _scheduled_count == 0; });
+}
+
+
+void MessageDispatcher::run()
+{
+  std::vector<uint8_t> batch;
+  std::unique_lock guard(_mutex);
+  while (true)
+  {
+    _work_signal.wait(guard, [this]() { return _quit || !_ready.empty(); });
+    if (_ready.empty())
+    {
+      // Quitting.
+      break;
+    }
+
+    Queue *queue = _ready.front();
+    _ready.pop_front();
+
+    // Take the pending packets and process them outside the lock. The queue remains scheduled, so
+    // no other worker will take it.
+    batch.clear();
+    std::swap(batch, queue->pending);
+    _pending_bytes -= batch.size();
+    guard.unlock();
+    _idle_signal.notify_all();
+
+    read(*queue->handler, batch);
+
+    guard.lock();
+    if (!queue->pending.empty())
+    {
+      // More data arrived while we were reading.
+      _ready.emplace_back(queue);
+      _work_signal.notify_one();
+    }
+    else
+    {
+      queue->scheduled = false;
+      if (--_scheduled_count == 0)
+      {
+        _idle_signal.notify_all();
+      }
+    }
+  }
+}
+
+
+void MessageDispatcher::read(handler::Message &handler, const std::vector<uint8_t> &data)
+{
+  size_t offset = 0;
+  while (offset + sizeof(PacketHeader) <= data.size())
+  {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto *header = reinterpret_cast<const PacketHeader *>(data.data() + offset);
+    PacketReader packet(header);
+    const size_t packet_size = packet.packetSize();
+    handler.readMessage(packet);
+    offset += packet_size;
+  }
+}
+}  // namespace tes::view::data
@@ -0,0 +1,103 @@
+//
+// Author: Kazys Stepanas
+//
+#pragma once
+
+#include <3esview/ViewConfig.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace tes
+{
+class PacketReader;
+}  // namespace tes
+
+namespace tes::view::handler
+{
+class Message;
+}  // namespace tes::view::handler
+
+namespace tes::view::data
+{
+/// Dispatches incoming messages to their @c handler::Message objects using a pool of worker
+/// threads.
+///
+/// Each message handler has its own queue of pending packets. A handler's queue is processed by at
+/// most one worker at a time, so each handler still sees its messages serially and in order, while
+/// different handlers read their messages in parallel. This prevents large data bursts for one
+/// handler - such as mesh resource data - from holding up messages for other handlers.
+///
+/// The data thread must call @c wait() at each frame boundary - @c CIdFrame - before ending the
+/// frame. This ensures all messages for the frame have been read before
+/// @c handler::Message::endFrame() is called.
+///
+/// Packet data are copied on @c dispatch() . The dispatcher blocks @c dispatch() calls while the
+/// total size of the pending packets exceeds @c kMaxPendingBytes .
+class TES_VIEWER_API MessageDispatcher
+{
+public:
+  /// Maximum bytes which may be queued before @c dispatch() blocks.
+  static constexpr size_t kMaxPendingBytes = 64u * 1024u * 1024u;
+
+  /// Create a dispatcher with the given number of worker threads.
+  /// @param thread_count The number of worker threads. Zero selects the hardware concurrency.
+  explicit MessageDispatcher(unsigned thread_count);
+  MessageDispatcher(const MessageDispatcher &other) = delete;
+  /// Destructor. Waits for pending messages, then stops the worker threads.
+  ~MessageDispatcher();
+
+  MessageDispatcher &operator=(const MessageDispatcher &other) = delete;
+
+  /// Query the number of worker threads.
+  /// @return The worker thread count.
+  [[nodiscard]] unsigned threadCount() const { return static_cast<unsigned>(_threads.size()); }
+
+  /// Queue @p packet for reading by @p handler .
+  /// @param handler The handler to read the packet.
+  /// @param packet The packet to read. The packet data are copied.
+  void dispatch(const std::shared_ptr<handler::Message> &handler, const PacketReader &packet);
+
+  /// Block until all dispatched messages have been read.
+  void wait();
+
+private:
+  /// Pending messages for a single handler.
+  struct Queue
+  {
+    /// The handler to read the messages.
+    std::shared_ptr<handler::Message> handler;
+    /// Pending packet data. Packets are stored contiguously.
+    std::vector<uint8_t> pending;
+    /// True while the queue is either ready for a worker or being processed by a worker.
+    bool scheduled = false;
+  };
+
+  /// Worker thread entry point.
+  void run();
+
+  /// Read all the packets in @p data using @p handler .
+  static void read(handler::Message &handler, const std::vector<uint8_t> &data);
+
+  std::mutex _mutex;
+  /// Signalled when a queue is ready or on quit.
+  std::condition_variable _work_signal;
+  /// Signalled when all queues become idle or pending bytes are released.
+  std::condition_variable _idle_signal;
+  std::unordered_map<const handler::Message *, std::unique_ptr<Queue>> _queues;
+  /// Queues ready for processing.
+  std::deque<Queue *> _ready;
+  /// Number of queues scheduled - ready or in progress.
+  size_t _scheduled_count = 0;
+  /// Number of pending bytes across all queues.
+  size_t _pending_bytes = 0;
+  bool _quit = false;
+  std::vector<std::thread> _threads;
+};
+}  // namespace tes::view::data
@@ -14,6 +14,7 @@
 #include <3escore/PacketBuffer.h>
 #include <3escore/PacketReader.h>
 #include <3escore/PacketStreamReader.h>
+#include <3escore/SharedMemoryRing.h>
 #include <3escore/TcpSocket.h>
 
 #include <cinttypes>
@@ -21,11 +22,34 @@
 
 namespace tes::view::data
 {
+namespace
+{
+/// Adapts a @c SharedMemoryRing to the @c TcpSocket read API used by @c NetworkThread::runWith() .
+/// Reads block briefly on the ring doorbell rather than spinning when there is no data.
+struct RingStream
+{
+  /// Time to block waiting for data (milliseconds).
+  static constexpr unsigned kWaitMs = 10u;
+
+  SharedMemoryRing &ring;
+
+  [[nodiscard]] bool isConnected() const { return ring.isConnected(); }
+  int readAvailable(uint8_t *buffer, int buffer_length)
+  {
+    return ring.read(buffer, buffer_length, kWaitMs);
+  }
+  // Reads already block on the doorbell.
+  [[nodiscard]] bool waitForData([[maybe_unused]] unsigned timeout_ms) const { return true; }
+};
+}  // namespace
+
+
 NetworkThread::NetworkThread(std::shared_ptr<ThirdEyeScene> tes, std::string host, uint16_t port,
-                             bool allow_reconnect)
+                             bool allow_reconnect, int receive_buffer_size)
   : _allow_reconnect(allow_reconnect)
   , _host(std::move(host))
   , _port(port)
+  , _receive_buffer_size(receive_buffer_size)
 {
   _tes = std::exchange(tes, nullptr);
   _thread = std::thread([this] { run(); });
@@ -114,9 +138,15 @@ bool NetworkThread::endRecording()
 void NetworkThread::run()
 {
   using namespace std::chrono_literals;
-  auto socket = std::make_unique<TcpSocket>();
   constexpr auto kReconnectDelay = 200ms;
 
+  if (_host == SharedMemoryRing::kHostName)
+  {
+    runSharedMemory();
+    return;
+  }
+
+  auto socket = std::make_unique<TcpSocket>();
   do
   {
     const bool connected = socket->open(_host.c_str(), _port);
@@ -139,24 +169,56 @@ void NetworkThread::run()
 }
 
 
-void NetworkThread::configureSocket(TcpSocket &socket)
+void NetworkThread::configureSocket(TcpSocket &socket) const
 {
   socket.setNoDelay(true);
   socket.setReadTimeout(0);
   socket.setWriteTimeout(0);
-  socket.setReadBufferSize(1024 * 1024);
+  socket.setReadBufferSize(_receive_buffer_size);
   socket.setSendBufferSize(4 * 1024);
 }
 
 
-void NetworkThread::runWith(TcpSocket &socket)
+void NetworkThread::runSharedMemory()
+{
+  using namespace std::chrono_literals;
+  constexpr auto kReconnectDelay = 200ms;
+  const std::string name = SharedMemoryRing::nameForPort(_port);
+
+  do
+  {
+    auto ring = SharedMemoryRing::open(name);
+    _connected = ring != nullptr;
+    _connection_attempted = true;
+    if (!ring)
+    {
+      if (_allow_reconnect)
+      {
+        std::this_thread::sleep_for(kReconnectDelay);
+      }
+      continue;
+    }
+
+    RingStream stream{ *ring };
+    runWith(stream);
+    ring->close();
+    // Opening the ring fails immediately when there is no server, so only retry when reconnecting.
+  } while (_allow_reconnect && !_quit_flag);
+}
+
+
+template <typename Stream>
+void NetworkThread::runWith(Stream &socket)
 {
+  // Number of empty reads to spin through before waiting on the stream.
+  constexpr unsigned kSpinReads = 64u;
+  // Time to wait for data once spinning has failed to yield data (milliseconds).
+  constexpr unsigned kIdleWaitMs = 5u;
   CollatedPacketDecoder packet_decoder;
   bool have_server_info = false;
-  // We have two buffers here -> redundant.
-  // TODO(KS): change the PacketBuffer interface so we can read directly into it's buffer.
-  PacketBuffer packet_buffer;
-  std::vector<uint8_t> read_buffer(2048u);
+  PacketBuffer packet_buffer(kReadBlockSize);
+  std::vector<uint8_t> packet_data;
+  unsigned empty_reads = 0;
 
   _current_frame = 0;
   _total_frames = 0;
@@ -166,15 +228,23 @@ void NetworkThread::runWith(TcpSocket &socket)
 
   while (socket.isConnected() && !_quit_flag)
   {
-    auto bytes_read = socket.readAvailable(read_buffer.data(), int(read_buffer.size()));
+    auto bytes_read =
+      socket.readAvailable(packet_buffer.writeBuffer(kReadBlockSize), int(kReadBlockSize));
     if (bytes_read <= 0)
     {
+      // Spin briefly for low latency under load, then back off to waiting on the stream.
+      if (++empty_reads >= kSpinReads)
+      {
+        empty_reads = 0;
+        (void)socket.waitForData(kIdleWaitMs);
+      }
       continue;
     }
 
-    packet_buffer.addBytes(read_buffer.data(), int_cast<size_t>(bytes_read));
+    empty_reads = 0;
+    packet_buffer.commitBytes(int_cast<size_t>(bytes_read));
 
-    if (const auto *packet_header = packet_buffer.extractPacket(read_buffer))
+    while (const auto *packet_header = packet_buffer.extractPacket(packet_data))
     {
       packet_decoder.setPacket(packet_header);
 
@@ -26,6 +26,7 @@ class FileConnection;
 class PacketBuffer;
 class PacketReader;
 class PacketStreamReader;
+class SharedMemoryRing;
 class TcpSocket;
 }  // namespace tes
 
@@ -43,13 +44,29 @@ namespace tes::view::data
 class StreamRecorder;
 
 /// A @c DataThread implementation which reads and processes packets form a live network connection.
+///
+/// Connects over TCP unless the host is @c SharedMemoryRing::kHostName ("shm"), in which case the
+/// thread reads from the same host shared memory ring named for the port. See
+/// @c SharedMemoryRing::nameForPort() .
 class TES_VIEWER_API NetworkThread : public DataThread
 {
 public:
   using Clock = std::chrono::steady_clock;
 
+  /// Default socket receive buffer size (bytes).
+  static constexpr int kDefaultReceiveBufferSize = 4 * 1024 * 1024;
+  /// Size of the blocks read from the socket (bytes).
+  static constexpr size_t kReadBlockSize = 256u * 1024u;
+
+  /// Constructor.
+  /// @param tes The scene to process messages.
+  /// @param host The host to connect to, or @c SharedMemoryRing::kHostName .
+  /// @param port The port to connect on.
+  /// @param allow_reconnect Allow reconnecting after a connection failure, timeout or loss?
+  /// @param receive_buffer_size The socket receive buffer size (bytes). Larger buffers allow the
+  ///   server to keep sending while the thread processes messages.
   NetworkThread(std::shared_ptr<ThirdEyeScene> tes, std::string host, uint16_t port,
-                bool allow_reconnect = true);
+                bool allow_reconnect = true, int receive_buffer_size = kDefaultReceiveBufferSize);
   NetworkThread(const NetworkThread &other) = delete;
   ~NetworkThread() override;
 
@@ -63,6 +80,10 @@ public:
   /// @return The socket port.
   uint16_t port() const { return _port; }
 
+  /// The socket receive buffer size requested for TCP connections.
+  /// @return The receive buffer size (bytes).
+  int receiveBufferSize() const { return _receive_buffer_size; }
+
   /// Is the thread allowed keep trying to connect after a connection failure, timeout or loss?
   /// @return True if reconnection is allowed.
   bool allowReconnect() const { return _allow_reconnect; }
@@ -155,8 +176,20 @@ protected:
   void run();
 
 private:
-  static void configureSocket(TcpSocket &socket);
-  void runWith(TcpSocket &socket);
+  void configureSocket(TcpSocket &socket) const;
+  /// Run the read loop for a connected @p stream .
+  ///
+  /// Data are read in blocks of up to @c kReadBlockSize directly into a @c PacketBuffer and all
+  /// complete packets are processed after each read. When no data arrive, the loop spins briefly
+  /// then backs off to waiting on the stream so an idle connection does not hold a core.
+  ///
+  /// @tparam Stream The stream type. Must support @c isConnected() ,
+  ///   @c readAvailable(uint8_t*,int) and @c waitForData(unsigned) as per @c TcpSocket .
+  /// @param stream The stream to read.
+  template <typename Stream>
+  void runWith(Stream &stream);
+  /// Connect and read from a same host @c SharedMemoryRing .
+  void runSharedMemory();
 
   /// Process a control packet.
   ///
@@ -207,6 +240,7 @@ private:
   std::unique_ptr<StreamRecorder> _record;
   std::string _host;
   uint16_t _port = 0;
+  int _receive_buffer_size = kDefaultReceiveBufferSize;
   /// The scene manager.
   std::shared_ptr<ThirdEyeScene> _tes;
   std::thread _thread;
@@ -0,0 +1,230 @@
+//
+// Author: Kazys Stepanas
+//
+#include "Snapshot.h"
+
+#include <3esview/SceneProcessor.h>
+
+#include <3escore/Log.h>
+#include <3escore/PacketBuffer.h>
+#include <3escore/PacketReader.h>
+#include <3escore/Server.h>
+
+#include <cstring>
+#include <fstream>
+
+namespace tes::view::data
+{
+namespace
+{
+/// Snapshot file header.
+struct FileHeader
+{
+  uint32_t marker = Snapshot::kMarker;
+  uint32_t version = Snapshot::kVersion;
+  uint32_t frame_number = 0;
+  uint32_t chunk_count = 0;
+  ServerInfoMessage server_info = {};
+};
+
+/// Header preceding each chunk payload.
+struct ChunkHeader
+{
+  uint16_t routing_id = 0;
+  uint16_t format = 0;
+  uint32_t reserved = 0;
+  uint64_t payload_size = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<FileHeader>);
+static_assert(std::is_trivially_copyable_v<ChunkHeader>);
+
+template <typename T>
+bool writeStruct(std::ostream &out, const T &value)
+{
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  return out.good();
+}
+
+template <typename T>
+bool readStruct(std::istream &in, T &value)
+{
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  in.read(reinterpret_cast<char *>(&value), sizeof(value));
+  return in.good();
+}
+}  // namespace
+
+
+void SnapshotBuffer::writeBytes(const void *data, size_t byte_count)
+{
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  _data.insert(_data.end(), bytes, bytes + byte_count);
+}
+
+
+bool SnapshotReader::readBytes(void *data, size_t byte_count)
+{
+  if (byte_count > remaining())
+  {
+    return false;
+  }
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(data, _data + _position, byte_count);
+  _position += byte_count;
+  return true;
+}
+
+
+bool Snapshot::save(const std::filesystem::path &path) const
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open())
+  {
+    log::error("Unable to open snapshot file for writing: ", path.string());
+    return false;
+  }
+
+  FileHeader header = {};
+  header.frame_number = frame_number;
+  header.chunk_count = static_cast<uint32_t>(chunks.size());
+  header.server_info = server_info;
+  bool ok = writeStruct(out, header);
+
+  for (const auto &chunk : chunks)
+  {
+    if (!ok)
+    {
+      break;
+    }
+
+    ChunkHeader chunk_header = {};
+    chunk_header.routing_id = chunk.routing_id;
+    chunk_header.format = static_cast<uint16_t>(chunk.format);
+    chunk_header.payload_size = chunk.payload.data().size();
+    ok = writeStruct(out, chunk_header);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    out.write(reinterpret_cast<const char *>(chunk.payload.data().data()),
+              static_cast<std::streamsize>(chunk.payload.data().size()));
+    ok = ok && out.good();
+  }
+
+  if (!ok)
+  {
+    log::error("Failed to write snapshot file: ", path.string());
+  }
+  return ok;
+}
+
+
+bool Snapshot::load(const std::filesystem::path &path)
+{
+  chunks.clear();
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open())
+  {
+    return false;
+  }
+
+  FileHeader header = {};
+  if (!readStruct(in, header) || header.marker != kMarker)
+  {
+    log::error("Not a snapshot file: ", path.string());
+    return false;
+  }
+
+  if (header.version != kVersion)
+  {
+    log::error("Unsupported snapshot version ", header.version, ": ", path.string());
+    return false;
+  }
+
+  frame_number = header.frame_number;
+  server_info = header.server_info;
+  chunks.resize(header.chunk_count);
+  for (auto &chunk : chunks)
+  {
+    ChunkHeader chunk_header = {};
+    if (!readStruct(in, chunk_header))
+    {
+      log::error("Truncated snapshot file: ", path.string());
+      chunks.clear();
+      return false;
+    }
+
+    chunk.routing_id = chunk_header.routing_id;
+    chunk.format = static_cast<SnapshotFormat>(chunk_header.format);
+    auto &payload = chunk.payload.data();
+    payload.resize(static_cast<size_t>(chunk_header.payload_size));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    in.read(reinterpret_cast<char *>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    if (!in.good())
+    {
+      log::error("Truncated snapshot file: ", path.string());
+      chunks.clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool Snapshot::isSnapshot(const std::filesystem::path &path)
+{
+  std::ifstream in(path, std::ios::binary);
+  uint32_t marker = 0;
+  return in.is_open() && readStruct(in, marker) && marker == kMarker;
+}
+
+
+bool Snapshot::restore(SceneProcessor &scene, const RestoreChunk &restore_chunk) const
+{
+  scene.updateServerInfo(server_info);
+
+  bool ok = true;
+  PacketBuffer packet_buffer;
+  std::vector<uint8_t> packet_bytes;
+  for (const auto &chunk : chunks)
+  {
+    const auto &payload = chunk.payload.data();
+    if (payload.empty())
+    {
+      continue;
+    }
+
+    if (chunk.format == SnapshotFormat::Packets)
+    {
+      packet_buffer.addBytes(payload.data(), payload.size());
+      while (const PacketHeader *header = packet_buffer.extractPacket(packet_bytes))
+      {
+        PacketReader packet(header);
+        scene.processMessage(packet);
+      }
+      continue;
+    }
+
+    SnapshotReader reader(payload.data(), payload.size());
+    ok = restore_chunk(chunk.routing_id, reader) && ok;
+  }
+
+  return ok;
+}
+
+
+SnapshotConnection::SnapshotConnection(SnapshotChunk &chunk)
+  : BaseConnection(ServerSettings(0u))
+  , _chunk(chunk)
+{
+  _chunk.format = SnapshotFormat::Packets;
+}
+
+
+int SnapshotConnection::writeBytes(const uint8_t *data, int byte_count)
+{
+  _chunk.payload.writeBytes(data, static_cast<size_t>(byte_count));
+  return byte_count;
+}
+}  // namespace tes::view::data
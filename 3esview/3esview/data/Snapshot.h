@@ -0,0 +1,226 @@
+//
+// Author: Kazys Stepanas
+//
+#pragma once
+
+#include <3esview/ViewConfig.h>
+
+#include <3esview/FrameStamp.h>
+
+#include <3escore/BaseConnection.h>
+#include <3escore/Messages.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+namespace tes::view
+{
+class SceneProcessor;
+}  // namespace tes::view
+
+namespace tes::view::data
+{
+/// Identifies how a @c SnapshotChunk payload is encoded.
+enum class SnapshotFormat : uint16_t
+{
+  /// Handler specific binary data, restored by @c handler::Message::restore() .
+  Native,
+  /// A sequence of protocol packets, restored by routing each packet as an incoming message.
+  Packets
+};
+
+/// Buffer used to write the payload of a @c SnapshotChunk .
+///
+/// Values are written in native byte order. Snapshots are a local cache of the viewer state, such
+/// as keyframes, rather than a data exchange format. Arrays are written as a 64-bit element count
+/// followed by the raw element data, which allows structure of arrays data to be written and read
+/// with a single copy per array.
+class TES_VIEWER_API SnapshotBuffer
+{
+public:
+  /// Write a single value.
+  /// @param value The value to write. Must be trivially copyable.
+  template <typename T>
+  void write(const T &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshot values must be trivially copyable");
+    writeBytes(&value, sizeof(value));
+  }
+
+  /// Write an array of values, prefixed by the element count.
+  /// @param values The values to write. The element type must be trivially copyable.
+  template <typename T>
+  void writeArray(const std::vector<T> &values)
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshot values must be trivially copyable");
+    write(static_cast<uint64_t>(values.size()));
+    writeBytes(values.data(), values.size() * sizeof(T));
+  }
+
+  /// Write raw bytes.
+  /// @param data The data to write.
+  /// @param byte_count Number of bytes in @p data .
+  void writeBytes(const void *data, size_t byte_count);
+
+  /// Reserve space for at least @p byte_count additional bytes.
+  /// @param byte_count The number of bytes to reserve.
+  void reserve(size_t byte_count) { _data.reserve(_data.size() + byte_count); }
+
+  /// Access the written data.
+  /// @return The data buffer.
+  [[nodiscard]] const std::vector<uint8_t> &data() const { return _data; }
+  /// Access the written data for direct modification.
+  /// @return The data buffer.
+  [[nodiscard]] std::vector<uint8_t> &data() { return _data; }
+
+  /// Clear the buffer.
+  void clear() { _data.clear(); }
+
+private:
+  std::vector<uint8_t> _data;
+};
+
+/// Reader for the payload of a @c SnapshotChunk . The inverse of @c SnapshotBuffer .
+///
+/// All read functions fail without reading if there is insufficient data remaining.
+class TES_VIEWER_API SnapshotReader
+{
+public:
+  /// Create a reader for the given data. The data must outlive the reader.
+  /// @param data The data to read.
+  /// @param byte_count The number of bytes in @p data .
+  SnapshotReader(const uint8_t *data, size_t byte_count)
+    : _data(data)
+    , _byte_count(byte_count)
+  {}
+
+  /// Read a single value.
+  /// @param[out] value The value to read into.
+  /// @return True on success.
+  template <typename T>
+  bool read(T &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshot values must be trivially copyable");
+    return readBytes(&value, sizeof(value));
+  }
+
+  /// Read an array of values written by @c SnapshotBuffer::writeArray() .
+  /// @param[out] values The array to read into. Resized to match the stored element count.
+  /// @return True on success.
+  template <typename T>
+  bool readArray(std::vector<T> &values)
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshot values must be trivially copyable");
+    uint64_t count = 0;
+    if (!read(count) || count > remaining() / sizeof(T))
+    {
+      return false;
+    }
+    values.resize(static_cast<size_t>(count));
+    return readBytes(values.data(), values.size() * sizeof(T));
+  }
+
+  /// Read raw bytes.
+  /// @param[out] data The buffer to read into.
+  /// @param byte_count The number of bytes to read.
+  /// @return True on success.
+  bool readBytes(void *data, size_t byte_count);
+
+  /// Query the number of bytes remaining to be read.
+  /// @return The number of bytes remaining.
+  [[nodiscard]] size_t remaining() const { return _byte_count - _position; }
+
+private:
+  const uint8_t *_data = nullptr;
+  size_t _byte_count = 0;
+  size_t _position = 0;
+};
+
+/// A single handler's data in a snapshot.
+struct TES_VIEWER_API SnapshotChunk
+{
+  /// Routing ID of the handler which wrote the chunk.
+  uint16_t routing_id = 0;
+  /// Payload encoding.
+  SnapshotFormat format = SnapshotFormat::Native;
+  /// Payload data.
+  SnapshotBuffer payload;
+};
+
+/// The contents of a snapshot file.
+///
+/// The file starts with a header identifying the format and version, the frame number and the
+/// @c ServerInfoMessage, followed by each @c SnapshotChunk in order. Each chunk is prefixed with
+/// its routing ID, format and payload size.
+struct TES_VIEWER_API Snapshot
+{
+  /// File marker identifying a binary snapshot.
+  static constexpr uint32_t kMarker = 0x3e55a900u;
+  /// Format version. Snapshots with a different version are rejected.
+  static constexpr uint32_t kVersion = 1u;
+
+  /// The frame number captured.
+  FrameNumber frame_number = 0;
+  /// The server info at the time of capture.
+  ServerInfoMessage server_info = {};
+  /// Handler chunks in restore order.
+  std::vector<SnapshotChunk> chunks;
+
+  /// Write the snapshot to @p path .
+  /// @param path The file path to write to.
+  /// @return True on success.
+  [[nodiscard]] bool save(const std::filesystem::path &path) const;
+
+  /// Load a snapshot from @p path . This replaces the current contents.
+  /// @param path The file path to read.
+  /// @return True on success, false if the file cannot be read or is not a compatible snapshot.
+  [[nodiscard]] bool load(const std::filesystem::path &path);
+
+  /// Check if @p path is a binary snapshot file by reading the file marker.
+  /// @param path The file path to check.
+  /// @return True if @p path starts with @c kMarker .
+  [[nodiscard]] static bool isSnapshot(const std::filesystem::path &path);
+
+  /// Function used to restore a @c SnapshotFormat::Native chunk through the handler for
+  /// @p routing_id . Returns false if the handler fails to restore the chunk.
+  using RestoreChunk = std::function<bool(uint16_t routing_id, SnapshotReader &reader)>;
+
+  /// Restore the loaded snapshot into @p scene .
+  ///
+  /// This updates the @p scene server info, then restores each chunk in order. Packets from
+  /// @c SnapshotFormat::Packets chunks are passed to @c SceneProcessor::processMessage() , while
+  /// @c SnapshotFormat::Native chunks are passed to @p restore_chunk .
+  /// @param scene The scene to restore into.
+  /// @param restore_chunk Restores native chunks.
+  /// @return True if all chunks were restored.
+  bool restore(SceneProcessor &scene, const RestoreChunk &restore_chunk) const;
+};
+
+/// A @c Connection which writes protocol packets into a @c SnapshotChunk using the
+/// @c SnapshotFormat::Packets format.
+///
+/// This supports handlers which snapshot by encoding their state as protocol messages. Packets are
+/// written uncollated and uncompressed. Resources are written when calling @c updateTransfers() .
+class TES_VIEWER_API SnapshotConnection final : public BaseConnection
+{
+public:
+  /// Create a connection writing to @p chunk . The chunk format is set to
+  /// @c SnapshotFormat::Packets .
+  /// @param chunk The chunk to write to. Must outlive the connection.
+  explicit SnapshotConnection(SnapshotChunk &chunk);
+
+  void close() override {}
+  [[nodiscard]] const char *address() const override { return "snapshot"; }
+  [[nodiscard]] uint16_t port() const override { return 0; }
+  [[nodiscard]] bool isConnected() const override { return true; }
+
+protected:
+  int writeBytes(const uint8_t *data, int byte_count) override;
+
+private:
+  SnapshotChunk &_chunk;
+};
+}  // namespace tes::view::data
@@ -1,8 +1,9 @@
 #include "StreamThread.h"
 
 #include "KeyframeStore.h"
+#include "Snapshot.h"
 
-#include <3esview/ThirdEyeScene.h>
+#include <3esview/SceneProcessor.h>
 
 #include <3escore/CollatedPacketDecoder.h>
 #include <3escore/Log.h>
@@ -14,7 +15,14 @@
 
 namespace tes::view::data
 {
-StreamThread::StreamThread(std::shared_ptr<ThirdEyeScene> tes, std::shared_ptr<std::istream> stream)
+namespace
+{
+/// Maximum time to wait at the end of the stream in free running mode before checking again.
+constexpr unsigned kEndWaitMs = 100;
+}  // namespace
+
+StreamThread::StreamThread(std::shared_ptr<SceneProcessor> tes,
+                           std::shared_ptr<std::istream> stream)
   : _stream_reader(std::make_unique<PacketStreamReader>(*stream))
   , _stream(std::move(stream))
   , _tes(std::exchange(tes, nullptr))
@@ -82,6 +90,13 @@ float StreamThread::playbackSpeed() const
 }
 
 
+void StreamThread::setFreeRunning(bool free_running)
+{
+  _free_running = free_running;
+  _notify.notify_all();
+}
+
+
 void StreamThread::pause()
 {
   _paused = true;
@@ -167,35 +182,7 @@ bool StreamThread::checkCompatibility(const PacketHeader *header)
 
 bool StreamThread::checkCompatibility(const PacketReader &reader)
 {
-  const auto version_major = reader.versionMajor();
-  const auto version_minor = reader.versionMinor();
-
-  // Exact version match.
-  if (version_major == kPacketVersionMajor && version_minor == kPacketCompatibilityVersionMinor)
-  {
-    return true;
-  }
-  // Check major version is in the allowed range (open interval).
-  if (kPacketCompatibilityVersionMajor < version_major && version_major < kPacketVersionMajor)
-  {
-    // Major version is between the allowed range.
-    return true;
-  }
-
-  // Major version match, ensure minor version is in range.
-  if (version_major == kPacketVersionMajor && version_minor <= kPacketVersionMinor)
-  {
-    return true;
-  }
-
-  // Major version compatibility match, ensure minor version is in range.
-  if (version_major == kPacketCompatibilityVersionMajor &&
-      version_minor >= kPacketCompatibilityVersionMinor)
-  {
-    return true;
-  }
-
-  return false;
+  return packetVersionCompatible(reader.versionMajor(), reader.versionMinor());
 }
 
 
@@ -224,7 +211,10 @@ void StreamThread::run()
       [[fallthrough]];
     default:
       _frame.catching_up = false;
-      std::this_thread::sleep_until(next_frame_start);
+      if (!_free_running)
+      {
+        std::this_thread::sleep_until(next_frame_start);
+      }
       break;
     case TargetFrameState::KeyframeSkip: {
       // Try restore a keyframe.
@@ -250,6 +240,17 @@ void StreamThread::run()
       continue;
     }
 
+    _at_end = _stream_reader->isEof();
+    if (_at_end && _free_running)
+    {
+      // Nothing more to process. Wait for a target frame or quit rather than spinning.
+      std::unique_lock lock(_data_mutex);
+      _notify.wait_for(lock, std::chrono::milliseconds(kEndWaitMs), [this] {
+        return _quit_flag || _frame.pending_target.has_value() || (_looping && !_paused);
+      });
+      continue;
+    }
+
     at_frame_boundary = false;  // Tracks when we reach a frame boundary.
     while (!_quit_flag && !at_frame_boundary && _stream_reader->isOk() && !_stream_reader->isEof())
     {
@@ -590,6 +591,12 @@ void StreamThread::skipToClosestKeyframe(FrameNumber target_frame)
 
 bool StreamThread::loadSnapshot(const std::filesystem::path &snapshot_path)
 {
+  if (Snapshot::isSnapshot(snapshot_path))
+  {
+    return _tes->loadSnapshot(snapshot_path);
+  }
+
+  // Snapshot saved as a 3es stream.
   std::ifstream stream(snapshot_path.string().c_str(), std::ios::binary);
   if (!stream.is_open())
   {
@@ -30,7 +30,7 @@ class PacketStreamReader;
 
 namespace tes::view
 {
-class ThirdEyeScene;
+class SceneProcessor;
 }  // namespace tes::view
 
 namespace tes::view::data
@@ -53,7 +53,13 @@ public:
     NoFrameEnd = (1u << 0u)
   };
 
-  StreamThread(std::shared_ptr<ThirdEyeScene> tes, std::shared_ptr<std::istream> stream);
+  /// Create the thread, processing @p stream into the @p tes scene.
+  ///
+  /// The scene is typically a @c ThirdEyeScene , or a @c HeadlessScene when processing without
+  /// rendering.
+  /// @param tes The scene to process messages into.
+  /// @param stream The stream to read.
+  StreamThread(std::shared_ptr<SceneProcessor> tes, std::shared_ptr<std::istream> stream);
   StreamThread(const StreamThread &other) = delete;
   ~StreamThread() override;
 
@@ -87,6 +93,21 @@ public:
   void setPlaybackSpeed(float speed) override;
   float playbackSpeed() const override;
 
+  /// Set free running mode, where frames are processed as fast as possible, ignoring the frame
+  /// timing and playback speed. Intended for processing streams without rendering - see
+  /// @c HeadlessScene .
+  /// @param free_running True to enable free running mode.
+  void setFreeRunning(bool free_running);
+
+  /// Query free running mode. See @c setFreeRunning() .
+  /// @return True when free running.
+  bool freeRunning() const { return _free_running; }
+
+  /// Check if the thread has processed the entire stream. This is cleared when looping or skipping
+  /// back to an earlier frame.
+  /// @return True when at the end of the stream.
+  bool atEnd() const { return _at_end; }
+
   /// Request the thread to quit. The thread may then be joined.
   void stop() override
   {
@@ -273,7 +294,8 @@ private:
   /// exceeds the last keyframe.
   /// @param target_frame The target frame number.
   void skipToClosestKeyframe(FrameNumber target_frame);
-  /// Load a snapshot from the given path and process it's packets.
+  /// Load a snapshot from the given path. This supports binary @c Snapshot files as written for
+  /// keyframes and snapshots saved as 3es streams, processing the stream packets.
   /// @param snapshot_path The snapshot path.
   /// @return True on success.
   bool loadSnapshot(const std::filesystem::path &snapshot_path);
@@ -316,12 +338,14 @@ private:
   FrameState _frame = {};
   std::atomic_bool _quit_flag = false;
   std::atomic_bool _paused = false;
+  std::atomic_bool _free_running = false;
+  std::atomic_bool _at_end = false;
   bool _looping = false;
   float _playback_speed = 1.0f;
   std::unique_ptr<PacketStreamReader> _stream_reader;
   std::shared_ptr<std::istream> _stream;
   /// The scene manager.
-  std::shared_ptr<ThirdEyeScene> _tes = {};
+  std::shared_ptr<SceneProcessor> _tes = {};
   std::thread _thread = {};
   ServerInfoMessage _server_info = {};
   bool _have_server_info = false;
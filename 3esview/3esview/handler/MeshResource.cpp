@@ -3,6 +3,7 @@
 //
 #include "MeshResource.h"
 
+#include <3esview/data/Snapshot.h>
 #include <3esview/mesh/Converter.h>
 #include <3esview/shaders/PointGeom.h>
 #include <3esview/shaders/Shader.h>
@@ -12,18 +13,78 @@
 #include <3escore/Enum.h>
 #include <3escore/Log.h>
 #include <3escore/MeshMessages.h>
+#include <3escore/PointOctree.h>
 #include <3escore/TriGeom.h>
 
 #include <Magnum/GL/Renderer.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+
 namespace tes::view::handler
 {
+struct MeshResource::PointLod
+{
+  /// Set to abort the background octree build. Shared with the build task.
+  std::shared_ptr<std::atomic_bool> abort = std::make_shared<std::atomic_bool>(false);
+  /// The background octree build.
+  std::future<std::shared_ptr<const PointOctree>> build;
+  /// The octree, once built.
+  std::shared_ptr<const PointOctree> octree;
+  /// Renderable meshes for the octree nodes, uploaded on demand.
+  std::vector<std::shared_ptr<Magnum::GL::Mesh>> node_meshes;
+  /// The frame in which each node was last drawn.
+  std::vector<unsigned> last_drawn;
+  /// The selected nodes for the current draw.
+  std::vector<uint32_t> selection;
+  /// Number of points in @c node_meshes .
+  size_t resident_points = 0;
+};
+
+
+namespace
+{
+bool isLargePointCloud(const SimpleMesh &mesh)
+{
+  return mesh.drawType() == DrawType::Points && mesh.indexCount() == 0 &&
+         mesh.vertexCount() >= MeshResource::kPointLodThreshold;
+}
+
+/// Convert a Magnum matrix to a core matrix. Magnum matrices are column major.
+Matrix4f toCoreMatrix(const Magnum::Matrix4 &matrix)
+{
+  Matrix4f result(matrix.data());
+  result.transpose();
+  return result;
+}
+}  // namespace
+
+
 MeshResource::MeshResource(std::shared_ptr<shaders::ShaderLibrary> shader_library)
   : Message(MtMesh, "mesh resource")
   , _shader_library(std::move(shader_library))
 {}
 
 
+MeshResource::~MeshResource()
+{
+  const std::lock_guard guard(_resource_lock);
+  for (auto &[id, resource] : _resources)
+  {
+    if (resource.lod)
+    {
+      *resource.lod->abort = true;
+    }
+  }
+  for (auto &lod : _retired_lods)
+  {
+    *lod->abort = true;
+  }
+}
+
+
 void MeshResource::initialise()
 {}
 
@@ -35,6 +96,7 @@ void MeshResource::reset()
   {
     _garbage_list.emplace_back(resource.mesh);
     resource.mesh = nullptr;
+    retirePointLod(resource);
   }
   for (auto &[id, resource] : _pending)
   {
@@ -52,6 +114,8 @@ void MeshResource::prepareFrame(const FrameStamp &stamp)
   {
     const std::lock_guard guard(_resource_lock);
     _garbage_list.clear();
+    ++_lod_frame;
+    _lod_frame_uploads = 0;
     // As we begin a frame, we need to commit resources.
     // For OpenGL this must be on prepareFrame() as this is the main thread.
     // With Vulkan we could do it in endFrame().
@@ -63,6 +127,11 @@ void MeshResource::prepareFrame(const FrameStamp &stamp)
       auto &[id, resource] = *iter;
       if (resource.marked)
       {
+        auto existing = _resources.find(id);
+        if (existing != _resources.end())
+        {
+          retirePointLod(existing->second);
+        }
         _resources[id] = resource;
         iter = _pending.erase(iter);
       }
@@ -158,11 +227,12 @@ void MeshResource::readMessage(PacketReader &reader)
     {
       // Note(KS): we can get a redefine message before we've ever rendered the item.
       // In this case, current will be null, so we just modify the pending item.
-      // We can also get multiple redefines after having rendered at least once. In this case, both
-      // current and pending will be valid. However, the Ready flag will only be set the first time,
-      // so this becomes our cloning condition. Note: this cloning can become very expensive.
+      // Once rendered, pending and current share the same mesh, which we must clone rather than
+      // modify. A pending mesh which has not yet been rendered is modified in place, retaining
+      // prior data. Progressive point clouds rely on this, redefining each level to add points.
+      // Note: this cloning can become very expensive.
       if (search->second.current &&
-          (search->second.flags & ResourceFlag::Ready) == ResourceFlag::Ready)
+          (!search->second.pending || search->second.pending == search->second.current))
       {
         search->second.pending =
           std::dynamic_pointer_cast<SimpleMesh>(search->second.current->clone());
@@ -245,6 +315,33 @@ void MeshResource::serialise(Connection &out)
 }
 
 
+Message::SnapshotTask MeshResource::snapshot()
+{
+  // Current meshes are replaced, not modified, so the task can share them.
+  auto meshes = std::make_shared<std::vector<std::shared_ptr<const SimpleMesh>>>();
+  {
+    const std::lock_guard guard(_resource_lock);
+    meshes->reserve(_resources.size());
+    for (auto &[id, resource] : _resources)
+    {
+      if (resource.current)
+      {
+        meshes->emplace_back(resource.current);
+      }
+    }
+  }
+
+  return [meshes](data::SnapshotChunk &chunk) {
+    data::SnapshotConnection connection(chunk);
+    for (const auto &mesh : *meshes)
+    {
+      connection.referenceResource(Ptr<const tes::Resource>(mesh));
+    }
+    return connection.updateTransfers(0) >= 0;
+  };
+}
+
+
 unsigned MeshResource::draw(const DrawParams &params, const std::vector<DrawItem> &drawables,
                             DrawFlag flags)
 {
@@ -281,8 +378,14 @@ unsigned MeshResource::draw(const DrawParams &params, const std::vector<DrawItem
   for (const auto &item : drawables)
   {
     const auto search = _resources.find(item.resource_id);
-    if (search != _resources.end() && search->second.mesh && search->second.shader &&
-        search->second.mesh->count())
+    if (search != _resources.end() && search->second.lod && search->second.lod->octree &&
+        search->second.shader)
+    {
+      drawPointLod(search->second, params, item);
+      ++drawn;
+    }
+    else if (search != _resources.end() && search->second.mesh && search->second.shader &&
+             search->second.mesh->count())
     {
       search->second.shader
         ->setDrawScale(search->second.current->drawScale())  //
@@ -307,12 +410,51 @@ unsigned MeshResource::draw(const DrawParams &params, const std::vector<DrawItem
 }
 
 
+void MeshResource::setPointBudget(unsigned budget)
+{
+  const std::lock_guard guard(_resource_lock);
+  _point_budget = budget;
+}
+
+
+unsigned MeshResource::pointBudget() const
+{
+  const std::lock_guard guard(_resource_lock);
+  return _point_budget;
+}
+
+
 void MeshResource::updateResources()
 {
   const std::lock_guard guard(_resource_lock);
   const mesh::ConvertOptions options = {};
+  const bool headless = hasModeFlag(ModeFlag::Headless);
+
+  // Release retired level of detail states once their builds have finished.
+  _retired_lods.erase(std::remove_if(_retired_lods.begin(), _retired_lods.end(),
+                                     [](const std::shared_ptr<PointLod> &lod) {
+                                       return lod->build.wait_for(std::chrono::seconds(0)) ==
+                                              std::future_status::ready;
+                                     }),
+                      _retired_lods.end());
+
   for (auto &[id, resource] : _resources)
   {
+    if (resource.lod && resource.lod->build.valid() &&
+        resource.lod->build.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+      auto &lod = *resource.lod;
+      lod.octree = lod.build.get();
+      if (lod.octree)
+      {
+        lod.node_meshes.resize(lod.octree->nodes().size());
+        lod.last_drawn.resize(lod.octree->nodes().size());
+        // Replace the preview bounds with the full bounds, which the root node covers.
+        resource.bounds = lod.octree->nodes().front().bounds;
+        resource.bounds.convertToSpherical();
+      }
+    }
+
     // Note: this is a very inefficient way to manage large meshes with changing sub-sections as we
     // duplicate and recreate the entire mesh. Better would be to only touch the changed sections,
     // but that can wait.
@@ -320,13 +462,25 @@ void MeshResource::updateResources()
     {
       if (resource.pending)
       {
+        retirePointLod(resource);
         resource.current = resource.pending;
-        resource.mesh = std::make_shared<Magnum::GL::Mesh>(
-          mesh::convert(*resource.current, resource.bounds, options));
-        // Update to spherical bounds.
-        resource.bounds.convertToSpherical();
-        resource.shader =
-          _shader_library->lookupForDrawType(static_cast<DrawType>(resource.current->drawType(0)));
+        // Only the resource data is maintained when headless.
+        if (!headless)
+        {
+          if (isLargePointCloud(*resource.current))
+          {
+            startPointLod(resource);
+          }
+          else
+          {
+            resource.mesh = std::make_shared<Magnum::GL::Mesh>(
+              mesh::convert(*resource.current, resource.bounds, options));
+          }
+          // Update to spherical bounds.
+          resource.bounds.convertToSpherical();
+          resource.shader = _shader_library->lookupForDrawType(
+            static_cast<DrawType>(resource.current->drawType(0)));
+        }
       }
       resource.flags &= ~ResourceFlag::Ready;
     }
@@ -334,6 +488,134 @@ void MeshResource::updateResources()
 }
 
 
+void MeshResource::startPointLod(Resource &resource)
+{
+  const auto &source = *resource.current;
+  const unsigned vertex_count = source.vertexCount();
+
+  // Upload an even stride of the points to draw until the octree is ready. Walking every point for
+  // the full bounds is left to the octree build, so the preview bounds stand in until then.
+  std::vector<uint32_t> preview(std::min(vertex_count, kPointPreviewCount));
+  for (size_t i = 0; i < preview.size(); ++i)
+  {
+    preview[i] = static_cast<uint32_t>(i * vertex_count / preview.size());
+  }
+  resource.mesh = std::make_shared<Magnum::GL::Mesh>(
+    mesh::convert(source, preview.data(), preview.size(), resource.bounds));
+
+  auto lod = std::make_shared<PointLod>();
+  const auto build_octree = [source = resource.current, abort_flag = lod->abort]() {
+    auto octree = std::make_shared<PointOctree>();
+    if (!octree->build(*source, PointOctree::kDefaultNodeCapacity, abort_flag.get()))
+    {
+      return std::shared_ptr<const PointOctree>();
+    }
+    return std::shared_ptr<const PointOctree>(std::move(octree));
+  };
+  lod->build = std::async(std::launch::async, build_octree);
+  resource.lod = std::move(lod);
+}
+
+
+void MeshResource::retirePointLod(Resource &resource)
+{
+  if (!resource.lod)
+  {
+    return;
+  }
+
+  auto &lod = *resource.lod;
+  *lod.abort = true;
+  // Node meshes must be released on the main thread.
+  for (auto &node_mesh : lod.node_meshes)
+  {
+    if (node_mesh)
+    {
+      _garbage_list.emplace_back(std::move(node_mesh));
+    }
+  }
+  if (lod.build.valid())
+  {
+    _retired_lods.emplace_back(std::move(resource.lod));
+  }
+  resource.lod = nullptr;
+}
+
+
+void MeshResource::drawPointLod(Resource &resource, const DrawParams &params, const DrawItem &item)
+{
+  auto &lod = *resource.lod;
+  const auto &octree = *lod.octree;
+  octree.select(lod.selection, toCoreMatrix(params.projection_matrix),
+                toCoreMatrix(params.view_matrix * item.model_matrix),
+                static_cast<unsigned>(params.view_size.y()), _point_budget);
+
+  resource.shader->setDrawScale(resource.current->drawScale()).setModelMatrix(item.model_matrix);
+
+  // Parents precede their children in the selection, so nodes deferred by the upload budget leave
+  // coarser coverage rather than holes. The first upload each frame is always allowed.
+  for (const auto node_index : lod.selection)
+  {
+    auto &node_mesh = lod.node_meshes[node_index];
+    const auto &node = octree.nodes()[node_index];
+    if (!node_mesh)
+    {
+      if (_lod_frame_uploads > 0 && _lod_frame_uploads + node.count > kPointUploadBudget)
+      {
+        continue;
+      }
+      Bounds node_bounds = {};
+      node_mesh = std::make_shared<Magnum::GL::Mesh>(mesh::convert(
+        *resource.current, octree.nodePoints(node_index), node.count, node_bounds));
+      _lod_frame_uploads += node.count;
+      lod.resident_points += node.count;
+    }
+    lod.last_drawn[node_index] = _lod_frame;
+    resource.shader->draw(*node_mesh);
+  }
+
+  // Draw the preview until the root node is uploaded.
+  if (!lod.selection.empty() && !lod.node_meshes.front() && resource.mesh)
+  {
+    resource.shader->draw(*resource.mesh);
+  }
+
+  evictPointLod(lod);
+}
+
+
+void MeshResource::evictPointLod(PointLod &lod) const
+{
+  const size_t resident_limit = 2u * static_cast<size_t>(_point_budget);
+  if (lod.resident_points <= resident_limit)
+  {
+    return;
+  }
+
+  std::vector<uint32_t> candidates;
+  for (uint32_t i = 0; i < static_cast<uint32_t>(lod.node_meshes.size()); ++i)
+  {
+    if (lod.node_meshes[i] && lod.last_drawn[i] != _lod_frame)
+    {
+      candidates.emplace_back(i);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [&lod](uint32_t a, uint32_t b) { return lod.last_drawn[a] < lod.last_drawn[b]; });
+
+  const auto &nodes = lod.octree->nodes();
+  for (const auto node_index : candidates)
+  {
+    if (lod.resident_points <= resident_limit)
+    {
+      break;
+    }
+    lod.resident_points -= nodes[node_index].count;
+    lod.node_meshes[node_index] = nullptr;
+  }
+}
+
+
 void MeshResource::calculateNormals(SimpleMesh &mesh, bool force)
 {
   if (!force && mesh.rawNormals() != nullptr)
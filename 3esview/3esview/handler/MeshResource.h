@@ -93,7 +93,19 @@ public:
     TwoSided = OFTwoSided
   };
 
+  /// Minimum vertex count for an unindexed point resource to be drawn with level of detail.
+  static constexpr unsigned kPointLodThreshold = 1u << 20u;
+  /// Default maximum number of points to draw for each level of detail point resource instance.
+  static constexpr unsigned kDefaultPointBudget = 5000000u;
+  /// Maximum number of level of detail points to upload to the GPU each frame.
+  static constexpr unsigned kPointUploadBudget = 1u << 20u;
+  /// Number of points in the preview mesh drawn while building the level of detail octree.
+  static constexpr unsigned kPointPreviewCount = 1u << 16u;
+
   MeshResource(std::shared_ptr<shaders::ShaderLibrary> shader_library);
+  /// Destructor. Aborts any octree builds still in progress, as destroying a build waits for it to
+  /// finish.
+  ~MeshResource() override;
 
   ResourceReference get(uint32_t id) const;
 
@@ -106,6 +118,9 @@ public:
             const painter::CategoryState &categories) override;
   void readMessage(PacketReader &reader) override;
   void serialise(Connection &out) override;
+  /// Captures the current mesh resources, which the snapshot task encodes as resource transfer
+  /// messages.
+  SnapshotTask snapshot() override;
 
   /// Draw any number of mesh resource. Does not consider culling (cull before calling).
   ///
@@ -117,6 +132,19 @@ public:
   unsigned draw(const DrawParams &params, const std::vector<DrawItem> &drawables,
                 DrawFlag flags = DrawFlag::Zero);
 
+  /// Set the maximum number of points to draw for each instance of a large point resource.
+  ///
+  /// Point resources with at least @c kPointLodThreshold vertices and no indices are drawn with
+  /// level of detail. A @c tes::PointOctree is built for the resource on a background thread,
+  /// then the octree nodes are selected each frame by screen space error within this budget.
+  /// Selected nodes are uploaded to the GPU incrementally, and released when not drawn for a while.
+  ///
+  /// @param budget The point budget.
+  void setPointBudget(unsigned budget);
+  /// Query the point budget. See @c setPointBudget() .
+  /// @return The maximum number of points drawn for each level of detail point resource instance.
+  [[nodiscard]] unsigned pointBudget() const;
+
   enum class ResourceFlag : unsigned
   {
     Zero = 0u,
@@ -125,9 +153,37 @@ public:
   };
 
 private:
+  /// Level of detail state for a large point resource.
+  struct PointLod;
+
   /// Update pending resources to current if ready.
   void updateResources();
 
+  /// Create the renderable preview for a large point resource and start building its level of
+  /// detail octree on a background thread. @c _resource_lock must be held.
+  ///
+  /// The resource bounds cover the preview points until the octree is built, then cover all the
+  /// points.
+  /// @param resource The resource to build for.
+  void startPointLod(Resource &resource);
+
+  /// Release the level of detail state for @p resource , aborting any background build without
+  /// waiting for it. @c _resource_lock must be held.
+  /// @param resource The resource to release for.
+  void retirePointLod(Resource &resource);
+
+  /// Draw a large point resource using its level of detail octree, uploading selected nodes as the
+  /// upload budget allows. @c _resource_lock must be held.
+  /// @param resource The resource to draw. Must have a built octree.
+  /// @param params Current draw parameters.
+  /// @param item The instance to draw.
+  void drawPointLod(Resource &resource, const DrawParams &params, const DrawItem &item);
+
+  /// Release the least recently drawn node meshes of @p lod while it has more points resident than
+  /// twice the point budget. Nodes drawn in the current frame are retained.
+  /// @param lod The level of detail state.
+  void evictPointLod(PointLod &lod) const;
+
   /// Calculate normals for @p mesh provided it does not already have normals.
   ///
   /// Vertex normals are calculated by averaging the triangle normals adjacent to the vertex.
@@ -162,6 +218,8 @@ private:
     std::shared_ptr<Magnum::GL::Mesh> mesh;
     ResourceFlag flags = ResourceFlag::Zero;
     std::shared_ptr<shaders::Shader> shader;
+    /// Level of detail state for large point resources. Null for other resources.
+    std::shared_ptr<PointLod> lod;
     /// Used as a mark for pending items to denote which should become active on the next frame.
     /// Some pending items may be for later frames.
     bool marked = false;
@@ -173,7 +231,15 @@ private:
   /// Garbage list populated on @c reset() from background thread so main thread can release on @c
   /// prepareFrame().
   std::vector<std::shared_ptr<Magnum::GL::Mesh>> _garbage_list;
+  /// Level of detail states replaced while their octree build is still running. Held until the
+  /// build finishes so the main thread does not wait on it.
+  std::vector<std::shared_ptr<PointLod>> _retired_lods;
   std::shared_ptr<shaders::ShaderLibrary> _shader_library;
+  unsigned _point_budget = kDefaultPointBudget;
+  /// Frame counter for level of detail node usage, incremented on @c prepareFrame() .
+  unsigned _lod_frame = 0;
+  /// Number of level of detail points uploaded this frame.
+  unsigned _lod_frame_uploads = 0;
 };
 
 TES_ENUM_FLAGS(MeshResource::DrawFlag);
@@ -316,7 +316,9 @@ bool MeshSet::handleDestroy(const DestroyMessage &msg, PacketReader &reader)
 bool MeshSet::createDrawables(const std::shared_ptr<tes::MeshSet> &shape)
 {
   const bool transient = shape->id() == 0;
-  for (unsigned i = 0; i < shape->partCount(); ++i)
+  // Drawables are only needed for rendering.
+  const unsigned drawable_count = (!hasModeFlag(ModeFlag::Headless)) ? shape->partCount() : 0u;
+  for (unsigned i = 0; i < drawable_count; ++i)
   {
     Drawable &drawable = _drawables.emplace_back();
     drawable.part_id = i;
@@ -379,7 +381,7 @@ bool MeshSet::updateShape(uint32_t shape_id, const PendingAction::Update &update
 
   auto &[id, shape] = *find;
 
-  const bool update_all = (update.flags & UFUpdateMode) != 0u;
+  const bool update_all = (update.flags & UFUpdateMode) == 0u;
   const bool update_position = (update.flags & UFPosition) != 0u || update_all;
   const bool update_rotation = (update.flags & UFRotation) != 0u || update_all;
   const bool update_scale = (update.flags & UFScale) != 0u || update_all;
@@ -1,5 +1,6 @@
 #include "MeshShape.h"
 
+#include <3esview/data/Snapshot.h>
 #include <3esview/mesh/Converter.h>
 #include <3esview/painter/CategoryState.h>
 #include <3esview/shaders/Shader.h>
@@ -51,6 +52,11 @@ void MeshShape::prepareFrame(const FrameStamp &stamp)
   const std::lock_guard guard(_shapes_mutex);
   // Release garbage assets.
   _garbage_list.clear();
+  if (hasModeFlag(ModeFlag::Headless))
+  {
+    _needs_render_asset_list.clear();
+    return;
+  }
   updateRenderAssets();
 }
 
@@ -240,6 +246,37 @@ void MeshShape::serialise(Connection &out)
 }
 
 
+Message::SnapshotTask MeshShape::snapshot()
+{
+  // Clone the shapes as updates modify the shape attributes in place. Copying the mesh data here is
+  // much cheaper than encoding it.
+  auto shapes = std::make_shared<std::vector<std::shared_ptr<tes::Shape>>>();
+  {
+    const std::lock_guard guard(_shapes_mutex);
+    shapes->reserve(_transients.size() + _shapes.size());
+    for (auto &transient : _transients)
+    {
+      shapes->emplace_back(transient->shape->clone());
+    }
+
+    for (auto &[id, render_mesh] : _shapes)
+    {
+      shapes->emplace_back(render_mesh->shape->clone());
+    }
+  }
+
+  return [shapes](data::SnapshotChunk &chunk) {
+    data::SnapshotConnection connection(chunk);
+    bool ok = true;
+    for (const auto &shape : *shapes)
+    {
+      ok = connection.create(*shape) >= 0 && ok;
+    }
+    return ok;
+  };
+}
+
+
 Magnum::Matrix4 MeshShape::composeTransform(const ObjectAttributes &attrs) const
 {
   return Message::composeTransform(attrs);
@@ -392,7 +429,7 @@ bool MeshShape::updateShape(uint32_t shape_id, const PendingAction::Update &upda
 
   const auto &[id, render_mesh] = *search;
 
-  const bool update_all = (update.flags & UFUpdateMode) != 0u;
+  const bool update_all = (update.flags & UFUpdateMode) == 0u;
   const bool update_position = (update.flags & UFPosition) != 0u || update_all;
   const bool update_rotation = (update.flags & UFRotation) != 0u || update_all;
   const bool update_scale = (update.flags & UFScale) != 0u || update_all;
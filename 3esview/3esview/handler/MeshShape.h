@@ -53,6 +53,9 @@ public:
 
   void readMessage(PacketReader &reader) override;
   void serialise(Connection &out) override;
+  /// Captures clones of the mesh shapes, which the snapshot task encodes as create and data
+  /// messages.
+  SnapshotTask snapshot() override;
 
   /// Compose the object transform from the given object attributes.
   /// @param attrs Object attributes as read from the message payload.
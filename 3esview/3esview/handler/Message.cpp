@@ -1,5 +1,9 @@
 #include "Message.h"
 
+#include <3esview/data/Snapshot.h>
+
+#include <3escore/Log.h>
+
 #include <Magnum/Math/Matrix4.h>
 #include <Magnum/Math/Quaternion.h>
 
@@ -20,6 +24,29 @@ void Message::updateServerInfo(const ServerInfoMessage &info)
 }
 
 
+Message::SnapshotTask Message::snapshot()
+{
+  auto packets = std::make_shared<data::SnapshotChunk>();
+  {
+    data::SnapshotConnection connection(*packets);
+    serialise(connection);
+  }
+  return [packets](data::SnapshotChunk &chunk) {
+    chunk.format = packets->format;
+    chunk.payload = std::move(packets->payload);
+    return true;
+  };
+}
+
+
+bool Message::restore(data::SnapshotReader &in)
+{
+  (void)in;
+  log::error(name(), " : no native snapshot support");
+  return false;
+}
+
+
 Magnum::Matrix4 Message::composeTransform(const ObjectAttributes &attrs)
 {
   return Magnum::Matrix4::translation(
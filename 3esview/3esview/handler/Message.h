@@ -15,6 +15,7 @@
 #include <Magnum/Math/Matrix4.h>
 #include <Magnum/Math/Vector2.h>
 
+#include <functional>
 #include <string>
 
 namespace tes
@@ -22,6 +23,12 @@ namespace tes
 class Connection;
 }  // namespace tes
 
+namespace tes::view::data
+{
+struct SnapshotChunk;
+class SnapshotReader;
+}  // namespace tes::view::data
+
 namespace tes::view::handler
 {
 /// The base class for a 3es message handler.
@@ -55,12 +62,18 @@ class TES_VIEWER_API Message
 {
 public:
   using ObjectAttributes = tes::ObjectAttributes<Magnum::Float>;
+  /// Deferred writer for a binary snapshot chunk. See @c snapshot() .
+  using SnapshotTask = std::function<bool(data::SnapshotChunk &chunk)>;
 
   /// Flags modifying the normal operating behaviour of a message handler.
   enum class ModeFlag
   {
     /// Ignore messages for transient objects. Do not create new transient objects.
-    IgnoreTransient = (1u << 0u)
+    IgnoreTransient = (1u << 0u),
+    /// Maintain the scene state without any render resources, such as for a @c HeadlessScene .
+    /// @c prepareFrame() effects pending state without making OpenGL calls and @c draw() must not
+    /// be called.
+    Headless = (1u << 1u)
   };
 
   /// Flags commonly used to manage drawable items in a message handler.
@@ -110,6 +123,13 @@ public:
   /// Set the @c ModeFlag values.
   /// @param flags New values.
   void setModeFlags(unsigned flags) { _mode_flags = flags; }
+  /// Check if a @c ModeFlag is set.
+  /// @param flag The flag to check.
+  /// @return True if @p flag is set.
+  [[nodiscard]] bool hasModeFlag(ModeFlag flag) const
+  {
+    return (_mode_flags & static_cast<unsigned>(flag)) != 0u;
+  }
 
   /// Get the handler name.
   /// @return The handler name.
@@ -195,6 +215,31 @@ public:
   /// @param out Stream to write to.
   virtual void serialise(Connection &out) = 0;
 
+  /// Capture the current frame state for a binary snapshot.
+  ///
+  /// Called from the main thread under the same conditions as @c serialise() . This should only
+  /// take an immutable copy of the state and return a task which encodes that copy. The task is
+  /// invoked later on a worker thread, concurrently with the tasks for other handlers and with
+  /// continued rendering, so it must not reference the live handler state.
+  ///
+  /// The default implementation calls @c serialise() immediately and the task writes the resulting
+  /// packets using @c data::SnapshotFormat::Packets . Handlers holding large amounts of state
+  /// should override this.
+  ///
+  /// @return The snapshot task.
+  virtual SnapshotTask snapshot();
+
+  /// Restore state from a @c data::SnapshotFormat::Native chunk written by the @c snapshot() task.
+  ///
+  /// Called from the data thread after a reset, in place of @c readMessage() . As with
+  /// @c readMessage() , changes must not be effected until the next @c endFrame() .
+  ///
+  /// The default implementation fails as the default @c snapshot() writes packets instead.
+  ///
+  /// @param in The chunk data reader.
+  /// @return True on success.
+  virtual bool restore(data::SnapshotReader &in);
+
   static Magnum::Matrix4 composeTransform(const ObjectAttributes &attrs);
   static void decomposeTransform(const Magnum::Matrix4 &transform, ObjectAttributes &attrs);
 
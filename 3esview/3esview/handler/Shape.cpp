@@ -1,5 +1,6 @@
 #include "Shape.h"
 
+#include <3esview/data/Snapshot.h>
 #include <3esview/painter/ShapePainter.h>
 
 #include <3escore/Colour.h>
@@ -13,6 +14,52 @@
 
 namespace tes::view::handler
 {
+namespace
+{
+constexpr std::array<painter::ShapePainter::Type, 3> kSnapshotShapeTypes = {
+  painter::ShapePainter::Type::Solid, painter::ShapePainter::Type::Wireframe,
+  painter::ShapePainter::Type::Transparent
+};
+
+/// Structure of arrays copy of the shapes of one @c painter::ShapePainter::Type for snapshots.
+struct ShapeArrays
+{
+  std::vector<uint32_t> ids;
+  std::vector<uint16_t> categories;
+  std::vector<Magnum::Matrix4> transforms;
+  std::vector<Magnum::Color4> colours;
+  /// Number of child shapes for each shape.
+  std::vector<uint32_t> child_counts;
+  /// Child shape transforms, ordered by parent.
+  std::vector<Magnum::Matrix4> child_transforms;
+  /// Child shape colours, ordered by parent.
+  std::vector<Magnum::Color4> child_colours;
+
+  void write(data::SnapshotBuffer &out) const
+  {
+    out.writeArray(ids);
+    out.writeArray(categories);
+    out.writeArray(transforms);
+    out.writeArray(colours);
+    out.writeArray(child_counts);
+    out.writeArray(child_transforms);
+    out.writeArray(child_colours);
+  }
+
+  [[nodiscard]] bool read(data::SnapshotReader &in)
+  {
+    const bool ok = in.readArray(ids) && in.readArray(categories) && in.readArray(transforms) &&
+                    in.readArray(colours) && in.readArray(child_counts) &&
+                    in.readArray(child_transforms) && in.readArray(child_colours);
+    // Validate array sizes.
+    return ok && categories.size() == ids.size() && transforms.size() == ids.size() &&
+           colours.size() == ids.size() && child_counts.size() == ids.size() &&
+           child_colours.size() == child_transforms.size();
+  }
+};
+}  // namespace
+
+
 [[nodiscard]] bool readMultiShape(const Shape &shape, painter::ShapePainter &painter,
                                   const painter::ShapePainter::ParentId &parent_id,
                                   painter::ShapePainter::Type draw_type, unsigned shape_count,
@@ -82,51 +129,69 @@ void Shape::draw(DrawPass pass, const FrameStamp &stamp, const DrawParams &param
 }
 
 
+const std::array<Shape::ReadFunction, OIdData + 1> Shape::kReadFunctions = {
+  nullptr,              // OIdNull
+  &Shape::readCreate,   // OIdCreate
+  &Shape::readUpdate,   // OIdUpdate
+  &Shape::readDestroy,  // OIdDestroy
+  &Shape::readData,     // OIdData
+};
+
+
 void Shape::readMessage(PacketReader &reader)
 {
   TES_ASSERT(reader.routingId() == routingId());
-  ObjectAttributes attrs = {};
-  bool ok = false;
-  bool logged = false;
-  switch (reader.messageId())
+  const unsigned message_id = reader.messageId();
+  const ReadFunction read = (message_id < kReadFunctions.size()) ? kReadFunctions[message_id] :
+                                                                   nullptr;
+  if (!read)
   {
-  case OIdCreate: {
-    CreateMessage msg = {};
-    ok = msg.read(reader, attrs) && handleCreate(msg, attrs, reader);
-    break;
-  }
-  case OIdDestroy: {
-    DestroyMessage msg = {};
-    ok = msg.read(reader);
-    if (ok)
-    {
-      // Note: It's OK to destroy IDs which haven't been created.
-      handleDestroy(msg, reader);
-    }
-    break;
-  }
-  case OIdUpdate: {
-    UpdateMessage msg = {};
-    ok = msg.read(reader, attrs) && handleUpdate(msg, attrs, reader);
-    break;
-  }
-  case OIdData: {
-    // We only expect data messages for multi-shape messages where the create message does not
-    // contain all the shapes.
-    DataMessage msg = {};
-    ok = msg.read(reader) && handleData(msg, reader);
-    break;
+    log::error(name(), " : unhandled shape message type: ", message_id);
+    return;
   }
-  default:
-    log::error(name(), " : unhandled shape message type: ", unsigned(reader.messageId()));
-    logged = true;
-    break;
+
+  if (!(this->*read)(reader))
+  {
+    log::error(name(), " : failed to decode message type: ", message_id);
   }
+}
+
+
+bool Shape::readCreate(PacketReader &reader)
+{
+  ObjectAttributes attrs = {};
+  CreateMessage msg = {};
+  return msg.read(reader, attrs) && handleCreate(msg, attrs, reader);
+}
+
 
-  if (!ok && !logged)
+bool Shape::readUpdate(PacketReader &reader)
+{
+  ObjectAttributes attrs = {};
+  UpdateMessage msg = {};
+  return msg.read(reader, attrs) && handleUpdate(msg, attrs, reader);
+}
+
+
+bool Shape::readDestroy(PacketReader &reader)
+{
+  DestroyMessage msg = {};
+  if (!msg.read(reader))
   {
-    log::error(name(), " : failed to decode message type: ", unsigned(reader.messageId()));
+    return false;
   }
+  // Note: It's OK to destroy IDs which haven't been created.
+  handleDestroy(msg, reader);
+  return true;
+}
+
+
+bool Shape::readData(PacketReader &reader)
+{
+  // We only expect data messages for multi-shape messages where the create message does not
+  // contain all the shapes.
+  DataMessage msg = {};
+  return msg.read(reader) && handleData(msg, reader);
 }
 
 
@@ -251,6 +316,94 @@ void Shape::serialise(Connection &out)
 }
 
 
+Message::SnapshotTask Shape::snapshot()
+{
+  auto arrays = std::make_shared<std::array<ShapeArrays, kSnapshotShapeTypes.size()>>();
+  for (size_t i = 0; i < kSnapshotShapeTypes.size(); ++i)
+  {
+    auto &shapes = (*arrays)[i];
+    const auto end = _painter->end(kSnapshotShapeTypes[i]);
+    for (auto shape = _painter->begin(kSnapshotShapeTypes[i]); shape != end; ++shape)
+    {
+      if (shape->is_child)
+      {
+        continue;
+      }
+
+      shapes.ids.emplace_back(shape->id.id());
+      shapes.categories.emplace_back(shape->id.category());
+      shapes.transforms.emplace_back(shape->attributes.transform);
+      shapes.colours.emplace_back(shape->attributes.colour);
+      shapes.child_counts.emplace_back(shape->child_count);
+      for (unsigned c = 0; c < shape->child_count; ++c)
+      {
+        const auto child = shape.getChild(c);
+        shapes.child_transforms.emplace_back(child.attributes.transform);
+        shapes.child_colours.emplace_back(child.attributes.colour);
+      }
+    }
+  }
+
+  return [arrays](data::SnapshotChunk &chunk) {
+    chunk.format = data::SnapshotFormat::Native;
+    chunk.payload.write(static_cast<uint32_t>(arrays->size()));
+    for (const auto &shapes : *arrays)
+    {
+      shapes.write(chunk.payload);
+    }
+    return true;
+  };
+}
+
+
+bool Shape::restore(data::SnapshotReader &in)
+{
+  uint32_t type_count = 0;
+  if (!in.read(type_count) || type_count != kSnapshotShapeTypes.size())
+  {
+    log::error(name(), " : invalid snapshot shape types");
+    return false;
+  }
+
+  ShapeArrays shapes;
+  for (const auto draw_type : kSnapshotShapeTypes)
+  {
+    if (!shapes.read(in))
+    {
+      log::error(name(), " : failed to read snapshot");
+      return false;
+    }
+
+    size_t child_index = 0;
+    for (size_t i = 0; i < shapes.ids.size(); ++i)
+    {
+      const Id id(shapes.ids[i], shapes.categories[i]);
+      const auto child_count = shapes.child_counts[i];
+      if (child_index + child_count > shapes.child_transforms.size())
+      {
+        log::error(name(), " : snapshot child shape count mismatch");
+        return false;
+      }
+
+      const auto parent_id = _painter->add(id, draw_type, shapes.transforms[i], shapes.colours[i],
+                                           child_count > 0);
+      for (uint32_t c = 0; c < child_count; ++c, ++child_index)
+      {
+        _painter->addChild(parent_id, draw_type, shapes.child_transforms[child_index],
+                           shapes.child_colours[child_index]);
+      }
+
+      if (child_count > 0 && !id.isTransient())
+      {
+        _multi_shapes[id.id()] = { child_count, false };
+      }
+    }
+  }
+
+  return true;
+}
+
+
 Magnum::Matrix4 Shape::composeTransform(const ObjectAttributes &attrs) const
 {
   return Message::composeTransform(attrs);
@@ -359,9 +512,10 @@ bool Shape::handleUpdate(const UpdateMessage &msg, const ObjectAttributes &attrs
       }
       transform = composeTransform(cur_attrs);
     }
-    if ((msg.flags & UFColour) == 0)
+    // Keep the current colour unless it is being updated.
+    if (msg.flags & UFColour)
     {
-      c = Colour(cur_attrs.colour);
+      colour = Magnum::Color4(c.rf(), c.gf(), c.bf(), c.af());
     }
   }
   else
@@ -5,6 +5,7 @@
 
 #include "Message.h"
 
+#include <array>
 #include <iosfwd>
 #include <memory>
 #include <unordered_map>
@@ -33,6 +34,13 @@ public:
 
   void readMessage(PacketReader &reader) override;
   void serialise(Connection &out) override;
+  /// Captures structure of arrays copies of the shape ids, transforms and colours.
+  SnapshotTask snapshot() override;
+  bool restore(data::SnapshotReader &in) override;
+
+  /// Access the painter which tracks the shape instances.
+  /// @return The shape painter.
+  [[nodiscard]] const std::shared_ptr<painter::ShapePainter> &painter() const { return _painter; }
 
   /// Compose the object transform from the given object attributes.
   /// @param attrs Object attributes as read from the message payload.
@@ -62,6 +70,17 @@ private:
     bool double_precision = false;
   };
 
+  /// Function signature for reading and handling a single message type.
+  using ReadFunction = bool (Shape::*)(PacketReader &reader);
+
+  bool readCreate(PacketReader &reader);
+  bool readUpdate(PacketReader &reader);
+  bool readDestroy(PacketReader &reader);
+  bool readData(PacketReader &reader);
+
+  /// Message read functions, directly indexed by message ID. Null entries are unhandled.
+  static const std::array<ReadFunction, OIdData + 1> kReadFunctions;
+
   // std::mutex _data_mutex;
   std::shared_ptr<painter::ShapePainter> _painter;
   /// Map of multi-shape attributes. We need to use some of this information when unpacking the data
@@ -63,7 +63,7 @@ public:
   /// Constructor.
   /// @param routing_id The message routing ID for the supported text messages.
   /// @param name The message handler name.
-  /// @param painter The text drawing API.
+  /// @param painter The text drawing API. May be null in @c ModeFlag::Headless mode.
   Text(uint16_t routing_id, const std::string &name, std::shared_ptr<painter::Text> painter);
 
   void initialise() override;
@@ -90,6 +90,13 @@ private:
   /// @return True on success.
   bool destroy(uint32_t shape_id);
 
+  /// Allocate or update the @c BoundsCuller entry for a persistent 3D text @p entry .
+  /// @param entry The text entry.
+  void updateBounds(TextEntry &entry);
+  /// Release the @c BoundsCuller entry for @p entry , if any.
+  /// @param entry The text entry.
+  void releaseBounds(TextEntry &entry);
+
   std::mutex _mutex;
   std::vector<PendingAction> _pending_queue;
   std::vector<TextEntry> _transient;
@@ -117,6 +124,10 @@ void Text<TextShape, Affordances>::reset()
   const std::lock_guard guard(_mutex);
   _pending_queue.clear();
   _transient.clear();
+  for (auto &[id, entry] : _text)
+  {
+    releaseBounds(entry);
+  }
   _text.clear();
 }
 
@@ -293,7 +304,10 @@ bool Text<TextShape, Affordances>::create(const TextShape &shape)
   }
   else
   {
-    _text[shape.id()] = entry;
+    auto &existing = _text[shape.id()];
+    releaseBounds(existing);
+    existing = entry;
+    updateBounds(existing);
   }
   return true;
 }
@@ -317,22 +331,41 @@ bool Text<TextShape, Affordances>::update(uint32_t shape_id,
 
   auto &entry = search->second;
 
-  // Use ObjectAttributes as an intermediary so we can use composeTransform().
+  // Use ObjectAttributes as an intermediary so we can use composeTransform(). Partial updates only
+  // replace the flagged attributes.
   // No need to set colour. That is unused by composeTransform()
+  const bool update_all = (update.flags & UFUpdateMode) == 0u;
   ObjectAttributes attrs = {};
-  attrs.position[0] = static_cast<Magnum::Float>(update.position[0]);
-  attrs.position[1] = static_cast<Magnum::Float>(update.position[1]);
-  attrs.position[2] = static_cast<Magnum::Float>(update.position[2]);
-  attrs.rotation[0] = static_cast<Magnum::Float>(update.rotation[0]);
-  attrs.rotation[1] = static_cast<Magnum::Float>(update.rotation[1]);
-  attrs.rotation[2] = static_cast<Magnum::Float>(update.rotation[2]);
-  attrs.rotation[3] = static_cast<Magnum::Float>(update.rotation[3]);
-  attrs.scale[0] = static_cast<Magnum::Float>(update.scale[0]);
-  attrs.scale[1] = static_cast<Magnum::Float>(update.scale[1]);
-  attrs.scale[2] = static_cast<Magnum::Float>(update.scale[2]);
+  if (!update_all)
+  {
+    decomposeTransform(entry.transform, attrs);
+  }
+  if (update_all || (update.flags & UFPosition))
+  {
+    attrs.position[0] = static_cast<Magnum::Float>(update.position[0]);
+    attrs.position[1] = static_cast<Magnum::Float>(update.position[1]);
+    attrs.position[2] = static_cast<Magnum::Float>(update.position[2]);
+  }
+  if (update_all || (update.flags & UFRotation))
+  {
+    attrs.rotation[0] = static_cast<Magnum::Float>(update.rotation[0]);
+    attrs.rotation[1] = static_cast<Magnum::Float>(update.rotation[1]);
+    attrs.rotation[2] = static_cast<Magnum::Float>(update.rotation[2]);
+    attrs.rotation[3] = static_cast<Magnum::Float>(update.rotation[3]);
+  }
+  if (update_all || (update.flags & UFScale))
+  {
+    attrs.scale[0] = static_cast<Magnum::Float>(update.scale[0]);
+    attrs.scale[1] = static_cast<Magnum::Float>(update.scale[1]);
+    attrs.scale[2] = static_cast<Magnum::Float>(update.scale[2]);
+  }
 
   entry.transform = composeTransform(attrs);
-  entry.colour = tes::view::convert(update.colour);
+  if (update_all || (update.flags & UFColour))
+  {
+    entry.colour = tes::view::convert(update.colour);
+  }
+  updateBounds(entry);
 
   return true;
 }
@@ -347,7 +380,48 @@ bool Text<TextShape, Affordances>::destroy(uint32_t shape_id)
     return false;
   }
 
+  releaseBounds(search->second);
   _text.erase(search);
   return true;
 }
+
+
+template <typename TextShape, typename Affordances>
+void Text<TextShape, Affordances>::updateBounds(TextEntry &entry)
+{
+  // Only 3D text is culled by bounds.
+  if constexpr (!Affordances::is2D())
+  {
+    if (!_painter)
+    {
+      return;
+    }
+
+    const auto &culler = _painter->culler();
+    if (!culler)
+    {
+      return;
+    }
+
+    if (entry.bounds_id == BoundsCuller::kInvalidId)
+    {
+      entry.bounds_id = culler->allocate(_painter->calculateBounds(entry));
+    }
+    else
+    {
+      culler->update(entry.bounds_id, _painter->calculateBounds(entry));
+    }
+  }
+}
+
+
+template <typename TextShape, typename Affordances>
+void Text<TextShape, Affordances>::releaseBounds(TextEntry &entry)
+{
+  if (entry.bounds_id != BoundsCuller::kInvalidId)
+  {
+    _painter->culler()->release(entry.bounds_id);
+    entry.bounds_id = BoundsCuller::kInvalidId;
+  }
+}
 }  // namespace tes::view::handler
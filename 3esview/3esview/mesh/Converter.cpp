@@ -4,6 +4,8 @@
 
 #include <3escore/MeshMessages.h>
 #include <3escore/shapes/MeshResource.h>
+#include <3escore/shapes/SimpleMesh.h>
+#include <3escore/tessellate/Cache.h>
 
 #include <Magnum/Magnum.h>
 
@@ -251,10 +253,13 @@ struct VertexMapper<VertexPNC>
 
 template <typename V>
 Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource, Magnum::MeshPrimitive draw_type,
-                         tes::Bounds<Magnum::Float> &bounds, const ConvertOptions &options)
+                         tes::Bounds<Magnum::Float> &bounds, const ConvertOptions &options,
+                         const uint32_t *vertex_order, size_t vertex_count)
 {
-  Array<V> vertices(Corrade::DefaultInit, mesh_resource.vertexCount());
-  Array<Magnum::UnsignedInt> indices(Corrade::DefaultInit, mesh_resource.indexCount());
+  // Indices do not apply to a vertex subset.
+  Array<V> vertices(Corrade::DefaultInit, vertex_count);
+  Array<Magnum::UnsignedInt> indices(Corrade::DefaultInit,
+                                     (vertex_order) ? 0u : mesh_resource.indexCount());
 
   const DataBuffer src_vertices = mesh_resource.vertices();
   const DataBuffer src_normals = mesh_resource.normals();
@@ -268,7 +273,9 @@ Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource, Magnum::MeshPri
 
   for (size_t i = 0; i < vertices.size(); ++i)
   {
-    const auto vertex = mapper(vertices[i], i, src_vertices, src_normals, src_colour, options);
+    const size_t src_index = (vertex_order) ? vertex_order[i] : i;
+    const auto vertex =
+      mapper(vertices[i], src_index, src_vertices, src_normals, src_colour, options);
     if (i != 0)
     {
       bounds.expand(tes::Vector3<Magnum::Float>(vertex.x(), vertex.y(), vertex.z()));
@@ -281,14 +288,14 @@ Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource, Magnum::MeshPri
   }
 
   const DataBuffer src_indices = mesh_resource.indices();
-  if (src_indices.count())
+  if (!vertex_order && src_indices.count())
   {
     for (size_t i = 0; i < indices.size(); ++i)
     {
       indices[i] = src_indices.get<unsigned>(i);
     }
   }
-  else if (options.auto_index)
+  else if (!vertex_order && options.auto_index)
   {
     indices = Array<Magnum::UnsignedInt>(Corrade::DefaultInit, mesh_resource.indexCount());
     for (unsigned i = 0; i < unsigned(indices.size()); ++i)
@@ -310,8 +317,11 @@ Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource, Magnum::MeshPri
   return Magnum::MeshTools::compile(md);
 }
 
+namespace
+{
 Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource, tes::Bounds<Magnum::Float> &bounds,
-                         const ConvertOptions &options)
+                         const ConvertOptions &options, const uint32_t *vertex_order,
+                         size_t vertex_count)
 {
   Magnum::MeshPrimitive primitive = {};
 
@@ -336,14 +346,46 @@ Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource, tes::Bounds<Mag
   {
     if (mesh_resource.colours().isValid())
     {
-      return convert<VertexPNC>(mesh_resource, primitive, bounds, options);
+      return convert<VertexPNC>(mesh_resource, primitive, bounds, options, vertex_order,
+                                vertex_count);
     }
-    return convert<VertexPN>(mesh_resource, primitive, bounds, options);
+    return convert<VertexPN>(mesh_resource, primitive, bounds, options, vertex_order,
+                             vertex_count);
   }
   if (mesh_resource.colours().isValid() || options.auto_colour)
   {
-    return convert<VertexPC>(mesh_resource, primitive, bounds, options);
+    return convert<VertexPC>(mesh_resource, primitive, bounds, options, vertex_order,
+                             vertex_count);
   }
-  return convert<VertexP>(mesh_resource, primitive, bounds, options);
+  return convert<VertexP>(mesh_resource, primitive, bounds, options, vertex_order,
+                          vertex_count);
+}
+}  // namespace
+
+
+Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource, tes::Bounds<Magnum::Float> &bounds,
+                         const ConvertOptions &options)
+{
+  return convert(mesh_resource, bounds, options, nullptr, mesh_resource.vertexCount());
+}
+
+
+Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource, const uint32_t *vertex_order,
+                         size_t vertex_count, tes::Bounds<Magnum::Float> &bounds,
+                         const ConvertOptions &options)
+{
+  return convert(mesh_resource, bounds, options, vertex_order, vertex_count);
+}
+
+
+Magnum::GL::Mesh convert(const tes::tessellate::Mesh &mesh)
+{
+  SimpleMesh build_mesh(
+    0, mesh.vertices.size(), mesh.indices.size(), DrawType::Triangles,
+    MeshComponentFlag::Vertex | MeshComponentFlag::Normal | MeshComponentFlag::Index);
+  build_mesh.setVertices(0, mesh.vertices.data(), mesh.vertices.size());
+  build_mesh.setNormals(0, mesh.normals.data(), mesh.normals.size());
+  build_mesh.setIndices(0, mesh.indices.data(), mesh.indices.size());
+  return convert(build_mesh);
 }
 }  // namespace tes::view::mesh
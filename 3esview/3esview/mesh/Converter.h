@@ -12,6 +12,11 @@ namespace tes
 class MeshResource;
 }  // namespace tes
 
+namespace tes::tessellate
+{
+struct Mesh;
+}  // namespace tes::tessellate
+
 namespace tes::view::mesh
 {
 /// Options to adjust the behaviour of @c convert() functions.
@@ -34,4 +39,23 @@ inline Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource,
   tes::Bounds<Magnum::Float> bounds;
   return convert(mesh_resource, bounds, options);
 }
+
+/// Convert a subset of the vertices of @p mesh_resource , drawn without indices.
+///
+/// Used to upload point cloud sections, such as the nodes of a @c tes::PointOctree .
+///
+/// @param mesh_resource The mesh to convert from.
+/// @param vertex_order The indices of the vertices to convert.
+/// @param vertex_count The number of elements in @p vertex_order .
+/// @param[out] bounds Set to the bounds of the converted vertices.
+/// @param options Conversion options.
+/// @return The converted mesh.
+Magnum::GL::Mesh convert(const tes::MeshResource &mesh_resource, const uint32_t *vertex_order,
+                         size_t vertex_count, tes::Bounds<Magnum::Float> &bounds,
+                         const ConvertOptions &options = {});
+
+/// Convert a cached tessellation mesh to a triangle mesh with normals.
+/// @param mesh The tessellated mesh to convert.
+/// @return The converted mesh.
+Magnum::GL::Mesh convert(const tes::tessellate::Mesh &mesh);
 }  // namespace tes::view::mesh
@@ -6,15 +6,12 @@
 #include <3esview/mesh/Converter.h>
 #include <3esview/shaders/ShaderLibrary.h>
 
-#include <3escore/shapes/SimpleMesh.h>
-#include <3escore/tessellate/Cylinder.h>
-#include <3escore/tessellate/Sphere.h>
+#include <3escore/tessellate/Cache.h>
 
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/Math/Matrix3.h>
 
 #include <cassert>
-#include <mutex>
 
 namespace tes::view::painter
 {
@@ -24,24 +21,29 @@ const Vector3f Capsule::kDefaultAxis = { 0.0f, 0.0f, 1.0f };
 
 Capsule::Capsule(const std::shared_ptr<BoundsCuller> &culler,
                  const std::shared_ptr<shaders::ShaderLibrary> &shaders)
-  : ShapePainter(culler, shaders, { Part{ solidMeshCylinder() } },
-                 { Part{ wireframeMeshCylinder() } }, { Part{ solidMeshCylinder() } },
-                 calculateBounds)
+  : ShapePainter(culler, shaders, buildLods(tessellate::CachedShape::CapsuleBody),
+                 { Part{ wireframeMeshCylinder() } }, calculateBounds)
 {
-  _solid_end_caps[0] = std::make_unique<ShapeCache>(culler, _solid_cache->shader(),
-                                                    Part{ solidMeshCapTop() }, calculateBounds);
-  _solid_end_caps[1] = std::make_unique<ShapeCache>(culler, _solid_cache->shader(),
-                                                    Part{ solidMeshCapBottom() }, calculateBounds);
+  // The end caps are drawn by separate caches. These select their LOD from the unmodified capsule
+  // transform, using the same screen size thresholds as the body, so all parts of a capsule are
+  // drawn at the same LOD and the seams match.
+  const auto top_cap_lods = buildLods(tessellate::CachedShape::CapsuleTop);
+  const auto bottom_cap_lods = buildLods(tessellate::CachedShape::CapsuleBottom);
+
+  _solid_end_caps[0] =
+    std::make_unique<ShapeCache>(culler, _solid_cache->shader(), top_cap_lods, calculateBounds);
+  _solid_end_caps[1] =
+    std::make_unique<ShapeCache>(culler, _solid_cache->shader(), bottom_cap_lods, calculateBounds);
 
   _wireframe_end_caps[0] = std::make_unique<ShapeCache>(
     culler, _wireframe_cache->shader(), Part{ wireframeMeshCap() }, calculateBounds);
   _wireframe_end_caps[1] = std::make_unique<ShapeCache>(
     culler, _wireframe_cache->shader(), Part{ wireframeMeshCap() }, calculateBounds);
 
-  _transparent_end_caps[0] = std::make_unique<ShapeCache>(
-    culler, _transparent_cache->shader(), Part{ solidMeshCapTop() }, calculateBounds);
-  _transparent_end_caps[1] = std::make_unique<ShapeCache>(
-    culler, _transparent_cache->shader(), Part{ solidMeshCapBottom() }, calculateBounds);
+  _transparent_end_caps[0] = std::make_unique<ShapeCache>(culler, _transparent_cache->shader(),
+                                                          top_cap_lods, calculateBounds);
+  _transparent_end_caps[1] = std::make_unique<ShapeCache>(culler, _transparent_cache->shader(),
+                                                          bottom_cap_lods, calculateBounds);
 
   const auto top_cap_modifier = [](Magnum::Matrix4 &transform) {
     return endCapTransformModifier(transform, true);
@@ -209,32 +211,7 @@ void Capsule::endCapTransformModifier(Magnum::Matrix4 &transform, bool positive)
 
 Magnum::GL::Mesh Capsule::solidMeshCylinder()
 {
-  static SimpleMesh build_mesh(
-    0, 0, 0, DrawType::Triangles,
-    MeshComponentFlag::Vertex | MeshComponentFlag::Normal | MeshComponentFlag::Index);
-  static std::mutex guard;
-
-  std::unique_lock<std::mutex> lock(guard);
-
-  // Build with the tes tesselator.
-  if (build_mesh.vertexCount() == 0)
-  {
-    std::vector<tes::Vector3f> vertices;
-    std::vector<tes::Vector3f> normals;
-    std::vector<unsigned> indices;
-
-    tes::cylinder::solid(vertices, indices, normals, Vector3f(0, 0, 1), kDefaultHeight,
-                         kDefaultRadius, 24, true);
-
-    build_mesh.setVertexCount(vertices.size());
-    build_mesh.setIndexCount(indices.size());
-
-    build_mesh.setVertices(0, vertices.data(), vertices.size());
-    build_mesh.setNormals(0, normals.data(), normals.size());
-    build_mesh.setIndices(0, indices.data(), indices.size());
-  }
-
-  return mesh::convert(build_mesh);
+  return mesh::convert(*tessellate::Cache::instance().solid(tessellate::CachedShape::CapsuleBody));
 }
 
 
@@ -246,39 +223,14 @@ Magnum::GL::Mesh Capsule::wireframeMeshCylinder()
 
 Magnum::GL::Mesh Capsule::solidMeshCapTop()
 {
-  static SimpleMesh build_mesh(
-    0, 0, 0, DrawType::Triangles,
-    MeshComponentFlag::Vertex | MeshComponentFlag::Normal | MeshComponentFlag::Index);
-  static std::mutex guard;
-
-  std::unique_lock<std::mutex> lock(guard);
-
-  // Build with the tes tesselator.
-  if (build_mesh.vertexCount() == 0)
-  {
-    buildEndCapSolid(build_mesh, false);
-  }
-
-  return mesh::convert(build_mesh);
+  return mesh::convert(*tessellate::Cache::instance().solid(tessellate::CachedShape::CapsuleTop));
 }
 
 
 Magnum::GL::Mesh Capsule::solidMeshCapBottom()
 {
-  static SimpleMesh build_mesh(
-    0, 0, 0, DrawType::Triangles,
-    MeshComponentFlag::Vertex | MeshComponentFlag::Normal | MeshComponentFlag::Index);
-  static std::mutex guard;
-
-  std::unique_lock<std::mutex> lock(guard);
-
-  // Build with the tes tesselator.
-  if (build_mesh.vertexCount() == 0)
-  {
-    buildEndCapSolid(build_mesh, true);
-  }
-
-  return mesh::convert(build_mesh);
+  return mesh::convert(
+    *tessellate::Cache::instance().solid(tessellate::CachedShape::CapsuleBottom));
 }
 
 
@@ -312,22 +264,4 @@ util::ResourceListId Capsule::addShape(const Id &shape_id, Type type,
   }
   return index;
 }
-
-
-void Capsule::buildEndCapSolid(SimpleMesh &mesh, bool bottomCap)
-{
-  std::vector<Vector3f> vertices;
-  std::vector<Vector3f> normals;
-  std::vector<unsigned> indices;
-
-  tes::sphere::solidLatLong(vertices, indices, normals, kDefaultRadius, Vector3f(0.0f), 4, 24,
-                            Vector3f(0, 0, (bottomCap) ? -1.0f : 1.0f), true);
-
-  mesh.setVertexCount(vertices.size());
-  mesh.setIndexCount(indices.size());
-
-  mesh.setVertices(0, vertices.data(), vertices.size());
-  mesh.setNormals(0, normals.data(), normals.size());
-  mesh.setIndices(0, indices.data(), indices.size());
-}
 }  // namespace tes::view::painter
@@ -6,11 +6,6 @@
 
 #include <3escore/Vector3.h>
 
-namespace tes
-{
-class SimpleMesh;
-}  // namespace tes
-
 namespace tes::view::painter
 {
 /// Capsule painter.
@@ -67,8 +62,6 @@ protected:
                                 const ParentId &parent_id, unsigned *child_index) override;
 
 private:
-  static void buildEndCapSolid(SimpleMesh &mesh, bool bottomCap);
-
   std::array<std::unique_ptr<ShapeCache>, 2> *endCapCachesForType(Type type);
 
   /// Transform modifier function for end cap transforms.
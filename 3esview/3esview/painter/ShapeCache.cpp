@@ -9,6 +9,8 @@
 
 #include <Corrade/Containers/ArrayViewStl.h>
 
+#include <algorithm>
+
 namespace tes::view::painter
 {
 constexpr size_t ShapeCache::kListEnd;
@@ -55,24 +57,54 @@ ShapeCache::ShapeCache(std::shared_ptr<BoundsCuller> culler,
                        std::shared_ptr<shaders::Shader> shader, const std::vector<Part> &parts,
                        BoundsCalculator bounds_calculator)
   : _culler(std::move(culler))
-  , _parts(parts)
   , _shader(std::move(shader))
   , _bounds_calculator(std::move(bounds_calculator))
 {
-  _instance_buffers.emplace_back(InstanceBuffer{ Magnum::GL::Buffer{}, 0 });
+  _lods.emplace_back(std::vector<Part>(parts), 0.0f);
 }
 
 ShapeCache::ShapeCache(std::shared_ptr<BoundsCuller> culler,
                        std::shared_ptr<shaders::Shader> shader, std::initializer_list<Part> parts,
                        BoundsCalculator bounds_calculator)
   : _culler(std::move(culler))
-  , _parts(parts)
   , _shader(std::move(shader))
   , _bounds_calculator(std::move(bounds_calculator))
 {
-  _instance_buffers.emplace_back(InstanceBuffer{ Magnum::GL::Buffer{}, 0 });
+  _lods.emplace_back(std::vector<Part>(parts), 0.0f);
+}
+
+ShapeCache::ShapeCache(std::shared_ptr<BoundsCuller> culler,
+                       std::shared_ptr<shaders::Shader> shader, const std::vector<LodLevel> &lods,
+                       BoundsCalculator bounds_calculator)
+  : _culler(std::move(culler))
+  , _shader(std::move(shader))
+  , _bounds_calculator(std::move(bounds_calculator))
+{
+  setLods(lods);
+}
+
+ShapeCache::Lod::Lod(std::vector<Part> parts, float min_screen_size)
+  : parts(std::move(parts))
+  , min_screen_size(min_screen_size)
+{}
+
+
+void ShapeCache::setLods(const std::vector<LodLevel> &lods)
+{
+  if (lods.empty())
+  {
+    return;
+  }
+
+  _lods.clear();
+  _lods.reserve(lods.size());
+  for (const auto &lod : lods)
+  {
+    _lods.emplace_back(lod.parts, lod.min_screen_size);
+  }
 }
 
+
 void ShapeCache::calcBounds(const Magnum::Matrix4 &transform, Bounds &bounds) const
 {
   _bounds_calculator(transform, bounds);
@@ -256,19 +288,20 @@ void ShapeCache::draw(const FrameStamp &stamp, const Magnum::Matrix4 &projection
   _shader->setProjectionMatrix(projection_matrix);
   _shader->setViewMatrix(view_matrix);
   _shader->setModelMatrix({});
-  buildInstanceBuffers(stamp, categories);
-  for (auto &buffer : _instance_buffers)
+  buildInstanceBuffers(stamp, projection_matrix, view_matrix, categories);
+  for (auto &lod : _lods)
   {
-    if (buffer.count)
+    for (auto &buffer : lod.instance_buffers)
     {
-      // for (const auto &part : _parts)
-      for (size_t i = 0; i < _parts.size(); ++i)
+      if (buffer.count)
       {
-        const auto &part = _parts[i];
-        // TODO(KS): see if we can enable this part transform usage.
-        // _shader->setModelMatrix(part.transform);
-        _shader->setColour(part.colour);
-        _shader->draw(*part.mesh, buffer.buffer, buffer.count);
+        for (const auto &part : lod.parts)
+        {
+          // TODO(KS): see if we can enable this part transform usage.
+          // _shader->setModelMatrix(part.transform);
+          _shader->setColour(part.colour);
+          _shader->draw(*part.mesh, buffer.buffer, buffer.count);
+        }
       }
     }
   }
@@ -342,13 +375,26 @@ bool ShapeCache::release(util::ResourceListId id)
 }
 
 
-void ShapeCache::buildInstanceBuffers(const FrameStamp &stamp, const CategoryState &categories)
+void ShapeCache::buildInstanceBuffers(const FrameStamp &stamp,
+                                      const Magnum::Matrix4 &projection_matrix,
+                                      const Magnum::Matrix4 &view_matrix,
+                                      const CategoryState &categories)
 {
   (void)stamp;
-  // Clear previous results.
-  for (auto &buffer : _instance_buffers)
+  // Clear previous results. Render resources are created on first use so a cache which never
+  // draws makes no OpenGL calls.
+  for (auto &lod : _lods)
   {
-    buffer.count = 0;
+    if (lod.instance_buffers.empty())
+    {
+      lod.instance_buffers.emplace_back(InstanceBuffer{ Magnum::GL::Buffer{}, 0 });
+      lod.marshal_buffer.resize(kMarshalBufferSize);
+    }
+    lod.current_buffer = 0;
+    for (auto &buffer : lod.instance_buffers)
+    {
+      buffer.count = 0;
+    }
   }
 
   if (!_culler)
@@ -358,22 +404,25 @@ void ShapeCache::buildInstanceBuffers(const FrameStamp &stamp, const CategorySta
 
   // Work through the instance list collecting visible items.
   auto &culler = *_culler;
-  unsigned cur_instance_buffer_idx = 0;
 
-  // Function to upload the contents of the marshalling buffer to the GPU.
-  const auto upload_buffer = [this, &cur_instance_buffer_idx](bool add_buffer_on_full) {
+  // Function to upload the contents of a LOD marshalling buffer to the GPU.
+  const auto upload_buffer = [](Lod &lod, bool add_buffer_on_full) {
     // Upload current data.
-    _instance_buffers[cur_instance_buffer_idx].buffer.setData(_marshal_buffer,
-                                                              Magnum::GL::BufferUsage::StaticDraw);
-    ++cur_instance_buffer_idx;
+    auto &buffer = lod.instance_buffers[lod.current_buffer];
+    buffer.buffer.setData(
+      Corrade::Containers::ArrayView<const ShapeInstance>(lod.marshal_buffer.data(), buffer.count),
+      Magnum::GL::BufferUsage::StaticDraw);
+    ++lod.current_buffer;
     // Start new buffer if required.
-    if (add_buffer_on_full && cur_instance_buffer_idx >= _instance_buffers.size())
+    if (add_buffer_on_full && lod.current_buffer >= lod.instance_buffers.size())
     {
-      _instance_buffers.emplace_back(InstanceBuffer{ Magnum::GL::Buffer{}, 0 });
+      lod.instance_buffers.emplace_back(InstanceBuffer{ Magnum::GL::Buffer{}, 0 });
     }
   };
 
   const bool have_transform_modifier = bool(_transform_modifier);
+  const bool select_lod = _lods.size() > 1;
+  const float projection_scale = projection_matrix[1][1];
 
   // Iterate shapes and marshal/upload.
   for (auto iter = _shapes.begin(); iter != _shapes.end(); ++iter)
@@ -381,36 +430,74 @@ void ShapeCache::buildInstanceBuffers(const FrameStamp &stamp, const CategorySta
     if ((iter->flags & (ShapeFlag::Pending | ShapeFlag::Hidden)) == ShapeFlag::None &&
         culler.isVisible(iter->bounds_id) && categories.isActive(iter->shape_id.category()))
     {
-      const unsigned marshal_index = _instance_buffers[cur_instance_buffer_idx].count;
-      ++_instance_buffers[cur_instance_buffer_idx].count;
+      ShapeInstance instance;
       if (iter->parent_rid == kListEnd)
       {
-        _marshal_buffer[marshal_index] = iter->current;
+        instance = iter->current;
       }
       else
       {
         // Child shape. Include parent transforms.
-        get(iter.id(), true, _marshal_buffer[marshal_index].transform,
-            _marshal_buffer[marshal_index].colour);
+        get(iter.id(), true, instance.transform, instance.colour);
       }
 
+      // Select the LOD before applying the transform modifier so caches drawing different parts of
+      // the same shape select the same LOD.
+      const unsigned lod_index =
+        (select_lod) ? selectLod(instance.transform, projection_scale, view_matrix) : 0u;
+
       if (have_transform_modifier)
       {
-        _transform_modifier(_marshal_buffer[marshal_index].transform);
+        _transform_modifier(instance.transform);
       }
 
+      auto &lod = _lods[lod_index];
+      auto &buffer = lod.instance_buffers[lod.current_buffer];
+      lod.marshal_buffer[buffer.count++] = instance;
+
       // Upload if at limit.
-      if (_instance_buffers[cur_instance_buffer_idx].count == _marshal_buffer.size())
+      if (buffer.count == lod.marshal_buffer.size())
       {
-        upload_buffer(true);
+        upload_buffer(lod, true);
       }
     }
   }
 
-  // Upload the last buffer.
-  if (_instance_buffers[cur_instance_buffer_idx].count > 0)
+  // Upload the last buffers.
+  for (auto &lod : _lods)
+  {
+    if (lod.current_buffer < lod.instance_buffers.size() &&
+        lod.instance_buffers[lod.current_buffer].count > 0)
+    {
+      upload_buffer(lod, false);
+    }
+  }
+}
+
+
+unsigned ShapeCache::selectLod(const Magnum::Matrix4 &transform, float projection_scale,
+                               const Magnum::Matrix4 &view_matrix) const
+{
+  // Approximate the projected size using the largest scale axis as the shape radius.
+  const float radius = std::max(
+    { transform[0].xyz().length(), transform[1].xyz().length(), transform[2].xyz().length() });
+  const float distance = -(view_matrix * Magnum::Vector4(transform[3].xyz(), 1.0f)).z();
+
+  // Use the highest detail when the camera is inside or very near the shape.
+  if (distance <= radius)
   {
-    upload_buffer(false);
+    return 0;
+  }
+
+  const float screen_size = radius * projection_scale / distance;
+  const auto lod_count = static_cast<unsigned>(_lods.size());
+  for (unsigned i = 0; i < lod_count; ++i)
+  {
+    if (screen_size >= _lods[i].min_screen_size)
+    {
+      return i;
+    }
   }
+  return lod_count - 1;
 }
 }  // namespace tes::view::painter
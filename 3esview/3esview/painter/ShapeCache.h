@@ -58,6 +58,9 @@ class CategoryState;
 ///
 /// Internally the cache maintains a free list which recycles IDs/indices in a LIFO order.
 ///
+/// OpenGL resources are only created in @c draw() . A cache constructed with no parts and a null
+/// shader tracks shapes without rendering them, such as for a headless scene, and must not draw.
+///
 /// Shapes may be added with a parent specified. Shapes with a parent use the parent transform in
 /// calculating their final transform and are visible so long as the parent is visible. @c
 /// endShape() should only be called for the parent shape and not for child shapes. Shape parenting
@@ -157,6 +160,21 @@ public:
     Part &operator=(Part &&other) = default;
   };
 
+  /// A level of detail (LOD) entry for a @c ShapeCache .
+  ///
+  /// A cache may have multiple LOD levels, each with its own @c Part set. Each shape instance is
+  /// drawn using the first LOD level where the instance's projected screen size is at least
+  /// @c min_screen_size . Levels should be ordered from highest to lowest detail with decreasing
+  /// @c min_screen_size values; the last level should use zero to catch all remaining instances.
+  struct TES_VIEWER_API LodLevel
+  {
+    /// Mesh parts to render at this LOD.
+    std::vector<Part> parts;
+    /// Minimum projected size of a shape to render at this LOD. This is expressed as the
+    /// projected shape radius as a fraction of the viewport height.
+    float min_screen_size = 0;
+  };
+
 
   /// The default implementation of a @c BoundsCalculator , calculating a spherical bounds,
   /// unaffected by rotation.
@@ -196,6 +214,15 @@ public:
              std::initializer_list<Part> parts,
              BoundsCalculator bounds_calculator = ShapeCache::calcSphericalBounds);
 
+  /// Construct a shape cache with LOD levels. See @c setLods() .
+  /// @param culler The bounds culler used to create bounds and manage bounds.
+  /// @param shader The shader used to draw the mesh.
+  /// @param lods The LOD levels, ordered from highest to lowest detail. Must not be empty.
+  /// @param bounds_calculator Bounds calculation function.
+  ShapeCache(std::shared_ptr<BoundsCuller> culler, std::shared_ptr<shaders::Shader> shader,
+             const std::vector<LodLevel> &lods,
+             BoundsCalculator bounds_calculator = ShapeCache::calcSphericalBounds);
+
   /// Calculate the bounds for a shape instance with the given transform.
   /// @param transform The shape instance transformation matrix.
   /// @param[out] centre Calculated bounds centre.
@@ -204,6 +231,18 @@ public:
 
   [[nodiscard]] std::shared_ptr<shaders::Shader> shader() const { return _shader; }
 
+  /// Set the LOD levels for the cache, replacing the current parts.
+  ///
+  /// Shape instances are assigned to a LOD level based on their projected screen size while
+  /// marshalling instances in @c draw() . Setting a single level disables LOD selection.
+  ///
+  /// @param lods The LOD levels, ordered from highest to lowest detail. Ignored if empty.
+  void setLods(const std::vector<LodLevel> &lods);
+
+  /// Query the number of LOD levels.
+  /// @return The LOD level count. Always at least one.
+  [[nodiscard]] size_t lodCount() const { return _lods.size(); }
+
   /// Set the bounds calculation function.
   /// @param bounds_calculator New bounds calculation function.
   void setBoundsCalculator(BoundsCalculator bounds_calculator)
@@ -217,7 +256,8 @@ public:
   /// Set the active transform modifier. May be empty.
   ///
   /// Applied when finalising the render transform for a shape. The @c transform passed to the @p
-  /// modifier will have the parent transform included.
+  /// modifier will have the parent transform included. LOD selection uses the transform before
+  /// modification.
   ///
   /// @param modifier The transform modifier function.
   void setTransformModifier(const TransformModifier &modifier) { _transform_modifier = modifier; }
@@ -449,7 +489,8 @@ private:
     [[nodiscard]] bool isChild() const { return parent_rid != kListEnd; }
   };
 
-  /// Instance buffer used to render shapes. Only valid during the @c draw() call.
+  /// Instance buffer used to render shapes. Only valid during the @c draw() call. The first buffer
+  /// for each @c Lod is created on the first @c draw() call.
   struct InstanceBuffer
   {
     /// Graphics buffer to which shape instances are marshalled.
@@ -458,6 +499,27 @@ private:
     unsigned count = 0;
   };
 
+  /// Number of shape instances marshalled per @c InstanceBuffer .
+  static constexpr size_t kMarshalBufferSize = 2048;
+
+  /// Render data for a LOD level.
+  struct Lod
+  {
+    /// Mesh parts to render.
+    std::vector<Part> parts;
+    /// Minimum projected screen size for this LOD. See @c LodLevel .
+    float min_screen_size = 0;
+    /// Instance buffers used to render shapes at this LOD.
+    std::vector<InstanceBuffer> instance_buffers;
+    /// Buffer used to marshal active shape instances in @c buildInstanceBuffers() . The size of
+    /// this array determines the number of instances per @p InstanceBuffer .
+    std::vector<ShapeInstance> marshal_buffer;
+    /// Index of the @c InstanceBuffer currently being populated in @c buildInstanceBuffers().
+    unsigned current_buffer = 0;
+
+    Lod(std::vector<Part> parts, float min_screen_size);
+  };
+
   void calcBoundsForShape(const Shape &child, Bounds &bounds) const;
 
   /// Release a shape to the free list. This also releases the shape chain if this is the head of a
@@ -469,23 +531,30 @@ private:
   /// @return True if the shape was valid for release and successfully released.
   bool release(util::ResourceListId id);
 
-  /// Fill the @p InstanceBuffer objects in @c _instance_buffers .
+  /// Fill the @p InstanceBuffer objects for each of the @c _lods .
   /// @param stamp The frame stamp to draw shapes for.
+  /// @param projection_matrix View to projection matrix. Used for LOD selection.
+  /// @param view_matrix World to view matrix. Used for LOD selection.
   /// @param categories Describes the active categories.
-  void buildInstanceBuffers(const FrameStamp &stamp, const CategoryState &categories);
+  void buildInstanceBuffers(const FrameStamp &stamp, const Magnum::Matrix4 &projection_matrix,
+                            const Magnum::Matrix4 &view_matrix, const CategoryState &categories);
+
+  /// Select the LOD index for a shape instance.
+  /// @param transform The shape instance transform, including parent transforms, before the
+  /// transform modifier is applied.
+  /// @param projection_scale The vertical projection scale, `projection_matrix[1][1]`.
+  /// @param view_matrix World to view matrix.
+  /// @return The index into @c _lods to draw the instance with.
+  [[nodiscard]] unsigned selectLod(const Magnum::Matrix4 &transform, float projection_scale,
+                                   const Magnum::Matrix4 &view_matrix) const;
 
   /// The bounds culler used to determine visibility.
   std::shared_ptr<BoundsCuller> _culler;
   /// Instantiated shape array. Some may be pending first view.
   util::ResourceList<Shape> _shapes;
-  /// Mesh parts to render.
-  std::vector<Part> _parts;
-  /// Transformation matrix applied to the shape before rendering. This allows the Magnum primitives
-  /// to be transformed to suit the 3rd Eye Scene rendering.
-  std::vector<InstanceBuffer> _instance_buffers;
-  /// Buffer used to marshal active shape instances in @c buildInstanceBuffers() . The size of this
-  /// array determines the number of instances per @p InstanceBuffer .
-  std::array<ShapeInstance, 2048> _marshal_buffer;
+  /// LOD levels to render, each with its own mesh parts and instance buffers. Always has at least
+  /// one entry.
+  std::vector<Lod> _lods;
   /// Shaper used to draw the shapes.
   std::shared_ptr<shaders::Shader> _shader;
   /// Bounds calculation function.
@@ -1,11 +1,14 @@
 #include "ShapePainter.h"
 
+#include "3esview/mesh/Converter.h"
 #include "3esview/shaders/ShaderLibrary.h"
 
 #include <3escore/shapes/Id.h>
 
 #include <Magnum/GL/Renderer.h>
 
+#include <array>
+
 namespace tes::view::painter
 {
 ShapePainter::ShapePainter(const std::shared_ptr<BoundsCuller> &culler,
@@ -35,9 +38,48 @@ ShapePainter::ShapePainter(const std::shared_ptr<BoundsCuller> &culler,
 }
 
 
+ShapePainter::ShapePainter(const std::shared_ptr<BoundsCuller> &culler,
+                           const std::shared_ptr<shaders::ShaderLibrary> &shaders,
+                           const std::vector<LodLevel> &solid_lods,
+                           const std::vector<Part> &wireframe,
+                           const BoundsCalculator &bounds_calculator)
+{
+  auto shader = shaders->lookup(shaders::ShaderLibrary::ID::Flat);
+  _solid_cache = std::make_unique<ShapeCache>(culler, shader, solid_lods, bounds_calculator);
+  _wireframe_cache = std::make_unique<ShapeCache>(culler, shader, wireframe, bounds_calculator);
+  _transparent_cache = std::make_unique<ShapeCache>(culler, shader, solid_lods, bounds_calculator);
+}
+
+
+ShapePainter::ShapePainter(const std::shared_ptr<BoundsCuller> &culler,
+                           const BoundsCalculator &bounds_calculator)
+{
+  const std::vector<Part> no_parts;
+  _solid_cache = std::make_unique<ShapeCache>(culler, nullptr, no_parts, bounds_calculator);
+  _wireframe_cache = std::make_unique<ShapeCache>(culler, nullptr, no_parts, bounds_calculator);
+  _transparent_cache = std::make_unique<ShapeCache>(culler, nullptr, no_parts, bounds_calculator);
+}
+
 ShapePainter::~ShapePainter() = default;
 
 
+std::vector<ShapePainter::LodLevel> ShapePainter::buildLods(tessellate::CachedShape shape)
+{
+  // Minimum projected screen size for each LOD level, expressed as a fraction of the viewport
+  // height.
+  static constexpr std::array<float, tessellate::Cache::kLodCount> kLodScreenSizes = { 0.1f, 0.025f,
+                                                                                       0.0f };
+  std::vector<LodLevel> lods;
+  for (unsigned lod = 0; lod < tessellate::Cache::kLodCount; ++lod)
+  {
+    auto mesh = std::make_shared<Magnum::GL::Mesh>(
+      mesh::convert(*tessellate::Cache::instance().solid(shape, lod)));
+    lods.emplace_back(LodLevel{ { Part{ std::move(mesh) } }, kLodScreenSizes[lod] });
+  }
+  return lods;
+}
+
+
 void ShapePainter::reset()
 {
   _solid_cache->clear();
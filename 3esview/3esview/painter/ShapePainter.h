@@ -5,6 +5,7 @@
 #include "ShapeCache.h"
 
 #include <3escore/shapes/Id.h>
+#include <3escore/tessellate/Cache.h>
 
 #include <Magnum/GL/Mesh.h>
 
@@ -33,6 +34,8 @@ class TES_VIEWER_API ShapePainter
 public:
   /// Part alias from @c ShapeCache .
   using Part = ShapeCache::Part;
+  /// LOD level alias from @c ShapeCache .
+  using LodLevel = ShapeCache::LodLevel;
   /// Bounds calculation function signature.
   using BoundsCalculator = ShapeCache::BoundsCalculator;
 
@@ -123,6 +126,27 @@ public:
                const std::vector<Part> &solid, const std::vector<Part> &wireframe,
                const std::vector<Part> &transparent, const BoundsCalculator &bounds_calculator);
 
+  /// Construct a shape painter with LOD levels for solid and transparent rendering.
+  ///
+  /// The solid and transparent caches share the mesh parts of @p solid_lods .
+  /// @param culler The @c BoundsCuller used for visibility checking.
+  /// @param solid_lods LOD levels used for solid and transparent rendering. See @c buildLods() .
+  /// @param wireframe Mesh used for wireframe rendering (line based).
+  /// @param bounds_calculator Bounds calculation function.
+  ShapePainter(const std::shared_ptr<BoundsCuller> &culler,
+               const std::shared_ptr<shaders::ShaderLibrary> &shaders,
+               const std::vector<LodLevel> &solid_lods, const std::vector<Part> &wireframe,
+               const BoundsCalculator &bounds_calculator);
+
+  /// Construct a shape painter which tracks shapes without any render resources.
+  ///
+  /// This supports the @c handler::Message::ModeFlag::Headless mode. The painter maintains the
+  /// shape state as normal, but makes no OpenGL calls and must not draw.
+  /// @param culler The @c BoundsCuller used to track shape bounds.
+  /// @param bounds_calculator Bounds calculation function.
+  ShapePainter(const std::shared_ptr<BoundsCuller> &culler,
+               const BoundsCalculator &bounds_calculator);
+
   ShapePainter(const ShapePainter &other) = delete;
 
   /// Destructor.
@@ -394,6 +418,14 @@ protected:
     return addShape(shape_id, type, transform, colour, hidden, ParentId(), nullptr);
   }
 
+  /// Build the @c LodLevel set for a cached tessellation shape using the tessellation @c Cache .
+  ///
+  /// The returned mesh parts may be shared between the solid and transparent caches.
+  ///
+  /// @param shape The shape to build LOD levels for.
+  /// @return The LOD levels, from highest to lowest detail.
+  [[nodiscard]] static std::vector<LodLevel> buildLods(tessellate::CachedShape shape);
+
   [[nodiscard]] ShapeCache *cacheForType(Type type);
   [[nodiscard]] const ShapeCache *cacheForType(Type type) const;
 
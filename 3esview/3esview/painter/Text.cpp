@@ -8,25 +8,73 @@
 
 #include <3escore/Log.h>
 
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Containers/PointerStl.h>
 #include <Corrade/Containers/StringStl.h>
 #include <Corrade/Utility/Resource.h>
 
+#include <Magnum/GL/MeshView.h>
 #include <Magnum/GL/Renderer.h>
+#include <Magnum/Math/Intersection.h>
 #include <Magnum/Math/Matrix3.h>
 #include <Magnum/Math/Matrix4.h>
 #include <Magnum/Math/Quaternion.h>
 #include <Magnum/Math/Vector2.h>
 #include <Magnum/Text/AbstractFont.h>
 
+#include <algorithm>
+#include <array>
 #include <cctype>
 #include <limits>
 
 namespace tes::view::painter
 {
-Text::Text(Corrade::PluginManager::Manager<Magnum::Text::AbstractFont> &font_manager,
+namespace
+{
+/// Layout font size for 2D text (pixels).
+constexpr float kLayoutSize2D = 32.0f;
+/// Layout font size for 3D text (world units before font size scaling).
+constexpr float kLayoutSize3D = 0.1f;
+/// Number of draw calls a glyph run may go unused before it may be evicted. Allows for multiple
+/// draw calls per frame.
+constexpr unsigned kRunEvictionAge = 8u;
+
+struct Vertex2D
+{
+  Magnum::Vector2 position;
+  Magnum::Vector2 texture_coordinates;
+};
+
+struct Vertex3D
+{
+  Magnum::Vector3 position;
+  Magnum::Vector2 texture_coordinates;
+};
+
+Vertex2D makeVertex(const Magnum::Matrix3 &transform, const Magnum::Vector2 &position,
+                    const Magnum::Vector2 &texture_coordinates)
+{
+  return { transform.transformPoint(position), texture_coordinates };
+}
+
+Vertex3D makeVertex(const Magnum::Matrix4 &transform, const Magnum::Vector2 &position,
+                    const Magnum::Vector2 &texture_coordinates)
+{
+  return { transform.transformPoint(Magnum::Vector3(position, 0.0f)), texture_coordinates };
+}
+
+bool colourLess(const Magnum::Color4 &a, const Magnum::Color4 &b)
+{
+  return std::lexicographical_compare(a.data(), a.data() + 4, b.data(), b.data() + 4);
+}
+}  // namespace
+
+
+Text::Text(std::shared_ptr<BoundsCuller> culler,
+           Corrade::PluginManager::Manager<Magnum::Text::AbstractFont> &font_manager,
            const std::string &font_resource_name, const std::string &fonts_resource_section,
            const std::string &font_plugin)
+  : _culler(std::move(culler))
 {
   // TODO(KS): get resources strings passed in as it's the exe which must include the resources.
   const Corrade::Utility::Resource rs(fonts_resource_section);
@@ -51,15 +99,13 @@ Text::Text(Corrade::PluginManager::Manager<Magnum::Text::AbstractFont> &font_man
 
     _font->fillGlyphCache(*_cache, printable_characters);
 
-    constexpr float kCacheSize = 32.0f;
-    _renderer_2d = std::make_unique<Magnum::Text::Renderer2D>(*_font, *_cache, kCacheSize,
-                                                              Magnum::Text::Alignment::MiddleLeft);
-    _renderer_2d->reserve(kMaxTextLength, Magnum::GL::BufferUsage::DynamicDraw,
-                          Magnum::GL::BufferUsage::StaticDraw);
-    _renderer_3d = std::make_unique<Magnum::Text::Renderer3D>(
-      *_font, *_cache, 0.1f, Magnum::Text::Alignment::MiddleCenter);
-    _renderer_3d->reserve(kMaxTextLength, Magnum::GL::BufferUsage::DynamicDraw,
-                          Magnum::GL::BufferUsage::StaticDraw);
+    _mesh_2d.setPrimitive(Magnum::MeshPrimitive::Triangles)
+      .addVertexBuffer(_vertex_buffer_2d, 0, Magnum::Shaders::DistanceFieldVectorGL2D::Position{},
+                       Magnum::Shaders::DistanceFieldVectorGL2D::TextureCoordinates{});
+    _mesh_3d.setPrimitive(Magnum::MeshPrimitive::Triangles)
+      .addVertexBuffer(_vertex_buffer_3d, 0, Magnum::Shaders::DistanceFieldVectorGL3D::Position{},
+                       Magnum::Shaders::DistanceFieldVectorGL3D::TextureCoordinates{});
+    ensureIndexCapacity(kMaxTextLength);
   }
   else
   {
@@ -91,6 +137,19 @@ bool Text::isAvailable() const
 }
 
 
+Bounds Text::calculateBounds(const TextEntry &text) const
+{
+  // Glyphs are no wider than the font size and the text is centred, so half the text length in
+  // font size units bounds the layout in any orientation. Add one character for the height.
+  const auto position = text.transform[3].xyz();
+  const float font_size = (text.font_size != 0) ? text.font_size : 1.0f;
+  const float scale = text.transform.scaling().max() * font_size * kLayoutSize3D;
+  const auto length = static_cast<float>(std::min<size_t>(text.text.length(), kMaxTextLength));
+  const float half_extent = scale * (0.5f * length + 1.0f);
+  return Bounds::fromCentreHalfExtents(position, Magnum::Vector3(half_extent));
+}
+
+
 void Text::beginDraw()
 {
   Magnum::GL::Renderer::enable(Magnum::GL::Renderer::Feature::Blending);
@@ -136,8 +195,13 @@ void Text::endDraw3D()
 }
 
 
-void Text::draw2DText(const TextEntry &text, const DrawParams &params)
+void Text::add2DText(const TextEntry &text, const DrawParams &params)
 {
+  if (text.text.empty())
+  {
+    return;
+  }
+
   // Adjust the position from [0, 1] to [-0.5, 0.5] with Y inverted so that +y is downs.
   auto text_position = text.transform[3].xyz();
   Magnum::Vector2 norm_position = {};
@@ -155,21 +219,52 @@ void Text::draw2DText(const TextEntry &text, const DrawParams &params)
   // We try render text out range for a bit to allow long text to start offscreen. The right
   // solution is to clip properly, but this is enough for now.
   // TODO(KS): clip text correctly.
-  if (norm_position.x() < -1 || norm_position.x() > 1 ||
-      norm_position.y() < -1 && norm_position.y() > 1)
+  if (norm_position.x() < -1 || norm_position.x() > 1 || norm_position.y() < -1 ||
+      norm_position.y() > 1)
   {
     return;
   }
 
   const auto view_size = Magnum::Vector2(params.view_size);
-  const auto text_transform = Magnum::Matrix3::projection(view_size) *
-                              Magnum::Matrix3::translation(norm_position * view_size);
-  draw(text, text_transform, *_renderer_2d, _shader_2d);
+  PendingText<Magnum::Matrix3> pending;
+  pending.run = &glyphRun(text.text, _runs_2d, kLayoutSize2D, false);
+  pending.transform = Magnum::Matrix3::translation(norm_position * view_size);
+  pending.colour = text.colour;
+  _pending_2d.emplace_back(pending);
+}
+
+
+void Text::prepare3D(const DrawParams &params)
+{
+  _view_frustum = Magnum::Math::Frustum<Magnum::Float>::fromMatrix(params.pv_transform);
 }
 
 
-void Text::draw3DText(const TextEntry &text, const DrawParams &params)
+void Text::add3DText(const TextEntry &text, const DrawParams &params)
 {
+  if (text.text.empty())
+  {
+    return;
+  }
+
+  // Cull before layout.
+  if (_culler && text.bounds_id != BoundsCuller::kInvalidId)
+  {
+    if (!_culler->isVisible(text.bounds_id))
+    {
+      return;
+    }
+  }
+  else
+  {
+    const auto bounds = calculateBounds(text);
+    if (!Magnum::Math::Intersection::aabbFrustum(bounds.centre(), bounds.halfExtents(),
+                                                 _view_frustum))
+    {
+      return;
+    }
+  }
+
   auto text_transform = text.transform;
   const auto text_position = text.transform[3].xyz();
   if ((text.flags & TextFlag::ScreenFacing) != TextFlag::Zero)
@@ -207,39 +302,206 @@ void Text::draw3DText(const TextEntry &text, const DrawParams &params)
     text_transform = text_transform * Magnum::Matrix4::scaling(Magnum::Vector3(text.font_size));
   }
 
-  draw(text, params.pv_transform * text_transform * _default_transform, *_renderer_3d, _shader_3d);
+  PendingText<Magnum::Matrix4> pending;
+  pending.run = &glyphRun(text.text, _runs_3d, kLayoutSize3D, true);
+  pending.transform = text_transform * _default_transform;
+  pending.colour = text.colour;
+  _pending_3d.emplace_back(pending);
 }
 
 
-template <typename Matrix, typename Renderer, typename Shader>
-void Text::draw(const TextEntry &text, const Matrix &full_projection_matrix, Renderer &renderer,
-                Shader &shader)
+void Text::flush2D(const DrawParams &params)
 {
-  using namespace Magnum::Math::Literals;
+  if (!_pending_2d.empty())
+  {
+    std::vector<Vertex2D> vertices;
+    pack(_pending_2d, vertices, _ranges);
+    _vertex_buffer_2d.setData(vertices, Magnum::GL::BufferUsage::StreamDraw);
+
+    beginDraw2D();
+    drawRanges(Magnum::Matrix3::projection(Magnum::Vector2(params.view_size)), _mesh_2d,
+               _shader_2d);
+    endDraw2D();
+  }
 
-  if (text.text.empty())
+  _pending_2d.clear();
+  evictRuns(_runs_2d);
+}
+
+
+void Text::flush3D(const DrawParams &params)
+{
+  if (!_pending_3d.empty())
+  {
+    std::vector<Vertex3D> vertices;
+    pack(_pending_3d, vertices, _ranges);
+    _vertex_buffer_3d.setData(vertices, Magnum::GL::BufferUsage::StreamDraw);
+
+    beginDraw3D();
+    drawRanges(params.pv_transform, _mesh_3d, _shader_3d);
+    endDraw3D();
+  }
+
+  _pending_3d.clear();
+  evictRuns(_runs_3d);
+}
+
+
+const Text::GlyphRun &Text::glyphRun(const std::string &text,
+                                     std::unordered_map<std::string, GlyphRun> &cache, float size,
+                                     bool centre)
+{
+  auto search = cache.find(text);
+  if (search == cache.end())
+  {
+    GlyphRun run;
+    const auto layouter = (text.length() <= kMaxTextLength) ?
+                            _font->layout(*_cache, size, text) :
+                            _font->layout(*_cache, size, text.substr(0, kMaxTextLength));
+    const unsigned glyph_count = layouter->glyphCount();
+    run.positions.reserve(4u * glyph_count);
+    run.texture_coordinates.reserve(4u * glyph_count);
+    Magnum::Vector2 cursor = {};
+    Magnum::Range2D rectangle = {};
+    for (unsigned i = 0; i < glyph_count; ++i)
+    {
+      const auto [quad, texture] = layouter->renderGlyph(i, cursor, rectangle);
+      run.positions.insert(run.positions.end(), { quad.topLeft(), quad.bottomLeft(),
+                                                  quad.topRight(), quad.bottomRight() });
+      run.texture_coordinates.insert(run.texture_coordinates.end(),
+                                     { texture.topLeft(), texture.bottomLeft(),
+                                       texture.topRight(), texture.bottomRight() });
+    }
+
+    // Align: always vertically centred, optionally horizontally centred.
+    const Magnum::Vector2 offset{ centre ? -rectangle.centerX() : 0.0f, -rectangle.centerY() };
+    for (auto &position : run.positions)
+    {
+      position += offset;
+    }
+    run.bounds = rectangle.translated(offset);
+    search = cache.emplace(text, std::move(run)).first;
+  }
+
+  search->second.last_used = _draw_stamp;
+  return search->second;
+}
+
+
+void Text::evictRuns(std::unordered_map<std::string, GlyphRun> &cache)
+{
+  if (cache.size() > kMaxCachedRuns)
+  {
+    for (auto iter = cache.begin(); iter != cache.end();)
+    {
+      iter = (_draw_stamp - iter->second.last_used > kRunEvictionAge) ? cache.erase(iter) :
+                                                                         std::next(iter);
+    }
+  }
+  ++_draw_stamp;
+}
+
+
+void Text::ensureIndexCapacity(unsigned quad_count)
+{
+  if (quad_count <= _index_quad_capacity)
   {
     return;
   }
 
-  if (text.text.length() <= renderer.capacity())
+  unsigned capacity = std::max(_index_quad_capacity, 1u);
+  while (capacity < quad_count)
   {
-    renderer.render(text.text);
+    capacity *= 2u;
   }
-  else
+
+  // Same quad winding as Magnum::Text::Renderer.
+  constexpr std::array<Magnum::UnsignedInt, 6> kQuadIndices = { 0, 1, 2, 1, 3, 2 };
+  std::vector<Magnum::UnsignedInt> indices;
+  indices.reserve(kQuadIndices.size() * capacity);
+  for (Magnum::UnsignedInt quad = 0; quad < capacity; ++quad)
+  {
+    for (const auto index : kQuadIndices)
+    {
+      indices.emplace_back(4u * quad + index);
+    }
+  }
+  _index_buffer.setData(indices, Magnum::GL::BufferUsage::StaticDraw);
+  _mesh_2d.setIndexBuffer(_index_buffer, 0, Magnum::GL::MeshIndexType::UnsignedInt);
+  _mesh_3d.setIndexBuffer(_index_buffer, 0, Magnum::GL::MeshIndexType::UnsignedInt);
+  _index_quad_capacity = capacity;
+}
+
+
+template <typename Vertex, typename Matrix>
+void Text::pack(std::vector<PendingText<Matrix>> &pending, std::vector<Vertex> &vertices,
+                std::vector<QuadRange> &ranges)
+{
+  // Group by colour so we need only one draw call per colour.
+  std::stable_sort(pending.begin(), pending.end(),
+                   [](const PendingText<Matrix> &a, const PendingText<Matrix> &b) {
+                     return colourLess(a.colour, b.colour);
+                   });
+
+  size_t vertex_count = 0;
+  for (const auto &text : pending)
+  {
+    vertex_count += text.run->positions.size();
+  }
+  vertices.clear();
+  vertices.reserve(vertex_count);
+  ranges.clear();
+
+  for (const auto &text : pending)
+  {
+    const auto &run = *text.run;
+    const auto first_quad = static_cast<unsigned>(vertices.size() / 4u);
+    for (size_t i = 0; i < run.positions.size(); ++i)
+    {
+      vertices.emplace_back(
+        makeVertex(text.transform, run.positions[i], run.texture_coordinates[i]));
+    }
+
+    const auto quad_count = static_cast<unsigned>(run.positions.size() / 4u);
+    if (!ranges.empty() && ranges.back().colour == text.colour)
+    {
+      ranges.back().count += quad_count;
+    }
+    else if (quad_count)
+    {
+      ranges.emplace_back(QuadRange{ first_quad, quad_count, text.colour });
+    }
+  }
+}
+
+
+template <typename Matrix, typename Shader>
+void Text::drawRanges(const Matrix &projection_matrix, Magnum::GL::Mesh &mesh, Shader &shader)
+{
+  using namespace Magnum::Math::Literals;
+
+  if (_ranges.empty())
   {
-    const std::string truncated = text.text.substr(0, renderer.capacity());
-    renderer.render(truncated);
+    return;
   }
 
+  ensureIndexCapacity(_ranges.back().first + _ranges.back().count);
+
   const auto outline_colour = 0x7f7f7f_rgbf;
   constexpr auto kOutlineStart = 0.45f;
   constexpr auto kOutlineEnd = 0.35f;
-  shader.setTransformationProjectionMatrix(full_projection_matrix)
-    .setColor(text.colour)
+  shader.bindVectorTexture(_cache->texture())
+    .setTransformationProjectionMatrix(projection_matrix)
     .setOutlineColor(outline_colour)
-    .setOutlineRange(kOutlineStart, kOutlineEnd)
-    // .setSmoothness(0.025f / _transformationRotatingText.uniformScaling())
-    .draw(renderer.mesh());
+    .setOutlineRange(kOutlineStart, kOutlineEnd);
+  // .setSmoothness(0.025f / _transformationRotatingText.uniformScaling())
+
+  Magnum::GL::MeshView view{ mesh };
+  for (const auto &range : _ranges)
+  {
+    view.setCount(static_cast<Magnum::Int>(6u * range.count))
+      .setIndexRange(static_cast<Magnum::Int>(6u * range.first));
+    shader.setColor(range.colour).draw(view);
+  }
 }
 }  // namespace tes::view::painter
@@ -5,21 +5,30 @@
 
 #include <3esview/ViewConfig.h>
 
+#include <3esview/BoundsCuller.h>
+
 #include <3escore/Enum.h>
 
 #include <Corrade/PluginManager/Manager.h>
 
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Color.h>
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Matrix3.h>
 #include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
 #include <Magnum/Math/Vector2.h>
 #include <Magnum/Shaders/DistanceFieldVectorGL.h>
 #include <Magnum/Text/AbstractFont.h>
 #include <Magnum/Text/DistanceFieldGlyphCache.h>
-#include <Magnum/Text/Renderer.h>
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace Magnum::Text
 {
@@ -34,7 +43,8 @@ struct DrawParams;
 
 namespace tes::view::painter
 {
-/// This class renders 2D and 3D text using an immediate mode style rendering.
+/// This class renders 2D and 3D text using an immediate mode style API over retained, batched
+/// rendering.
 ///
 /// The two public draw methods - @c draw2D() and @c draw3D() - are designed to draw a collection of
 /// @c TextEntry items. The expected usage is to have @c TextEntry items in either a vector or
@@ -64,11 +74,21 @@ namespace tes::view::painter
 ///
 /// This interface also supports rendering from a container which indirectly contains @c TextEntry
 /// items.
+///
+/// Internally, each unique string is laid out once into a glyph run which is cached across frames.
+/// Each draw call culls the entries, then packs the glyph quads for all visible entries into a
+/// single vertex buffer. The buffer is drawn with one draw call per unique text colour. 3D entries
+/// with a valid @c TextEntry::bounds_id are culled using the @c BoundsCuller ; the owner of the
+/// entry is responsible for allocating and maintaining the bounds - see @c calculateBounds() .
+/// Other 3D entries are culled against the view frustum directly.
 class TES_VIEWER_API Text
 {
 public:
   /// A hard limit to the number of characters we can render in a text string.
   static constexpr unsigned kMaxTextLength = 1024u;
+  /// Maximum number of glyph runs to cache for each of 2D and 3D text. Runs which have not been
+  /// used recently are evicted once this is exceeded.
+  static constexpr size_t kMaxCachedRuns = 4096u;
 
   /// Flags which affect text rendering.
   enum class TextFlag : unsigned
@@ -99,14 +119,18 @@ public:
     TextFlag flags = TextFlag::Zero;
     /// Category ID - see @c painter::CategoryState .
     unsigned category_id = 0u;
+    /// Optional @c BoundsCuller entry for culling 3D text.
+    BoundsId bounds_id = BoundsCuller::kInvalidId;
   };
 
   /// Construct a text renderer.
+  /// @param culler The bounds culler used to cull 3D text. May be null.
   /// @param font_manager The font manager plugin to load fonts from.
   /// @param font_resource_name The true type font resource name.
   /// @param fonts_resource_section The resource data section containing the font.
   /// @param font_plugin The font plugin name.
-  Text(Corrade::PluginManager::Manager<Magnum::Text::AbstractFont> &font_manager,
+  Text(std::shared_ptr<BoundsCuller> culler,
+       Corrade::PluginManager::Manager<Magnum::Text::AbstractFont> &font_manager,
        const std::string &font_resource_name = "SourceSansPro-Regular.ttf",
        const std::string &fonts_resource_section = "resources",
        const std::string &font_plugin = "TrueTypeFont");
@@ -115,6 +139,19 @@ public:
   /// @return True if text rendering is availabe.
   [[nodiscard]] bool isAvailable() const;
 
+  /// Access the @c BoundsCuller used to cull 3D text.
+  /// @return The bounds culler. May be null.
+  [[nodiscard]] const std::shared_ptr<BoundsCuller> &culler() const { return _culler; }
+
+  /// Calculate conservative world bounds for a 3D @c TextEntry .
+  ///
+  /// The bounds do not require the text layout and are valid for any text orientation, including
+  /// @c TextFlag::ScreenFacing text.
+  ///
+  /// @param text The text entry.
+  /// @return The text bounds.
+  [[nodiscard]] Bounds calculateBounds(const TextEntry &text) const;
+
   /// Draw a collection of 2D @c TextEntry items.
   ///
   /// See class comments for usage examples.
@@ -173,6 +210,44 @@ public:
   }
 
 private:
+  /// A laid out string. Glyph quads are stored as four vertices each in the order: top left,
+  /// bottom left, top right, bottom right.
+  struct GlyphRun
+  {
+    /// Glyph quad vertex positions in layout space.
+    std::vector<Magnum::Vector2> positions;
+    /// Glyph quad texture coordinates.
+    std::vector<Magnum::Vector2> texture_coordinates;
+    /// Bounds of the glyph positions.
+    Magnum::Range2D bounds;
+    /// Value of @c _draw_stamp when this run was last used.
+    unsigned last_used = 0;
+  };
+
+  /// A visible text entry pending submission.
+  /// @tparam Matrix The entry transformation matrix type of rank 3 or 4.
+  template <typename Matrix>
+  struct PendingText
+  {
+    /// The glyph run to draw.
+    const GlyphRun *run = nullptr;
+    /// Transformation from layout space into the shader input space.
+    Matrix transform;
+    /// Text colour.
+    Magnum::Color4 colour;
+  };
+
+  /// A range of quads sharing the same colour.
+  struct QuadRange
+  {
+    /// Index of the first quad.
+    unsigned first = 0;
+    /// Number of quads.
+    unsigned count = 0;
+    /// Quad colour.
+    Magnum::Color4 colour;
+  };
+
   /// Common setup for drawing of 2D or 3D text.
   void beginDraw();
   /// Common tear down for drawing of 2D or 3D text.
@@ -188,36 +263,58 @@ private:
   /// Tear down drawing of 3D text.
   void endDraw3D();
 
-  /// Draw 2D text.
+  /// Add 2D text for drawing by @c flush2D() .
   ///
   /// 2D text is rendered in an overlay and always the same size. This should only be called during
   /// the overlay draw pass.
-  void draw2DText(const TextEntry &text, const DrawParams &params);
+  void add2DText(const TextEntry &text, const DrawParams &params);
+
+  /// Prepare to add 3D text, caching the view frustum for culling.
+  void prepare3D(const DrawParams &params);
 
-  /// Draw 3D text.
+  /// Add 3D text for drawing by @c flush3D() . Culls the text first.
   ///
   /// 3D text is rendered in the scene and is perspective scaled. 3D text should be rendered during
   /// the opaque draw pass. This should only be called during the opaque or transparent rendering
   /// passes.
-  void draw3DText(const TextEntry &text, const DrawParams &params);
+  void add3DText(const TextEntry &text, const DrawParams &params);
+
+  /// Draw all text added by @c add2DText() .
+  void flush2D(const DrawParams &params);
+  /// Draw all text added by @c add3DText() .
+  void flush3D(const DrawParams &params);
+
+  /// Resolve the cached glyph run for @p text , laying out the text as required.
+  /// @param text The text to lay out. Truncated to @c kMaxTextLength .
+  /// @param cache The run cache to resolve from.
+  /// @param size The layout font size.
+  /// @param centre True to centre the text horizontally. The text is always vertically centred.
+  /// @return The glyph run. Valid until the next @c evictRuns() call.
+  const GlyphRun &glyphRun(const std::string &text,
+                           std::unordered_map<std::string, GlyphRun> &cache, float size,
+                           bool centre);
+
+  /// Evict runs from @p cache which have not been used recently when the cache is full.
+  void evictRuns(std::unordered_map<std::string, GlyphRun> &cache);
 
-  /// Draw a single text item.
-  /// @tparam Renderer The text renderer type: `[Magnum::Text::Renderer2D,
-  /// Magnum::Text::Renderer3D]`
-  /// @tparam Matrix The text transformation matrix type of rank 3 or 4.
+  /// Ensure the shared index buffer can index at least @p quad_count quads.
+  void ensureIndexCapacity(unsigned quad_count);
+
+  /// Pack the @p pending text vertices into @p vertices , grouped by colour into @p ranges .
+  /// @tparam Vertex The vertex type: position and texture coordinates.
+  /// @tparam Matrix The transformation matrix type of rank 3 or 4.
+  template <typename Vertex, typename Matrix>
+  static void pack(std::vector<PendingText<Matrix>> &pending, std::vector<Vertex> &vertices,
+                   std::vector<QuadRange> &ranges);
+
+  /// Draw the quad @p ranges from @p mesh .
+  /// @tparam Matrix The projection matrix type of rank 3 or 4.
   /// @tparam Shader The text shader type:
   ///   `[Magnum::Shader::DistanceFieldVectorGL2D, Magnum::Shader::DistanceFieldVectorGL3D]`
-  /// @param text The text item to draw.
-  /// @param full_projection_matrix The full transformation matrix including projection, camera and
-  /// model transforms.
-  /// @param renderer The text renderer.
-  /// @param shader The text shader.
-  template <typename Matrix, typename Renderer, typename Shader>
-  void draw(const TextEntry &text, const Matrix &full_projection_matrix, Renderer &renderer,
-            Shader &shader);
-
-  std::unique_ptr<Magnum::Text::Renderer2D> _renderer_2d;
-  std::unique_ptr<Magnum::Text::Renderer3D> _renderer_3d;
+  template <typename Matrix, typename Shader>
+  void drawRanges(const Matrix &projection_matrix, Magnum::GL::Mesh &mesh, Shader &shader);
+
+  std::shared_ptr<BoundsCuller> _culler;
   /// Default transformation matrix required to get the text from facing along Z to align with the
   /// world up vector, facing back along the forward vector.
   Magnum::Matrix4 _default_transform;
@@ -226,6 +323,28 @@ private:
   Magnum::Shaders::DistanceFieldVectorGL2D _shader_2d;
   Magnum::Shaders::DistanceFieldVectorGL3D _shader_3d;
   std::unique_ptr<Magnum::Text::DistanceFieldGlyphCache> _cache;
+
+  /// Cached 2D glyph runs keyed by text.
+  std::unordered_map<std::string, GlyphRun> _runs_2d;
+  /// Cached 3D glyph runs keyed by text.
+  std::unordered_map<std::string, GlyphRun> _runs_3d;
+  /// Incremented for each draw call to track glyph run usage.
+  unsigned _draw_stamp = 0;
+  /// View frustum for culling 3D text which has no @c BoundsCuller entry.
+  Magnum::Math::Frustum<Magnum::Float> _view_frustum;
+
+  std::vector<PendingText<Magnum::Matrix3>> _pending_2d;
+  std::vector<PendingText<Magnum::Matrix4>> _pending_3d;
+  std::vector<QuadRange> _ranges;
+
+  Magnum::GL::Buffer _vertex_buffer_2d;
+  Magnum::GL::Buffer _vertex_buffer_3d;
+  /// Quad index buffer shared by the 2D and 3D meshes.
+  Magnum::GL::Buffer _index_buffer;
+  Magnum::GL::Mesh _mesh_2d;
+  Magnum::GL::Mesh _mesh_3d;
+  /// Number of quads @c _index_buffer can index.
+  unsigned _index_quad_capacity = 0;
 };
 
 template <typename Iter, typename Resolver>
@@ -237,17 +356,15 @@ void Text::draw2D(const Iter &begin, const Iter &end, const Resolver &resolver,
     return;
   }
 
-  beginDraw2D();
-  _shader_2d.bindVectorTexture(_cache->texture());
   for (auto iter = begin; iter != end; ++iter)
   {
     const auto &&[text, visible] = resolver(iter);
     if (visible)
     {
-      draw2DText(text, params);
+      add2DText(text, params);
     }
   }
-  endDraw2D();
+  flush2D(params);
 }
 
 TES_ENUM_FLAGS(Text::TextFlag);
@@ -261,16 +378,15 @@ void Text::draw3D(const Iter &begin, const Iter &end, const Resolver &resolver,
     return;
   }
 
-  beginDraw3D();
-  _shader_3d.bindVectorTexture(_cache->texture());
+  prepare3D(params);
   for (auto iter = begin; iter != end; ++iter)
   {
     const auto &&[text, visible] = resolver(iter);
     if (visible)
     {
-      draw3DText(text, params);
+      add3DText(text, params);
     }
   }
-  endDraw3D();
+  flush3D(params);
 }
 }  // namespace tes::view::painter
@@ -241,6 +241,7 @@ IOCode load(const ryml::ConstNodeRef &node, Render &render, std::ostream &log)
   code = mergeCode(priv::read(node, render.edl_exponential_scale, log), code);
   code = mergeCode(priv::read(node, render.edl_linear_scale, log), code);
   code = mergeCode(priv::read(node, render.point_size, log), code);
+  code = mergeCode(priv::read(node, render.point_budget, log), code);
   code = mergeCode(priv::read(node, render.background_colour, log), code);
   return code;
 }
@@ -255,6 +256,7 @@ IOCode save(ryml::NodeRef node, const Render &render, std::ostream &log)
   code = mergeCode(priv::write(node, render.edl_exponential_scale, log), code);
   code = mergeCode(priv::write(node, render.edl_linear_scale, log), code);
   code = mergeCode(priv::write(node, render.point_size, log), code);
+  code = mergeCode(priv::write(node, render.point_budget, log), code);
   code = mergeCode(priv::write(node, render.background_colour, log), code);
   return code;
 }
@@ -20,6 +20,8 @@ struct Render
                              "Linear scaling for EDL shader." };
   Float point_size = { "Point size", 4.0f, 1.0f, 64.0f,
                        "Point render size for point clouds (pixels)." };
+  UInt point_budget = { "Point budget", 5000000u, 100000u, 100000000u,
+                        "Maximum points drawn for each instance of a large point cloud." };
   Colour background_colour = { "Background colour", tes::Colour::Grey, "Background colour." };
 
   [[nodiscard]] inline bool operator==(const Render &other) const
@@ -27,7 +29,7 @@ struct Render
     return use_edl_shader == other.use_edl_shader && edl_radius == other.edl_radius &&
            edl_exponential_scale == other.edl_exponential_scale &&
            edl_linear_scale == other.edl_linear_scale && point_size == other.point_size &&
-           background_colour == other.background_colour;
+           point_budget == other.point_budget && background_colour == other.background_colour;
   }
 
   [[nodiscard]] inline bool operator!=(const Render &other) const { return !operator==(other); }
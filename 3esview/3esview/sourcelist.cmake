@@ -8,9 +8,11 @@ list(APPEND PUBLIC_HEADERS
   FboEffect.h
   FramesPerSecondWindow.h
   FrameStamp.h
+  HeadlessScene.h
   Magnum.h
   MagnumColour.h
   MagnumV3.h
+  SceneProcessor.h
   ThirdEyeScene.h
   ViewableWindow.h
   Viewer.h
@@ -42,7 +44,9 @@ list(APPEND PUBLIC_HEADERS
   command/render/Resolution.h
   data/DataThread.h
   data/KeyframeStore.h
+  data/MessageDispatcher.h
   data/NetworkThread.h
+  data/Snapshot.h
   data/StreamRecorder.h
   data/StreamThread.h
   handler/Camera.h
@@ -93,6 +97,7 @@ list(APPEND PUBLIC_HEADERS
   util/CStrPtr.h
   util/PendingAction.h
   util/ResourceList.h
+  util/RoutingTable.h
 )
 
 list(APPEND SOURCES
@@ -101,6 +106,7 @@ list(APPEND SOURCES
   FboEffect.cpp
   FramesPerSecondWindow.cpp
   FrameStamp.cpp
+  HeadlessScene.cpp
   ThirdEyeScene.cpp
   Viewer.cpp
   ViewerLog.cpp
@@ -131,7 +137,9 @@ list(APPEND SOURCES
   command/render/Resolution.cpp
   data/DataThread.cpp
   data/KeyframeStore.cpp
+  data/MessageDispatcher.cpp
   data/NetworkThread.cpp
+  data/Snapshot.cpp
   data/StreamRecorder.cpp
   data/StreamThread.cpp
   handler/Camera.cpp
@@ -0,0 +1,70 @@
+//
+// Author: Kazys Stepanas
+//
+#pragma once
+
+#include <3esview/ViewConfig.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tes::view::util
+{
+/// A dense, directly indexed lookup table for message routing.
+///
+/// Routing and message IDs are small 16-bit integers, so we can index a flat array by ID rather
+/// than hashing into a map for every packet. The table grows to the largest registered ID, so the
+/// cost is proportional to the largest ID, not the full 16-bit range.
+///
+/// Unregistered entries hold a default constructed @c T - e.g., a null pointer - which is returned
+/// by @c operator[] for out of range IDs as well.
+///
+/// @tparam T The entry type. Must be default constructible, with the default value representing an
+/// empty entry.
+template <typename T>
+class RoutingTable
+{
+public:
+  /// The maximum number of entries: the range of 16-bit IDs.
+  static constexpr size_t kMaxSize = 0x10000u;
+
+  /// Register @p value for @p id , replacing any existing entry.
+  /// @param id The ID to register. Must be less than @c kMaxSize .
+  /// @param value The value to register.
+  /// @return True on success, false if @p id is out of range.
+  bool set(uint32_t id, T value)
+  {
+    if (id >= kMaxSize)
+    {
+      return false;
+    }
+
+    if (id >= _entries.size())
+    {
+      _entries.resize(id + 1u);
+    }
+    _entries[id] = std::move(value);
+    return true;
+  }
+
+  /// Look up the entry for @p id .
+  /// @param id The ID to look up.
+  /// @return The entry for @p id or a default value when not registered.
+  [[nodiscard]] const T &operator[](uint32_t id) const
+  {
+    return (id < _entries.size()) ? _entries[id] : _empty;
+  }
+
+  /// Query the table size. This is one more than the largest registered ID.
+  /// @return The table size.
+  [[nodiscard]] size_t size() const { return _entries.size(); }
+
+  /// Clear all entries.
+  void clear() { _entries.clear(); }
+
+private:
+  std::vector<T> _entries;
+  T _empty = {};
+};
+}  // namespace tes::view::util
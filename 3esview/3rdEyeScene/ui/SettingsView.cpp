@@ -136,6 +136,7 @@ SettingsView::ViewStatus SettingsView::show(unsigned idx, settings::Render &conf
     status += showProperty(idx++, config.edl_exponential_scale);
     status += showProperty(idx++, config.edl_linear_scale);
     status += showProperty(idx++, config.point_size);
+    status += showProperty(idx++, config.point_budget);
     status += showProperty(idx++, config.background_colour);
   }
 
@@ -3,6 +3,8 @@
 //
 #include "OccupancyLoader.h"
 
+#include "PlyStream.h"
+
 #ifdef _MSC_VER
 // std::equal with parameters that may be unsafe warning under Visual Studio.
 #pragma warning(disable : 4996)
@@ -31,6 +33,14 @@ struct TrajectoryPoint
   tes::Vector3d position;
 };
 
+/// Candidate names for the point time field, in order of preference.
+const std::vector<std::string> &timeFieldNames()
+{
+  static const std::vector<std::string> names = { "time", "timestamp", "scalar_GpsTime",
+                                                  "GpsTime" };
+  return names;
+}
+
 struct PlyReader
 {
   tinyply::PlyFile plyFile;
@@ -56,8 +66,7 @@ struct PlyReader
     yData = plyFile.request_properties_from_element("vertex", { "y" });
     zData = plyFile.request_properties_from_element("vertex", { "z" });
 
-    const std::vector<std::string> timeNames = { "time", "timestamp", "scalar_GpsTime", "GpsTime" };
-    for (const auto &name : timeNames)
+    for (const auto &name : timeFieldNames())
     {
       try
       {
@@ -139,11 +148,12 @@ struct PlyReader
 
 struct OccupancyLoaderDetail
 {
-  PlyReader sampleReader;
+  /// Samples are streamed as the sample cloud may be far larger than available memory.
+  PlyStream sampleStream;
+  /// The trajectory is small enough to load in full.
   PlyReader trajectoryReader;
   std::string sampleFilePath;
   std::string trajectoryFilePath;
-  std::ifstream sampleFile;
   std::ifstream trajectory_file;
   TrajectoryPoint trajectoryBuffer[2];
 
@@ -168,7 +178,7 @@ bool OccupancyLoader::open(const char *sampleFilePath, const char *trajectoryFil
   _imp->sampleFilePath = sampleFilePath;
   _imp->trajectoryFilePath = trajectoryFilePath;
 
-  _imp->sampleFile.open(_imp->sampleFilePath, std::ios::binary | std::ios::in);
+  _imp->sampleStream.open(sampleFilePath, timeFieldNames());
   _imp->trajectory_file.open(_imp->trajectoryFilePath, std::ios::binary | std::ios::in);
 
   if (!sampleFileIsOpen() || !trajectoryFileIsOpen())
@@ -177,13 +187,8 @@ bool OccupancyLoader::open(const char *sampleFilePath, const char *trajectoryFil
     return false;
   }
 
-  _imp->sampleReader.plyFile.parse_header(_imp->sampleFile);
   _imp->trajectoryReader.plyFile.parse_header(_imp->trajectory_file);
-
-  _imp->sampleReader.bindProperties();
   _imp->trajectoryReader.bindProperties();
-
-  _imp->sampleReader.plyFile.read(_imp->sampleFile);
   _imp->trajectoryReader.plyFile.read(_imp->trajectory_file);
 
   // Prime the trajectory buffer.
@@ -209,9 +214,8 @@ bool OccupancyLoader::open(const char *sampleFilePath, const char *trajectoryFil
 
 void OccupancyLoader::close()
 {
-  _imp->sampleReader.close();
+  _imp->sampleStream.close();
   _imp->trajectoryReader.close();
-  _imp->sampleFile.close();
   _imp->trajectory_file.close();
   _imp->sampleFilePath.clear();
   _imp->trajectoryFilePath.clear();
@@ -220,7 +224,7 @@ void OccupancyLoader::close()
 
 bool OccupancyLoader::sampleFileIsOpen() const
 {
-  return _imp->sampleFile.is_open();
+  return _imp->sampleStream.isOpen();
 }
 
 
@@ -248,7 +252,7 @@ bool OccupancyLoader::nextPoint(tes::Vector3f &sample, tes::Vector3f &origin, do
 bool OccupancyLoader::nextPoint(tes::Vector3d &sample, tes::Vector3d &origin, double *timestampOut)
 {
   double timestamp = 0;
-  if (_imp->sampleReader.nextPoint(timestamp, sample))
+  if (_imp->sampleStream.nextPoint(timestamp, sample))
   {
     if (timestampOut)
     {
@@ -10,6 +10,9 @@
 #include <3escore/ServerApi.h>
 #include <3escore/TransferProgress.h>
 
+#include <algorithm>
+#include <utility>
+
 using namespace tes;
 
 struct OccupancyMeshDetail
@@ -48,6 +51,33 @@ uint32_t nodeColour(const octomap::OcTree::NodeType *node, const octomap::OcTree
   const int c = int(255 * intensity);
   return tes::Colour(c, c, c).colour32();
 }
+
+
+/// Sort and deduplicate @p indices , then split them into runs of contiguous indices.
+/// @param indices The indices to process. Sorted and deduplicated on return.
+/// @param max_run The maximum number of indices in each run.
+/// @return The runs as `[begin, end)` index ranges, in ascending order.
+std::vector<std::pair<uint32_t, uint32_t>> indexRuns(std::vector<uint32_t> &indices,
+                                                     uint32_t max_run)
+{
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+  std::vector<std::pair<uint32_t, uint32_t>> runs;
+  for (const auto index : indices)
+  {
+    if (!runs.empty() && runs.back().second == index &&
+        runs.back().second - runs.back().first < max_run)
+    {
+      ++runs.back().second;
+    }
+    else
+    {
+      runs.emplace_back(index, index + 1);
+    }
+  }
+  return runs;
+}
 }  // namespace
 
 OccupancyMesh::OccupancyMesh(unsigned mesh_id, octomap::OcTree &map)
@@ -201,9 +231,10 @@ void OccupancyMesh::update(const UnorderedKeySet &newly_occupied, const Unordere
     return;
   }
 
-  // Start by removing freed nodes.
-  size_t initial_unused_vertex_count = _detail->unused_vertex_list.size();
+  // Apply all the changes before sending so that updates to adjacent vertices can be sent as runs
+  // rather than one packet per vertex. Start by removing freed nodes.
   std::vector<uint32_t> modified_vertices;
+  std::vector<uint32_t> modified_colours;
   for (const auto &key : newly_free)
   {
     // Resolve the index for this voxel.
@@ -213,36 +244,63 @@ void OccupancyMesh::update(const UnorderedKeySet &newly_occupied, const Unordere
       // Invalidate the voxel.
       _detail->colours[voxelLookup->second] = 0u;
       _detail->unused_vertex_list.push_back(voxelLookup->second);
-      modified_vertices.push_back(voxelLookup->second);
+      modified_colours.push_back(voxelLookup->second);
       _detail->voxel_index_map.erase(voxelLookup);
     }
   }
 
   // Now added occupied nodes, initially from the free list.
-  size_t processed_occupied_count = 0;
   auto occupied_iter = newly_occupied.begin();
   while (!_detail->unused_vertex_list.empty() && occupied_iter != newly_occupied.end())
   {
     const uint32_t vertex_index = _detail->unused_vertex_list.back();
     const octomap::OcTreeKey key = *occupied_iter;
     const octomap::OcTree::NodeType *node = _map.search(key);
-    const bool mark_as_modified = _detail->unused_vertex_list.size() <= initial_unused_vertex_count;
     _detail->unused_vertex_list.pop_back();
     ++occupied_iter;
-    ++processed_occupied_count;
     _detail->vertices[vertex_index] = p2p(_map.keyToCoord(key));
     // validateVertex(_detail->vertices[vertex_index]);
     _detail->colours[vertex_index] = nodeColour(node, _map);
     _detail->voxel_index_map.insert(std::make_pair(key, vertex_index));
-    // Only mark as modified if this vertex wasn't just invalidate by removal.
-    // It will already be on the list otherwise.
-    if (mark_as_modified)
+    modified_vertices.push_back(vertex_index);
+    modified_colours.push_back(vertex_index);
+  }
+
+  // Add remaining vertices.
+  const auto old_vertex_count = uint32_t(_detail->vertices.size());
+  for (; occupied_iter != newly_occupied.end(); ++occupied_iter)
+  {
+    const uint32_t vertex_index = uint32_t(_detail->vertices.size());
+    const octomap::OcTreeKey key = *occupied_iter;
+    _detail->voxel_index_map.insert(std::make_pair(key, vertex_index));
+    //_detail->indices.push_back(uint32_t(_detail->vertices.size()));
+    _detail->vertices.push_back(p2p(_map.keyToCoord(key)));
+    // validateVertex(_detail->vertices.back());
+    // Normals represent voxel half extents.
+    _detail->normals.push_back(Vector3f(float(0.5f * _map.getResolution())));
+    _detail->colours.push_back(0xffffffffu);
+  }
+  const auto new_vertex_count = uint32_t(_detail->vertices.size());
+
+  // Update colours for touched occupied
+  for (auto key : touched_occupied)
+  {
+    const octomap::OcTree::NodeType *node = _map.search(key);
+    auto index_search = _detail->voxel_index_map.find(key);
+    if (node && index_search != _detail->voxel_index_map.end())
     {
-      modified_vertices.push_back(vertex_index);
+      _detail->colours[index_search->second] = nodeColour(node, _map);
+      modified_colours.push_back(index_search->second);
     }
   }
 
-  // Send messages for individually changed voxels.
+  // New vertices are sent in full.
+  for (uint32_t vertex_index = old_vertex_count; vertex_index < new_vertex_count; ++vertex_index)
+  {
+    modified_vertices.push_back(vertex_index);
+    modified_colours.push_back(vertex_index);
+  }
+
   // Start a mesh redefinition message.
   std::vector<uint8_t> buffer(tes::kMaxPacketSize);
   tes::PacketWriter packet(buffer.data(), (uint16_t)buffer.size());
@@ -251,19 +309,8 @@ void OccupancyMesh::update(const UnorderedKeySet &newly_occupied, const Unordere
   tes::MeshFinaliseMessage final_msg = {};
   tes::ObjectAttributesd attributes = {};
 
-  // Work out how many vertices we'll have after all modifications are done.
-  size_t old_vertex_count = _detail->vertices.size();
-  size_t new_vertex_count = _detail->vertices.size();
-  if (newly_occupied.size() - processed_occupied_count > _detail->unused_vertex_list.size())
-  {
-    // We have more occupied vertices than available in the free list.
-    // This means we will add new vertices.
-    new_vertex_count +=
-      newly_occupied.size() - processed_occupied_count - _detail->unused_vertex_list.size();
-  }
-
   msg.mesh_id = _id;
-  msg.vertex_count = (uint32_t)new_vertex_count;
+  msg.vertex_count = new_vertex_count;
   msg.index_count = 0;
   msg.draw_type = drawType(0);
   attributes.identity();
@@ -274,109 +321,45 @@ void OccupancyMesh::update(const UnorderedKeySet &newly_occupied, const Unordere
   packet.finalise();
   g_tes_server->send(packet);
 
-  // Next update changed triangles.
   cmp_msg.mesh_id = id();
 
+  // Send each run of contiguous changes in one message, limiting the run length to fit a packet.
+  const uint32_t transfer_limit = 5001;
   const float quantisation_unit = 0.001f;
-  // Update modified vertices, one at a time.
-  for (uint32_t vertex_index : modified_vertices)
+  for (const auto &[begin, end] : indexRuns(modified_vertices, transfer_limit))
   {
     packet.reset(tes::MtMesh, tes::MmtVertex);
     cmp_msg.write(packet);
-    DataBuffer data_buffer(_detail->vertices.data() + vertex_index, 1u);
-    data_buffer.writePacked(packet, 0, quantisation_unit);
+    DataBuffer(&_detail->vertices[begin], end - begin)
+      .writePacked(packet, 0, quantisation_unit, 0, begin);
     if (packet.finalise())
     {
       g_tes_server->send(packet);
     }
+  }
 
-    // Send colour and position update.
-    packet.reset(tes::MtMesh, tes::MmtVertexColour);
+  // Only new vertices require normals.
+  for (uint32_t offset = old_vertex_count; offset < new_vertex_count; offset += transfer_limit)
+  {
+    const uint32_t count = std::min(transfer_limit, new_vertex_count - offset);
+    packet.reset(tes::MtMesh, tes::MmtNormal);
     cmp_msg.write(packet);
-    data_buffer = DataBuffer(_detail->colours.data() + vertex_index, 1u);
-    data_buffer.write(packet, 0);
+    DataBuffer(&_detail->normals[offset], count)
+      .writePacked(packet, 0, quantisation_unit, 0, offset);
     if (packet.finalise())
     {
       g_tes_server->send(packet);
     }
   }
 
-  // Add remaining vertices and send a bulk modification message.
-  for (; occupied_iter != newly_occupied.end(); ++occupied_iter, ++processed_occupied_count)
-  {
-    const uint32_t vertex_index = uint32_t(_detail->vertices.size());
-    const octomap::OcTreeKey key = *occupied_iter;
-    _detail->voxel_index_map.insert(std::make_pair(key, vertex_index));
-    //_detail->indices.push_back(uint32_t(_detail->vertices.size()));
-    _detail->vertices.push_back(p2p(_map.keyToCoord(key)));
-    // validateVertex(_detail->vertices.back());
-    // Normals represent voxel half extents.
-    _detail->normals.push_back(Vector3f(float(0.5f * _map.getResolution())));
-    _detail->colours.push_back(0xffffffffu);
-  }
-
-  // Send bulk messages for new vertices.
-  if (old_vertex_count != new_vertex_count)
-  {
-    const uint16_t transferLimit = 5001;
-    // Send colour and position update.
-    uint32_t offset = uint32_t(old_vertex_count);
-
-    while (offset < new_vertex_count)
-    {
-      auto count = uint16_t(std::min<size_t>(transferLimit, new_vertex_count - offset));
-
-      packet.reset(tes::MtMesh, tes::MmtVertex);
-      cmp_msg.write(packet);
-      DataBuffer(&_detail->vertices[offset], count)
-        .writePacked(packet, 0, quantisation_unit, 0, offset);
-      if (packet.finalise())
-      {
-        g_tes_server->send(packet);
-      }
-
-      packet.reset(tes::MtMesh, tes::MmtNormal);
-      cmp_msg.write(packet);
-      DataBuffer(&_detail->normals[offset], count)
-        .writePacked(packet, 0, quantisation_unit, 0, offset);
-      if (packet.finalise())
-      {
-        g_tes_server->send(packet);
-      }
-
-      packet.reset(tes::MtMesh, tes::MmtVertexColour);
-      cmp_msg.write(packet);
-      DataBuffer(&_detail->colours[offset], count).write(packet, 0, 0, offset);
-      if (packet.finalise())
-      {
-        g_tes_server->send(packet);
-      }
-
-      // Calculate next batch.
-      offset += count;
-    }
-  }
-
-  // Update colours for touched occupied
-  if (!touched_occupied.empty())
+  for (const auto &[begin, end] : indexRuns(modified_colours, transfer_limit))
   {
-    for (auto key : touched_occupied)
+    packet.reset(tes::MtMesh, tes::MmtVertexColour);
+    cmp_msg.write(packet);
+    DataBuffer(&_detail->colours[begin], end - begin).write(packet, 0, 0, begin);
+    if (packet.finalise())
     {
-      const octomap::OcTree::NodeType *node = _map.search(key);
-      auto index_search = _detail->voxel_index_map.find(key);
-      if (node && index_search != _detail->voxel_index_map.end())
-      {
-        const unsigned voxel_index = index_search->second;
-        _detail->colours[voxel_index] = nodeColour(node, _map);
-
-        packet.reset(tes::MtMesh, tes::MmtVertexColour);
-        cmp_msg.write(packet);
-        DataBuffer(&_detail->colours[voxel_index], 1).write(packet, 0, 0, voxel_index);
-        if (packet.finalise())
-        {
-          g_tes_server->send(packet);
-        }
-      }
+      g_tes_server->send(packet);
     }
   }
 
@@ -0,0 +1,737 @@
+//
+// author Kazys Stepanas
+//
+#include "PlyStream.h"
+
+#include <3escore/Endian.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif  // WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else  // _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+namespace
+{
+enum class PlyFormat
+{
+  Ascii,
+  BinaryLittleEndian,
+  BinaryBigEndian
+};
+
+enum class PlyType
+{
+  Int8,
+  UInt8,
+  Int16,
+  UInt16,
+  Int32,
+  UInt32,
+  Float32,
+  Float64,
+  Invalid
+};
+
+/// Field indices into @c PlyLayout::fields
+enum Field : unsigned
+{
+  FieldX,
+  FieldY,
+  FieldZ,
+  FieldTime,
+  FieldCount
+};
+
+struct PlyField
+{
+  /// Property index in the vertex element.
+  unsigned property_index = ~0u;
+  /// Byte offset into a binary vertex record.
+  size_t offset = 0;
+  PlyType type = PlyType::Invalid;
+
+  bool valid() const { return property_index != ~0u; }
+};
+
+/// Describes the vertex element layout.
+struct PlyLayout
+{
+  PlyFormat format = PlyFormat::Ascii;
+  uint64_t vertex_count = 0;
+  /// Binary record size.
+  size_t stride = 0;
+  /// Number of vertex properties.
+  unsigned property_count = 0;
+  std::array<PlyField, FieldCount> fields;
+};
+
+PlyType parseType(const std::string &name)
+{
+  if (name == "char" || name == "int8")
+  {
+    return PlyType::Int8;
+  }
+  if (name == "uchar" || name == "uint8")
+  {
+    return PlyType::UInt8;
+  }
+  if (name == "short" || name == "int16")
+  {
+    return PlyType::Int16;
+  }
+  if (name == "ushort" || name == "uint16")
+  {
+    return PlyType::UInt16;
+  }
+  if (name == "int" || name == "int32")
+  {
+    return PlyType::Int32;
+  }
+  if (name == "uint" || name == "uint32")
+  {
+    return PlyType::UInt32;
+  }
+  if (name == "float" || name == "float32")
+  {
+    return PlyType::Float32;
+  }
+  if (name == "double" || name == "float64")
+  {
+    return PlyType::Float64;
+  }
+  return PlyType::Invalid;
+}
+
+size_t typeSize(PlyType type)
+{
+  switch (type)
+  {
+  case PlyType::Int8:
+  case PlyType::UInt8:
+    return 1;
+  case PlyType::Int16:
+  case PlyType::UInt16:
+    return 2;
+  case PlyType::Int32:
+  case PlyType::UInt32:
+  case PlyType::Float32:
+    return 4;
+  case PlyType::Float64:
+    return 8;
+  default:
+    break;
+  }
+  return 0;
+}
+
+template <typename T>
+double readBinary(const uint8_t *data, bool swap)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  if (swap)
+  {
+    tes::endianSwap(reinterpret_cast<uint8_t *>(&value), sizeof(value));
+  }
+  return static_cast<double>(value);
+}
+
+double readBinary(const uint8_t *data, PlyType type, bool swap)
+{
+  switch (type)
+  {
+  case PlyType::Int8:
+    return readBinary<int8_t>(data, swap);
+  case PlyType::UInt8:
+    return readBinary<uint8_t>(data, swap);
+  case PlyType::Int16:
+    return readBinary<int16_t>(data, swap);
+  case PlyType::UInt16:
+    return readBinary<uint16_t>(data, swap);
+  case PlyType::Int32:
+    return readBinary<int32_t>(data, swap);
+  case PlyType::UInt32:
+    return readBinary<uint32_t>(data, swap);
+  case PlyType::Float32:
+    return readBinary<float>(data, swap);
+  case PlyType::Float64:
+    return readBinary<double>(data, swap);
+  default:
+    break;
+  }
+  return 0;
+}
+
+/// A decoded chunk of points.
+struct PointChunk
+{
+  std::vector<double> timestamps;
+  std::vector<tes::Vector3d> positions;
+};
+
+/// Decode binary vertex records in the range `[begin, end)`.
+PointChunk decodeBinary(const uint8_t *begin, const uint8_t *end, const PlyLayout &layout)
+{
+  PointChunk chunk;
+  const size_t count = size_t(end - begin) / layout.stride;
+  chunk.timestamps.resize(count);
+  chunk.positions.resize(count);
+
+#if TES_IS_BIG_ENDIAN
+  const bool swap = layout.format == PlyFormat::BinaryLittleEndian;
+#else   // TES_IS_BIG_ENDIAN
+  const bool swap = layout.format == PlyFormat::BinaryBigEndian;
+#endif  // TES_IS_BIG_ENDIAN
+
+  const auto &fields = layout.fields;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const uint8_t *record = begin + i * layout.stride;
+    chunk.positions[i].x() = readBinary(record + fields[FieldX].offset, fields[FieldX].type, swap);
+    chunk.positions[i].y() = readBinary(record + fields[FieldY].offset, fields[FieldY].type, swap);
+    chunk.positions[i].z() = readBinary(record + fields[FieldZ].offset, fields[FieldZ].type, swap);
+    chunk.timestamps[i] =
+      readBinary(record + fields[FieldTime].offset, fields[FieldTime].type, swap);
+  }
+
+  return chunk;
+}
+
+/// Does the line `[begin, end)` contain only whitespace?
+bool blankLine(const char *begin, const char *end)
+{
+  return std::all_of(begin, end, [](char c) { return c == ' ' || c == '\t' || c == '\r'; });
+}
+
+/// Decode ASCII vertex lines in the range `[begin, end)`. The range must start at the beginning of
+/// a line. Blank lines are skipped.
+PointChunk decodeAscii(const char *begin, const char *end, const PlyLayout &layout)
+{
+  PointChunk chunk;
+  std::array<double, FieldCount> values = {};
+  // Map property index to field index.
+  std::vector<int> property_fields(layout.property_count, -1);
+  for (unsigned f = 0; f < FieldCount; ++f)
+  {
+    property_fields[layout.fields[f].property_index] = int(f);
+  }
+
+  // strtod() requires a terminated string, so we copy each line into a local buffer.
+  std::string line;
+  const char *cursor = begin;
+  while (cursor < end)
+  {
+    const char *line_end = std::find(cursor, end, '\n');
+    line.assign(cursor, line_end);
+    cursor = line_end + 1;
+    if (blankLine(line.data(), line.data() + line.size()))
+    {
+      continue;
+    }
+
+    const char *token = line.c_str();
+    char *token_end = nullptr;
+    unsigned property = 0;
+    for (; property < layout.property_count; ++property)
+    {
+      const double value = std::strtod(token, &token_end);
+      if (token_end == token)
+      {
+        break;
+      }
+      if (property_fields[property] >= 0)
+      {
+        values[unsigned(property_fields[property])] = value;
+      }
+      token = token_end;
+    }
+
+    if (property == layout.property_count)
+    {
+      chunk.timestamps.emplace_back(values[FieldTime]);
+      chunk.positions.emplace_back(values[FieldX], values[FieldY], values[FieldZ]);
+    }
+  }
+
+  return chunk;
+}
+
+/// Parse the PLY header from @p data. Returns the byte offset to the vertex data, or zero on
+/// failure.
+size_t parseHeader(const char *data, size_t size, const std::vector<std::string> &time_fields,
+                   PlyLayout &layout)
+{
+  const char *header_end_marker = "end_header";
+  const char *header_end =
+    std::search(data, data + size, header_end_marker, header_end_marker + strlen(header_end_marker));
+  if (header_end == data + size)
+  {
+    return 0;
+  }
+  const char *data_start = std::find(header_end, data + size, '\n');
+  if (data_start == data + size)
+  {
+    return 0;
+  }
+  ++data_start;
+
+  std::istringstream header(std::string(data, header_end));
+  std::string line;
+  std::string token;
+  bool in_vertex = false;
+  bool seen_element = false;
+  unsigned time_priority = ~0u;
+
+  std::getline(header, line);
+  if (line.compare(0, 3, "ply") != 0)
+  {
+    return 0;
+  }
+
+  while (std::getline(header, line))
+  {
+    std::istringstream words(line);
+    words >> token;
+    if (token == "format")
+    {
+      words >> token;
+      if (token == "ascii")
+      {
+        layout.format = PlyFormat::Ascii;
+      }
+      else if (token == "binary_little_endian")
+      {
+        layout.format = PlyFormat::BinaryLittleEndian;
+      }
+      else if (token == "binary_big_endian")
+      {
+        layout.format = PlyFormat::BinaryBigEndian;
+      }
+      else
+      {
+        return 0;
+      }
+    }
+    else if (token == "element")
+    {
+      std::string name;
+      words >> name;
+      if (!seen_element && name != "vertex")
+      {
+        // We only support the vertex element being first.
+        return 0;
+      }
+      in_vertex = !seen_element;
+      seen_element = true;
+      if (in_vertex)
+      {
+        words >> layout.vertex_count;
+      }
+    }
+    else if (token == "property" && in_vertex)
+    {
+      std::string type_name;
+      std::string name;
+      words >> type_name >> name;
+      if (type_name == "list")
+      {
+        // Lists are not supported in the vertex element.
+        return 0;
+      }
+
+      const PlyType type = parseType(type_name);
+      if (type == PlyType::Invalid)
+      {
+        return 0;
+      }
+
+      PlyField field;
+      field.property_index = layout.property_count++;
+      field.offset = layout.stride;
+      field.type = type;
+      layout.stride += typeSize(type);
+
+      if (name == "x")
+      {
+        layout.fields[FieldX] = field;
+      }
+      else if (name == "y")
+      {
+        layout.fields[FieldY] = field;
+      }
+      else if (name == "z")
+      {
+        layout.fields[FieldZ] = field;
+      }
+      else
+      {
+        const auto search = std::find(time_fields.begin(), time_fields.end(), name);
+        const auto priority = unsigned(search - time_fields.begin());
+        if (search != time_fields.end() && priority < time_priority)
+        {
+          layout.fields[FieldTime] = field;
+          time_priority = priority;
+        }
+      }
+    }
+  }
+
+  for (const auto &field : layout.fields)
+  {
+    if (!field.valid())
+    {
+      return 0;
+    }
+  }
+
+  return size_t(data_start - data);
+}
+}  // namespace
+
+
+struct PlyStreamDetail
+{
+  /// Memory mapped file.
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE mapping = nullptr;
+#else   // _WIN32
+  int file = -1;
+#endif  // _WIN32
+
+  PlyLayout layout;
+  /// Offset to the vertex data.
+  size_t data_offset = 0;
+  /// End of the vertex data. For ASCII files this is the end of the mapped file until the last
+  /// vertex line has been scheduled.
+  size_t data_end = 0;
+  /// Number of vertices covered by the scheduled chunks.
+  uint64_t vertices_scheduled = 0;
+  /// Offset at which the next chunk to be scheduled starts.
+  size_t next_chunk_offset = 0;
+  size_t chunk_points = PlyStream::kDefaultChunkPoints;
+  unsigned max_in_flight = 1;
+
+  /// A scheduled chunk decode.
+  struct PendingChunk
+  {
+    size_t begin = 0;
+    size_t end = 0;
+    std::future<PointChunk> points;
+  };
+
+  /// Chunks in flight, in file order.
+  std::deque<PendingChunk> pending;
+  /// The chunk currently being read.
+  PointChunk current;
+  size_t current_begin = 0;
+  size_t current_end = 0;
+  size_t current_index = 0;
+  uint64_t points_read = 0;
+
+  bool map(const char *file_path);
+  void unmap();
+  /// Schedule chunk decoding up to the in flight limit.
+  void schedule();
+  /// Release the mapped pages for a consumed byte range.
+  void release(size_t begin, size_t end);
+};
+
+
+bool PlyStreamDetail::map(const char *file_path)
+{
+#ifdef _WIN32
+  file = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                     FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+  {
+    unmap();
+    return false;
+  }
+  size = size_t(file_size.QuadPart);
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+  {
+    unmap();
+    return false;
+  }
+  data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!data)
+  {
+    unmap();
+    return false;
+  }
+#else   // _WIN32
+  file = ::open(file_path, O_RDONLY);
+  if (file < 0)
+  {
+    return false;
+  }
+  struct stat file_stat = {};
+  if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+  {
+    unmap();
+    return false;
+  }
+  size = size_t(file_stat.st_size);
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  if (mapped == MAP_FAILED)
+  {
+    unmap();
+    return false;
+  }
+  data = static_cast<const uint8_t *>(mapped);
+  madvise(mapped, size, MADV_SEQUENTIAL);
+#endif  // _WIN32
+  return true;
+}
+
+
+void PlyStreamDetail::unmap()
+{
+#ifdef _WIN32
+  if (data)
+  {
+    UnmapViewOfFile(data);
+  }
+  if (mapping)
+  {
+    CloseHandle(mapping);
+  }
+  if (file != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(file);
+  }
+  mapping = nullptr;
+  file = INVALID_HANDLE_VALUE;
+#else   // _WIN32
+  if (data)
+  {
+    munmap(const_cast<uint8_t *>(data), size);
+  }
+  if (file >= 0)
+  {
+    ::close(file);
+  }
+  file = -1;
+#endif  // _WIN32
+  data = nullptr;
+  size = 0;
+}
+
+
+void PlyStreamDetail::schedule()
+{
+  while (pending.size() < max_in_flight && next_chunk_offset < data_end)
+  {
+    PendingChunk chunk;
+    chunk.begin = next_chunk_offset;
+    if (layout.format == PlyFormat::Ascii)
+    {
+      // Count vertex lines to find the chunk end so the vertex data stops after the last vertex,
+      // before any following element. Blank lines do not count.
+      const char *text = reinterpret_cast<const char *>(data);
+      const uint64_t chunk_vertices =
+        std::min<uint64_t>(chunk_points, layout.vertex_count - vertices_scheduled);
+      uint64_t line_count = 0;
+      const char *cursor = text + chunk.begin;
+      const char *text_end = text + data_end;
+      while (line_count < chunk_vertices && cursor < text_end)
+      {
+        const auto *line_end =
+          static_cast<const char *>(std::memchr(cursor, '\n', size_t(text_end - cursor)));
+        line_end = (line_end) ? line_end : text_end;
+        if (!blankLine(cursor, line_end))
+        {
+          ++line_count;
+        }
+        cursor = std::min(line_end + 1, text_end);
+      }
+      chunk.end = size_t(cursor - text);
+      vertices_scheduled += line_count;
+      if (vertices_scheduled >= layout.vertex_count)
+      {
+        data_end = chunk.end;
+      }
+      chunk.points = std::async(std::launch::async, decodeAscii, text + chunk.begin,
+                                text + chunk.end, std::cref(layout));
+    }
+    else
+    {
+      chunk.end = std::min(chunk.begin + chunk_points * layout.stride, data_end);
+      chunk.points = std::async(std::launch::async, decodeBinary, data + chunk.begin,
+                                data + chunk.end, std::cref(layout));
+    }
+    next_chunk_offset = chunk.end;
+    pending.emplace_back(std::move(chunk));
+  }
+}
+
+
+void PlyStreamDetail::release(size_t begin, size_t end)
+{
+#ifndef _WIN32
+  // Release whole pages only; partial pages are still shared with the adjacent chunks.
+  const auto page_size = size_t(sysconf(_SC_PAGESIZE));
+  begin = (begin + page_size - 1) / page_size * page_size;
+  end = end / page_size * page_size;
+  if (begin < end)
+  {
+    madvise(const_cast<uint8_t *>(data + begin), end - begin, MADV_DONTNEED);
+  }
+#else   // _WIN32
+  (void)begin;
+  (void)end;
+#endif  // _WIN32
+}
+
+
+PlyStream::PlyStream()
+  : _imp(std::make_unique<PlyStreamDetail>())
+{}
+
+
+PlyStream::~PlyStream()
+{
+  close();
+}
+
+
+bool PlyStream::open(const char *file_path, const std::vector<std::string> &time_fields,
+                     unsigned thread_count, size_t chunk_points)
+{
+  close();
+
+  if (!_imp->map(file_path))
+  {
+    return false;
+  }
+
+  _imp->layout = PlyLayout();
+  _imp->data_offset = parseHeader(reinterpret_cast<const char *>(_imp->data), _imp->size,
+                                  time_fields, _imp->layout);
+  if (_imp->data_offset == 0)
+  {
+    close();
+    return false;
+  }
+
+  if (_imp->layout.format == PlyFormat::Ascii)
+  {
+    _imp->data_end = _imp->size;
+  }
+  else
+  {
+    _imp->data_end = std::min<size_t>(
+      _imp->size, _imp->data_offset + size_t(_imp->layout.vertex_count) * _imp->layout.stride);
+  }
+
+  if (thread_count == 0)
+  {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  _imp->chunk_points = std::max<size_t>(1, chunk_points);
+  // Allow one chunk to be read while the others decode.
+  _imp->max_in_flight = thread_count + 1;
+  _imp->next_chunk_offset = _imp->data_offset;
+  _imp->schedule();
+  return true;
+}
+
+
+void PlyStream::close()
+{
+  for (auto &chunk : _imp->pending)
+  {
+    if (chunk.points.valid())
+    {
+      chunk.points.wait();
+    }
+  }
+  _imp->pending.clear();
+  _imp->current = PointChunk();
+  _imp->current_begin = _imp->current_end = 0;
+  _imp->current_index = 0;
+  _imp->points_read = 0;
+  _imp->vertices_scheduled = 0;
+  _imp->layout = PlyLayout();
+  _imp->data_offset = _imp->data_end = _imp->next_chunk_offset = 0;
+  _imp->unmap();
+}
+
+
+bool PlyStream::isOpen() const
+{
+  return _imp->data != nullptr;
+}
+
+
+uint64_t PlyStream::pointCount() const
+{
+  return _imp->layout.vertex_count;
+}
+
+
+uint64_t PlyStream::pointsRead() const
+{
+  return _imp->points_read;
+}
+
+
+bool PlyStream::nextPoint(double &timestamp, tes::Vector3d &pt)
+{
+  if (!isOpen() || _imp->points_read >= _imp->layout.vertex_count)
+  {
+    return false;
+  }
+
+  while (_imp->current_index >= _imp->current.positions.size())
+  {
+    // Current chunk exhausted. Release it and move on to the next chunk.
+    _imp->release(_imp->current_begin, _imp->current_end);
+    _imp->current = PointChunk();
+    _imp->current_index = 0;
+
+    if (_imp->pending.empty())
+    {
+      return false;
+    }
+
+    auto next = std::move(_imp->pending.front());
+    _imp->pending.pop_front();
+    _imp->current = next.points.get();
+    _imp->current_begin = next.begin;
+    _imp->current_end = next.end;
+    _imp->schedule();
+  }
+
+  timestamp = _imp->current.timestamps[_imp->current_index];
+  pt = _imp->current.positions[_imp->current_index];
+  ++_imp->current_index;
+  ++_imp->points_read;
+  return true;
+}
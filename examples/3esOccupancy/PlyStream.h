@@ -0,0 +1,72 @@
+//
+// author Kazys Stepanas
+//
+#ifndef PLYSTREAM_H
+#define PLYSTREAM_H
+
+#include <3escore/Vector3.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct PlyStreamDetail;
+
+/// A streaming PLY point reader which memory maps the source file and decodes points in parallel
+/// chunks.
+///
+/// The stream only reads the @c vertex element, which must be the first element in the file, and
+/// only extracts the x, y, z and time fields. Binary (either endian) and ASCII PLY files are
+/// supported. Elements after the vertex element, such as faces, are ignored. Blank lines in the
+/// ASCII vertex data are skipped.
+///
+/// Chunks are decoded ahead of the reader by background tasks, with the number of chunks in flight
+/// bounded to keep memory usage constant regardless of the file size. Mapped pages are released
+/// once a chunk has been consumed so a large file may be streamed with bounded resident memory.
+class PlyStream
+{
+public:
+  /// Default number of points decoded per chunk.
+  static constexpr size_t kDefaultChunkPoints = 64 * 1024;
+
+  PlyStream();
+  ~PlyStream();
+
+  /// Open a PLY file for streaming.
+  /// @param file_path The file to open.
+  /// @param time_fields Candidate names for the time field in order of preference. The first
+  /// matching vertex property is used.
+  /// @param thread_count Number of chunks to decode concurrently. Zero selects the hardware
+  /// concurrency.
+  /// @param chunk_points Number of points per decoding chunk.
+  /// @return True on success.
+  bool open(const char *file_path, const std::vector<std::string> &time_fields,
+            unsigned thread_count = 0, size_t chunk_points = kDefaultChunkPoints);
+
+  /// Close the file, waiting on any outstanding decoding tasks.
+  void close();
+
+  /// Is the stream open?
+  /// @return True when open.
+  bool isOpen() const;
+
+  /// Query the number of points in the file as reported by the PLY header.
+  /// @return The point count.
+  uint64_t pointCount() const;
+
+  /// Query the number of points read so far.
+  /// @return The number of points returned by @c nextPoint().
+  uint64_t pointsRead() const;
+
+  /// Read the next point. This blocks if the next chunk is still being decoded.
+  /// @param[out] timestamp The point timestamp.
+  /// @param[out] pt The point position.
+  /// @return True if a point was read, false at the end of the stream.
+  bool nextPoint(double &timestamp, tes::Vector3d &pt);
+
+private:
+  std::unique_ptr<PlyStreamDetail> _imp;
+};
+
+#endif  // PLYSTREAM_H
@@ -0,0 +1,117 @@
+//
+// author: Kazys Stepanas
+//
+#include <3escore/CollatedPacket.h>
+#include <3escore/CollatedPacketDecoder.h>
+#include <3escore/PacketWriter.h>
+#include <3escore/shapes/Sphere.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+namespace tes
+{
+namespace
+{
+/// Encode @p count sphere create messages, as a stand in for typical frame content.
+std::vector<std::vector<uint8_t>> makePackets(size_t count)
+{
+  std::mt19937 rand_engine(42u);
+  std::uniform_real_distribution<float> rand(-10.0f, 10.0f);
+  std::vector<uint8_t> buffer(0xffffu);
+  std::vector<std::vector<uint8_t>> packets(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    const Sphere sphere(Id(static_cast<uint32_t>(i + 1)),
+                        Spherical(Vector3f(rand(rand_engine), rand(rand_engine), rand(rand_engine)),
+                                  rand(rand_engine)));
+    PacketWriter writer(buffer.data(), buffer.size());
+    sphere.writeCreate(writer);
+    writer.finalise();
+    packets[i].assign(buffer.data(), buffer.data() + writer.packetSize());
+  }
+  return packets;
+}
+
+
+/// Collate packets until the collation buffer is full, then finalise.
+/// Range 0 is the @c CompressionLevel , or -1 for no compression.
+void benchCollate(benchmark::State &state)
+{
+  const auto packets = makePackets(1000u);
+  const bool compress = state.range(0) >= 0;
+  CollatedPacket collated(compress);
+  if (compress)
+  {
+    collated.setCompressionLevel(static_cast<CompressionLevel>(state.range(0)));
+  }
+
+  size_t bytes = 0;
+  size_t collated_bytes = 0;
+  for (auto _ : state)
+  {
+    collated.reset();
+    for (const auto &packet : packets)
+    {
+      if (collated.add(packet.data(), static_cast<uint16_t>(packet.size())) < 0)
+      {
+        break;
+      }
+    }
+    bytes += collated.collatedBytes();
+    collated.finalise();
+    unsigned byte_count = 0;
+    benchmark::DoNotOptimize(collated.buffer(byte_count));
+    collated_bytes += byte_count;
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  state.counters["ratio"] =
+    (bytes) ? static_cast<double>(collated_bytes) / static_cast<double>(bytes) : 1.0;
+}
+
+
+/// Decode a finalised collated packet. Range 0 as for @c benchCollate() .
+void benchDecodeCollated(benchmark::State &state)
+{
+  const auto packets = makePackets(1000u);
+  const bool compress = state.range(0) >= 0;
+  CollatedPacket collated(compress);
+  if (compress)
+  {
+    collated.setCompressionLevel(static_cast<CompressionLevel>(state.range(0)));
+  }
+  for (const auto &packet : packets)
+  {
+    if (collated.add(packet.data(), static_cast<uint16_t>(packet.size())) < 0)
+    {
+      break;
+    }
+  }
+  collated.finalise();
+  unsigned byte_count = 0;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto *header = reinterpret_cast<const PacketHeader *>(collated.buffer(byte_count));
+
+  CollatedPacketDecoder decoder;
+  for (auto _ : state)
+  {
+    decoder.setPacket(header);
+    while (const auto *packet = decoder.next())
+    {
+      benchmark::DoNotOptimize(packet);
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * collated.collatedBytes()));
+}
+}  // namespace
+
+BENCHMARK(benchCollate)
+  ->Arg(-1)
+  ->Arg(static_cast<int>(CompressionLevel::Low))
+  ->Arg(static_cast<int>(CompressionLevel::Medium))
+  ->Arg(static_cast<int>(CompressionLevel::High))
+  ->Arg(static_cast<int>(CompressionLevel::VeryHigh));
+BENCHMARK(benchDecodeCollated)->Arg(-1)->Arg(static_cast<int>(CompressionLevel::Medium));
+}  // namespace tes
@@ -0,0 +1,154 @@
+//
+// author: Kazys Stepanas
+//
+#include <3escore/DataBuffer.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketWriter.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+namespace tes
+{
+namespace
+{
+std::vector<Vector3f> makeVertices(size_t count)
+{
+  std::mt19937 rand_engine(42u);
+  std::uniform_real_distribution<float> rand(-10.0f, 10.0f);
+  std::vector<Vector3f> vertices(count);
+  for (auto &vertex : vertices)
+  {
+    vertex = Vector3f(rand(rand_engine), rand(rand_engine), rand(rand_engine));
+  }
+  return vertices;
+}
+
+
+/// Write a buffer into packets, as done when transferring mesh data. Range 0 is the vertex count.
+void benchWrite(benchmark::State &state)
+{
+  const auto vertices = makeVertices(static_cast<size_t>(state.range(0)));
+  const DataBuffer buffer(vertices);
+  std::vector<uint8_t> packet_buffer(0xffffu);
+  for (auto _ : state)
+  {
+    uint32_t offset = 0;
+    while (offset < buffer.count())
+    {
+      PacketWriter writer(packet_buffer.data(), packet_buffer.size());
+      const auto written = buffer.write(writer, offset);
+      if (written == 0)
+      {
+        state.SkipWithError("Write failed");
+        return;
+      }
+      offset += written;
+      writer.finalise();
+      benchmark::DoNotOptimize(packet_buffer.data());
+    }
+  }
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * vertices.size() * sizeof(Vector3f)));
+}
+
+
+/// Write a buffer quantised to 16-bit integers. Range 0 is the vertex count.
+void benchWritePacked(benchmark::State &state)
+{
+  const auto vertices = makeVertices(static_cast<size_t>(state.range(0)));
+  const DataBuffer buffer(vertices);
+  std::vector<uint8_t> packet_buffer(0xffffu);
+  for (auto _ : state)
+  {
+    uint32_t offset = 0;
+    while (offset < buffer.count())
+    {
+      PacketWriter writer(packet_buffer.data(), packet_buffer.size());
+      const auto written = buffer.writePacked(writer, offset, 1e-3);
+      if (written == 0)
+      {
+        state.SkipWithError("Write failed");
+        return;
+      }
+      offset += written;
+      writer.finalise();
+      benchmark::DoNotOptimize(packet_buffer.data());
+    }
+  }
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * vertices.size() * sizeof(Vector3f)));
+}
+
+
+/// Read a packed buffer back from packets. Range 0 is the vertex count.
+void benchReadPacked(benchmark::State &state)
+{
+  const auto vertices = makeVertices(static_cast<size_t>(state.range(0)));
+  const DataBuffer buffer(vertices);
+  std::vector<std::vector<uint8_t>> packets;
+  uint32_t offset = 0;
+  while (offset < buffer.count())
+  {
+    std::vector<uint8_t> packet_buffer(0xffffu);
+    PacketWriter writer(packet_buffer.data(), packet_buffer.size());
+    offset += buffer.writePacked(writer, offset, 1e-3);
+    writer.finalise();
+    packet_buffer.resize(writer.packetSize());
+    packets.emplace_back(std::move(packet_buffer));
+  }
+
+  for (auto _ : state)
+  {
+    DataBuffer read_buffer(DctFloat32, 3);
+    for (const auto &packet : packets)
+    {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      PacketReader reader(reinterpret_cast<const PacketHeader *>(packet.data()));
+      read_buffer.read(reader);
+    }
+    benchmark::DoNotOptimize(read_buffer.count());
+  }
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * vertices.size() * sizeof(Vector3f)));
+}
+
+
+/// Read a float buffer as double, converting each component. Range 0 is the vertex count.
+void benchGetConvert(benchmark::State &state)
+{
+  const auto vertices = makeVertices(static_cast<size_t>(state.range(0)));
+  const DataBuffer buffer(vertices);
+  std::vector<double> converted(buffer.addressableCount());
+  for (auto _ : state)
+  {
+    buffer.get(0, buffer.count(), converted.data(), converted.size());
+    benchmark::DoNotOptimize(converted.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * converted.size()));
+}
+
+
+/// Duplicate a borrowed buffer, taking ownership of a copy. Range 0 is the vertex count.
+void benchDuplicate(benchmark::State &state)
+{
+  const auto vertices = makeVertices(static_cast<size_t>(state.range(0)));
+  for (auto _ : state)
+  {
+    DataBuffer buffer(vertices);
+    buffer.duplicate();
+    benchmark::DoNotOptimize(buffer.ptr<float>());
+  }
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * vertices.size() * sizeof(Vector3f)));
+}
+}  // namespace
+
+BENCHMARK(benchWrite)->Arg(1024)->Arg(65536);
+BENCHMARK(benchWritePacked)->Arg(1024)->Arg(65536);
+BENCHMARK(benchReadPacked)->Arg(1024)->Arg(65536);
+BENCHMARK(benchGetConvert)->Arg(1024)->Arg(65536);
+BENCHMARK(benchDuplicate)->Arg(1024)->Arg(65536);
+}  // namespace tes
@@ -0,0 +1,140 @@
+//
+// author: Kazys Stepanas
+//
+#include "BenchViewer.h"
+
+#include <3esview/ThirdEyeScene.h>
+
+#include <3escore/Messages.h>
+#include <3escore/PacketBuffer.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketWriter.h>
+#include <3escore/shapes/MeshShape.h>
+#include <3escore/shapes/Sphere.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace tes::view
+{
+namespace
+{
+/// A recorded message stream along with the number of frames it contains.
+struct RecordedStream
+{
+  std::vector<uint8_t> bytes;
+  FrameNumber frame_count = 0;
+};
+
+void appendPacket(RecordedStream &stream, PacketWriter &writer)
+{
+  writer.finalise();
+  stream.bytes.insert(stream.bytes.end(), writer.data(), writer.data() + writer.packetSize());
+}
+
+void appendShape(RecordedStream &stream, PacketWriter &writer, const Shape &shape)
+{
+  shape.writeCreate(writer);
+  appendPacket(stream, writer);
+  if (shape.isComplex())
+  {
+    unsigned progress = 0;
+    int status = 0;
+    while ((status = shape.writeData(writer, progress)) >= 0)
+    {
+      appendPacket(stream, writer);
+      if (status == 0)
+      {
+        break;
+      }
+    }
+  }
+}
+
+/// Record a stream where each frame has a burst of point cloud mesh data alongside many simple
+/// shapes. This is the case parallel dispatch targets: shape messages no longer queue behind the
+/// mesh data.
+RecordedStream recordStream(FrameNumber frame_count, unsigned shapes_per_frame,
+                            unsigned points_per_frame)
+{
+  RecordedStream stream;
+  std::vector<uint8_t> buffer(0xffffu);
+  PacketWriter writer(buffer.data(), static_cast<uint16_t>(buffer.size()));
+
+  std::vector<Vector3f> points(points_per_frame);
+  for (FrameNumber frame = 0; frame < frame_count; ++frame)
+  {
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      points[i] = Vector3f(static_cast<float>(i), static_cast<float>(frame), 0.0f);
+    }
+    appendShape(stream, writer, MeshShape(DrawType::Points, Id(), DataBuffer(points)));
+
+    for (unsigned i = 0; i < shapes_per_frame; ++i)
+    {
+      const Sphere sphere(Id(), Spherical(Vector3f(static_cast<float>(i), 0, 0), 0.5f));
+      appendShape(stream, writer, sphere);
+    }
+
+    ControlMessage msg = {};
+    writer.reset(MtControl, CIdFrame);
+    msg.write(writer);
+    appendPacket(stream, writer);
+  }
+
+  stream.frame_count = frame_count;
+  return stream;
+}
+
+/// Replay @p stream into @p tes in the same way as a @c data::StreamThread .
+/// @return The number of packets processed.
+size_t replay(ThirdEyeScene &tes, const RecordedStream &stream)
+{
+  PacketBuffer packet_buffer;
+  std::vector<uint8_t> packet_bytes;
+  packet_buffer.addBytes(stream.bytes.data(), stream.bytes.size());
+  size_t packet_count = 0;
+  FrameNumber frame = 0;
+  while (const PacketHeader *header = packet_buffer.extractPacket(packet_bytes))
+  {
+    PacketReader packet(header);
+    ++packet_count;
+    if (packet.routingId() == MtControl)
+    {
+      tes.updateToFrame(++frame);
+    }
+    else
+    {
+      tes.processMessage(packet);
+    }
+  }
+  return packet_count;
+}
+
+
+/// Replay a recorded stream through @c ThirdEyeScene message dispatch.
+/// Range 0 is the number of dispatch threads, zero for synchronous dispatch.
+void benchDispatch(benchmark::State &state)
+{
+  static const RecordedStream stream = recordStream(100, 1000, 50000);
+  const auto &tes = BenchViewer::instance().tes();
+  tes->setDispatchThreads(static_cast<unsigned>(state.range(0)));
+
+  size_t packet_count = 0;
+  for (auto _ : state)
+  {
+    packet_count += replay(*tes, stream);
+    state.PauseTiming();
+    tes->reset();
+    state.ResumeTiming();
+  }
+
+  tes->setDispatchThreads(0);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stream.bytes.size()));
+  state.SetItemsProcessed(static_cast<int64_t>(packet_count));
+}
+}  // namespace
+
+BENCHMARK(benchDispatch)->Arg(0)->Arg(2)->Arg(4)->Unit(benchmark::kMillisecond);
+}  // namespace tes::view
@@ -0,0 +1,208 @@
+//
+// author: Kazys Stepanas
+//
+#include <3escore/Crc.h>
+#include <3escore/Messages.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketStreamReader.h>
+#include <3escore/PacketWriter.h>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tes
+{
+namespace
+{
+/// Packet buffer size used by the element I/O benchmarks.
+constexpr uint16_t kPacketBufferSize = 0xffffu;
+
+template <typename T>
+std::vector<T> makeElements(size_t count)
+{
+  std::mt19937 rand_engine(42u);
+  std::uniform_int_distribution<int> rand(0, 127);
+  std::vector<T> elements(count);
+  for (auto &element : elements)
+  {
+    element = static_cast<T>(rand(rand_engine));
+  }
+  return elements;
+}
+
+
+template <typename T>
+void benchWriteElement(benchmark::State &state)
+{
+  const auto elements = makeElements<T>((kPacketBufferSize - 64u) / sizeof(T));
+  std::vector<uint8_t> buffer(kPacketBufferSize);
+  for (auto _ : state)
+  {
+    PacketWriter writer(buffer.data(), buffer.size(), MtNull);
+    for (const auto &element : elements)
+    {
+      writer.writeElement(element);
+    }
+    writer.finalise();
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements.size()));
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * elements.size() * sizeof(T)));
+}
+
+
+template <typename T>
+void benchWriteArray(benchmark::State &state)
+{
+  const auto elements = makeElements<T>((kPacketBufferSize - 64u) / sizeof(T));
+  std::vector<uint8_t> buffer(kPacketBufferSize);
+  for (auto _ : state)
+  {
+    PacketWriter writer(buffer.data(), buffer.size(), MtNull);
+    writer.writeArray(elements.data(), elements.size());
+    writer.finalise();
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * elements.size() * sizeof(T)));
+}
+
+
+template <typename T>
+void benchReadElement(benchmark::State &state)
+{
+  const auto elements = makeElements<T>((kPacketBufferSize - 64u) / sizeof(T));
+  std::vector<uint8_t> buffer(kPacketBufferSize);
+  PacketWriter writer(buffer.data(), buffer.size(), MtNull);
+  writer.writeArray(elements.data(), elements.size());
+  writer.finalise();
+
+  for (auto _ : state)
+  {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    PacketReader reader(reinterpret_cast<const PacketHeader *>(buffer.data()));
+    T element = {};
+    for (size_t i = 0; i < elements.size(); ++i)
+    {
+      reader.readElement(element);
+      benchmark::DoNotOptimize(element);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements.size()));
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * elements.size() * sizeof(T)));
+}
+
+
+template <typename T>
+void benchReadArray(benchmark::State &state)
+{
+  const auto elements = makeElements<T>((kPacketBufferSize - 64u) / sizeof(T));
+  std::vector<uint8_t> buffer(kPacketBufferSize);
+  PacketWriter writer(buffer.data(), buffer.size(), MtNull);
+  writer.writeArray(elements.data(), elements.size());
+  writer.finalise();
+
+  std::vector<T> read_elements(elements.size());
+  for (auto _ : state)
+  {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    PacketReader reader(reinterpret_cast<const PacketHeader *>(buffer.data()));
+    reader.readArray(read_elements.data(), read_elements.size());
+    benchmark::DoNotOptimize(read_elements.data());
+  }
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * elements.size() * sizeof(T)));
+}
+
+
+void benchCrc16(benchmark::State &state)
+{
+  const auto data = makeElements<uint8_t>(static_cast<size_t>(state.range(0)));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(crc16(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+
+
+void benchCrc32(benchmark::State &state)
+{
+  const auto data = makeElements<uint8_t>(static_cast<size_t>(state.range(0)));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(crc32(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+
+
+/// Build a stream of @p packet_count packets, each with @p payload_size bytes of payload.
+std::string makePacketStream(size_t packet_count, size_t payload_size)
+{
+  const auto payload = makeElements<uint8_t>(payload_size);
+  std::vector<uint8_t> buffer(kPacketBufferSize);
+  std::string stream;
+  for (size_t i = 0; i < packet_count; ++i)
+  {
+    PacketWriter writer(buffer.data(), buffer.size(), MtControl, CIdNull);
+    writer.writeArray(payload.data(), payload.size());
+    writer.finalise();
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    stream.append(reinterpret_cast<const char *>(buffer.data()), writer.packetSize());
+  }
+  return stream;
+}
+
+
+void benchPacketStreamReader(benchmark::State &state)
+{
+  constexpr size_t kPacketCount = 1000u;
+  const std::string data = makePacketStream(kPacketCount, static_cast<size_t>(state.range(0)));
+  for (auto _ : state)
+  {
+    std::istringstream in(data);
+    PacketStreamReader reader(in);
+    size_t packet_count = 0;
+    while (reader.extractPacket().header)
+    {
+      ++packet_count;
+    }
+    if (packet_count != kPacketCount)
+    {
+      state.SkipWithError("Packet count mismatch");
+      break;
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kPacketCount));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE(benchWriteElement, uint8_t);
+BENCHMARK_TEMPLATE(benchWriteElement, uint32_t);
+BENCHMARK_TEMPLATE(benchWriteElement, float);
+BENCHMARK_TEMPLATE(benchWriteElement, double);
+BENCHMARK_TEMPLATE(benchWriteArray, uint8_t);
+BENCHMARK_TEMPLATE(benchWriteArray, uint32_t);
+BENCHMARK_TEMPLATE(benchWriteArray, float);
+BENCHMARK_TEMPLATE(benchWriteArray, double);
+BENCHMARK_TEMPLATE(benchReadElement, uint8_t);
+BENCHMARK_TEMPLATE(benchReadElement, uint32_t);
+BENCHMARK_TEMPLATE(benchReadElement, float);
+BENCHMARK_TEMPLATE(benchReadElement, double);
+BENCHMARK_TEMPLATE(benchReadArray, uint8_t);
+BENCHMARK_TEMPLATE(benchReadArray, uint32_t);
+BENCHMARK_TEMPLATE(benchReadArray, float);
+BENCHMARK_TEMPLATE(benchReadArray, double);
+BENCHMARK(benchCrc16)->Arg(64)->Arg(1024)->Arg(0xffff);
+BENCHMARK(benchCrc32)->Arg(64)->Arg(1024)->Arg(0xffff);
+BENCHMARK(benchPacketStreamReader)->Arg(16)->Arg(256)->Arg(4096);
+}  // namespace tes
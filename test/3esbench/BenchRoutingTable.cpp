@@ -0,0 +1,98 @@
+//
+// author: Kazys Stepanas
+//
+#include "3esbench/BenchViewerConfig.h"
+
+#include <3esview/util/RoutingTable.h>
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace tes::view
+{
+namespace
+{
+/// Number of packet routing IDs to look up per iteration.
+constexpr size_t kPacketCount = 4096u;
+
+struct Handler
+{
+  int value = 0;
+};
+
+/// Routing IDs drawn from a typical spread of built in and user handler IDs.
+const std::vector<uint32_t> &registeredIds()
+{
+  static const std::vector<uint32_t> ids = { 1,  2,  3,  4,  5,  6,  7,  8,  64,  65, 66,
+                                             67, 68, 69, 70, 71, 72, 73, 74, 75, 2048 };
+  return ids;
+}
+
+/// Generate the routing IDs for a sequence of packets.
+std::vector<uint32_t> makePackets()
+{
+  const auto &ids = registeredIds();
+  std::mt19937 rand_eng(0x01020304);
+  std::uniform_int_distribution<size_t> rand(0, ids.size() - 1u);
+  std::vector<uint32_t> packets(kPacketCount);
+  for (auto &id : packets)
+  {
+    id = ids[rand(rand_eng)];
+  }
+  return packets;
+}
+
+
+/// Look up the handler for each packet using a @c util::RoutingTable .
+void benchRoutingTable(benchmark::State &state)
+{
+  util::RoutingTable<std::shared_ptr<Handler>> table;
+  for (const auto id : registeredIds())
+  {
+    table.set(id, std::make_shared<Handler>(Handler{ static_cast<int>(id) }));
+  }
+  const auto packets = makePackets();
+
+  for (auto _ : state)
+  {
+    int64_t sum = 0;
+    for (const auto id : packets)
+    {
+      sum += table[id]->value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * packets.size()));
+}
+
+
+/// Look up the handler for each packet using a hash map, which @c util::RoutingTable replaces.
+void benchRoutingMap(benchmark::State &state)
+{
+  std::unordered_map<uint32_t, std::shared_ptr<Handler>> map;
+  for (const auto id : registeredIds())
+  {
+    map.emplace(id, std::make_shared<Handler>(Handler{ static_cast<int>(id) }));
+  }
+  const auto packets = makePackets();
+
+  for (auto _ : state)
+  {
+    int64_t sum = 0;
+    for (const auto id : packets)
+    {
+      sum += map.find(id)->second->value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * packets.size()));
+}
+}  // namespace
+
+BENCHMARK(benchRoutingTable);
+BENCHMARK(benchRoutingMap);
+}  // namespace tes::view
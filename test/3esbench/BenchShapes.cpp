@@ -0,0 +1,185 @@
+//
+// author: Kazys Stepanas
+//
+#include <3escore/CollatedPacket.h>
+#include <3escore/PacketWriter.h>
+#include <3escore/ShapeRegistry.h>
+#include <3escore/shapes/MeshShape.h>
+#include <3escore/shapes/MutableMesh.h>
+#include <3escore/shapes/Sphere.h>
+#include <3escore/tessellate/Sphere.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace tes
+{
+namespace
+{
+void benchSphereCreate(benchmark::State &state)
+{
+  const Sphere sphere(Id(1u, 2u), Spherical(Vector3f(1, 2, 3), 1.5f));
+  std::vector<uint8_t> buffer(0xffffu);
+  for (auto _ : state)
+  {
+    PacketWriter writer(buffer.data(), buffer.size());
+    sphere.writeCreate(writer);
+    writer.finalise();
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+
+void benchSphereUpdate(benchmark::State &state)
+{
+  Sphere sphere(Id(1u, 2u), Spherical(Vector3f(1, 2, 3), 1.5f));
+  std::vector<uint8_t> buffer(0xffffu);
+  float x = 0;
+  for (auto _ : state)
+  {
+    sphere.setPosition(Vector3f(x, 2, 3));
+    x += 1.0f;
+    PacketWriter writer(buffer.data(), buffer.size());
+    sphere.writeUpdate(writer);
+    writer.finalise();
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+
+/// Encode a mesh shape create message and all its data messages. Range 0 is the sphere
+/// tessellation depth.
+void benchMeshShapeCreate(benchmark::State &state)
+{
+  std::vector<Vector3f> vertices;
+  std::vector<unsigned> indices;
+  std::vector<Vector3f> normals;
+  sphere::solid(vertices, indices, normals, 1.0f, Vector3f(0.0f),
+                static_cast<unsigned>(state.range(0)));
+  MeshShape mesh(DrawType::Triangles, Id(1u), DataBuffer(vertices), DataBuffer(indices));
+  mesh.setNormals(DataBuffer(normals));
+
+  std::vector<uint8_t> buffer(0xffffu);
+  size_t bytes = 0;
+  for (auto _ : state)
+  {
+    PacketWriter writer(buffer.data(), buffer.size());
+    mesh.writeCreate(writer);
+    writer.finalise();
+    bytes += writer.packetSize();
+
+    unsigned progress = 0;
+    int result = 0;
+    do
+    {
+      writer.reset(mesh.routingId(), 0);
+      result = mesh.writeData(writer, progress);
+      writer.finalise();
+      bytes += writer.packetSize();
+    } while (result > 0);
+
+    if (result < 0)
+    {
+      state.SkipWithError("Mesh data write failed");
+      break;
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  state.counters["vertices"] = static_cast<double>(vertices.size());
+}
+
+
+/// Apply a set of random vertex and colour edits to a @c MutableMesh and encode the resulting
+/// update. Range 0 is the vertex count, range 1 is the number of edits per update.
+void benchMutableMeshUpdate(benchmark::State &state)
+{
+  const auto vertex_count = static_cast<unsigned>(state.range(0));
+  const auto edit_count = static_cast<unsigned>(state.range(1));
+  const auto components = MeshComponentFlag::Vertex | MeshComponentFlag::Colour;
+
+  MutableMesh mesh(1u, DrawType::Points, components);
+  // Large, uncompressed collation buffer to capture all the messages for an update.
+  CollatedPacket collated(0xffffu, 0xffffffffu);
+
+  std::vector<Vector3f> vertices(vertex_count);
+  std::vector<uint32_t> colours(vertex_count);
+  for (unsigned i = 0; i < vertex_count; ++i)
+  {
+    vertices[i] = Vector3f(static_cast<float>(i), 0, 0);
+    colours[i] = i;
+  }
+  mesh.setVertexCount(vertex_count);
+  mesh.setVertices(0u, vertices.data(), vertex_count);
+  mesh.setColours(0u, colours.data(), vertex_count);
+  mesh.update(&collated);
+
+  std::mt19937 rand_engine(42u);
+  std::uniform_int_distribution<unsigned> index_rand(0u, vertex_count - 1u);
+  size_t bytes = 0;
+  for (auto _ : state)
+  {
+    for (unsigned i = 0; i < edit_count; ++i)
+    {
+      const unsigned index = index_rand(rand_engine);
+      mesh.setVertex(index, Vector3f(static_cast<float>(index), static_cast<float>(i), 0));
+      mesh.setColours(index, &i, 1u);
+    }
+    collated.reset();
+    mesh.update(&collated);
+    bytes += collated.collatedBytes();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * edit_count));
+  state.counters["bytes_per_update"] = benchmark::Counter(
+    static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+
+
+/// Move a fraction of the entries in a @c ShapeRegistry and encode the changes. Range 0 is the
+/// entry count, range 1 is the percentage of entries moved per update.
+void benchShapeRegistryUpdate(benchmark::State &state)
+{
+  const auto entry_count = static_cast<unsigned>(state.range(0));
+  const auto move_step = static_cast<unsigned>(100 / std::max<int64_t>(state.range(1), 1));
+
+  ShapeRegistry registry(SIdSphere);
+  registry.reserve(entry_count);
+  for (unsigned i = 0; i < entry_count; ++i)
+  {
+    registry.add(i + 1u, Vector3f(static_cast<float>(i), 0, 0));
+  }
+  size_t bytes = 0;
+  const auto emit = [&bytes](const uint8_t *data, uint32_t byte_count) {
+    benchmark::DoNotOptimize(data);
+    bytes += byte_count;
+  };
+  registry.encode(emit);
+  bytes = 0;
+
+  float z = 0;
+  for (auto _ : state)
+  {
+    z += 1.0f;
+    Vector3f *positions = registry.positions();
+    for (unsigned i = 0; i < entry_count; i += move_step)
+    {
+      positions[i].z() = z;
+    }
+    registry.encode(emit, true);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * entry_count));
+  state.counters["bytes_per_update"] = benchmark::Counter(
+    static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+}  // namespace
+
+BENCHMARK(benchSphereCreate);
+BENCHMARK(benchSphereUpdate);
+BENCHMARK(benchMeshShapeCreate)->Arg(2)->Arg(4);
+BENCHMARK(benchMutableMeshUpdate)->Args({ 4096, 16 })->Args({ 4096, 1024 })->Args({ 65536, 1024 });
+BENCHMARK(benchShapeRegistryUpdate)->Args({ 65536, 1 })->Args({ 65536, 100 });
+}  // namespace tes
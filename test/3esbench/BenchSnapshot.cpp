@@ -0,0 +1,144 @@
+//
+// author: Kazys Stepanas
+//
+#include "BenchViewer.h"
+
+#include <3esview/ThirdEyeScene.h>
+
+#include <3escore/FileConnection.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketWriter.h>
+#include <3escore/shapes/MeshShape.h>
+#include <3escore/shapes/Sphere.h>
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <vector>
+
+namespace tes::view
+{
+namespace
+{
+constexpr unsigned kSphereCount = 20000u;
+constexpr unsigned kPointCount = 100000u;
+
+void processShape(ThirdEyeScene &tes, PacketWriter &writer, const Shape &shape)
+{
+  shape.writeCreate(writer);
+  writer.finalise();
+  PacketReader create(reinterpret_cast<const PacketHeader *>(writer.data()));
+  tes.processMessage(create);
+  if (shape.isComplex())
+  {
+    unsigned progress = 0;
+    int status = 0;
+    while ((status = shape.writeData(writer, progress)) >= 0)
+    {
+      writer.finalise();
+      PacketReader data(reinterpret_cast<const PacketHeader *>(writer.data()));
+      tes.processMessage(data);
+      if (status == 0)
+      {
+        break;
+      }
+    }
+  }
+}
+
+/// Reset @p tes and populate it with many persistent spheres and a persistent point cloud.
+void populateScene(ThirdEyeScene &tes)
+{
+  tes.reset();
+  std::vector<uint8_t> buffer(0xffffu);
+  PacketWriter writer(buffer.data(), static_cast<uint16_t>(buffer.size()));
+
+  for (unsigned i = 0; i < kSphereCount; ++i)
+  {
+    const Sphere sphere(Id(i + 1), Spherical(Vector3f(static_cast<float>(i), 0, 0), 0.5f));
+    processShape(tes, writer, sphere);
+  }
+
+  std::vector<Vector3f> points(kPointCount);
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    points[i] = Vector3f(static_cast<float>(i), 1.0f, 0.0f);
+  }
+  processShape(tes, writer, MeshShape(DrawType::Points, Id(1), DataBuffer(points)));
+  tes.updateToFrame(1);
+}
+
+
+/// Write a snapshot of the populated scene as a 3es stream.
+void benchStreamSnapshot(benchmark::State &state)
+{
+  const auto &tes = BenchViewer::instance().tes();
+  populateScene(*tes);
+  const auto path = std::filesystem::temp_directory_path() / "3es_bench_snapshot.3es";
+
+  for (auto _ : state)
+  {
+    FileConnection out(path.string(), ServerSettings());
+    if (!tes->saveSnapshot(out, []() { return false; }).first)
+    {
+      state.SkipWithError("stream snapshot failed");
+      break;
+    }
+  }
+
+  std::filesystem::remove(path);
+}
+
+
+/// Write a binary snapshot of the populated scene.
+void benchBinarySnapshot(benchmark::State &state)
+{
+  const auto &tes = BenchViewer::instance().tes();
+  populateScene(*tes);
+  const auto path = std::filesystem::temp_directory_path() / "3es_bench_snapshot.bin";
+
+  for (auto _ : state)
+  {
+    if (!tes->saveSnapshot(path, []() { return false; }).first)
+    {
+      state.SkipWithError("binary snapshot failed");
+      break;
+    }
+  }
+
+  std::filesystem::remove(path);
+}
+
+
+/// Restore a binary snapshot of the populated scene into a clean scene.
+void benchRestoreSnapshot(benchmark::State &state)
+{
+  const auto &tes = BenchViewer::instance().tes();
+  populateScene(*tes);
+  const auto path = std::filesystem::temp_directory_path() / "3es_bench_restore.bin";
+  if (!tes->saveSnapshot(path, []() { return false; }).first)
+  {
+    state.SkipWithError("binary snapshot failed");
+    return;
+  }
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    tes->reset();
+    state.ResumeTiming();
+    if (!tes->loadSnapshot(path))
+    {
+      state.SkipWithError("restore snapshot failed");
+      break;
+    }
+  }
+
+  std::filesystem::remove(path);
+}
+}  // namespace
+
+BENCHMARK(benchStreamSnapshot)->Unit(benchmark::kMillisecond);
+BENCHMARK(benchBinarySnapshot)->Unit(benchmark::kMillisecond);
+BENCHMARK(benchRestoreSnapshot)->Unit(benchmark::kMillisecond);
+}  // namespace tes::view
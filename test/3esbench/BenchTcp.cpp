@@ -0,0 +1,209 @@
+//
+// author: Kazys Stepanas
+//
+#include <3escore/PacketBuffer.h>
+#include <3escore/PacketHeader.h>
+#include <3escore/PacketWriter.h>
+#include <3escore/TcpListenSocket.h>
+#include <3escore/TcpSocket.h>
+#include <3escore/shapes/Sphere.h>
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace tes
+{
+namespace
+{
+/// First port to try listening on.
+constexpr uint16_t kBasePort = 33600u;
+/// Number of ports to try before failing.
+constexpr uint16_t kPortAttempts = 32u;
+/// Read size for the legacy receive path (bytes).
+constexpr size_t kLegacyReadSize = 2048u;
+/// Read size for the block receive path (bytes).
+constexpr size_t kBlockReadSize = 256u * 1024u;
+
+/// Receive strategies.
+enum class ReadMode : int
+{
+  /// Read 2KiB into an intermediate buffer, copy to the @c PacketBuffer and extract one packet
+  /// per read.
+  Legacy,
+  /// Read blocks directly into the @c PacketBuffer and extract all packets per read.
+  Block
+};
+
+
+/// Encode sphere create messages until the stream is at least @p byte_count bytes.
+/// @param[out] packet_count Set to the number of packets in the stream.
+std::vector<uint8_t> makeStream(size_t byte_count, size_t &packet_count)
+{
+  std::mt19937 rand_engine(42u);
+  std::uniform_real_distribution<float> rand(-10.0f, 10.0f);
+  std::vector<uint8_t> buffer(0xffffu);
+  std::vector<uint8_t> stream;
+  stream.reserve(byte_count + buffer.size());
+  packet_count = 0;
+  while (stream.size() < byte_count)
+  {
+    const Sphere sphere(Id(static_cast<uint32_t>(packet_count + 1)),
+                        Spherical(Vector3f(rand(rand_engine), rand(rand_engine), rand(rand_engine)),
+                                  rand(rand_engine)));
+    PacketWriter writer(buffer.data(), buffer.size());
+    sphere.writeCreate(writer);
+    writer.finalise();
+    stream.insert(stream.end(), buffer.data(), buffer.data() + writer.packetSize());
+    ++packet_count;
+  }
+  return stream;
+}
+
+
+/// Listen on the first available port from @c kBasePort .
+bool listen(TcpListenSocket &server)
+{
+  for (uint16_t i = 0; i < kPortAttempts; ++i)
+  {
+    if (server.listen(static_cast<uint16_t>(kBasePort + i)))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/// Receive @p packet_count packets totalling @p byte_count bytes from @p socket .
+/// @return The number of packets received.
+size_t receive(TcpSocket &socket, ReadMode mode, size_t byte_count, size_t packet_count)
+{
+  PacketBuffer packet_buffer((mode == ReadMode::Block) ? kBlockReadSize : kLegacyReadSize);
+  std::vector<uint8_t> read_buffer(kLegacyReadSize);
+  std::vector<uint8_t> packet_data;
+  size_t received_bytes = 0;
+  size_t received_packets = 0;
+
+  while (received_packets < packet_count && socket.isConnected())
+  {
+    int bytes_read = 0;
+    if (mode == ReadMode::Block)
+    {
+      bytes_read =
+        socket.readAvailable(packet_buffer.writeBuffer(kBlockReadSize), int(kBlockReadSize));
+      if (bytes_read > 0)
+      {
+        packet_buffer.commitBytes(static_cast<size_t>(bytes_read));
+      }
+    }
+    else
+    {
+      bytes_read = socket.readAvailable(read_buffer.data(), int(read_buffer.size()));
+      if (bytes_read > 0)
+      {
+        packet_buffer.addBytes(read_buffer.data(), static_cast<size_t>(bytes_read));
+      }
+    }
+
+    if (bytes_read <= 0)
+    {
+      if (received_bytes < byte_count)
+      {
+        continue;
+      }
+    }
+    received_bytes += static_cast<size_t>(std::max(bytes_read, 0));
+
+    // The legacy path only extracts one packet per read, draining once all data have arrived.
+    const bool extract_all = mode == ReadMode::Block || received_bytes >= byte_count;
+    while (const auto *packet = packet_buffer.extractPacket(packet_data))
+    {
+      benchmark::DoNotOptimize(packet);
+      ++received_packets;
+      if (!extract_all)
+      {
+        break;
+      }
+    }
+  }
+
+  return received_packets;
+}
+
+
+/// Stream sphere packets over a loopback connection and receive them.
+/// Range 0 is the @c ReadMode , range 1 the receive buffer size (KiB).
+void benchTcpReceive(benchmark::State &state)
+{
+  const auto mode = static_cast<ReadMode>(state.range(0));
+  const int receive_buffer_size = static_cast<int>(state.range(1) * 1024);
+  size_t packet_count = 0;
+  const auto stream = makeStream(16u * 1024u * 1024u, packet_count);
+
+  TcpListenSocket server;
+  if (!listen(server))
+  {
+    state.SkipWithError("Failed to listen");
+    return;
+  }
+
+  for (auto _ : state)
+  {
+    std::thread sender([&server, &stream] {
+      const auto connection = server.accept(5000u);
+      if (!connection)
+      {
+        return;
+      }
+      connection->setNoDelay(true);
+      connection->setSendBufferSize(1024 * 1024);
+      constexpr size_t kChunkSize = 64u * 1024u;
+      for (size_t offset = 0; offset < stream.size(); offset += kChunkSize)
+      {
+        const auto size = std::min(kChunkSize, stream.size() - offset);
+        if (connection->write(stream.data() + offset, static_cast<int>(size)) < 0)
+        {
+          break;
+        }
+      }
+      connection->close();
+    });
+
+    TcpSocket client;
+    if (!client.open("127.0.0.1", server.port()))
+    {
+      sender.join();
+      state.SkipWithError("Failed to connect");
+      break;
+    }
+    client.setNoDelay(true);
+    client.setReadTimeout(0);
+    client.setReadBufferSize(receive_buffer_size);
+
+    const size_t received = receive(client, mode, stream.size(), packet_count);
+    client.close();
+    sender.join();
+
+    if (received != packet_count)
+    {
+      state.SkipWithError("Incomplete receive");
+      break;
+    }
+  }
+
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stream.size()));
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * packet_count));
+}
+}  // namespace
+
+BENCHMARK(benchTcpReceive)
+  ->Args({ static_cast<int>(ReadMode::Legacy), 1024 })
+  ->Args({ static_cast<int>(ReadMode::Block), 1024 })
+  ->Args({ static_cast<int>(ReadMode::Block), 4096 })
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
+}  // namespace tes
@@ -0,0 +1,153 @@
+//
+// author: Kazys Stepanas
+//
+#include <3escore/tessellate/Arrow.h>
+#include <3escore/tessellate/Box.h>
+#include <3escore/tessellate/Capsule.h>
+#include <3escore/tessellate/Cone.h>
+#include <3escore/tessellate/Cylinder.h>
+#include <3escore/tessellate/Sphere.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace tes
+{
+namespace
+{
+/// Tessellation output buffers, reused across iterations as a typical caller would.
+struct Mesh
+{
+  std::vector<Vector3f> vertices;
+  std::vector<unsigned> indices;
+  std::vector<Vector3f> normals;
+
+  void clear()
+  {
+    vertices.clear();
+    indices.clear();
+    normals.clear();
+  }
+};
+
+
+void setCounters(benchmark::State &state, const Mesh &mesh)
+{
+  state.counters["vertices"] = static_cast<double>(mesh.vertices.size());
+  state.counters["indices"] = static_cast<double>(mesh.indices.size());
+}
+
+
+/// Range 0 is the subdivision depth.
+void benchSphereSolid(benchmark::State &state)
+{
+  Mesh mesh;
+  for (auto _ : state)
+  {
+    mesh.clear();
+    sphere::solid(mesh.vertices, mesh.indices, mesh.normals, 1.0f, Vector3f(0.0f),
+                  static_cast<unsigned>(state.range(0)));
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  setCounters(state, mesh);
+}
+
+
+/// Range 0 is the segment count.
+void benchSphereLatLong(benchmark::State &state)
+{
+  Mesh mesh;
+  const auto segments = static_cast<unsigned>(state.range(0));
+  for (auto _ : state)
+  {
+    mesh.clear();
+    sphere::solidLatLong(mesh.vertices, mesh.indices, mesh.normals, 1.0f, Vector3f(0.0f),
+                         segments / 2u, segments);
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  setCounters(state, mesh);
+}
+
+
+void benchBoxSolid(benchmark::State &state)
+{
+  Mesh mesh;
+  for (auto _ : state)
+  {
+    mesh.clear();
+    box::solid(mesh.vertices, mesh.indices, mesh.normals);
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  setCounters(state, mesh);
+}
+
+
+/// Range 0 is the facet count.
+void benchCylinderSolid(benchmark::State &state)
+{
+  Mesh mesh;
+  for (auto _ : state)
+  {
+    mesh.clear();
+    cylinder::solid(mesh.vertices, mesh.indices, mesh.normals, Vector3f(0, 0, 1), 2.0f, 0.5f,
+                    static_cast<unsigned>(state.range(0)));
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  setCounters(state, mesh);
+}
+
+
+/// Range 0 is the facet count.
+void benchConeSolid(benchmark::State &state)
+{
+  Mesh mesh;
+  for (auto _ : state)
+  {
+    mesh.clear();
+    cone::solid(mesh.vertices, mesh.indices, mesh.normals, Vector3f(0.0f), Vector3f(0, 0, 1),
+                2.0f, 0.25f, static_cast<unsigned>(state.range(0)));
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  setCounters(state, mesh);
+}
+
+
+/// Range 0 is the facet count.
+void benchCapsuleSolid(benchmark::State &state)
+{
+  Mesh mesh;
+  for (auto _ : state)
+  {
+    mesh.clear();
+    capsule::solid(mesh.vertices, mesh.indices, mesh.normals, 2.0f, 0.5f,
+                   static_cast<unsigned>(state.range(0)));
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  setCounters(state, mesh);
+}
+
+
+/// Range 0 is the facet count.
+void benchArrowSolid(benchmark::State &state)
+{
+  Mesh mesh;
+  for (auto _ : state)
+  {
+    mesh.clear();
+    arrow::solid(mesh.vertices, mesh.indices, mesh.normals, static_cast<unsigned>(state.range(0)),
+                 0.15f, 0.1f, 0.8f, 1.0f);
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  setCounters(state, mesh);
+}
+}  // namespace
+
+BENCHMARK(benchSphereSolid)->Arg(1)->Arg(3)->Arg(5);
+BENCHMARK(benchSphereLatLong)->Arg(16)->Arg(64);
+BENCHMARK(benchBoxSolid);
+BENCHMARK(benchCylinderSolid)->Arg(16)->Arg(128);
+BENCHMARK(benchConeSolid)->Arg(16)->Arg(128);
+BENCHMARK(benchCapsuleSolid)->Arg(16)->Arg(128);
+BENCHMARK(benchArrowSolid)->Arg(16)->Arg(128);
+}  // namespace tes
@@ -0,0 +1,32 @@
+//
+// author: Kazys Stepanas
+//
+#include "BenchViewer.h"
+
+#include <3esview/ThirdEyeScene.h>
+
+namespace tes::view
+{
+BenchViewer &BenchViewer::instance()
+{
+  static BenchViewer viewer;
+  return viewer;
+}
+
+
+BenchViewer::BenchViewer()
+  : _gl_context{ Magnum::Platform::WindowlessGLContext::Configuration{} }
+  , _context{ Magnum::NoCreate }
+{
+  _gl_context.makeCurrent();
+  _context.create();
+  _tes = std::make_shared<ThirdEyeScene>();
+}
+
+
+BenchViewer::~BenchViewer()
+{
+  // Release the scene while the context is still valid.
+  _tes.reset();
+}
+}  // namespace tes::view
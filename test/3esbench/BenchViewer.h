@@ -0,0 +1,41 @@
+//
+// author: Kazys Stepanas
+//
+#pragma once
+
+#include "3esbench/BenchViewerConfig.h"
+
+#include <Magnum/Platform/GLContext.h>
+
+#include <memory>
+
+namespace tes::view
+{
+class ThirdEyeScene;
+
+/// Hosts a windowless OpenGL context and a @c ThirdEyeScene for viewer benchmarks.
+///
+/// The context is created on first use and persists until exit. As for 3estViewer, benchmarks
+/// using the viewer must not run concurrently.
+class BenchViewer
+{
+public:
+  /// Query the shared benchmark viewer, creating it on first use.
+  /// @return The benchmark viewer.
+  static BenchViewer &instance();
+
+  /// Destructor.
+  ~BenchViewer();
+
+  /// Query the scene, with the OpenGL context current on the calling thread.
+  /// @return The scene.
+  [[nodiscard]] const std::shared_ptr<ThirdEyeScene> &tes() const { return _tes; }
+
+private:
+  BenchViewer();
+
+  Magnum::Platform::WindowlessGLContext _gl_context;
+  Magnum::Platform::GLContext _context;
+  std::shared_ptr<ThirdEyeScene> _tes;
+};
+}  // namespace tes::view
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <3escore/CoreConfig.h>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Platform/@WINDOWLESS_APP@.h>
@@ -3,20 +3,103 @@
 //
 #include "TestCommon.h"
 
+#include <3escore/BaseConnection.h>
 #include <3escore/ByteValue.h>
+#include <3escore/CollatedPacket.h>
+#include <3escore/CollatedPacketDecoder.h>
+#include <3escore/ConnectionMonitor.h>
 #include <3escore/IntArg.h>
+#include <3escore/Messages.h>
+#include <3escore/PacketBuffer.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketStreamReader.h>
+#include <3escore/PacketWriter.h>
 #include <3escore/Ptr.h>
+#include <3escore/ResourcePacketCache.h>
+#include <3escore/Server.h>
+#include <3escore/ServerUtil.h>
+#include <3escore/ShapeRegistry.h>
+#include <3escore/ShapeTimeline.h>
+#include <3escore/SharedMemoryRing.h>
+#include <3escore/TcpListenSocket.h>
+#include <3escore/TcpSocket.h>
 #include <3escore/V3Arg.h>
+#include <3escore/WriteBehindFile.h>
+#include <3escore/shapes/MeshShape.h>
+#include <3escore/shapes/PointCloud.h>
+#include <3escore/shapes/ProgressivePoints.h>
 #include <3escore/shapes/SimpleMesh.h>
+#include <3escore/shapes/Sphere.h>
+#include <3escore/tessellate/Cache.h>
 
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
 #include <iterator>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 namespace tes
 {
+/// A connection simulating a bandwidth limited link by sleeping in @c writeBytes() .
+class ThrottledConnection : public BaseConnection
+{
+public:
+  explicit ThrottledConnection(const ServerSettings &settings)
+    : BaseConnection(settings)
+  {}
+
+  void close() override {}
+  [[nodiscard]] const char *address() const override { return "throttled"; }
+  [[nodiscard]] uint16_t port() const override { return 0; }
+  [[nodiscard]] bool isConnected() const override { return true; }
+
+  /// Set the simulated link rate in bytes per second. Zero for unlimited.
+  ///
+  /// Writes do not block, but report the time the link would have blocked as send latency.
+  void setRate(double bytes_per_second) { _rate = bytes_per_second; }
+  [[nodiscard]] uint64_t bytesWritten() const { return _bytes_written; }
+
+  /// Enable keeping a copy of the written bytes, available from @c written() .
+  void setCapture(bool capture) { _capture = capture; }
+  [[nodiscard]] const std::vector<uint8_t> &written() const { return _written; }
+
+protected:
+  int writeBytes(const uint8_t *data, int byte_count) override
+  {
+    _bytes_written += static_cast<uint64_t>(byte_count);
+    if (_capture)
+    {
+      _written.insert(_written.end(), data, data + byte_count);
+    }
+    if (_rate > 0)
+    {
+      addWriteLatency(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(byte_count / _rate)));
+    }
+    return byte_count;
+  }
+
+private:
+  double _rate = 0;
+  uint64_t _bytes_written = 0;
+  std::vector<uint8_t> _written;
+  bool _capture = false;
+};
+
 template <typename DSTINT, typename SRCINT>
 void TestIntArg(SRCINT value)
 {
@@ -249,4 +332,1706 @@ TEST(Core, ByteValue)
     fractional = ByteValue(half, static_cast<ByteUnit>(i)).bytes();
   }
 }
+
+
+TEST(Core, TessellationCache)
+{
+  auto &cache = tessellate::Cache::instance();
+  for (unsigned s = 0; s < static_cast<unsigned>(tessellate::CachedShape::Count); ++s)
+  {
+    const auto shape = static_cast<tessellate::CachedShape>(s);
+    size_t previous_vertex_count = 0;
+    for (unsigned lod = 0; lod < tessellate::Cache::kLodCount; ++lod)
+    {
+      const auto mesh = cache.solid(shape, lod);
+      ASSERT_NE(mesh, nullptr);
+      EXPECT_FALSE(mesh->vertices.empty());
+      EXPECT_EQ(mesh->vertices.size(), mesh->normals.size());
+      EXPECT_EQ(mesh->indices.size() % 3, 0u);
+      // Repeated requests must share the same buffers.
+      EXPECT_EQ(mesh, cache.solid(shape, lod));
+      // Each LOD must not be more detailed than the last.
+      if (lod > 0)
+      {
+        EXPECT_LE(mesh->vertices.size(), previous_vertex_count);
+      }
+      previous_vertex_count = mesh->vertices.size();
+    }
+    // Out of range LOD is clamped.
+    EXPECT_EQ(cache.solid(shape, tessellate::Cache::kLodCount),
+              cache.solid(shape, tessellate::Cache::kLodCount - 1));
+  }
+}
+
+TEST(Core, SharedMemoryRing)
+{
+  const std::string name = "/3es-unit-test-ring";
+  // Use a small ring to exercise wrapping and blocking on a full ring.
+  auto writer = SharedMemoryRing::create(name, 1u);
+  if (!writer)
+  {
+    GTEST_SKIP() << "Shared memory not supported";
+  }
+  EXPECT_TRUE(writer->isWriter());
+  EXPECT_FALSE(writer->readerAttached());
+
+  auto reader = SharedMemoryRing::open(name);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_FALSE(reader->isWriter());
+  EXPECT_TRUE(writer->readerAttached());
+  EXPECT_EQ(reader->capacity(), writer->capacity());
+  // Only one reader may attach.
+  EXPECT_EQ(SharedMemoryRing::open(name), nullptr);
+
+  constexpr size_t kTotalBytes = 1024u * 1024u;
+  std::thread write_thread([&writer] {
+    std::vector<uint8_t> chunk;
+    size_t written = 0;
+    unsigned chunk_size = 1;
+    while (written < kTotalBytes)
+    {
+      chunk.resize(std::min<size_t>(chunk_size, kTotalBytes - written));
+      for (size_t i = 0; i < chunk.size(); ++i)
+      {
+        chunk[i] = static_cast<uint8_t>((written + i) % 251u);
+      }
+      ASSERT_EQ(writer->write(chunk.data(), static_cast<int>(chunk.size()), 5000u),
+                static_cast<int>(chunk.size()));
+      written += chunk.size();
+      chunk_size = (chunk_size * 7u) % 1531u + 1u;
+    }
+    writer->close();
+  });
+
+  std::vector<uint8_t> buffer(777u);
+  size_t read = 0;
+  bool sequence_ok = true;
+  while (reader->isConnected())
+  {
+    const int bytes = reader->read(buffer.data(), static_cast<int>(buffer.size()), 100u);
+    for (int i = 0; i < bytes; ++i)
+    {
+      sequence_ok = sequence_ok && buffer[i] == static_cast<uint8_t>((read + i) % 251u);
+    }
+    read += static_cast<size_t>(std::max(bytes, 0));
+  }
+
+  write_thread.join();
+  EXPECT_TRUE(sequence_ok);
+  EXPECT_EQ(read, kTotalBytes);
+  EXPECT_EQ(reader->read(buffer.data(), static_cast<int>(buffer.size()), 0), -1);
+}
+
+
+TEST(Core, SharedMemoryServer)
+{
+  ServerInfoMessage info;
+  initDefaultServerInfo(&info);
+  ServerSettings settings(SFNakedFrameMessage | SFSharedMemory);
+  settings.port_range = 1000;
+  auto server = Server::create(settings, &info);
+  ASSERT_TRUE(server->connectionMonitor()->start(ConnectionMode::Synchronous));
+
+  auto reader =
+    SharedMemoryRing::open(SharedMemoryRing::nameForPort(server->connectionMonitor()->port()));
+  if (!reader)
+  {
+    server->connectionMonitor()->stop();
+    GTEST_SKIP() << "Shared memory not supported";
+  }
+
+  server->connectionMonitor()->monitorConnections();
+  server->connectionMonitor()->commitConnections();
+  ASSERT_EQ(server->connectionCount(), 1u);
+
+  const Sphere sphere(Id(42u), Spherical(Vector3f(1, 2, 3), 1.5f));
+  server->create(sphere);
+  server->updateFrame(0.0f, true);
+
+  // Expect the server info, the sphere creation and the end of frame.
+  PacketBuffer packet_buffer;
+  std::vector<uint8_t> read_buffer(2048u);
+  std::vector<uint8_t> packet_bytes;
+  bool have_server_info = false;
+  bool have_create = false;
+  bool have_frame = false;
+  const auto start_time = std::chrono::steady_clock::now();
+  while (!have_frame && std::chrono::steady_clock::now() - start_time < std::chrono::seconds(5))
+  {
+    const int bytes = reader->read(read_buffer.data(), static_cast<int>(read_buffer.size()), 10u);
+    if (bytes <= 0)
+    {
+      continue;
+    }
+    packet_buffer.addBytes(read_buffer.data(), static_cast<size_t>(bytes));
+    while (const PacketHeader *header = packet_buffer.extractPacket(packet_bytes))
+    {
+      const PacketReader packet(header);
+      have_server_info = have_server_info || packet.routingId() == MtServerInfo;
+      have_create = have_create || (packet.routingId() == sphere.routingId() &&
+                                    packet.messageId() == OIdCreate);
+      have_frame = packet.routingId() == MtControl && packet.messageId() == CIdFrame;
+    }
+  }
+
+  EXPECT_TRUE(have_server_info);
+  EXPECT_TRUE(have_create);
+  EXPECT_TRUE(have_frame);
+
+  // Detaching the reader expires the connection.
+  reader->close();
+  server->connectionMonitor()->monitorConnections();
+  server->connectionMonitor()->commitConnections();
+  EXPECT_EQ(server->connectionCount(), 0u);
+
+  server->close();
+  server->connectionMonitor()->stop();
+  server->connectionMonitor()->join();
+}
+
+
+TEST(Core, AdaptiveConnection)
+{
+  ServerSettings settings(SFCollate | SFAdaptive);
+  settings.target_latency_ms = 2;
+  ThrottledConnection connection(settings);
+  // 4MB/s: a 24KB point cloud per frame reports ~6ms of send latency.
+  connection.setRate(4e6);
+
+  std::vector<Vector3f> points(2000u);
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    points[i] = Vector3f(static_cast<float>(i), 0.5f * static_cast<float>(i), 1.0f);
+  }
+  const MeshShape cloud(DrawType::Points, Id(), DataBuffer(points));
+
+  const auto sendFrame = [&connection, &cloud]() {
+    const uint64_t start_bytes = connection.bytesWritten();
+    connection.create(cloud);
+    connection.updateTransfers(0);
+    connection.updateFrame(0.0f, true);
+    return connection.bytesWritten() - start_bytes;
+  };
+
+  const uint64_t full_frame_bytes = sendFrame();
+  EXPECT_EQ(connection.stats().adaptive_level, 0u);
+
+  // Saturate the link until we reach point decimation.
+  for (int i = 0; i < 100 && connection.stats().point_decimation < 2; ++i)
+  {
+    sendFrame();
+  }
+
+  ConnectionStats stats = connection.stats();
+  EXPECT_GE(stats.adaptive_level, 3u);
+  EXPECT_GE(stats.point_decimation, 2u);
+  EXPECT_GT(stats.throughput, 0.0);
+  EXPECT_GT(stats.transfer_byte_limit, 0u);
+  EXPECT_GT(stats.bytes_sent, full_frame_bytes);
+#ifdef TES_ZLIB
+  EXPECT_NE(stats.compression_level, CompressionLevel::None);
+#endif  // TES_ZLIB
+  EXPECT_LT(sendFrame(), full_frame_bytes / 2);
+
+  // Open the link and expect full quality to be restored.
+  connection.setRate(0);
+  for (int i = 0; i < 1000 && connection.stats().adaptive_level > 0; ++i)
+  {
+    sendFrame();
+  }
+
+  stats = connection.stats();
+  EXPECT_EQ(stats.adaptive_level, 0u);
+  EXPECT_EQ(stats.point_decimation, 1u);
+  EXPECT_EQ(stats.transfer_byte_limit, 0u);
+  EXPECT_EQ(stats.compression_level, CompressionLevel::None);
+}
+
+
+TEST(Core, CollationFlushPolicy)
+{
+  const Sphere sphere(Id(1), Spherical(Vector3f(1, 2, 3), 1.0f));
+
+  // Size limit: flush before the collation buffer is full.
+  {
+    ServerSettings settings(SFCollate);
+    settings.flush_policy.max_bytes = 256;
+    ThrottledConnection connection(settings);
+    for (int i = 0; i < 8; ++i)
+    {
+      connection.create(sphere);
+    }
+    EXPECT_GT(connection.bytesWritten(), 0u);
+    EXPECT_LT(connection.bytesWritten(), 8u * 256u);
+  }
+
+  // Age limit: nothing is sent until the pending packet is old enough.
+  {
+    ServerSettings settings(SFCollate);
+    settings.flush_policy.max_age_us = 2000;
+    ThrottledConnection connection(settings);
+    // Bracket the collation start time so the checks do not depend on the test's timing.
+    const auto before = std::chrono::steady_clock::now();
+    connection.create(sphere);
+    const auto after = std::chrono::steady_clock::now();
+    EXPECT_EQ(connection.bytesWritten(), 0u);
+    EXPECT_FALSE(connection.flushExpired(before));
+    EXPECT_EQ(connection.bytesWritten(), 0u);
+    EXPECT_TRUE(connection.flushExpired(after + std::chrono::microseconds(2000)));
+    EXPECT_GT(connection.bytesWritten(), 0u);
+    EXPECT_FALSE(connection.flushExpired(after + std::chrono::milliseconds(10)));
+  }
+
+  // Collate across frames.
+  {
+    ServerSettings settings(SFCollate);
+    settings.flush_policy.end_of_frame = false;
+    ThrottledConnection connection(settings);
+    connection.create(sphere);
+    connection.updateFrame(0.0f, true);
+    EXPECT_EQ(connection.bytesWritten(), 0u);
+  }
+}
+
+
+TEST(Core, SendCollated)
+{
+  // Collate a regular packet, an extended packet and a packet without a CRC.
+  std::vector<uint8_t> buffer(1024u);
+  std::vector<uint8_t> expected;
+  CollatedPacket collated(false);
+  PacketWriter writer(buffer.data(), static_cast<uint16_t>(buffer.size()));
+  for (unsigned i = 0; i < 3u; ++i)
+  {
+    writer.setExtended(i == 1u);
+    writer.reset(SIdSphere, OIdData);
+    for (uint32_t value = 0; value < 10u * (i + 1u); ++value)
+    {
+      writer.writeElement(value);
+    }
+    writer.finalise();
+    if (i == 2u)
+    {
+      writer.packet().flags = static_cast<uint8_t>(writer.packet().flags | PFNoCrc);
+    }
+    const PacketReader reader(&writer.packet());
+    const auto *bytes = writer.data();
+    expected.insert(expected.end(), bytes, bytes + reader.packetSize());
+    ASSERT_GT(collated.add(bytes, reader.packetSize()), 0);
+  }
+  ASSERT_TRUE(collated.finalise());
+
+  // Sending a collated packet sends each packet in turn.
+  ThrottledConnection connection(ServerSettings(0u));
+  connection.setCapture(true);
+  EXPECT_GT(connection.send(collated), 0);
+  EXPECT_EQ(connection.written(), expected);
+
+  // A truncated extended packet is rejected.
+  CollatedPacket truncated(false);
+  writer.setExtended(true);
+  writer.reset(SIdSphere, OIdData);
+  writer.writeElement(uint32_t(0u));
+  writer.finalise();
+  ASSERT_GT(truncated.add(writer.data(), sizeof(PacketHeader) + 2u), 0);
+  ASSERT_TRUE(truncated.finalise());
+  ThrottledConnection rejected(ServerSettings(0u));
+  EXPECT_EQ(rejected.send(truncated), -1);
+  EXPECT_EQ(rejected.bytesWritten(), 0u);
+}
+
+
+TEST(Core, CollateExtended)
+{
+  // Decode the packets written to a connection, returning the collated packet headers and the
+  // number of sphere create messages found within them.
+  struct Decoded
+  {
+    std::vector<PacketHeader> collated;
+    unsigned created = 0;
+  };
+  const auto decode = [](const std::vector<uint8_t> &bytes) {
+    Decoded decoded;
+    PacketBuffer packet_buffer;
+    packet_buffer.addBytes(bytes.data(), bytes.size());
+    std::vector<uint8_t> packet_data;
+    CollatedPacketDecoder decoder;
+    while (const PacketHeader *header = packet_buffer.extractPacket(packet_data))
+    {
+      const PacketReader reader(header);
+      if (reader.routingId() == MtCollatedPacket)
+      {
+        decoded.collated.emplace_back(*header);
+      }
+      EXPECT_TRUE(decoder.setPacket(header));
+      while (const PacketHeader *packet = decoder.next())
+      {
+        const PacketReader nested(packet);
+        if (nested.routingId() == SIdSphere && nested.messageId() == OIdCreate)
+        {
+          ++decoded.created;
+        }
+      }
+    }
+    return decoded;
+  };
+
+  constexpr unsigned kShapeCount = 4000u;
+  constexpr uint32_t kMaxBytes = 256u * 1024u;
+
+  // With extended packets, the flush policy may collate beyond 64 KiB.
+  for (const bool compress : { false, true })
+  {
+    ServerSettings settings(SFCollate | SFExtendedPackets | (compress ? SFCompress : 0u));
+    settings.flush_policy.max_bytes = kMaxBytes;
+    ThrottledConnection connection(settings);
+    connection.setCapture(true);
+    unsigned collated_bytes = 0;
+    for (unsigned i = 0; i < kShapeCount; ++i)
+    {
+      const int wrote = connection.create(
+        Sphere(Id(i + 1u), Spherical(Vector3f(static_cast<float>(i), 2, 3), 1.0f)));
+      ASSERT_GT(wrote, 0);
+      collated_bytes += static_cast<unsigned>(wrote);
+    }
+    ASSERT_GT(collated_bytes, CollatedPacket::kMaxPacketSize);
+    connection.updateFrame(0.0f, true);
+
+    const auto decoded = decode(connection.written());
+    EXPECT_EQ(decoded.created, kShapeCount);
+    ASSERT_FALSE(decoded.collated.empty());
+    // The first packet collates the create messages, exceeding the classic packet limit.
+    const PacketReader first(&decoded.collated.front());
+    EXPECT_TRUE(first.isExtended());
+    EXPECT_EQ(first.versionMinor(), kPacketExtendedVersionMinor);
+    if (!compress)
+    {
+      EXPECT_GT(first.payloadSize(), CollatedPacket::kMaxPacketSize);
+    }
+  }
+
+  // Without extended packets, collated packets stay within the 16-bit payload size.
+  {
+    ServerSettings settings(SFCollate);
+    settings.flush_policy.max_bytes = kMaxBytes;
+    ThrottledConnection connection(settings);
+    connection.setCapture(true);
+    for (unsigned i = 0; i < kShapeCount; ++i)
+    {
+      ASSERT_GT(connection.create(
+                  Sphere(Id(i + 1u), Spherical(Vector3f(static_cast<float>(i), 2, 3), 1.0f))),
+                0);
+    }
+    connection.updateFrame(0.0f, true);
+
+    const auto decoded = decode(connection.written());
+    EXPECT_EQ(decoded.created, kShapeCount);
+    EXPECT_GT(decoded.collated.size(), 1u);
+    for (const auto &header : decoded.collated)
+    {
+      const PacketReader reader(&header);
+      EXPECT_FALSE(reader.isExtended());
+      EXPECT_EQ(reader.versionMinor(), kPacketVersionMinor);
+    }
+  }
+
+  // A large transaction packet is finalised as an extended packet and still sent message by
+  // message.
+  CollatedPacket transaction(1024u * 1024u, 1024u * 1024u);
+  for (unsigned i = 0; i < kShapeCount; ++i)
+  {
+    ASSERT_GT(
+      transaction.create(Sphere(Id(i + 1u), Spherical(Vector3f(static_cast<float>(i), 2, 3)))), 0);
+  }
+  ASSERT_TRUE(transaction.finalise());
+  unsigned transaction_bytes = 0;
+  const PacketReader transaction_reader(
+    reinterpret_cast<const PacketHeader *>(transaction.buffer(transaction_bytes)));
+  EXPECT_TRUE(transaction_reader.isExtended());
+  EXPECT_EQ(transaction_reader.packetSize(), transaction_bytes);
+  ThrottledConnection connection(ServerSettings(0u));
+  connection.setCapture(true);
+  EXPECT_GT(connection.send(transaction), 0);
+  const auto decoded = decode(connection.written());
+  EXPECT_EQ(decoded.created, kShapeCount);
+  EXPECT_TRUE(decoded.collated.empty());
+}
+
+
+TEST(Core, ResourceTransferOrder)
+{
+  const auto large_mesh = std::make_shared<SimpleMesh>(1u, 20000u, 0u, DrawType::Points,
+                                                       MeshComponentFlag::Vertex);
+  const auto small_mesh = std::make_shared<SimpleMesh>(2u, 3u, 0u, DrawType::Points,
+                                                       MeshComponentFlag::Vertex);
+
+  // Reference the large mesh first, then send a single packet and report which started.
+  const auto firstTransfer = [&](ResourceOrder order, int large_priority) {
+    ServerSettings settings(0u);
+    settings.resource_order = order;
+    ThrottledConnection connection(settings);
+    connection.resourceCache()->setPriority(large_mesh->uniqueKey(), large_priority);
+    connection.referenceResource(large_mesh);
+    connection.referenceResource(small_mesh);
+    connection.updateTransfers(1u);
+    uint64_t first_key = 0;
+    for (const auto &transfer : connection.resourceTransfers())
+    {
+      if (transfer.bytes_sent)
+      {
+        EXPECT_EQ(first_key, 0u);
+        first_key = transfer.resource_key;
+      }
+    }
+    return first_key;
+  };
+
+  EXPECT_EQ(firstTransfer(ResourceOrder::Fifo, 0), large_mesh->uniqueKey());
+  EXPECT_EQ(firstTransfer(ResourceOrder::SmallestFirst, 0), small_mesh->uniqueKey());
+  EXPECT_EQ(firstTransfer(ResourceOrder::RecentFirst, 0), small_mesh->uniqueKey());
+  // User priority overrides the ordering policy.
+  EXPECT_EQ(firstTransfer(ResourceOrder::SmallestFirst, 1), large_mesh->uniqueKey());
+}
+
+
+TEST(Core, ResourceTransferRequeue)
+{
+  std::vector<std::shared_ptr<SimpleMesh>> meshes;
+  for (uint32_t i = 0; i < 3u; ++i)
+  {
+    meshes.emplace_back(
+      std::make_shared<SimpleMesh>(i + 1u, 3u, 0u, DrawType::Points, MeshComponentFlag::Vertex));
+  }
+
+  // Reference each mesh, then re-reference the first and report the order the meshes are sent.
+  const auto transferOrder = [&](ResourceOrder order, int requeue_priority) {
+    ServerSettings settings(0u);
+    settings.resource_order = order;
+    ThrottledConnection connection(settings);
+    for (const auto &mesh : meshes)
+    {
+      connection.referenceResource(mesh);
+    }
+    connection.resourceCache()->setPriority(meshes[0]->uniqueKey(), requeue_priority);
+    // Repeated references only keep the latest queue entry.
+    for (unsigned i = 0; i < 200u; ++i)
+    {
+      connection.referenceResource(meshes[0]);
+    }
+
+    std::vector<uint64_t> sent;
+    while (sent.size() < meshes.size())
+    {
+      connection.updateTransfers(1u);
+      for (const auto &transfer : connection.resourceTransfers())
+      {
+        if (transfer.sent &&
+            std::find(sent.begin(), sent.end(), transfer.resource_key) == sent.end())
+        {
+          sent.emplace_back(transfer.resource_key);
+        }
+      }
+    }
+    EXPECT_EQ(connection.resourceTransfers().size(), meshes.size());
+    return sent;
+  };
+
+  const std::vector<uint64_t> first_order = { meshes[0]->uniqueKey(), meshes[1]->uniqueKey(),
+                                              meshes[2]->uniqueKey() };
+  const std::vector<uint64_t> last_order = { meshes[1]->uniqueKey(), meshes[2]->uniqueKey(),
+                                             meshes[0]->uniqueKey() };
+  const std::vector<uint64_t> recent_order = { meshes[0]->uniqueKey(), meshes[2]->uniqueKey(),
+                                               meshes[1]->uniqueKey() };
+  // Re-referencing keeps the first reference position.
+  EXPECT_EQ(transferOrder(ResourceOrder::Fifo, 0), first_order);
+  // Re-referencing makes a resource the most recent.
+  EXPECT_EQ(transferOrder(ResourceOrder::RecentFirst, 0), recent_order);
+  // A priority set after the first reference applies from the next reference.
+  EXPECT_EQ(transferOrder(ResourceOrder::Fifo, -1), last_order);
+  EXPECT_EQ(transferOrder(ResourceOrder::SmallestFirst, -1), last_order);
+}
+
+
+TEST(Core, ResourceTransferSharedCache)
+{
+  const auto mesh = std::make_shared<SimpleMesh>(1u, 20000u, 0u, DrawType::Points,
+                                                 MeshComponentFlag::Vertex);
+  const ServerSettings settings(0u);
+  const auto cache = std::make_shared<ResourcePacketCache>(settings.client_buffer_size);
+  ThrottledConnection first(settings);
+  ThrottledConnection late_joiner(settings);
+  first.setResourceCache(cache);
+  late_joiner.setResourceCache(cache);
+
+  first.referenceResource(mesh);
+  first.updateTransfers(0);
+  auto packed = cache->acquire(mesh);
+  EXPECT_EQ(cache->size(), 1u);
+
+  late_joiner.referenceResource(mesh);
+  late_joiner.updateTransfers(0);
+  // Both connections send the same, single packed copy.
+  EXPECT_EQ(cache->acquire(mesh), packed);
+  EXPECT_EQ(first.bytesWritten(), late_joiner.bytesWritten());
+  EXPECT_EQ(first.bytesWritten(), packed->byteCount());
+
+  for (const auto *connection : { &first, &late_joiner })
+  {
+    const auto transfers = connection->resourceTransfers();
+    ASSERT_EQ(transfers.size(), 1u);
+    EXPECT_TRUE(transfers[0].sent);
+    EXPECT_EQ(transfers[0].bytes_sent, packed->byteCount());
+    EXPECT_EQ(transfers[0].byte_count, packed->byteCount());
+    EXPECT_EQ(connection->stats().resources_sent, 1u);
+  }
+
+  // Releasing all references expires the cache entry.
+  first.releaseResource(mesh);
+  late_joiner.releaseResource(mesh);
+  packed.reset();
+  EXPECT_EQ(cache->size(), 0u);
+}
+
+
+TEST(Core, ExtendedPackets)
+{
+  // Round trip a payload larger than the 16-bit limit.
+  constexpr uint32_t kValueCount = 50000u;
+  std::vector<uint32_t> values(kValueCount);
+  for (uint32_t i = 0; i < kValueCount; ++i)
+  {
+    values[i] = i * 7u;
+  }
+
+  std::vector<uint8_t> buffer(256u * 1024u);
+  PacketWriter writer(buffer.data(), buffer.size(), MtMesh, MmtVertex);
+  EXPECT_EQ(writer.maxPayloadSize(), 0xffffu);
+  ASSERT_TRUE(writer.setExtended(true));
+  EXPECT_GT(writer.maxPayloadSize(), 0xffffu);
+  EXPECT_EQ(writer.writeArray(values.data(), values.size()), values.size());
+  ASSERT_TRUE(writer.finalise());
+  EXPECT_TRUE(writer.isExtended());
+  EXPECT_EQ(writer.payloadSize(), kValueCount * sizeof(uint32_t));
+  EXPECT_EQ(writer.packetSize(), sizeof(PacketHeader) + kExtendedPayloadSizeBytes +
+                                   kValueCount * sizeof(uint32_t) + sizeof(PacketWriter::CrcType));
+
+  // Extract from small reads, which split the header and the extended size.
+  PacketBuffer packet_buffer;
+  std::vector<uint8_t> packet_data;
+  const PacketHeader *extracted = nullptr;
+  constexpr size_t kChunkSize = 7u;
+  for (size_t offset = 0; offset < writer.packetSize() && !extracted; offset += kChunkSize)
+  {
+    packet_buffer.addBytes(writer.data() + offset,
+                           std::min<size_t>(kChunkSize, writer.packetSize() - offset));
+    extracted = packet_buffer.extractPacket(packet_data);
+  }
+  ASSERT_NE(extracted, nullptr);
+  PacketReader reader(extracted);
+  EXPECT_TRUE(reader.checkCrc());
+  EXPECT_EQ(reader.routingId(), MtMesh);
+  EXPECT_EQ(reader.payloadSize(), writer.payloadSize());
+  std::vector<uint32_t> read_values(kValueCount);
+  EXPECT_EQ(reader.readArray(read_values.data(), read_values.size()), read_values.size());
+  EXPECT_EQ(read_values, values);
+
+  // Transfer a resource using extended packets.
+  constexpr unsigned kVertexCount = 200000u;
+  SimpleMesh mesh(1u, kVertexCount, 0u, DrawType::Points, MeshComponentFlag::Vertex);
+  for (unsigned i = 0; i < kVertexCount; ++i)
+  {
+    mesh.setVertex(i, Vector3f(static_cast<float>(i), 0.5f * static_cast<float>(i), 1.0f));
+  }
+
+  ServerSettings settings(SFExtendedPackets);
+  const PackedResource classic(mesh, settings.client_buffer_size);
+  const PackedResource extended(mesh, settings.resourcePacketSize());
+  EXPECT_LT(extended.packetCount() * 4u, classic.packetCount());
+  EXPECT_LT(extended.byteCount(), classic.byteCount());
+
+  SimpleMesh received(1u, 0u, 0u, DrawType::Points, MeshComponentFlag::Vertex);
+  for (size_t i = 0; i < extended.packetCount(); ++i)
+  {
+    uint32_t byte_count = 0;
+    const uint8_t *bytes = extended.packet(i, byte_count);
+    PacketReader packet(reinterpret_cast<const PacketHeader *>(bytes));
+    ASSERT_EQ(packet.packetSize(), byte_count);
+    EXPECT_TRUE(packet.isExtended());
+    EXPECT_TRUE(packet.checkCrc());
+    switch (packet.messageId())
+    {
+    case MmtCreate:
+      EXPECT_TRUE(received.readCreate(packet));
+      break;
+    case MmtFinalise:
+      break;
+    default:
+      EXPECT_TRUE(received.readTransfer(packet.messageId(), packet));
+      break;
+    }
+  }
+
+  ASSERT_EQ(received.vertexCount(), kVertexCount);
+  const DataBuffer sent_vertices = mesh.vertices(0);
+  const DataBuffer received_vertices = received.vertices(0);
+  for (unsigned i = 0; i < kVertexCount; ++i)
+  {
+    ASSERT_EQ(received_vertices.get<float>(i, 1), sent_vertices.get<float>(i, 1));
+  }
+
+  // Connections only accept an extended cache with extended packets enabled.
+  const auto cache = std::make_shared<ResourcePacketCache>(settings.resourcePacketSize());
+  ThrottledConnection extended_connection(settings);
+  extended_connection.setResourceCache(cache);
+  EXPECT_EQ(extended_connection.resourceCache(), cache);
+  ThrottledConnection classic_connection(ServerSettings(0u));
+  classic_connection.setResourceCache(cache);
+  EXPECT_NE(classic_connection.resourceCache(), cache);
+}
+
+
+TEST(Core, PacketVersion)
+{
+  // Read back the versions of the packets written to a connection.
+  const auto read_versions = [](const std::vector<uint8_t> &bytes) {
+    std::vector<std::pair<uint16_t, uint16_t>> versions;
+    PacketBuffer packet_buffer;
+    packet_buffer.addBytes(bytes.data(), bytes.size());
+    std::vector<uint8_t> packet_data;
+    while (const PacketHeader *header = packet_buffer.extractPacket(packet_data))
+    {
+      const PacketReader reader(header);
+      versions.emplace_back(reader.versionMajor(), reader.versionMinor());
+    }
+    return versions;
+  };
+  const std::pair<uint16_t, uint16_t> classic_version = { kPacketVersionMajor,
+                                                          kPacketVersionMinor };
+  const std::pair<uint16_t, uint16_t> extended_version = { kPacketVersionMajor,
+                                                           kPacketExtendedVersionMinor };
+  EXPECT_EQ(classic_version, std::make_pair(uint16_t(0u), uint16_t(4u)));
+
+  // A stream without extended packets remains readable by older clients.
+  ServerInfoMessage info = {};
+  initDefaultServerInfo(&info);
+  const Sphere sphere(Id(1u), Spherical(Vector3f(1, 2, 3), 1.0f));
+  ThrottledConnection classic_connection(ServerSettings(0u));
+  classic_connection.setCapture(true);
+  ASSERT_TRUE(classic_connection.sendServerInfo(info));
+  ASSERT_GT(classic_connection.create(sphere), 0);
+  ASSERT_GT(classic_connection.updateFrame(0.0f), 0);
+  const auto classic_versions = read_versions(classic_connection.written());
+  ASSERT_EQ(classic_versions.size(), 3u);
+  for (const auto &version : classic_versions)
+  {
+    EXPECT_EQ(version, classic_version);
+  }
+
+  // A server with extended packets marks its server info, but not its small messages.
+  ThrottledConnection extended_connection{ ServerSettings(SFExtendedPackets) };
+  extended_connection.setCapture(true);
+  ASSERT_TRUE(extended_connection.sendServerInfo(info));
+  ASSERT_GT(extended_connection.create(sphere), 0);
+  const auto extended_versions = read_versions(extended_connection.written());
+  ASSERT_EQ(extended_versions.size(), 2u);
+  EXPECT_EQ(extended_versions[0], extended_version);
+  EXPECT_EQ(extended_versions[1], classic_version);
+
+  // Only extended packets take the newer version, and version overrides last until reset.
+  std::vector<uint8_t> buffer(1024u);
+  PacketWriter writer(buffer.data(), buffer.size(), MtMesh, MmtVertex);
+  EXPECT_EQ(writer.versionMinor(), kPacketVersionMinor);
+  ASSERT_TRUE(writer.setExtended(true));
+  EXPECT_EQ(writer.versionMinor(), kPacketExtendedVersionMinor);
+  ASSERT_TRUE(writer.setExtended(false));
+  EXPECT_EQ(writer.versionMinor(), kPacketVersionMinor);
+  writer.setVersion(kPacketVersionMajor, kPacketExtendedVersionMinor);
+  EXPECT_EQ(writer.versionMinor(), kPacketExtendedVersionMinor);
+  writer.reset(MtMesh, MmtVertex);
+  EXPECT_EQ(writer.versionMinor(), kPacketVersionMinor);
+
+  // Readers accept versions from the compatibility version to the extended version.
+  const auto next = [](uint16_t version) { return static_cast<uint16_t>(version + 1u); };
+  const auto previous = [](uint16_t version) { return static_cast<uint16_t>(version - 1u); };
+  EXPECT_TRUE(packetVersionCompatible(kPacketCompatibilityVersionMajor,
+                                      kPacketCompatibilityVersionMinor));
+  EXPECT_TRUE(packetVersionCompatible(kPacketVersionMajor, kPacketVersionMinor));
+  EXPECT_TRUE(packetVersionCompatible(kPacketVersionMajor, kPacketExtendedVersionMinor));
+  EXPECT_FALSE(packetVersionCompatible(kPacketVersionMajor, next(kPacketExtendedVersionMinor)));
+  EXPECT_FALSE(packetVersionCompatible(kPacketCompatibilityVersionMajor,
+                                       previous(kPacketCompatibilityVersionMinor)));
+  EXPECT_FALSE(packetVersionCompatible(next(kPacketVersionMajor), 0u));
+}
+
+
+TEST(Core, CorruptPacketHeaders)
+{
+  using Packet = std::vector<uint8_t>;
+  std::vector<uint8_t> buffer(1024u);
+  const auto make_packet = [&buffer](uint16_t message_id, bool extended) {
+    PacketWriter writer(buffer.data(), static_cast<uint16_t>(buffer.size()), SIdSphere,
+                        message_id);
+    writer.setExtended(extended);
+    for (uint32_t i = 0; i < 8u; ++i)
+    {
+      writer.writeElement(i);
+    }
+    writer.finalise();
+    return Packet(writer.data(), writer.data() + writer.packetSize());
+  };
+
+  const Packet first = make_packet(1u, false);
+  const Packet last = make_packet(2u, true);
+  // A payload offset which does not match the packet format.
+  Packet bad_offset = make_packet(3u, false);
+  reinterpret_cast<PacketHeader *>(bad_offset.data())->payload_offset = 7u;
+  Packet bad_extended_offset = make_packet(4u, true);
+  reinterpret_cast<PacketHeader *>(bad_extended_offset.data())->payload_offset = 0u;
+  // An extended payload size over the limit. Only the header and size are present.
+  Packet oversized = make_packet(5u, true);
+  oversized.resize(sizeof(PacketHeader) + kExtendedPayloadSizeBytes);
+  const uint32_t oversized_size = networkEndianSwapValue(kDefaultMaxExtendedPayloadSize + 1u);
+  std::memcpy(oversized.data() + sizeof(PacketHeader), &oversized_size, sizeof(oversized_size));
+
+  Packet stream;
+  for (const auto &packet : { first, bad_offset, bad_extended_offset, oversized, last })
+  {
+    stream.insert(stream.end(), packet.begin(), packet.end());
+  }
+
+  // Corrupt headers are skipped, resyncing on the following packet.
+  const std::vector<uint16_t> expected_ids = { 1u, 2u };
+  {
+    PacketBuffer packet_buffer;
+    packet_buffer.addBytes(stream);
+    std::vector<uint16_t> message_ids;
+    std::vector<uint8_t> packet_bytes;
+    while (const PacketHeader *header = packet_buffer.extractPacket(packet_bytes))
+    {
+      message_ids.emplace_back(PacketReader(header).messageId());
+    }
+    EXPECT_EQ(message_ids, expected_ids);
+  }
+
+  {
+    std::istringstream in(std::string(stream.begin(), stream.end()));
+    PacketStreamReader reader(in);
+    std::vector<uint16_t> message_ids;
+    bool dropped = false;
+    for (int i = 0; i < 100 && reader.isOk(); ++i)
+    {
+      const auto [header, status, pos] = reader.extractPacket();
+      if (header)
+      {
+        message_ids.emplace_back(PacketReader(header).messageId());
+        dropped = dropped || status == PacketStreamReader::Status::Dropped;
+      }
+      else if (status == PacketStreamReader::Status::End)
+      {
+        break;
+      }
+    }
+    EXPECT_EQ(message_ids, expected_ids);
+    EXPECT_TRUE(dropped);
+  }
+
+  // The payload limit is configurable.
+  {
+    PacketBuffer packet_buffer;
+    packet_buffer.setMaxPayloadSize(16u);
+    packet_buffer.addBytes(last);
+    packet_buffer.addBytes(first);
+    std::vector<uint8_t> packet_bytes;
+    const PacketHeader *header = packet_buffer.extractPacket(packet_bytes);
+    ASSERT_NE(header, nullptr);
+    EXPECT_EQ(PacketReader(header).messageId(), 1u);
+  }
+
+  // Collated decoding stops at a corrupt header.
+  CollatedPacket collated(false);
+  for (const auto &packet : { first, bad_offset, last })
+  {
+    ASSERT_GT(collated.add(packet.data(), static_cast<uint32_t>(packet.size())), 0);
+  }
+  ASSERT_TRUE(collated.finalise());
+  unsigned collated_size = 0;
+  const auto *collated_header =
+    reinterpret_cast<const PacketHeader *>(collated.buffer(collated_size));
+  CollatedPacketDecoder decoder;
+  ASSERT_TRUE(decoder.setPacket(collated_header));
+  const PacketHeader *decoded = decoder.next();
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_EQ(PacketReader(decoded).messageId(), 1u);
+  EXPECT_EQ(decoder.next(), nullptr);
+  EXPECT_FALSE(decoder.decoding());
+
+  // Collated packets are also subject to the payload limit.
+  decoder.setMaxPayloadSize(16u);
+  EXPECT_FALSE(decoder.setPacket(collated_header));
+}
+
+
+TEST(Core, ProgressivePoints)
+{
+  // Octree levels: a single root point, one point for each other corner, then the duplicates.
+  std::vector<Vector3f> corners;
+  for (unsigned i = 0; i < 16u; ++i)
+  {
+    corners.emplace_back(Vector3f(float(i & 1u), float((i >> 1u) & 1u), float((i >> 2u) & 1u)));
+  }
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> level_ends;
+  ProgressivePoints::levelOrder(DataBuffer(corners), order, level_ends);
+  EXPECT_EQ(level_ends, std::vector<uint32_t>({ 1u, 8u, 16u }));
+  ASSERT_EQ(order.size(), corners.size());
+  std::vector<Vector3f> first_corners;
+  for (size_t i = 0; i < level_ends[1]; ++i)
+  {
+    first_corners.emplace_back(corners[order[i]]);
+  }
+  for (unsigned i = 0; i < 8u; ++i)
+  {
+    EXPECT_NE(std::find(first_corners.begin(), first_corners.end(), corners[i]),
+              first_corners.end());
+  }
+
+  // Pack a large cloud for progressive transfer.
+  constexpr unsigned kPointCount = 200000u;
+  PointCloud cloud(1u);
+  std::mt19937 rand_engine(42u);
+  std::uniform_real_distribution<float> rand(-10.0f, 10.0f);
+  for (unsigned i = 0; i < kPointCount; ++i)
+  {
+    cloud.addPoint(Vector3f(rand(rand_engine), rand(rand_engine), rand(rand_engine)),
+                   Vector3f(0, 0, 1), Colour(i * 997u));
+  }
+  ASSERT_TRUE(ProgressivePoints::canRefine(cloud));
+
+  // Each transfer level prefix is spread over the cloud.
+  const ProgressivePoints progressive(cloud, 1000u, 4u);
+  EXPECT_EQ(progressive.levelEnds(), std::vector<uint32_t>({ 1000u, 4000u, 16000u, 64000u,
+                                                             kPointCount }));
+  std::array<unsigned, 8> octant_counts = {};
+  const DataBuffer ordered_vertices = progressive.vertices();
+  for (unsigned i = 0; i < progressive.levelEnds().front(); ++i)
+  {
+    const unsigned octant = (ordered_vertices.get<float>(i, 0) >= 0 ? 1u : 0u) |
+                            (ordered_vertices.get<float>(i, 1) >= 0 ? 2u : 0u) |
+                            (ordered_vertices.get<float>(i, 2) >= 0 ? 4u : 0u);
+    ++octant_counts[octant];
+  }
+  for (const unsigned octant_count : octant_counts)
+  {
+    EXPECT_GT(octant_count, 100u);
+  }
+
+  ServerSettings settings(SFProgressivePoints);
+  settings.progressive_point_count = kPointCount / 2u;
+  EXPECT_EQ(ResourcePacketCache(settings.resourcePacketSize()).progressivePointCount(), 0u);
+  const PackedResource packed(cloud, settings.resourcePacketSize(),
+                              settings.progressivePointCount());
+  const PackedResource classic(cloud, settings.resourcePacketSize());
+
+  // Decode, noting the vertex count at each finalisation.
+  SimpleMesh received(1u, 0u, 0u, DrawType::Points,
+                      MeshComponentFlag::Vertex | MeshComponentFlag::Normal |
+                        MeshComponentFlag::Colour);
+  std::vector<unsigned> finalised_counts;
+  size_t first_finalise_bytes = 0;
+  size_t byte_count = 0;
+  for (size_t i = 0; i < packed.packetCount(); ++i)
+  {
+    uint32_t packet_size = 0;
+    const uint8_t *bytes = packed.packet(i, packet_size);
+    byte_count += packet_size;
+    PacketReader packet(reinterpret_cast<const PacketHeader *>(bytes));
+    ASSERT_TRUE(packet.checkCrc());
+    switch (packet.messageId())
+    {
+    case MmtCreate:
+      EXPECT_TRUE(received.readCreate(packet));
+      break;
+    case MmtRedefine: {
+      MeshRedefineMessage msg = {};
+      ObjectAttributesd attributes;
+      ASSERT_TRUE(msg.read(packet, attributes));
+      EXPECT_GT(msg.vertex_count, received.vertexCount());
+      received.setVertexCount(msg.vertex_count);
+      break;
+    }
+    case MmtFinalise:
+      finalised_counts.emplace_back(received.vertexCount());
+      first_finalise_bytes = (first_finalise_bytes) ? first_finalise_bytes : byte_count;
+      break;
+    default:
+      EXPECT_TRUE(received.readTransfer(packet.messageId(), packet));
+      break;
+    }
+  }
+
+  // The first level arrives after a fraction of the data, with levels refining to the full cloud.
+  ASSERT_GE(finalised_counts.size(), 2u);
+  EXPECT_EQ(finalised_counts.front(), ProgressivePoints::kDefaultBaseCount);
+  EXPECT_LT(first_finalise_bytes * 2u, packed.byteCount());
+  EXPECT_TRUE(std::is_sorted(finalised_counts.begin(), finalised_counts.end()));
+  EXPECT_EQ(finalised_counts.back(), kPointCount);
+  EXPECT_LT(classic.packetCount(), packed.packetCount());
+
+  // Compare the points regardless of order.
+  ASSERT_EQ(received.vertexCount(), kPointCount);
+  using Point = std::tuple<float, float, float, uint32_t>;
+  const auto sorted_points = [](const Vector3f *vertices, const auto &colour_at) {
+    std::vector<Point> points(kPointCount);
+    for (unsigned i = 0; i < kPointCount; ++i)
+    {
+      points[i] = { vertices[i].x(), vertices[i].y(), vertices[i].z(), colour_at(i) };
+    }
+    std::sort(points.begin(), points.end());
+    return points;
+  };
+  const auto sent = sorted_points(cloud.rawVertices(), [&cloud](unsigned i) {
+    return cloud.rawColours()[i].colour32();
+  });
+  const auto decoded = sorted_points(received.rawVertices(), [&received](unsigned i) {
+    return received.rawColours()[i];
+  });
+  EXPECT_TRUE(sent == decoded);
+}
+
+
+TEST(Core, StateCacheReplay)
+{
+  const char *file_name = "state-cache-replay.3es";
+  auto server = Server::create(ServerSettings(SFStateCache));
+
+  // Build the scene before there are any connections.
+  CategoryNameMessage category = {};
+  category.category_id = 3u;
+  category.default_active = 1u;
+  category.name = "replayed";
+  category.name_length = static_cast<uint16_t>(std::strlen(category.name));
+  sendMessage(*server, MtCategory, CategoryNameMessage::MessageId, category);
+
+  Sphere moved(Id(1u), Spherical(Vector3f(0, 0, 0), 1.0f));
+  const Sphere destroyed(Id(2u), Spherical(Vector3f(1, 0, 0), 1.0f));
+  const Sphere kept(Id(3u), Spherical(Vector3f(2, 0, 0), 1.0f));
+  const Sphere transient(Id(), Spherical(Vector3f(3, 0, 0), 1.0f));
+  server->create(moved);
+  server->create(destroyed);
+  server->create(kept);
+  server->create(transient);
+  server->destroy(destroyed);
+  moved.setPosition(Vector3f(1, 2, 3));
+  server->update(moved);
+  const auto mesh = std::make_shared<SimpleMesh>(1u, 3u, 0u, DrawType::Points,
+                                                 MeshComponentFlag::Vertex);
+  server->referenceResource(mesh);
+  server->updateFrame(0.0f, true);
+
+  // Connect. The replay runs in the background, catching up with changes made meanwhile.
+  auto connection = server->connectionMonitor()->openFileStream(file_name);
+  ASSERT_NE(connection, nullptr);
+  server->connectionMonitor()->commitConnections();
+  const Sphere late(Id(4u), Spherical(Vector3f(4, 0, 0), 1.0f));
+  server->create(late);
+  // Close waits for the replay to complete.
+  server->close();
+
+  const auto *base_connection = dynamic_cast<const BaseConnection *>(connection.get());
+  ASSERT_NE(base_connection, nullptr);
+  const auto transfers = base_connection->resourceTransfers();
+  ASSERT_EQ(transfers.size(), 1u);
+  EXPECT_EQ(transfers[0].resource_key, mesh->uniqueKey());
+  connection.reset();
+
+  // Read back the stream, collecting the created spheres.
+  std::ifstream in(file_name, std::ios::binary);
+  ASSERT_TRUE(in.is_open());
+  PacketBuffer packet_buffer;
+  std::vector<uint8_t> read_buffer(4096u);
+  std::vector<uint8_t> packet_bytes;
+  std::map<uint32_t, Vector3d> spheres;
+  bool have_category = false;
+  while (in.read(reinterpret_cast<char *>(read_buffer.data()),
+                 static_cast<std::streamsize>(read_buffer.size())) ||
+         in.gcount() > 0)
+  {
+    packet_buffer.addBytes(read_buffer.data(), static_cast<size_t>(in.gcount()));
+    while (const PacketHeader *header = packet_buffer.extractPacket(packet_bytes))
+    {
+      PacketReader packet(header);
+      if (packet.routingId() == MtCategory)
+      {
+        have_category = true;
+      }
+      else if (packet.routingId() == SIdSphere && packet.messageId() == OIdCreate)
+      {
+        Sphere sphere;
+        ASSERT_TRUE(sphere.readCreate(packet));
+        spheres[sphere.id()] = sphere.position();
+      }
+    }
+  }
+  in.close();
+  std::remove(file_name);
+
+  EXPECT_TRUE(have_category);
+  ASSERT_EQ(spheres.size(), 3u);
+  EXPECT_EQ(spheres.count(2u), 0u);
+  EXPECT_EQ(spheres[1u], Vector3d(1, 2, 3));
+  EXPECT_EQ(spheres[3u], Vector3d(2, 0, 0));
+  EXPECT_EQ(spheres[4u], Vector3d(4, 0, 0));
+}
+
+
+TEST(Core, DeltaUpdates)
+{
+  const char *file_name = "delta-updates.3es";
+  ServerSettings settings(SFDeltaUpdates);
+  settings.update_tolerance = 0.01;
+  auto server = Server::create(settings);
+  auto connection = server->connectionMonitor()->openFileStream(file_name);
+  ASSERT_NE(connection, nullptr);
+  server->connectionMonitor()->commitConnections();
+
+  Sphere sphere(Id(1u), Spherical(Vector3f(0, 0, 0), 1.0f));
+  server->create(sphere);
+  // No change: skipped.
+  EXPECT_EQ(server->update(sphere), 0);
+  sphere.setPosition(Vector3f(1, 0, 0));
+  EXPECT_GT(server->update(sphere), 0);
+  // Within tolerance: skipped.
+  sphere.setPosition(Vector3f(1.005f, 0, 0));
+  EXPECT_EQ(server->update(sphere), 0);
+  // The colour changes, but the position remains within tolerance of the last sent value.
+  sphere.setColour(Colour(255, 0, 0));
+  EXPECT_GT(server->update(sphere), 0);
+  server->updateFrame(0.0f, true);
+  server->close();
+  connection.reset();
+
+  // Read back, applying the updates to a sphere read from the creation message.
+  std::ifstream in(file_name, std::ios::binary);
+  ASSERT_TRUE(in.is_open());
+  PacketBuffer packet_buffer;
+  std::vector<uint8_t> read_buffer(4096u);
+  std::vector<uint8_t> packet_bytes;
+  Sphere remote;
+  std::vector<uint16_t> update_flags;
+  while (in.read(reinterpret_cast<char *>(read_buffer.data()),
+                 static_cast<std::streamsize>(read_buffer.size())) ||
+         in.gcount() > 0)
+  {
+    packet_buffer.addBytes(read_buffer.data(), static_cast<size_t>(in.gcount()));
+    while (const PacketHeader *header = packet_buffer.extractPacket(packet_bytes))
+    {
+      PacketReader packet(header);
+      if (packet.routingId() != SIdSphere)
+      {
+        continue;
+      }
+      if (packet.messageId() == OIdCreate)
+      {
+        ASSERT_TRUE(remote.readCreate(packet));
+      }
+      else if (packet.messageId() == OIdUpdate)
+      {
+        PacketReader peek(header);
+        UpdateMessage update = {};
+        ObjectAttributesd attrs = {};
+        ASSERT_TRUE(update.read(peek, attrs));
+        // Compact updates carry only the changed attributes.
+        EXPECT_EQ(peek.bytesAvailable(), 0u);
+        update_flags.emplace_back(update.flags);
+        ASSERT_TRUE(remote.readUpdate(packet));
+      }
+    }
+  }
+  in.close();
+  std::remove(file_name);
+
+  ASSERT_EQ(update_flags.size(), 2u);
+  EXPECT_EQ(update_flags[0] & (UFUpdateMode | UFCompact | UFPosRotScaleColour),
+            UFUpdateMode | UFCompact | UFPosition);
+  EXPECT_EQ(update_flags[1] & (UFUpdateMode | UFCompact | UFPosRotScaleColour),
+            UFUpdateMode | UFCompact | UFColour);
+  EXPECT_EQ(remote.position(), Vector3d(1, 0, 0));
+  EXPECT_EQ(remote.colour().colour32(), Colour(255, 0, 0).colour32());
+}
+
+
+TEST(Core, CompactUpdates)
+{
+  // Round trip every combination of compact update attributes through the shape decoding and check
+  // the attributes which are not flagged are preserved.
+  const Sphere initial(Id(1u), Transform(Vector3d(1, 2, 3), Quaterniond(0, 0, 0, 1),
+                                         Vector3d(1, 1, 1)));
+  Sphere source(Id(1u), Transform(Vector3d(4, 5, 6), Quaterniond(0, 0, 1, 0), Vector3d(2, 3, 4)));
+  source.setColour(Colour(255, 0, 0));
+  std::vector<uint8_t> buffer(1024u);
+  for (const uint16_t precision : { uint16_t(0u), uint16_t(OFDoublePrecision) })
+  {
+    // The attribute flags are contiguous bits, starting at UFPosition.
+    for (unsigned bits = 0; bits < 16u; ++bits)
+    {
+      const auto parts = static_cast<uint16_t>(bits * UFPosition);
+      source.setFlags(static_cast<uint16_t>(UFUpdateMode | UFCompact | precision | parts));
+      PacketWriter writer(buffer.data(), static_cast<uint16_t>(buffer.size()));
+      ASSERT_TRUE(source.writeUpdate(writer));
+      writer.finalise();
+
+      PacketReader packet(reinterpret_cast<const PacketHeader *>(buffer.data()));
+      PacketReader peek(reinterpret_cast<const PacketHeader *>(buffer.data()));
+      UpdateMessage update = {};
+      ObjectAttributesd attrs = {};
+      ASSERT_TRUE(update.read(peek, attrs)) << parts;
+      // Only the flagged attributes are present.
+      EXPECT_EQ(peek.bytesAvailable(), 0u) << parts;
+
+      Sphere remote = initial;
+      ASSERT_TRUE(remote.readUpdate(packet)) << parts;
+      const Sphere &expect_position = (parts & UFPosition) ? source : initial;
+      const Sphere &expect_rotation = (parts & UFRotation) ? source : initial;
+      const Sphere &expect_scale = (parts & UFScale) ? source : initial;
+      const Sphere &expect_colour = (parts & UFColour) ? source : initial;
+      EXPECT_EQ(remote.position(), expect_position.position()) << parts;
+      EXPECT_EQ(remote.rotation(), expect_rotation.rotation()) << parts;
+      EXPECT_EQ(remote.scale(), expect_scale.scale()) << parts;
+      EXPECT_EQ(remote.colour().colour32(), expect_colour.colour().colour32()) << parts;
+    }
+  }
+}
+
+
+TEST(Core, ShapeRegistry)
+{
+  // Collect the encoded packets as (message ID, shape ID, update flags).
+  std::vector<std::array<uint32_t, 3>> messages;
+  const auto emit = [&messages](const uint8_t *data, uint32_t byte_count) {
+    ASSERT_GE(byte_count, sizeof(PacketHeader));
+    PacketReader packet(reinterpret_cast<const PacketHeader *>(data));
+    ASSERT_EQ(packet.routingId(), SIdBox);
+    ASSERT_TRUE(packet.checkCrc());
+    uint32_t id = 0;
+    uint16_t flags = 0;
+    packet.readElement(id);
+    if (packet.messageId() == OIdUpdate)
+    {
+      packet.readElement(flags);
+    }
+    messages.emplace_back(std::array<uint32_t, 3>{ packet.messageId(), id, flags });
+  };
+
+  ShapeRegistry registry(SIdBox);
+  const auto first = registry.add(1u, Vector3f(1, 0, 0));
+  const auto second = registry.add(2u, Vector3f(2, 0, 0));
+  const auto third = registry.add(3u, Vector3f(3, 0, 0));
+  EXPECT_EQ(registry.add(0u), ShapeRegistry::kInvalidHandle);
+  ASSERT_EQ(registry.size(), 3u);
+
+  EXPECT_EQ(registry.encode(emit), 3u);
+  ASSERT_EQ(messages.size(), 3u);
+  for (uint32_t i = 0; i < 3u; ++i)
+  {
+    EXPECT_EQ(messages[i][0], OIdCreate);
+    EXPECT_EQ(messages[i][1], i + 1u);
+  }
+
+  // Nothing changed.
+  messages.clear();
+  EXPECT_EQ(registry.encode(emit), 0u);
+
+  // Remove the first entry. The third moves into its index, but keeps its handle.
+  EXPECT_TRUE(registry.remove(first));
+  EXPECT_FALSE(registry.contains(first));
+  EXPECT_FALSE(registry.remove(first));
+  ASSERT_TRUE(registry.contains(third));
+  EXPECT_EQ(registry.indexOf(third), 0u);
+  EXPECT_EQ(registry.ids()[registry.indexOf(third)], 3u);
+  // Modify in bulk through the arrays.
+  registry.positions()[registry.indexOf(second)] = Vector3f(2, 2, 0);
+  registry.setColour(third, Colour(255, 0, 0));
+  // Added and removed before encoding: never created.
+  registry.remove(registry.add(4u));
+
+  EXPECT_EQ(registry.encode(emit, true), 3u);
+  ASSERT_EQ(messages.size(), 3u);
+  EXPECT_EQ(messages[0][0], OIdDestroy);
+  EXPECT_EQ(messages[0][1], 1u);
+  // Updates are in array order: third, then second.
+  EXPECT_EQ(messages[1][0], OIdUpdate);
+  EXPECT_EQ(messages[1][1], 3u);
+  EXPECT_EQ(messages[1][2], UFUpdateMode | UFCompact | UFColour);
+  EXPECT_EQ(messages[2][0], OIdUpdate);
+  EXPECT_EQ(messages[2][1], 2u);
+  EXPECT_EQ(messages[2][2], UFUpdateMode | UFCompact | UFPosition);
+
+  // Recreate the live shapes.
+  messages.clear();
+  EXPECT_EQ(registry.encodeCreated(emit), 2u);
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_EQ(messages[0][0], OIdCreate);
+  EXPECT_EQ(messages[1][0], OIdCreate);
+
+  // Clear destroys the created shapes.
+  messages.clear();
+  registry.clear();
+  EXPECT_EQ(registry.size(), 0u);
+  EXPECT_EQ(registry.encode(emit), 2u);
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_EQ(messages[0][0], OIdDestroy);
+  EXPECT_EQ(messages[1][0], OIdDestroy);
+}
+
+
+TEST(Core, ShapeTimeline)
+{
+  const char *file_name = "shape-timeline.3es";
+  const char *timeline_name = "shape-timeline.3tml";
+  auto server = Server::create(ServerSettings(SFDefaultNoCompression));
+  auto connection = server->connectionMonitor()->openFileStream(file_name);
+  ASSERT_NE(connection, nullptr);
+  server->connectionMonitor()->commitConnections();
+
+  // Frame 0: create two spheres and a transient.
+  Sphere first(Id(1u), Spherical(Vector3f(1, 0, 0)));
+  Sphere second(Id(2u), Spherical(Vector3f(0, 2, 0)));
+  server->create(first);
+  server->create(second);
+  server->create(Sphere(Id(0u), Spherical(Vector3f(5, 5, 5))));
+  server->updateFrame(0.0f, true);
+  // Frames 1-9: move the first sphere each frame.
+  for (unsigned i = 1; i < 10u; ++i)
+  {
+    first.setPosition(Vector3f(static_cast<float>(i + 1), 0, 0));
+    server->update(first);
+    server->updateFrame(0.0f, true);
+  }
+  // Frame 10: destroy the second sphere.
+  server->destroy(second);
+  server->updateFrame(0.0f, true);
+  server->close();
+  connection.reset();
+
+  ShapeTimeline timeline;
+  {
+    std::ifstream in(file_name, std::ios::binary);
+    ASSERT_TRUE(in.is_open());
+    EXPECT_TRUE(timeline.build(in));
+  }
+  std::remove(file_name);
+
+  const auto validate = [](const ShapeTimeline &timeline) {
+    EXPECT_EQ(timeline.frameCount(), 11u);
+    EXPECT_EQ(timeline.shapeCount(), 2u);
+    // 1 create + 9 updates for the first sphere, create + destroy for the second.
+    EXPECT_EQ(timeline.eventCount(), 12u);
+    EXPECT_TRUE(timeline.contains(SIdSphere, 1u));
+    EXPECT_FALSE(timeline.contains(SIdSphere, 0u));
+    EXPECT_FALSE(timeline.contains(SIdBox, 1u));
+
+    for (unsigned frame = 0; frame < 11u; ++frame)
+    {
+      const auto state = timeline.stateAt(SIdSphere, 1u, frame);
+      ASSERT_TRUE(state.has_value());
+      EXPECT_EQ(state->position, Vector3f(static_cast<float>(std::min(frame, 9u) + 1), 0, 0));
+    }
+
+    EXPECT_TRUE(timeline.stateAt(SIdSphere, 2u, 9u).has_value());
+    EXPECT_FALSE(timeline.stateAt(SIdSphere, 2u, 10u).has_value());
+
+    std::vector<ShapeTimeline::Event> events;
+    EXPECT_EQ(timeline.events(SIdSphere, 1u, 3u, 6u, events), 3u);
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].frame, 3u);
+    EXPECT_EQ(events[0].type, ShapeTimeline::EventType::Update);
+    EXPECT_EQ(events[2].state.position, Vector3f(6, 0, 0));
+    EXPECT_EQ(timeline.events(SIdSphere, 2u, 0u, 100u, events), 2u);
+    EXPECT_EQ(events.back().type, ShapeTimeline::EventType::Destroy);
+    EXPECT_EQ(events.back().frame, 10u);
+  };
+
+  validate(timeline);
+
+  ASSERT_TRUE(timeline.save(timeline_name));
+  ShapeTimeline loaded;
+  ASSERT_TRUE(loaded.load(timeline_name));
+  std::remove(timeline_name);
+  validate(loaded);
+}
+
+
+TEST(Core, ShapeTimelineCorrupt)
+{
+  const char *file_name = "shape-timeline-corrupt.3es";
+  const char *timeline_name = "shape-timeline-corrupt.3tml";
+  auto server = Server::create(ServerSettings(SFDefaultNoCompression));
+  auto connection = server->connectionMonitor()->openFileStream(file_name);
+  ASSERT_NE(connection, nullptr);
+  server->connectionMonitor()->commitConnections();
+  Sphere first(Id(1u), Spherical(Vector3f(1, 0, 0)));
+  server->create(first);
+  server->create(Sphere(Id(2u), Spherical(Vector3f(0, 2, 0))));
+  server->updateFrame(0.0f, true);
+  first.setPosition(Vector3f(2, 0, 0));
+  server->update(first);
+  server->updateFrame(0.0f, true);
+  server->close();
+  connection.reset();
+
+  ShapeTimeline timeline;
+  {
+    std::ifstream in(file_name, std::ios::binary);
+    ASSERT_TRUE(in.is_open());
+    EXPECT_TRUE(timeline.build(in));
+  }
+  std::remove(file_name);
+  ASSERT_EQ(timeline.shapeCount(), 2u);
+  ASSERT_EQ(timeline.eventCount(), 3u);
+  ASSERT_TRUE(timeline.save(timeline_name));
+
+  std::vector<uint8_t> original;
+  {
+    std::ifstream in(timeline_name, std::ios::binary);
+    original.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+  // File layout: 32 byte header with the shape count at 16 and the event count at 24, then the
+  // shape keys and the event offsets.
+  const size_t shape_count_at = 16u;
+  const size_t event_count_at = 24u;
+  const size_t keys_at = 32u;
+  const size_t offsets_at = keys_at + 2u * sizeof(uint64_t);
+  const auto load = [timeline_name](const std::vector<uint8_t> &bytes) {
+    {
+      std::ofstream out(timeline_name, std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char *>(bytes.data()),
+                static_cast<std::streamsize>(bytes.size()));
+    }
+    ShapeTimeline loaded;
+    const bool ok = loaded.load(timeline_name);
+    // A failed load leaves the timeline empty.
+    EXPECT_TRUE(ok || (loaded.shapeCount() == 0 && loaded.eventCount() == 0));
+    return ok;
+  };
+  const auto corrupt = [&original](size_t offset, auto value) {
+    auto bytes = original;
+    std::memcpy(bytes.data() + offset, &value, sizeof(value));
+    return bytes;
+  };
+
+  EXPECT_TRUE(load(original));
+  // Counts which do not match the file size, including those which would exhaust memory.
+  EXPECT_FALSE(load(corrupt(shape_count_at, uint64_t(3u))));
+  EXPECT_FALSE(load(corrupt(shape_count_at, ~uint64_t(0u))));
+  EXPECT_FALSE(load(corrupt(event_count_at, uint64_t(4u))));
+  EXPECT_FALSE(load(corrupt(event_count_at, ~uint64_t(0u) / 2u)));
+  EXPECT_FALSE(load(std::vector<uint8_t>(original.begin(), original.end() - 1)));
+  // Offsets which are out of order, past the events, not starting at zero or not ending at the
+  // event count.
+  EXPECT_FALSE(load(corrupt(offsets_at + sizeof(uint32_t), uint32_t(4u))));
+  EXPECT_FALSE(load(corrupt(offsets_at, uint32_t(1u))));
+  EXPECT_FALSE(load(corrupt(offsets_at + 2u * sizeof(uint32_t), uint32_t(2u))));
+  // Unsorted shape keys.
+  EXPECT_FALSE(load(corrupt(keys_at, ~uint64_t(0u))));
+  std::remove(timeline_name);
+}
+
+
+TEST(Core, ListenSocketWake)
+{
+  TcpListenSocket listen_socket;
+  uint16_t port = ServerSettings::kDefaultPort + 200u;
+  while (!listen_socket.listen(port) && port < ServerSettings::kDefaultPort + 1000u)
+  {
+    ++port;
+  }
+  ASSERT_TRUE(listen_socket.isListening());
+
+  // A pending wake returns immediately.
+  listen_socket.wake();
+  EXPECT_EQ(listen_socket.accept(10000u), nullptr);
+
+#ifndef WIN32
+  // Wake a blocked accept from another thread.
+  const auto start_time = std::chrono::steady_clock::now();
+  std::thread waker([&listen_socket]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    listen_socket.wake();
+  });
+  EXPECT_EQ(listen_socket.accept(10000u), nullptr);
+  waker.join();
+  EXPECT_LT(std::chrono::steady_clock::now() - start_time, std::chrono::seconds(5));
+#endif  // WIN32
+
+  // Connections are still accepted after waking.
+  TcpSocket client;
+  ASSERT_TRUE(client.open("127.0.0.1", listen_socket.port()));
+  EXPECT_NE(listen_socket.accept(5000u), nullptr);
+}
+
+
+TEST(Core, ConnectionCommit)
+{
+  ServerSettings settings(SFDefault);
+  settings.port_range = 1000;
+  auto server = Server::create(settings);
+  ASSERT_TRUE(server->connectionMonitor()->start(ConnectionMode::Asynchronous));
+
+  TcpSocket client;
+  ASSERT_TRUE(client.open("127.0.0.1", server->connectionMonitor()->port()));
+  ASSERT_GT(server->connectionMonitor()->waitForConnection(5000u), 0);
+  server->connectionMonitor()->commitConnections();
+  ASSERT_EQ(server->connectionCount(), 1u);
+  const auto connection = server->connection(0);
+
+  // Committing without changes keeps the same connections.
+  server->connectionMonitor()->commitConnections();
+  ASSERT_EQ(server->connectionCount(), 1u);
+  EXPECT_EQ(server->connection(0), connection);
+  EXPECT_GE(server->updateFrame(0.0f, true), 0);
+
+  // A snapshot of the connections remains valid after the connection is dropped.
+  client.close();
+  const auto wait_start = std::chrono::steady_clock::now();
+  while (server->connectionCount() > 0 &&
+         std::chrono::steady_clock::now() - wait_start < std::chrono::seconds(5))
+  {
+    server->updateFrame(0.0f, true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(server->connectionCount(), 0u);
+  EXPECT_NE(connection, nullptr);
+
+  server->close();
+}
+
+
+TEST(Core, CollationFlushThread)
+{
+  // The server flush thread sends aged collated packets without any frame update.
+  ServerSettings settings(SFCollate);
+  settings.port_range = 1000;
+  settings.flush_policy.max_age_us = 1000;
+  settings.flush_policy.end_of_frame = false;
+  auto server = Server::create(settings);
+  ASSERT_TRUE(server->connectionMonitor()->start(ConnectionMode::Asynchronous));
+
+  TcpSocket client;
+  ASSERT_TRUE(client.open("127.0.0.1", server->connectionMonitor()->port()));
+  ASSERT_GT(server->connectionMonitor()->waitForConnection(5000u), 0);
+  server->connectionMonitor()->commitConnections();
+  ASSERT_EQ(server->connectionCount(), 1u);
+
+  // The server info bypasses collation, so the create starts a new collated packet. With no frame
+  // update and no size limit, only the flush thread can send it.
+  const Sphere sphere(Id(1), Spherical(Vector3f(1, 2, 3), 1.0f));
+  ASSERT_GT(server->create(sphere), 0);
+
+  PacketBuffer packet_buffer;
+  CollatedPacketDecoder decoder;
+  std::vector<uint8_t> read_buffer(4096u);
+  std::vector<uint8_t> packet_bytes;
+  bool received = false;
+  client.setReadTimeout(100u);
+  const auto wait_start = std::chrono::steady_clock::now();
+  while (!received && std::chrono::steady_clock::now() - wait_start < std::chrono::seconds(5))
+  {
+    const int read = client.read(read_buffer.data(), static_cast<int>(read_buffer.size()));
+    ASSERT_GE(read, 0);
+    packet_buffer.addBytes(read_buffer.data(), static_cast<size_t>(read));
+    while (const PacketHeader *header = packet_buffer.extractPacket(packet_bytes))
+    {
+      decoder.setPacket(header);
+      while (const PacketHeader *decoded = decoder.next())
+      {
+        const PacketReader packet(decoded);
+        received = received ||
+                   (packet.routingId() == SIdSphere && packet.messageId() == OIdCreate);
+      }
+    }
+  }
+  EXPECT_TRUE(received);
+
+  // Stopping the server stops the flush thread.
+  server->close();
+  server.reset();
+}
+
+
+TEST(Core, WriteBehindFile)
+{
+  const char *file_name = "write-behind.bin";
+  // Use small buffers to exercise the buffer hand over.
+  WriteBehindFile writer(1024u);
+  ASSERT_TRUE(writer.open(file_name));
+
+  std::vector<uint32_t> expected;
+  for (uint32_t i = 0; i < 10000u; ++i)
+  {
+    // Write in varied sizes, including writes larger than the buffer.
+    const uint32_t count = 1u + (i % 7u) * ((i % 50u == 0) ? 100u : 1u);
+    std::vector<uint32_t> values(count, i);
+    ASSERT_TRUE(writer.write(values.data(), values.size() * sizeof(uint32_t)));
+    expected.insert(expected.end(), values.begin(), values.end());
+  }
+
+  // Rewrite the first value on close.
+  writer.close([](std::fstream &file) {
+    const uint32_t marker = 0xdeadbeefu;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&marker), sizeof(marker));
+  });
+  expected[0] = 0xdeadbeefu;
+
+  const auto stats = writer.stats();
+  EXPECT_EQ(stats.bytes_written, expected.size() * sizeof(uint32_t));
+  EXPECT_EQ(stats.bytes_dropped, 0u);
+  EXPECT_FALSE(writer.isOpen());
+  EXPECT_FALSE(writer.write(expected.data(), sizeof(uint32_t)));
+
+  std::ifstream in(file_name, std::ios::binary);
+  std::vector<uint32_t> actual(expected.size() + 1u);
+  in.read(reinterpret_cast<char *>(actual.data()),
+          static_cast<std::streamsize>(actual.size() * sizeof(uint32_t)));
+  EXPECT_EQ(static_cast<size_t>(in.gcount()), expected.size() * sizeof(uint32_t));
+  actual.resize(expected.size());
+  EXPECT_EQ(actual, expected);
+  in.close();
+  std::remove(file_name);
+}
+
+
+namespace
+{
+/// A @c WriteBehindFile where the writer thread blocks until the gate is opened, to simulate slow
+/// storage.
+class GatedWriteBehindFile : public WriteBehindFile
+{
+public:
+  GatedWriteBehindFile(size_t buffer_size, bool drop_when_full)
+    : WriteBehindFile(buffer_size, drop_when_full)
+  {}
+
+  ~GatedWriteBehindFile() override
+  {
+    openGate();
+    close();
+  }
+
+  /// Block until the writer thread is waiting on the gate.
+  void waitForWriter()
+  {
+    std::unique_lock<std::mutex> lock(_gate_lock);
+    _gate_signal.wait(lock, [this]() { return _writer_waiting; });
+  }
+
+  void openGate()
+  {
+    const std::lock_guard<std::mutex> guard(_gate_lock);
+    _gate_open = true;
+    _gate_signal.notify_all();
+  }
+
+protected:
+  bool writeBytes(std::fstream &file, const uint8_t *data, size_t byte_count) override
+  {
+    {
+      std::unique_lock<std::mutex> lock(_gate_lock);
+      _writer_waiting = true;
+      _gate_signal.notify_all();
+      _gate_signal.wait(lock, [this]() { return _gate_open; });
+    }
+    return WriteBehindFile::writeBytes(file, data, byte_count);
+  }
+
+private:
+  std::mutex _gate_lock;
+  std::condition_variable _gate_signal;
+  bool _writer_waiting = false;
+  bool _gate_open = false;
+};
+
+
+/// Fill both buffers of @p writer while the writer thread is blocked, then make one more write
+/// which must either drop or stall. Returns the file content.
+std::vector<uint8_t> writeBehindSlowStorage(bool drop_when_full, WriteBehindFile::Stats &stats)
+{
+  const char *file_name = "write-behind-slow.bin";
+  constexpr size_t kBufferSize = 16u;
+  std::array<std::vector<uint8_t>, 3> blocks;
+  for (size_t i = 0; i < blocks.size(); ++i)
+  {
+    blocks[i].resize(kBufferSize, static_cast<uint8_t>(i + 1u));
+  }
+
+  std::vector<uint8_t> content;
+  {
+    GatedWriteBehindFile writer(kBufferSize, drop_when_full);
+    EXPECT_TRUE(writer.open(file_name));
+    // The writer thread takes the first block, either when the second is written or on the flush
+    // interval, then blocks. The second block stays in the fill buffer.
+    EXPECT_TRUE(writer.write(blocks[0].data(), blocks[0].size()));
+    EXPECT_TRUE(writer.write(blocks[1].data(), blocks[1].size()));
+    writer.waitForWriter();
+
+    if (drop_when_full)
+    {
+      EXPECT_FALSE(writer.write(blocks[2].data(), blocks[2].size()));
+    }
+    else
+    {
+      auto stalled = std::async(std::launch::async, [&writer, &blocks]() {
+        return writer.write(blocks[2].data(), blocks[2].size());
+      });
+      // Can't complete until the gate opens.
+      EXPECT_EQ(stalled.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+      writer.openGate();
+      EXPECT_TRUE(stalled.get());
+    }
+
+    writer.openGate();
+    writer.close();
+    stats = writer.stats();
+  }
+
+  std::ifstream in(file_name, std::ios::binary);
+  content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  in.close();
+  std::remove(file_name);
+  return content;
+}
+}  // namespace
+
+
+TEST(Core, WriteBehindFileDrop)
+{
+  WriteBehindFile::Stats stats = {};
+  const auto content = writeBehindSlowStorage(true, stats);
+
+  // The third block is dropped whole.
+  std::vector<uint8_t> expected(16u, 1u);
+  expected.resize(32u, 2u);
+  EXPECT_EQ(content, expected);
+  EXPECT_EQ(stats.bytes_written, 32u);
+  EXPECT_EQ(stats.bytes_dropped, 16u);
+  EXPECT_EQ(stats.bytes_late, 0u);
+}
+
+
+TEST(Core, WriteBehindFileStall)
+{
+  WriteBehindFile::Stats stats = {};
+  const auto content = writeBehindSlowStorage(false, stats);
+
+  // The third block waits for the writer thread, then is written in order.
+  std::vector<uint8_t> expected(16u, 1u);
+  expected.resize(32u, 2u);
+  expected.resize(48u, 3u);
+  EXPECT_EQ(content, expected);
+  EXPECT_EQ(stats.bytes_written, 48u);
+  EXPECT_EQ(stats.bytes_dropped, 0u);
+  EXPECT_EQ(stats.bytes_late, 16u);
+  EXPECT_GT(stats.stall_time, 0.0);
+}
 }  // namespace tes
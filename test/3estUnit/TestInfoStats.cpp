@@ -0,0 +1,143 @@
+//
+// author: Kazys Stepanas
+//
+
+#include "TestCommon.h"
+
+#include <3esinfo/InfoStats.h>
+
+#include <3escore/CollatedPacket.h>
+#include <3escore/Messages.h>
+#include <3escore/PacketWriter.h>
+#include <3escore/shapes/Sphere.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <fstream>
+#include <string>
+
+namespace tes
+{
+namespace
+{
+/// Write a stream of @p frame_count frames to @p file_name . Each frame holds an uncompressed
+/// collated packet of sphere create and destroy messages followed by a frame message. Shape
+/// categories cycle through @p category_count values.
+/// @return The number of sphere create messages written.
+unsigned writeStatsStream(const std::string &file_name, unsigned frame_count,
+                          unsigned shapes_per_frame, uint16_t category_count)
+{
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  CollatedPacket collated(false);
+  std::array<uint8_t, 256> buffer = {};
+  unsigned created = 0;
+  for (unsigned frame = 0; frame < frame_count; ++frame)
+  {
+    collated.reset();
+    for (unsigned i = 0; i < shapes_per_frame; ++i)
+    {
+      const auto id = frame * shapes_per_frame + i + 1u;
+      Sphere sphere(Id(id, static_cast<uint16_t>(id % category_count)),
+                    Spherical(Vector3f(static_cast<float>(i), static_cast<float>(frame), 0)));
+      EXPECT_GT(collated.create(sphere), 0);
+      ++created;
+      if (frame > 0)
+      {
+        // Destroy a shape created in the previous frame, possibly in another chunk.
+        const Sphere previous(Id(id - shapes_per_frame));
+        PacketWriter writer(buffer.data(), buffer.size());
+        EXPECT_TRUE(previous.writeDestroy(writer));
+        EXPECT_TRUE(writer.finalise());
+        EXPECT_GT(collated.add(writer), 0);
+      }
+    }
+    EXPECT_TRUE(collated.finalise());
+    unsigned byte_count = 0;
+    const uint8_t *bytes = collated.buffer(byte_count);
+    out.write(reinterpret_cast<const char *>(bytes), byte_count);
+
+    PacketWriter writer(buffer.data(), buffer.size(), MtControl, CIdFrame);
+    ControlMessage msg = {};
+    msg.value32 = 1u;
+    EXPECT_TRUE(msg.write(writer));
+    EXPECT_TRUE(writer.finalise());
+    out.write(reinterpret_cast<const char *>(writer.data()), writer.packetSize());
+  }
+  return created;
+}
+
+
+void compareStats(const ChunkStats &expected, const ChunkStats &actual)
+{
+  EXPECT_EQ(actual.stream_bytes, expected.stream_bytes);
+  EXPECT_EQ(actual.packet_count, expected.packet_count);
+  EXPECT_EQ(actual.collated_count, expected.collated_count);
+  EXPECT_EQ(actual.unsupported_count, expected.unsupported_count);
+  EXPECT_EQ(actual.dropped_count, expected.dropped_count);
+
+  EXPECT_EQ(actual.messages.size(), expected.messages.size());
+  for (const auto &[key, stats] : expected.messages)
+  {
+    const auto search = actual.messages.find(key);
+    ASSERT_NE(search, actual.messages.end());
+    EXPECT_EQ(search->second.count, stats.count);
+    EXPECT_EQ(search->second.bytes, stats.bytes);
+  }
+
+  EXPECT_EQ(actual.categories.size(), expected.categories.size());
+  for (const auto &[category, stats] : expected.categories)
+  {
+    const auto search = actual.categories.find(category);
+    ASSERT_NE(search, actual.categories.end());
+    EXPECT_EQ(search->second.count, stats.count);
+    EXPECT_EQ(search->second.bytes, stats.bytes);
+  }
+  EXPECT_EQ(actual.unresolved.size(), expected.unresolved.size());
+
+  ASSERT_EQ(actual.frames.size(), expected.frames.size());
+  for (size_t i = 0; i < expected.frames.size(); ++i)
+  {
+    EXPECT_EQ(actual.frames[i].count, expected.frames[i].count) << "frame " << i;
+    EXPECT_EQ(actual.frames[i].bytes, expected.frames[i].bytes) << "frame " << i;
+  }
+  EXPECT_EQ(actual.open_frame.count, expected.open_frame.count);
+}
+}  // namespace
+
+
+TEST(InfoStats, ThreadCount)
+{
+  const std::string file_name = "info-stats.3es";
+  constexpr unsigned kFrameCount = 200u;
+  constexpr unsigned kShapesPerFrame = 100u;
+  constexpr uint16_t kCategoryCount = 5u;
+  const unsigned created =
+    writeStatsStream(file_name, kFrameCount, kShapesPerFrame, kCategoryCount);
+
+  std::ifstream in(file_name, std::ios::binary | std::ios::ate);
+  const std::streamoff file_size = in.tellg();
+  in.close();
+  ASSERT_GT(file_size, 0);
+
+  ChunkStats expected;
+  collectStats(file_name, 0, file_size, 1u, expected);
+  EXPECT_EQ(expected.packet_count, 2u * kFrameCount);
+  EXPECT_EQ(expected.collated_count, kFrameCount);
+  EXPECT_EQ(static_cast<std::streamoff>(expected.stream_bytes), file_size);
+  EXPECT_EQ((expected.messages[{ SIdSphere, OIdCreate }].count), created);
+  EXPECT_EQ(expected.categories.size(), kCategoryCount);
+  EXPECT_TRUE(expected.unresolved.empty());
+  EXPECT_EQ(expected.frames.size(), kFrameCount);
+
+  // Chunk boundaries fall inside the collated packets, whose nested packets are valid packets in
+  // their own right. Each nested packet must still be counted once.
+  for (const unsigned thread_count : { 2u, 3u, 5u, 8u, 13u, 64u })
+  {
+    SCOPED_TRACE(thread_count);
+    ChunkStats actual;
+    collectStats(file_name, 0, file_size, thread_count, actual);
+    compareStats(expected, actual);
+  }
+}
+}  // namespace tes
@@ -0,0 +1,220 @@
+//
+// author: Kazys Stepanas
+//
+
+#include "TestCommon.h"
+
+#include <3esOccupancy/PlyStream.h>
+
+#include <3escore/Endian.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace tes
+{
+namespace
+{
+struct PlyPoint
+{
+  double time;
+  Vector3d position;
+};
+
+
+std::vector<PlyPoint> makePoints(unsigned count)
+{
+  std::vector<PlyPoint> points(count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    points[i].time = 0.5 * i;
+    points[i].position = Vector3d(i, -0.25 * i, 1000.0 + i);
+  }
+  return points;
+}
+
+
+template <typename T>
+void writeBinary(std::ostream &out, T value, bool big_endian)
+{
+#if TES_IS_BIG_ENDIAN
+  const bool swap = !big_endian;
+#else   // TES_IS_BIG_ENDIAN
+  const bool swap = big_endian;
+#endif  // TES_IS_BIG_ENDIAN
+  if (swap)
+  {
+    endianSwap(reinterpret_cast<uint8_t *>(&value), sizeof(value));
+  }
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+
+/// Write a binary PLY file holding @p points followed by a face element.
+void writeBinaryPly(const std::string &file_name, const std::vector<PlyPoint> &points,
+                    bool big_endian)
+{
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  out << "ply\n";
+  out << "format " << (big_endian ? "binary_big_endian" : "binary_little_endian") << " 1.0\n";
+  out << "element vertex " << points.size() << "\n";
+  out << "property float x\n";
+  out << "property float y\n";
+  out << "property float z\n";
+  out << "property uchar intensity\n";
+  out << "property double time\n";
+  out << "element face 2\n";
+  out << "property list uchar int vertex_indices\n";
+  out << "end_header\n";
+  for (const auto &point : points)
+  {
+    writeBinary(out, static_cast<float>(point.position.x()), big_endian);
+    writeBinary(out, static_cast<float>(point.position.y()), big_endian);
+    writeBinary(out, static_cast<float>(point.position.z()), big_endian);
+    writeBinary(out, uint8_t(255), big_endian);
+    writeBinary(out, point.time, big_endian);
+  }
+  for (int face = 0; face < 2; ++face)
+  {
+    writeBinary(out, uint8_t(3), big_endian);
+    for (int i = 0; i < 3; ++i)
+    {
+      writeBinary(out, int32_t(face + i), big_endian);
+    }
+  }
+}
+
+
+/// Write an ASCII PLY file holding @p points followed by a face element. Blank lines are scattered
+/// through the vertex data and some lines end in CRLF.
+void writeAsciiPly(const std::string &file_name, const std::vector<PlyPoint> &points)
+{
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  out << "ply\n";
+  out << "format ascii 1.0\n";
+  out << "comment time and position\n";
+  out << "element vertex " << points.size() << "\n";
+  out << "property double timestamp\n";
+  out << "property double x\n";
+  out << "property double y\n";
+  out << "property double z\n";
+  out << "element face 4\n";
+  out << "property list uchar int vertex_indices\n";
+  out << "end_header\n";
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    const auto &point = points[i];
+    if (i % 11 == 0)
+    {
+      out << ((i % 2) ? "\n" : "  \r\n");
+    }
+    out << point.time << " " << point.position.x() << " " << point.position.y() << " "
+        << point.position.z() << ((i % 3) ? "\n" : "\r\n");
+  }
+  // Faces have as many values as the vertex properties, so would decode as vertices if the vertex
+  // data were not bounded.
+  for (int face = 0; face < 4; ++face)
+  {
+    out << "3 " << face << " " << face + 1 << " " << face + 2 << "\n";
+  }
+}
+
+
+void readPly(const std::string &file_name, const std::vector<PlyPoint> &points, float epsilon)
+{
+  const std::vector<std::string> time_fields = { "time", "timestamp" };
+  PlyStream stream;
+  for (const unsigned thread_count : { 1u, 3u })
+  {
+    for (const size_t chunk_points : { size_t(1), size_t(7), size_t(64), size_t(100000) })
+    {
+      SCOPED_TRACE("threads " + std::to_string(thread_count) + " chunk " +
+                   std::to_string(chunk_points));
+      ASSERT_TRUE(stream.open(file_name.c_str(), time_fields, thread_count, chunk_points));
+      EXPECT_EQ(stream.pointCount(), points.size());
+
+      double time = 0;
+      Vector3d position;
+      for (size_t i = 0; i < points.size(); ++i)
+      {
+        ASSERT_TRUE(stream.nextPoint(time, position)) << "point " << i;
+        EXPECT_NEAR(time, points[i].time, epsilon) << "point " << i;
+        EXPECT_NEAR(position.x(), points[i].position.x(), epsilon) << "point " << i;
+        EXPECT_NEAR(position.y(), points[i].position.y(), epsilon) << "point " << i;
+        EXPECT_NEAR(position.z(), points[i].position.z(), epsilon) << "point " << i;
+      }
+      EXPECT_FALSE(stream.nextPoint(time, position));
+      EXPECT_EQ(stream.pointsRead(), points.size());
+
+      stream.close();
+      EXPECT_FALSE(stream.isOpen());
+      EXPECT_EQ(stream.pointCount(), 0u);
+      EXPECT_EQ(stream.pointsRead(), 0u);
+    }
+  }
+}
+}  // namespace
+
+
+TEST(PlyStream, Binary)
+{
+  const auto points = makePoints(1000);
+  for (const bool big_endian : { false, true })
+  {
+    SCOPED_TRACE(big_endian ? "big endian" : "little endian");
+    const std::string file_name = "ply-stream-binary.ply";
+    writeBinaryPly(file_name, points, big_endian);
+    readPly(file_name, points, 1e-3f);
+  }
+}
+
+
+TEST(PlyStream, Ascii)
+{
+  const auto points = makePoints(1000);
+  const std::string file_name = "ply-stream-ascii.ply";
+  writeAsciiPly(file_name, points);
+  readPly(file_name, points, 1e-9f);
+
+  // A malformed vertex line is dropped. The face which follows must not be read in its place.
+  {
+    std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+    out << "ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nproperty float y\n"
+           "property float z\nproperty float time\nelement face 1\n"
+           "property list uchar int vertex_indices\nend_header\n"
+           "1 2 3 4\n5 6 seven 8\n9 10 11 12\n3 0 1 2\n";
+  }
+  const std::vector<std::string> time_fields = { "time" };
+  PlyStream stream;
+  ASSERT_TRUE(stream.open(file_name.c_str(), time_fields, 1, 1));
+  double time = 0;
+  Vector3d position;
+  ASSERT_TRUE(stream.nextPoint(time, position));
+  EXPECT_EQ(time, 4.0);
+  ASSERT_TRUE(stream.nextPoint(time, position));
+  EXPECT_EQ(time, 12.0);
+  EXPECT_FALSE(stream.nextPoint(time, position));
+}
+
+
+TEST(PlyStream, Invalid)
+{
+  const std::vector<std::string> time_fields = { "time" };
+  PlyStream stream;
+  EXPECT_FALSE(stream.open("ply-stream-missing.ply", time_fields));
+
+  // No time field.
+  const std::string file_name = "ply-stream-invalid.ply";
+  {
+    std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+    out << "ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\nproperty float y\n"
+           "property float z\nend_header\n1 2 3\n";
+  }
+  EXPECT_FALSE(stream.open(file_name.c_str(), time_fields));
+  EXPECT_FALSE(stream.isOpen());
+  EXPECT_EQ(stream.pointCount(), 0u);
+}
+}  // namespace tes
@@ -0,0 +1,151 @@
+//
+// author: Kazys Stepanas
+//
+#include "TestCommon.h"
+
+#include <3escore/PointOctree.h>
+
+#include <3escore/shapes/SimpleMesh.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace tes
+{
+namespace
+{
+/// Build an OpenGL style perspective projection.
+/// @param fov_y The vertical field of view (radians).
+/// @param aspect The view aspect ratio (width / height).
+/// @param near_clip The near clip plane distance.
+/// @param far_clip The far clip plane distance.
+Matrix4f perspective(float fov_y, float aspect, float near_clip, float far_clip)
+{
+  const float focal = 1.0f / std::tan(0.5f * fov_y);
+  Matrix4f projection = Matrix4f::Zero;
+  projection(0, 0) = focal / aspect;
+  projection(1, 1) = focal;
+  projection(2, 2) = (far_clip + near_clip) / (near_clip - far_clip);
+  projection(2, 3) = 2.0f * far_clip * near_clip / (near_clip - far_clip);
+  projection(3, 2) = -1.0f;
+  return projection;
+}
+
+
+/// Build a point cloud resource with @p point_count random points in a cube of edge 20.
+SimpleMesh makeCloud(unsigned point_count)
+{
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> rand(-10.0f, 10.0f);
+
+  SimpleMesh cloud(1, point_count, 0, DrawType::Points);
+  for (unsigned i = 0; i < point_count; ++i)
+  {
+    cloud.setVertex(i, Vector3f(rand(rng), rand(rng), rand(rng)));
+  }
+  return cloud;
+}
+}  // namespace
+
+
+TEST(PointOctree, Build)
+{
+  constexpr unsigned kPointCount = 200000u;
+  constexpr unsigned kNodeCapacity = 1000u;
+  const auto cloud = makeCloud(kPointCount);
+  PointOctree octree;
+  ASSERT_TRUE(octree.build(cloud, kNodeCapacity));
+  const auto &nodes = octree.nodes();
+  ASSERT_FALSE(nodes.empty());
+  EXPECT_EQ(nodes.front().count, kNodeCapacity);
+
+  // Each point must appear exactly once.
+  std::vector<unsigned> seen(kPointCount);
+  for (const auto index : octree.order())
+  {
+    ASSERT_LT(index, kPointCount);
+    ++seen[index];
+  }
+  for (const auto count : seen)
+  {
+    ASSERT_EQ(count, 1u);
+  }
+
+  // Node ranges are disjoint and cover all points. Children lie within their parent bounds.
+  unsigned total = 0;
+  for (const auto &node : nodes)
+  {
+    total += node.count;
+    EXPECT_LE(node.count, kNodeCapacity);
+    for (uint32_t i = 0; i < node.child_count; ++i)
+    {
+      const auto &child = nodes[node.first_child + i];
+      EXPECT_GE(child.begin, node.begin + node.count);
+      Boundsf joined = node.bounds;
+      joined.expand(child.bounds);
+      EXPECT_TRUE(joined == node.bounds);
+      EXPECT_GT(node.spacing, child.spacing);
+    }
+  }
+  EXPECT_EQ(total, kPointCount);
+
+  // An empty resource has no octree.
+  PointOctree empty;
+  EXPECT_FALSE(empty.build(SimpleMesh(2, 0, 0, DrawType::Points)));
+  EXPECT_TRUE(empty.empty());
+}
+
+
+TEST(PointOctree, Select)
+{
+  constexpr unsigned kPointCount = 200000u;
+  constexpr unsigned kNodeCapacity = 1000u;
+  const auto cloud = makeCloud(kPointCount);
+  PointOctree octree;
+  ASSERT_TRUE(octree.build(cloud, kNodeCapacity));
+  const auto &nodes = octree.nodes();
+
+  // Select from a view outside the cloud, looking down -Z at the cloud centre.
+  constexpr unsigned kViewWidth = 1280u;
+  constexpr unsigned kViewHeight = 720u;
+  const auto projection = perspective(static_cast<float>(M_PI) / 3.0f,
+                                      static_cast<float>(kViewWidth) / kViewHeight, 0.1f, 1000.0f);
+  const auto model_view = Matrix4f::translation(Vector3f(0, 0, -40.0f));
+
+  std::vector<uint32_t> selection;
+  constexpr unsigned kBudget = 20000u;
+  const unsigned selected = octree.select(selection, projection, model_view, kViewHeight, kBudget);
+  EXPECT_LE(selected, kBudget);
+  EXPECT_GT(selected, kNodeCapacity);
+  ASSERT_FALSE(selection.empty());
+  EXPECT_EQ(selection.front(), 0u);
+
+  // Every selected node must follow its parent.
+  std::vector<bool> selected_nodes(nodes.size());
+  for (const auto node_index : selection)
+  {
+    selected_nodes[node_index] = true;
+    const auto &node = nodes[node_index];
+    for (uint32_t i = 0; i < node.child_count; ++i)
+    {
+      EXPECT_FALSE(selected_nodes[node.first_child + i]);
+    }
+  }
+
+  // An unlimited budget from far away should not refine to full resolution.
+  const auto far_view = Matrix4f::translation(Vector3f(0, 0, -900.0f));
+  EXPECT_LT(octree.select(selection, projection, far_view, kViewHeight, kPointCount), kPointCount);
+
+  // Looking away from the cloud selects nothing.
+  const auto away_view = Matrix4f::translation(Vector3f(0, 0, 40.0f));
+  EXPECT_EQ(octree.select(selection, projection, away_view, kViewHeight, kBudget), 0u);
+  EXPECT_TRUE(selection.empty());
+
+  // As does a view with the cloud off to the side.
+  const auto side_view = Matrix4f::translation(Vector3f(100.0f, 0, -40.0f));
+  EXPECT_EQ(octree.select(selection, projection, side_view, kViewHeight, kBudget), 0u);
+}
+}  // namespace tes
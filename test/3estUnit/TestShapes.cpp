@@ -4,17 +4,20 @@
 
 #include "TestCommon.h"
 
+#include <3escore/CollatedPacket.h>
 #include <3escore/CollatedPacketDecoder.h>
 #include <3escore/ConnectionMonitor.h>
 #include <3escore/CoordinateFrame.h>
 #include <3escore/Maths.h>
 #include <3escore/MathsStream.h>
+#include <3escore/MeshMessages.h>
 #include <3escore/Messages.h>
 #include <3escore/PacketBuffer.h>
 #include <3escore/PacketReader.h>
 #include <3escore/PacketWriter.h>
 #include <3escore/Server.h>
 #include <3escore/ServerUtil.h>
+#include <3escore/shapes/MutableMesh.h>
 #include <3escore/shapes/PointCloud.h>
 #include <3escore/shapes/Shapes.h>
 #include <3escore/shapes/SimpleMesh.h>
@@ -25,6 +28,7 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -534,6 +538,12 @@ TEST(Shapes, Mesh)
                                 Quaternionf().setAxisAngle(Vector3f(1, 1, 1), degToRad(18.0f)),
                                 Vector3f(1.0f, 1.2f, 0.8f)))
               .setColours(colours));
+
+  // V> Test clones copy normals and colours.
+  MeshShape mesh(DrawType::Triangles, Id(42u), DataBuffer(vertices), DataBuffer(indices));
+  mesh.setNormals(DataBuffer(normals)).setColours(colours);
+  const auto clone = mesh.clone();
+  validateShape(static_cast<const MeshShape &>(*clone), mesh, {});
 }
 
 TEST(Shapes, Plane)
@@ -559,6 +569,64 @@ TEST(Shapes, PointCloud)
   testShape(MeshSet(&cloud, Id(42u)));
 }
 
+TEST(Shapes, DecimatedPoints)
+{
+  constexpr unsigned kPointCount = 1000u;
+  constexpr unsigned kStride = 3u;
+  constexpr unsigned kDecimatedCount = (kPointCount + kStride - 1u) / kStride;
+  std::vector<double> vertices(3u * kPointCount);
+  std::vector<int16_t> normals(3u * kPointCount);
+  std::vector<uint32_t> colours(kPointCount);
+  for (unsigned i = 0; i < kPointCount; ++i)
+  {
+    for (unsigned j = 0; j < 3u; ++j)
+    {
+      vertices[3u * i + j] = 0.5 * i + j;
+      normals[3u * i + j] = static_cast<int16_t>(-int(i) + int(j));
+    }
+    colours[i] = ColourSet::predefined(ColourSet::Standard).cycle(i).colour32();
+  }
+
+  MeshShape mesh(DrawType::Points, Id(42u), DataBuffer(vertices.data(), kPointCount, 3u));
+  mesh.setNormals(DataBuffer(normals.data(), kPointCount, 3u));
+  mesh.setColours(DataBuffer(colours));
+
+  // Integer normal and colour streams are decimated along with the vertices.
+  const auto decimated = mesh.decimatedPoints(kStride);
+  ASSERT_EQ(decimated.vertices().count(), kDecimatedCount);
+  ASSERT_EQ(decimated.normals().count(), kDecimatedCount);
+  ASSERT_EQ(decimated.colours().count(), kDecimatedCount);
+  EXPECT_EQ(decimated.normals().type(), DctInt16);
+  EXPECT_EQ(decimated.colours().type(), DctUInt32);
+  for (unsigned i = 0; i < kDecimatedCount; ++i)
+  {
+    const unsigned source = i * kStride;
+    for (unsigned j = 0; j < 3u; ++j)
+    {
+      EXPECT_EQ(decimated.vertices().get<double>(i, j), vertices[3u * source + j]);
+      EXPECT_EQ(decimated.normals().get<int16_t>(i, j), normals[3u * source + j]);
+    }
+    EXPECT_EQ(decimated.colours().get<uint32_t>(i), colours[source]);
+  }
+
+  // A uniform normal is shared by all vertices and is not decimated.
+  MeshShape uniform(DrawType::Points, Id(43u), DataBuffer(vertices.data(), kPointCount, 3u));
+  uniform.setUniformNormal(Vector3f(0, 0, 1));
+  const auto uniform_decimated = uniform.decimatedPoints(kStride);
+  EXPECT_EQ(uniform_decimated.vertices().count(), kDecimatedCount);
+  EXPECT_EQ(uniform_decimated.normals().count(), 1u);
+
+  // Indexed meshes are not decimated.
+  std::vector<uint32_t> indices(kPointCount);
+  for (unsigned i = 0; i < kPointCount; ++i)
+  {
+    indices[i] = i;
+  }
+  MeshShape indexed(DrawType::Points, Id(44u), DataBuffer(vertices.data(), kPointCount, 3u),
+                    DataBuffer(indices));
+  EXPECT_EQ(indexed.decimatedPoints(kStride).vertices().count(), kPointCount);
+}
+
 TEST(Shapes, Pose)
 {
   testShape(Pose(Id(42u), Transform(Vector3f(1.2f, 2.3f, 3.4f),
@@ -603,6 +671,134 @@ TEST(Shapes, Text3D)
                    Directional(Vector3f(1.2f, 2.3f, 3.4f), Vector3f(1, 2, 3).normalised(), 15)));
 }
 
+/// Apply the mesh component messages collated in @p collated to @p mesh .
+/// @return The number of component data messages decoded.
+unsigned applyMutableMeshUpdate(CollatedPacket &collated, SimpleMesh &mesh)
+{
+  EXPECT_TRUE(collated.finalise());
+  unsigned byte_count = 0;
+  const uint8_t *bytes = collated.buffer(byte_count);
+  // Large collated packets are finalised as PFExtended packets: skip the extended payload size.
+  const PacketReader collated_reader(reinterpret_cast<const PacketHeader *>(bytes));
+  unsigned cursor = CollatedPacket::InitialCursorOffset + collated_reader.payloadOffset();
+  const unsigned end = cursor + collated.collatedBytes();
+  unsigned data_messages = 0;
+  while (cursor < end)
+  {
+    PacketReader reader(reinterpret_cast<const PacketHeader *>(bytes + cursor));
+    EXPECT_EQ(reader.routingId(), MtMesh);
+    switch (reader.messageId())
+    {
+    case MmtVertex:
+    case MmtIndex:
+    case MmtVertexColour:
+    case MmtNormal:
+    case MmtUv:
+      EXPECT_TRUE(mesh.readTransfer(reader.messageId(), reader));
+      ++data_messages;
+      break;
+    default:
+      break;
+    }
+    cursor += reader.packetSize();
+  }
+  return data_messages;
+}
+
+
+TEST(Shapes, MutableMeshCoalesce)
+{
+  constexpr unsigned kVertexCount = 4096u;
+  constexpr unsigned kRandomEdits = 2000u;
+  constexpr unsigned kSweepWindow = 64u;
+  constexpr unsigned kSweepStep = 16u;
+  const auto components = MeshComponentFlag::Vertex | MeshComponentFlag::Colour;
+
+  MutableMesh mesh(1u, DrawType::Points, components);
+  SimpleMesh received(1u, kVertexCount, 0u, DrawType::Points, components);
+  // Large, uncompressed collation buffer to count the bytes emitted per update.
+  CollatedPacket collated(0xffffu, 0xffffffffu);
+
+  std::vector<Vector3f> vertices(kVertexCount);
+  std::vector<uint32_t> colours(kVertexCount);
+  for (unsigned i = 0; i < kVertexCount; ++i)
+  {
+    vertices[i] = Vector3f(static_cast<float>(i), 0, 0);
+    colours[i] = i;
+  }
+
+  // Initial definition: a single contiguous run per component.
+  mesh.setVertexCount(kVertexCount);
+  mesh.setVertices(0u, vertices.data(), kVertexCount);
+  mesh.setColours(0u, colours.data(), kVertexCount);
+  mesh.update(&collated);
+  const unsigned define_messages = applyMutableMeshUpdate(collated, received);
+  const unsigned define_bytes = collated.collatedBytes();
+  // Each component must have been batched into a handful of packets.
+  EXPECT_LT(define_messages, 2u * kVertexCount / 1000u);
+
+  // Bytes emitted for editing a single vertex and colour: the cost of each edit without coalescing.
+  const uint32_t single_colour = 0xffffffffu;
+  mesh.setVertex(0u, Vector3f(0, 0, -1));
+  mesh.setColours(0u, &single_colour, 1u);
+  collated.reset();
+  mesh.update(&collated);
+  EXPECT_EQ(applyMutableMeshUpdate(collated, received), 2u);
+  const unsigned single_edit_bytes = collated.collatedBytes();
+
+  // Random edits, including repeated writes to the same vertex.
+  std::mt19937 rand_engine(42u);
+  std::uniform_int_distribution<unsigned> index_rand(0u, kVertexCount - 1u);
+  unsigned random_writes = 0;
+  for (unsigned i = 0; i < kRandomEdits; ++i)
+  {
+    const unsigned index = index_rand(rand_engine);
+    const Vector3f vertex(static_cast<float>(index), static_cast<float>(i), 0);
+    random_writes += mesh.setVertex(index, vertex);
+    random_writes += mesh.setColours(index, &i, 1u);
+  }
+  collated.reset();
+  mesh.update(&collated);
+  const unsigned random_messages = applyMutableMeshUpdate(collated, received);
+  const unsigned random_bytes = collated.collatedBytes();
+  EXPECT_LT(random_messages, random_writes);
+  // Repeated and adjacent edits must be merged, at least halving the bytes of individual edits.
+  EXPECT_LT(random_bytes, (random_writes / 2u) * single_edit_bytes / 2u);
+
+  // Sweeping edits: overlapping windows moving across the mesh.
+  unsigned sweep_writes = 0;
+  for (unsigned start = 0; start + kSweepWindow <= kVertexCount; start += kSweepStep)
+  {
+    for (unsigned i = 0; i < kSweepWindow; ++i)
+    {
+      vertices[start + i] = Vector3f(static_cast<float>(start), static_cast<float>(i), 1);
+      colours[start + i] = start + i;
+    }
+    sweep_writes += mesh.setVertices(start, vertices.data() + start, kSweepWindow);
+    sweep_writes += mesh.setColours(start, colours.data() + start, kSweepWindow);
+  }
+  collated.reset();
+  mesh.update(&collated);
+  const unsigned sweep_messages = applyMutableMeshUpdate(collated, received);
+  const unsigned sweep_bytes = collated.collatedBytes();
+  // Overlapping windows coalesce into one run per component.
+  EXPECT_LE(sweep_messages, define_messages);
+
+  // The windows overlap, writing every vertex several times, but the sweep must emit each vertex
+  // once: exactly the bytes of the initial definition.
+  EXPECT_GT(sweep_writes, 2u * kVertexCount);
+  EXPECT_EQ(sweep_bytes, define_bytes);
+
+  // Validate the receiver matches the final mesh state.
+  const SimpleMesh &reference = mesh.meshResource();
+  ASSERT_EQ(reference.vertexCount(), kVertexCount);
+  for (unsigned i = 0; i < kVertexCount; ++i)
+  {
+    EXPECT_EQ(received.rawVertices()[i], reference.rawVertices()[i]) << "vertex " << i;
+    EXPECT_EQ(received.rawColours()[i], reference.rawColours()[i]) << "colour " << i;
+  }
+}
+
 TEST(Shapes, FileStream)
 {
   const char *fileName = "sphere-stream.3es";
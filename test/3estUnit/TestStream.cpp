@@ -195,4 +195,67 @@ TEST(Stream, PacketBuffer)
   EXPECT_EQ(restored_info.coordinate_frame, expected_server_info.coordinate_frame);
   EXPECT_EQ(final_frame_count, expected_frame_count);
 }
+
+TEST(Stream, PacketBufferDirect)
+{
+  std::stringstream stream;
+  ServerInfoMessage expected_server_info = {};
+  const uint32_t expected_frame_count = 42u;
+  initDefaultServerInfo(&expected_server_info);
+  streamutil::initialiseStream(stream, &expected_server_info);
+  ASSERT_TRUE(streamutil::finaliseStream(stream, expected_frame_count, &expected_server_info));
+  stream.flush();
+
+  // Repeat the stream several times in one buffer, then read it in blocks which are not aligned
+  // to packet boundaries, writing directly into the PacketBuffer and extracting all packets. Small
+  // blocks split packet markers across reads.
+  const auto str = stream.str();
+  const unsigned repeat_count = 5;
+  std::vector<uint8_t> buffer;
+  for (unsigned i = 0; i < repeat_count; ++i)
+  {
+    std::copy(str.begin(), str.end(), back_inserter(buffer));
+  }
+
+  for (const size_t block_size : { size_t(3), size_t(16), size_t(21), size_t(100), buffer.size() })
+  {
+    PacketBuffer packet_buffer(16u);
+    std::vector<uint8_t> packet_data;
+    unsigned server_info_count = 0;
+    unsigned frame_count_count = 0;
+
+    for (size_t i = 0; i < buffer.size(); i += block_size)
+    {
+      const size_t copy_count = std::min<size_t>(block_size, buffer.size() - i);
+      uint8_t *dst = packet_buffer.writeBuffer(copy_count);
+      ASSERT_NE(dst, nullptr);
+      std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(i),
+                buffer.begin() + static_cast<std::ptrdiff_t>(i + copy_count), dst);
+      packet_buffer.commitBytes(copy_count);
+
+      while (const auto *packet = packet_buffer.extractPacket(packet_data))
+      {
+        PacketReader reader(packet);
+        if (reader.routingId() == MtServerInfo)
+        {
+          ServerInfoMessage restored_info = {};
+          EXPECT_TRUE(restored_info.read(reader));
+          EXPECT_EQ(restored_info.time_unit, expected_server_info.time_unit);
+          ++server_info_count;
+        }
+        else if (reader.routingId() == MtControl && reader.messageId() == CIdFrameCount)
+        {
+          ControlMessage msg;
+          EXPECT_TRUE(msg.read(reader));
+          EXPECT_EQ(msg.value32, expected_frame_count);
+          ++frame_count_count;
+        }
+      }
+    }
+
+    EXPECT_EQ(server_info_count, repeat_count) << "block size " << block_size;
+    EXPECT_EQ(frame_count_count, repeat_count) << "block size " << block_size;
+    EXPECT_EQ(packet_buffer.pendingBytes(), 0u);
+  }
+}
 }  // namespace tes
@@ -0,0 +1,195 @@
+//
+// author: Kazys Stepanas
+//
+
+#include "TestCommon.h"
+
+#include <3esfilter/StreamState.h>
+
+#include <3escore/MeshMessages.h>
+#include <3escore/Messages.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketWriter.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+namespace tes
+{
+namespace
+{
+using Packet = std::vector<uint8_t>;
+
+/// Build a packet with the given routing and message IDs and a payload of @p values .
+template <typename... Args>
+Packet makePacket(uint16_t routing_id, uint16_t message_id, Args... values)
+{
+  std::array<uint8_t, 256> buffer = {};
+  PacketWriter writer(buffer.data(), buffer.size(), routing_id, message_id);
+  (writer.writeElement(values), ...);
+  writer.finalise();
+  return Packet(buffer.data(), buffer.data() + writer.packetSize());
+}
+
+/// Build an object message for @p id . The @p tag makes each packet unique.
+Packet objectPacket(uint16_t message_id, uint32_t id, uint32_t tag)
+{
+  return makePacket(SIdSphere, message_id, id, tag);
+}
+
+/// Build an object update message for @p id with the given @p flags .
+Packet updatePacket(uint32_t id, uint16_t flags, uint32_t tag)
+{
+  return makePacket(SIdSphere, OIdUpdate, id, flags, tag);
+}
+
+/// Build a mesh resource message for @p mesh_id .
+Packet meshPacket(uint16_t message_id, uint32_t mesh_id, uint32_t tag)
+{
+  return makePacket(MtMesh, message_id, mesh_id, tag);
+}
+
+void add(StreamState &state, const Packet &packet)
+{
+  const PacketReader reader(reinterpret_cast<const PacketHeader *>(packet.data()));
+  state.add(reader);
+}
+
+std::vector<Packet> written(const StreamState &state)
+{
+  std::vector<Packet> packets;
+  state.write([&packets](const uint8_t *data, uint32_t byte_count) {
+    packets.emplace_back(data, data + byte_count);
+  });
+  return packets;
+}
+}  // namespace
+
+
+TEST(StreamState, Objects)
+{
+  StreamState state;
+  const auto create = objectPacket(OIdCreate, 1u, 0u);
+  const auto data = objectPacket(OIdData, 1u, 1u);
+  add(state, create);
+  add(state, data);
+
+  // Transient objects are not tracked.
+  add(state, objectPacket(OIdCreate, 0u, 2u));
+  add(state, objectPacket(OIdData, 0u, 3u));
+  // Destroyed objects are removed.
+  add(state, objectPacket(OIdCreate, 2u, 4u));
+  add(state, objectPacket(OIdData, 2u, 5u));
+  add(state, objectPacket(OIdDestroy, 2u, 6u));
+  // Messages for unknown objects are ignored.
+  add(state, objectPacket(OIdData, 3u, 7u));
+  add(state, updatePacket(3u, 0u, 8u));
+
+  EXPECT_EQ(written(state), std::vector<Packet>({ create, data }));
+
+  // A second create replaces the object.
+  const auto recreate = objectPacket(OIdCreate, 1u, 9u);
+  add(state, recreate);
+  EXPECT_EQ(written(state), std::vector<Packet>({ recreate }));
+}
+
+
+TEST(StreamState, Updates)
+{
+  StreamState state;
+  const auto create = objectPacket(OIdCreate, 1u, 0u);
+  const auto full = updatePacket(1u, 0u, 1u);
+  const auto position = updatePacket(1u, UFUpdateMode | UFPosition, 2u);
+  const auto colour = updatePacket(1u, UFUpdateMode | UFColour, 3u);
+  const auto position2 = updatePacket(1u, UFUpdateMode | UFPosition, 4u);
+  const auto position_colour = updatePacket(1u, UFUpdateMode | UFPosition | UFColour, 5u);
+  add(state, create);
+  add(state, full);
+  add(state, position);
+  add(state, colour);
+  add(state, position_colour);
+  add(state, position2);
+
+  // Partial updates only supersede earlier updates of the same attributes.
+  EXPECT_EQ(written(state),
+            std::vector<Packet>({ create, full, colour, position_colour, position2 }));
+
+  // A full update supersedes all earlier updates.
+  const auto full2 = updatePacket(1u, 0u, 6u);
+  add(state, full2);
+  EXPECT_EQ(written(state), std::vector<Packet>({ create, full2 }));
+
+  // Object data are kept alongside the updates.
+  const auto data = objectPacket(OIdData, 1u, 7u);
+  add(state, data);
+  EXPECT_EQ(written(state), std::vector<Packet>({ create, data, full2 }));
+}
+
+
+TEST(StreamState, Resources)
+{
+  StreamState state;
+  const auto create = meshPacket(MmtCreate, 1u, 0u);
+  const auto vertices = meshPacket(MmtVertex, 1u, 1u);
+  const auto indices = meshPacket(MmtIndex, 1u, 2u);
+  add(state, create);
+  add(state, vertices);
+  add(state, indices);
+  EXPECT_EQ(written(state), std::vector<Packet>({ create, vertices, indices }));
+
+  // A redefinition drops all but the original create message.
+  const auto redefine = meshPacket(MmtRedefine, 1u, 3u);
+  const auto vertices2 = meshPacket(MmtVertex, 1u, 4u);
+  add(state, redefine);
+  add(state, vertices2);
+  EXPECT_EQ(written(state), std::vector<Packet>({ create, redefine, vertices2 }));
+
+  // Destroyed resources are removed and data for unknown resources ignored.
+  add(state, meshPacket(MmtCreate, 2u, 5u));
+  add(state, meshPacket(MmtDestroy, 2u, 6u));
+  add(state, meshPacket(MmtVertex, 3u, 7u));
+  EXPECT_EQ(written(state), std::vector<Packet>({ create, redefine, vertices2 }));
+}
+
+
+TEST(StreamState, Order)
+{
+  StreamState state;
+  // Add in the reverse of the write order.
+  const auto object2 = objectPacket(OIdCreate, 2u, 0u);
+  const auto object1 = objectPacket(OIdCreate, 1u, 1u);
+  const auto mesh = meshPacket(MmtCreate, 1u, 2u);
+  const auto camera = makePacket(MtCamera, 0, uint8_t(1u), uint8_t(0u));
+  const auto category2 = makePacket(MtCategory, CMIdName, uint16_t(2u), uint16_t(0u));
+  const auto category1 = makePacket(MtCategory, CMIdName, uint16_t(1u), uint16_t(0u));
+  const auto category1_renamed = makePacket(MtCategory, CMIdName, uint16_t(1u), uint16_t(1u));
+  const auto frame = makePacket(MtControl, CIdCoordinateFrame, uint32_t(0u), uint32_t(2u));
+  for (const auto &packet : { object2, object1, mesh, camera, category2, category1,
+                              category1_renamed, frame })
+  {
+    add(state, packet);
+  }
+
+  // Objects are written in creation order. Categories use the latest definition.
+  EXPECT_EQ(written(state), std::vector<Packet>({ frame, category1_renamed, category2, camera, mesh,
+                                                  object2, object1 }));
+}
+
+
+TEST(StreamState, Reset)
+{
+  StreamState state;
+  add(state, makePacket(MtCategory, CMIdName, uint16_t(1u), uint16_t(0u)));
+  add(state, makePacket(MtCamera, 0, uint8_t(1u), uint8_t(0u)));
+  add(state, meshPacket(MmtCreate, 1u, 0u));
+  add(state, objectPacket(OIdCreate, 1u, 1u));
+  add(state, makePacket(MtControl, CIdReset, uint32_t(0u), uint32_t(0u)));
+  EXPECT_TRUE(written(state).empty());
+
+  const auto create = objectPacket(OIdCreate, 1u, 2u);
+  add(state, create);
+  EXPECT_EQ(written(state), std::vector<Packet>({ create }));
+}
+}  // namespace tes
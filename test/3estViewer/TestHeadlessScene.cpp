@@ -0,0 +1,303 @@
+//
+// author: Kazys Stepanas
+//
+
+#include "3estViewer/TestViewerConfig.h"
+
+#include <3esview/HeadlessScene.h>
+#include <3esview/data/Snapshot.h>
+#include <3esview/handler/Category.h>
+#include <3esview/handler/MeshResource.h>
+#include <3esview/handler/Shape.h>
+#include <3esview/painter/ShapePainter.h>
+
+#include <3escore/Messages.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketWriter.h>
+#include <3escore/ResourcePacker.h>
+#include <3escore/shapes/Box.h>
+#include <3escore/shapes/SimpleMesh.h>
+#include <3escore/shapes/Sphere.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+// Note: these tests create no OpenGL context.
+
+namespace tes::view
+{
+namespace
+{
+/// Helper for writing messages into a @c HeadlessScene .
+class SceneWriter
+{
+public:
+  explicit SceneWriter(HeadlessScene &scene)
+    : _scene(scene)
+    , _buffer(0xffffu)
+    , _writer(_buffer.data(), static_cast<uint16_t>(_buffer.size()))
+  {}
+
+  PacketWriter &writer() { return _writer; }
+
+  /// Finalise and process the current message.
+  void commit()
+  {
+    _writer.finalise();
+    PacketReader reader(reinterpret_cast<const PacketHeader *>(_writer.data()));
+    _scene.processMessage(reader);
+  }
+
+  void create(const Shape &shape)
+  {
+    shape.writeCreate(_writer);
+    commit();
+  }
+
+  void update(const Shape &shape)
+  {
+    shape.writeUpdate(_writer);
+    commit();
+  }
+
+  void destroy(const Shape &shape)
+  {
+    shape.writeDestroy(_writer);
+    commit();
+  }
+
+  void category(uint16_t id, const char *name)
+  {
+    CategoryNameMessage msg = {};
+    msg.category_id = id;
+    msg.default_active = 1u;
+    msg.name = name;
+    msg.name_length = static_cast<uint16_t>(std::strlen(name));
+    _writer.reset(MtCategory, CategoryNameMessage::MessageId);
+    msg.write(_writer);
+    commit();
+  }
+
+  void resource(const Resource &resource)
+  {
+    ResourcePacker packer;
+    packer.transfer(&resource);
+    while (packer.isValid() && packer.nextPacket(_writer, 0xff00u))
+    {
+      commit();
+    }
+  }
+
+private:
+  HeadlessScene &_scene;
+  std::vector<uint8_t> _buffer;
+  PacketWriter _writer;
+};
+
+
+std::shared_ptr<painter::ShapePainter> shapePainter(const HeadlessScene &scene,
+                                                    uint16_t routing_id)
+{
+  const auto handler = std::dynamic_pointer_cast<handler::Shape>(scene.messageHandler(routing_id));
+  return (handler) ? handler->painter() : nullptr;
+}
+
+
+bool readPosition(const HeadlessScene &scene, uint16_t routing_id, const Id &id,
+                  Magnum::Vector3 &position)
+{
+  const auto painter = shapePainter(scene, routing_id);
+  Magnum::Matrix4 transform = {};
+  Magnum::Color4 colour = {};
+  if (!painter || !painter->readShape(id, transform, colour))
+  {
+    return false;
+  }
+  position = transform.translation();
+  return true;
+}
+}  // namespace
+
+
+TEST(HeadlessScene, Handlers)
+{
+  HeadlessScene scene;
+  // Check the scene routes to the same handlers as the viewer.
+  const std::vector<uint16_t> routing_ids = { MtCategory, MtCamera,   MtMesh,       SIdSphere,
+                                               SIdBox,     SIdCone,    SIdCylinder,  SIdCapsule,
+                                               SIdPlane,   SIdStar,    SIdArrow,     SIdPose,
+                                               SIdText2D,  SIdText3D,  SIdMeshShape, SIdMeshSet };
+  for (const auto routing_id : routing_ids)
+  {
+    const auto handler = scene.messageHandler(routing_id);
+    ASSERT_NE(handler, nullptr) << routing_id;
+    EXPECT_TRUE(handler->hasModeFlag(handler::Message::ModeFlag::Headless)) << routing_id;
+  }
+  EXPECT_NE(shapePainter(scene, SIdSphere), nullptr);
+}
+
+
+TEST(HeadlessScene, Shapes)
+{
+  HeadlessScene scene;
+  SceneWriter writer(scene);
+
+  Sphere moved(Id(1u), Spherical(Vector3f(0, 0, 0), 1.0f));
+  const Sphere destroyed(Id(2u), Spherical(Vector3f(1, 0, 0), 1.0f));
+  const Box box(Id(1u), Transform(Vector3f(0, 2, 0)));
+  writer.create(moved);
+  writer.create(destroyed);
+  writer.create(box);
+
+  // Nothing is visible until the frame is effected.
+  Magnum::Vector3 position = {};
+  EXPECT_FALSE(readPosition(scene, SIdSphere, moved.id(), position));
+  scene.updateToFrame(1);
+  ASSERT_TRUE(readPosition(scene, SIdSphere, moved.id(), position));
+  EXPECT_EQ(position, Magnum::Vector3(0, 0, 0));
+  EXPECT_TRUE(readPosition(scene, SIdSphere, destroyed.id(), position));
+  ASSERT_TRUE(readPosition(scene, SIdBox, box.id(), position));
+  EXPECT_EQ(position, Magnum::Vector3(0, 2, 0));
+
+  moved.setPosition(Vector3d(3, 0, 0));
+  writer.update(moved);
+  writer.destroy(destroyed);
+  scene.updateToFrame(2);
+
+  ASSERT_TRUE(readPosition(scene, SIdSphere, moved.id(), position));
+  EXPECT_EQ(position, Magnum::Vector3(3, 0, 0));
+  EXPECT_FALSE(readPosition(scene, SIdSphere, destroyed.id(), position));
+  EXPECT_TRUE(readPosition(scene, SIdBox, box.id(), position));
+
+  const auto stats = scene.stats();
+  EXPECT_EQ(stats.message_count, 5u);
+  EXPECT_EQ(stats.unhandled_count, 0u);
+  EXPECT_EQ(stats.frame_count, 2u);
+  EXPECT_EQ(scene.frame(), 2u);
+
+  scene.reset();
+  EXPECT_FALSE(readPosition(scene, SIdSphere, moved.id(), position));
+  EXPECT_FALSE(readPosition(scene, SIdBox, box.id(), position));
+}
+
+
+TEST(HeadlessScene, PartialUpdates)
+{
+  HeadlessScene scene;
+  SceneWriter writer(scene);
+
+  Sphere sphere(Id(1u), Spherical(Vector3f(0, 0, 0), 1.0f));
+  sphere.setColour(Colour(0, 255, 0));
+  writer.create(sphere);
+
+  // Compact partial updates only carry the flagged attributes. The rest must be preserved.
+  sphere.setPosition(Vector3d(1, 2, 3));
+  sphere.setColour(Colour(255, 0, 0));
+  sphere.setFlags(static_cast<uint16_t>(UFUpdateMode | UFCompact | UFPosition));
+  writer.update(sphere);
+  scene.updateToFrame(1);
+
+  const auto painter = shapePainter(scene, SIdSphere);
+  ASSERT_NE(painter, nullptr);
+  Magnum::Matrix4 transform = {};
+  Magnum::Color4 colour = {};
+  ASSERT_TRUE(painter->readShape(sphere.id(), transform, colour));
+  EXPECT_EQ(transform.translation(), Magnum::Vector3(1, 2, 3));
+  EXPECT_EQ(colour, Magnum::Color4(0, 1, 0, 1));
+
+  sphere.setPosition(Vector3d(0, 0, 0));
+  sphere.setFlags(static_cast<uint16_t>(UFUpdateMode | UFCompact | UFColour));
+  writer.update(sphere);
+  scene.updateToFrame(2);
+
+  ASSERT_TRUE(painter->readShape(sphere.id(), transform, colour));
+  EXPECT_EQ(transform.translation(), Magnum::Vector3(1, 2, 3));
+  EXPECT_EQ(colour, Magnum::Color4(1, 0, 0, 1));
+}
+
+
+TEST(HeadlessScene, Categories)
+{
+  HeadlessScene scene;
+  SceneWriter writer(scene);
+
+  writer.category(1u, "first");
+  writer.category(2u, "second");
+  scene.updateToFrame(1);
+
+  auto categories = scene.categoryHandler().categories();
+  painter::CategoryInfo info = {};
+  ASSERT_TRUE(categories->lookup(1u, info));
+  EXPECT_EQ(info.name, "first");
+  ASSERT_TRUE(categories->lookup(2u, info));
+  EXPECT_EQ(info.name, "second");
+  EXPECT_TRUE(categories->isActive(2u));
+}
+
+
+TEST(HeadlessScene, MeshResource)
+{
+  HeadlessScene scene;
+  SceneWriter writer(scene);
+
+  const std::vector<Vector3f> vertices = { Vector3f(0, 0, 0), Vector3f(1, 0, 0),
+                                           Vector3f(0, 1, 0) };
+  SimpleMesh mesh(7u, vertices.size(), 0u, DrawType::Points, MeshComponentFlag::Vertex);
+  mesh.setVertices(0, vertices.data(), vertices.size());
+  writer.resource(mesh);
+  scene.updateToFrame(1);
+
+  const auto resources =
+    std::dynamic_pointer_cast<handler::MeshResource>(scene.messageHandler(MtMesh));
+  ASSERT_NE(resources, nullptr);
+  const auto resource = resources->get(mesh.id()).resource();
+  ASSERT_NE(resource, nullptr);
+  EXPECT_EQ(resource->vertexCount(), vertices.size());
+  EXPECT_EQ(resource->drawType(0), static_cast<uint8_t>(DrawType::Points));
+}
+
+
+TEST(HeadlessScene, Unhandled)
+{
+  HeadlessScene scene;
+  SceneWriter writer(scene);
+
+  writer.writer().reset(static_cast<uint16_t>(SIdBuiltInLast + 1000u), 0);
+  writer.commit();
+
+  const auto stats = scene.stats();
+  EXPECT_EQ(stats.message_count, 1u);
+  EXPECT_EQ(stats.unhandled_count, 1u);
+}
+
+
+TEST(HeadlessScene, Snapshot)
+{
+  const auto path = std::filesystem::temp_directory_path() / "headless-scene-snapshot.bin";
+  HeadlessScene scene;
+  SceneWriter writer(scene);
+
+  writer.category(1u, "snapped");
+  const Sphere sphere(Id(1u), Spherical(Vector3f(1, 2, 3), 1.0f));
+  writer.create(sphere);
+  scene.updateToFrame(1);
+
+  ASSERT_TRUE(scene.saveSnapshot(path, {}).first);
+  // Snapshots share the viewer's binary format.
+  EXPECT_TRUE(data::Snapshot::isSnapshot(path));
+
+  HeadlessScene restored;
+  ASSERT_TRUE(restored.loadSnapshot(path));
+  restored.updateToFrame(1);
+  std::filesystem::remove(path);
+
+  Magnum::Vector3 position = {};
+  ASSERT_TRUE(readPosition(restored, SIdSphere, sphere.id(), position));
+  EXPECT_EQ(position, Magnum::Vector3(1, 2, 3));
+  auto categories = restored.categoryHandler().categories();
+  EXPECT_TRUE(categories->has(1u));
+}
+}  // namespace tes::view
@@ -250,6 +250,7 @@ TEST(Settings, Serialise)
   config.render.background_colour.setValue(tes::Colour(1, 2, 3));
   config.render.edl_radius.setValue(4);
   config.render.point_size.setValue(1.2f);
+  config.render.point_budget.setValue(1000000);
 
   config.connection.history.emplace_back("127.0.0.1", 1234);
   config.connection.history.emplace_back("1.2.3.4", 6789);
@@ -0,0 +1,123 @@
+//
+// author: Kazys Stepanas
+//
+
+#include "3estViewer/TestViewerConfig.h"
+
+#include "TestViewer.h"
+
+#include <3esview/ThirdEyeScene.h>
+#include <3esview/data/Snapshot.h>
+
+#include <3escore/FileConnection.h>
+#include <3escore/Messages.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketWriter.h>
+#include <3escore/shapes/MeshShape.h>
+#include <3escore/shapes/Sphere.h>
+
+#include <filesystem>
+#include <vector>
+
+// Note(KS): all the tests in this file are removed from CTest runs when TES_DISABLE_PAINTER_TESTS
+// is on. See CMakeLists.txt and TES_DISABLE_PAINTER_TESTS usage for details.
+
+namespace tes::view
+{
+namespace
+{
+void processShape(ThirdEyeScene &tes, PacketWriter &writer, const Shape &shape)
+{
+  shape.writeCreate(writer);
+  writer.finalise();
+  PacketReader create(reinterpret_cast<const PacketHeader *>(writer.data()));
+  tes.processMessage(create);
+  if (shape.isComplex())
+  {
+    unsigned progress = 0;
+    int status = 0;
+    while ((status = shape.writeData(writer, progress)) >= 0)
+    {
+      writer.finalise();
+      PacketReader data(reinterpret_cast<const PacketHeader *>(writer.data()));
+      tes.processMessage(data);
+      if (status == 0)
+      {
+        break;
+      }
+    }
+  }
+}
+
+/// Populate @p tes with many persistent spheres and a persistent point cloud.
+void populateScene(ThirdEyeScene &tes, unsigned sphere_count, unsigned point_count)
+{
+  std::vector<uint8_t> buffer(0xffffu);
+  PacketWriter writer(buffer.data(), static_cast<uint16_t>(buffer.size()));
+
+  for (unsigned i = 0; i < sphere_count; ++i)
+  {
+    const Sphere sphere(Id(i + 1), Spherical(Vector3f(static_cast<float>(i), 0, 0), 0.5f));
+    processShape(tes, writer, sphere);
+  }
+
+  std::vector<Vector3f> points(point_count);
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    points[i] = Vector3f(static_cast<float>(i), 1.0f, 0.0f);
+  }
+  processShape(tes, writer, MeshShape(DrawType::Points, Id(1), DataBuffer(points)));
+}
+}  // namespace
+
+
+TEST(Snapshot, RoundTrip)
+{
+  auto viewer = TestViewer::createViewer();
+  auto tes = viewer->tes();
+
+  populateScene(*tes, 20000, 100000);
+  tes->updateToFrame(1);
+  viewer->runFor(1);
+
+  const auto temp_dir = std::filesystem::temp_directory_path();
+  const auto snapshot_path = temp_dir / "3es_test_snapshot.bin";
+  const auto restored_path = temp_dir / "3es_test_snapshot_restored.bin";
+  const auto stream_path = temp_dir / "3es_test_snapshot.3es";
+
+  // Compare against the protocol message snapshot. See 3esbench for snapshot timings.
+  {
+    FileConnection out(stream_path.string(), ServerSettings());
+    EXPECT_TRUE(tes->saveSnapshot(out, []() { return false; }).first);
+  }
+
+  const auto [saved, frame_number] = tes->saveSnapshot(snapshot_path, []() { return false; });
+  ASSERT_TRUE(saved);
+  EXPECT_TRUE(data::Snapshot::isSnapshot(snapshot_path));
+  EXPECT_FALSE(data::Snapshot::isSnapshot(stream_path));
+
+  // Restore into a clean scene, then snapshot again. The content should match.
+  tes->reset();
+  EXPECT_TRUE(tes->loadSnapshot(snapshot_path));
+  tes->updateToFrame(frame_number);
+  viewer->runFor(1);
+  EXPECT_TRUE(tes->saveSnapshot(restored_path, []() { return false; }).first);
+
+  data::Snapshot original;
+  data::Snapshot restored;
+  ASSERT_TRUE(original.load(snapshot_path));
+  ASSERT_TRUE(restored.load(restored_path));
+  ASSERT_EQ(original.chunks.size(), restored.chunks.size());
+  for (size_t i = 0; i < original.chunks.size(); ++i)
+  {
+    EXPECT_EQ(original.chunks[i].routing_id, restored.chunks[i].routing_id);
+    EXPECT_EQ(original.chunks[i].format, restored.chunks[i].format);
+    // Content order may differ, but the sizes must match.
+    EXPECT_EQ(original.chunks[i].payload.data().size(), restored.chunks[i].payload.data().size());
+  }
+
+  std::filesystem::remove(snapshot_path);
+  std::filesystem::remove(restored_path);
+  std::filesystem::remove(stream_path);
+}
+}  // namespace tes::view
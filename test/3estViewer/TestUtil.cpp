@@ -5,6 +5,7 @@
 #include "3estViewer/TestViewerConfig.h"
 
 #include <3esview/util/ResourceList.h>
+#include <3esview/util/RoutingTable.h>
 
 #include <chrono>
 #include <iostream>
@@ -258,4 +259,34 @@ TEST(Util, ResourceList_Threads)
     ++expected_value;
   }
 }  // namespace tes::view
+
+
+TEST(Util, RoutingTable)
+{
+  util::RoutingTable<std::shared_ptr<Resource>> table;
+  EXPECT_EQ(table.size(), 0u);
+  EXPECT_EQ(table[0], nullptr);
+  EXPECT_EQ(table[42], nullptr);
+
+  auto resource = std::make_shared<Resource>();
+  resource->value = 42;
+  EXPECT_TRUE(table.set(42, resource));
+  EXPECT_EQ(table.size(), 43u);
+  EXPECT_EQ(table[42], resource);
+  EXPECT_EQ(table[41], nullptr);
+  EXPECT_EQ(table[43], nullptr);
+
+  // Largest valid ID.
+  const auto max_id = static_cast<uint32_t>(util::RoutingTable<int>::kMaxSize - 1u);
+  EXPECT_TRUE(table.set(max_id, resource));
+  EXPECT_EQ(table[max_id], resource);
+  // Out of range.
+  EXPECT_FALSE(table.set(max_id + 1u, resource));
+  EXPECT_EQ(table[max_id + 1u], nullptr);
+  EXPECT_EQ(table.size(), util::RoutingTable<int>::kMaxSize);
+
+  table.clear();
+  EXPECT_EQ(table.size(), 0u);
+  EXPECT_EQ(table[42], nullptr);
+}
 }  // namespace tes::view
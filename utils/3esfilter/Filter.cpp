@@ -0,0 +1,542 @@
+#include "StreamState.h"
+
+#include <3escore/CollatedPacket.h>
+#include <3escore/CollatedPacketDecoder.h>
+#include <3escore/Log.h>
+#include <3escore/Messages.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketStreamReader.h>
+#include <3escore/StreamUtil.h>
+#include <3escore/WriteBehindFile.h>
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+// Filters a .3es recording to a frame range and/or subset of routing IDs and categories,
+// re-collating and re-compressing the output. Reading and filtering are sequential, while
+// collation and compression of the output run in parallel over batches of frames.
+
+namespace tes
+{
+namespace
+{
+/// Target number of uncompressed bytes in each batch of frames encoded in parallel.
+constexpr size_t kBatchSize = 1024u * 1024u;
+/// Limit on the depth of the category hierarchy, guarding against cyclic definitions.
+constexpr unsigned kMaxCategoryDepth = 64u;
+
+enum class ParseResult
+{
+  Ok,
+  Help,
+  ParseError,
+  ValidationError
+};
+
+struct Options
+{
+  std::string input;
+  std::string output;
+  /// First input frame to write.
+  unsigned start_frame = 0;
+  /// Input frame at which to stop writing (exclusive). Zero for the end of the input.
+  unsigned end_frame = 0;
+  std::vector<unsigned> routing;
+  std::vector<unsigned> exclude_routing;
+  std::vector<unsigned> categories;
+  std::vector<unsigned> exclude_categories;
+  unsigned compression_level = static_cast<unsigned>(CompressionLevel::Default);
+  /// Number of threads used to collate and compress. Zero to use the hardware concurrency.
+  unsigned threads = 0;
+  bool no_collate = false;
+  bool quiet = false;
+};
+
+
+bool validate(const Options &opt)
+{
+  bool ok = true;
+  if (opt.input.empty())
+  {
+    log::error("Input file must be specified");
+    ok = false;
+  }
+  if (opt.output.empty())
+  {
+    log::error("Output file must be specified");
+    ok = false;
+  }
+  if (opt.end_frame && opt.end_frame <= opt.start_frame)
+  {
+    log::error("End frame must be after the start frame");
+    ok = false;
+  }
+  return ok;
+}
+
+
+ParseResult parseArgs(int argc, char *argv[], Options &opt)
+{
+  cxxopts::Options parser("3esfilter", "Trim and filter a 3es recording, re-collating the output.\n"
+                                       "Routing and category lists are comma separated IDs.");
+
+  // clang-format off
+  parser.add_options()
+    ("help", "Show command line help.")
+    ("file", "Data file to read (.3es)", cxxopts::value(opt.input))
+    ("o,output", "Data file to write (.3es)", cxxopts::value(opt.output))
+    ("s,start", "First input frame to write. The state at the start of this frame is written first.", cxxopts::value(opt.start_frame)->default_value(std::to_string(opt.start_frame)))
+    ("e,end", "Input frame at which to stop (exclusive). Zero to write to the end of the input.", cxxopts::value(opt.end_frame)->default_value(std::to_string(opt.end_frame)))
+    ("r,routing", "Routing IDs to keep. Server info and control messages are always kept.", cxxopts::value(opt.routing))
+    ("exclude-routing", "Routing IDs to remove.", cxxopts::value(opt.exclude_routing))
+    ("c,category", "Categories of shapes to keep, including their child categories.", cxxopts::value(opt.categories))
+    ("exclude-category", "Categories of shapes to remove, including their child categories.", cxxopts::value(opt.exclude_categories))
+    ("l,level", "Compression level [0, 4]. Zero to collate without compression.", cxxopts::value(opt.compression_level)->default_value(std::to_string(opt.compression_level)))
+    ("no-collate", "Write packets without collation or compression.", cxxopts::value(opt.no_collate))
+    ("threads", "Number of threads used to collate and compress. Zero for the hardware concurrency.", cxxopts::value(opt.threads)->default_value(std::to_string(opt.threads)))
+    ("q,quiet", "Run in quiet mode (disable non-critical logging).", cxxopts::value(opt.quiet))
+  ;
+  // clang-format on
+
+  parser.parse_positional({ "file" });
+
+  try
+  {
+    cxxopts::ParseResult parsed = parser.parse(argc, argv);
+
+    if (parsed.count("help"))
+    {
+      // Force output: don't log as that could be filtered by log level.
+      std::cout << parser.help() << std::endl;
+      // Help already shown.
+      return ParseResult::Help;
+    }
+
+    if (!validate(opt))
+    {
+      return ParseResult::ValidationError;
+    }
+  }
+  catch (const cxxopts::exceptions::parsing &e)
+  {
+    log::error("Argument error\n", e.what());
+    return ParseResult::ParseError;
+  }
+
+  return ParseResult::Ok;
+}
+
+
+/// Streams a recording through the configured filters into a new recording.
+class StreamFilter
+{
+public:
+  explicit StreamFilter(const Options &opt);
+
+  /// Run the filter.
+  /// @return True on success.
+  bool run();
+
+private:
+  /// Check if @p packet passes the routing and category filters, tracking category definitions and
+  /// object categories.
+  bool passes(const PacketReader &packet);
+  /// Check if @p category passes the category filters, considering its ancestors.
+  [[nodiscard]] bool categoryPasses(uint16_t category) const;
+
+  /// Add a packet to the current batch.
+  void emit(const uint8_t *data, uint32_t byte_count);
+  /// Write the file header, using @p server_info .
+  void writeHeader(const ServerInfoMessage &server_info);
+  /// Queue the current batch for encoding, then write completed batches until at most
+  /// @p max_pending remain queued.
+  void dispatch(size_t max_pending);
+
+  /// Collate and compress a batch of packets, flushing the collation at the end of each frame.
+  static std::vector<uint8_t> encode(const std::vector<uint8_t> &batch, bool collate,
+                                     unsigned compression_level);
+
+  Options _opt;
+  WriteBehindFile _writer;
+  StreamState _state;
+  std::unordered_set<unsigned> _routing;
+  std::unordered_set<unsigned> _exclude_routing;
+  std::unordered_set<unsigned> _categories;
+  std::unordered_set<unsigned> _exclude_categories;
+  /// Category parents from category definitions.
+  std::unordered_map<uint16_t, uint16_t> _category_parents;
+  /// Categories of live persistent objects, keyed by @c objectKey() .
+  std::unordered_map<uint64_t, uint16_t> _object_categories;
+  /// Current batch of uncompressed packets.
+  std::vector<uint8_t> _batch;
+  /// Batches being encoded, in stream order.
+  std::deque<std::future<std::vector<uint8_t>>> _pending;
+  size_t _max_pending = 1;
+  /// Current input frame number.
+  unsigned _frame = 0;
+  /// Number of frames written.
+  unsigned _frames_written = 0;
+  bool _header_written = false;
+};
+
+
+StreamFilter::StreamFilter(const Options &opt)
+  : _opt(opt)
+  , _routing(opt.routing.begin(), opt.routing.end())
+  , _exclude_routing(opt.exclude_routing.begin(), opt.exclude_routing.end())
+  , _categories(opt.categories.begin(), opt.categories.end())
+  , _exclude_categories(opt.exclude_categories.begin(), opt.exclude_categories.end())
+{
+  const unsigned threads = (opt.threads) ? opt.threads : std::thread::hardware_concurrency();
+  // Allow some queuing beyond the thread count so the encoders don't starve.
+  _max_pending = 2u * std::max(threads, 1u);
+  _batch.reserve(kBatchSize + std::numeric_limits<uint16_t>::max());
+}
+
+
+bool StreamFilter::run()
+{
+  std::ifstream in_stream(_opt.input, std::ios::binary);
+  if (!in_stream.is_open())
+  {
+    log::error("Unable to open file ", _opt.input);
+    return false;
+  }
+
+  if (!_writer.open(_opt.output))
+  {
+    log::error("Unable to open output file ", _opt.output);
+    return false;
+  }
+
+  PacketStreamReader reader(in_stream);
+  CollatedPacketDecoder decoder;
+  bool ok = true;
+  bool done = false;
+
+  while (!done && reader.isOk() && !reader.isEof())
+  {
+    const auto [header, status, pos] = reader.extractPacket();
+    if (!header)
+    {
+      if (status != PacketStreamReader::Status::End)
+      {
+        ok = false;
+        log::warn("Failed to load packet at ", pos);
+      }
+      break;
+    }
+
+    decoder.setPacket(header);
+    while (const auto *packet_header = decoder.next())
+    {
+      PacketReader packet(packet_header);
+      if (!packetVersionCompatible(packet.versionMajor(), packet.versionMinor()))
+      {
+        log::warn("Unsupported packet version: ", packet.versionMajor(), ".",
+                  packet.versionMinor());
+        continue;
+      }
+
+      const uint16_t routing_id = packet.routingId();
+      const uint16_t message_id = packet.messageId();
+
+      if (routing_id == MtServerInfo)
+      {
+        // Only the first server info is written, as part of the header.
+        if (!_header_written)
+        {
+          ServerInfoMessage server_info = {};
+          if (!server_info.read(packet))
+          {
+            initDefaultServerInfo(&server_info);
+          }
+          writeHeader(server_info);
+        }
+        continue;
+      }
+
+      if (!_header_written)
+      {
+        ServerInfoMessage server_info = {};
+        initDefaultServerInfo(&server_info);
+        writeHeader(server_info);
+      }
+
+      // The header carries our own frame count. Keyframes refer to the input stream.
+      if (routing_id == MtControl && (message_id == CIdFrameCount || message_id == CIdKeyframe))
+      {
+        continue;
+      }
+
+      if (!passes(packet))
+      {
+        continue;
+      }
+
+      const bool frame_end = routing_id == MtControl && message_id == CIdFrame;
+      if (_frame < _opt.start_frame)
+      {
+        // Before the range: track state only.
+        if (!frame_end)
+        {
+          _state.add(packet);
+        }
+        else if (++_frame == _opt.start_frame)
+        {
+          _state.write(
+            [this](const uint8_t *data, uint32_t byte_count) { emit(data, byte_count); });
+          _state.clear();
+        }
+        continue;
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      emit(reinterpret_cast<const uint8_t *>(packet_header), packet.packetSize());
+
+      if (frame_end)
+      {
+        ++_frame;
+        ++_frames_written;
+        if (_batch.size() >= kBatchSize)
+        {
+          dispatch(_max_pending);
+        }
+
+        if (_opt.end_frame && _frame >= _opt.end_frame)
+        {
+          done = true;
+          break;
+        }
+      }
+    }
+  }
+
+  dispatch(0);
+  const auto frames_written = _frames_written;
+  _writer.close(
+    [frames_written](std::fstream &file) { streamutil::finaliseStream(file, frames_written); });
+
+  if (!_opt.quiet)
+  {
+    const auto stats = _writer.stats();
+    std::cout << "Wrote " << _frames_written << " frames, " << stats.bytes_written << " bytes"
+              << std::endl;
+  }
+
+  return ok;
+}
+
+
+bool StreamFilter::passes(const PacketReader &packet)
+{
+  const uint16_t routing_id = packet.routingId();
+  const uint16_t message_id = packet.messageId();
+
+  if (routing_id == MtControl)
+  {
+    return true;
+  }
+
+  if (routing_id == MtCategory && message_id == CMIdName)
+  {
+    // Track the category hierarchy regardless of routing filters.
+    PacketReader reader(&packet.packet());
+    uint16_t category_id = 0;
+    uint16_t parent_id = 0;
+    if (reader.readElement(category_id) == sizeof(category_id) &&
+        reader.readElement(parent_id) == sizeof(parent_id))
+    {
+      _category_parents[category_id] = parent_id;
+    }
+  }
+
+  if (!_routing.empty() && _routing.find(routing_id) == _routing.end() ||
+      _exclude_routing.find(routing_id) != _exclude_routing.end())
+  {
+    return false;
+  }
+
+  if (routing_id < ShapeHandlersIDStart || _categories.empty() && _exclude_categories.empty())
+  {
+    return true;
+  }
+
+  // Object messages lead with the object ID. Create messages follow with the category.
+  PacketReader reader(&packet.packet());
+  uint32_t id = 0;
+  reader.readElement(id);
+  const uint64_t key = objectKey(routing_id, id);
+
+  if (message_id == OIdCreate)
+  {
+    uint16_t category = 0;
+    reader.readElement(category);
+    if (id)
+    {
+      _object_categories[key] = category;
+    }
+    return categoryPasses(category);
+  }
+
+  const auto search = _object_categories.find(key);
+  // Keep objects of unknown category.
+  const bool pass = search == _object_categories.end() || categoryPasses(search->second);
+  if (message_id == OIdDestroy && search != _object_categories.end())
+  {
+    _object_categories.erase(search);
+  }
+  return pass;
+}
+
+
+bool StreamFilter::categoryPasses(uint16_t category) const
+{
+  bool included = _categories.empty();
+  for (unsigned depth = 0; depth < kMaxCategoryDepth; ++depth)
+  {
+    if (_exclude_categories.find(category) != _exclude_categories.end())
+    {
+      return false;
+    }
+    included = included || _categories.find(category) != _categories.end();
+
+    const auto parent = _category_parents.find(category);
+    if (parent == _category_parents.end() || parent->second == category)
+    {
+      break;
+    }
+    category = parent->second;
+  }
+  return included;
+}
+
+
+void StreamFilter::emit(const uint8_t *data, uint32_t byte_count)
+{
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  _batch.insert(_batch.end(), data, data + byte_count);
+}
+
+
+void StreamFilter::writeHeader(const ServerInfoMessage &server_info)
+{
+  // Write the header uncompressed. The frame count is updated on closing.
+  std::ostringstream header;
+  streamutil::initialiseStream(header, &server_info);
+  const std::string header_bytes = header.str();
+  _writer.write(header_bytes.data(), header_bytes.size());
+  _header_written = true;
+}
+
+
+void StreamFilter::dispatch(size_t max_pending)
+{
+  if (!_batch.empty())
+  {
+    _pending.emplace_back(std::async(std::launch::async, &StreamFilter::encode, std::move(_batch),
+                                     !_opt.no_collate, _opt.compression_level));
+    _batch = {};
+    _batch.reserve(kBatchSize + std::numeric_limits<uint16_t>::max());
+  }
+
+  while (_pending.size() > max_pending)
+  {
+    const auto bytes = _pending.front().get();
+    _pending.pop_front();
+    _writer.write(bytes.data(), bytes.size());
+  }
+}
+
+
+std::vector<uint8_t> StreamFilter::encode(const std::vector<uint8_t> &batch, bool collate,
+                                          unsigned compression_level)
+{
+  if (!collate)
+  {
+    return batch;
+  }
+
+  std::vector<uint8_t> output;
+  output.reserve(batch.size());
+  CollatedPacket collation(compression_level > 0);
+  collation.setCompressionLevel(static_cast<CompressionLevel>(
+    std::min(compression_level, static_cast<unsigned>(CompressionLevel::VeryHigh))));
+
+  const auto flush = [&collation, &output]() {
+    if (collation.collatedBytes() && collation.finalise())
+    {
+      unsigned byte_count = 0;
+      const uint8_t *bytes = collation.buffer(byte_count);
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      output.insert(output.end(), bytes, bytes + byte_count);
+    }
+    collation.reset();
+  };
+
+  size_t offset = 0;
+  while (offset < batch.size())
+  {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const PacketReader packet(reinterpret_cast<const PacketHeader *>(&batch[offset]));
+    const uint32_t byte_count = packet.packetSize();
+    const uint8_t *bytes = &batch[offset];
+    offset += byte_count;
+
+    if (collation.add(bytes, byte_count) < 0)
+    {
+      // Full. Flush and try again.
+      flush();
+      if (collation.add(bytes, byte_count) < 0)
+      {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        output.insert(output.end(), bytes, bytes + byte_count);
+      }
+    }
+
+    if (packet.routingId() == MtControl && packet.messageId() == CIdFrame)
+    {
+      flush();
+    }
+  }
+  flush();
+
+  return output;
+}
+}  // namespace
+}  // namespace tes
+
+
+int main(int argc, char *argv[])
+{
+  tes::Options opt = {};
+
+  switch (tes::parseArgs(argc, argv, opt))
+  {
+  case tes::ParseResult::Ok:
+    break;
+  case tes::ParseResult::Help:
+    return 0;
+  case tes::ParseResult::ParseError:
+    [[fallthrough]];
+  case tes::ParseResult::ValidationError:
+    [[fallthrough]];
+  default:
+    return 1;
+  }
+
+  tes::StreamFilter filter(opt);
+  return filter.run() ? 0 : 1;
+}
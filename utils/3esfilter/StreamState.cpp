@@ -0,0 +1,215 @@
+#include "StreamState.h"
+
+#include <3escore/MeshMessages.h>
+#include <3escore/Messages.h>
+#include <3escore/PacketReader.h>
+
+#include <algorithm>
+
+namespace tes
+{
+void StreamState::add(const PacketReader &packet)
+{
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto *bytes = reinterpret_cast<const uint8_t *>(&packet.packet());
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  Packet data(bytes, bytes + packet.packetSize());
+  // Use a new reader so we can read the payload without modifying the caller's reader.
+  PacketReader reader(&packet.packet());
+  const uint16_t routing_id = reader.routingId();
+  const uint16_t message_id = reader.messageId();
+
+  if (routing_id >= ShapeHandlersIDStart)
+  {
+    // All object messages lead with the object ID.
+    uint32_t id = 0;
+    if (reader.readElement(id) != sizeof(id) || id == 0)
+    {
+      // Transient or invalid.
+      return;
+    }
+
+    const uint64_t key = objectKey(routing_id, id);
+    switch (message_id)
+    {
+    case OIdCreate: {
+      auto &entry = _objects[key];
+      entry = {};
+      entry.sequence = _next_sequence++;
+      entry.packets.emplace_back(std::move(data));
+      break;
+    }
+    case OIdUpdate: {
+      const auto search = _objects.find(key);
+      uint16_t flags = 0;
+      if (search == _objects.end() || reader.readElement(flags) != sizeof(flags))
+      {
+        break;
+      }
+
+      auto &updates = search->second.updates;
+      if (!(flags & UFUpdateMode))
+      {
+        // Full update. Supersedes all previous updates.
+        updates.clear();
+      }
+      else
+      {
+        const uint16_t update_flags = flags & (UFUpdateMode | UFPosRotScaleColour);
+        updates.erase(std::remove_if(updates.begin(), updates.end(),
+                                     [update_flags](const auto &update) {
+                                       return update.first == update_flags;
+                                     }),
+                      updates.end());
+      }
+      updates.emplace_back(flags & (UFUpdateMode | UFPosRotScaleColour), std::move(data));
+      break;
+    }
+    case OIdDestroy:
+      _objects.erase(key);
+      break;
+    case OIdData: {
+      const auto search = _objects.find(key);
+      if (search != _objects.end())
+      {
+        search->second.packets.emplace_back(std::move(data));
+      }
+      break;
+    }
+    default:
+      break;
+    }
+    return;
+  }
+
+  switch (routing_id)
+  {
+  case MtControl:
+    if (message_id == CIdCoordinateFrame)
+    {
+      _coordinate_frame = std::move(data);
+    }
+    else if (message_id == CIdReset)
+    {
+      clear();
+    }
+    break;
+  case MtCategory:
+    if (message_id == CMIdName)
+    {
+      uint16_t category_id = 0;
+      if (reader.readElement(category_id) == sizeof(category_id))
+      {
+        _categories[category_id] = std::move(data);
+      }
+    }
+    break;
+  case MtCamera: {
+    uint8_t camera_id = 0;
+    if (reader.readElement(camera_id) == sizeof(camera_id))
+    {
+      _cameras[camera_id] = std::move(data);
+    }
+    break;
+  }
+  case MtMesh: {
+    // Mesh messages lead with the mesh ID.
+    uint32_t mesh_id = 0;
+    if (reader.readElement(mesh_id) != sizeof(mesh_id))
+    {
+      break;
+    }
+
+    const uint64_t key = objectKey(routing_id, mesh_id);
+    if (message_id == MmtCreate)
+    {
+      auto &entry = _resources[key];
+      entry = {};
+      entry.sequence = _next_sequence++;
+      entry.packets.emplace_back(std::move(data));
+    }
+    else if (message_id == MmtDestroy)
+    {
+      _resources.erase(key);
+    }
+    else
+    {
+      const auto search = _resources.find(key);
+      if (search == _resources.end())
+      {
+        break;
+      }
+
+      auto &packets = search->second.packets;
+      if (message_id == MmtRedefine)
+      {
+        // Keep only the original create message ahead of the new definition.
+        packets.resize(1);
+      }
+      packets.emplace_back(std::move(data));
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+
+void StreamState::write(const Emit &emit) const
+{
+  if (!_coordinate_frame.empty())
+  {
+    emit(_coordinate_frame.data(), static_cast<uint32_t>(_coordinate_frame.size()));
+  }
+
+  for (const auto &[category_id, packet] : _categories)
+  {
+    emit(packet.data(), static_cast<uint32_t>(packet.size()));
+  }
+
+  for (const auto &[camera_id, packet] : _cameras)
+  {
+    emit(packet.data(), static_cast<uint32_t>(packet.size()));
+  }
+
+  writeEntries(_resources, emit);
+  writeEntries(_objects, emit);
+}
+
+
+void StreamState::clear()
+{
+  _categories.clear();
+  _cameras.clear();
+  _coordinate_frame.clear();
+  _resources.clear();
+  _objects.clear();
+}
+
+
+void StreamState::writeEntries(const std::unordered_map<uint64_t, Entry> &entries,
+                               const Emit &emit)
+{
+  std::vector<const Entry *> ordered;
+  ordered.reserve(entries.size());
+  for (const auto &[key, entry] : entries)
+  {
+    ordered.emplace_back(&entry);
+  }
+  std::sort(ordered.begin(), ordered.end(),
+            [](const Entry *a, const Entry *b) { return a->sequence < b->sequence; });
+
+  for (const auto *entry : ordered)
+  {
+    for (const auto &packet : entry->packets)
+    {
+      emit(packet.data(), static_cast<uint32_t>(packet.size()));
+    }
+    for (const auto &[flags, packet] : entry->updates)
+    {
+      emit(packet.data(), static_cast<uint32_t>(packet.size()));
+    }
+  }
+}
+}  // namespace tes
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tes
+{
+class PacketReader;
+
+/// Tracks the packets required to reproduce the state of a 3es stream at a frame boundary.
+///
+/// This supports starting a trimmed stream part way through a recording. The state is tracked at
+/// the packet level, so it supports any shape which follows the object message conventions without
+/// decoding the shape:
+/// - The latest category definition for each category.
+/// - The latest camera for each camera ID and the latest coordinate frame.
+/// - All packets for each live mesh resource since it was created or redefined.
+/// - The create and data packets for each live, persistent object plus its most recent updates.
+///
+/// Object updates are reduced to the last full update, plus the last partial update for each
+/// combination of @c UpdateFlag values after that. Replaying these in order yields the latest value
+/// of each attribute. Transient objects are not part of the state as they only last one frame.
+class StreamState
+{
+public:
+  /// Function used to emit snapshot packets.
+  using Emit = std::function<void(const uint8_t *data, uint32_t byte_count)>;
+
+  /// Update the state with @p packet . Packets must be added in stream order.
+  /// @param packet The packet to add. Must not be a collated packet.
+  void add(const PacketReader &packet);
+
+  /// Emit the packets required to reproduce the current state. Categories and cameras are written
+  /// first, then resources, then objects in creation order.
+  /// @param emit Function called for each packet.
+  void write(const Emit &emit) const;
+
+  /// Clear the state, as for a @c CIdReset control message.
+  void clear();
+
+private:
+  using Packet = std::vector<uint8_t>;
+
+  /// Packets for a live mesh resource or persistent object.
+  struct Entry
+  {
+    /// Order in which the entry was created.
+    uint64_t sequence = 0;
+    /// Creation and data packets.
+    std::vector<Packet> packets;
+    /// Object updates and the update flags of each.
+    std::vector<std::pair<uint16_t, Packet>> updates;
+  };
+
+  static void writeEntries(const std::unordered_map<uint64_t, Entry> &entries, const Emit &emit);
+
+  std::map<uint16_t, Packet> _categories;
+  std::map<uint8_t, Packet> _cameras;
+  Packet _coordinate_frame;
+  /// Mesh resources keyed by routing and resource ID.
+  std::unordered_map<uint64_t, Entry> _resources;
+  /// Persistent objects keyed by routing and object ID.
+  std::unordered_map<uint64_t, Entry> _objects;
+  uint64_t _next_sequence = 0;
+};
+}  // namespace tes
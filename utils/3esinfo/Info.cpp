@@ -1,3 +1,5 @@
+#include "InfoStats.h"
+
 #include <3escore/ByteValue.h>
 #include <3escore/CollatedPacketDecoder.h>
 #include <3escore/Endian.h>
@@ -10,62 +12,42 @@
 #include <3escore/TcpSocket.h>
 #include <3escore/PacketStreamReader.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <csignal>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <optional>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <type_traits>
+#include <vector>
 
 #include <cxxopts.hpp>
 
-struct PacketKey
-{
-  uint16_t routing_id = 0;
-  uint16_t message_id = 0;
-
-  uint32_t key() const noexcept
-  {
-    return static_cast<uint32_t>(routing_id) | static_cast<uint32_t>(message_id) << 16u;
-  }
-};
-
-inline bool operator==(const PacketKey &a, const PacketKey &b)
-{
-  const uint32_t key_a = a.key();
-  const uint32_t key_b = b.key();
-  return key_a == key_b;
-}
-
-inline bool operator<(const PacketKey &a, const PacketKey &b)
-{
-  const uint32_t key_a = a.key();
-  const uint32_t key_b = b.key();
-  return key_a < key_b;
-}
-
-namespace std
-{
-template <>
-struct hash<PacketKey>
-{
-  size_t operator()(const PacketKey &key) const noexcept { return key.key(); }
-};
-}  // namespace std
-
 namespace
 {
+using tes::ByteStats;
+using tes::ChunkStats;
+using tes::PacketKey;
+
 enum class InfoMode
 {
   Message,
-  Packet
+  Packet,
+  Stats
 };
 
 const std::array kInfoModeStrings = {
   std::string_view{ "message" },
   std::string_view{ "packet" },
+  std::string_view{ "stats" },
 };
 
 std::string_view toString(const InfoMode mode)
@@ -161,6 +143,11 @@ struct Options
   std::optional<tes::ByteUnit> display_unit{};
   InfoMode mode = InfoMode::Message;
   size_t offset = 0;
+  /// Number of threads used to scan the file in @c InfoMode::Stats . Zero to use the hardware
+  /// concurrency.
+  unsigned threads = 0;
+  /// Number of largest frames and resources to list in @c InfoMode::Stats .
+  unsigned top = 10;
 };
 
 bool validate(Options &opt)
@@ -185,8 +172,10 @@ ParseResult parseArgs(int argc, char *argv[], Options &opt)
     ("help", "Show command line help.")
     ("file", "Data file to open (.3es)", cxxopts::value(opt.filename))
     ("du", "Size display unit: B, KiB, MiB, ...", cxxopts::value(display_unit))
-    ("m,mode", "Information display mode. message for message information, packet for packet information.", cxxopts::value(opt.mode)->default_value(std::string{toString(opt.mode)}))
+    ("m,mode", "Information display mode. message for message information, packet for packet information, stats for JSON bandwidth statistics.", cxxopts::value(opt.mode)->default_value(std::string{toString(opt.mode)}))
     ("offset", "Offset starting position.", cxxopts::value(opt.offset)->default_value(std::to_string(opt.offset)))
+    ("threads", "Number of threads used to scan the file in stats mode. Zero for the hardware concurrency.", cxxopts::value(opt.threads)->default_value(std::to_string(opt.threads)))
+    ("top", "Number of largest frames and resources listed in stats mode.", cxxopts::value(opt.top)->default_value(std::to_string(opt.top)))
   ;
   // clang-format on
 
@@ -356,41 +345,6 @@ MessageMap buildMessageNames()
 }
 
 
-bool checkCompatibility(const tes::PacketReader &reader)
-{
-  const auto version_major = reader.versionMajor();
-  const auto version_minor = reader.versionMinor();
-
-  // Exact version match.
-  if (version_major == tes::kPacketVersionMajor &&
-      version_minor == tes::kPacketCompatibilityVersionMinor)
-  {
-    return true;
-  }
-  // Check major version is in the allowed range (open interval).
-  if (tes::kPacketCompatibilityVersionMajor < version_major &&
-      version_major < tes::kPacketVersionMajor)
-  {
-    // Major version is between the allowed range.
-    return true;
-  }
-
-  // Major version match, ensure minor version is in range.
-  if (version_major == tes::kPacketVersionMajor && version_minor <= tes::kPacketVersionMinor)
-  {
-    return true;
-  }
-
-  // Major version compatibility match, ensure minor version is in range.
-  if (version_major == tes::kPacketCompatibilityVersionMajor &&
-      version_minor >= tes::kPacketCompatibilityVersionMinor)
-  {
-    return true;
-  }
-
-  return false;
-}
-
 void processPacket(tes::PacketReader &reader, InfoMap &info_map)
 {
   const PacketKey key = { reader.routingId(), reader.messageId() };
@@ -480,11 +434,264 @@ void displayInfo(const InfoMap &info, const Options &opt)
     break;
   case InfoMode::Packet:
     break;
+  case InfoMode::Stats:
+    break;
   default:
     std::cerr << "Unhandled info mode " << opt.mode << std::flush;
     break;
   }
 }
+
+
+// --- Stats mode ---
+// See InfoStats.h for details of how the file is scanned.
+
+/// A frame listed in the stats output.
+struct FrameInfo
+{
+  uint64_t number = 0;
+  ByteStats stats;
+};
+
+
+std::string jsonString(const std::string &str)
+{
+  std::ostringstream out;
+  out << '"';
+  for (const char ch : str)
+  {
+    switch (ch)
+    {
+    case '"':
+      out << "\\\"";
+      break;
+    case '\\':
+      out << "\\\\";
+      break;
+    default:
+      if (static_cast<unsigned char>(ch) < 0x20u)
+      {
+        out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+            << static_cast<unsigned>(ch) << std::dec << std::setfill(' ');
+      }
+      else
+      {
+        out << ch;
+      }
+      break;
+    }
+  }
+  out << '"';
+  return out.str();
+}
+
+
+/// Format the members of @p stats as JSON members, without braces.
+std::string jsonMembers(const ByteStats &stats)
+{
+  std::ostringstream out;
+  const auto stored_bytes = static_cast<uint64_t>(std::llround(stats.stored_bytes));
+  const double ratio = (stats.bytes) ? stats.stored_bytes / static_cast<double>(stats.bytes) : 1.0;
+  out << "\"count\": " << stats.count << ", \"bytes\": " << stats.bytes
+      << ", \"stored_bytes\": " << stored_bytes << ", \"stored_ratio\": " << std::fixed
+      << std::setprecision(4) << ratio;
+  return out.str();
+}
+
+
+void displayStats(const ChunkStats &stats, const Options &opt)
+{
+  const Working working = { buildRoutingNames(), buildMessageNames() };
+  std::ostream &out = std::cout;
+
+  ByteStats frame_total;
+  for (const auto &frame : stats.frames)
+  {
+    frame_total += frame;
+  }
+
+  out << "{\n";
+  out << "  \"file\": " << jsonString(opt.filename) << ",\n";
+  out << "  \"totals\": {\n";
+  out << "    \"stream_bytes\": " << stats.stream_bytes << ",\n";
+  out << "    \"packets\": " << stats.packet_count << ",\n";
+  out << "    \"collated_packets\": " << stats.collated_count << ",\n";
+  out << "    \"compressed_bytes\": " << stats.compressed_bytes << ",\n";
+  out << "    \"compressed_content_bytes\": " << stats.compressed_content_bytes << ",\n";
+  out << "    \"unsupported_packets\": " << stats.unsupported_count << ",\n";
+  out << "    \"dropped_sections\": " << stats.dropped_count << "\n";
+  out << "  },\n";
+
+  // Messages, largest first.
+  std::vector<std::pair<PacketKey, ByteStats>> messages(stats.messages.begin(),
+                                                        stats.messages.end());
+  std::sort(messages.begin(), messages.end(), [](const auto &a, const auto &b) {
+    return a.second.stored_bytes > b.second.stored_bytes ||
+           a.second.stored_bytes == b.second.stored_bytes && a.first < b.first;
+  });
+  out << "  \"messages\": [";
+  const char *separator = "\n";
+  for (const auto &[key, message] : messages)
+  {
+    out << separator << "    { \"routing_id\": " << key.routing_id
+        << ", \"message_id\": " << key.message_id
+        << ", \"routing_name\": " << jsonString(routingName(working.routing_names, key))
+        << ", \"message_name\": " << jsonString(messageName(working.message_names, key)) << ", "
+        << jsonMembers(message) << " }";
+    separator = ",\n";
+  }
+  out << "\n  ],\n";
+
+  // Categories, largest first.
+  std::vector<std::pair<uint16_t, ByteStats>> categories(stats.categories.begin(),
+                                                         stats.categories.end());
+  std::sort(categories.begin(), categories.end(), [](const auto &a, const auto &b) {
+    return a.second.stored_bytes > b.second.stored_bytes ||
+           a.second.stored_bytes == b.second.stored_bytes && a.first < b.first;
+  });
+  ByteStats uncategorised;
+  for (const auto &[key, object] : stats.unresolved)
+  {
+    uncategorised += object;
+  }
+  out << "  \"categories\": {\n";
+  out << "    \"uncategorised\": { " << jsonMembers(uncategorised) << " },\n";
+  out << "    \"items\": [";
+  separator = "\n";
+  for (const auto &[category, category_stats] : categories)
+  {
+    const auto name = stats.category_names.find(category);
+    out << separator << "      { \"category\": " << category << ", \"name\": "
+        << jsonString((name != stats.category_names.end()) ? name->second : std::string{})
+        << ", " << jsonMembers(category_stats) << " }";
+    separator = ",\n";
+  }
+  out << "\n    ]\n";
+  out << "  },\n";
+
+  // Frames: summary, histogram over power of two stored byte buckets and the largest frames.
+  std::vector<FrameInfo> frames(stats.frames.size());
+  std::vector<uint64_t> histogram;
+  uint64_t min_frame = (!stats.frames.empty()) ? std::numeric_limits<uint64_t>::max() : 0;
+  uint64_t max_frame = 0;
+  for (size_t i = 0; i < stats.frames.size(); ++i)
+  {
+    frames[i] = { i, stats.frames[i] };
+    const auto frame_bytes = static_cast<uint64_t>(std::llround(stats.frames[i].stored_bytes));
+    min_frame = std::min(min_frame, frame_bytes);
+    max_frame = std::max(max_frame, frame_bytes);
+    size_t bucket = 0;
+    while ((frame_bytes >> bucket) > 1u)
+    {
+      ++bucket;
+    }
+    if (histogram.size() <= bucket)
+    {
+      histogram.resize(bucket + 1);
+    }
+    ++histogram[bucket];
+  }
+  const size_t top_frames = std::min<size_t>(opt.top, frames.size());
+  std::partial_sort(frames.begin(), frames.begin() + top_frames, frames.end(),
+                    [](const FrameInfo &a, const FrameInfo &b) {
+                      return a.stats.stored_bytes > b.stats.stored_bytes ||
+                             a.stats.stored_bytes == b.stats.stored_bytes && a.number < b.number;
+                    });
+
+  out << "  \"frames\": {\n";
+  out << "    \"count\": " << stats.frames.size() << ",\n";
+  out << "    \"total\": { " << jsonMembers(frame_total) << " },\n";
+  out << "    \"trailing\": { " << jsonMembers(stats.open_frame) << " },\n";
+  out << "    \"min_stored_bytes\": " << min_frame << ",\n";
+  out << "    \"mean_stored_bytes\": "
+      << ((!stats.frames.empty()) ?
+            static_cast<uint64_t>(
+              std::llround(frame_total.stored_bytes / static_cast<double>(stats.frames.size()))) :
+            0u)
+      << ",\n";
+  out << "    \"max_stored_bytes\": " << max_frame << ",\n";
+  out << "    \"histogram\": [";
+  separator = "\n";
+  for (size_t bucket = 0; bucket < histogram.size(); ++bucket)
+  {
+    if (histogram[bucket])
+    {
+      const uint64_t bucket_min = (bucket) ? (uint64_t(1) << bucket) : 0u;
+      const uint64_t bucket_max = (uint64_t(1) << (bucket + 1)) - 1u;
+      out << separator << "      { \"min_stored_bytes\": " << bucket_min
+          << ", \"max_stored_bytes\": " << bucket_max << ", \"count\": " << histogram[bucket]
+          << " }";
+      separator = ",\n";
+    }
+  }
+  out << "\n    ],\n";
+  out << "    \"largest\": [";
+  separator = "\n";
+  for (size_t i = 0; i < top_frames; ++i)
+  {
+    out << separator << "      { \"frame\": " << frames[i].number << ", "
+        << jsonMembers(frames[i].stats) << " }";
+    separator = ",\n";
+  }
+  out << "\n    ]\n";
+  out << "  },\n";
+
+  // Resources.
+  ByteStats resource_total;
+  std::vector<std::pair<uint64_t, ByteStats>> resources(stats.resources.begin(),
+                                                        stats.resources.end());
+  for (const auto &[key, resource] : resources)
+  {
+    resource_total += resource;
+  }
+  const size_t top_resources = std::min<size_t>(opt.top, resources.size());
+  std::partial_sort(resources.begin(), resources.begin() + top_resources, resources.end(),
+                    [](const auto &a, const auto &b) {
+                      return a.second.stored_bytes > b.second.stored_bytes ||
+                             a.second.stored_bytes == b.second.stored_bytes && a.first < b.first;
+                    });
+  out << "  \"resources\": {\n";
+  out << "    \"count\": " << resources.size() << ",\n";
+  out << "    \"total\": { " << jsonMembers(resource_total) << " },\n";
+  out << "    \"largest\": [";
+  separator = "\n";
+  for (size_t i = 0; i < top_resources; ++i)
+  {
+    const auto routing_id = static_cast<uint16_t>(resources[i].first >> 32u);
+    const auto id = static_cast<uint32_t>(resources[i].first & 0xffffffffu);
+    out << separator << "      { \"routing_name\": "
+        << jsonString(routingName(working.routing_names, routing_id)) << ", \"id\": " << id
+        << ", " << jsonMembers(resources[i].second) << " }";
+    separator = ",\n";
+  }
+  out << "\n    ]\n";
+  out << "  }\n";
+  out << "}" << std::endl;
+}
+
+
+int runStats(const Options &opt)
+{
+  std::ifstream in_stream(opt.filename, std::ios::binary | std::ios::ate);
+  if (!in_stream.is_open())
+  {
+    tes::log::error("Unable to open file ", opt.filename);
+    return 1;
+  }
+  const std::streamoff file_size = in_stream.tellg();
+  in_stream.close();
+
+  const auto start = std::min(static_cast<std::streamoff>(opt.offset), file_size);
+  unsigned thread_count = (opt.threads) ? opt.threads : std::thread::hardware_concurrency();
+  const auto max_threads = static_cast<unsigned>(
+    std::max<std::streamoff>(1, (file_size - start) / tes::kMinStatsChunkSize));
+  thread_count = std::max(1u, std::min(thread_count, max_threads));
+
+  ChunkStats total;
+  tes::collectStats(opt.filename, start, file_size, thread_count, total);
+  displayStats(total, opt);
+  return 0;
+}
 }  // namespace
 
 int main(int argc, char *argv[])
@@ -505,6 +712,11 @@ int main(int argc, char *argv[])
     return 1;
   }
 
+  if (opt.mode == InfoMode::Stats)
+  {
+    return runStats(opt);
+  }
+
   std::ifstream in_stream(opt.filename, std::ios::binary);
   if (!in_stream.is_open())
   {
@@ -550,7 +762,7 @@ int main(int argc, char *argv[])
       tes::PacketReader packet(packet_header);
 
       // Check the initial packet compatibility.
-      if (!checkCompatibility(packet))
+      if (!tes::packetVersionCompatible(packet.versionMajor(), packet.versionMinor()))
       {
         ok = false;
         tes::log::warn("Unsupported packet version: ", packet.versionMajor(), ".",
@@ -0,0 +1,305 @@
+#include "InfoStats.h"
+
+#include <3escore/CollatedPacketDecoder.h>
+#include <3escore/Log.h>
+#include <3escore/Messages.h>
+#include <3escore/PacketReader.h>
+#include <3escore/PacketStreamReader.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <thread>
+
+namespace tes
+{
+namespace
+{
+bool validPacket(const PacketHeader *header)
+{
+  PacketReader reader(header);
+  return packetVersionCompatible(reader.versionMajor(), reader.versionMinor()) &&
+         ((reader.flags() & PFNoCrc) || reader.checkCrc());
+}
+
+
+void processStatsPacket(const PacketHeader *header, CollatedPacketDecoder &decoder,
+                        ChunkStats &stats)
+{
+  PacketReader outer(header);
+  const uint64_t stream_bytes = outer.packetSize();
+  stats.stream_bytes += stream_bytes;
+  ++stats.packet_count;
+
+  // Scale from contained bytes to stored bytes.
+  double stored_scale = 1.0;
+  if (outer.routingId() == MtCollatedPacket)
+  {
+    CollatedPacketMessage msg = {};
+    if (msg.read(outer) && msg.uncompressed_bytes)
+    {
+      ++stats.collated_count;
+      if (msg.flags & CPFCompress)
+      {
+        stats.compressed_bytes += stream_bytes;
+        stats.compressed_content_bytes += msg.uncompressed_bytes;
+      }
+      stored_scale = static_cast<double>(stream_bytes) / msg.uncompressed_bytes;
+    }
+  }
+
+  std::array<char, 1024> name_buffer = {};
+  decoder.setPacket(header);
+  while (const auto *packet_header = decoder.next())
+  {
+    PacketReader packet(packet_header);
+    if (!packetVersionCompatible(packet.versionMajor(), packet.versionMinor()))
+    {
+      ++stats.unsupported_count;
+      continue;
+    }
+
+    const uint16_t routing_id = packet.routingId();
+    const uint16_t message_id = packet.messageId();
+    const uint64_t bytes = packet.packetSize();
+    const double stored_bytes = stored_scale * static_cast<double>(bytes);
+
+    stats.messages[{ routing_id, message_id }].add(bytes, stored_bytes);
+    stats.open_frame.add(bytes, stored_bytes);
+
+    if (routing_id >= ShapeHandlersIDStart)
+    {
+      // All object messages lead with the object ID. Create messages follow with the category.
+      uint32_t id = 0;
+      packet.readElement(id);
+      if (message_id == OIdCreate)
+      {
+        uint16_t category = 0;
+        packet.readElement(category);
+        if (id)
+        {
+          stats.object_categories[objectKey(routing_id, id)] = category;
+        }
+        stats.categories[category].add(bytes, stored_bytes);
+      }
+      else
+      {
+        const auto search = stats.object_categories.find(objectKey(routing_id, id));
+        if (search != stats.object_categories.end())
+        {
+          stats.categories[search->second].add(bytes, stored_bytes);
+        }
+        else
+        {
+          stats.unresolved[objectKey(routing_id, id)].add(bytes, stored_bytes);
+        }
+      }
+    }
+    else if (routing_id == MtMesh || routing_id == MtMaterial)
+    {
+      // Mesh messages lead with the mesh ID.
+      uint32_t id = 0;
+      packet.readElement(id);
+      stats.resources[objectKey(routing_id, id)].add(bytes, stored_bytes);
+    }
+    else if (routing_id == MtCategory && message_id == CMIdName)
+    {
+      CategoryNameMessage msg = {};
+      if (msg.read(packet, name_buffer.data(), name_buffer.size()))
+      {
+        stats.category_names[msg.category_id] = msg.name;
+      }
+    }
+    else if (routing_id == MtControl && message_id == CIdFrame)
+    {
+      stats.frames.emplace_back(stats.open_frame);
+      stats.open_frame = {};
+    }
+  }
+}
+}  // namespace
+
+std::streamoff findPacketBoundary(std::istream &in, std::streamoff start, std::streamoff end)
+{
+  PacketStreamReader reader(in);
+  std::streamoff candidate = start;
+  while (candidate < end)
+  {
+    reader.seek(candidate);
+    const auto first = reader.extractPacket();
+    const auto first_pos = static_cast<std::streamoff>(first.pos);
+    if (!first.header || first_pos >= end)
+    {
+      return end;
+    }
+
+    bool valid = validPacket(first.header);
+    std::streamoff next_pos = first_pos + PacketReader(first.header).packetSize();
+    for (unsigned i = 1; valid && i < kSyncPacketCount; ++i)
+    {
+      const auto next = reader.extractPacket();
+      if (!next.header)
+      {
+        // End of the stream.
+        break;
+      }
+      valid = static_cast<std::streamoff>(next.pos) == next_pos && validPacket(next.header);
+      next_pos += PacketReader(next.header).packetSize();
+    }
+
+    if (valid)
+    {
+      return first_pos;
+    }
+    candidate = first_pos + 1;
+  }
+  return end;
+}
+
+
+void scanChunk(const std::string &filename, std::streamoff start, std::streamoff end, bool sync,
+               ChunkStats &stats)
+{
+  stats.scan_start = stats.scan_end = start;
+  stats.range_end = end;
+  std::ifstream in(filename, std::ios::binary);
+  if (!in.is_open())
+  {
+    log::error("Unable to open file ", filename);
+    return;
+  }
+
+  if (sync)
+  {
+    start = findPacketBoundary(in, start, end);
+    stats.scan_start = stats.scan_end = start;
+    in.clear();
+  }
+
+  PacketStreamReader reader(in);
+  CollatedPacketDecoder decoder;
+  reader.seek(start);
+  while (reader.isOk() && !reader.isEof())
+  {
+    const auto [header, status, pos] = reader.extractPacket();
+    if (!header)
+    {
+      if (status != PacketStreamReader::Status::End)
+      {
+        log::warn("Failed to load packet.");
+      }
+      break;
+    }
+
+    if (static_cast<std::streamoff>(pos) >= end)
+    {
+      break;
+    }
+
+    stats.dropped_count += status == PacketStreamReader::Status::Dropped;
+    processStatsPacket(header, decoder, stats);
+    stats.scan_end = static_cast<std::streamoff>(pos) + PacketReader(header).packetSize();
+  }
+}
+
+
+void mergeStats(const std::string &filename, std::vector<ChunkStats> &chunks, ChunkStats &total)
+{
+  for (size_t i = 0; i < chunks.size(); ++i)
+  {
+    auto &chunk = chunks[i];
+    // A chunk which synchronised onto packets nested in the last packet of the previous chunk, or
+    // which skipped bytes the previous chunk would have read, is rescanned from where the previous
+    // chunk stopped.
+    if (i > 0 && chunk.scan_start != chunks[i - 1].scan_end)
+    {
+      const std::streamoff start = chunks[i - 1].scan_end;
+      const std::streamoff end = chunk.range_end;
+      chunk = {};
+      scanChunk(filename, start, end, false, chunk);
+    }
+
+    total.stream_bytes += chunk.stream_bytes;
+    total.packet_count += chunk.packet_count;
+    total.collated_count += chunk.collated_count;
+    total.compressed_bytes += chunk.compressed_bytes;
+    total.compressed_content_bytes += chunk.compressed_content_bytes;
+    total.unsupported_count += chunk.unsupported_count;
+    total.dropped_count += chunk.dropped_count;
+
+    for (const auto &[key, stats] : chunk.messages)
+    {
+      total.messages[key] += stats;
+    }
+    for (const auto &[category, stats] : chunk.categories)
+    {
+      total.categories[category] += stats;
+    }
+    for (const auto &[key, stats] : chunk.unresolved)
+    {
+      // Resolve using shapes created in previous chunks.
+      const auto search = total.object_categories.find(key);
+      if (search != total.object_categories.end())
+      {
+        total.categories[search->second] += stats;
+      }
+      else
+      {
+        total.unresolved[key] += stats;
+      }
+    }
+    for (const auto &[key, category] : chunk.object_categories)
+    {
+      total.object_categories[key] = category;
+    }
+    for (const auto &[category, name] : chunk.category_names)
+    {
+      total.category_names[category] = name;
+    }
+    for (const auto &[key, stats] : chunk.resources)
+    {
+      total.resources[key] += stats;
+    }
+
+    if (chunk.frames.empty())
+    {
+      total.open_frame += chunk.open_frame;
+    }
+    else
+    {
+      chunk.frames.front() += total.open_frame;
+      total.frames.insert(total.frames.end(), chunk.frames.begin(), chunk.frames.end());
+      total.open_frame = chunk.open_frame;
+    }
+
+    // Release memory as we go, keeping the scan range for the next chunk.
+    const std::streamoff scan_end = chunk.scan_end;
+    chunk = {};
+    chunk.scan_end = scan_end;
+  }
+}
+
+
+void collectStats(const std::string &filename, std::streamoff start, std::streamoff end,
+                  unsigned thread_count, ChunkStats &total)
+{
+  thread_count = std::max(1u, thread_count);
+  const std::streamoff chunk_size = (end - start + thread_count - 1) / thread_count;
+  std::vector<ChunkStats> chunks(thread_count);
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  for (unsigned i = 0; i < thread_count; ++i)
+  {
+    const std::streamoff chunk_start = std::min(end, start + i * chunk_size);
+    const std::streamoff chunk_end = std::min(end, chunk_start + chunk_size);
+    threads.emplace_back(scanChunk, std::cref(filename), chunk_start, chunk_end, i > 0,
+                         std::ref(chunks[i]));
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  mergeStats(filename, chunks, total);
+}
+}  // namespace tes
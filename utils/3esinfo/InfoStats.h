@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ios>
+#include <istream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tes
+{
+/// Identifies a message type by routing and message ID.
+struct PacketKey
+{
+  uint16_t routing_id = 0;
+  uint16_t message_id = 0;
+
+  [[nodiscard]] uint32_t key() const noexcept
+  {
+    return static_cast<uint32_t>(routing_id) | static_cast<uint32_t>(message_id) << 16u;
+  }
+};
+
+inline bool operator==(const PacketKey &a, const PacketKey &b)
+{
+  const uint32_t key_a = a.key();
+  const uint32_t key_b = b.key();
+  return key_a == key_b;
+}
+
+inline bool operator<(const PacketKey &a, const PacketKey &b)
+{
+  const uint32_t key_a = a.key();
+  const uint32_t key_b = b.key();
+  return key_a < key_b;
+}
+}  // namespace tes
+
+namespace std
+{
+template <>
+struct hash<tes::PacketKey>
+{
+  size_t operator()(const tes::PacketKey &key) const noexcept { return key.key(); }
+};
+}  // namespace std
+
+namespace tes
+{
+// The stats mode of 3esinfo splits the file into byte ranges scanned in parallel. Each range starts
+// at the first packet boundary at or after its nominal start and ends with the packet which spans
+// its nominal end. A range may start inside a packet which holds valid packets, such as an
+// uncompressed collated packet, so merging checks each range starts where the previous range
+// stopped and rescans the range from there if not. Frames, and object categories, which span
+// ranges are joined when merging the range results in order.
+
+/// Minimum number of bytes scanned per thread.
+constexpr std::streamoff kMinStatsChunkSize = 1024 * 1024;
+/// Number of consecutive, valid packets required to accept a packet boundary when starting a scan
+/// part way through a file.
+constexpr unsigned kSyncPacketCount = 4;
+
+/// Byte totals for an item of interest.
+struct ByteStats
+{
+  /// Number of packets.
+  uint64_t count = 0;
+  /// Uncompressed packet bytes.
+  uint64_t bytes = 0;
+  /// Bytes as stored in the stream. Collated packet bytes are apportioned across the packets they
+  /// contain, so this reflects compression and collation overhead.
+  double stored_bytes = 0;
+
+  void add(uint64_t packet_bytes, double packet_stored_bytes)
+  {
+    ++count;
+    bytes += packet_bytes;
+    stored_bytes += packet_stored_bytes;
+  }
+
+  ByteStats &operator+=(const ByteStats &other)
+  {
+    count += other.count;
+    bytes += other.bytes;
+    stored_bytes += other.stored_bytes;
+    return *this;
+  }
+};
+
+/// Statistics collected by scanning a byte range of the file.
+struct ChunkStats
+{
+  /// File position scanning started from, after any search for a packet boundary.
+  std::streamoff scan_start = 0;
+  /// File position of the end of the last top level packet processed, or @c scan_start if none.
+  /// The next chunk should start here.
+  std::streamoff scan_end = 0;
+  /// Nominal end of the byte range scanned. Packets starting before this are processed.
+  std::streamoff range_end = 0;
+  /// Stream bytes consumed by the packets processed.
+  uint64_t stream_bytes = 0;
+  /// Number of top level packets processed.
+  uint64_t packet_count = 0;
+  /// Number of collated packets.
+  uint64_t collated_count = 0;
+  /// Stored bytes of compressed collated packets.
+  uint64_t compressed_bytes = 0;
+  /// Uncompressed bytes contained in compressed collated packets.
+  uint64_t compressed_content_bytes = 0;
+  /// Number of packets skipped due to an unsupported version.
+  uint64_t unsupported_count = 0;
+  /// Number of times bytes were skipped to find a packet marker.
+  uint64_t dropped_count = 0;
+  /// Totals by routing and message ID.
+  std::unordered_map<PacketKey, ByteStats> messages;
+  /// Shape message totals by category.
+  std::unordered_map<uint16_t, ByteStats> categories;
+  /// Shape message totals for shapes not created within this chunk, keyed by @c objectKey() .
+  /// These are resolved to categories on merging.
+  std::unordered_map<uint64_t, ByteStats> unresolved;
+  /// Categories of shapes created in this chunk, keyed by @c objectKey() .
+  std::unordered_map<uint64_t, uint16_t> object_categories;
+  /// Category names defined in this chunk.
+  std::map<uint16_t, std::string> category_names;
+  /// Resource message totals keyed by @c objectKey() using the resource routing ID.
+  std::unordered_map<uint64_t, ByteStats> resources;
+  /// Frames completed in this chunk. The first frame may have started in a previous chunk.
+  std::vector<ByteStats> frames;
+  /// The frame in progress at the end of the chunk.
+  ByteStats open_frame;
+};
+
+/// Find the first packet boundary at or after @p start and before @p end .
+///
+/// A candidate boundary is only accepted when it is followed by a run of contiguous, valid packets
+/// to avoid accepting marker bytes which happen to occur in packet payloads.
+/// @return The boundary position, or @p end if there is none before @p end .
+std::streamoff findPacketBoundary(std::istream &in, std::streamoff start, std::streamoff end);
+
+/// Scan the packets starting in the byte range [@p start, @p end) of @p filename .
+/// @param sync True to search for a valid packet boundary from @p start .
+void scanChunk(const std::string &filename, std::streamoff start, std::streamoff end, bool sync,
+               ChunkStats &stats);
+
+/// Merge the per chunk results, in file order, into @p total , joining frames and resolving object
+/// categories across chunk boundaries.
+///
+/// A chunk which does not start where the previous chunk stopped is rescanned from that position
+/// using @p filename , so no packet is counted twice.
+///
+/// The frames of @p total hold all complete frames, with @c open_frame holding the bytes after the
+/// last frame.
+/// @param filename The file the chunks were scanned from.
+/// @param chunks The chunk results in file order. Released as they are merged.
+/// @param[out] total The merged results.
+void mergeStats(const std::string &filename, std::vector<ChunkStats> &chunks, ChunkStats &total);
+
+/// Collect the stats for the byte range [@p start, @p end) of @p filename , splitting the range
+/// into @p thread_count chunks scanned in parallel. The results do not depend on @p thread_count .
+/// @param filename The file to scan.
+/// @param start The file position to start scanning from. Must be a packet boundary.
+/// @param end The file position to stop at. Packets starting before @p end are included.
+/// @param thread_count The number of threads to scan with.
+/// @param[out] total The collected stats.
+void collectStats(const std::string &filename, std::streamoff start, std::streamoff end,
+                  unsigned thread_count, ChunkStats &total);
+}  // namespace tes
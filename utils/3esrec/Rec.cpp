@@ -1,14 +1,18 @@
 #include "FrameDisplay.h"
 
+#include <3escore/CollatedPacket.h>
 #include <3escore/CollatedPacketDecoder.h>
 #include <3escore/Endian.h>
 #include <3escore/Log.h>
 #include <3escore/Messages.h>
 #include <3escore/PacketBuffer.h>
 #include <3escore/PacketWriter.h>
+#include <3escore/SharedMemoryRing.h>
 #include <3escore/StreamUtil.h>
 #include <3escore/TcpSocket.h>
+#include <3escore/WriteBehindFile.h>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <csignal>
@@ -48,6 +52,42 @@ struct EndPoint
   uint16_t port = 0;
 };
 
+/// The connection data source: either a TCP socket or a same host shared memory ring.
+struct InputStream
+{
+  /// Time to block waiting for shared memory data (milliseconds).
+  static constexpr unsigned kRingWaitMs = 1u;
+
+  std::unique_ptr<TcpSocket> socket;
+  std::unique_ptr<SharedMemoryRing> ring;
+
+  [[nodiscard]] bool isConnected() const
+  {
+    return (socket) ? socket->isConnected() : ring && ring->isConnected();
+  }
+
+  int read(uint8_t *buffer, int buffer_length)
+  {
+    if (socket)
+    {
+      return socket->readAvailable(buffer, buffer_length);
+    }
+    return (ring) ? ring->read(buffer, buffer_length, kRingWaitMs) : -1;
+  }
+
+  void close()
+  {
+    if (socket)
+    {
+      socket->close();
+    }
+    if (ring)
+    {
+      ring->close();
+    }
+  }
+};
+
 class TesRec
 {
 #if PACKET_TIMING
@@ -58,6 +98,12 @@ public:
   {
     EndPoint end_point = { "127.0.0.1", defaultPort() };
     std::string prefix = "tes";
+    std::string mode = "m-";
+    /// Size of each write behind buffer (MiB).
+    unsigned buffer_size_mib = 4;
+    /// Compression level used when re-collating in the @c Mode::CollateAndCompress mode.
+    unsigned compression_level = static_cast<unsigned>(CompressionLevel::Default);
+    bool drop = false;
     bool persist = false;
     bool quiet = false;
     bool overwrite = false;
@@ -93,9 +139,23 @@ public:
   void requestQuit() { _quit = true; }
 
 private:
-  std::unique_ptr<TcpSocket> attemptConnection();
+  std::unique_ptr<InputStream> attemptConnection();
+
+  std::unique_ptr<WriteBehindFile> createOutputWriter();
 
-  std::unique_ptr<std::iostream> createOutputWriter();
+  /// Write @p packet to @p writer according to the @c decodeMode() , re-collating if required.
+  /// @param writer The output writer.
+  /// @param packet The decoded packet to write.
+  /// @param collation The collation buffer for re-collating modes.
+  /// @param flush True to flush the collation buffer after adding @p packet .
+  void writePacket(WriteBehindFile &writer, const PacketReader &packet, CollatedPacket &collation,
+                   bool flush);
+
+  /// Write the contents of @p collation to @p writer and reset it.
+  static void flushCollation(WriteBehindFile &writer, CollatedPacket &collation);
+
+  /// Finalise and close @p writer , reporting the write statistics.
+  void closeOutputWriter(WriteBehindFile &writer);
 
   std::string generateNewOutputFile();
 
@@ -163,6 +223,14 @@ TesRec::TesRec(int argc, const char **args)
   {
     _args_ok = parseArgs(_opt, static_cast<int>(DefaultArgs.size()), DefaultArgs.data());
   }
+  _decode_mode = argToMode(_opt.mode.c_str());
+  if (_decode_mode == Mode::FileCompression)
+  {
+    // Whole file GZip compression cannot be read back by the viewer. Use collated packet
+    // compression instead.
+    log::error("Unsupported recording mode '", _opt.mode, "'. Use 'mc' for compression.");
+    _args_ok = false;
+  }
 }
 
 
@@ -174,10 +242,13 @@ void TesRec::run(FrameDisplay *frame_display)
   const auto sleep_interval = std::chrono::microseconds(500);
   std::vector<uint8_t> socket_buffer(socket_buffer_size);
   std::vector<uint8_t> decode_buffer(decode_buffer_size);
-  std::unique_ptr<TcpSocket> socket = nullptr;
+  std::unique_ptr<InputStream> socket = nullptr;
   std::unique_ptr<PacketBuffer> packet_buffer;
-  std::unique_ptr<std::iostream> io_stream;
+  std::unique_ptr<WriteBehindFile> io_stream;
   CollatedPacketDecoder collated_decoder;
+  CollatedPacket collation(_decode_mode == Mode::CollateAndCompress);
+  collation.setCompressionLevel(static_cast<CompressionLevel>(
+    std::min(_opt.compression_level, static_cast<unsigned>(CompressionLevel::VeryHigh))));
 #if PACKET_TIMING
   using TimingClock = std::chrono::high_resolution_clock;
   auto start_time = TimingClock::now();                   // Set start_time type
@@ -232,7 +303,7 @@ void TesRec::run(FrameDisplay *frame_display)
     {
       // We have a connection. Read messages while we can.
       const int bytes_read =
-        socket->readAvailable(socket_buffer.data(), static_cast<int>(socket_buffer.size()));
+        socket->read(socket_buffer.data(), static_cast<int>(socket_buffer.size()));
       have_data = false;
       if (bytes_read <= 0)
       {
@@ -257,8 +328,7 @@ void TesRec::run(FrameDisplay *frame_display)
 
         if (_decode_mode == Mode::Passthrough)
         {
-          io_stream->write(reinterpret_cast<const char *>(new_packet_header),
-                           completed_packet.packetSize());
+          io_stream->write(new_packet_header, completed_packet.packetSize());
 
           if (completed_packet.routingId() == MtControl)
           {
@@ -284,12 +354,14 @@ void TesRec::run(FrameDisplay *frame_display)
           while (const PacketHeader *decoded_packet_header = collated_decoder.next())
           {
             PacketReader decoded_packet(decoded_packet_header);
+            bool frame_end = false;
 
-            switch (completed_packet.routingId())
+            switch (decoded_packet.routingId())
             {
             case MtControl:
               if (decoded_packet.messageId() == CIdFrame)
               {
+                frame_end = true;
                 ++_total_frames;
                 frame_display->incrementFrame();
 #if PACKET_TIMING
@@ -303,7 +375,7 @@ void TesRec::run(FrameDisplay *frame_display)
               break;
 
             case MtServerInfo:
-              if (_server_info.read(decoded_packet))
+              if (!_server_info.read(decoded_packet))
               {
                 std::cout << "\nFailed to decode ServerInfo message" << std::endl;
                 _quit = true;
@@ -314,9 +386,7 @@ void TesRec::run(FrameDisplay *frame_display)
               break;
             }
 
-            // TODO(KS): use a local collated packet to re-compress data.
-            io_stream->write(reinterpret_cast<const char *>(new_packet_header),
-                             completed_packet.packetSize());
+            writePacket(*io_stream, decoded_packet, collation, frame_end);
           }
         }
       }
@@ -326,8 +396,8 @@ void TesRec::run(FrameDisplay *frame_display)
 
     if (io_stream)
     {
-      streamutil::finaliseStream(*io_stream, _total_frames);
-      io_stream->flush();
+      flushCollation(*io_stream, collation);
+      closeOutputWriter(*io_stream);
       io_stream.reset(nullptr);
     }
 
@@ -353,24 +423,31 @@ void TesRec::run(FrameDisplay *frame_display)
 #endif  // PACKET_TIMING
 }
 
-std::unique_ptr<TcpSocket> TesRec::attemptConnection()
+std::unique_ptr<InputStream> TesRec::attemptConnection()
 {
-  std::unique_ptr<TcpSocket> socket(new TcpSocket);
+  auto stream = std::make_unique<InputStream>();
+
+  if (_opt.end_point.host == SharedMemoryRing::kHostName)
+  {
+    stream->ring = SharedMemoryRing::open(SharedMemoryRing::nameForPort(_opt.end_point.port));
+    return (stream->ring) ? std::move(stream) : nullptr;
+  }
 
-  if (socket->open(_opt.end_point.host.c_str(), _opt.end_point.port))
+  stream->socket = std::make_unique<TcpSocket>();
+  if (stream->socket->open(_opt.end_point.host.c_str(), _opt.end_point.port))
   {
-    socket->setNoDelay(true);
-    socket->setWriteTimeout(0);
-    socket->setReadTimeout(0);
-    socket->setReadBufferSize(1024 * 1024);
-    return socket;
+    stream->socket->setNoDelay(true);
+    stream->socket->setWriteTimeout(0);
+    stream->socket->setReadTimeout(0);
+    stream->socket->setReadBufferSize(1024 * 1024);
+    return stream;
   }
 
   return nullptr;
 }
 
 
-std::unique_ptr<std::iostream> TesRec::createOutputWriter()
+std::unique_ptr<WriteBehindFile> TesRec::createOutputWriter()
 {
   const std::string file_path = generateNewOutputFile();
   if (file_path.empty())
@@ -381,42 +458,74 @@ std::unique_ptr<std::iostream> TesRec::createOutputWriter()
   }
   std::cout << "Recording to: " << file_path << std::endl;
 
-  std::unique_ptr<std::fstream> stream(new std::fstream);
-
-  stream->open(file_path.c_str(),
-               std::ios::binary | std::ios::out | std::ios::in | std::ios::trunc);
-
-  if (!stream->is_open())
+  auto writer = std::make_unique<WriteBehindFile>(
+    static_cast<size_t>(std::max(_opt.buffer_size_mib, 1u)) * 1024u * 1024u, _opt.drop);
+  if (!writer->open(file_path))
   {
     return nullptr;
   }
 
   // Write the recording header uncompressed to the file.
   // We'll rewind here later and update the frame count.
-  // Write to a memory stream to prevent corruption of the file stream when we wrap it
-  // in a GZipStream.
-  streamutil::initialiseStream(*stream, &_server_info);
-
-  return stream;
-
-  // TODO(KS): implement compression modes
-  // switch (DecodeMode)
-  // {
-  //   case Mode.CollateAndCompress:
-  //     stream = new CollationStream(fileStream, true);
-  //     break;
-  //   case Mode.CollateOnly:
-  //     stream = new CollationStream(fileStream, false);
-  //     break;
-  //   case Mode.FileCompression:
-  //     stream = new GZipStream(fileStream, CompressionMode.Compress,
-  //     CompressionLevel.BestCompression); break;
-  //   case Mode.Uncompressed:
-  //     stream = fileStream;
-  //     break;
-  // }
-
-  // return new NetworkWriter(stream);
+  std::ostringstream header;
+  streamutil::initialiseStream(header, &_server_info);
+  const std::string header_bytes = header.str();
+  writer->write(header_bytes.data(), header_bytes.size());
+  return writer;
+}
+
+
+void TesRec::writePacket(WriteBehindFile &writer, const PacketReader &packet,
+                         CollatedPacket &collation, bool flush)
+{
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto *bytes = reinterpret_cast<const uint8_t *>(&packet.packet());
+  if (_decode_mode == Mode::Uncompressed)
+  {
+    writer.write(bytes, packet.packetSize());
+    return;
+  }
+
+  if (collation.add(bytes, packet.packetSize()) < 0)
+  {
+    // Full. Flush and try again.
+    flushCollation(writer, collation);
+    if (collation.add(bytes, packet.packetSize()) < 0)
+    {
+      writer.write(bytes, packet.packetSize());
+    }
+  }
+
+  if (flush)
+  {
+    flushCollation(writer, collation);
+  }
+}
+
+
+void TesRec::flushCollation(WriteBehindFile &writer, CollatedPacket &collation)
+{
+  if (collation.collatedBytes() && collation.finalise())
+  {
+    unsigned byte_count = 0;
+    const uint8_t *bytes = collation.buffer(byte_count);
+    writer.write(bytes, byte_count);
+  }
+  collation.reset();
+}
+
+
+void TesRec::closeOutputWriter(WriteBehindFile &writer)
+{
+  writer.close([this](std::fstream &file) { streamutil::finaliseStream(file, _total_frames); });
+
+  const auto stats = writer.stats();
+  if (!quiet() || stats.bytes_dropped)
+  {
+    std::cout << "\nWrote " << stats.bytes_written << " bytes. Late " << stats.bytes_late
+              << " bytes, stalled " << stats.stall_time << "s, dropped " << stats.bytes_dropped
+              << " bytes" << std::endl;
+  }
 }
 
 
@@ -458,9 +567,13 @@ bool TesRec::parseArgs(Options &opt, int argc, const char *const *argv)
   // clang-format off
   parser.add_options()
     ("h,help", "Show command line help")
-    ("i,ip", "Specifies the server IP address to connect to.", cxxopts::value(opt.end_point.host)->default_value(opt.end_point.host))
+    ("i,ip", "Specifies the server IP address to connect to. Use 'shm' to connect to a server on the same host via shared memory (the server must enable SFSharedMemory).", cxxopts::value(opt.end_point.host)->default_value(opt.end_point.host))
     ("p,port", "Specifies the port to connect on.", cxxopts::value(opt.end_point.port)->default_value(std::to_string(defaultPort())))
     ("persist", "Persist running after the first connection closes, waiting for a new connection. Use Ctrl-C to terminate.", cxxopts::value(opt.persist)->implicit_value("true"))
+    ("b,buffer-size", "Size of each of the two write behind buffers (MiB). Larger buffers absorb longer storage stalls.", cxxopts::value(opt.buffer_size_mib)->default_value(std::to_string(opt.buffer_size_mib)))
+    ("drop", "Drop incoming data rather than stall reading when the file writer falls behind. Dropped bytes are reported on completion.", cxxopts::value(opt.drop)->implicit_value("true"))
+    ("l,level", "Compression level used to re-compress data in 'mc' mode [0, 4]. Zero for no compression.", cxxopts::value(opt.compression_level)->default_value(std::to_string(opt.compression_level)))
+    ("m,mode", "Recording mode: 'mc' decode then collate and compress, 'mC' decode then collate only, 'mu' decode to uncompressed packets, 'm-' record packets as received.", cxxopts::value(opt.mode)->default_value(opt.mode))
     ("q,quiet", "Run in quiet mode (disable non-critical logging).", cxxopts::value(opt.quiet)->implicit_value("true"))
     ("overwrite", "Overwrite existing files using the current prefix. The current session numbering will not overwrite until it loops to 0.", cxxopts::value(opt.overwrite)->implicit_value("true"))
     ("prefix", "Specifies the file prefix used for recording. The recording file is "